@@ -103,19 +103,19 @@ void  crcInit(void);
 
 /*********************************************************************
  *
- * Function:    crcCalc()
+ * Function:    crcUpdate()
  * 
- * Description: Compute the CRC of a given message.
+ * Description: Continue the computation of a CRC with the next bytes
+ *				of a message, starting from INITIAL_REMAINDER.
  *
  * Notes:		crcInit() must be called first.
  *
- * Returns:		The CRC of the message.
+ * Returns:		The updated remainder, to be passed to crcFinal().
  *
  *********************************************************************/
 template <typename CharIterator>
-crc crcCalc(const CharIterator message, unsigned int nBytes)
+crc crcUpdate(crc remainder, const CharIterator message, unsigned int nBytes)
 {
-    crc	           remainder = INITIAL_REMAINDER;
     unsigned char  data;
 	unsigned int   byte;
 
@@ -127,11 +127,41 @@ crc crcCalc(const CharIterator message, unsigned int nBytes)
         data = REFLECT_DATA(message[byte]) ^ (remainder >> (WIDTH - 8));
   		remainder = crcTable[data] ^ (remainder << 8);
     }
+    return remainder;
+}
+
+/*********************************************************************
+ *
+ * Function:    crcFinal()
+ * 
+ * Description: Turn the remainder computed by crcUpdate() into a CRC.
+ *
+ * Returns:		The CRC of the message.
+ *
+ *********************************************************************/
+inline crc crcFinal(const crc remainder)
+{
+    return (REFLECT_REMAINDER(remainder) ^ FINAL_XOR_VALUE);
+}
 
+/*********************************************************************
+ *
+ * Function:    crcCalc()
+ * 
+ * Description: Compute the CRC of a given message.
+ *
+ * Notes:		crcInit() must be called first.
+ *
+ * Returns:		The CRC of the message.
+ *
+ *********************************************************************/
+template <typename CharIterator>
+crc crcCalc(const CharIterator message, unsigned int nBytes)
+{
     /*
      * The final remainder is the CRC.
      */
-    return (REFLECT_REMAINDER(remainder) ^ FINAL_XOR_VALUE);
+    return crcFinal( crcUpdate( crc(INITIAL_REMAINDER), message, nBytes ) );
 }
 
 #endif /* _crc_h */
\ No newline at end of file
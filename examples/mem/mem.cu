@@ -21,22 +21,218 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
+#include <algorithm>
 #include <nvbio/basic/timer.h>
 #include <nvbio/basic/console.h>
 #include <nvbio/basic/vector.h>
 #include <nvbio/basic/packed_vector.h>
 #include <nvbio/basic/shared_pointer.h>
+#include <nvbio/basic/omp.h>
 #include <nvbio/basic/dna.h>
 #include <nvbio/strings/string_set.h>
 #include <nvbio/strings/infix.h>
 #include <nvbio/strings/seeds.h>
 #include <nvbio/fmindex/mem.h>
+#include <nvbio/fmindex/smem.h>
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/sequence/sequence_mmap.h>
 #include <nvbio/io/fmindex/fmindex.h>
 
 using namespace nvbio;
 
+// run the MEM filter on the host, sweeping the number of threads to report the
+// scalability of the rank and locate phases
+//
+int cpu_mem(
+    const io::FMIndexData*      h_fmi,
+    io::SequenceDataStream*     read_data_file,
+    const uint32                batch_reads,
+    const uint32                batch_bps,
+    const uint32                min_intv,
+    const uint32                max_intv,
+    const uint32                min_span,
+    const uint32                max_threads,
+    const uint32                lanes)
+{
+    typedef io::FMIndexData::fm_index_type              fm_index_type;
+    typedef MEMFilterHost<fm_index_type>                mem_filter_type;
+
+    // fetch the FM-index
+    const fm_index_type f_index = h_fmi->index();
+    const fm_index_type r_index = h_fmi->rindex();
+
+    // create a MEM filter
+    mem_filter_type mem_filter;
+
+    // create a batched SMEM finder
+    SMEMFinderHost<fm_index_type>                       smem_finder;
+    SMEMFinderHost<fm_index_type>::smem_set_type        smems;
+
+    const uint32 mems_batch = 16*1024*1024;
+    nvbio::vector<host_tag,mem_filter_type::mem_type> mems( mems_batch );
+
+    io::SequenceDataHost h_read_data;
+
+    // load a batch of reads
+    while (io::next( DNA_N, &h_read_data, read_data_file, batch_reads, batch_bps ))
+    {
+        const io::SequenceDataAccess<DNA_N> h_read_access( h_read_data );
+
+        const uint32 n_reads = h_read_data.size() / 2;
+
+        log_info(stderr, "  %u reads\n", n_reads);
+
+        // sweep the number of threads in powers of 2, always including max_threads itself
+        for (uint32 n_threads = 1; true; n_threads = nvbio::min( n_threads*2u, max_threads ))
+        {
+            mem_filter.set_threads( n_threads );
+
+            Timer timer;
+            timer.start();
+
+            mem_filter.rank(
+                f_index,
+                r_index,
+                h_read_access.sequence_string_set(),
+                min_intv,
+                max_intv,
+                min_span );
+
+            timer.stop();
+            const float rank_time = timer.seconds();
+
+            const uint64 n_mems = mem_filter.n_mems();
+
+            float locate_time = 0.0f;
+
+            // loop through large batches of hits and locate them
+            for (uint64 mems_begin = 0; mems_begin < n_mems; mems_begin += mems_batch)
+            {
+                const uint64 mems_end = nvbio::min( mems_begin + mems_batch, n_mems );
+
+                timer.start();
+
+                mem_filter.locate(
+                    mems_begin,
+                    mems_end,
+                    mems.begin() );
+
+                timer.stop();
+                locate_time += timer.seconds();
+            }
+
+            log_info(stderr, "    %3u threads : rank %.1f K reads/s, %.2f M MEMs/s - locate %.2f M MEMs/s (%.1f avg MEMs)\n",
+                n_threads,
+                1.0e-3f * float( n_reads ) / rank_time,
+                1.0e-6f * float( n_mems ) / rank_time,
+                locate_time ? 1.0e-6f * float( n_mems ) / locate_time : 0.0f,
+                float( n_mems ) / float( n_reads ) );
+
+            // and now run the batched SMEM finder, interleaving many reads per thread
+            smem_finder.set_threads( n_threads );
+            smem_finder.set_lanes( lanes );
+
+            smem_finder.find(
+                f_index,
+                r_index,
+                h_read_access.sequence_string_set(),
+                smems,
+                min_intv,
+                max_intv,
+                min_span );
+
+            const SMEMStats& smem_stats = smem_finder.stats();
+
+            log_info(stderr, "                  smem %.1f K reads/s (%u lanes) : rank %.1f%%, bookkeeping %.1f%%, assembly %.1f%% - %.1f rank calls/read (%llu vs %llu ranges)\n",
+                1.0e-3f * float( n_reads ) / smem_stats.time,
+                lanes,
+                100.0f * smem_stats.rank_time        / smem_stats.time,
+                100.0f * smem_stats.bookkeeping_time / smem_stats.time,
+                100.0f * smem_stats.assembly_time    / smem_stats.time,
+                float( smem_stats.n_rank_calls ) / float( n_reads ),
+                smem_stats.n_ranges,
+                mem_filter.n_ranges() );
+
+            if (n_threads == max_threads)
+                break;
+        }
+    }
+    return 0;
+}
+
+// check that the batched host SMEM finder returns the same MEM ranges as the device MEM filter
+// did on the same batch of reads
+//
+template <typename mem_filter_type, typename string_set_type>
+bool check_smems(
+    const io::FMIndexData*      h_fmi,
+    const mem_filter_type&      mem_filter,
+    const string_set_type&      string_set,
+    const uint32                min_intv,
+    const uint32                max_intv,
+    const uint32                min_span)
+{
+    typedef io::FMIndexData::fm_index_type              fm_index_type;
+    typedef typename mem_filter_type::rank_type         rank_type;
+
+    // fetch the device ranges
+    HostVectorArray<rank_type> d_ranges;
+    d_ranges = mem_filter.m_mem_ranges;
+
+    // and run the host SMEM finder on the same strings
+    SMEMFinderHost<fm_index_type>                       smem_finder;
+    SMEMFinderHost<fm_index_type>::smem_set_type        smems;
+
+    smem_finder.find(
+        h_fmi->index(),
+        h_fmi->rindex(),
+        string_set,
+        smems,
+        min_intv,
+        max_intv,
+        min_span );
+
+    if (smems.size() != d_ranges.size())
+    {
+        log_error(stderr, "    SMEM check: %u strings, expected %u\n", smems.size(), d_ranges.size());
+        return false;
+    }
+
+    // compare the ranges of each string as sets, ignoring their order and group flags
+    std::vector< std::pair<uint64,uint64> > h_keys;
+    std::vector< std::pair<uint64,uint64> > d_keys;
+
+    for (uint32 i = 0; i < smems.size(); ++i)
+    {
+        const uint32 n_d_ranges = d_ranges[i] ? d_ranges.size(i) : 0u;
+
+        h_keys.resize( smems.n_ranges(i) );
+        d_keys.resize( n_d_ranges );
+
+        for (uint32 j = 0; j < h_keys.size(); ++j)
+        {
+            const rank_type r = smems[i][j];
+            h_keys[j] = std::make_pair( (uint64( r.coords.x ) << 32) | uint64( r.coords.y ), (uint64( r.string_id() ) << 32) | uint64( r.coords.w ) );
+        }
+        for (uint32 j = 0; j < d_keys.size(); ++j)
+        {
+            const rank_type r = d_ranges[i][j];
+            d_keys[j] = std::make_pair( (uint64( r.coords.x ) << 32) | uint64( r.coords.y ), (uint64( r.string_id() ) << 32) | uint64( r.coords.w ) );
+        }
+        std::sort( h_keys.begin(), h_keys.end() );
+        std::sort( d_keys.begin(), d_keys.end() );
+
+        if (h_keys != d_keys)
+        {
+            log_error(stderr, "    SMEM check: string %u has %u host ranges, %u device ranges, or they differ\n",
+                i, uint32( h_keys.size() ), uint32( d_keys.size() ));
+            return false;
+        }
+    }
+    return true;
+}
+
 // main test entry point
 //
 int main(int argc, char* argv[])
@@ -55,10 +251,19 @@ int main(int argc, char* argv[])
     uint32 min_intv         = 1u;
     uint32 max_intv         = 10000u;
     uint32 min_span         = 19u;
+    bool   cpu              = false;
+    uint32 max_threads      = uint32( omp_get_max_threads() );
+    uint32 lanes            = 16u;
 
     for (int i = 0; i < argc; ++i)
     {
-        if (strcmp( argv[i], "-max-reads" ) == 0)
+        if (strcmp( argv[i], "-cpu" ) == 0)
+            cpu = true;
+        else if (strcmp( argv[i], "-threads" ) == 0)
+            max_threads = nvbio::max( uint32( atoi( argv[++i] ) ), 1u );
+        else if (strcmp( argv[i], "-lanes" ) == 0)
+            lanes = nvbio::max( uint32( atoi( argv[++i] ) ), 1u );
+        else if (strcmp( argv[i], "-max-reads" ) == 0)
             max_reads = uint32( atoi( argv[++i] ) );
         else if (strcmp( argv[i], "-min-intv" ) == 0)
             min_intv = atoi( argv[++i] );
@@ -101,6 +306,36 @@ int main(int argc, char* argv[])
         h_fmi = &file_loader;
     }
 
+    if (cpu)
+    {
+        // open a read file
+        SharedPointer<io::SequenceDataStream> read_data_file(
+            io::open_sequence_file(
+                reads,
+                io::Phred33,
+                2*max_reads,
+                uint32(-1),
+                io::SequenceEncoding( io::FORWARD | io::REVERSE_COMPLEMENT ) ) );
+
+        // check whether the file opened correctly
+        if (read_data_file == NULL || read_data_file->is_ok() == false)
+        {
+            log_error(stderr, "    failed opening file \"%s\"\n", reads);
+            return 1u;
+        }
+
+        return cpu_mem(
+            h_fmi,
+            read_data_file.get(),
+            batch_reads,
+            batch_bps,
+            min_intv,
+            max_intv,
+            min_span,
+            max_threads,
+            lanes );
+    }
+
     // build its device version
     const io::SequenceDataDevice d_ref( *h_ref );
     const io::FMIndexDataDevice  d_fmi( *h_fmi, fm_flags );
@@ -146,6 +381,8 @@ int main(int argc, char* argv[])
 
     io::SequenceDataHost h_read_data;
 
+    bool checked = false;
+
     // load a batch of reads
     while (io::next( DNA_N, &h_read_data, read_data_file.get(), batch_reads, batch_bps ))
     {
@@ -183,6 +420,27 @@ int main(int argc, char* argv[])
         log_info(stderr, "    %.1f avg MEMs\n", float( n_mems ) / float( n_reads ) );
         log_info(stderr, "    %.1f K reads/s\n", 1.0e-3f * float(n_reads) / timer.seconds());
 
+        // check the batched host SMEM finder against the device ranks on the first batch
+        if (checked == false)
+        {
+            log_info(stderr, "  checking host SMEMs... started\n");
+
+            const io::SequenceDataAccess<DNA_N> h_read_access( h_read_data );
+
+            if (check_smems(
+                h_fmi,
+                mem_filter,
+                h_read_access.sequence_string_set(),
+                min_intv,
+                max_intv,
+                min_span ) == false)
+                return 1u;
+
+            checked = true;
+
+            log_info(stderr, "  checking host SMEMs... done\n");
+        }
+
         log_info(stderr, "  locating MEMs... started\n");
 
         float locate_time = 0.0f;
@@ -334,7 +334,7 @@ void save_ssa(const uint32 seq_length, const uint32 sa_intv, const uint32 ssa_le
     }
 
     fwrite( &primary,       sizeof(uint32),     1u,         output_file );
-    fwrite( &cumFreq,       sizeof(uint32),     4u,         output_file );
+    fwrite( cumFreq,        sizeof(uint32),     4u,         output_file );
     fwrite( &sa_intv,       sizeof(uint32),     1u,         output_file );
     fwrite( &seq_length,    sizeof(uint32),     1u,         output_file );
     fwrite( &h_ssa[1],      sizeof(uint32),     ssa_len-1,  output_file );
@@ -342,6 +342,229 @@ void save_ssa(const uint32 seq_length, const uint32 sa_intv, const uint32 ssa_le
     log_info(stderr, "writing \"%s\"... done\n", sa_name);
 }
 
+//
+// log the I/O statistics of the spilled outputs
+//
+void log_spill_stats(const SpillStats& stats, const float merge_write_time, const uint64 merge_write_bytes)
+{
+    log_info(stderr, "  spill : %.1f MB written (%.1f MB/s), %llu patches\n",
+        float(stats.bytes_written)/float(1024*1024),
+        float(stats.bytes_written)/float(1024*1024) / nvbio::max( stats.write_time, 1.0e-6f ),
+        stats.n_patches);
+    log_info(stderr, "  merge : %.1f MB read (%.1f MB/s), %.1f MB written (%.1f MB/s)\n",
+        float(stats.bytes_read)/float(1024*1024),
+        float(stats.bytes_read)/float(1024*1024) / nvbio::max( stats.read_time, 1.0e-6f ),
+        float(merge_write_bytes)/float(1024*1024),
+        float(merge_write_bytes)/float(1024*1024) / nvbio::max( merge_write_time, 1.0e-6f ));
+}
+
+//
+// .bwt file, merged from a spilled BWT: the dollar symbol is removed and the symbols are packed;
+// returns false on errors, leaving the spill to be removed by its owner
+//
+bool save_spilled_bwt(const uint32 seq_length, const uint32 seq_words, const uint32 primary, const uint32* cumFreq, SpillFile& bwt_spill, const char* bwt_name, const bool compute_crc)
+{
+    typedef PackedStream<uint32*,uint8,io::FMIndexData::BWT_BITS,io::FMIndexData::BWT_BIG_ENDIAN> stream_type;
+
+    const uint32 SYMBOLS_PER_WORD = (8u*sizeof(uint32)) / io::FMIndexData::BWT_BITS;
+    const uint32 BLOCK_WORDS      = 1024*1024;
+    const uint32 BLOCK_SYMBOLS    = BLOCK_WORDS * SYMBOLS_PER_WORD;
+
+    log_info(stderr, "\nwriting \"%s\"... started\n", bwt_name);
+    FILE* output_file = fopen( bwt_name, "wb" );
+    if (output_file == NULL)
+    {
+        log_error(stderr, "  could not open output file \"%s\"!\n", bwt_name );
+        return false;
+    }
+    fwrite( &primary, sizeof(uint32), 1, output_file );
+    fwrite( cumFreq,  sizeof(uint32), 4, output_file );
+
+    std::vector<uint8>          h_block( BLOCK_SYMBOLS );
+    thrust::host_vector<uint32> h_words( BLOCK_WORDS, 0u );
+
+    stream_type h_packed( nvbio::plain_view( h_words ) );
+
+    float  write_time = 0.0f;
+    uint64 n_words    = 0u;
+    uint32 n_packed   = 0u;
+    crc    remainder  = INITIAL_REMAINDER;
+
+    bwt_spill.rewind();
+
+    for (uint64 slot = 0, n_read; (n_read = bwt_spill.read( BLOCK_SYMBOLS, &h_block[0] )) > 0; slot += n_read)
+    {
+        if (compute_crc)
+        {
+            // accumulate the crc of the symbols around the dollar
+            if (primary >= slot && primary < slot + n_read)
+            {
+                const uint32 dollar = uint32( primary - slot );
+                remainder = crcUpdate( remainder, &h_block[0],              dollar );
+                remainder = crcUpdate( remainder, &h_block[0] + dollar+1u,  uint32( n_read ) - dollar - 1u );
+            }
+            else
+                remainder = crcUpdate( remainder, &h_block[0], uint32( n_read ) );
+        }
+
+        for (uint32 i = 0; i < n_read; ++i)
+        {
+            // skip the dollar
+            if (slot + i == primary)
+                continue;
+
+            h_packed[ n_packed++ ] = h_block[i];
+
+            if (n_packed == BLOCK_SYMBOLS)
+            {
+                ScopedTimer<float> timer( &write_time );
+
+                if (save_stream( output_file, BLOCK_WORDS, nvbio::plain_view( h_words ) ) == false)
+                {
+                    log_error(stderr, "  writing failed!\n");
+                    fclose( output_file );
+                    return false;
+                }
+                thrust::fill( h_words.begin(), h_words.end(), 0u );
+
+                n_words += BLOCK_WORDS;
+                n_packed = 0u;
+            }
+        }
+    }
+    {
+        ScopedTimer<float> timer( &write_time );
+
+        const uint32 n_last_words = util::divide_ri( n_packed, SYMBOLS_PER_WORD );
+        if (save_stream( output_file, n_last_words, nvbio::plain_view( h_words ) ) == false)
+        {
+            log_error(stderr, "  writing failed!\n");
+            fclose( output_file );
+            return false;
+        }
+        n_words += n_last_words;
+    }
+    fclose( output_file );
+
+    if (n_words != seq_words)
+    {
+        log_error(stderr, "  spilled BWT size mismatch: %llu words, expected %u\n", n_words, seq_words);
+        return false;
+    }
+    if (compute_crc)
+        log_info(stderr, "  crc: %u\n", crcFinal( remainder ));
+
+    log_spill_stats( bwt_spill.stats(), write_time, n_words * sizeof(uint32) );
+    log_info(stderr, "writing \"%s\"... done\n", bwt_name);
+    return true;
+}
+
+//
+// .sa file, merged from a spilled SSA; returns false on errors, leaving the spill to be removed by its owner
+//
+bool save_spilled_ssa(const uint32 seq_length, const uint32 sa_intv, const uint32 ssa_len, const uint32 primary, const uint32* cumFreq, SpillFile& ssa_spill, const char* sa_name)
+{
+    const uint32 BLOCK_SIZE = 4*1024*1024;
+
+    log_info(stderr, "\nwriting \"%s\"... started\n", sa_name);
+    FILE* output_file = fopen( sa_name, "wb" );
+    if (output_file == NULL)
+    {
+        log_error(stderr, "  could not open output file \"%s\"!\n", sa_name );
+        return false;
+    }
+
+    fwrite( &primary,       sizeof(uint32),     1u,         output_file );
+    fwrite( cumFreq,        sizeof(uint32),     4u,         output_file );
+    fwrite( &sa_intv,       sizeof(uint32),     1u,         output_file );
+    fwrite( &seq_length,    sizeof(uint32),     1u,         output_file );
+
+    std::vector<uint32> h_block( BLOCK_SIZE );
+
+    float  write_time = 0.0f;
+    uint64 n_samples  = 0u;
+
+    ssa_spill.rewind();
+
+    // skip the implicit empty suffix
+    ssa_spill.read( 1u, &h_block[0] );
+
+    for (uint64 n_read; (n_read = ssa_spill.read( BLOCK_SIZE, &h_block[0] )) > 0; n_samples += n_read)
+    {
+        ScopedTimer<float> timer( &write_time );
+
+        if (fwrite( &h_block[0], sizeof(uint32), n_read, output_file ) != n_read)
+        {
+            log_error(stderr, "  writing failed!\n");
+            fclose( output_file );
+            return false;
+        }
+    }
+    fclose( output_file );
+
+    if (n_samples != ssa_len-1)
+    {
+        log_error(stderr, "  spilled SSA size mismatch: %llu samples, expected %u\n", n_samples, ssa_len-1);
+        return false;
+    }
+    log_spill_stats( ssa_spill.stats(), write_time, n_samples * sizeof(uint32) );
+    log_info(stderr, "writing \"%s\"... done\n", sa_name);
+    return true;
+}
+
+//
+// build the BWT and SSA of a device-side string, spilling them to the given scratch files
+//
+template <typename string_type>
+uint32 build_spilled_bwt(
+    const uint32        seq_length,
+    const string_type   d_string,
+    const uint32        sa_intv,
+    SpillFile&          bwt_spill,
+    SpillFile&          ssa_spill,
+    BWTParams*          params)
+{
+    StringBWTSSASpillHandler<string_type> output(
+        seq_length,                         // string length
+        d_string,                           // string
+        sa_intv,                            // SSA sampling interval
+        &bwt_spill,                         // output bwt spill
+        &ssa_spill );                       // output ssa spill
+
+    cuda::blockwise_suffix_sort(
+        seq_length,
+        d_string,
+        output,
+        params );
+
+    bwt_spill.flush();
+    ssa_spill.flush();
+
+    return output.primary;
+}
+
+//
+// strip any directory from an output name
+//
+const char* output_base_name(const char* output_name)
+{
+    const char* base_name = output_name;
+    for (const char* p = output_name; *p != '\0'; ++p)
+    {
+        if (*p == '/' || *p == '\\')
+            base_name = p + 1;
+    }
+    return base_name;
+}
+
+//
+// return the name of a scratch file for the given output
+//
+std::string scratch_file_name(const char* scratch_dir, const char* output_name, const char* ext)
+{
+    return std::string( scratch_dir ) + "/" + output_base_name( output_name ) + ext;
+}
+
 int build(
     const char*  input_name,
     const char*  output_name,
@@ -353,7 +576,10 @@ int build(
     const char*  rsa_name,
     const uint64 max_length,
     const PacType pac_type,
-    const bool    compute_crc)
+    const bool    compute_crc,
+    const uint32  sa_intv,
+    const char*   scratch_dir,
+    const uint64  host_memory)
 {
     std::vector<std::string> sortednames;
     list_files(input_name, sortednames);
@@ -390,13 +616,27 @@ int build(
     log_info(stderr, "  buffer size     : %.1f MB\n",
         2*seq_words*sizeof(uint32)/1.0e6f );
 
-    const uint32 sa_intv = nvbio::io::FMIndexData::SA_INT;
+    // the whole pipeline indexes the text with 32-bit integers, in external-memory mode as well:
+    // reject longer inputs upfront rather than after having spent hours sorting them
+    if (seq_length >= uint64( uint32(-1) ))
+    {
+        log_error(stderr, "  sequence too long: %llu bps, nvBWT supports at most %u bps per index%s\n",
+            seq_length, uint32(-1) - 1u,
+            scratch_dir ? " (--scratch-dir saves memory but does not lift this limit)" : "");
+        log_error(stderr, "  split the input or clamp it with --max-length\n");
+        return 1;
+    }
+
     const uint32 ssa_len = (seq_length + sa_intv) / sa_intv;
 
+    // in external-memory mode, the BWT and the SSA are spilled to disk as they are produced,
+    // and only the packed string is kept in host memory
+    const bool external = (scratch_dir != NULL);
+
     // allocate the actual storage
     thrust::host_vector<uint32> h_string_storage( seq_words+1 );
-    thrust::host_vector<uint32> h_bwt_storage( seq_words+1 );
-    thrust::host_vector<uint32> h_ssa( ssa_len );
+    thrust::host_vector<uint32> h_bwt_storage( external ? 0u : seq_words+1 );
+    thrust::host_vector<uint32> h_ssa( external ? 0u : ssa_len );
 
     typedef PackedStream<const uint32*,uint8,io::FMIndexData::BWT_BITS,io::FMIndexData::BWT_BIG_ENDIAN> const_stream_type;
     typedef PackedStream<      uint32*,uint8,io::FMIndexData::BWT_BITS,io::FMIndexData::BWT_BIG_ENDIAN>       stream_type;
@@ -452,8 +692,25 @@ int build(
         BWTParams params;
         uint32    primary;
 
+        if (host_memory)
+            params.host_memory = host_memory;
+
+        // in external-memory mode, let the sorter spill its super-blocks as well, naming
+        // its scratch files after the output so that concurrent runs do not collide
+        const std::string sort_prefix = std::string( output_base_name( output_name ) ) + ".sufsort";
+        params.scratch_dir    = scratch_dir;
+        params.scratch_prefix = sort_prefix.c_str();
+
         thrust::device_vector<uint32> d_string_storage( h_string_storage );
-        thrust::device_vector<uint32> d_bwt_storage( seq_words+1 );
+        thrust::device_vector<uint32> d_bwt_storage( external ? 0u : seq_words+1 );
+
+        SpillFile bwt_spill;
+        SpillFile ssa_spill;
+        if (external)
+        {
+            bwt_spill.open( scratch_file_name( scratch_dir, output_name, ".bwt.spill" ).c_str(), sizeof(uint8) );
+            ssa_spill.open( scratch_file_name( scratch_dir, output_name, ".sa.spill" ).c_str(),  sizeof(uint32) );
+        }
 
         const_stream_type d_string( nvbio::plain_view( d_string_storage ) );
               stream_type d_bwt(    nvbio::plain_view( d_bwt_storage ) );
@@ -462,6 +719,9 @@ int build(
 
         log_info(stderr, "\nbuilding forward BWT... started\n");
         timer.start();
+        if (external)
+            primary = build_spilled_bwt( seq_length, d_string, sa_intv, bwt_spill, ssa_spill, &params );
+        else
         {
             StringBWTSSAHandler<const_stream_type,stream_type,uint32*> output(
                 seq_length,                         // string length
@@ -486,6 +746,15 @@ int build(
         log_info(stderr, "  primary: %u\n", primary);
 
         // save everything to disk
+        if (external)
+        {
+            // on failure, return through the spills' destructors so as to remove the scratch files
+            save_pac( seq_length, nvbio::plain_view( h_string_storage ), pac_name, pac_type );
+            if (save_spilled_bwt( seq_length, seq_words, primary, cumFreq, bwt_spill, bwt_name, compute_crc ) == false ||
+                save_spilled_ssa( seq_length, sa_intv, ssa_len, primary, cumFreq, ssa_spill, sa_name ) == false)
+                return 1;
+        }
+        else
         {
             // copy to the host
             thrust::copy( d_bwt_storage.begin(),
@@ -505,6 +774,24 @@ int build(
         }
 
         // reverse the string in h_string_storage
+        if (external)
+        {
+            // reverse the string in place, as there is no spare storage
+            for (uint32 i = 0; i < seq_length/2; ++i)
+            {
+                const uint8 c = h_string[i];
+                h_string[i] = uint8( h_string[ seq_length - i - 1u ] );
+                h_string[ seq_length - i - 1u ] = c;
+            }
+
+            // copy the new string to the device
+            d_string_storage = h_string_storage;
+
+            // and reopen the spills
+            bwt_spill.open( scratch_file_name( scratch_dir, output_name, ".rbwt.spill" ).c_str(), sizeof(uint8) );
+            ssa_spill.open( scratch_file_name( scratch_dir, output_name, ".rsa.spill" ).c_str(),  sizeof(uint32) );
+        }
+        else
         {
             // reuse the bwt storage to build the reverse
             uint32* h_rbase_stream = nvbio::plain_view( h_bwt_storage );
@@ -524,6 +811,9 @@ int build(
 
         log_info(stderr, "\nbuilding reverse BWT... started\n");
         timer.start();
+        if (external)
+            primary = build_spilled_bwt( seq_length, d_string, sa_intv, bwt_spill, ssa_spill, &params );
+        else
         {
             StringBWTSSAHandler<const_stream_type,stream_type,uint32*> output(
                 seq_length,                         // string length
@@ -548,6 +838,15 @@ int build(
         log_info(stderr, "  primary: %u\n", primary);
 
         // save everything to disk
+        if (external)
+        {
+            // on failure, return through the spills' destructors so as to remove the scratch files
+            save_pac( seq_length, nvbio::plain_view( h_string_storage ), rpac_name, pac_type );
+            if (save_spilled_bwt( seq_length, seq_words, primary, cumFreq, bwt_spill, rbwt_name, compute_crc ) == false ||
+                save_spilled_ssa( seq_length, sa_intv, ssa_len, primary, cumFreq, ssa_spill, rsa_name ) == false)
+                return 1;
+        }
+        else
         {
             // copy to the host
             thrust::copy( d_bwt_storage.begin(),
@@ -623,7 +922,12 @@ int main(int argc, char* argv[])
         log_info(stderr, "    -b | --byte-packing   output byte packed .pac\n");
         log_info(stderr, "    -w | --word-packing   output word packed .wpac\n");
         log_info(stderr, "    -c | --crc            compute crcs\n");
+        log_info(stderr, "    -s | --sa-intv        SSA sampling interval (16|32|64, default 16)\n");
         log_info(stderr, "    -d | --device         cuda device\n");
+        log_info(stderr, "    -x | --scratch-dir    spill the BWT, SSA and sorting buffers to the given directory\n");
+        log_info(stderr, "                          (saves host memory, but texts are still limited to 4 Gbps:\n");
+        log_info(stderr, "                           longer inputs are rejected)\n");
+        log_info(stderr, "    -M | --host-memory    host memory budget for sorting, in MB\n");
         exit(0);
     }
 
@@ -631,7 +935,10 @@ int main(int argc, char* argv[])
     uint64  max_length  = uint64(-1);
     PacType pac_type    = BPAC;
     bool    crc         = false;
+    uint32  sa_intv     = nvbio::io::FMIndexData::SA_INT;
     int     cuda_device = -1;
+    const char* scratch_dir = NULL;
+    uint64  host_memory = 0u;
 
     uint32 n_files = 0;
     for (int32 i = 1; i < argc; ++i)
@@ -664,11 +971,31 @@ int main(int argc, char* argv[])
         {
             crc = true;
         }
+        else if ((strcmp( arg, "-s" )               == 0) ||
+                 (strcmp( arg, "--sa-intv" )        == 0))
+        {
+            sa_intv = atoi( argv[++i] );
+            if (nvbio::io::FMIndexData::is_supported_sa_intv( sa_intv ) == false)
+            {
+                log_error(stderr, "unsupported SSA interval %u\n", sa_intv);
+                exit(1);
+            }
+        }
         else if ((strcmp( arg, "-d" )               == 0) ||
                  (strcmp( arg, "--device" )         == 0))
         {
             cuda_device = atoi( argv[++i] );
         }
+        else if ((strcmp( arg, "-x" )               == 0) ||
+                 (strcmp( arg, "--scratch-dir" )    == 0))
+        {
+            scratch_dir = argv[++i];
+        }
+        else if ((strcmp( arg, "-M" )               == 0) ||
+                 (strcmp( arg, "--host-memory" )    == 0))
+        {
+            host_memory = uint64( atoi( argv[++i] ) ) * 1024u*1024u;
+        }
         else
             file_names[ n_files++ ] = argv[i];
     }
@@ -691,6 +1018,9 @@ int main(int argc, char* argv[])
     log_info(stderr, "max length : %lld\n", max_length);
     log_info(stderr, "input      : \"%s\"\n", input_name);
     log_info(stderr, "output     : \"%s\"\n", output_name);
+    log_info(stderr, "sa intv    : %u\n", sa_intv);
+    if (scratch_dir)
+        log_info(stderr, "scratch    : \"%s\"\n", scratch_dir);
 
     int device_count;
     cudaGetDeviceCount(&device_count);
@@ -737,6 +1067,6 @@ int main(int argc, char* argv[])
     cudaMemGetInfo(&free, &total);
     NVBIO_CUDA_DEBUG_STATEMENT( log_info(stderr,"device mem : total: %.1f GB, free: %.1f GB\n", float(total)/float(1024*1024*1024), float(free)/float(1024*1024*1024)) );
 
-    return build( input_name, output_name, pac_name, rpac_name, bwt_name, rbwt_name, sa_name, rsa_name, max_length, pac_type, crc );
+    return build( input_name, output_name, pac_name, rpac_name, bwt_name, rbwt_name, sa_name, rsa_name, max_length, pac_type, crc, sa_intv, scratch_dir, host_memory );
 }
 
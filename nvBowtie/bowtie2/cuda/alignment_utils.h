@@ -115,11 +115,11 @@ template <typename vector>
 struct Backtracker
 {
     // constructor
-    NVBIO_FORCEINLINE NVBIO_DEVICE 
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE 
     Backtracker(vector vec, const uint32 _capacity) : out(vec), size(0), prev(255), capacity(_capacity) {}
 
     // encode a soft clipping operation
-    NVBIO_FORCEINLINE NVBIO_DEVICE 
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE 
     void clip(const uint32 l)
     {
         if (l)
@@ -130,7 +130,7 @@ struct Backtracker
     }
 
     // encode a new operation
-    NVBIO_FORCEINLINE NVBIO_DEVICE 
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE 
     void push(uint8 type)
     {
         NVBIO_CUDA_DEBUG_ASSERT( type == aln::SUBSTITUTION ||
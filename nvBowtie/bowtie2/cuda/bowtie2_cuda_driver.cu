@@ -34,6 +34,8 @@
 #include <nvBowtie/bowtie2/cuda/input_thread.h>
 #include <nvBowtie/bowtie2/cuda/aligner.h>
 #include <nvBowtie/bowtie2/cuda/aligner_inst.h>
+#include <nvBowtie/bowtie2/cuda/host_aligner.h>
+#include <nvBowtie/bowtie2/cuda/metrics.h>
 #include <nvbio/basic/cuda/arch.h>
 #include <nvbio/basic/timer.h>
 #include <nvbio/basic/console.h>
@@ -45,6 +47,7 @@
 #include <nvbio/fmindex/ssa.h>
 #include <nvbio/fmindex/fmindex.h>
 #include <nvbio/fmindex/fmindex_device.h>
+#include <nvbio/io/output/output_dedup.h>
 #include <thrust/host_vector.h>
 #include <thrust/device_vector.h>
 #include <thrust/scan.h>
@@ -104,6 +107,13 @@ void parse_options(Params& params, const std::map<std::string,std::string>& opti
     params.randomized       = uint_option(options, "rand",             init ? 0u      : params.randomized);           // use randomized selection
     params.top_seed         = uint_option(options, "top",              init ? 0u      : params.top_seed);             // explore top seed entirely
     params.min_read_len     = uint_option(options, "min-read-len",     init ? 12u     : params.min_read_len);         // minimum read length
+    params.dedup            = (bool)uint_option(options, "dedup",      init ? 0u      : params.dedup);                // align duplicate reads only once
+    params.dedup_cache      = uint_option(options, "dedup-cache",      init ? 256*1024u : params.dedup_cache);        // cross-batch duplicate cache size
+    params.dedup_quals      = (bool)uint_option(options, "dedup-quals", init ? 1u     : params.dedup_quals);          // match qualities as well as sequences
+    params.metrics_json     = string_option(options, "metrics-json",   init ? ""      : params.metrics_json.c_str());   // JSON metrics file
+    params.metrics_prom     = string_option(options, "metrics-prom",   init ? ""      : params.metrics_prom.c_str());   // Prometheus metrics file
+    params.metrics_socket   = string_option(options, "metrics-socket", init ? ""      : params.metrics_socket.c_str()); // Prometheus metrics socket
+    params.metrics_interval = uint_option(options, "metrics-interval", init ? 16u     : params.metrics_interval);     // metrics update interval, in batches
 
     const bool local = params.alignment_type == LocalAlignment;
 
@@ -166,6 +176,13 @@ int driver(
         log_warning(stderr, "edit-distance scoring is incompatible with local alignment, switching to Smith-Waterman\n");
         params.scoring_mode = SmithWatermanMode;
     }
+    if (params.dedup && params.mode == AllMapping)
+    {
+        // the alignments of a sequence can only be fanned out to its duplicates in the best-mapping modes,
+        // which report a fixed number of alignments per read
+        log_warning(stderr, "duplicate removal is only supported in the best-mapping modes: ignoring dedup\n");
+        params.dedup = false;
+    }
 
     // build an empty report
     FILE* html_output = (params.report != std::string("")) ? fopen( params.report.c_str(), "w" ) : NULL;
@@ -277,10 +294,18 @@ int driver(
     nvbio::bowtie2::cuda::BowtieMapq< BowtieMapq2< SmithWatermanScoringScheme<> > > new_mapq_eval(scoring_scheme.sw);
     aligner.output_file->configure_mapq_evaluator(&new_mapq_eval, params.mapq_filter);
 
+    // setup the duplicate-read cache
+    io::DuplicateReadCache dedup( params.dedup_cache, params.dedup_quals );
+    if (params.dedup)
+        aligner.output_file->configure_dedup( &dedup );
+
     // setup the input thread
     InputThread input_thread( &read_data_stream, stats, BATCH_SIZE );
     input_thread.create();
 
+    // setup the metrics exporter
+    MetricsExporter metrics( params );
+
     uint32 input_set  = 0;
     uint32 n_reads    = 0;
 
@@ -313,25 +338,26 @@ int driver(
 
         aligner.output_file->start_batch(read_data_host);
 
-        io::SequenceDataDevice read_data( *read_data_host );
+        // collapse the duplicate reads, only aligning their unique representatives
+        const io::SequenceDataHost* align_data_host = params.dedup ? &dedup.dedup( *read_data_host ) : read_data_host;
+
+        io::SequenceDataDevice read_data( *align_data_host );
         cudaThreadSynchronize();
 
         timer.stop();
         stats.read_HtoD.add( read_data.size(), timer.seconds() );
 
-        // mark this set as ready to be reused
-        input_thread.read_data[ input_set ] = NULL;
-
-        // advance input set pointer
-        input_set = (input_set + 1) % InputThread::BUFFERS;
-
         const uint32 count = read_data_host->size();
         log_info(stderr, "aligning reads [%u, %u]\n", read_begin, read_begin + count - 1u);
         log_verbose(stderr, "  %u reads\n", read_data_host->size());
         log_verbose(stderr, "  %.3f M bps (%.1f MB)\n", float(read_data_host->bps())/1.0e6f, float(read_data_host->words()*sizeof(uint32)+read_data_host->bps()*sizeof(char))/float(1024*1024));
         log_verbose(stderr, "  %.1f bps/read (min: %u, max: %u)\n", float(read_data_host->bps())/float(read_data_host->size()), read_data_host->min_sequence_len(), read_data_host->max_sequence_len());
 
-        if (params.mode == AllMapping)
+        if (align_data_host->size() == 0)
+        {
+            // all reads have been found in the duplicate-read cache
+        }
+        else if (params.mode == AllMapping)
         {
             all_ed(
                 aligner,
@@ -380,14 +406,32 @@ int driver(
 
         aligner.output_file->end_batch();
 
+        // the output is done with the host reads: mark this set as ready to be reused
+        input_thread.release( input_set );
+
+        // advance input set pointer
+        input_set = (input_set + 1) % InputThread::BUFFERS;
+
         // increase the total reads counter
         n_reads += count;
 
         log_verbose(stderr, "  %.1f K reads/s\n", 1.0e-3f * float(n_reads) / stats.global_time);
+
+        // update the live metrics
+        metrics.collect( stats, input_thread.m_stats_lock, aligner.output_file->get_aggregate_statistics(), n_reads, input_thread.occupancy(), InputThread::BUFFERS );
     }
 
     input_thread.join();
 
+    // write the final metrics
+    metrics.collect( stats, input_thread.m_stats_lock, aligner.output_file->get_aggregate_statistics(), n_reads, input_thread.occupancy(), InputThread::BUFFERS, true );
+    metrics.stop();
+
+    log_verbose(stderr, "  read batches: %.1f MB peak, %.1f MB reserved, %llu reallocations\n",
+        float(input_thread.read_data_pool.peak_bytes())/float(1024*1024),
+        float(input_thread.read_data_pool.reserved_bytes())/float(1024*1024),
+        input_thread.read_data_pool.n_grows());
+
     io::IOStats iostats;
 
     aligner.output_file->close();
@@ -408,6 +452,10 @@ int driver(
     memcpy(stats.mapq_bins, iostats.mate1.mapq_bins,             sizeof(iostats.mate1.mapq_bins));
     memcpy(stats.mapped2,   iostats.mate1.mapped_ed_correlation, sizeof(iostats.mate1.mapped_ed_correlation));
 
+    stats.n_dedup_reads      = params.dedup ? dedup.n_reads : 0u;
+    stats.n_dedup_batch_hits = dedup.n_batch_hits;
+    stats.n_dedup_cache_hits = dedup.n_cache_hits;
+
     delete aligner.output_file;
 
     global_timer.stop();
@@ -428,6 +476,8 @@ int driver(
     log_stats(stderr, "  reads I/O    : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", stats.read_io.time, 1.0e-6f * stats.read_io.avg_speed(), 1.0e-6f * stats.read_io.max_speed);
     log_stats(stderr, "    exposed    : %.2f sec (avg: %.3fK reads/s).\n", polling_time, 1.0e-3f * float(n_reads)/polling_time);
     log_stats(stderr, "  output I/O   : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", stats.io.time, 1.0e-6f * stats.io.avg_speed(), 1.0e-6f * stats.io.max_speed);
+    if (params.dedup)
+        log_stats(stderr, "  duplicates   : %.2f %% hit rate (%llu in-batch, %llu cached)\n", 100.0f * dedup.hit_rate(), dedup.n_batch_hits, dedup.n_cache_hits);
 
     std::vector<uint32>& mapped         = stats.mapped;
     uint32&              n_mapped       = stats.n_mapped;
@@ -453,6 +503,244 @@ int driver(
     return 0;
 }
 
+//
+// single-end host driver
+//
+int host_driver(
+    const char*                              output_name,
+    const io::SequenceData&                  reference_data,
+    const io::FMIndexData&                   driver_data,
+          io::SequenceDataStream&            read_data_stream,
+    const std::map<std::string,std::string>& options)
+{
+    log_visible(stderr, "Bowtie2 host driver... started\n");
+
+    // WARNING: we don't do any error checking on passed parameters!
+    Params params;
+    {
+        bool init = true;
+        std::string config = string_option(options, "config", "" );
+        if (config != "") { parse_options( params, load_options( config.c_str() ), init ); init = false; }
+                            parse_options( params, options,                        init );
+    }
+    if (params.alignment_type == LocalAlignment &&
+        params.scoring_mode == EditDistanceMode)
+    {
+        log_warning(stderr, "edit-distance scoring is incompatible with local alignment, switching to Smith-Waterman\n");
+        params.scoring_mode = SmithWatermanMode;
+    }
+    if (params.mode == AllMapping)
+    {
+        log_error(stderr, "all-mapping is not supported by the host driver\n");
+        return 1;
+    }
+    if (params.allow_sub || params.randomized)
+        log_warning(stderr, "the host driver only supports exact, deterministic seeding: ignoring N and rand\n");
+
+    if (driver_data.has_ssa() == false || driver_data.has_default_intervals() == false)
+    {
+        log_error(stderr, "the host driver requires an FM-index with a sampled suffix array and default intervals\n");
+        return 1;
+    }
+
+    // compute band length
+    const uint32 band_len = Aligner::band_length( params.max_dist );
+
+    // print command line options
+    log_visible(stderr, "  mode           = %s\n", mapping_mode( params.mode ));
+    log_visible(stderr, "  scoring        = %s\n", scoring_mode( params.scoring_mode ));
+    log_visible(stderr, "  alignment type = %s\n", params.alignment_type == LocalAlignment ? "local" : "end-to-end");
+    log_visible(stderr, "  seed length    = %u\n", params.seed_len);
+    log_visible(stderr, "  seed interval  = (%s, %.3f, %.3f)\n", params.seed_freq.type_symbol(), params.seed_freq.k, params.seed_freq.m);
+    log_visible(stderr, "  max hits       = %u\n", params.max_hits);
+    log_visible(stderr, "  max edit dist  = %u (band len %u)\n", params.max_dist, band_len);
+    log_visible(stderr, "  max effort     = %u\n", params.max_effort);
+    log_visible(stderr, "  mapQ filter    = %u\n", params.mapq_filter);
+
+    const HostAligner::fmi_type fmi = driver_data.index();
+
+    HostAligner host_aligner;
+
+    const uint32 BATCH_SIZE = 128*1024;
+    log_stats(stderr, "  processing reads in batches of %uK\n", BATCH_SIZE/1024);
+
+    float polling_time = 0.0f;
+    Timer global_timer;
+    global_timer.start();
+
+    UberScoringScheme scoring_scheme;
+    scoring_scheme.ed = EditDistanceScoringScheme( params );
+    scoring_scheme.sw = SmithWatermanScoringScheme<>();
+    if (AlignmentType( params.alignment_type ) == LocalAlignment)
+        scoring_scheme.sw = SmithWatermanScoringScheme<>::local();
+
+    // load scoring scheme from file
+    if (params.scoring_file != "")
+        scoring_scheme.sw = load_scoring_scheme( params.scoring_file.c_str(), AlignmentType( params.alignment_type ) );
+
+    Stats stats( params );
+
+    io::OutputFile* output_file = io::OutputFile::open(output_name,
+                                                       io::SINGLE_END,
+                                                       io::BNT(reference_data));
+
+    nvbio::bowtie2::cuda::BowtieMapq< BowtieMapq2< SmithWatermanScoringScheme<> > > new_mapq_eval(scoring_scheme.sw);
+    output_file->configure_mapq_evaluator(&new_mapq_eval, params.mapq_filter);
+
+    // setup the duplicate-read cache
+    io::DuplicateReadCache dedup( params.dedup_cache, params.dedup_quals );
+    if (params.dedup)
+        output_file->configure_dedup( &dedup );
+
+    io::CPUOutputBatch cpu_batch;
+
+    // setup the input thread
+    InputThread input_thread( &read_data_stream, stats, BATCH_SIZE );
+    input_thread.create();
+
+    // setup the metrics exporter
+    MetricsExporter metrics( params );
+
+    uint32 input_set  = 0;
+    uint32 n_reads    = 0;
+
+    // loop through the batches of reads
+    for (uint32 read_begin = 0; true; read_begin += BATCH_SIZE)
+    {
+        Timer polling_timer;
+        polling_timer.start();
+
+        // poll until the current input set is loaded...
+        while (input_thread.read_data[ input_set ] == NULL) {}
+
+        polling_timer.stop();
+        polling_time += polling_timer.seconds();
+
+        io::SequenceDataHost* read_data_host = input_thread.read_data[ input_set ];
+        if (read_data_host == (io::SequenceDataHost*)InputThread::INVALID)
+            break;
+
+        if (read_data_host->max_sequence_len() > Aligner::MAX_READ_LEN)
+        {
+            log_error(stderr, "unsupported read length %u (maximum is %u)\n",
+                read_data_host->max_sequence_len(),
+                Aligner::MAX_READ_LEN );
+            break;
+        }
+
+        output_file->start_batch(read_data_host);
+
+        const uint32 count = read_data_host->size();
+        log_info(stderr, "aligning reads [%u, %u]\n", read_begin, read_begin + count - 1u);
+        log_verbose(stderr, "  %u reads\n", read_data_host->size());
+        log_verbose(stderr, "  %.3f M bps (%.1f MB)\n", float(read_data_host->bps())/1.0e6f, float(read_data_host->words()*sizeof(uint32)+read_data_host->bps()*sizeof(char))/float(1024*1024));
+        log_verbose(stderr, "  %.1f bps/read (min: %u, max: %u)\n", float(read_data_host->bps())/float(read_data_host->size()), read_data_host->min_sequence_len(), read_data_host->max_sequence_len());
+
+        // collapse the duplicate reads, only aligning their unique representatives
+        const io::SequenceDataHost* align_data_host = params.dedup ? &dedup.dedup( *read_data_host ) : read_data_host;
+
+        if (align_data_host->size())
+        {
+            host_aligner.best_approx(
+                params,
+                band_len,
+                fmi,
+                scoring_scheme,
+                reference_data,
+                *align_data_host,
+                cpu_batch,
+                stats );
+
+            cpu_batch.read_data[ io::MATE_1 ] = read_data_host;
+            cpu_batch.read_data[ io::MATE_2 ] = NULL;
+
+            // hand the results over to the output file
+            output_file->process( cpu_batch );
+        }
+
+        global_timer.stop();
+        stats.global_time += global_timer.seconds();
+        global_timer.start();
+
+        output_file->end_batch();
+
+        // the output is done with the host reads: mark this set as ready to be reused
+        input_thread.release( input_set );
+
+        // advance input set pointer
+        input_set = (input_set + 1) % InputThread::BUFFERS;
+
+        // increase the total reads counter
+        n_reads += count;
+
+        log_verbose(stderr, "  %.1f K reads/s\n", 1.0e-3f * float(n_reads) / stats.global_time);
+
+        // update the live metrics
+        metrics.collect( stats, input_thread.m_stats_lock, output_file->get_aggregate_statistics(), n_reads, input_thread.occupancy(), InputThread::BUFFERS );
+    }
+
+    input_thread.join();
+
+    // write the final metrics
+    metrics.collect( stats, input_thread.m_stats_lock, output_file->get_aggregate_statistics(), n_reads, input_thread.occupancy(), InputThread::BUFFERS, true );
+    metrics.stop();
+
+    output_file->close();
+
+    // transfer I/O statistics to the old stats struct
+    const io::IOStats iostats = output_file->get_aggregate_statistics();
+
+    stats.io = iostats.output_process_timings;
+    stats.n_mapped          = iostats.mate1.n_mapped;
+    stats.n_ambiguous       = iostats.mate1.n_ambiguous;
+    stats.n_nonambiguous    = iostats.mate1.n_unambiguous;
+    stats.n_unique          = iostats.mate1.n_unique;
+    stats.n_multiple        = iostats.mate1.n_multiple;
+    stats.mapped            = iostats.mate1.mapped_ed_histogram;
+    stats.f_mapped          = iostats.mate1.mapped_ed_histogram_fwd;
+    stats.r_mapped          = iostats.mate1.mapped_ed_histogram_rev;
+    memcpy(stats.mapq_bins, iostats.mate1.mapq_bins,             sizeof(iostats.mate1.mapq_bins));
+    memcpy(stats.mapped2,   iostats.mate1.mapped_ed_correlation, sizeof(iostats.mate1.mapped_ed_correlation));
+
+    stats.n_dedup_reads      = params.dedup ? dedup.n_reads : 0u;
+    stats.n_dedup_batch_hits = dedup.n_batch_hits;
+    stats.n_dedup_cache_hits = dedup.n_cache_hits;
+
+    delete output_file;
+
+    global_timer.stop();
+    stats.global_time += global_timer.seconds();
+
+    nvbio::bowtie2::cuda::generate_report(stats, params.report.c_str());
+
+    log_stats(stderr, "  total        : %.2f sec (avg: %.1fK reads/s).\n", stats.global_time, 1.0e-3f * float(n_reads)/stats.global_time);
+    log_stats(stderr, "  aligning     : %.2f sec (avg: %.3fM seeds/s, max: %.3fM seeds/s, %llu extensions).\n", stats.score.time, 1.0e-6f * stats.score.avg_speed(), 1.0e-6f * stats.score.max_speed, host_aligner.n_extensions);
+    log_stats(stderr, "  finalizing   : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", stats.finalize.time, 1.0e-6f * stats.finalize.avg_speed(), 1.0e-6f * stats.finalize.max_speed);
+    log_stats(stderr, "  reads I/O    : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", stats.read_io.time, 1.0e-6f * stats.read_io.avg_speed(), 1.0e-6f * stats.read_io.max_speed);
+    log_stats(stderr, "    exposed    : %.2f sec (avg: %.3fK reads/s).\n", polling_time, 1.0e-3f * float(n_reads)/polling_time);
+    log_stats(stderr, "  output I/O   : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", stats.io.time, 1.0e-6f * stats.io.avg_speed(), 1.0e-6f * stats.io.max_speed);
+    if (params.dedup)
+        log_stats(stderr, "  duplicates   : %.2f %% hit rate (%llu in-batch, %llu cached)\n", 100.0f * dedup.hit_rate(), dedup.n_batch_hits, dedup.n_cache_hits);
+
+    const std::vector<uint32>& mapped = stats.mapped;
+    {
+        log_stats(stderr, "  mapped reads : %.2f %% - of these:\n", 100.0f * float(stats.n_mapped)/float(n_reads) );
+        log_stats(stderr, "    aligned uniquely      : %4.1f%% (%4.1f%% of total)\n", 100.0f * float(stats.n_unique)/float(stats.n_mapped), 100.0f * float(stats.n_mapped - stats.n_multiple)/float(n_reads) );
+        log_stats(stderr, "    aligned unambiguously : %4.1f%% (%4.1f%% of total)\n", 100.0f * float(stats.n_nonambiguous)/float(stats.n_mapped), 100.0f * float(stats.n_nonambiguous)/float(n_reads) );
+        log_stats(stderr, "    aligned ambiguously   : %4.1f%% (%4.1f%% of total)\n", 100.0f * float(stats.n_ambiguous)/float(stats.n_mapped), 100.0f * float(stats.n_ambiguous)/float(n_reads) );
+        log_stats(stderr, "    aligned multiply      : %4.1f%% (%4.1f%% of total)\n", 100.0f * float(stats.n_multiple)/float(stats.n_mapped), 100.0f * float(stats.n_multiple)/float(n_reads) );
+        for (uint32 i = 0; i < mapped.size(); ++i)
+        {
+            if (float(mapped[i])/float(n_reads) > 1.0e-3f)
+                log_stats(stderr, "    ed %4u : %.1f %%\n", i,
+                100.0f * float(mapped[i])/float(n_reads) );
+        }
+    }
+
+    log_visible(stderr, "Bowtie2 host driver... done\n");
+    return 0;
+}
+
 //
 // paired-end driver
 //
@@ -604,6 +892,9 @@ int driver(
     InputThreadPaired input_thread( &read_data_stream1, &read_data_stream2, stats, BATCH_SIZE );
     input_thread.create();
 
+    // setup the metrics exporter
+    MetricsExporter metrics( params );
+
     uint32 input_set  = 0;
     uint32 n_reads    = 0;
 
@@ -646,13 +937,6 @@ int driver(
         timer.stop();
         stats.read_HtoD.add( read_data1.size(), timer.seconds() );
 
-        // mark this set as ready to be reused
-        input_thread.read_data1[ input_set ] = NULL;
-        input_thread.read_data2[ input_set ] = NULL;
-
-        // advance input set pointer
-        input_set = (input_set + 1) % InputThread::BUFFERS;
-
         const uint32 count = read_data_host1->size();
         log_info(stderr, "aligning reads [%u, %u]\n", read_begin, read_begin + count - 1u);
         log_verbose(stderr, "  %u reads\n", read_data_host1->size());
@@ -716,14 +1000,32 @@ int driver(
 
         aligner.output_file->end_batch();
 
+        // the output is done with the host reads: mark this set as ready to be reused
+        input_thread.release( input_set );
+
+        // advance input set pointer
+        input_set = (input_set + 1) % InputThread::BUFFERS;
+
         // increase the total reads counter
         n_reads += count;
 
         log_verbose(stderr, "  %.1f K reads/s\n", 1.0e-3f * float(n_reads) / stats.global_time);
+
+        // update the live metrics
+        metrics.collect( stats, input_thread.m_stats_lock, aligner.output_file->get_aggregate_statistics(), n_reads, input_thread.occupancy(), InputThreadPaired::BUFFERS );
     }
 
     input_thread.join();
 
+    // write the final metrics
+    metrics.collect( stats, input_thread.m_stats_lock, aligner.output_file->get_aggregate_statistics(), n_reads, input_thread.occupancy(), InputThreadPaired::BUFFERS, true );
+    metrics.stop();
+
+    log_verbose(stderr, "  read batches: %.1f MB peak, %.1f MB reserved, %llu reallocations\n",
+        float(input_thread.read_data_pool1.peak_bytes() + input_thread.read_data_pool2.peak_bytes())/float(1024*1024),
+        float(input_thread.read_data_pool1.reserved_bytes() + input_thread.read_data_pool2.reserved_bytes())/float(1024*1024),
+        input_thread.read_data_pool1.n_grows() + input_thread.read_data_pool2.n_grows());
+
     io::IOStats iostats;
 
     aligner.output_file->close();
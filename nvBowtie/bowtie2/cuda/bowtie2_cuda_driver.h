@@ -33,6 +33,15 @@ int driver(const char*                              output_name,
                  io::SequenceDataStream&            read_data_stream,
            const std::map<std::string,std::string>& options);
 
+/// single-end driver running entirely on the host, without requiring a CUDA device
+///
+int host_driver(
+    const char*                              output_name,
+    const io::SequenceData&                  reference_data,
+    const io::FMIndexData&                   driver_data,
+          io::SequenceDataStream&            read_data_stream,
+    const std::map<std::string,std::string>& options);
+
 int driver(const char*                              output_name,
            const io::SequenceData&                  reference_data,
            const io::FMIndexData&                   driver_data,
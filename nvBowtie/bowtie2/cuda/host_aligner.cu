@@ -0,0 +1,716 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvBowtie/bowtie2/cuda/host_aligner.h>
+#include <nvBowtie/bowtie2/cuda/alignment_utils.h>
+#include <nvbio/alignment/alignment.h>
+#include <nvbio/fmindex/fmindex.h>
+#include <nvbio/io/sequence/sequence_access.h>
+#include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/vector_view.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/console.h>
+#include <algorithm>
+#include <string.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace nvbio {
+namespace bowtie2 {
+namespace cuda {
+
+namespace {
+
+// the SA range of an exactly matching seed
+//
+struct SeedRange
+{
+    uint2  range;       // inclusive SA range
+    uint32 offset;      // offset of the seed in the strand-oriented read
+    uint32 rc;          // read strand
+
+    uint32 size() const { return range.y - range.x + 1u; }
+};
+
+// order seed ranges by increasing size
+//
+struct seed_range_less
+{
+    bool operator() (const SeedRange& r1, const SeedRange& r2) const { return r1.size() < r2.size(); }
+};
+
+// a candidate seed extension
+//
+struct Candidate
+{
+    uint32 g_pos;       // the reference diagonal
+    uint32 rc;          // read strand
+    uint32 order;       // the order in which the candidate has been found
+};
+
+// order candidates by diagonal first, and discovery order second
+//
+struct candidate_pos_less
+{
+    bool operator() (const Candidate& c1, const Candidate& c2) const
+    {
+        return c1.rc    != c2.rc    ? c1.rc    < c2.rc    :
+               c1.g_pos != c2.g_pos ? c1.g_pos < c2.g_pos :
+                                      c1.order < c2.order;
+    }
+};
+
+// check whether two candidates lie on the same diagonal
+//
+struct candidate_pos_equal
+{
+    bool operator() (const Candidate& c1, const Candidate& c2) const { return c1.rc == c2.rc && c1.g_pos == c2.g_pos; }
+};
+
+// order candidates by discovery order
+//
+struct candidate_order_less
+{
+    bool operator() (const Candidate& c1, const Candidate& c2) const { return c1.order < c2.order; }
+};
+
+// the per-thread storage needed to align a read
+//
+template <uint32 BAND_LEN, typename aligner_type>
+struct Workspace
+{
+    typedef typename aln::column_storage_type<aligner_type>::type   cell_type;
+
+    static const uint32 BITS              = aln::direction_vector_traits<aligner_type>::BITS;
+    static const uint32 ELEMENTS_PER_WORD = 32 / BITS;
+    static const uint32 CHECKPOINTS       = BANDED_DP_CHECKPOINTS;
+    static const uint32 MAX_CIGAR_LEN     = 1024;
+
+    Workspace() :
+        checkpoints( BAND_LEN * ((MAXIMUM_READ_LENGTH + CHECKPOINTS-1) / CHECKPOINTS) ),
+        submatrix( (BAND_LEN * CHECKPOINTS + ELEMENTS_PER_WORD-1) / ELEMENTS_PER_WORD ),
+        cigar( MAX_CIGAR_LEN ),
+        n_extensions( 0u ) {}
+
+    std::vector<uint8>      read[2];        // the forward and reverse-complemented read
+    std::vector<uint8>      qual[2];        // the corresponding qualities
+    std::vector<uint8>      text;           // the current reference window
+    std::vector<SeedRange>  ranges;         // the seed ranges of the current seeding pass
+    std::vector<Candidate>  candidates;     // the candidate extensions of the current seeding pass
+    std::vector<cell_type>  checkpoints;    // the traceback checkpoints
+    std::vector<uint32>     submatrix;      // the traceback submatrix
+    std::vector<io::Cigar>  cigar;          // the traceback CIGAR
+    uint64                  n_extensions;   // the number of extensions performed by this thread
+};
+
+// load a reference window into a plain array
+//
+template <typename genome_string>
+void load_text(const genome_string genome, const uint32 begin, const uint32 end, std::vector<uint8>& text)
+{
+    text.resize( end - begin );
+    for (uint32 i = begin; i < end; ++i)
+        text[i - begin] = genome[i];
+}
+
+// collect the exactly matching seeds of a read on both strands
+//
+template <typename fmi_type>
+void collect_seeds(
+    const Params&                   params,
+    const fmi_type                  fmi,
+    const std::vector<uint8>*       read,
+    const uint32                    read_len,
+    const uint32                    seeding_pass,
+    std::vector<SeedRange>&         ranges,
+    uint32&                         range_sum,
+    uint32&                         range_count)
+{
+    const uint32 seed_len     = nvbio::min( params.seed_len, read_len );
+    const uint32 seed_freq    = nvbio::max( (uint32)params.seed_freq( read_len ), 1u );
+    const uint32 retry_stride = seed_freq/(params.max_reseed+1);
+
+    ranges.clear();
+    range_sum   = 0;
+    range_count = 0;
+
+    for (uint32 pos = seeding_pass * retry_stride; pos + seed_len <= read_len; pos += seed_freq)
+    {
+        for (uint32 rc = 0; rc < 2; ++rc)
+        {
+            // seeds are placed on the stored read, which is reversed with respect to the forward strand
+            const uint32 offset = rc ? pos : read_len - seed_len - pos;
+            const uint8* seed   = &read[rc][0] + offset;
+
+            // skip seeds containing Ns
+            bool has_N = false;
+            for (uint32 i = 0; i < seed_len; ++i)
+                has_N |= (seed[i] > 3u);
+            if (has_N)
+                continue;
+
+            const uint2 range = match( fmi, seed, seed_len );
+            if (range.x > range.y)
+                continue;
+
+            SeedRange seed_range;
+            seed_range.range  = range;
+            seed_range.offset = offset;
+            seed_range.rc     = rc;
+            ranges.push_back( seed_range );
+
+            range_sum += range.y - range.x + 1u;
+            range_count++;
+        }
+    }
+
+    // keep the max_hits least repetitive seeds
+    std::stable_sort( ranges.begin(), ranges.end(), seed_range_less() );
+    if (ranges.size() > params.max_hits)
+        ranges.resize( params.max_hits );
+}
+
+// compute the MD string and the final Smith-Waterman score of a traced-back alignment,
+// mirroring the GPU finish_alignment_kernel()
+//
+template <typename scheme_type>
+void finish_alignment(
+    const scheme_type&              scoring_scheme,
+    const uint8*                    pattern,
+    const uint8*                    quals,
+    const uint8*                    text,
+    const io::Cigar*                cigar,
+    const uint32                    cigar_len,
+    const uint32                    cigar_offset,
+    std::vector<uint8>*             mds,
+    uint32&                         ed,
+    int32&                          score)
+{
+    const uint32 SUB_MASK = 1u << io::Cigar::SUBSTITUTION;
+    const uint32 DEL_MASK = 1u << io::Cigar::DELETION;
+    const uint32 INS_MASK = 1u << io::Cigar::INSERTION;
+    const uint32 CLP_MASK = 1u << io::Cigar::SOFT_CLIPPING;
+
+    // leave a blank space in the MDS vector to store its length later on
+    uint32 mds_len = 2;
+    uint8  mds_op  = io::MDS_INVALID;
+
+    const uint32 mds_base = mds ? uint32( mds->size() ) : 0u;
+    if (mds)
+        mds->resize( mds_base + 2u );
+
+    ed    = 0;
+    score = 0;
+
+    for (uint32 i = 0, j = 0/*read_pos*/, k = cigar_offset; i < cigar_len; ++i)
+    {
+        const uint32 l = cigar[ cigar_len - i - 1u ].m_len;
+        const uint32 t = cigar[ cigar_len - i - 1u ].m_type;
+
+        const uint8 t_mask = 1u << t;
+
+        // handle deletions & insertions
+        if (t_mask & (INS_MASK | DEL_MASK | CLP_MASK))
+        {
+            mds_op = t_mask & DEL_MASK ? io::MDS_DELETION : io::MDS_INSERTION;
+            if (mds)
+            {
+                mds->push_back( mds_op );
+                mds->push_back( uint8( l ) );
+            }
+            mds_len += 2;
+        }
+
+        for (uint32 n = 0; n < l; ++n)
+        {
+            // advance j and k
+            j += (t_mask & (SUB_MASK | INS_MASK | CLP_MASK)) ? 1u : 0u;
+            k += (t_mask & (SUB_MASK | DEL_MASK))            ? 1u : 0u;
+
+            const uint8 readc = j > 0 ? pattern[j-1] : 255u;
+            const uint8 refc  = k > 0 ? text[k-1]    : 255u;
+
+            if (t_mask == SUB_MASK)
+            {
+                if (readc == refc)
+                {
+                    // prolong the sequence of previous matches, or start a new one
+                    if (mds_op == io::MDS_MATCH && mds && (*mds)[ mds->size()-1 ] < 255)
+                        (*mds)[ mds->size()-1 ]++;
+                    else
+                    {
+                        mds_op = io::MDS_MATCH;
+                        if (mds)
+                        {
+                            mds->push_back( mds_op );
+                            mds->push_back( 1u );
+                        }
+                        mds_len += 2;
+                    }
+                }
+                else
+                {
+                    // handle mismatches
+                    mds_op = io::MDS_MISMATCH;
+                    if (mds)
+                    {
+                        mds->push_back( mds_op );
+                        mds->push_back( readc );
+                    }
+                    mds_len += 2;
+                    ++ed;
+                }
+
+                // score the substitution
+                score += scoring_scheme.score( readc, 1u << refc, quals[j-1] );
+            }
+            else
+            {
+                // handle all the rare cases together: deletions/insertions
+                if (mds)
+                    mds->push_back( t_mask & DEL_MASK ? refc : readc );
+                mds_len++;
+
+                if (t_mask != CLP_MASK) // don't count soft-clipping in the edit-distance calculation
+                    ++ed;
+            }
+        }
+
+        if      (t_mask == INS_MASK) score -= scoring_scheme.cumulative_deletion( l );
+        else if (t_mask == DEL_MASK) score -= scoring_scheme.cumulative_insertion( l );
+    }
+
+    // store the MDS length in the first two bytes
+    if (mds)
+    {
+        (*mds)[ mds_base + 0 ] = uint8( mds_len & 0xFF );
+        (*mds)[ mds_base + 1 ] = uint8( mds_len >> 8 );
+    }
+}
+
+} // anonymous namespace
+
+// align a batch of single-end reads
+//
+void HostAligner::best_approx(
+    const Params&                   params,
+    const uint32                    band_len,
+    const fmi_type                  fmi,
+    const UberScoringScheme&        scoring_scheme,
+    const io::SequenceData&         reference_data,
+    const io::SequenceDataHost&     read_data,
+          io::CPUOutputBatch&       output,
+          Stats&                    stats)
+{
+    if (params.scoring_mode == EditDistanceMode)
+        best_approx_t<edit_distance_scoring_tag>( params, band_len, fmi, scoring_scheme, reference_data, read_data, output, stats );
+    else
+        best_approx_t<smith_waterman_scoring_tag>( params, band_len, fmi, scoring_scheme, reference_data, read_data, output, stats );
+}
+
+// dispatch the alignment of a batch of reads to the proper aligner and band length
+//
+template <typename scoring_tag>
+void HostAligner::best_approx_t(
+    const Params&                   params,
+    const uint32                    band_len,
+    const fmi_type                  fmi,
+    const UberScoringScheme&        input_scoring_scheme,
+    const io::SequenceData&         reference_data,
+    const io::SequenceDataHost&     read_data,
+          io::CPUOutputBatch&       output,
+          Stats&                    stats)
+{
+    typedef typename ScoringSchemeSelector<scoring_tag>::type           scoring_scheme_type;
+    typedef typename scoring_scheme_type::local_aligner_type            local_aligner_type;
+    typedef typename scoring_scheme_type::end_to_end_aligner_type       end_to_end_aligner_type;
+
+    const scoring_scheme_type scoring_scheme = ScoringSchemeSelector<scoring_tag>::scheme( input_scoring_scheme );
+
+    // always use Smith-Waterman for the final scoring of the found alignments
+    const SmithWatermanScoringScheme<>& sw = input_scoring_scheme.sw;
+
+    #define NVBIO_HOST_ALIGNER_DISPATCH( ALIGNER )                                                                             \
+        if      (band_len < 4)  best_approx_t<3u>(  params, fmi, scoring_scheme, ALIGNER, sw, reference_data, read_data, output, stats ); \
+        else if (band_len < 8)  best_approx_t<7u>(  params, fmi, scoring_scheme, ALIGNER, sw, reference_data, read_data, output, stats ); \
+        else if (band_len < 16) best_approx_t<15u>( params, fmi, scoring_scheme, ALIGNER, sw, reference_data, read_data, output, stats ); \
+        else                    best_approx_t<31u>( params, fmi, scoring_scheme, ALIGNER, sw, reference_data, read_data, output, stats );
+
+    if (params.alignment_type == LocalAlignment)
+    {
+        const local_aligner_type aligner = scoring_scheme.local_aligner();
+        NVBIO_HOST_ALIGNER_DISPATCH( aligner );
+    }
+    else
+    {
+        const end_to_end_aligner_type aligner = scoring_scheme.end_to_end_aligner();
+        NVBIO_HOST_ALIGNER_DISPATCH( aligner );
+    }
+
+    #undef NVBIO_HOST_ALIGNER_DISPATCH
+}
+
+// align a batch of reads with a given aligner and band length
+//
+template <uint32 BAND_LEN, typename scoring_scheme_type, typename aligner_type>
+void HostAligner::best_approx_t(
+    const Params&                   params,
+    const fmi_type                  fmi,
+    const scoring_scheme_type&      scoring_scheme,
+    const aligner_type              aligner,
+    const SmithWatermanScoringScheme<>& sw_scheme,
+    const io::SequenceData&         reference_data,
+    const io::SequenceDataHost&     read_data,
+          io::CPUOutputBatch&       output,
+          Stats&                    stats)
+{
+    typedef typename scoring_scheme_type::threshold_score_type          threshold_score_type;
+    typedef Workspace<BAND_LEN,aligner_type>                            workspace_type;
+    typedef typename workspace_type::cell_type                          cell_type;
+    typedef PackedStream<uint32*,uint8,workspace_type::BITS,false>      submatrix_type;
+    typedef vector_view<const uint8*>                                   string_type;
+
+    typedef io::SequenceDataAccess<DNA>                                 genome_access_type;
+    typedef genome_access_type::sequence_stream_type                    genome_string;
+    typedef io::SequenceDataAccess<DNA_N>                               read_access_type;
+    typedef read_access_type::sequence_stream_type                      read_string;
+
+    const genome_access_type genome_access( reference_data );
+    const uint32             genome_len = genome_access.bps();
+    const genome_string      genome     = genome_access.sequence_stream();
+
+    const read_access_type   reads( read_data );
+    const read_string        read_stream = reads.sequence_stream();
+    const char*              qual_stream = reads.qual_stream();
+
+    const threshold_score_type threshold_score = scoring_scheme.threshold_score( params );
+    const int32                score_limit     = scoring_scheme.score_limit( params );
+
+    const uint32 count = read_data.size();
+
+    // setup the output
+    output.count = count;
+    output.best_alignments.resize( count );
+    output.cigar[ io::MATE_1 ].coords.resize( count );
+
+    // setup the per-read references to the per-thread output buffers
+    m_owner.resize( count );
+    m_cigar_refs.resize( count );
+    m_mds_refs.resize( count );
+
+    uint32 n_threads = 1u;
+  #if defined(_OPENMP)
+    n_threads = omp_get_max_threads();
+  #endif
+    m_cigar_buffers.resize( n_threads );
+    m_mds_buffers.resize( n_threads );
+
+    uint64 n_ext = 0;
+
+    Timer timer;
+    timer.start();
+
+  #if defined(_OPENMP)
+    #pragma omp parallel
+  #endif
+    {
+        uint32 thread_id = 0u;
+      #if defined(_OPENMP)
+        thread_id = omp_get_thread_num();
+      #endif
+
+        workspace_type ws;
+
+        std::vector<io::Cigar>& cigar_buffer = m_cigar_buffers[ thread_id ];
+        std::vector<uint8>&     mds_buffer   = m_mds_buffers[ thread_id ];
+        cigar_buffer.clear();
+        mds_buffer.clear();
+
+      #if defined(_OPENMP)
+        #pragma omp for schedule(dynamic, 64)
+      #endif
+        for (int read_id = 0; read_id < int( count ); ++read_id)
+        {
+            const uint2  read_range = reads.get_range( read_id );
+            const uint32 read_len   = read_range.y - read_range.x;
+
+            // initialize the best alignments
+            const io::Alignment worst_alignment( uint32(-1), io::Alignment::max_ed(), threshold_score( read_len ), 0u );
+            io::BestAlignments best( worst_alignment, worst_alignment );
+
+            m_owner[ read_id ]      = thread_id;
+            m_cigar_refs[ read_id ] = make_uint2( 0u, 0u );
+            m_mds_refs[ read_id ]   = make_uint2( 0u, 0u );
+
+            io::AlignmentResult& result = output.best_alignments[ read_id ];
+            result = io::AlignmentResult();
+            output.cigar[ io::MATE_1 ].coords[ read_id ] = make_uint2( 0u, 0u );
+
+            // filter away short strings
+            if (read_len < params.min_read_len || read_len > MAXIMUM_READ_LENGTH)
+            {
+                result.best[ io::MATE_1 ]        = best.m_a1;
+                result.second_best[ io::MATE_1 ] = best.m_a2;
+                continue;
+            }
+
+            // unpack the read: the reads are stored reversed, so that the forward strand is
+            // read backwards, and the reverse-complemented one forward
+            for (uint32 rc = 0; rc < 2; ++rc)
+            {
+                ws.read[rc].resize( read_len );
+                ws.qual[rc].resize( read_len );
+            }
+            for (uint32 i = 0; i < read_len; ++i)
+            {
+                const uint8 f = read_stream[ read_range.x + read_len - i - 1u ];
+                const uint8 r = read_stream[ read_range.x + i ];
+                ws.read[0][i] = f;
+                ws.read[1][i] = r < 4 ? 3u - r : r;
+                ws.qual[0][i] = uint8( qual_stream[ read_range.x + read_len - i - 1u ] );
+                ws.qual[1][i] = uint8( qual_stream[ read_range.x + i ] );
+            }
+
+            //
+            // perform a number of seed & extension passes, re-seeding the reads whose seeds
+            // are too repetitive
+            //
+            for (uint32 seeding_pass = 0; seeding_pass < params.max_reseed+1; ++seeding_pass)
+            {
+                uint32 range_sum, range_count;
+                collect_seeds( params, fmi, ws.read, read_len, seeding_pass, ws.ranges, range_sum, range_count );
+
+                // locate the seed hits, visiting the least repetitive seeds first
+                ws.candidates.clear();
+                for (uint32 r = 0; r < ws.ranges.size() && ws.candidates.size() < params.max_ext; ++r)
+                {
+                    const SeedRange& seed = ws.ranges[r];
+                    for (uint32 row = seed.range.x; row <= seed.range.y && ws.candidates.size() < params.max_ext; ++row)
+                    {
+                        const uint32 loc = locate( fmi, row );
+                        if (loc < seed.offset)
+                            continue;
+
+                        Candidate candidate;
+                        candidate.g_pos = loc - seed.offset;
+                        candidate.rc    = seed.rc;
+                        candidate.order = uint32( ws.candidates.size() );
+                        ws.candidates.push_back( candidate );
+                    }
+                }
+
+                // remove duplicate diagonals, keeping the first occurrence of each
+                std::sort( ws.candidates.begin(), ws.candidates.end(), candidate_pos_less() );
+                ws.candidates.erase( std::unique( ws.candidates.begin(), ws.candidates.end(), candidate_pos_equal() ), ws.candidates.end() );
+                std::sort( ws.candidates.begin(), ws.candidates.end(), candidate_order_less() );
+
+                // extend the candidates
+                uint32 trys = params.max_effort_init;
+                for (uint32 i = 0; i < ws.candidates.size(); ++i)
+                {
+                    const uint32 g_pos   = ws.candidates[i].g_pos;
+                    const uint32 read_rc = ws.candidates[i].rc;
+
+                    // skip locations that we have already visited without paying the extension attempt
+                    if ((read_rc == best.m_a1.m_rc && g_pos == best.m_a1.m_align) ||
+                        (read_rc == best.m_a2.m_rc && g_pos == best.m_a2.m_align))
+                        continue;
+
+                    // setup the genome range
+                    const uint32 genome_begin = g_pos > BAND_LEN/2 ? g_pos - BAND_LEN/2 : 0u;
+                    const uint32 genome_end   = nvbio::min( genome_begin + BAND_LEN + read_len, genome_len );
+                    if (genome_begin >= genome_end)
+                        continue;
+
+                    load_text( genome, genome_begin, genome_end, ws.text );
+
+                    // score the DP matrix window
+                    const int32 min_score = nvbio::max( best.m_a2.score(), score_limit );
+
+                    aln::BestSink<int32> sink;
+                    aln::banded_alignment_score<BAND_LEN>(
+                        aligner,
+                        string_type( read_len, &ws.read[ read_rc ][0] ),
+                        &ws.qual[ read_rc ][0],
+                        string_type( genome_end - genome_begin, &ws.text[0] ),
+                        min_score,
+                        sink );
+
+                    ws.n_extensions++;
+
+                    const int32 score = nvbio::max( sink.score, scoring_scheme_type::worst_score );
+
+                    // reduce the score into the best alignments
+                    if (score > best.m_a1.score())
+                    {
+                        best.m_a2 = best.m_a1;
+                        best.m_a1 = io::Alignment( g_pos, 0u, score, read_rc );
+                        trys = params.max_effort;
+                    }
+                    else if ((score > best.m_a2.score()) && io::distinct_alignments( best.m_a1.m_align, best.m_a1.m_rc, g_pos, read_rc, read_len/2 ))
+                    {
+                        best.m_a2 = io::Alignment( g_pos, 0u, score, read_rc );
+                        trys = params.max_effort;
+                    }
+                    else if (trys > 0)
+                    {
+                        // bowtie2 does 1 more alignment than effort limit, we don't
+                        if ((i+1 >= params.min_ext && --trys == 0) ||
+                            (i+1 >= params.max_ext))
+                            break;
+                    }
+                }
+
+                // stop unless the seeds were too repetitive
+                if (range_count && range_sum < params.rep_seeds * range_count)
+                    break;
+            }
+
+            //
+            // backtrack the best two alignments, and compute their MD strings and final scores
+            //
+            for (uint32 aln_idx = 0; aln_idx < 2; ++aln_idx)
+            {
+                io::Alignment& alignment = aln_idx == 0 ? best.m_a1 : best.m_a2;
+                if (alignment.is_aligned() == false)
+                    continue;
+
+                const uint32 read_rc      = alignment.m_rc;
+                const uint32 genome_begin = alignment.alignment() > BAND_LEN/2 ? alignment.alignment() - BAND_LEN/2 : 0u;
+                const uint32 genome_end   = nvbio::min( genome_begin + BAND_LEN + read_len, genome_len );
+
+                load_text( genome, genome_begin, genome_end, ws.text );
+
+                detail::Backtracker<io::Cigar*> backtracer( &ws.cigar[0], workspace_type::MAX_CIGAR_LEN );
+
+                const aln::Alignment<int32> traceback = aln::banded_alignment_traceback<BAND_LEN, workspace_type::CHECKPOINTS>(
+                    aligner,
+                    string_type( read_len, &ws.read[ read_rc ][0] ),
+                    &ws.qual[ read_rc ][0],
+                    string_type( genome_end - genome_begin, &ws.text[0] ),
+                    alignment.score(),
+                    backtracer,
+                    &ws.checkpoints[0],
+                    submatrix_type( &ws.submatrix[0] ) );
+
+                if (backtracer.size == 0)
+                    continue;
+
+                const uint32 cigar_offset = traceback.source.x;
+
+                // only the CIGAR and MD string of the best alignment are kept
+                std::vector<uint8>* mds = aln_idx == 0 ? &mds_buffer : NULL;
+                if (aln_idx == 0)
+                {
+                    m_cigar_refs[ read_id ] = make_uint2( uint32( cigar_buffer.size() ), backtracer.size );
+                    m_mds_refs[ read_id ]   = make_uint2( uint32( mds_buffer.size() ), 0u );
+                    cigar_buffer.insert( cigar_buffer.end(), &ws.cigar[0], &ws.cigar[0] + backtracer.size );
+
+                    output.cigar[ io::MATE_1 ].coords[ read_id ] = make_uint2( traceback.source.x + (traceback.source.y << 16), backtracer.size );
+                }
+
+                uint32 ed;
+                int32  score;
+                finish_alignment(
+                    sw_scheme,
+                    &ws.read[ read_rc ][0],
+                    &ws.qual[ read_rc ][0],
+                    &ws.text[0],
+                    &ws.cigar[0],
+                    backtracer.size,
+                    cigar_offset,
+                    mds,
+                    ed,
+                    score );
+
+                if (aln_idx == 0)
+                    m_mds_refs[ read_id ].y = uint32( mds_buffer.size() ) - m_mds_refs[ read_id ].x;
+
+                // rewrite the alignment
+                alignment.m_align     = genome_begin;
+                alignment.m_ed        = ed;
+                alignment.m_score_sgn = score < 0 ? 1 : 0;
+                alignment.m_score     = score < 0 ? -score : score;
+            }
+
+            result.best[ io::MATE_1 ]        = best.m_a1;
+            result.second_best[ io::MATE_1 ] = best.m_a2;
+        }
+
+      #if defined(_OPENMP)
+        #pragma omp atomic
+      #endif
+        n_ext += ws.n_extensions;
+    }
+
+    timer.stop();
+    stats.score.add( uint32( n_ext ), timer.seconds(), 0.0f );
+
+    n_extensions += n_ext;
+
+    //
+    // gather the per-thread CIGARs and MD strings into the output vector arrays
+    //
+    timer.start();
+
+    std::vector<uint32> cigar_base( n_threads + 1u, 0u );
+    std::vector<uint32> mds_base( n_threads + 1u, 0u );
+    for (uint32 t = 0; t < n_threads; ++t)
+    {
+        cigar_base[t+1] = cigar_base[t] + uint32( m_cigar_buffers[t].size() );
+        mds_base[t+1]   = mds_base[t]   + uint32( m_mds_buffers[t].size() );
+    }
+
+    io::HostCigarArray& cigars = output.cigar[ io::MATE_1 ];
+    io::HostMdsArray&   mds    = output.mds[ io::MATE_1 ];
+    cigars.array.resize( count, nvbio::max( cigar_base[ n_threads ], 1u ) );
+    mds.resize( count, nvbio::max( mds_base[ n_threads ], 1u ) );
+
+  #if defined(_OPENMP)
+    #pragma omp parallel for
+  #endif
+    for (int read_id = 0; read_id < int( count ); ++read_id)
+    {
+        const uint32 owner     = m_owner[ read_id ];
+        const uint2  cigar_ref = m_cigar_refs[ read_id ];
+        const uint2  mds_ref   = m_mds_refs[ read_id ];
+
+        // bind every slot, empty ones included, so that no read ever refers to the
+        // storage of a previous batch handed back by OutputFile::take()
+        io::Cigar* cigar = cigars.array.bind( read_id, cigar_base[ owner ] + cigar_ref.x, cigar_ref.y );
+        if (cigar_ref.y)
+            memcpy( cigar, &m_cigar_buffers[ owner ][ cigar_ref.x ], sizeof(io::Cigar) * cigar_ref.y );
+
+        uint8* mds_vec = mds.bind( read_id, mds_base[ owner ] + mds_ref.x, mds_ref.y );
+        if (mds_ref.y)
+            memcpy( mds_vec, &m_mds_buffers[ owner ][ mds_ref.x ], mds_ref.y );
+    }
+
+    // and clear the second mate's outputs, which are never produced here
+    output.cigar[ io::MATE_2 ].array.resize( 0u, 0u );
+    output.cigar[ io::MATE_2 ].coords.clear();
+    output.mds[ io::MATE_2 ].resize( 0u, 0u );
+
+    timer.stop();
+    stats.finalize.add( count, timer.seconds(), 0.0f );
+}
+
+} // namespace cuda
+} // namespace bowtie2
+} // namespace nvbio
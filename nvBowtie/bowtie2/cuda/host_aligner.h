@@ -0,0 +1,123 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvBowtie/bowtie2/cuda/defs.h>
+#include <nvBowtie/bowtie2/cuda/params.h>
+#include <nvBowtie/bowtie2/cuda/stats.h>
+#include <nvBowtie/bowtie2/cuda/scoring.h>
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/fmindex/fmindex.h>
+#include <nvbio/io/output/output_batch.h>
+#include <vector>
+
+namespace nvbio {
+namespace bowtie2 {
+namespace cuda {
+
+///@addtogroup nvBowtie
+///@{
+
+///
+/// A host-side implementation of the single-end best-mapping pipeline, running entirely on the
+/// CPU through OpenMP, and requiring no CUDA device.
+///\par
+/// The aligner follows the same seed & extend strategy as the GPU Aligner, and is built on the
+/// same host/device FM-index and alignment primitives:
+///  - exact seeding of both strands, with re-seeding of the reads whose seeds are too repetitive;
+///  - banded DP extension of the seed hits, keeping the best two distinct alignments and bailing
+///    out after max-effort consecutive failed extensions;
+///  - banded traceback of the best two alignments, followed by the computation of their MD strings
+///    and of their final Smith-Waterman scores.
+///\par
+/// Unlike the GPU pipeline, which processes all reads in lock-step through a set of work queues,
+/// each read is processed start to finish by a single thread: hence, the set of seed hits being
+/// extended is not visited in exactly the same order, and results are expected to match the GPU
+/// ones for the vast majority of the reads rather than bit-for-bit.
+///
+struct HostAligner
+{
+    typedef io::FMIndexData::fm_index_type  fmi_type;
+
+    /// constructor
+    ///
+    HostAligner() : n_extensions( 0u ) {}
+
+    /// align a batch of single-end reads, returning the best two alignments of each read, together
+    /// with the CIGAR and MD string of the best one, in a CPUOutputBatch
+    ///
+    /// \param params           the alignment parameters
+    /// \param band_len         the DP band length
+    /// \param fmi              the host FM-index of the reference
+    /// \param scoring_scheme   the scoring schemes
+    /// \param reference_data   the reference sequence
+    /// \param read_data        the reads to align
+    /// \param output           the output results
+    /// \param stats            the statistics to update
+    ///
+    void best_approx(
+        const Params&                   params,
+        const uint32                    band_len,
+        const fmi_type                  fmi,
+        const UberScoringScheme&        scoring_scheme,
+        const io::SequenceData&         reference_data,
+        const io::SequenceDataHost&     read_data,
+              io::CPUOutputBatch&       output,
+              Stats&                    stats);
+
+    uint64 n_extensions;    ///< total number of DP extensions performed so far
+
+private:
+    template <typename scoring_tag>
+    void best_approx_t(
+        const Params&                   params,
+        const uint32                    band_len,
+        const fmi_type                  fmi,
+        const UberScoringScheme&        scoring_scheme,
+        const io::SequenceData&         reference_data,
+        const io::SequenceDataHost&     read_data,
+              io::CPUOutputBatch&       output,
+              Stats&                    stats);
+
+    template <uint32 BAND_LEN, typename scoring_scheme_type, typename aligner_type>
+    void best_approx_t(
+        const Params&                   params,
+        const fmi_type                  fmi,
+        const scoring_scheme_type&      scoring_scheme,
+        const aligner_type              aligner,
+        const SmithWatermanScoringScheme<>& sw_scheme,
+        const io::SequenceData&         reference_data,
+        const io::SequenceDataHost&     read_data,
+              io::CPUOutputBatch&       output,
+              Stats&                    stats);
+
+    // per-read references to the CIGARs and MD strings of the best alignments, stored in
+    // per-thread buffers
+    std::vector<uint32>                 m_owner;
+    std::vector<uint2>                  m_cigar_refs;
+    std::vector<uint2>                  m_mds_refs;
+    std::vector< std::vector<io::Cigar> > m_cigar_buffers;
+    std::vector< std::vector<uint8> >     m_mds_buffers;
+};
+
+///@}  // group nvBowtie
+
+} // namespace cuda
+} // namespace bowtie2
+} // namespace nvbio
@@ -0,0 +1,219 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/shared_pointer.h>
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/fmindex/fmindex.h>
+#include <nvBowtie/bowtie2/cuda/bowtie2_cuda_driver.h>
+
+
+namespace nvbio {
+namespace bowtie2 {
+namespace cuda {
+
+namespace { // anonymous namespace
+
+// the fields of a SAM record compared by the test
+//
+struct SAMRecord
+{
+    uint32      flag;
+    std::string rname;
+    uint32      pos;
+    std::string cigar;
+};
+
+// load the primary records of a SAM file, indexed by read name
+//
+bool load_sam(const char* file_name, std::map<std::string,SAMRecord>& records)
+{
+    FILE* file = fopen( file_name, "r" );
+    if (file == NULL)
+    {
+        log_error(stderr, "  unable to open \"%s\"\n", file_name);
+        return false;
+    }
+
+    char line[64*1024];
+    while (fgets( line, sizeof(line), file ))
+    {
+        if (line[0] == '@')
+            continue;
+
+        // split the first 6 tab-separated fields: QNAME, FLAG, RNAME, POS, MAPQ, CIGAR
+        char* fields[6];
+        char* p = line;
+        uint32 n_fields = 0;
+        for (; n_fields < 6 && p != NULL; ++n_fields)
+        {
+            fields[ n_fields ] = p;
+            p = strchr( p, '\t' );
+            if (p)
+                *p++ = '\0';
+        }
+        if (n_fields < 6)
+            continue;
+
+        SAMRecord record;
+        record.flag  = uint32( atoi( fields[1] ) );
+        record.rname = fields[2];
+        record.pos   = uint32( atoi( fields[3] ) );
+        record.cigar = fields[5];
+
+        // skip secondary alignments
+        if (record.flag & 0x100)
+            continue;
+
+        records[ fields[0] ] = record;
+    }
+    fclose( file );
+    return true;
+}
+
+// open a read file
+//
+SharedPointer<io::SequenceDataStream> open_reads(const char* reads_name)
+{
+    return SharedPointer<io::SequenceDataStream>(
+        io::open_sequence_file( reads_name, io::Phred33, uint32(-1), uint32(-1), io::REVERSE ) );
+}
+
+} // anonymous namespace
+
+// align a set of single-end reads against a small reference with both the GPU and the host
+// pipelines, checking that:
+//  - the host pipeline never reports a CIGAR for the reads it leaves unaligned;
+//  - the two pipelines agree on the mapping status, strand and position of the vast majority
+//    of the reads (see HostAligner for why they are not expected to agree bit-for-bit).
+//
+int test_host_aligner(const char* reference_name, const char* reads_name)
+{
+    log_visible(stderr, "host aligner test... started\n");
+
+    SharedPointer<io::SequenceData> reference_data = io::load_sequence_file( DNA, reference_name );
+    if (reference_data == NULL)
+    {
+        log_error(stderr, "  unable to load reference \"%s\"\n", reference_name);
+        return 1;
+    }
+
+    io::FMIndexDataHost driver_data;
+    if (!driver_data.load( reference_name ))
+        return 1;
+
+    const std::map<std::string,std::string> options;
+
+    const char* gpu_output_name = "nvbowtie-test.gpu.sam";
+    const char* cpu_output_name = "nvbowtie-test.cpu.sam";
+
+    {
+        SharedPointer<io::SequenceDataStream> read_data_file = open_reads( reads_name );
+        if (read_data_file == NULL || read_data_file->is_ok() == false)
+        {
+            log_error(stderr, "  unable to open read file \"%s\"\n", reads_name);
+            return 1;
+        }
+        driver( gpu_output_name, *reference_data, driver_data, *read_data_file, options );
+    }
+    {
+        SharedPointer<io::SequenceDataStream> read_data_file = open_reads( reads_name );
+        if (read_data_file == NULL || read_data_file->is_ok() == false)
+        {
+            log_error(stderr, "  unable to open read file \"%s\"\n", reads_name);
+            return 1;
+        }
+        host_driver( cpu_output_name, *reference_data, driver_data, *read_data_file, options );
+    }
+
+    std::map<std::string,SAMRecord> gpu_records;
+    std::map<std::string,SAMRecord> cpu_records;
+    const bool loaded =
+        load_sam( gpu_output_name, gpu_records ) &&
+        load_sam( cpu_output_name, cpu_records );
+
+    remove( gpu_output_name );
+    remove( cpu_output_name );
+
+    if (loaded == false)
+        return 1;
+
+    if (gpu_records.size() != cpu_records.size() || cpu_records.empty())
+    {
+        log_error(stderr, "  mismatching number of records: %u (gpu), %u (cpu)\n", uint32( gpu_records.size() ), uint32( cpu_records.size() ));
+        return 1;
+    }
+
+    uint32 n_agree    = 0u;
+    uint32 n_mapped   = 0u;
+    uint32 n_stale    = 0u;
+    for (std::map<std::string,SAMRecord>::const_iterator it = cpu_records.begin(); it != cpu_records.end(); ++it)
+    {
+        const SAMRecord& cpu = it->second;
+
+        const bool cpu_mapped = (cpu.flag & 0x4) == 0;
+        if (cpu_mapped == false && cpu.cigar != "*")
+        {
+            if (n_stale++ == 0)
+                log_error(stderr, "  unaligned read \"%s\" reported with CIGAR %s\n", it->first.c_str(), cpu.cigar.c_str());
+        }
+        n_mapped += cpu_mapped ? 1u : 0u;
+
+        std::map<std::string,SAMRecord>::const_iterator gpu_it = gpu_records.find( it->first );
+        if (gpu_it == gpu_records.end())
+            continue;
+
+        const SAMRecord& gpu = gpu_it->second;
+
+        const bool gpu_mapped = (gpu.flag & 0x4) == 0;
+        if (cpu_mapped != gpu_mapped)
+            continue;
+
+        if (cpu_mapped == false ||
+            ((cpu.flag & 0x10) == (gpu.flag & 0x10) && cpu.rname == gpu.rname && cpu.pos == gpu.pos))
+            ++n_agree;
+    }
+
+    const uint32 n_reads   = uint32( cpu_records.size() );
+    const float  agreement = float( n_agree ) / float( n_reads );
+
+    log_visible(stderr, "  %u reads, %u aligned on the host, %.2f%% matching the GPU\n", n_reads, n_mapped, 100.0f * agreement);
+
+    if (n_stale)
+    {
+        log_error(stderr, "  %u unaligned reads reported with a CIGAR\n", n_stale);
+        return 1;
+    }
+    if (agreement < 0.95f)
+    {
+        log_error(stderr, "  too many mismatching alignments\n");
+        return 1;
+    }
+
+    log_visible(stderr, "host aligner test... done\n");
+    return 0;
+}
+
+} // namespace cuda
+} // namespace bowtie2
+} // namespace nvbio
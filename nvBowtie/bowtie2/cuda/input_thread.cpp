@@ -41,19 +41,27 @@ void InputThread::run()
         //// lock the set to flush
         //ScopedLock lock( &m_lock[m_set] );
 
+        // make sure the set can hold the largest batch seen so far (a no-op if it was recycled)
+        read_data_pool.reserve( m_set );
+
         Timer timer;
         timer.start();
 
-        const int ret = io::next( DNA_N, &read_data_storage[ m_set ], m_read_data_stream, m_batch_size );
+        const int ret = io::next( DNA_N, &read_data_pool[ m_set ], m_read_data_stream, m_batch_size );
 
         timer.stop();
 
         if (ret)
         {
-            m_stats.read_io.add( read_data_storage[ m_set ].size(), timer.seconds() );
+            {
+                ScopedLock lock( &m_stats_lock );
+                m_stats.read_io.add( read_data_pool[ m_set ].size(), timer.seconds() );
+            }
+
+            read_data_pool.record( m_set );
 
             // mark the set as done
-            read_data[ m_set ] = &read_data_storage[ m_set ];
+            read_data[ m_set ] = &read_data_pool[ m_set ];
         }
         else
         {
@@ -67,6 +75,18 @@ void InputThread::run()
     }
 }
 
+// release a set once the consumer is done with it, recycling its storage
+//
+void InputThread::release(const uint32 set)
+{
+    // grow the set's storage from the consuming thread, so that any new pages are first
+    // touched (and hence placed) next to it
+    read_data_pool.reserve( set );
+
+    // hand the set back to the input thread
+    read_data[ set ] = NULL;
+}
+
 void InputThreadPaired::run()
 {
     log_verbose( stderr, "starting background paired-end input thread\n" );
@@ -79,21 +99,31 @@ void InputThreadPaired::run()
         //// lock the set to flush
         //ScopedLock lock( &m_lock[m_set] );
 
+        // make sure the set can hold the largest batch seen so far (a no-op if it was recycled)
+        read_data_pool1.reserve( m_set );
+        read_data_pool2.reserve( m_set );
+
         Timer timer;
         timer.start();
 
-        const int ret1 = io::next( DNA_N, &read_data_storage1[ m_set ], m_read_data_stream1, m_batch_size );
-        const int ret2 = io::next( DNA_N, &read_data_storage2[ m_set ], m_read_data_stream2, m_batch_size );
+        const int ret1 = io::next( DNA_N, &read_data_pool1[ m_set ], m_read_data_stream1, m_batch_size );
+        const int ret2 = io::next( DNA_N, &read_data_pool2[ m_set ], m_read_data_stream2, m_batch_size );
 
         timer.stop();
 
         if (ret1 && ret2)
         {
-            m_stats.read_io.add( read_data_storage1[ m_set ].size(), timer.seconds() );
+            {
+                ScopedLock lock( &m_stats_lock );
+                m_stats.read_io.add( read_data_pool1[ m_set ].size(), timer.seconds() );
+            }
+
+            read_data_pool1.record( m_set );
+            read_data_pool2.record( m_set );
 
             // mark the set as done
-            read_data1[ m_set ] = &read_data_storage1[ m_set ];
-            read_data2[ m_set ] = &read_data_storage2[ m_set ];
+            read_data1[ m_set ] = &read_data_pool1[ m_set ];
+            read_data2[ m_set ] = &read_data_pool2[ m_set ];
         }
         else
         {
@@ -108,6 +138,20 @@ void InputThreadPaired::run()
     }
 }
 
+// release a set once the consumer is done with it, recycling its storage
+//
+void InputThreadPaired::release(const uint32 set)
+{
+    // grow the set's storage from the consuming thread, so that any new pages are first
+    // touched (and hence placed) next to it
+    read_data_pool1.reserve( set );
+    read_data_pool2.reserve( set );
+
+    // hand the set back to the input thread
+    read_data1[ set ] = NULL;
+    read_data2[ set ] = NULL;
+}
+
 } // namespace cuda
 } // namespace bowtie2
 } // namespace nvbio
@@ -24,6 +24,7 @@
 #include <nvbio/basic/threads.h>
 #include <nvbio/basic/timer.h>
 #include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/sequence/sequence_pool.h>
 
 namespace nvbio {
 namespace bowtie2 {
@@ -41,7 +42,7 @@ struct InputThread : public Thread<InputThread>
     static const uint32 INVALID = 1u;
 
     InputThread(io::SequenceDataStream* read_data_stream, Stats& _stats, const uint32 batch_size) :
-        m_read_data_stream( read_data_stream ), m_stats( _stats ), m_batch_size( batch_size ), m_set(0)
+        m_read_data_stream( read_data_stream ), m_stats( _stats ), m_batch_size( batch_size ), m_set(0), read_data_pool( BUFFERS )
     {
         for (uint32 i = 0; i < BUFFERS; ++i)
             read_data[i] = NULL;
@@ -49,12 +50,27 @@ struct InputThread : public Thread<InputThread>
 
     void run();
 
+    // release a set once the consumer is done with it, recycling its storage
+    //
+    void release(const uint32 set);
+
+    // return the number of sets loaded and waiting to be consumed
+    //
+    uint32 occupancy() const
+    {
+        uint32 n = 0;
+        for (uint32 i = 0; i < BUFFERS; ++i)
+            n += (read_data[i] != NULL && read_data[i] != (io::SequenceDataHost*)INVALID) ? 1u : 0u;
+        return n;
+    }
+
     io::SequenceDataStream* m_read_data_stream;
     Stats&              m_stats;
     uint32              m_batch_size;
     volatile uint32     m_set;
+    Mutex               m_stats_lock;       // protects m_stats.read_io, updated by this thread
 
-    io::SequenceDataHost           read_data_storage[BUFFERS];
+    io::SequenceDataHostPool       read_data_pool;
     io::SequenceDataHost* volatile read_data[BUFFERS];
 };
 
@@ -70,7 +86,8 @@ struct InputThreadPaired : public Thread<InputThreadPaired>
     static const uint32 INVALID = 1u;
 
     InputThreadPaired(io::SequenceDataStream* read_data_stream1, io::SequenceDataStream* read_data_stream2, Stats& _stats, const uint32 batch_size) :
-        m_read_data_stream1( read_data_stream1 ), m_read_data_stream2( read_data_stream2 ), m_stats( _stats ), m_batch_size( batch_size ), m_set(0)
+        m_read_data_stream1( read_data_stream1 ), m_read_data_stream2( read_data_stream2 ), m_stats( _stats ), m_batch_size( batch_size ), m_set(0),
+        read_data_pool1( BUFFERS ), read_data_pool2( BUFFERS )
     {
         for (uint32 i = 0; i < BUFFERS; ++i)
             read_data1[i] = read_data2[i] = NULL;
@@ -78,14 +95,29 @@ struct InputThreadPaired : public Thread<InputThreadPaired>
 
     void run();
 
+    // release a set once the consumer is done with it, recycling its storage
+    //
+    void release(const uint32 set);
+
+    // return the number of sets loaded and waiting to be consumed
+    //
+    uint32 occupancy() const
+    {
+        uint32 n = 0;
+        for (uint32 i = 0; i < BUFFERS; ++i)
+            n += (read_data2[i] != NULL && read_data2[i] != (io::SequenceDataHost*)INVALID) ? 1u : 0u;
+        return n;
+    }
+
     io::SequenceDataStream* m_read_data_stream1;
     io::SequenceDataStream* m_read_data_stream2;
     Stats&                  m_stats;
     uint32                  m_batch_size;
     volatile uint32         m_set;
+    Mutex                   m_stats_lock;   // protects m_stats.read_io, updated by this thread
 
-    io::SequenceDataHost read_data_storage1[BUFFERS];
-    io::SequenceDataHost read_data_storage2[BUFFERS];
+    io::SequenceDataHostPool read_data_pool1;
+    io::SequenceDataHostPool read_data_pool2;
 
     io::SequenceDataHost* volatile read_data1[BUFFERS];
     io::SequenceDataHost* volatile read_data2[BUFFERS];
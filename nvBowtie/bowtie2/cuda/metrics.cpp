@@ -0,0 +1,499 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvBowtie/bowtie2/cuda/metrics.h>
+#include <nvbio/basic/atomics.h>
+#include <nvbio/basic/console.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+namespace nvbio {
+namespace bowtie2 {
+namespace cuda {
+
+namespace { // anonymous
+
+// the percentiles reported for each series
+const float  PERCENTILES[4]      = { 0.5f, 0.9f, 0.99f, 0.999f };
+const char*  PERCENTILE_NAMES[4] = { "p50", "p90", "p99", "p999" };
+
+// the polling period of the background thread, in milliseconds
+const int POLL_PERIOD = 100;
+
+// append a formatted string
+//
+void append(std::string& out, const char* format, ...)
+{
+    char buffer[1024];
+
+    va_list args;
+    va_start( args, format );
+    vsnprintf( buffer, sizeof(buffer), format, args );
+    va_end( args );
+
+    out.append( buffer );
+}
+
+// copy a name into a fixed-size buffer
+//
+void copy_name(char* dst, const char* src)
+{
+    strncpy( dst, src ? src : "", MetricsExporter::MAX_NAME-1 );
+    dst[ MetricsExporter::MAX_NAME-1 ] = '\0';
+}
+
+// write a file atomically, going through a temporary and renaming it over the destination
+//
+bool write_file(const std::string& file_name, const std::string& content)
+{
+    const std::string tmp_name = file_name + ".tmp";
+
+    FILE* file = fopen( tmp_name.c_str(), "w" );
+    if (file == NULL)
+        return false;
+
+    const bool ok = fwrite( content.c_str(), 1u, content.length(), file ) == content.length();
+    fclose( file );
+
+  #ifdef WIN32
+    remove( file_name.c_str() );
+  #endif
+    return ok && rename( tmp_name.c_str(), file_name.c_str() ) == 0;
+}
+
+} // anonymous namespace
+
+// constructor: starts the background thread if any destination has been specified
+//
+MetricsExporter::MetricsExporter(const Params& params) :
+    m_json_file( params.metrics_json ),
+    m_prom_file( params.metrics_prom ),
+    m_socket_file( params.metrics_socket ),
+    m_interval( nvbio::max( params.metrics_interval, 1u ) ),
+    m_socket( -1 ),
+    m_batches( 0u ),
+    m_seq( 0u ),
+    m_last_seq( 0u ),
+    m_stop( 0u )
+{
+    memset( &m_local,  0, sizeof(Snapshot) );
+    memset( &m_shared, 0, sizeof(Snapshot) );
+
+    m_timer.start();
+
+  #ifdef WIN32
+    if (m_socket_file.length())
+    {
+        log_warning(stderr, "metrics sockets are not supported on this platform\n");
+        m_socket_file = "";
+    }
+  #else
+    if (m_socket_file.length())
+    {
+        struct sockaddr_un addr;
+        memset( &addr, 0, sizeof(addr) );
+        addr.sun_family = AF_UNIX;
+
+        if (m_socket_file.length() >= sizeof(addr.sun_path))
+            log_warning(stderr, "metrics socket path too long: \"%s\"\n", m_socket_file.c_str());
+        else
+        {
+            strcpy( addr.sun_path, m_socket_file.c_str() );
+
+            // remove any stale socket left by a previous run
+            unlink( m_socket_file.c_str() );
+
+            m_socket = socket( AF_UNIX, SOCK_STREAM, 0 );
+            if (m_socket < 0 ||
+                bind( m_socket, (struct sockaddr*)&addr, sizeof(addr) ) != 0 ||
+                listen( m_socket, 4 ) != 0)
+            {
+                log_warning(stderr, "unable to open metrics socket \"%s\"\n", m_socket_file.c_str());
+                if (m_socket >= 0)
+                    close( m_socket );
+                m_socket = -1;
+            }
+        }
+        if (m_socket < 0)
+            m_socket_file = "";
+    }
+  #endif
+
+    m_enabled = m_json_file.length() || m_prom_file.length() || m_socket_file.length();
+
+    if (m_enabled)
+        create();
+}
+
+// destructor
+//
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+// take a snapshot of the totals of a timing series, leaving the latency percentiles
+// to the background thread
+//
+void MetricsExporter::add_series(const TimeSeries& series, const char* name)
+{
+    if (series.num == 0 || m_local.n_series == MAX_SERIES)
+        return;
+
+    Series& s = m_local.series[ m_local.n_series++ ];
+
+    copy_name( s.name,  name );
+    copy_name( s.units, series.units.c_str() );
+    s.calls       = series.num;
+    s.items       = series.calls;
+    s.time        = series.time;
+    s.device_time = series.device_time;
+    s.max_speed   = series.max_speed;
+
+    s.histogram   = &series.latency;
+    s.has_latency = series.latency.count() > 0u;
+}
+
+// notify the end of a batch, taking and publishing a snapshot every metrics-interval
+// batches, or immediately if forced
+//
+void MetricsExporter::collect(
+    const Stats&        stats,
+          Mutex&        read_io_lock,
+    const io::IOStats&  iostats,
+    const uint64        n_reads,
+    const uint32        queue_occupancy,
+    const uint32        queue_capacity,
+    const bool          force)
+{
+    if (m_enabled == false)
+        return;
+
+    if (force == false && (++m_batches % m_interval) != 0)
+        return;
+
+    m_timer.stop();
+
+    m_local.timestamp = uint64( time(NULL) );
+    m_local.uptime    = m_timer.seconds();
+    m_local.batches   = m_batches;
+    m_local.n_reads   = n_reads;
+    m_local.n_mapped  = iostats.mate1.n_mapped;
+    m_local.n_series  = 0;
+    m_local.n_queues  = 0;
+
+    // the read I/O totals are updated by the input thread, and must be copied under its lock
+    {
+        ScopedLock lock( &read_io_lock );
+        add_series( stats.read_io,        stats.read_io.name.c_str() );
+    }
+    add_series( stats.read_HtoD,          stats.read_HtoD.name.c_str() );
+    add_series( stats.map,                stats.map.name.c_str() );
+    add_series( stats.select,             stats.select.name.c_str() );
+    add_series( stats.sort,               stats.sort.name.c_str() );
+    add_series( stats.locate,             stats.locate.name.c_str() );
+    add_series( stats.score,              stats.score.name.c_str() );
+    add_series( stats.opposite_score,     stats.opposite_score.name.c_str() );
+    add_series( stats.backtrack,          stats.backtrack.name.c_str() );
+    add_series( stats.backtrack_opposite, stats.backtrack_opposite.name.c_str() );
+    add_series( stats.finalize,           stats.finalize.name.c_str() );
+    add_series( iostats.output_process_timings, "output" );
+
+    Queue& input_queue = m_local.queues[ m_local.n_queues++ ];
+    copy_name( input_queue.name, "input" );
+    input_queue.occupancy = queue_occupancy;
+    input_queue.capacity  = queue_capacity;
+
+    publish();
+}
+
+// publish the local snapshot to the background thread
+//
+void MetricsExporter::publish()
+{
+    // the atomic operations act as full memory barriers around the copy
+    host_atomic_add( &m_seq, 1u );      // odd: a snapshot is being written
+    m_shared = m_local;
+    host_atomic_add( &m_seq, 1u );      // even: the snapshot is complete
+}
+
+// fetch a new snapshot, if one has been published since the last call
+//
+bool MetricsExporter::fetch(Snapshot& snapshot)
+{
+    const uint32 seq1 = host_atomic_add( &m_seq, 0u );
+    if ((seq1 & 1u) || seq1 == m_last_seq)
+        return false;
+
+    Snapshot copy = m_shared;
+
+    // discard the copy if the main thread has started publishing a newer snapshot meanwhile,
+    // leaving the caller's last good snapshot untouched
+    const uint32 seq2 = host_atomic_add( &m_seq, 0u );
+    if (seq1 != seq2)
+        return false;
+
+    // compute the latency percentiles from the live histograms
+    for (uint32 i = 0; i < copy.n_series; ++i)
+    {
+        Series& s = copy.series[i];
+        for (uint32 p = 0; p < 4; ++p)
+            s.latency[p] = s.has_latency ? float( s.histogram->percentile( PERCENTILES[p] ) ) * 1.0e-9f : 0.0f;
+    }
+
+    snapshot   = copy;
+    m_last_seq = seq1;
+    return true;
+}
+
+// write a snapshot to the destination files
+//
+void MetricsExporter::write(const Snapshot& snapshot)
+{
+    if (m_json_file.length() && write_file( m_json_file, metrics_json( snapshot ) ) == false)
+        log_warning(stderr, "unable to write metrics file \"%s\"\n", m_json_file.c_str());
+
+    if (m_prom_file.length() && write_file( m_prom_file, metrics_prometheus( snapshot ) ) == false)
+        log_warning(stderr, "unable to write metrics file \"%s\"\n", m_prom_file.c_str());
+}
+
+// wait for a connection on the metrics socket for up to a polling period, and reply
+// with the given snapshot; without a socket, just sleep for the polling period
+//
+void MetricsExporter::serve(const Snapshot& snapshot)
+{
+  #ifdef WIN32
+    Sleep( POLL_PERIOD );
+  #else
+    if (m_socket < 0)
+    {
+        poll( NULL, 0, POLL_PERIOD );
+        return;
+    }
+
+    struct pollfd listener;
+    listener.fd      = m_socket;
+    listener.events  = POLLIN;
+    listener.revents = 0;
+
+    if (poll( &listener, 1, POLL_PERIOD ) <= 0 || (listener.revents & POLLIN) == 0)
+        return;
+
+    const int client = accept( m_socket, NULL, NULL );
+    if (client < 0)
+        return;
+
+    // consume the request, if any, without waiting on clients which don't send one
+    struct pollfd request;
+    request.fd      = client;
+    request.events  = POLLIN;
+    request.revents = 0;
+    if (poll( &request, 1, POLL_PERIOD ) > 0)
+    {
+        char buffer[4096];
+        recv( client, buffer, sizeof(buffer), 0 );
+    }
+
+    std::string response =
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+    response.append( metrics_prometheus( snapshot ) );
+
+    for (size_t sent = 0; sent < response.length();)
+    {
+        const ssize_t n = send( client, response.c_str() + sent, response.length() - sent, MSG_NOSIGNAL );
+        if (n <= 0)
+            break;
+        sent += size_t( n );
+    }
+    close( client );
+  #endif
+}
+
+// run the background thread
+//
+void MetricsExporter::run()
+{
+    Snapshot snapshot;
+    memset( &snapshot, 0, sizeof(Snapshot) );
+
+    while (1u)
+    {
+        // read the stop flag before fetching, so that the last snapshot published is always written
+        const bool stopping = host_atomic_add( &m_stop, 0u ) != 0u;
+
+        if (fetch( snapshot ))
+            write( snapshot );
+
+        if (stopping)
+            break;
+
+        serve( snapshot );
+    }
+}
+
+// write the last published snapshot and stop the background thread
+//
+void MetricsExporter::stop()
+{
+    if (m_enabled == false)
+        return;
+
+    host_atomic_add( &m_stop, 1u );
+    join();
+
+  #ifndef WIN32
+    if (m_socket >= 0)
+    {
+        close( m_socket );
+        unlink( m_socket_file.c_str() );
+        m_socket = -1;
+    }
+  #endif
+    m_enabled = false;
+}
+
+// format a snapshot as a JSON document
+//
+std::string metrics_json(const MetricsExporter::Snapshot& snapshot)
+{
+    std::string out;
+
+    append( out, "{\n" );
+    append( out, "  \"timestamp\": %llu,\n",  snapshot.timestamp );
+    append( out, "  \"uptime\": %.3f,\n",     snapshot.uptime );
+    append( out, "  \"batches\": %llu,\n",    snapshot.batches );
+    append( out, "  \"reads\": %llu,\n",      snapshot.n_reads );
+    append( out, "  \"mapped\": %llu,\n",     snapshot.n_mapped );
+    append( out, "  \"reads_per_second\": %.1f,\n", snapshot.uptime > 0.0f ? double(snapshot.n_reads) / snapshot.uptime : 0.0 );
+
+    append( out, "  \"stages\": [\n" );
+    for (uint32 i = 0; i < snapshot.n_series; ++i)
+    {
+        const MetricsExporter::Series& s = snapshot.series[i];
+
+        append( out, "    { \"name\": \"%s\", \"units\": \"%s\", \"calls\": %llu, \"items\": %llu, \"time\": %.6f, \"device_time\": %.6f, \"avg_speed\": %.1f, \"max_speed\": %.1f, \"latency\": ",
+            s.name, s.units, s.calls, s.items, s.time, s.device_time,
+            s.time > 0.0f ? double(s.items) / s.time : 0.0,
+            s.max_speed );
+        if (s.has_latency)
+        {
+            append( out, "{ " );
+            for (uint32 p = 0; p < 4; ++p)
+                append( out, "\"%s\": %.6f%s", PERCENTILE_NAMES[p], s.latency[p], p < 3 ? ", " : "" );
+            append( out, " }" );
+        }
+        else
+            append( out, "null" );
+        append( out, " }%s\n", i+1 < snapshot.n_series ? "," : "" );
+    }
+    append( out, "  ],\n" );
+
+    append( out, "  \"queues\": [\n" );
+    for (uint32 i = 0; i < snapshot.n_queues; ++i)
+    {
+        const MetricsExporter::Queue& q = snapshot.queues[i];
+
+        append( out, "    { \"name\": \"%s\", \"occupancy\": %u, \"capacity\": %u }%s\n",
+            q.name, q.occupancy, q.capacity, i+1 < snapshot.n_queues ? "," : "" );
+    }
+    append( out, "  ]\n" );
+    append( out, "}\n" );
+    return out;
+}
+
+// format a snapshot in the Prometheus text exposition format
+//
+std::string metrics_prometheus(const MetricsExporter::Snapshot& snapshot)
+{
+    std::string out;
+
+    append( out, "# HELP nvbowtie_uptime_seconds Time since the alignment started.\n" );
+    append( out, "# TYPE nvbowtie_uptime_seconds gauge\n" );
+    append( out, "nvbowtie_uptime_seconds %.3f\n", snapshot.uptime );
+
+    append( out, "# HELP nvbowtie_batches_total Number of read batches processed.\n" );
+    append( out, "# TYPE nvbowtie_batches_total counter\n" );
+    append( out, "nvbowtie_batches_total %llu\n", snapshot.batches );
+
+    append( out, "# HELP nvbowtie_reads_total Number of reads processed.\n" );
+    append( out, "# TYPE nvbowtie_reads_total counter\n" );
+    append( out, "nvbowtie_reads_total %llu\n", snapshot.n_reads );
+
+    append( out, "# HELP nvbowtie_mapped_reads_total Number of reads mapped.\n" );
+    append( out, "# TYPE nvbowtie_mapped_reads_total counter\n" );
+    append( out, "nvbowtie_mapped_reads_total %llu\n", snapshot.n_mapped );
+
+    append( out, "# HELP nvbowtie_stage_items_total Number of items processed by each pipeline stage.\n" );
+    append( out, "# TYPE nvbowtie_stage_items_total counter\n" );
+    for (uint32 i = 0; i < snapshot.n_series; ++i)
+        append( out, "nvbowtie_stage_items_total{stage=\"%s\",units=\"%s\"} %llu\n", snapshot.series[i].name, snapshot.series[i].units, snapshot.series[i].items );
+
+    append( out, "# HELP nvbowtie_stage_device_seconds_total Device time spent in each pipeline stage.\n" );
+    append( out, "# TYPE nvbowtie_stage_device_seconds_total counter\n" );
+    for (uint32 i = 0; i < snapshot.n_series; ++i)
+        append( out, "nvbowtie_stage_device_seconds_total{stage=\"%s\"} %.6f\n", snapshot.series[i].name, snapshot.series[i].device_time );
+
+    append( out, "# HELP nvbowtie_stage_max_speed Maximum speed of each pipeline stage, in items per second.\n" );
+    append( out, "# TYPE nvbowtie_stage_max_speed gauge\n" );
+    for (uint32 i = 0; i < snapshot.n_series; ++i)
+        append( out, "nvbowtie_stage_max_speed{stage=\"%s\"} %.1f\n", snapshot.series[i].name, snapshot.series[i].max_speed );
+
+    append( out, "# HELP nvbowtie_stage_latency_seconds Latency of each call to a pipeline stage.\n" );
+    append( out, "# TYPE nvbowtie_stage_latency_seconds summary\n" );
+    for (uint32 i = 0; i < snapshot.n_series; ++i)
+    {
+        const MetricsExporter::Series& s = snapshot.series[i];
+        for (uint32 p = 0; p < 4 && s.has_latency; ++p)
+            append( out, "nvbowtie_stage_latency_seconds{stage=\"%s\",quantile=\"%g\"} %.6f\n", s.name, PERCENTILES[p], s.latency[p] );
+        append( out, "nvbowtie_stage_latency_seconds_sum{stage=\"%s\"} %.6f\n", s.name, s.time );
+        append( out, "nvbowtie_stage_latency_seconds_count{stage=\"%s\"} %llu\n", s.name, s.calls );
+    }
+
+    append( out, "# HELP nvbowtie_queue_occupancy Number of entries waiting in each queue.\n" );
+    append( out, "# TYPE nvbowtie_queue_occupancy gauge\n" );
+    for (uint32 i = 0; i < snapshot.n_queues; ++i)
+        append( out, "nvbowtie_queue_occupancy{queue=\"%s\"} %u\n", snapshot.queues[i].name, snapshot.queues[i].occupancy );
+
+    append( out, "# HELP nvbowtie_queue_capacity Maximum number of entries in each queue.\n" );
+    append( out, "# TYPE nvbowtie_queue_capacity gauge\n" );
+    for (uint32 i = 0; i < snapshot.n_queues; ++i)
+        append( out, "nvbowtie_queue_capacity{queue=\"%s\"} %u\n", snapshot.queues[i].name, snapshot.queues[i].capacity );
+
+    return out;
+}
+
+} // namespace cuda
+} // namespace bowtie2
+} // namespace nvbio
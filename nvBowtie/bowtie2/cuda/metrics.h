@@ -0,0 +1,180 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvBowtie/bowtie2/cuda/defs.h>
+#include <nvBowtie/bowtie2/cuda/params.h>
+#include <nvBowtie/bowtie2/cuda/stats.h>
+#include <nvbio/io/output/output_stats.h>
+#include <nvbio/basic/threads.h>
+#include <nvbio/basic/timer.h>
+#include <string>
+
+namespace nvbio {
+namespace bowtie2 {
+namespace cuda {
+
+///@addtogroup nvBowtie
+///@{
+
+///
+/// A periodic, machine-readable export of the live alignment statistics, meant to let
+/// schedulers and monitoring systems follow long runs.
+///\par
+/// Every metrics-interval batches, the main thread takes a small fixed-size snapshot of the
+/// per-stage timing series, the read counters and the input queue occupancy, and publishes
+/// it to a background thread through a sequence lock built on atomic counters: the main
+/// thread never blocks, and all formatting and I/O happen off the alignment loop.
+/// The latency percentiles are computed by the background thread as well, directly from
+/// the live per-stage histograms, which are only ever updated through atomic operations.
+/// The background thread then writes the snapshot as:
+///  - a JSON document (metrics-json);
+///  - a Prometheus text exposition file (metrics-prom), e.g. for the node exporter's
+///    textfile collector;
+///  - a Prometheus text exposition served over HTTP on a local UNIX socket (metrics-socket,
+///    not available on Windows).
+///\par
+/// Files are written to a temporary and renamed over the destination, so that readers
+/// never observe a partial update.
+///
+struct MetricsExporter : public Thread<MetricsExporter>
+{
+    static const uint32 MAX_SERIES = 32;
+    static const uint32 MAX_QUEUES = 4;
+    static const uint32 MAX_NAME   = 32;
+
+    /// the snapshot of a single timing series
+    ///
+    struct Series
+    {
+        char    name[MAX_NAME];
+        char    units[MAX_NAME];
+        uint64  calls;              ///< number of samples, i.e. kernel or function calls
+        uint64  items;              ///< number of items processed
+        float   time;               ///< total time
+        float   device_time;        ///< total device time
+        float   max_speed;          ///< maximum speed, in items/s
+        bool    has_latency;        ///< whether latency percentiles are available
+        float   latency[4];         ///< latency percentiles (p50, p90, p99, p999), filled by the background thread
+
+        const LogLinearHistogram* histogram;    ///< the live latency histogram the percentiles are computed from
+    };
+
+    /// the snapshot of a queue
+    ///
+    struct Queue
+    {
+        char    name[MAX_NAME];
+        uint32  occupancy;
+        uint32  capacity;
+    };
+
+    /// a full snapshot
+    ///
+    struct Snapshot
+    {
+        uint64  timestamp;          ///< UNIX time of the snapshot
+        float   uptime;             ///< seconds since the exporter was created
+        uint64  batches;            ///< number of batches processed
+        uint64  n_reads;            ///< number of reads processed
+        uint64  n_mapped;           ///< number of reads mapped
+        uint32  n_series;
+        uint32  n_queues;
+        Series  series[MAX_SERIES];
+        Queue   queues[MAX_QUEUES];
+    };
+
+    /// constructor: starts the background thread if any destination has been specified
+    ///
+    MetricsExporter(const Params& params);
+
+    /// destructor
+    ///
+    ~MetricsExporter();
+
+    /// return true if any destination has been specified
+    ///
+    bool enabled() const { return m_enabled; }
+
+    /// notify the end of a batch, taking and publishing a snapshot every metrics-interval
+    /// batches, or immediately if forced
+    ///
+    /// \param stats            the global statistics
+    /// \param read_io_lock     the lock protecting the read I/O statistics, which are
+    ///                         concurrently updated by the input thread
+    /// \param iostats          the output statistics
+    /// \param n_reads          the number of reads processed so far
+    /// \param queue_occupancy  the number of input batches loaded and waiting to be processed
+    /// \param queue_capacity   the maximum number of input batches in flight
+    /// \param force            take a snapshot regardless of the interval
+    ///
+    void collect(
+        const Stats&        stats,
+              Mutex&        read_io_lock,
+        const io::IOStats&  iostats,
+        const uint64        n_reads,
+        const uint32        queue_occupancy,
+        const uint32        queue_capacity,
+        const bool          force = false);
+
+    /// write the last published snapshot and stop the background thread
+    ///
+    void stop();
+
+    /// run the background thread
+    ///
+    void run();
+
+private:
+    void add_series(const TimeSeries& series, const char* name);
+    void publish();
+    bool fetch(Snapshot& snapshot);
+    void write(const Snapshot& snapshot);
+    void serve(const Snapshot& snapshot);
+
+    bool                m_enabled;
+    std::string         m_json_file;
+    std::string         m_prom_file;
+    std::string         m_socket_file;
+    uint32              m_interval;
+    int                 m_socket;
+
+    Timer               m_timer;
+    uint64              m_batches;
+    Snapshot            m_local;        // the snapshot being built by the main thread
+
+    uint32              m_seq;          // the sequence lock counter, odd while a snapshot is being published
+    uint32              m_last_seq;     // the sequence number of the last snapshot fetched by the background thread
+    uint32              m_stop;         // the stop flag
+    Snapshot            m_shared;       // the published snapshot
+};
+
+/// format a snapshot as a JSON document
+///
+std::string metrics_json(const MetricsExporter::Snapshot& snapshot);
+
+/// format a snapshot in the Prometheus text exposition format
+///
+std::string metrics_prometheus(const MetricsExporter::Snapshot& snapshot);
+
+///@}  // group nvBowtie
+
+} // namespace cuda
+} // namespace bowtie2
+} // namespace nvbio
@@ -0,0 +1,214 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <nvbio/basic/console.h>
+#include <nvBowtie/bowtie2/cuda/metrics.h>
+
+
+namespace nvbio {
+namespace bowtie2 {
+namespace cuda {
+
+namespace { // anonymous namespace
+
+// add a timing series to a snapshot
+//
+void add_series(
+    MetricsExporter::Snapshot&  snapshot,
+    const char*                 name,
+    const uint64                calls,
+    const uint64                items,
+    const float                 time,
+    const float*                latency)
+{
+    MetricsExporter::Series& s = snapshot.series[ snapshot.n_series++ ];
+    strcpy( s.name,  name );
+    strcpy( s.units, "reads" );
+    s.calls       = calls;
+    s.items       = items;
+    s.time        = time;
+    s.device_time = time * 0.5f;
+    s.max_speed   = 1000.0f;
+    s.has_latency = latency != NULL;
+    s.histogram   = NULL;
+    for (uint32 p = 0; p < 4; ++p)
+        s.latency[p] = latency ? latency[p] : 0.0f;
+}
+
+// check that a formatted document contains a given string
+//
+bool contains(const char* format, const std::string& doc, const char* str)
+{
+    if (doc.find( str ) != std::string::npos)
+        return true;
+
+    log_error(stderr, "  %s output lacks \"%s\"\n", format, str);
+    return false;
+}
+
+// check that a formatted document does not contain a given string
+//
+bool lacks(const char* format, const std::string& doc, const char* str)
+{
+    if (doc.find( str ) == std::string::npos)
+        return true;
+
+    log_error(stderr, "  %s output unexpectedly contains \"%s\"\n", format, str);
+    return false;
+}
+
+} // anonymous namespace
+
+// format a hand-built snapshot as JSON and in the Prometheus text format, checking:
+//  - the JSON keys, the per-stage latency objects and the null latency of stages without one;
+//  - the structure of the JSON document (balanced, no trailing commas);
+//  - the Prometheus summary lines: one per quantile, plus _sum and _count for every stage.
+//
+int test_metrics_format()
+{
+    log_visible(stderr, "metrics format test... started\n");
+
+    MetricsExporter::Snapshot snapshot;
+    memset( &snapshot, 0, sizeof(snapshot) );
+
+    snapshot.timestamp = 1700000000u;
+    snapshot.uptime    = 10.0f;
+    snapshot.batches   = 3u;
+    snapshot.n_reads   = 1000u;
+    snapshot.n_mapped  = 900u;
+
+    const float latency[4] = { 0.001f, 0.002f, 0.003f, 0.004f };
+    add_series( snapshot, "map",    5u, 1000u, 2.5f,  latency );
+    add_series( snapshot, "select", 7u, 1000u, 1.25f, NULL );
+
+    MetricsExporter::Queue& queue = snapshot.queues[ snapshot.n_queues++ ];
+    strcpy( queue.name, "input" );
+    queue.occupancy = 2u;
+    queue.capacity  = 4u;
+
+    // check the JSON document
+    {
+        const std::string json = metrics_json( snapshot );
+
+        const char* keys[] = {
+            "\"timestamp\": 1700000000,",
+            "\"uptime\": 10.000,",
+            "\"batches\": 3,",
+            "\"reads\": 1000,",
+            "\"mapped\": 900,",
+            "\"reads_per_second\": 100.0,",
+            "\"stages\": [",
+            "{ \"name\": \"map\", \"units\": \"reads\", \"calls\": 5, \"items\": 1000, \"time\": 2.500000,",
+            "\"latency\": { \"p50\": 0.001000, \"p90\": 0.002000, \"p99\": 0.003000, \"p999\": 0.004000 } },",
+            "{ \"name\": \"select\", \"units\": \"reads\", \"calls\": 7,",
+            "\"latency\": null }\n",
+            "\"queues\": [",
+            "{ \"name\": \"input\", \"occupancy\": 2, \"capacity\": 4 }\n" };
+
+        for (uint32 i = 0; i < sizeof(keys)/sizeof(keys[0]); ++i)
+        {
+            if (contains( "JSON", json, keys[i] ) == false)
+                return 1;
+        }
+
+        // the last entry of each list must not be followed by a comma
+        if (lacks( "JSON", json, ",\n  ]" ) == false ||
+            lacks( "JSON", json, ",\n}" )   == false)
+            return 1;
+
+        int32 braces   = 0;
+        int32 brackets = 0;
+        for (uint32 i = 0; i < json.length(); ++i)
+        {
+            braces   += json[i] == '{' ? 1 : json[i] == '}' ? -1 : 0;
+            brackets += json[i] == '[' ? 1 : json[i] == ']' ? -1 : 0;
+            if (braces < 0 || brackets < 0)
+                break;
+        }
+        if (braces != 0 || brackets != 0)
+        {
+            log_error(stderr, "  unbalanced JSON document:\n%s", json.c_str());
+            return 1;
+        }
+    }
+
+    // check the Prometheus exposition
+    {
+        const std::string prom = metrics_prometheus( snapshot );
+
+        const char* lines[] = {
+            "nvbowtie_reads_total 1000\n",
+            "nvbowtie_mapped_reads_total 900\n",
+            "# TYPE nvbowtie_stage_latency_seconds summary\n",
+            "nvbowtie_stage_latency_seconds{stage=\"map\",quantile=\"0.5\"} 0.001000\n",
+            "nvbowtie_stage_latency_seconds{stage=\"map\",quantile=\"0.9\"} 0.002000\n",
+            "nvbowtie_stage_latency_seconds{stage=\"map\",quantile=\"0.99\"} 0.003000\n",
+            "nvbowtie_stage_latency_seconds{stage=\"map\",quantile=\"0.999\"} 0.004000\n",
+            "nvbowtie_stage_latency_seconds_sum{stage=\"map\"} 2.500000\n",
+            "nvbowtie_stage_latency_seconds_count{stage=\"map\"} 5\n",
+            "nvbowtie_stage_latency_seconds_sum{stage=\"select\"} 1.250000\n",
+            "nvbowtie_stage_latency_seconds_count{stage=\"select\"} 7\n",
+            "nvbowtie_queue_occupancy{queue=\"input\"} 2\n",
+            "nvbowtie_queue_capacity{queue=\"input\"} 4\n" };
+
+        for (uint32 i = 0; i < sizeof(lines)/sizeof(lines[0]); ++i)
+        {
+            if (contains( "Prometheus", prom, lines[i] ) == false)
+                return 1;
+        }
+
+        // stages without latency percentiles must not report any quantile
+        if (lacks( "Prometheus", prom, "{stage=\"select\",quantile=" ) == false)
+            return 1;
+
+        // each sample line must be made of a metric name, optional labels, and a value
+        for (size_t begin = 0, end; begin < prom.length(); begin = end + 1)
+        {
+            end = prom.find( '\n', begin );
+            if (end == std::string::npos)
+            {
+                log_error(stderr, "  unterminated Prometheus line\n");
+                return 1;
+            }
+
+            const std::string line = prom.substr( begin, end - begin );
+            if (line[0] == '#')
+                continue;
+
+            const size_t space = line.rfind( ' ' );
+            if (line.compare( 0, 9, "nvbowtie_" ) != 0 ||
+                space == std::string::npos ||
+                strtod( line.c_str() + space + 1, NULL ) < 0.0)
+            {
+                log_error(stderr, "  malformed Prometheus line \"%s\"\n", line.c_str());
+                return 1;
+            }
+        }
+    }
+
+    log_visible(stderr, "metrics format test... done\n");
+    return 0;
+}
+
+} // namespace cuda
+} // namespace bowtie2
+} // namespace nvbio
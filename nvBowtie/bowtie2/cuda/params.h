@@ -164,6 +164,15 @@ struct Params : public ParamsPOD
     std::string   report;
     std::string   scoring_file;
 
+    bool          dedup;
+    uint32        dedup_cache;
+    bool          dedup_quals;
+
+    std::string   metrics_json;
+    std::string   metrics_prom;
+    std::string   metrics_socket;
+    uint32        metrics_interval;
+
     int32         persist_batch;
     int32         persist_seeding;
     int32         persist_extension;
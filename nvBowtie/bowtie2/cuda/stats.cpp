@@ -56,6 +56,10 @@ Stats::Stats(const Params& params_) :
     hits_top_max      = 0u;
     hits_stats        = 0u;
 
+    n_dedup_reads      = 0u;
+    n_dedup_batch_hits = 0u;
+    n_dedup_cache_hits = 0u;
+
     for (uint32 i = 0; i < 28; ++i)
         hits_bins[i] = hits_top_bins[i] = 0;
 
@@ -212,6 +216,7 @@ void generate_report(Stats& stats, const char* report)
                     add_param( html_output, "mapQ-filter", stats.params.mapq_filter,               true );
                     add_param( html_output, "scoring",     stats.params.scoring_file.c_str(),      false );
                     add_param( html_output, "report",      stats.params.report.c_str(),            true );
+                    add_param( html_output, "dedup",       stats.params.dedup ? "yes" : "no",      false );
                 }
                 //
                 // speed stats
@@ -329,6 +334,27 @@ void generate_report(Stats& stats, const char* report)
                     }
                 }
                 //
+                // duplicate-read cache stats
+                //
+                if (stats.n_dedup_reads)
+                {
+                    html::table_object table( html_output, "dedup-stats", "stats", "duplicate-read stats" );
+                    {
+                        html::tr_object tr( html_output, NULL );
+                        html::th_object( html_output, html::FORMATTED, NULL, "" );
+                        html::th_object( html_output, html::FORMATTED, NULL, "batch hits" );
+                        html::th_object( html_output, html::FORMATTED, NULL, "cache hits" );
+                        html::th_object( html_output, html::FORMATTED, NULL, "hit rate" );
+                    }
+                    {
+                        html::tr_object tr( html_output, "class", "alt", NULL );
+                        html::th_object( html_output, html::FORMATTED, NULL, "reads" );
+                        html::td_object( html_output, html::FORMATTED, NULL, "%.1f %%", 100.0f * float(stats.n_dedup_batch_hits)/float(stats.n_dedup_reads) );
+                        html::td_object( html_output, html::FORMATTED, NULL, "%.1f %%", 100.0f * float(stats.n_dedup_cache_hits)/float(stats.n_dedup_reads) );
+                        html::td_object( html_output, html::FORMATTED, NULL, "%.1f %%", 100.0f * float(stats.n_dedup_batch_hits + stats.n_dedup_cache_hits)/float(stats.n_dedup_reads) );
+                    }
+                }
+                //
                 // mapping quality stats
                 //
                 {
@@ -620,8 +646,6 @@ void generate_kernel_table(const char* report, const KernelStats& stats)
     const char* units           = stats.units.c_str();
     const std::string file_name = generate_file_name( report, name );
 
-    const std::deque< std::pair<uint32,float> >& table = stats.info;
-
     FILE* html_output = fopen( file_name.c_str(), "w" );
     if (html_output == NULL)
     {
@@ -747,61 +771,41 @@ void generate_kernel_table(const char* report, const KernelStats& stats)
                     }
                 }
                 //
-                // kernel table stats
+                // kernel latency stats
                 //
                 {
+                    const float  percentiles[]     = { 0.5f, 0.9f, 0.99f, 0.999f, 1.0f };
+                    const char*  percentile_names[] = { "p50", "p90", "p99", "p99.9", "max" };
+                    const uint32 n_percentiles      = 5;
+
+                    float latency[5];
+                    for (uint32 i = 0; i < n_percentiles; ++i)
+                        latency[i] = stats.latency_percentile( percentiles[i] );
+
+                    const float max_latency = latency[ n_percentiles-1 ];
+
                     char buffer1[1024];
                     char buffer2[1024];
-                    sprintf( buffer1, "%s-stats", name );
-                    sprintf( buffer2, "%s stats", name );
+                    sprintf( buffer1, "%s-latency-stats", name );
+                    sprintf( buffer2, "%s latency stats", name );
                     html::table_object tab( html_output, buffer1, "stats", buffer2 );
                     {
                         html::tr_object tr( html_output, NULL );
-                        html::th_object( html_output, html::FORMATTED, NULL, "launch" );
-                        html::th_object( html_output, html::FORMATTED, NULL, "batch size (%s)", units );
+                        html::th_object( html_output, html::FORMATTED, NULL, "percentile" );
                         html::th_object( html_output, html::FORMATTED, NULL, "time" );
-                        html::th_object( html_output, html::FORMATTED, NULL, "speed" );
-                    }
-                    uint32 best_bin[2]     = {0};
-                    float  best_bin_val[2] = {0};
-                    for (uint32 i = 0; i < table.size(); ++i)
-                    {
-                        if (best_bin_val[0] < table[i].second)
-                        {
-                            best_bin_val[1] = best_bin_val[0];
-                            best_bin[1]     = best_bin[0];
-                            best_bin_val[0] = table[i].second;
-                            best_bin[0]     = i;
-                        }
-                        else if (best_bin_val[1] < table[i].second)
-                        {
-                            best_bin_val[1] = table[i].second;
-                            best_bin[1]     = i;
-                        }
                     }
-
-                    float max_time  = 0.0f;
-                    float max_speed = 0.0f;
-                    for (uint32 i = 0; i < table.size(); ++i)
                     {
-                        const float speed = float(table[i].first) / table[i].second;
-                        max_time = nvbio::max( float(table[i].second), max_time );
-                        max_speed = nvbio::max( speed, max_speed );
+                        html::tr_object tr( html_output, "class", "alt", NULL );
+                        html::th_object( html_output, html::FORMATTED, NULL, "mean" );
+                        html::td_object( html_output, html::FORMATTED, NULL, "%.3f ms", stats.num ? 1000.0f * stats.time / float(stats.num) : 0.0f );
                     }
 
                     char span_string[1024];
-                    char units_string[1024];
-                    for (uint32 i = 0; i < table.size(); ++i)
+                    for (uint32 i = 0; i < n_percentiles; ++i)
                     {
-                        const float speed = float(table[i].first) / table[i].second;
-                        html::tr_object tr( html_output, "class", i % 2 ? "none" : "alt", NULL );
-                        html::th_object( html_output, html::FORMATTED, NULL, "%u", i );
-                        const char* cls = i == best_bin[0] ? "yellow" : i == best_bin[1] ? "orange" : "none";
-                        html::td_object( html_output, html::FORMATTED, NULL, "%.1f %c", float(table[i].first) * (table[i].first > 1000000 ?  1.0e-6f : 1.0e-3f), table[i].first > 1000000 ? 'M' : 'K' );
-                        stats_string( span_string, 50, "ms", 1000.0f * float(table[i].second), float(table[i].second) / max_time, 50.0f );
-                        html::td_object( html_output, html::FORMATTED, "class", cls, NULL, span_string );
-                        sprintf(units_string, "%c %s/s", speed > 1000000 ? 'M' : 'K', units );
-                        stats_string( span_string, 100, units_string, speed * (speed >= 1.0e6f ? 1.0e-6f : 1.0e-3f), speed / max_speed, 50.0f );
+                        html::tr_object tr( html_output, "class", i % 2 ? "alt" : "none", NULL );
+                        html::th_object( html_output, html::FORMATTED, NULL, percentile_names[i] );
+                        stats_string( span_string, 60, "ms", 1000.0f * latency[i], max_latency ? latency[i] / max_latency : 0.0f, 50.0f );
                         html::td_object( html_output, html::FORMATTED, NULL, span_string );
                     }
                 }
@@ -22,7 +22,6 @@
 #include <nvBowtie/bowtie2/cuda/params.h>
 #include <nvbio/basic/timer.h>
 #include <vector>
-#include <deque>
 
 namespace nvbio {
 namespace bowtie2 {
@@ -70,6 +69,11 @@ struct Stats
     // mapping quality stats
     uint64 mapq_bins[64];
 
+    // duplicate-read cache stats
+    uint64 n_dedup_reads;
+    uint64 n_dedup_batch_hits;
+    uint64 n_dedup_cache_hits;
+
     // extensive (seeding) stats
     volatile bool stats_ready;
     uint64 hits_total;
@@ -39,6 +39,8 @@ namespace cuda {
 
     void test_seed_hit_deques();
     void test_scoring_queues();
+    int  test_host_aligner(const char* reference_name, const char* reads_name);
+    int  test_metrics_format();
 
 } // namespace cuda
 } // namespace bowtie2
@@ -63,8 +65,6 @@ bool is_number(const char* str)
 
 int main(int argc, char* argv[])
 {
-    cudaSetDeviceFlags( cudaDeviceMapHost | cudaDeviceLmemResizeToMax );
-
     crcInit();
 
     if (argc == 1 ||
@@ -72,10 +72,12 @@ int main(int argc, char* argv[])
         (argc == 2 && strcmp( argv[1], "-h" ) == 0))
     {
         log_info(stderr,"nvBowtie [options] reference-genome read-file output\n");
+        log_info(stderr,"nvBowtie -test [reference-genome read-file]\n");
         log_info(stderr,"options:\n");
         log_info(stderr,"  General:\n");
         log_info(stderr,"    --max-reads        int [-1]      maximum number of reads to process\n");
         log_info(stderr,"    --device           int [0]       select the given cuda device\n");
+        log_info(stderr,"    --cpu                            align on the host, without using any cuda device (single-end only)\n");
         log_info(stderr,"    --file-ref                       load reference from file\n");
         log_info(stderr,"    --server-ref                     load reference from server\n");
         log_info(stderr,"    --phred33                        qualities are ASCII characters equal to Phred quality + 33\n");
@@ -106,13 +108,37 @@ int main(int argc, char* argv[])
         log_info(stderr,"    --no-mixed                       only report paired alignments\n");
         log_info(stderr,"  Reporting:\n");
         log_info(stderr,"    --mapQ-filter      int [0]       minimum mapQ threshold\n");
+        log_info(stderr,"  Duplicates:\n");
+        log_info(stderr,"    --dedup            int [0]       align exact-duplicate reads only once (single-end best-mapping only)\n");
+        log_info(stderr,"    --dedup-cache      int [262144]  maximum number of sequences cached across batches\n");
+        log_info(stderr,"    --dedup-quals      int [1]       require qualities to match as well as bases\n");
+        log_info(stderr,"  Metrics:\n");
+        log_info(stderr,"    --metrics-json     file          periodically write live metrics to a JSON file\n");
+        log_info(stderr,"    --metrics-prom     file          periodically write live metrics to a Prometheus text file\n");
+        log_info(stderr,"    --metrics-socket   file          serve live Prometheus metrics over HTTP on a UNIX socket\n");
+        log_info(stderr,"    --metrics-interval int [16]      number of batches between metrics updates\n");
         exit(0);
     }
-    else if (argc == 2 && strcmp( argv[1], "-test" ) == 0)
+    else if ((argc == 2 || argc == 4) && strcmp( argv[1], "-test" ) == 0)
     {
+        cudaSetDeviceFlags( cudaDeviceMapHost | cudaDeviceLmemResizeToMax );
+
         log_visible(stderr, "nvBowtie tests... started\n");
         nvbio::bowtie2::cuda::test_seed_hit_deques();
         nvbio::bowtie2::cuda::test_scoring_queues();
+
+        if (nvbio::bowtie2::cuda::test_metrics_format() != 0)
+        {
+            log_error(stderr, "nvBowtie tests... failed\n");
+            exit(1);
+        }
+
+        // compare the host and the GPU pipelines on a user supplied reference and read set
+        if (argc == 4 && nvbio::bowtie2::cuda::test_host_aligner( argv[2], argv[3] ) != 0)
+        {
+            log_error(stderr, "nvBowtie tests... failed\n");
+            exit(1);
+        }
         log_visible(stderr, "nvBowtie tests... done\n");
         exit(0);
     }
@@ -121,6 +147,7 @@ int main(int argc, char* argv[])
     uint32 max_read_len = uint32(-1);
     //bool   debug        = false;
     int    cuda_device  = -1;
+    bool   host_only    = false;
     bool   from_file    = false;
     bool   paired_end   = false;
     io::PairedEndPolicy pe_policy = io::PE_POLICY_FR;
@@ -181,6 +208,9 @@ int main(int argc, char* argv[])
         else if (strcmp( argv[i], "-device" ) == 0 ||
                  strcmp( argv[i], "--device" ) == 0)
             cuda_device = atoi( argv[++i] );
+        else if (strcmp( argv[i], "-cpu" ) == 0 ||
+                 strcmp( argv[i], "--cpu" ) == 0)
+            host_only = true;
         else if (strcmp( argv[i], "-verbosity" ) == 0 ||
                  strcmp( argv[i], "--verbosity" ) == 0)
             set_verbosity( Verbosity( atoi( argv[++i] ) ) );
@@ -221,8 +251,20 @@ int main(int argc, char* argv[])
     }
     log_debug(stderr, "\n");
 
-    int device_count;
-    cudaGetDeviceCount(&device_count);
+    if (host_only && paired_end)
+    {
+        log_error(stderr, "paired-end alignment is not supported on the host\n");
+        return 1;
+    }
+
+    // touch the cuda runtime only if we are going to use a device, as it might not be
+    // installed at all on the nodes used for host-only alignment
+    int device_count = 0;
+    if (host_only == false)
+    {
+        cudaSetDeviceFlags( cudaDeviceMapHost | cudaDeviceLmemResizeToMax );
+        cudaGetDeviceCount(&device_count);
+    }
     log_verbose(stderr, "  cuda devices : %d\n", device_count);
 
     // inspect and select cuda devices
@@ -362,7 +404,10 @@ int main(int argc, char* argv[])
                 return 1;
             }
 
-            nvbio::bowtie2::cuda::driver( argv[argc-1], *reference_data, *driver_data, *read_data_file, string_options );
+            if (host_only)
+                nvbio::bowtie2::cuda::host_driver( argv[argc-1], *reference_data, *driver_data, *read_data_file, string_options );
+            else
+                nvbio::bowtie2::cuda::driver( argv[argc-1], *reference_data, *driver_data, *read_data_file, string_options );
         }
 
         log_info( stderr, "nvBowtie... done\n" );
@@ -31,20 +31,21 @@ int main(int argc, char* argv[])
 {
     if (argc == 1)
     {
-        fprintf(stderr, "nvFM-server genome-prefix mapped-name\n");
+        fprintf(stderr, "nvFM-server genome-prefix mapped-name [occ-intv]\n");
         exit(1);
     }
 
     fprintf(stderr, "nvFM-server started\n");
 
     const char* file_name = argv[1];
-    const char* mapped_name = argc == 3 ? argv[2] : argv[1];
+    const char* mapped_name = argc >= 3 ? argv[2] : argv[1];
+    const uint32 occ_intv   = argc >= 4 ? uint32( atoi( argv[3] ) ) : io::FMIndexData::OCC_INT;
 
     io::SequenceDataMMAPServer reference_driver;
     reference_driver.load( DNA, file_name, mapped_name );
 
     io::FMIndexDataMMAPServer fmindex_driver;
-    fmindex_driver.load( file_name, mapped_name );
+    fmindex_driver.load( file_name, mapped_name, occ_intv );
 
     getc(stdin);
     return 0;
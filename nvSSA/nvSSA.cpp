@@ -38,17 +38,36 @@ int main(int argc, char* argv[])
 
     if (argc == 1)
     {
-        log_info(stderr,"nvSSA [-gpu] input-prefix [output-prefix]\n");
+        log_info(stderr,"nvSSA [-gpu] [-kmer-lut k] input-prefix [output-prefix]\n");
+        log_info(stderr,"  -gpu          build the SSA on the GPU\n");
+        log_info(stderr,"  -kmer-lut k   also build the k-mer lookup tables (.kmer/.rkmer), with k <= 15\n");
         exit(0);
     }
 
-    int base_arg = 0;
+    bool   gpu    = false;
+    uint32 kmer_k = 0u;
+
+    int base_arg = 1;
+    for (; base_arg < argc && argv[base_arg][0] == '-'; ++base_arg)
+    {
+        if (strcmp( argv[base_arg], "-gpu" ) == 0)
+            gpu = true;
+        else if (strcmp( argv[base_arg], "-kmer-lut" ) == 0 && base_arg+1 < argc)
+            kmer_k = atoi( argv[++base_arg] );
+        else
+        {
+            log_error(stderr, "unknown option \"%s\"\n", argv[base_arg]);
+            exit(1);
+        }
+    }
+    if (base_arg >= argc)
+    {
+        log_error(stderr, "missing input prefix\n");
+        exit(1);
+    }
+
     const char* input;
     const char* output;
-    if (strcmp( argv[1], "-gpu" ) == 0)
-        base_arg = 2;
-    else
-        base_arg = 1;
 
     input = argv[base_arg];
     if (argc == base_arg+2)
@@ -65,7 +84,7 @@ int main(int argc, char* argv[])
 
     nvbio::io::FMIndexData::ssa_storage_type ssa, rssa;
 
-    if (strcmp( argv[1], "-gpu" ) == 0)
+    if (gpu)
     {
         nvbio::io::FMIndexDataDevice driver_data_cuda(
             driver_data,
@@ -108,6 +127,17 @@ int main(int argc, char* argv[])
         fclose( file );
     }
     log_info(stderr, "saving SSA... done\n");
+
+    //
+    // Build and save the k-mer lookup tables
+    //
+    if (kmer_k)
+    {
+        log_info(stderr, "saving k-mer tables... started\n");
+        if (nvbio::io::save_kmer_luts( driver_data, kmer_k, output ) == false)
+            return 1;
+        log_info(stderr, "saving k-mer tables... done\n");
+    }
     return 0;
 }
 
@@ -36,6 +36,10 @@
 #include <nvbio/io/sequence/sequence.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#ifndef WIN32
+#include <sys/stat.h>
+#endif
 #include <vector>
 #include <algorithm>
 
@@ -65,6 +69,26 @@ struct Reads
     thrust::host_vector<uint64> h_read_index;       // read index
 };
 
+// return whether two file names refer to the same file, either literally or, if both exist,
+// through different paths to the same inode
+//
+bool same_file(const char* name1, const char* name2)
+{
+    if (*name1 == '\0' || *name2 == '\0')
+        return false;
+
+    if (strcmp( name1, name2 ) == 0)
+        return true;
+
+  #ifndef WIN32
+    struct stat info1, info2;
+    if (stat( name1, &info1 ) == 0 &&
+        stat( name2, &info2 ) == 0)
+        return info1.st_dev == info2.st_dev && info1.st_ino == info2.st_ino;
+  #endif
+    return false;
+}
+
 bool read(const char* reads_name, const io::QualityEncoding qencoding, const io::SequenceEncoding flags, Reads* reads)
 {
     typedef Reads::word_type word_type;
@@ -214,6 +238,8 @@ int main(int argc, char* argv[])
         log_info(stderr, "   -c       | --compression   string    [1R]   (e.g. \"1\", ..., \"9\", \"1R\")\n");
         log_info(stderr, "   -t       | --threads       int       [auto]\n");
         log_info(stderr, "   -b       | --bucketing     int       [16]   (# of bits used for bucketing)\n");
+        log_info(stderr, "   -cpu     | --cpu-only                       (build the BWT without using the GPU)\n");
+        log_info(stderr, "   -m       | --merge         string           (merge with an existing .bwt|.bwt4 file)\n");
         log_info(stderr, "   -F       | --skip-forward\n");
         log_info(stderr, "   -R       | --skip-reverse\n");
         log_info(stderr, "  output formats:\n");
@@ -226,6 +252,9 @@ int main(int argc, char* argv[])
         log_info(stderr, "    .bwt4     4-bit packed binary\n");
         log_info(stderr, "    .bwt4.gz  4-bit packed binary, gzip compressed\n");
         log_info(stderr, "    .bwt4.bgz 4-bit packed binary, block-gzip compressed\n");
+        log_info(stderr, "    .rle      run-length encoded binary\n");
+        log_info(stderr, "    .rle.gz   run-length encoded binary, gzip compressed\n");
+        log_info(stderr, "    .rle.bgz  run-length encoded binary, block-gzip compressed\n");
         return 0;
     }
 
@@ -240,6 +269,8 @@ int main(int argc, char* argv[])
     const char* comp_level        = "1R";
     io::QualityEncoding qencoding = io::Phred33;
     int   threads                 = 0;
+    bool  cpu_only                = false;
+    const char* merge_name        = NULL;
 
     BWTParams params;
 
@@ -293,12 +324,40 @@ int main(int argc, char* argv[])
         {
             params.bucketing_bits = atoi( argv[++i] );
         }
+        else if ((strcmp( argv[i], "-cpu" )           == 0) ||
+                 (strcmp( argv[i], "--cpu-only" )     == 0))  // don't use the GPU
+        {
+            cpu_only = true;
+        }
+        else if ((strcmp( argv[i], "-m" )             == 0) ||
+                 (strcmp( argv[i], "--merge" )        == 0))  // merge with an existing BWT
+        {
+            merge_name = argv[++i];
+        }
     }
 
     try
     {
         log_visible(stderr,"nvSetBWT... started\n");
 
+        // load the BWT to merge with, before opening (and truncating) any output file
+        HostSetBWT merge_bwt_in;
+        HostSetBWT merge_bwt_new;
+        if (merge_name)
+        {
+            if (same_file( merge_name, output_name ) ||
+                same_file( primary_index_name( merge_name ).c_str(), primary_index_name( output_name ).c_str() ))
+            {
+                log_error(stderr, "  the merged BWT and its index must be written to different files\n");
+                return 1;
+            }
+
+            log_info(stderr,"  loading bwt \"%s\"... started\n", merge_name);
+            if (load_bwt_file( merge_name, &merge_bwt_in ) == false)
+                return 1;
+            log_info(stderr,"  loading bwt... done (%llu symbols, %u strings)\n", merge_bwt_in.size(), merge_bwt_in.n_strings());
+        }
+
         // build an output file
         SharedPointer<BaseBWTHandler> output_handler = SharedPointer<BaseBWTHandler>( open_bwt_file( output_name, comp_level ) );
         if (output_handler == NULL)
@@ -307,10 +366,20 @@ int main(int argc, char* argv[])
             return 1;
         }
 
+        // when merging, collect the new BWT in memory rather than writing it out directly
+        SharedPointer<BaseBWTHandler> merge_handler;
+        if (merge_name)
+            merge_handler = SharedPointer<BaseBWTHandler>( open_host_set_bwt( &merge_bwt_new ) );
+
+        BaseBWTHandler& bwt_handler = merge_name ? *merge_handler : *output_handler;
+
         // gather device memory stats
-        size_t free_device, total_device;
-        cudaMemGetInfo(&free_device, &total_device);
-        log_stats(stderr, "  device has %ld of %ld MB free\n", free_device/1024/1024, total_device/1024/1024);
+        size_t free_device = 0, total_device = 0;
+        if (cpu_only == false)
+        {
+            cudaMemGetInfo(&free_device, &total_device);
+            log_stats(stderr, "  device has %ld of %ld MB free\n", free_device/1024/1024, total_device/1024/1024);
+        }
 
     #ifdef _OPENMP
         // now set the number of CPU threads
@@ -352,7 +421,23 @@ int main(int argc, char* argv[])
         nvbio::Timer timer;
         timer.start();
 
-        if (input_size + params.device_memory < free_device)
+        if (cpu_only)
+        {
+            log_verbose(stderr, "  using cpu path\n");
+
+            const packed_stream_type h_packed_string( reads.h_read_storage );
+
+            const string_set h_string_set(
+                reads.n_reads,
+                h_packed_string,
+                nvbio::plain_view( reads.h_read_index ) );
+
+            host_large_bwt<SYMBOL_SIZE,true>(
+                h_string_set,
+                bwt_handler,
+                &params );
+        }
+        else if (input_size + params.device_memory < free_device)
         {
             log_verbose(stderr, "  using fast path\n");
 
@@ -370,7 +455,7 @@ int main(int argc, char* argv[])
 
             cuda::bwt<SYMBOL_SIZE,true>(
                 d_string_set,
-                *output_handler,
+                bwt_handler,
                 &params );
         }
         else
@@ -386,10 +471,22 @@ int main(int argc, char* argv[])
 
             large_bwt<SYMBOL_SIZE,true>(
                 h_string_set,
-                *output_handler,
+                bwt_handler,
                 &params );
         }
 
+        if (merge_name)
+        {
+            log_info(stderr, "  merge... started\n");
+
+            merge_bwt( merge_bwt_in, merge_bwt_new, *output_handler );
+
+            log_info(stderr, "  merge... done\n");
+        }
+
+        // wait for any output still being compressed in the background
+        output_handler->flush();
+
         timer.stop();
 
         //if (output_handler->n_dollars != reads.n_reads)
@@ -397,6 +494,20 @@ int main(int argc, char* argv[])
 
         log_info(stderr, "  bwt... done: %.2fs\n", timer.seconds());
 
+        // report the time spent sorting separately from the time spent waiting for the output
+        const BWTOutputStats output_stats = output_handler->output_stats();
+
+        log_stats(stderr, "    sorting     : %.2fs\n", timer.seconds() - output_stats.wait_time);
+        log_stats(stderr, "    output wait : %.2fs\n", output_stats.wait_time);
+        if (output_stats.compression_time > 0.0f)
+            log_stats(stderr, "    compression : %.2fs (summed over all compressor threads)\n", output_stats.compression_time);
+        if (output_stats.compressed_bytes)
+        {
+            log_stats(stderr, "    compressed  : %.1f MB -> %.1f MB\n",
+                float( output_stats.raw_bytes )        / float(1024*1024),
+                float( output_stats.compressed_bytes ) / float(1024*1024));
+        }
+
         log_visible(stderr,"nvSetBWT... done\n");
     }
     catch (nvbio::cuda_error e)
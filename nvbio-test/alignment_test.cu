@@ -33,6 +33,7 @@
 #include <nvbio/alignment/alignment.h>
 #include <nvbio/alignment/batched.h>
 #include <nvbio/alignment/sink.h>
+#include <nvbio/strings/string_set.h>
 #include <thrust/device_vector.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -163,6 +164,130 @@ struct AlignmentStream
     int16*                      m_scores;
 };
 
+//
+// A host alignment stream class, aligning each pattern against a window of a single packed
+// reference starting at an arbitrary offset, as is the case when verifying candidate hits
+//
+template <typename t_aligner_type, uint32 M, uint32 N, typename cache_type, bool PREFETCH = false>
+struct HostAlignmentStream
+{
+    typedef t_aligner_type                                                          aligner_type;
+
+    typedef const uint32*                                                           storage_iterator;
+
+    typedef nvbio::PackedStringLoader<storage_iterator,4,false,cache_type>          pattern_loader_type;
+    typedef typename pattern_loader_type::input_iterator                            uncached_pattern_iterator;
+    typedef typename pattern_loader_type::iterator                                  pattern_iterator;
+    typedef nvbio::vector_view<pattern_iterator>                                    pattern_string;
+
+    typedef nvbio::PackedStringLoader<storage_iterator,2,false,cache_type>          text_loader_type;
+    typedef typename text_loader_type::input_iterator                               uncached_text_iterator;
+    typedef typename text_loader_type::iterator                                     text_iterator;
+    typedef nvbio::vector_view<text_iterator>                                       text_string;
+
+    // an alignment context
+    struct context_type
+    {
+        int32                   min_score;
+        aln::BestSink<int32>    sink;
+    };
+    // a container for the strings to be aligned
+    struct strings_type
+    {
+        pattern_loader_type     pattern_loader;
+        text_loader_type        text_loader;
+        pattern_string          pattern;
+        trivial_quality_string  quals;
+        text_string             text;
+    };
+
+    // constructor
+    HostAlignmentStream(
+        aligner_type        _aligner,
+        const uint32        _count,
+        const uint32*       _patterns,
+        const uint32*       _text,
+        const uint32*       _text_offsets,
+               int16*       _scores) :
+        m_aligner( _aligner ), m_count(_count), m_patterns(_patterns), m_text(_text), m_text_offsets(_text_offsets), m_scores(_scores) {}
+
+    // get the aligner
+    const aligner_type& aligner() const { return m_aligner; };
+
+    // return the maximum pattern length
+    uint32 max_pattern_length() const { return M; }
+
+    // return the maximum text length
+    uint32 max_text_length() const { return N; }
+
+    // return the stream size
+    uint32 size() const { return m_count; }
+
+    // return the i-th pattern's length
+    uint32 pattern_length(const uint32 i, context_type* context) const { return M; }
+
+    // return the i-th text's length
+    uint32 text_length(const uint32 i, context_type* context) const { return N; }
+
+    // initialize the i-th context
+    bool init_context(
+        const uint32    i,
+        context_type*   context) const
+    {
+        context->min_score = Field_traits<int32>::min();
+        return true;
+    }
+
+    // initialize the i-th context
+    void load_strings(
+        const uint32        i,
+        const uint32        window_begin,
+        const uint32        window_end,
+        const context_type* context,
+              strings_type* strings) const
+    {
+        strings->pattern = pattern_string( M,
+            strings->pattern_loader.load(
+                m_patterns + i * M,
+                M,
+                make_uint2( window_begin, window_end ),
+                false ) );
+
+        strings->text = text_string( N, strings->text_loader.load( m_text + m_text_offsets[i], N ) );
+    }
+
+    // prefetch the strings of the i-th job
+    void prefetch(const uint32 i) const
+    {
+        pattern_loader_type::prefetch( m_patterns + i * M, M );
+        text_loader_type::prefetch( m_text + m_text_offsets[i], N );
+    }
+
+    // handle the output
+    void output(
+        const uint32        i,
+        const context_type* context) const
+    {
+        // copy the output score
+        m_scores[i] = context->sink.score;
+    }
+
+    aligner_type                m_aligner;
+    uint32                      m_count;
+    uncached_pattern_iterator   m_patterns;
+    uncached_text_iterator      m_text;
+    const uint32*               m_text_offsets;
+    int16*                      m_scores;
+};
+
+// prefetch the strings of the i-th job of a HostAlignmentStream
+//
+template <typename aligner_type, uint32 M, uint32 N, uint32 HOST_CACHE_SIZE>
+void prefetch_strings(const HostAlignmentStream<aligner_type,M,N,host_cache_tag<HOST_CACHE_SIZE>,true>& stream, const uint32 i)
+{
+    stream.prefetch( i );
+}
+
 // A simple kernel to test the speed of alignment without the possible overheads of the BatchAlignmentScore interface
 //
 template <uint32 BLOCKDIM, uint32 MAX_REF_LEN, typename aligner_type, typename score_type>
@@ -545,6 +670,102 @@ void batch_banded_score_profile_all(
     fprintf(stderr, " GCUPS\n");
 }
 
+// execute and time a batch of full DP alignments on the host, checking the scores against a reference
+//
+template <uint32 N, uint32 M, typename stream_type>
+void host_batch_score_profile(
+    const char*                     name,
+    const stream_type               stream,
+    const uint32                    n_tests,
+    const uint32                    n_tasks,
+    const int16*                    scores,
+    const int16*                    ref_scores)
+{
+    typedef aln::BatchedAlignmentScore<stream_type, HostThreadScheduler> batch_type;  // our batch type
+
+    // setup a batch
+    batch_type batch;
+
+    Timer timer;
+    timer.start();
+
+    for (uint32 i = 0; i < n_tests; ++i)
+        batch.enact( stream );
+
+    timer.stop();
+
+    const float time = timer.seconds() / float(n_tests);
+
+    fprintf(stderr,"    %15s : %5.2f GCUPS\n", name, 1.0e-9f * float(n_tasks*uint64(N*M))/time );
+
+    if (ref_scores != NULL && std::equal( scores, scores + n_tasks, ref_scores ) == false)
+    {
+        log_error(stderr, "    %s: mismatching scores\n", name);
+        exit(1);
+    }
+}
+
+// execute and time the host batch_score algorithm with all the host string caching strategies
+//
+template <uint32 N, uint32 M, typename aligner_type>
+void host_batch_score_profile_all(
+    const aligner_type              aligner,
+    const uint32                    n_tests,
+    const uint32                    n_tasks,
+    const std::vector<uint32>&      pattern_hvec,
+    const std::vector<uint32>&      text_hvec,
+    const std::vector<uint32>&      offsets_hvec)
+{
+    const uint32 HOST_CACHE_SIZE = 512;
+
+    std::vector<int16> ref_scores( n_tasks );
+    std::vector<int16> scores( n_tasks );
+    {
+        typedef HostAlignmentStream<aligner_type,M,N,uncached_tag_type> stream_type;
+
+        host_batch_score_profile<N,M>(
+            "uncached",
+            stream_type( aligner, n_tasks, &pattern_hvec[0], &text_hvec[0], &offsets_hvec[0], &ref_scores[0] ),
+            n_tests,
+            n_tasks,
+            &ref_scores[0],
+            NULL );
+    }
+    {
+        typedef HostAlignmentStream<aligner_type,M,N,lmem_cache_tag<64> > stream_type;
+
+        host_batch_score_profile<N,M>(
+            "word cache",
+            stream_type( aligner, n_tasks, &pattern_hvec[0], &text_hvec[0], &offsets_hvec[0], &scores[0] ),
+            n_tests,
+            n_tasks,
+            &scores[0],
+            &ref_scores[0] );
+    }
+    {
+        typedef HostAlignmentStream<aligner_type,M,N,host_cache_tag<HOST_CACHE_SIZE> > stream_type;
+
+        host_batch_score_profile<N,M>(
+            "unpacked",
+            stream_type( aligner, n_tasks, &pattern_hvec[0], &text_hvec[0], &offsets_hvec[0], &scores[0] ),
+            n_tests,
+            n_tasks,
+            &scores[0],
+            &ref_scores[0] );
+    }
+    {
+        typedef HostAlignmentStream<aligner_type,M,N,host_cache_tag<HOST_CACHE_SIZE>,true> stream_type;
+
+        host_batch_score_profile<N,M>(
+            "prefetched",
+            stream_type( aligner, n_tasks, &pattern_hvec[0], &text_hvec[0], &offsets_hvec[0], &scores[0] ),
+            n_tests,
+            n_tasks,
+            &scores[0],
+            &ref_scores[0] );
+    }
+}
+
 // a simple banded edit distance test
 //
 template <typename string_type>
@@ -570,6 +791,90 @@ void banded_edit_distance_test(
         fprintf(stderr, "  synthetic Edit Distance test %u... passed!\n", test_id);
 }
 
+// check the host batch_alignment_score() path, which unpacks the strings into a host cache of
+// unpacked symbols, against single uncached alignments on texts longer than the cache
+//
+template <typename aligner_type>
+void host_long_text_test(const char* name, const aligner_type aligner)
+{
+    const uint32 N_TASKS = 16;
+    const uint32 M       = 100;
+    const uint32 N       = 5000;        // well beyond the 2048 symbols cached by batch_alignment_score()
+
+    typedef PackedStream<uint32*,uint8,2u,false>                        packed_stream_type;
+    typedef PackedStream<const uint32*,uint8,2u,false>                  const_packed_stream_type;
+    typedef ConcatenatedStringSet<const_packed_stream_type,const uint32*> packed_string_set;
+    typedef typename column_storage_type<aligner_type>::type            cell_type;
+
+    std::vector<uint8>  str( M * N_TASKS );
+    std::vector<uint8>  ref( N * N_TASKS );
+    std::vector<uint32> str_words( (M * N_TASKS + 15) >> 4 );
+    std::vector<uint32> ref_words( (N * N_TASKS + 15) >> 4 );
+    std::vector<uint32> str_offsets( N_TASKS+1 );
+    std::vector<uint32> ref_offsets( N_TASKS+1 );
+
+    LCG_random rand;
+    for (uint32 i = 0; i < M * N_TASKS; ++i)
+        str[i] = rand.next() & 3u;
+    for (uint32 i = 0; i < N * N_TASKS; ++i)
+        ref[i] = rand.next() & 3u;
+
+    // plant each pattern near the end of its text, so that any truncation of the text changes the score
+    for (uint32 t = 0; t < N_TASKS; ++t)
+    {
+        const uint32 offset = N - M - t;
+        for (uint32 i = 0; i < M; ++i)
+            ref[ t * N + offset + i ] = str[ t * M + i ];
+    }
+
+    packed_stream_type str_stream( &str_words[0] );
+    packed_stream_type ref_stream( &ref_words[0] );
+    for (uint32 i = 0; i < M * N_TASKS; ++i)
+        str_stream[i] = str[i];
+    for (uint32 i = 0; i < N * N_TASKS; ++i)
+        ref_stream[i] = ref[i];
+
+    for (uint32 t = 0; t <= N_TASKS; ++t)
+    {
+        str_offsets[t] = t * M;
+        ref_offsets[t] = t * N;
+    }
+
+    std::vector< aln::BestSink<int32> > sinks( N_TASKS );
+
+    aln::batch_alignment_score(
+        aligner,
+        packed_string_set( N_TASKS, const_packed_stream_type( &str_words[0] ), &str_offsets[0] ),
+        packed_string_set( N_TASKS, const_packed_stream_type( &ref_words[0] ), &ref_offsets[0] ),
+        &sinks[0],
+        aln::HostThreadScheduler(),
+        M,
+        N );
+
+    std::vector<cell_type> column( N );
+
+    for (uint32 t = 0; t < N_TASKS; ++t)
+    {
+        aln::BestSink<int32> sink;
+        aln::alignment_score(
+            aligner,
+            vector_view<const uint8*>( M, &str[ t * M ] ),
+            trivial_quality_string(),
+            vector_view<const uint8*>( N, &ref[ t * N ] ),
+            Field_traits<int32>::min(),
+            sink,
+            &column[0] );
+
+        if (sinks[t].score != sink.score)
+        {
+            log_error(stderr, "  host %s long text test... failed\n", name);
+            log_error(stderr, "    task %u: expected %d, got: %d\n", t, sink.score, sinks[t].score);
+            exit(1);
+        }
+    }
+    fprintf(stderr, "  host %s long text test... passed!\n", name);
+}
+
 void test(int argc, char* argv[])
 {
                      uint32 n_tests          = 1;
@@ -623,6 +928,8 @@ void test(int argc, char* argv[])
                     TEST_MASK |= GOTOH;
                 else if (strcmp( temp, "gotoh-banded" ) == 0)
                     TEST_MASK |= GOTOH_BANDED;
+                else if (strcmp( temp, "host" ) == 0)
+                    TEST_MASK |= HOST;
 
                 if (*end == '\0')
                     break;
@@ -754,6 +1061,12 @@ void test(int argc, char* argv[])
         }
     }
 
+    if (TEST_MASK & FUNCTIONAL)
+    {
+        host_long_text_test( "Smith-Waterman", make_smith_waterman_aligner<aln::SEMI_GLOBAL>( aln::SimpleSmithWatermanScheme(2,-1,-1,-1) ) );
+        host_long_text_test( "Edit Distance",  make_edit_distance_aligner<aln::SEMI_GLOBAL>() );
+    }
+
     if (TEST_MASK & FUNCTIONAL)
     {
         fprintf(stderr,"  testing real banded Gotoh problem...\n");
@@ -1124,6 +1437,46 @@ void test(int argc, char* argv[])
             }
         }
     }
+    // do a speed test of host alignment against windows scattered across a large reference
+    if (TEST_MASK & HOST)
+    {
+        const uint32 N_TASKS = N_THREAD_TASKS / 8;
+        const uint32 M = 150;
+        const uint32 N = 500;
+        const uint32 REF_LEN = 256u*1024u*1024u;
+
+        const uint32 M_WORDS   = (M + 7)  >> 3;
+        const uint32 REF_WORDS = (REF_LEN + 15) >> 4;
+
+        std::vector<uint32> str( M_WORDS * N_TASKS );
+        std::vector<uint32> ref( REF_WORDS );
+        std::vector<uint32> offsets( N_TASKS );
+
+        LCG_random rand;
+        fill_packed_stream<4u>( rand, 4u, M * N_TASKS, &str[0] );
+        fill_packed_stream<2u>( rand, 4u, REF_LEN,     &ref[0] );
+
+        for (uint32 i = 0; i < N_TASKS; ++i)
+            offsets[i] = rand.next() % (REF_LEN - N);
+
+        fprintf(stderr,"  testing host Smith-Waterman scoring speed (semi-global)...\n");
+        host_batch_score_profile_all<N,M>(
+            make_smith_waterman_aligner<aln::SEMI_GLOBAL>( aln::SimpleSmithWatermanScheme(2,-1,-1,-1) ),
+            n_tests,
+            N_TASKS,
+            str,
+            ref,
+            offsets );
+
+        fprintf(stderr,"  testing host Edit Distance scoring speed (semi-global)...\n");
+        host_batch_score_profile_all<N,M>(
+            make_edit_distance_aligner<aln::SEMI_GLOBAL>(),
+            n_tests,
+            N_TASKS,
+            str,
+            ref,
+            offsets );
+    }
     fprintf(stderr,"testing alignment... done\n");
 }
 
@@ -55,6 +55,7 @@ enum AlignmentTest
     SW_WARP             = 64u,
     SW_STRIPED          = 128u,
     FUNCTIONAL          = 256u,
+    HOST                = 512u,
 };
 
 // make a light-weight string from an ASCII char string
@@ -0,0 +1,219 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// bloom_filter_test.cpp
+//
+
+#include <nvbio/basic/bloom_filter.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/console.h>
+#include <vector>
+
+namespace nvbio {
+
+namespace {
+
+struct hash_functor1
+{
+    uint64 operator() (const uint32 key) const { return hash( uint64( key ) ); }
+};
+struct hash_functor2
+{
+    uint64 operator() (const uint32 key) const { return hash2( key ); }
+};
+
+// the i-th inserted key
+//
+uint32 inserted_key(const uint32 i) { return hash( 2u*i ); }
+
+// the i-th probed key, never inserted as hash() is a bijection
+//
+uint32 probed_key(const uint32 i) { return hash( 2u*i + 1u ); }
+
+struct BloomStats
+{
+    float  insert_time;
+    float  has_time;
+    uint32 n_false_negatives;
+    uint32 n_false_positives;
+    uint32 n_mismatches;        // batched lookups disagreeing with the scalar ones
+};
+
+// insert n_keys keys in the given filter, and probe it with n_probes keys which were not inserted
+//
+template <typename filter_type>
+BloomStats test_filter(filter_type& filter, const std::vector<uint32>& keys, const std::vector<uint32>& probes)
+{
+    BloomStats stats;
+    stats.n_mismatches = 0;
+
+    Timer timer;
+    timer.start();
+
+    for (uint32 i = 0; i < uint32( keys.size() ); ++i)
+        filter.insert( keys[i] );
+
+    timer.stop();
+    stats.insert_time = timer.seconds();
+
+    stats.n_false_negatives = 0;
+    for (uint32 i = 0; i < uint32( keys.size() ); ++i)
+        stats.n_false_negatives += filter.has( keys[i] ) ? 0u : 1u;
+
+    timer.start();
+
+    stats.n_false_positives = 0;
+    for (uint32 i = 0; i < uint32( probes.size() ); ++i)
+        stats.n_false_positives += filter.has( probes[i] ) ? 1u : 0u;
+
+    timer.stop();
+    stats.has_time = timer.seconds();
+    return stats;
+}
+
+// probe a blocked filter through the batched has() method, checking that all inserted keys are
+// reported present, and that the batched results match the scalar has() ones of a reference
+// view of the same filter
+//
+template <typename filter_type, typename reference_type>
+BloomStats test_batched(const filter_type& filter, const reference_type& reference, const std::vector<uint32>& keys, const std::vector<uint32>& probes)
+{
+    BloomStats stats;
+    stats.insert_time = 0.0f;
+
+    std::vector<uint8> results( nvbio::max( uint32( keys.size() ), uint32( probes.size() ) ) );
+
+    // check the inserted keys
+    filter.has( uint32( keys.size() ), &keys[0], &results[0] );
+
+    stats.n_false_negatives = 0;
+    for (uint32 i = 0; i < uint32( keys.size() ); ++i)
+        stats.n_false_negatives += results[i] ? 0u : 1u;
+
+    // and time the probes
+    Timer timer;
+    timer.start();
+
+    filter.has( uint32( probes.size() ), &probes[0], &results[0] );
+
+    stats.n_false_positives = 0;
+    for (uint32 i = 0; i < uint32( probes.size() ); ++i)
+        stats.n_false_positives += results[i];
+
+    timer.stop();
+    stats.has_time = timer.seconds();
+
+    // compare the batched results against the scalar ones
+    stats.n_mismatches = 0;
+    for (uint32 i = 0; i < uint32( probes.size() ); ++i)
+        stats.n_mismatches += (results[i] ? true : false) != reference.has( probes[i] ) ? 1u : 0u;
+
+    return stats;
+}
+
+bool report(const char* name, const BloomStats& stats, const uint32 n_keys, const uint32 n_probes)
+{
+    log_info(stderr, "    %-16s : fpr %.4f%%, insert %6.1f M keys/s, has %6.1f M keys/s\n",
+        name,
+        100.0f * float( stats.n_false_positives ) / float( n_probes ),
+        stats.insert_time ? 1.0e-6f * float( n_keys ) / stats.insert_time : 0.0f,
+        1.0e-6f * float( n_probes ) / stats.has_time);
+
+    if (stats.n_false_negatives)
+    {
+        log_error(stderr, "  %s: %u false negatives\n", name, stats.n_false_negatives);
+        return false;
+    }
+    if (stats.n_mismatches)
+    {
+        log_error(stderr, "  %s: %u lookups differ from the scalar ones\n", name, stats.n_mismatches);
+        return false;
+    }
+    return true;
+}
+
+template <uint32 K>
+bool bloom_filter_test(const uint32 bits_per_key, const std::vector<uint32>& keys, const std::vector<uint32>& probes)
+{
+    const uint32 n_keys   = uint32( keys.size() );
+    const uint32 n_probes = uint32( probes.size() );
+    const uint64 n_bits   = uint64( n_keys ) * bits_per_key;
+
+    log_info(stderr, "  %u bits per key, K = %u\n", bits_per_key, K);
+
+    // the classic filter, touching K different cache lines per key
+    {
+        std::vector<uint32> storage( n_bits / 32u, 0u );
+
+        bloom_filter<K,hash_functor1,hash_functor2,uint32*> filter( n_bits, &storage[0] );
+
+        if (report( "bloom_filter", test_filter( filter, keys, probes ), n_keys, n_probes ) == false)
+            return false;
+    }
+    // the blocked filter, touching a single cache line per key
+    {
+        std::vector<uint32> storage( n_bits / 32u, 0u );
+
+        blocked_bloom_filter<K,hash_functor1,hash_functor2,uint32*> filter( n_bits, &storage[0] );
+
+        if (report( "blocked", test_filter( filter, keys, probes ), n_keys, n_probes ) == false)
+            return false;
+
+        // a view of the same blocks through a generic iterator, which always takes the portable
+        // lookup path, even when the uint32* one uses AVX2
+        typedef std::vector<uint32>::const_iterator reference_iterator;
+
+        const blocked_bloom_filter<K,hash_functor1,hash_functor2,reference_iterator> reference( n_bits, reference_iterator( storage.begin() ) );
+
+        if (report( "blocked/batched", test_batched( filter, reference, keys, probes ), n_keys, n_probes ) == false)
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int bloom_filter_test()
+{
+    log_info(stderr, "bloom filter test... started\n");
+
+    const uint32 n_keys   = 4*1024*1024;
+    const uint32 n_probes = 16*1024*1024;
+
+    std::vector<uint32> keys( n_keys );
+    for (uint32 i = 0; i < n_keys; ++i)
+        keys[i] = inserted_key(i);
+
+    std::vector<uint32> probes( n_probes );
+    for (uint32 i = 0; i < n_probes; ++i)
+        probes[i] = probed_key(i);
+
+  #if defined(NVBIO_AVX2)
+    log_info(stderr, "  AVX2 lookups enabled\n");
+  #endif
+
+    if (bloom_filter_test<4>( 8u, keys, probes ) == false ||
+        bloom_filter_test<8>( 16u, keys, probes ) == false)
+        return 1;
+
+    log_info(stderr, "bloom filter test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
@@ -24,6 +24,9 @@
 #include <string.h>
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/cache.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/omp.h>
+#include <vector>
 
 using namespace nvbio;
 
@@ -57,6 +60,93 @@ struct CacheManager
     uint32 m_size;
 };
 
+// a cache manager tracking which elements are loaded, used to check the cache
+// from multiple threads
+struct TrackingCacheManager
+{
+    // constructor
+    TrackingCacheManager(const uint32 n_items, const uint32 capacity) :
+        m_loaded( n_items, 0u ), m_capacity( capacity ), m_size(0), m_errors(0), m_misses(0) {}
+
+    // acquire element i
+    bool acquire(const uint32 i)
+    {
+        if (m_size >= m_capacity)
+            return false;
+
+        if (m_loaded[i])
+            ++m_errors;
+
+        m_loaded[i] = 1u;
+        ++m_size;
+        ++m_misses;
+        return true;
+    }
+
+    // release element i
+    void release(const uint32 i)
+    {
+        if (m_loaded[i] == 0u)
+            ++m_errors;
+
+        m_loaded[i] = 0u;
+        --m_size;
+    }
+
+    // is cache usage below the low-watermark?
+    bool low_watermark() const
+    {
+        return (m_size < m_capacity - m_capacity/4);
+    }
+
+    std::vector<uint32> m_loaded;
+    uint32              m_capacity;
+    uint32              m_size;
+    uint32              m_errors;
+    uint32              m_misses;
+};
+
+// pin and unpin elements drawn from a skewed distribution from n_threads threads,
+// checking that pinned elements are always loaded, and returning the throughput
+// in M pins/s
+float cache_throughput(const uint32 n_threads, const uint32 n_items, const uint32 capacity, const uint32 n_ops, uint32* n_errors, float* miss_rate)
+{
+    TrackingCacheManager manager( n_items, capacity );
+
+    LRU<TrackingCacheManager> cache( manager );
+
+    uint32 n_unloaded = 0;
+
+    Timer timer;
+    timer.start();
+
+  #pragma omp parallel num_threads(n_threads) reduction(+:n_unloaded)
+    {
+        uint32 seed = 1u + omp_get_thread_num();
+
+      #pragma omp for
+        for (int i = 0; i < int( n_ops ); ++i)
+        {
+            // raising a uniform variate to the 4-th power skews accesses towards the first elements
+            seed = seed * 1664525u + 1013904223u;
+            const uint64 r    = seed >> 16;
+            const uint64 r2   = (r * r) >> 16;
+            const uint32 item = uint32( (r2 * r2 * n_items) >> 32 );
+
+            cache.pin( item );
+            if (manager.m_loaded[ item ] == 0u)
+                ++n_unloaded;
+            cache.unpin( item );
+        }
+    }
+
+    timer.stop();
+
+    *n_errors  = manager.m_errors + n_unloaded + (manager.m_size != cache.size() ? 1u : 0u);
+    *miss_rate = float( manager.m_misses ) / float( n_ops );
+    return 1.0e-6f * float( n_ops ) / timer.seconds();
+}
+
 int cache_test()
 {
     printf("cache test... started\n");
@@ -85,6 +175,22 @@ int cache_test()
         printf("  error: overflow was expected, but did not occurr!\n");
     else
         printf("  test overflow... done\n");
+
+    printf("  test throughput... started\n");
+    for (uint32 n_threads = 1; n_threads <= uint32( omp_get_max_threads() ); n_threads *= 2)
+    {
+        uint32 n_errors;
+        float  miss_rate;
+        const float mpins = cache_throughput( n_threads, 64*1024, 16*1024, 4*1024*1024, &n_errors, &miss_rate );
+
+        printf("    %2u threads: %6.2f M pins/s (miss rate %.1f%%)\n", n_threads, mpins, 100.0f * miss_rate);
+        if (n_errors)
+        {
+            printf("  error: %u inconsistencies found!\n", n_errors);
+            return 1;
+        }
+    }
+    printf("  test throughput... done\n");
     printf("cache test... done\n");
     return 0u;
 }
\ No newline at end of file
@@ -0,0 +1,308 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// dedup_test.cpp
+//
+
+#include <nvbio/io/output/output_dedup.h>
+#include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/io/sequence/sequence_access.h>
+#include <nvbio/basic/shared_pointer.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/dna.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace nvbio {
+
+namespace {
+
+// a read of a test batch
+//
+struct TestRead
+{
+    const char* name;
+    const char* bps;
+    const char* qual;
+};
+
+// build a batch of reads
+//
+void build_batch(io::SequenceDataHost& batch, const uint32 n_reads, const TestRead* reads)
+{
+    SharedPointer<io::SequenceDataEncoder> encoder( io::create_encoder( DNA_N, &batch ) );
+
+    encoder->begin_batch();
+    for (uint32 i = 0; i < n_reads; ++i)
+    {
+        encoder->push_back(
+            uint32( strlen( reads[i].bps ) ),
+            reads[i].name,
+            (const uint8*)reads[i].bps,
+            (const uint8*)reads[i].qual,
+            io::Phred33,
+            uint32(-1),
+            io::SequenceDataEncoder::NO_OP );
+    }
+    encoder->end_batch();
+}
+
+// the number of CIGAR operations and MD bytes of the synthetic alignment tagged by pos
+//
+uint32 cigar_len(const uint32 pos) { return pos % 7u + 1u; }
+uint32 mds_len(const uint32 pos)   { return pos % 5u + 1u; }
+
+// fill a batch with the synthetic results of n reads: the i-th read is aligned at pos[i], with
+// a CIGAR and an MD string derived from it, or left unaligned if pos[i] is uint32(-1)
+//
+void fill_results(io::CPUOutputBatch& batch, const uint32 n, const uint32* pos)
+{
+    batch.count = n;
+    batch.best_alignments.resize( n );
+    batch.cigar[ io::MATE_1 ].array.resize( n, 64u );
+    batch.cigar[ io::MATE_1 ].coords.resize( n );
+    batch.mds[ io::MATE_1 ].resize( n, 64u );
+
+    uint32 cigar_offset = 0u;
+    uint32 mds_offset   = 0u;
+    for (uint32 i = 0; i < n; ++i)
+    {
+        batch.best_alignments[i] = io::AlignmentResult();
+        batch.cigar[ io::MATE_1 ].coords[i] = make_uint2( 0u, 0u );
+
+        if (pos[i] == uint32(-1))
+            continue;
+
+        batch.best_alignments[i].best[ io::MATE_1 ] = io::Alignment( pos[i], pos[i] % 3u, -int32( pos[i] % 11u ), 0u );
+        batch.cigar[ io::MATE_1 ].coords[i] = make_uint2( pos[i], pos[i] + 1u );
+
+        io::Cigar* cigar = batch.cigar[ io::MATE_1 ].array.bind( i, cigar_offset, cigar_len( pos[i] ) );
+        for (uint32 j = 0; j < cigar_len( pos[i] ); ++j)
+            cigar[j] = io::Cigar( io::Cigar::SUBSTITUTION, uint16( pos[i] + j ) );
+
+        uint8* mds = batch.mds[ io::MATE_1 ].bind( i, mds_offset, mds_len( pos[i] ) );
+        for (uint32 j = 0; j < mds_len( pos[i] ); ++j)
+            mds[j] = uint8( pos[i] + j );
+
+        cigar_offset += cigar_len( pos[i] );
+        mds_offset   += mds_len( pos[i] );
+    }
+}
+
+// check that the i-th read of a fanned out batch carries the synthetic results tagged by pos
+//
+bool check_results(const io::CPUOutputBatch& batch, const uint32 i, const uint32 pos)
+{
+    const io::Alignment& aln   = batch.best_alignments[i].best[ io::MATE_1 ];
+    const io::Cigar*     cigar = batch.cigar[ io::MATE_1 ].array[i];
+    const uint8*         mds   = batch.mds[ io::MATE_1 ][i];
+
+    if (pos == uint32(-1))
+    {
+        if (aln.is_aligned() || cigar != NULL || mds != NULL)
+        {
+            log_error(stderr, "  read %u: expected to be unaligned\n", i);
+            return false;
+        }
+        return true;
+    }
+
+    if (aln.is_aligned() == false || aln.alignment() != pos || aln.ed() != pos % 3u || aln.score() != -int32( pos % 11u ))
+    {
+        log_error(stderr, "  read %u: mismatching alignment, expected at %u\n", i, pos);
+        return false;
+    }
+
+    const uint2 coords = batch.cigar[ io::MATE_1 ].coords[i];
+    if (coords.x != pos || coords.y != pos + 1u)
+    {
+        log_error(stderr, "  read %u: mismatching CIGAR coordinates\n", i);
+        return false;
+    }
+
+    if (cigar == NULL || batch.cigar[ io::MATE_1 ].array.size(i) != cigar_len( pos ))
+    {
+        log_error(stderr, "  read %u: CIGAR not bound\n", i);
+        return false;
+    }
+    for (uint32 j = 0; j < cigar_len( pos ); ++j)
+    {
+        if (cigar[j].m_type != io::Cigar::SUBSTITUTION || cigar[j].m_len != pos + j)
+        {
+            log_error(stderr, "  read %u: mismatching CIGAR\n", i);
+            return false;
+        }
+    }
+
+    if (mds == NULL || batch.mds[ io::MATE_1 ].size(i) != mds_len( pos ))
+    {
+        log_error(stderr, "  read %u: MD string not bound\n", i);
+        return false;
+    }
+    for (uint32 j = 0; j < mds_len( pos ); ++j)
+    {
+        if (mds[j] != uint8( pos + j ))
+        {
+            log_error(stderr, "  read %u: mismatching MD string\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+// check the unique reads returned by dedup() against the expected input reads
+//
+bool check_unique(const io::SequenceDataHost& unique, const uint32 n, const TestRead* reads, const uint32* ids)
+{
+    if (unique.size() != n)
+    {
+        log_error(stderr, "  %u unique reads, expected %u\n", unique.size(), n);
+        return false;
+    }
+
+    typedef io::SequenceDataAccess<DNA_N> access_type;
+    const access_type access( unique );
+    const access_type::sequence_stream_type stream = access.sequence_stream();
+
+    for (uint32 u = 0; u < n; ++u)
+    {
+        const TestRead& read  = reads[ ids[u] ];
+        const uint2     range = access.get_range( u );
+
+        bool match = range.y - range.x == strlen( read.bps ) &&
+                     strcmp( access.name_stream() + access.name_index()[u], read.name ) == 0;
+
+        for (uint32 j = 0; match && j < range.y - range.x; ++j)
+            match = stream[ range.x + j ] == char_to_dna( read.bps[j] );
+
+        if (match == false)
+        {
+            log_error(stderr, "  unique read %u does not match input read \"%s\"\n", u, read.name);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int dedup_test()
+{
+    log_info(stderr, "dedup test... started\n");
+
+    // a cache of two entries, so that the first batch overflows it
+    io::DuplicateReadCache dedup( 2u );
+
+    //
+    // first batch: two exact duplicates, and a read differing from another only by its qualities
+    //
+    const TestRead reads1[5] = {
+        { "r0", "ACGTACGTAA", "IIIIIIIIII" },
+        { "r1", "ACGTACGTAA", "IIIIIIIIII" },   // duplicate of r0
+        { "r2", "TTTTGGGGCC", "IIIIIIIIII" },
+        { "r3", "ACGTACGTAA", "IIIII#IIII" },   // r0 with different qualities
+        { "r4", "TTTTGGGGCC", "IIIIIIIIII" },   // duplicate of r2
+    };
+    io::SequenceDataHost batch1;
+    build_batch( batch1, 5u, reads1 );
+    {
+        const io::SequenceDataHost& unique = dedup.dedup( batch1 );
+
+        const uint32 unique_ids[3] = { 0u, 2u, 3u };
+        if (dedup.unique_reads() != 3u || check_unique( unique, 3u, reads1, unique_ids ) == false)
+            return 1;
+
+        // align r0 and r3, and leave r2 unaligned
+        const uint32 unique_pos[3] = { 100u, uint32(-1), 102u };
+
+        io::CPUOutputBatch output;
+        fill_results( output, 3u, unique_pos );
+
+        dedup.fan_out( output );
+
+        const uint32 pos[5] = { 100u, 100u, uint32(-1), 102u, uint32(-1) };
+        if (output.count != 5u)
+        {
+            log_error(stderr, "  first batch: %u fanned out results, expected 5\n", output.count);
+            return 1;
+        }
+        for (uint32 i = 0; i < 5u; ++i)
+        {
+            if (check_results( output, i, pos[i] ) == false)
+                return 1;
+        }
+    }
+    if (dedup.n_reads != 5u || dedup.n_batch_hits != 2u || dedup.n_cache_hits != 0u)
+    {
+        log_error(stderr, "  first batch: %llu reads, %llu batch hits, %llu cache hits, expected 5, 2, 0\n",
+            dedup.n_reads, dedup.n_batch_hits, dedup.n_cache_hits);
+        return 1;
+    }
+
+    //
+    // second batch: r0 has been evicted from the cache, while r2 and r3 are still there
+    //
+    const TestRead reads2[5] = {
+        { "s0", "TTTTGGGGCC", "IIIIIIIIII" },   // cached r2
+        { "s1", "ACGTACGTAA", "IIIII#IIII" },   // cached r3
+        { "s2", "ACGTACGTAA", "IIIIIIIIII" },   // evicted r0
+        { "s3", "GATTACAGAT", "IIIIIIIIII" },   // new
+        { "s4", "ACGTACGTAA", "IIIII#IIII" },   // duplicate of s1
+    };
+    io::SequenceDataHost batch2;
+    build_batch( batch2, 5u, reads2 );
+    {
+        const io::SequenceDataHost& unique = dedup.dedup( batch2 );
+
+        const uint32 unique_ids[2] = { 2u, 3u };
+        if (dedup.unique_reads() != 2u || check_unique( unique, 2u, reads2, unique_ids ) == false)
+            return 1;
+
+        const uint32 unique_pos[2] = { 200u, 201u };
+
+        io::CPUOutputBatch output;
+        fill_results( output, 2u, unique_pos );
+
+        dedup.fan_out( output );
+
+        const uint32 pos[5] = { uint32(-1), 102u, 200u, 201u, 102u };
+        if (output.count != 5u)
+        {
+            log_error(stderr, "  second batch: %u fanned out results, expected 5\n", output.count);
+            return 1;
+        }
+        for (uint32 i = 0; i < 5u; ++i)
+        {
+            if (check_results( output, i, pos[i] ) == false)
+                return 1;
+        }
+    }
+    if (dedup.n_reads != 10u || dedup.n_batch_hits != 3u || dedup.n_cache_hits != 2u)
+    {
+        log_error(stderr, "  second batch: %llu reads, %llu batch hits, %llu cache hits, expected 10, 3, 2\n",
+            dedup.n_reads, dedup.n_batch_hits, dedup.n_cache_hits);
+        return 1;
+    }
+
+    log_info(stderr, "  hit rate: %.1f%%\n", 100.0f * dedup.hit_rate());
+    log_info(stderr, "dedup test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
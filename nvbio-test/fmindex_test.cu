@@ -44,6 +44,7 @@
 #include <nvbio/fmindex/ssa.h>
 #include <nvbio/fmindex/fmindex.h>
 #include <nvbio/fmindex/backtrack.h>
+#include <nvbio/fmindex/kmer_lut.h>
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/fmindex/fmindex.h>
 
@@ -406,6 +407,129 @@ void synthetic_test_host(
     fprintf(stderr, "\n    cpu alignment... done: %.1fms, A/s: %.2f M\n", timer.seconds()*1000.0f, REQS/(timer.seconds()*1.0e6f) );
 }
 
+// backward search counting the number of range rank() queries issued
+//
+template <typename FMIndexType, typename Iterator>
+typename FMIndexType::range_type counted_match(
+    const FMIndexType                       fmi,
+    const Iterator                          pattern,
+    const uint32                            pattern_len,
+    typename FMIndexType::range_type        range,
+    uint64&                                 rank_calls)
+{
+    typedef typename FMIndexType::range_type range_type;
+
+    for (int32 i = pattern_len-1; i >= 0 && range.x <= range.y; --i)
+    {
+        const uint8 c = pattern[i];
+        const range_type c_rank = rank(
+            fmi,
+            make_vector( range.x-1, range.y ),
+            c );
+
+        range.x = fmi.L2(c) + c_rank.x + 1;
+        range.y = fmi.L2(c) + c_rank.y;
+
+        ++rank_calls;
+    }
+    return range;
+}
+
+// test the k-mer lookup table against plain backward search, and measure how many rank()
+// queries and how much time it saves per seed
+//
+template <
+    typename TextType,
+    typename FMIndexType>
+void kmer_lut_test(
+    const uint32                LEN,
+    const uint32                REQS,
+    const TextType              text,
+    const FMIndexType           fmi)
+{
+    typedef typename FMIndexType::index_type index_type;
+    typedef typename FMIndexType::range_type range_type;
+
+    const uint32 K          = 10u;
+    const uint32 SEED_LEN   = 20u;
+
+    if (LEN < SEED_LEN*2)
+        return;
+
+    fprintf(stderr, "  k-mer lut test... started\n" );
+
+    Timer timer;
+    timer.start();
+
+    std::vector<range_type> lut_ranges( fm_index_kmer_lut<index_type>::entries( K ) );
+    build_kmer_lut( fmi, K, &lut_ranges[0] );
+
+    timer.stop();
+    fprintf(stderr, "    build (k=%u): %.1fms, %.1f MB\n", K, timer.seconds()*1000.0f, float(lut_ranges.size()*sizeof(range_type))/float(1024*1024) );
+
+    const fm_index_kmer_lut<index_type> lut( K, &lut_ranges[0] );
+
+    // half of the seeds are sampled from the text, half are random strings
+    std::vector<uint8> seeds( uint64(REQS) * SEED_LEN );
+    for (uint32 i = 0; i < REQS; ++i)
+    {
+        const uint32 pos = rand() % (LEN - SEED_LEN);
+        for (uint32 j = 0; j < SEED_LEN; ++j)
+            seeds[ i*SEED_LEN + j ] = (i & 1) ? uint8( rand() % 4 ) : uint8( text[ pos + j ] );
+    }
+
+    // check the output and count the rank calls
+    uint64 rank_calls     = 0;
+    uint64 lut_rank_calls = 0;
+    for (uint32 i = 0; i < REQS; ++i)
+    {
+        const uint8* seed = &seeds[ i*SEED_LEN ];
+
+        const range_type range     = match( fmi, seed, SEED_LEN );
+        const range_type lut_range = match( fmi, lut, seed, SEED_LEN );
+
+        if (range.x != lut_range.x || range.y != lut_range.y)
+        {
+            fprintf(stderr, "  \nerror : k-mer lut match %u resulted in (%llu,%llu), expected (%llu,%llu)\n", i,
+                (unsigned long long)lut_range.x, (unsigned long long)lut_range.y,
+                (unsigned long long)range.x,     (unsigned long long)range.y );
+            exit(1);
+        }
+
+        counted_match( fmi, seed, SEED_LEN, make_vector( index_type(0), fmi.length() ), rank_calls );
+
+        uint32 code;
+        kmer_code( seed + SEED_LEN - K, K, &code );
+        if (lut[ code ].x <= lut[ code ].y)
+            counted_match( fmi, seed, SEED_LEN - K, lut[ code ], lut_rank_calls );
+    }
+
+    // time both searches
+    uint64 checksum = 0;
+
+    timer.start();
+    for (uint32 i = 0; i < REQS; ++i)
+        checksum += match( fmi, &seeds[ i*SEED_LEN ], SEED_LEN ).x;
+    timer.stop();
+    const float match_time = timer.seconds();
+
+    timer.start();
+    for (uint32 i = 0; i < REQS; ++i)
+        checksum -= match( fmi, lut, &seeds[ i*SEED_LEN ], SEED_LEN ).x;
+    timer.stop();
+    const float lut_time = timer.seconds();
+
+    if (checksum)
+    {
+        fprintf(stderr, "  \nerror : k-mer lut checksum mismatch\n" );
+        exit(1);
+    }
+
+    fprintf(stderr, "    plain  : %5.2f rank calls/seed, %.2f M seeds/s\n", float(rank_calls)/float(REQS),     float(REQS)/(match_time*1.0e6f) );
+    fprintf(stderr, "    k-mer  : %5.2f rank calls/seed, %.2f M seeds/s\n", float(lut_rank_calls)/float(REQS), float(REQS)/(lut_time*1.0e6f) );
+    fprintf(stderr, "  k-mer lut test... done\n" );
+}
+
 } // anonymous namespace
 
 template <typename index_type>
@@ -656,6 +780,8 @@ void synthetic_test(const uint32 LEN, const uint32 QUERIES)
     }
     fprintf(stderr, "\n  alignment test... done\n" );
 
+    kmer_lut_test( LEN, REQS, text, fmi );
+
     const uint32 SPARSITY = 100;
 
     data.input[0] = 0;
@@ -1001,6 +1127,192 @@ void backtrack_test(const char* index_file, const char* reads_name, const uint32
         log_warning(stderr, "unable to load \"%s\"\n", index_file);
 }
 
+// run random host rank() queries against an FM-index from all OpenMP threads, returning
+// the total number of ranks per second
+//
+template <typename fm_index_type>
+float host_rank_throughput(const fm_index_type* fmi, const uint32 n_indices, const uint32 n_queries)
+{
+    uint64 checksum = 0;
+
+    Timer timer;
+    timer.start();
+
+    #pragma omp parallel reduction(+:checksum)
+    {
+        // each thread picks the replica closest to its NUMA node, if there is more than one
+        const fm_index_type& local_fmi = fmi[ n_indices > 1 ? numa_current_node() % n_indices : 0u ];
+
+        #pragma omp for
+        for (int i = 0; i < int( n_queries ); ++i)
+        {
+            const uint32 pos = hash( uint32(i) ) % local_fmi.length();
+            checksum += rank( local_fmi, pos, uint8( i & 3 ) );
+        }
+    }
+
+    timer.stop();
+
+    // prevent the queries from being optimized away
+    if (checksum == uint64(-1))
+        fprintf(stderr, "  checksum: %llu\n", checksum);
+
+    return float( n_queries ) / timer.seconds();
+}
+
+// measure the host rank() throughput under each NUMA placement policy
+//
+void numa_rank_test(const char* index_file, const uint32 n_queries)
+{
+  #ifdef _OPENMP
+    omp_set_num_threads( omp_get_num_procs() );
+  #endif
+
+    typedef io::FMIndexData::partial_fm_index_type host_fmindex_type;
+
+    const uint32 n_nodes = numa_node_count();
+    fprintf(stderr, "  NUMA rank test (%u nodes, %u queries)\n", n_nodes, n_queries);
+
+    const char* policies[] = { "default", "interleave", "bind:0", "replicate" };
+
+    for (uint32 p = 0; p < 4; ++p)
+    {
+        NUMAPlacement placement;
+        parse_numa_placement( policies[p], &placement );
+
+        // replicas are built from a default-placed copy
+        io::FMIndexDataHost h_fmi;
+        if (h_fmi.load( index_file, io::FMIndexData::FORWARD, io::FMIndexData::OCC_INT,
+                        placement.policy == NUMA_REPLICATE ? NUMAPlacement() : placement ) == 0)
+        {
+            log_warning(stderr, "unable to load \"%s\"\n", index_file);
+            return;
+        }
+
+        numa_pin_omp_threads( placement );
+
+        std::vector<host_fmindex_type> fmis;
+        NUMAReplicas<io::FMIndexDataHost> replicas;
+        if (placement.policy == NUMA_REPLICATE)
+        {
+            replicas.build( h_fmi );
+            for (uint32 node = 0; node < replicas.size(); ++node)
+                fmis.push_back( replicas[node].partial_index() );
+        }
+        else
+            fmis.push_back( h_fmi.partial_index() );
+
+        const float ranks_per_sec = host_rank_throughput( &fmis[0], uint32( fmis.size() ), n_queries );
+
+        fprintf(stderr, "    %-10s : %7.2f M ranks/s\n", policies[p], ranks_per_sec * 1.0e-6f);
+    }
+
+    // leave the threads free to migrate again
+    numa_unpin_omp_threads();
+}
+
+// a functor matching and locating a set of seeds through whichever FMIndexDataView
+// dispatch_fmindex() selects for the intervals an index has been loaded with
+//
+struct IntervalQueries
+{
+    IntervalQueries(
+        const uint32    _n_seeds,
+        const uint32    _seed_len,
+        const uint8*    _seeds,
+        uint2*          _ranges,
+        uint32*         _locations) :
+        n_seeds( _n_seeds ),
+        seed_len( _seed_len ),
+        seeds( _seeds ),
+        ranges( _ranges ),
+        locations( _locations ) {}
+
+    template <typename view_type>
+    void operator() (const view_type& view)
+    {
+        typedef typename view_type::fm_index_type   fm_index_type;
+        typedef typename fm_index_type::range_type  range_type;
+
+        const fm_index_type fmi = view.index();
+
+        for (uint32 i = 0; i < n_seeds; ++i)
+        {
+            const range_type range = match( fmi, seeds + i*seed_len, seed_len );
+
+            ranges[i]    = make_uint2( uint32( range.x ), uint32( range.y ) );
+            locations[i] = range.x <= range.y ? uint32( locate( fmi, range.x ) ) : uint32(-1);
+        }
+    }
+
+    const uint32    n_seeds;
+    const uint32    seed_len;
+    const uint8*    seeds;
+    uint2*          ranges;
+    uint32*         locations;
+};
+
+// load an index with each supported occurrence table interval, and check that matching and
+// locating a set of random seeds through dispatch_fmindex() gives the same results as with
+// the default interval
+//
+void interval_test(const char* index_file, const uint32 n_queries)
+{
+    const uint32 SEED_LEN = 14u;
+
+    fprintf(stderr, "  interval test (%u queries)\n", n_queries);
+
+    std::vector<uint8> seeds( uint64(n_queries) * SEED_LEN );
+    for (uint32 i = 0; i < n_queries * SEED_LEN; ++i)
+        seeds[i] = uint8( rand() % 4 );
+
+    std::vector<uint2>  ref_ranges( n_queries );
+    std::vector<uint32> ref_locations( n_queries );
+    std::vector<uint2>  ranges( n_queries );
+    std::vector<uint32> locations( n_queries );
+
+    // the default interval goes first, and provides the reference results
+    const uint32 intervals[] = { io::FMIndexData::OCC_INT, 32u, 128u, 256u };
+
+    for (uint32 k = 0; k < sizeof(intervals) / sizeof(intervals[0]); ++k)
+    {
+        io::FMIndexDataHost h_fmi;
+        if (h_fmi.load( index_file, io::FMIndexData::FORWARD | io::FMIndexData::SA, intervals[k] ) == 0)
+        {
+            log_warning(stderr, "unable to load \"%s\"\n", index_file);
+            return;
+        }
+
+        IntervalQueries queries(
+            n_queries,
+            SEED_LEN,
+            &seeds[0],
+            k ? &ranges[0]    : &ref_ranges[0],
+            k ? &locations[0] : &ref_locations[0] );
+
+        if (io::dispatch_fmindex( h_fmi, queries ) == false)
+        {
+            fprintf(stderr, "  \nerror : unsupported intervals (occ %u, sa %u)\n", h_fmi.occ_intv(), h_fmi.sa_intv() );
+            exit(1);
+        }
+
+        for (uint32 i = 0; k && i < n_queries; ++i)
+        {
+            if (ranges[i].x    != ref_ranges[i].x ||
+                ranges[i].y    != ref_ranges[i].y ||
+                locations[i]   != ref_locations[i])
+            {
+                fprintf(stderr, "  \nerror : occ %u, seed %u resulted in (%u,%u) at %u, expected (%u,%u) at %u\n", h_fmi.occ_intv(), i,
+                    ranges[i].x,     ranges[i].y,     locations[i],
+                    ref_ranges[i].x, ref_ranges[i].y, ref_locations[i] );
+                exit(1);
+            }
+        }
+
+        fprintf(stderr, "    occ %3u, sa %2u : ok\n", h_fmi.occ_intv(), h_fmi.sa_intv());
+    }
+}
+
 int fmindex_test(int argc, char* argv[])
 {
     uint32 synth_len     = 10000000;
@@ -1009,6 +1321,8 @@ int fmindex_test(int argc, char* argv[])
     char*  index_name        = "./data/human.NCBI36/Homo_sapiens.NCBI36.53.dna.toplevel.fa";
     char*  reads_name        = "./data/SRR493095_1.fastq.gz";
     uint32 backtrack_queries = 64*1024;
+    uint32 numa_queries      = 0;
+    uint32 interval_queries  = 0;
 
     for (int i = 0; i < argc; ++i)
     {
@@ -1022,6 +1336,10 @@ int fmindex_test(int argc, char* argv[])
             index_name = argv[++i];
         else if (strcmp( argv[i], "-reads" ) == 0)
             reads_name = argv[++i];
+        else if (strcmp( argv[i], "-numa-queries" ) == 0)
+            numa_queries = atoi( argv[++i] ) * 1024;
+        else if (strcmp( argv[i], "-interval-queries" ) == 0)
+            interval_queries = atoi( argv[++i] ) * 1024;
     }
 
     fprintf(stderr, "FM-index test... started\n");
@@ -1035,6 +1353,12 @@ int fmindex_test(int argc, char* argv[])
     if (backtrack_queries)
         backtrack_test( index_name, reads_name, backtrack_queries );
 
+    if (numa_queries)
+        numa_rank_test( index_name, numa_queries );
+
+    if (interval_queries)
+        interval_test( index_name, interval_queries );
+
     fprintf(stderr, "FM-index test... done\n");
     return 0;
 }
@@ -0,0 +1,204 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// histogram_test.cpp
+//
+
+#include <nvbio/basic/histogram.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/console.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace nvbio {
+
+namespace {
+
+// the i-th test value, spread log-uniformly over [1, 2^40)
+//
+uint64 test_value(const uint32 i)
+{
+    const uint32 h1 = i * 2654435761u;
+    const uint32 h2 = (i + 1u) * 2246822519u;
+    const uint32 e  = (h1 >> 8) % 40u;
+    return (uint64(1u) << e) + (((uint64(h2) << 32) | h1) & ((uint64(1u) << e) - 1u));
+}
+
+// check that a reported value is within the histogram's precision from the exact one
+//
+bool check_value(const char* name, const uint64 value, const uint64 exact)
+{
+    const double error = exact ? (double(value) - double(exact)) / double(exact) : double(value);
+    if (value < exact || error > 1.0 / double(LogLinearHistogram::SUB_BUCKETS))
+    {
+        log_error(stderr, "  %s: %llu, expected %llu (error %.4f)\n", name, value, exact, error);
+        return false;
+    }
+    return true;
+}
+
+// check that a reported time is within the histogram's precision from the exact one,
+// allowing for the rounding of the float to nanoseconds conversion
+//
+bool check_time(const float value, const float exact)
+{
+    return value >= exact * (1.0f - 1.0e-5f) &&
+           value <= exact * (1.0f + 1.0f / float(LogLinearHistogram::SUB_BUCKETS) + 1.0e-5f);
+}
+
+} // anonymous namespace
+
+int histogram_test()
+{
+    log_info(stderr, "histogram test... started\n");
+
+    // check the bucket boundaries
+    for (uint32 b = 0; b < LogLinearHistogram::N_BUCKETS; ++b)
+    {
+        const uint64 begin = LogLinearHistogram::bucket_begin( b );
+        const uint64 last  = LogLinearHistogram::bucket_last( b );
+        if (LogLinearHistogram::bucket( begin ) != b ||
+            LogLinearHistogram::bucket( last )  != b ||
+            (b && LogLinearHistogram::bucket_last( b-1 ) + 1u != begin))
+        {
+            log_error(stderr, "  bucket %u: [%llu, %llu] not contiguous\n", b, begin, last);
+            return 1;
+        }
+    }
+    if (LogLinearHistogram::bucket( uint64(-1) ) != LogLinearHistogram::N_BUCKETS-1)
+    {
+        log_error(stderr, "  overflowing values not clamped\n");
+        return 1;
+    }
+
+    const uint32 n_values = 8*1024*1024;
+
+    std::vector<uint64> values( n_values );
+    for (uint32 i = 0; i < n_values; ++i)
+        values[i] = test_value(i);
+
+    // record all values from multiple threads into a single shared histogram
+    LogLinearHistogram shared;
+    {
+        Timer timer;
+        timer.start();
+
+      #if defined(_OPENMP)
+        #pragma omp parallel for
+      #endif
+        for (int i = 0; i < int( n_values ); ++i)
+            shared.add( values[i] );
+
+        timer.stop();
+        log_info(stderr, "  shared add  : %7.1f M values/s\n", 1.0e-6f * float(n_values) / timer.seconds());
+    }
+
+    // record all values into per-thread histograms, and merge them
+    LogLinearHistogram merged;
+    {
+        Timer timer;
+        timer.start();
+
+      #if defined(_OPENMP)
+        #pragma omp parallel
+      #endif
+        {
+            LogLinearHistogram local;
+
+          #if defined(_OPENMP)
+            #pragma omp for
+          #endif
+            for (int i = 0; i < int( n_values ); ++i)
+                local.add( values[i] );
+
+            merged.merge( local );
+        }
+
+        timer.stop();
+        log_info(stderr, "  merged add  : %7.1f M values/s\n", 1.0e-6f * float(n_values) / timer.seconds());
+    }
+
+    // compare the two against the exact percentiles
+    std::sort( values.begin(), values.end() );
+
+    uint64 sum = 0u;
+    for (uint32 i = 0; i < n_values; ++i)
+        sum += values[i];
+
+    const LogLinearHistogram* histograms[2]      = { &shared, &merged };
+    const char*               histogram_names[2] = { "shared", "merged" };
+    for (uint32 h = 0; h < 2; ++h)
+    {
+        const LogLinearHistogram& histogram = *histograms[h];
+
+        if (histogram.count() != n_values || histogram.sum() != sum)
+        {
+            log_error(stderr, "  %s: %llu values (sum %llu), expected %u (sum %llu)\n",
+                histogram_names[h], histogram.count(), histogram.sum(), n_values, sum);
+            return 1;
+        }
+
+        const float percentiles[4] = { 0.5f, 0.9f, 0.99f, 0.999f };
+        for (uint32 p = 0; p < 4; ++p)
+        {
+            const uint64 rank = uint64( ceil( double( percentiles[p] ) * double( n_values ) ) );
+            if (check_value( histogram_names[h], histogram.percentile( percentiles[p] ), values[ rank-1 ] ) == false)
+                return 1;
+        }
+        if (check_value( histogram_names[h], histogram.max(), values.back() ) == false ||
+            histogram.min() > values.front())
+            return 1;
+    }
+
+    log_info(stderr, "  p50: %llu, p90: %llu, p99: %llu, p999: %llu\n",
+        shared.percentile( 0.5f ),
+        shared.percentile( 0.9f ),
+        shared.percentile( 0.99f ),
+        shared.percentile( 0.999f ));
+
+    // check the TimeSeries latency tracking
+    {
+        TimeSeries series;
+        TimeSeries other;
+        for (uint32 i = 1; i <= 1000; ++i)
+        {
+            series.add( 1u, 1.0e-3f * float(i) );
+            other.add( 1u, 1.0e-3f * float(i + 1000) );
+        }
+        series.merge( other );
+
+        const float p50 = series.latency_percentile( 0.5f );
+        const float p99 = series.latency_percentile( 0.99f );
+        if (series.num != 2000 || check_time( p50, 1.0f ) == false || check_time( p99, 1.98f ) == false)
+        {
+            log_error(stderr, "  time series: p50 %.3f s, p99 %.3f s, expected 1.000 s and 1.980 s\n", p50, p99);
+            return 1;
+        }
+    }
+
+    log_info(stderr, "histogram test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
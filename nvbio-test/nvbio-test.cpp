@@ -45,6 +45,12 @@ int string_set_test(int argc, char* argv[]);
 int sum_tree_test();
 int qgram_test(int argc, char* argv[]);
 int sequence_test(int argc, char* argv[]);
+int primitives_test(int argc, char* argv[]);
+int vector_array_test();
+int bloom_filter_test();
+int histogram_test();
+int dedup_test();
+int smem_test();
 
 namespace cuda { void scan_test(); }
 namespace aln { void test(int argc, char* argv[]); }
@@ -71,6 +77,12 @@ enum Tests {
     kRank           = 32768u,
     kQGram          = 65536u,
     kSequence       = 131072u,
+    kPrimitives     = 262144u,
+    kVectorArray    = 524288u,
+    kBloomFilter    = 1048576u,
+    kHistogram      = 2097152u,
+    kDedup          = 4194304u,
+    kSMEM           = 8388608u,
     kALL            = 0xFFFFFFFFu
 };
 
@@ -128,6 +140,18 @@ int main(int argc, char* argv[])
                 tests = kWorkQueue;
             else if (strcmp( argv[arg], "-sequence" ) == 0)
                 tests = kSequence;
+            else if (strcmp( argv[arg], "-primitives" ) == 0)
+                tests = kPrimitives;
+            else if (strcmp( argv[arg], "-vector-array" ) == 0)
+                tests = kVectorArray;
+            else if (strcmp( argv[arg], "-bloom-filter" ) == 0)
+                tests = kBloomFilter;
+            else if (strcmp( argv[arg], "-histogram" ) == 0)
+                tests = kHistogram;
+            else if (strcmp( argv[arg], "-dedup" ) == 0)
+                tests = kDedup;
+            else if (strcmp( argv[arg], "-smem" ) == 0)
+                tests = kSMEM;
 
             ++arg;
         }
@@ -191,6 +215,12 @@ int main(int argc, char* argv[])
     if (tests & kFMIndex)       fmindex_test( argc, argv+arg );
     if (tests & kQGram)         qgram_test( argc, argv+arg );
     if (tests & kSequence)      sequence_test( argc, argv+arg );
+    if (tests & kPrimitives)    primitives_test( argc, argv+arg );
+    if (tests & kVectorArray)   vector_array_test();
+    if (tests & kBloomFilter)   bloom_filter_test();
+    if (tests & kHistogram)     histogram_test();
+    if (tests & kDedup)         dedup_test();
+    if (tests & kSMEM)          smem_test();
 
     cudaDeviceReset();
 	return 0;
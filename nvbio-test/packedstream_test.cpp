@@ -26,6 +26,8 @@
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/cached_iterator.h>
 #include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/timer.h>
+#include <vector>
 #include <sais.h>
 
 using namespace nvbio;
@@ -46,6 +48,153 @@ bool check_stream(const uint8* uncomp_stream, const CompStream& comp_stream)
     return true;
 }
 
+// test the word-parallel assign(), lcp() and compare() functions against their symbol-by-symbol definitions,
+// and time them on long streams
+//
+template <typename word_type, uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+bool bulk_test(const char* name)
+{
+    typedef PackedStream<const word_type*,uint8,SYMBOL_SIZE,BIG_ENDIAN> const_stream_type;
+    typedef PackedStream<word_type*,uint8,SYMBOL_SIZE,BIG_ENDIAN>       stream_type;
+
+    const uint32 SYMBOL_MASK      = (1u << SYMBOL_SIZE) - 1u;
+    const uint32 SYMBOLS_PER_WORD = uint32( 8u * sizeof(word_type) ) / SYMBOL_SIZE;
+    const uint32 N_WORDS          = 64;
+    const uint32 N_SYMBOLS        = N_WORDS * SYMBOLS_PER_WORD;
+
+    fprintf(stderr, "%s bulk test... started\n", name);
+
+    std::vector<word_type> in_words( N_WORDS );
+    std::vector<word_type> out_words( N_WORDS );
+    std::vector<uint8>     ref( N_SYMBOLS );
+
+    // randomized assign() test
+    for (uint32 r = 0; r < 10000; ++r)
+    {
+        const uint32 in_offset  = rand() % N_SYMBOLS;
+        const uint32 out_offset = rand() % N_SYMBOLS;
+        const uint32 len        = rand() % (N_SYMBOLS - nvbio::max( in_offset, out_offset ) + 1u);
+
+        stream_type       in_string( &in_words[0] );
+        const_stream_type in( &in_words[0] );
+        stream_type       out( &out_words[0] );
+        for (uint32 i = 0; i < N_SYMBOLS; ++i)
+        {
+            in_string[i] = uint8( rand() & SYMBOL_MASK );
+            ref[i] = uint8( rand() & SYMBOL_MASK );
+            out[i] = ref[i];
+        }
+        for (uint32 i = 0; i < len; ++i)
+            ref[ out_offset + i ] = in[ in_offset + i ];
+
+        assign( len, in + in_offset, out + out_offset );
+
+        for (uint32 i = 0; i < N_SYMBOLS; ++i)
+        {
+            if (out[i] != ref[i])
+            {
+                fprintf(stderr, "  assign(%u,%u,%u) error at %u : found %u, expected %u\n", len, in_offset, out_offset, i, uint32( out[i] ), uint32( ref[i] ));
+                return false;
+            }
+        }
+    }
+
+    // randomized lcp() and compare() test, on strings sharing long prefixes
+    for (uint32 r = 0; r < 10000; ++r)
+    {
+        const uint32 offset1 = rand() % N_SYMBOLS;
+        const uint32 offset2 = rand() % N_SYMBOLS;
+        const uint32 len1    = rand() % (N_SYMBOLS - offset1 + 1u);
+        const uint32 len2    = rand() % (N_SYMBOLS - offset2 + 1u);
+        const uint32 len     = nvbio::min( len1, len2 );
+
+        stream_type string1( &in_words[0] );
+        stream_type string2( &out_words[0] );
+        for (uint32 i = 0; i < N_SYMBOLS; ++i)
+            string1[i] = uint8( rand() & SYMBOL_MASK );
+        for (uint32 i = 0; i < N_SYMBOLS; ++i)
+            string2[i] = uint8( rand() & SYMBOL_MASK );
+
+        // copy a random prefix of the first string into the second
+        const uint32 prefix = rand() % (len + 1u);
+        for (uint32 i = 0; i < prefix; ++i)
+            string2[ offset2 + i ] = string1[ offset1 + i ];
+
+        uint32 ref_lcp = 0;
+        while (ref_lcp < len && string1[ offset1 + ref_lcp ] == string2[ offset2 + ref_lcp ])
+            ++ref_lcp;
+
+        const int32 ref_cmp =
+            ref_lcp < len ? (string1[ offset1 + ref_lcp ] < string2[ offset2 + ref_lcp ] ? -1 : 1) :
+            len1 < len2 ? -1 : len1 > len2 ? 1 : 0;
+
+        const uint32 out_lcp = lcp( len, string1 + offset1, string2 + offset2 );
+        const int32  out_cmp = compare( len1, string1 + offset1, len2, string2 + offset2 );
+        if (out_lcp != ref_lcp || out_cmp != ref_cmp)
+        {
+            fprintf(stderr, "  lcp/compare error : found (%u,%d), expected (%u,%d)\n", out_lcp, out_cmp, ref_lcp, ref_cmp);
+            return false;
+        }
+    }
+
+    // time the bulk functions against the symbol-by-symbol loops on long, unaligned streams
+    {
+        const uint32 N_BENCH_SYMBOLS = 16*1024*1024;
+        const uint32 N_BENCH_WORDS   = N_BENCH_SYMBOLS / SYMBOLS_PER_WORD + 1u;
+
+        std::vector<word_type> words1( N_BENCH_WORDS, word_type(0x12345678u) );
+        std::vector<word_type> words2( N_BENCH_WORDS, word_type(0u) );
+
+        stream_type string1( &words1[0] );
+        stream_type string2( &words2[0] );
+
+        const uint32 len = N_BENCH_SYMBOLS - SYMBOLS_PER_WORD;
+
+        Timer timer;
+
+        timer.start();
+        for (uint32 i = 0; i < len; ++i)
+            string2[ i + 3 ] = string1[ i + 1 ];
+        timer.stop();
+        const float symbol_copy_time = timer.seconds();
+
+        timer.start();
+        assign( len, string1 + 1u, string2 + 3u );
+        timer.stop();
+        const float bulk_copy_time = timer.seconds();
+
+        uint32 symbol_lcp = 0;
+        timer.start();
+        while (symbol_lcp < len && string1[ symbol_lcp + 1 ] == string2[ symbol_lcp + 3 ])
+            ++symbol_lcp;
+        timer.stop();
+        const float symbol_lcp_time = timer.seconds();
+
+        timer.start();
+        const uint32 bulk_lcp = lcp( len, string1 + 1u, string2 + 3u );
+        timer.stop();
+        const float bulk_lcp_time = timer.seconds();
+
+        if (symbol_lcp != len || bulk_lcp != len)
+        {
+            fprintf(stderr, "  lcp error : found %u, expected %u\n", bulk_lcp, len);
+            return false;
+        }
+
+        fprintf(stderr, "  copy : %7.1f M symbols/s symbol-by-symbol, %7.1f M symbols/s bulk (x%.1f)\n",
+            1.0e-6f * float(len) / symbol_copy_time,
+            1.0e-6f * float(len) / bulk_copy_time,
+            symbol_copy_time / bulk_copy_time);
+        fprintf(stderr, "  lcp  : %7.1f M symbols/s symbol-by-symbol, %7.1f M symbols/s bulk (x%.1f)\n",
+            1.0e-6f * float(len) / symbol_lcp_time,
+            1.0e-6f * float(len) / bulk_lcp_time,
+            symbol_lcp_time / bulk_lcp_time);
+    }
+
+    fprintf(stderr, "%s bulk test... done\n", name);
+    return true;
+}
+
 int packedstream_test()
 {
     {
@@ -381,5 +530,13 @@ int packedstream_test()
         fprintf(stderr, "2-bit uint4-stream test... done\n");
     }
 
+    if (bulk_test<uint32,2,true>( "2-bit uint32-stream" ) == false ||
+        bulk_test<uint32,2,false>( "2-bit uint32-stream (little-endian)" ) == false ||
+        bulk_test<uint64,2,true>( "2-bit uint64-stream" ) == false ||
+        bulk_test<uint32,4,false>( "4-bit uint32-stream (little-endian)" ) == false ||
+        bulk_test<uint64,4,true>( "4-bit uint64-stream" ) == false ||
+        bulk_test<uint8,2,true>( "2-bit byte-stream" ) == false)
+        exit(1);
+
 	return 0;
 }
@@ -0,0 +1,414 @@
+/*
+ * nvbio
+ * Copyright (C) 2011-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// primitives_test.cpp
+//
+
+#include <nvbio/basic/primitives.h>
+#include <nvbio/basic/sort.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+namespace nvbio {
+
+namespace {
+
+struct is_odd
+{
+    bool operator() (const uint32 x) const { return (x & 1u) != 0u; }
+};
+
+template <typename T>
+bool check(const char* name, const uint64 n, const T* ref, const T* out)
+{
+    for (uint64 i = 0; i < n; ++i)
+    {
+        if (ref[i] != out[i])
+        {
+            log_error(stderr, "  %s mismatch at %llu: expected %llu, got %llu\n", name, (unsigned long long)i, (unsigned long long)ref[i], (unsigned long long)out[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+void report(const char* name, const uint64 n, const float serial_time, const float parallel_time)
+{
+    fprintf(stderr, "    %-18s : serial %7.2f GB/s, parallel %7.2f GB/s (x%.1f)\n",
+        name,
+        1.0e-9f * float(n * sizeof(uint32)) / serial_time,
+        1.0e-9f * float(n * sizeof(uint32)) / parallel_time,
+        serial_time / parallel_time );
+}
+
+void report_sort(const char* name, const uint64 n, const float serial_time, const float parallel_time)
+{
+    fprintf(stderr, "    %-18s : std::sort %7.1f M keys/s, radix %7.1f M keys/s (x%.1f)\n",
+        name,
+        1.0e-6f * float(n) / serial_time,
+        1.0e-6f * float(n) / parallel_time,
+        serial_time / parallel_time );
+}
+
+// test the host primitives on n items against thrust's serial host algorithms, and
+// if requested, report the speed of both
+//
+bool test_primitives(const uint64 n, const uint32 n_runs, const bool bench)
+{
+    // pad all vectors by one item, so that their first element can be addressed for n = 0
+    std::vector<uint32> in( n+1 );
+    std::vector<uint32> keys( n+1 );
+    std::vector<uint8>  flags( n+1 );
+    std::vector<uint32> ref( n+1 );
+    std::vector<uint32> out( n+1 );
+    std::vector<uint32> ref_counts( n+1 );
+    std::vector<uint32> out_counts( n+1 );
+
+    // generate random values, and sorted keys with short, random length runs
+    for (uint64 i = 0; i < n; ++i)
+    {
+        in[i]    = rand() & 255u;
+        flags[i] = (rand() & 3) == 0;
+        keys[i]  = i ? keys[i-1] + ((rand() & 7) == 0 ? 1u : 0u) : 0u;
+    }
+
+    nvbio::vector<host_tag,uint8> temp_storage;
+
+    Timer timer;
+
+    // reduce
+    {
+        uint32 ref_r = 0, out_r = 0;
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            ref_r = thrust::reduce( in.begin(), in.begin() + n, 0u, thrust::plus<uint32>() );
+        timer.stop();
+        const float serial_time = timer.seconds();
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            out_r = reduce<host_tag>( n, &in[0], thrust::plus<uint32>(), temp_storage );
+        timer.stop();
+        const float parallel_time = timer.seconds();
+
+        if (ref_r != out_r)
+        {
+            log_error(stderr, "  reduce mismatch: expected %u, got %u\n", ref_r, out_r);
+            return false;
+        }
+        if (bench) report( "reduce", n * n_runs, serial_time, parallel_time );
+    }
+
+    // inclusive scan
+    {
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            thrust::inclusive_scan( in.begin(), in.begin() + n, ref.begin(), thrust::plus<uint32>() );
+        timer.stop();
+        const float serial_time = timer.seconds();
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            inclusive_scan<host_tag>( n, &in[0], &out[0], thrust::plus<uint32>(), temp_storage );
+        timer.stop();
+        const float parallel_time = timer.seconds();
+
+        if (check( "inclusive_scan", n, &ref[0], &out[0] ) == false)
+            return false;
+
+        if (bench) report( "inclusive_scan", n * n_runs, serial_time, parallel_time );
+    }
+
+    // exclusive scan
+    {
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            thrust::exclusive_scan( in.begin(), in.begin() + n, ref.begin(), 0u, thrust::plus<uint32>() );
+        timer.stop();
+        const float serial_time = timer.seconds();
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            exclusive_scan<host_tag>( n, &in[0], &out[0], thrust::plus<uint32>(), 0u, temp_storage );
+        timer.stop();
+        const float parallel_time = timer.seconds();
+
+        if (check( "exclusive_scan", n, &ref[0], &out[0] ) == false)
+            return false;
+
+        if (bench) report( "exclusive_scan", n * n_runs, serial_time, parallel_time );
+    }
+
+    // copy flagged
+    {
+        uint64 ref_n = 0, out_n = 0;
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            ref_n = thrust::copy_if( in.begin(), in.begin() + n, flags.begin(), ref.begin(), nvbio::is_true_functor<bool>() ) - ref.begin();
+        timer.stop();
+        const float serial_time = timer.seconds();
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            out_n = copy_flagged<host_tag>( n, &in[0], &flags[0], &out[0], temp_storage );
+        timer.stop();
+        const float parallel_time = timer.seconds();
+
+        if (ref_n != out_n || check( "copy_flagged", ref_n, &ref[0], &out[0] ) == false)
+            return false;
+
+        if (bench) report( "copy_flagged", n * n_runs, serial_time, parallel_time );
+    }
+
+    // copy if
+    {
+        uint64 ref_n = 0, out_n = 0;
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            ref_n = thrust::copy_if( in.begin(), in.begin() + n, ref.begin(), is_odd() ) - ref.begin();
+        timer.stop();
+        const float serial_time = timer.seconds();
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            out_n = copy_if<host_tag>( n, &in[0], &out[0], is_odd(), temp_storage );
+        timer.stop();
+        const float parallel_time = timer.seconds();
+
+        if (ref_n != out_n || check( "copy_if", ref_n, &ref[0], &out[0] ) == false)
+            return false;
+
+        if (bench) report( "copy_if", n * n_runs, serial_time, parallel_time );
+    }
+
+    // run-length encode
+    {
+        uint64 ref_n = 0, out_n = 0;
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+        {
+            ref_n = thrust::reduce_by_key(
+                keys.begin(),
+                keys.begin() + n,
+                thrust::make_constant_iterator<uint32>( 1u ),
+                ref.begin(),
+                ref_counts.begin() ).first - ref.begin();
+        }
+        timer.stop();
+        const float serial_time = timer.seconds();
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            out_n = runlength_encode<host_tag>( n, &keys[0], &out[0], &out_counts[0], temp_storage );
+        timer.stop();
+        const float parallel_time = timer.seconds();
+
+        if (ref_n != out_n ||
+            check( "runlength_encode", ref_n, &ref[0], &out[0] ) == false ||
+            check( "runlength_encode", ref_n, &ref_counts[0], &out_counts[0] ) == false)
+            return false;
+
+        if (bench) report( "runlength_encode", n * n_runs, serial_time, parallel_time );
+    }
+
+    // reduce by key
+    {
+        uint64 ref_n = 0, out_n = 0;
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+        {
+            ref_n = thrust::reduce_by_key(
+                keys.begin(),
+                keys.begin() + n,
+                in.begin(),
+                ref.begin(),
+                ref_counts.begin(),
+                nvbio::equal_functor<uint32>(),
+                thrust::plus<uint32>() ).first - ref.begin();
+        }
+        timer.stop();
+        const float serial_time = timer.seconds();
+
+        timer.start();
+        for (uint32 r = 0; r < n_runs; ++r)
+            out_n = reduce_by_key<host_tag>( n, &keys[0], &in[0], &out[0], &out_counts[0], thrust::plus<uint32>(), temp_storage );
+        timer.stop();
+        const float parallel_time = timer.seconds();
+
+        if (ref_n != out_n ||
+            check( "reduce_by_key", ref_n, &ref[0], &out[0] ) == false ||
+            check( "reduce_by_key", ref_n, &ref_counts[0], &out_counts[0] ) == false)
+            return false;
+
+        if (bench) report( "reduce_by_key", n * n_runs, serial_time, parallel_time );
+    }
+
+    // radix sort
+    {
+        std::vector<uint64> keys64( n+1 );
+        std::vector<uint64> ref64( n+1 );
+        std::vector<uint64> temp64( n+1 );
+        std::vector<uint32> values( n+1 );
+        std::vector<uint32> temp_values( n+1 );
+
+        for (uint64 i = 0; i < n; ++i)
+            keys64[i] = (uint64( rand() ) << 32) ^ (uint64( rand() ) << 11) ^ uint64( rand() );
+
+        HostSortEnactor sort_enactor;
+
+        // 64-bit keys
+        {
+            float serial_time   = 0.0f;
+            float parallel_time = 0.0f;
+
+            cuda::SortBuffers<uint64*> sort_buffers;
+            for (uint32 r = 0; r < n_runs; ++r)
+            {
+                ref64 = keys64;
+                timer.start();
+                std::sort( ref64.begin(), ref64.begin() + n );
+                timer.stop();
+                serial_time += timer.seconds();
+
+                std::vector<uint64> in64( keys64 );
+
+                sort_buffers.selector = 0;
+                sort_buffers.keys[0]  = &in64[0];
+                sort_buffers.keys[1]  = &temp64[0];
+
+                timer.start();
+                sort_enactor.sort( n, sort_buffers );
+                timer.stop();
+                parallel_time += timer.seconds();
+
+                if (check( "sort(uint64)", n, &ref64[0], sort_buffers.current_keys() ) == false)
+                    return false;
+            }
+            if (bench) report_sort( "sort(uint64)", n * n_runs, serial_time, parallel_time );
+        }
+
+        // 32-bit key-value pairs, sorting on the lowest 24 bits only
+        {
+            float serial_time   = 0.0f;
+            float parallel_time = 0.0f;
+
+            std::vector< std::pair<uint32,uint32> > ref_pairs( n+1 );
+
+            cuda::SortBuffers<uint32*,uint32*> sort_buffers;
+            for (uint32 r = 0; r < n_runs; ++r)
+            {
+                for (uint64 i = 0; i < n; ++i)
+                {
+                    ref_pairs[i] = std::make_pair( uint32( keys64[i] ) & 0xFFFFFFu, uint32(i) );
+                    in[i]        = uint32( keys64[i] );
+                    values[i]    = uint32(i);
+                }
+
+                timer.start();
+                std::sort( ref_pairs.begin(), ref_pairs.begin() + n ); // (key,index) pairs: same as a stable sort
+                timer.stop();
+                serial_time += timer.seconds();
+
+                sort_buffers.selector  = 0;
+                sort_buffers.keys[0]   = &in[0];
+                sort_buffers.keys[1]   = &out[0];
+                sort_buffers.values[0] = &values[0];
+                sort_buffers.values[1] = &temp_values[0];
+
+                timer.start();
+                sort_enactor.sort( n, sort_buffers, 0u, 24u );
+                timer.stop();
+                parallel_time += timer.seconds();
+
+                const uint32* sorted_values = sort_buffers.current_values();
+                for (uint64 i = 0; i < n; ++i)
+                {
+                    if (sorted_values[i] != ref_pairs[i].second)
+                    {
+                        log_error(stderr, "  sort(uint32,uint32) mismatch at %llu\n", (unsigned long long)i);
+                        return false;
+                    }
+                }
+            }
+            if (bench) report_sort( "sort(uint32,uint32)", n * n_runs, serial_time, parallel_time );
+        }
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+// test the host primitives against thrust's serial host algorithms on small and odd sizes,
+// straddling the chunk boundaries, and optionally benchmark them on a large input
+//
+int primitives_test(int argc, char* argv[])
+{
+    uint64 bench_n = 0;             // the benchmark only runs if asked for with -length, as it needs ~2 GB
+    uint32 n_runs  = 4;
+
+    for (int i = 0; i < argc; ++i)
+    {
+        if (strcmp( argv[i], "-length" ) == 0)
+            bench_n = uint64( atoi( argv[++i] ) ) * 1024*1024;
+        else if (strcmp( argv[i], "-runs" ) == 0)
+            n_runs = atoi( argv[++i] );
+    }
+
+    fprintf(stderr, "primitives test... started\n");
+    fprintf(stderr, "  threads : %d\n", omp_get_max_threads());
+
+    const uint64 chunk = priv::HOST_PRIMITIVES_MIN_CHUNK;
+    const uint64 sizes[] = {
+        0u, 1u, 2u, 3u, 17u, 1000u,
+        chunk - 1u, chunk, chunk + 1u,
+        3u*chunk + 5u,
+        1024u*1024u + 7u };
+
+    for (uint32 i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i)
+    {
+        if (test_primitives( sizes[i], 1u, false ) == false)
+        {
+            log_error(stderr, "  failed on %llu items\n", sizes[i]);
+            return 1;
+        }
+    }
+
+    if (bench_n)
+    {
+        fprintf(stderr, "  items   : %.1f M\n", float(bench_n) / float(1024*1024));
+        if (test_primitives( bench_n, n_runs, true ) == false)
+            return 1;
+    }
+
+    fprintf(stderr, "primitives test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
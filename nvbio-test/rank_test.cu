@@ -39,6 +39,8 @@
 #include <nvbio/basic/deinterleaved_iterator.h>
 #include <nvbio/fmindex/bwt.h>
 #include <nvbio/fmindex/rank_dictionary.h>
+#include <nvbio/fmindex/cacheline_rank_dictionary.h>
+#include <nvbio/fmindex/rle_rank_dictionary.h>
 
 namespace nvbio {
 namespace { // anonymous namespace
@@ -227,22 +229,289 @@ void synthetic_test(const uint32 LEN)
     }
 }
 
+// measure the latency and throughput of rank() queries on a given dictionary, and report
+// them together with its memory footprint
+//
+template <typename rank_dict_type>
+void rank_timing(
+    const char*                         name,
+    const rank_dict_type&               dict,
+    const uint32                        LEN,
+    const uint64                        bytes,
+    const thrust::host_vector<uint32>&  queries)
+{
+    const uint32 n_queries = uint32( queries.size() );
+
+    Timer timer;
+
+    // measure the throughput of independent queries
+    uint32 sum = 0;
+    timer.start();
+    for (uint32 i = 0; i < n_queries; ++i)
+        sum += rank( dict, queries[i], i & 3u );
+    timer.stop();
+    const float throughput_time = timer.seconds();
+
+    // measure the latency of a chain of dependent queries
+    uint32 pos = queries[0];
+    timer.start();
+    for (uint32 i = 0; i < n_queries; ++i)
+        pos = (queries[i] + rank( dict, pos, i & 3u )) % LEN;
+    timer.stop();
+    const float latency_time = timer.seconds();
+
+    fprintf(stderr, "    %-13s : %5.2f bits/bp, %7.1f MB, latency %6.1f ns, throughput %6.1f M rank/s  (%u)\n",
+        name,
+        float( 8u * bytes ) / float( LEN ),
+        float( bytes ) / float(1024*1024),
+        1.0e9f * latency_time / float(n_queries),
+        1.0e-6f * float(n_queries) / throughput_time,
+        (sum + pos) & 1u );
+}
+
+// fill a random text and a text made of runs of up to 1000 equal symbols, the latter stressing
+// the packed counters of all dictionaries
+//
+void build_texts(
+    const uint32                    LEN,
+    thrust::host_vector<uint32>&    text_storage,
+    thrust::host_vector<uint32>&    runs_storage)
+{
+    const uint32 WORDS = align<4>( (LEN+15)/16 );
+
+    text_storage.assign( WORDS, 0u );
+    runs_storage.assign( WORDS, 0u );
+
+    typedef PackedStream<uint32*,uint8,2,true> stream_type;
+    stream_type text( nvbio::plain_view( text_storage ) );
+    stream_type runs( nvbio::plain_view( runs_storage ) );
+
+    for (uint32 i = 0; i < LEN; ++i)
+        text[i] = (rand() % 4);
+
+    for (uint32 i = 0; i < LEN;)
+    {
+        const uint8  c = rand() % 4;
+        const uint32 n = nvbio::min( uint32( 1u + rand() % 1000 ), LEN - i );
+        for (uint32 j = 0; j < n; ++j)
+            runs[i+j] = c;
+
+        i += n;
+    }
+}
+
+// build a rank dictionary with a given occurrence table interval over a text, using the same
+// BWT/occurrence table layout io::FMIndexDataView adopts for non-default intervals
+//
+template <uint32 OCC_INT>
+struct OccRankDictionary
+{
+    typedef PackedStream<const uint32*,uint8,2,true> stream_type;
+    typedef rank_dictionary<2u, OCC_INT, stream_type, const uint32*, const uint32*> rank_dict_type;
+
+    OccRankDictionary(
+        const uint32                        LEN,
+        const thrust::host_vector<uint32>&  text_storage,
+        const thrust::host_vector<uint32>&  count_table) :
+        occ( ((LEN+OCC_INT-1) / OCC_INT) * 4, 0u )
+    {
+        const stream_type text( nvbio::plain_view( text_storage ) );
+
+        build_occurrence_table<OCC_INT>(
+            text.begin(),
+            text.begin() + LEN,
+            &occ[0],
+            (uint32*)NULL );
+
+        dict = rank_dict_type(
+            text,
+            nvbio::plain_view( occ ),
+            nvbio::plain_view( count_table ) );
+    }
+
+    uint64 bytes(const uint32 LEN) const { return uint64( align<4>( (LEN+15)/16 ) + occ.size() ) * sizeof(uint32); }
+
+    thrust::host_vector<uint32> occ;
+    rank_dict_type              dict;
+};
+
+// check the rank dictionaries with all the occurrence table intervals supported by the FM-index
+// loaders, as well as the cache-line blocked and the run-length encoded dictionaries, on a random
+// and a run-heavy text
+//
+void rank_check(const uint32 LEN)
+{
+    fprintf(stderr, "  rank dictionaries check (%u K bps)\n", LEN / 1000);
+
+    thrust::host_vector<uint32> text_storage;
+    thrust::host_vector<uint32> runs_storage;
+    thrust::host_vector<uint32> count_table( 256 );
+
+    build_texts( LEN, text_storage, runs_storage );
+
+    // generate the count table
+    gen_bwt_count_table( nvbio::plain_view( count_table ) );
+
+    typedef PackedStream<const uint32*,uint8,2,true> stream_type;
+
+    for (uint32 t = 0; t < 2; ++t)
+    {
+        const thrust::host_vector<uint32>& storage = t == 0 ? text_storage : runs_storage;
+
+        do_test( LEN, OccRankDictionary<32>(  LEN, storage, count_table ).dict );
+        do_test( LEN, OccRankDictionary<64>(  LEN, storage, count_table ).dict );
+        do_test( LEN, OccRankDictionary<128>( LEN, storage, count_table ).dict );
+        do_test( LEN, OccRankDictionary<256>( LEN, storage, count_table ).dict );
+
+        const stream_type text( nvbio::plain_view( storage ) );
+
+        CacheLineRankDictionaryHost cacheline_dict;
+        cacheline_dict.build( text.begin(), text.begin() + LEN );
+        do_test( LEN, cacheline_dict.dictionary() );
+
+        std::vector<uint8> rle_runs( LEN );
+
+        RLERankDictionaryHost rle_dict;
+        rle_dict.build( rle_runs.begin(), rle_runs.begin() + rle_encode( LEN, text.begin(), &rle_runs[0] ) );
+        do_test( uint64( LEN ), rle_dict.dictionary() );
+    }
+}
+
+// benchmark a rank dictionary with a given occurrence table interval, reporting its memory
+// footprint together with the latency and throughput of rank() queries
+//
+template <uint32 OCC_INT>
+void rank_benchmark(
+    const uint32                        LEN,
+    const thrust::host_vector<uint32>&  text_storage,
+    const thrust::host_vector<uint32>&  count_table,
+    const thrust::host_vector<uint32>&  queries)
+{
+    const OccRankDictionary<OCC_INT> occ_dict( LEN, text_storage, count_table );
+
+    char name[16];
+    sprintf( name, "occ-%u", OCC_INT );
+
+    rank_timing( name, occ_dict.dict, LEN, occ_dict.bytes( LEN ), queries );
+}
+
+// benchmark rank() latency against memory for all the occurrence table intervals
+// supported by the FM-index loaders
+//
+void rank_benchmark_matrix(const uint32 LEN, const uint32 N_QUERIES)
+{
+    fprintf(stderr, "  rank benchmark (%u M bps, %u M queries)\n", LEN / 1000000, N_QUERIES / 1000000);
+
+    const uint32 WORDS = align<4>( (LEN+15)/16 );
+
+    thrust::host_vector<uint32> text_storage;
+    thrust::host_vector<uint32> runs_storage;
+    thrust::host_vector<uint32> count_table( 256 );
+    thrust::host_vector<uint32> queries( N_QUERIES );
+
+    build_texts( LEN, text_storage, runs_storage );
+
+    for (uint32 i = 0; i < N_QUERIES; ++i)
+        queries[i] = uint32( (uint64(rand()) * uint64(RAND_MAX) + uint64(rand())) % LEN );
+
+    // generate the count table
+    gen_bwt_count_table( nvbio::plain_view( count_table ) );
+
+    // compare the fused 32-byte BWT/occurrence groups used by io::FMIndexData with
+    // 64-byte cache-line blocks
+    {
+        const uint32 OCC_WORDS = ((LEN+63) / 64) * 4;
+
+        thrust::host_vector<uint32> occ( OCC_WORDS, 0u );
+        thrust::host_vector<uint32> bwt_occ( WORDS + OCC_WORDS, 0u );
+
+        typedef PackedStream<const uint32*,uint8,2,true> stream_type;
+        const stream_type text( nvbio::plain_view( text_storage ) );
+
+        build_occurrence_table<64>(
+            text.begin(),
+            text.begin() + LEN,
+            &occ[0],
+            (uint32*)NULL );
+
+        // fuse the BWT & OCC vectors
+        for (uint32 w = 0; w < WORDS; w += 4)
+        {
+            for (uint32 j = 0; j < 4; ++j)
+            {
+                bwt_occ[ w*2+j ]   = text_storage[ w+j ];
+                bwt_occ[ w*2+4+j ] = occ[ w+j ];
+            }
+        }
+
+        typedef deinterleaved_iterator<2,0,const uint4*>                    bwt_type;
+        typedef deinterleaved_iterator<2,1,const uint4*>                    occ_type;
+        typedef PackedStream<bwt_type,uint8,2,true>                         bwt_stream_type;
+        typedef rank_dictionary<2u, 64u, bwt_stream_type, occ_type, const uint32*> fused_dict_type;
+
+        const uint4* bwt_occ_ptr = (const uint4*)nvbio::plain_view( bwt_occ );
+
+        const fused_dict_type fused_dict(
+            bwt_stream_type( bwt_type( bwt_occ_ptr ) ),
+            occ_type( bwt_occ_ptr ),
+            nvbio::plain_view( count_table ) );
+
+        CacheLineRankDictionaryHost cacheline_dict;
+        cacheline_dict.build( text.begin(), text.begin() + LEN );
+
+        rank_timing( "fused-32B",    fused_dict,                   LEN, uint64( WORDS + OCC_WORDS ) * sizeof(uint32), queries );
+        rank_timing( "cacheline-64B", cacheline_dict.dictionary(), LEN, cacheline_dict.allocated(),                        queries );
+
+        // and compare the run-length encoded dictionary on both the random and the run-heavy text
+        RLERankDictionaryHost rle_dict;
+        {
+            const stream_type runs( nvbio::plain_view( runs_storage ) );
+
+            std::vector<uint8> rle_runs( LEN );
+
+            rle_dict.build( rle_runs.begin(), rle_runs.begin() + rle_encode( LEN, text.begin(), &rle_runs[0] ) );
+            rank_timing( "rle",      rle_dict.dictionary(), LEN, rle_dict.allocated(), queries );
+
+            rle_dict.build( rle_runs.begin(), rle_runs.begin() + rle_encode( LEN, runs.begin(), &rle_runs[0] ) );
+            rank_timing( "rle-runs", rle_dict.dictionary(), LEN, rle_dict.allocated(), queries );
+        }
+    }
+
+    // and compare all the occurrence table intervals supported by the FM-index loaders
+    rank_benchmark<32>(  LEN, text_storage, count_table, queries );
+    rank_benchmark<64>(  LEN, text_storage, count_table, queries );
+    rank_benchmark<128>( LEN, text_storage, count_table, queries );
+    rank_benchmark<256>( LEN, text_storage, count_table, queries );
+}
+
 } // anonymous namespace
 
 int rank_test(int argc, char* argv[])
 {
-    uint32 len = 10000000;
+    uint32 len       = 10000000;
+    uint32 bench_len = 0;           // the rank benchmark only runs if asked for with -bench-length
+    uint32 n_queries = 4000000;
 
     for (int i = 0; i < argc; ++i)
     {
         if (strcmp( argv[i], "-length" ) == 0)
             len = atoi( argv[++i] )*1000;
+        else if (strcmp( argv[i], "-bench-length" ) == 0)
+            bench_len = atoi( argv[++i] )*1000;
+        else if (strcmp( argv[i], "-queries" ) == 0)
+            n_queries = atoi( argv[++i] )*1000;
     }
 
     fprintf(stderr, "rank test... started\n");
 
     synthetic_test( len );
 
+    // check all the rank dictionaries on a small input, regardless of the benchmark
+    rank_check( nvbio::min( len, 1000000u ) );
+
+    if (bench_len && n_queries)
+        rank_benchmark_matrix( bench_len, n_queries );
+
     fprintf(stderr, "rank test... done\n");
     return 0;
 }
@@ -28,13 +28,159 @@
 #include <nvbio/basic/dna.h>
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/sequence/sequence_mmap.h>
+#include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/io/sequence/sequence_pool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
 
 using namespace nvbio;
 
 namespace nvbio {
 
+namespace {
+
+// fill a batch with n_reads random reads of a given length
+//
+void fill_batch(io::SequenceDataHost& batch, const uint32 n_reads, const uint32 read_len)
+{
+    SharedPointer<io::SequenceDataEncoder> encoder( io::create_encoder( DNA_N, &batch ) );
+
+    std::vector<uint8> bps( read_len );
+    std::vector<uint8> qual( read_len, uint8('I') );
+
+    encoder->begin_batch();
+    for (uint32 i = 0; i < n_reads; ++i)
+    {
+        for (uint32 j = 0; j < read_len; ++j)
+            bps[j] = uint8( "ACGT"[ rand() & 3 ] );
+
+        char name[32];
+        sprintf( name, "read.%u", i );
+
+        encoder->push_back( read_len, name, &bps[0], &qual[0], io::Phred33, uint32(-1), io::SequenceDataEncoder::NO_OP );
+    }
+    encoder->end_batch();
+}
+
+// the storage pointers of a batch, which must stay put as long as it is not reallocated
+//
+struct BatchStorage
+{
+    BatchStorage(const io::SequenceDataHost& batch) :
+        sequence( nvbio::raw_pointer( batch.m_sequence_vec ) ),
+        qual( nvbio::raw_pointer( batch.m_qual_vec ) ),
+        name( nvbio::raw_pointer( batch.m_name_vec ) ),
+        sequence_index( nvbio::raw_pointer( batch.m_sequence_index_vec ) ),
+        name_index( nvbio::raw_pointer( batch.m_name_index_vec ) ) {}
+
+    bool operator== (const BatchStorage& other) const
+    {
+        return sequence       == other.sequence &&
+               qual           == other.qual &&
+               name           == other.name &&
+               sequence_index == other.sequence_index &&
+               name_index     == other.name_index;
+    }
+
+    const uint32* sequence;
+    const char*   qual;
+    const char*   name;
+    const uint32* sequence_index;
+    const uint32* name_index;
+};
+
+// check that the pool reserves enough storage for any batch as large as the largest one
+// recorded so far, so that refilling a batch never reallocates it, and that it grows
+// its batches again when a larger one shows up
+//
+bool sequence_pool_test()
+{
+    io::SequenceDataHostPool pool( 2u, 1.25f );
+
+    // load a first batch, and record it
+    fill_batch( pool[0], 1000u, 100u );
+    pool.record( 0u );
+
+    if (pool.n_batches() != 1u || pool.peak_bytes() != io::SequenceDataHostPool::bytes( pool[0] ))
+    {
+        log_error(stderr, "  pool: wrong statistics after the first batch\n");
+        return false;
+    }
+
+    // reserve the second batch, which must grow it in a single step
+    pool.reserve( 1u );
+    if (pool.n_grows() != 1u ||
+        pool[1].m_sequence_index_vec.size() < 1001u ||
+        pool[1].m_sequence_vec.size()       < pool[0].m_sequence_stream_words ||
+        pool[1].m_name_vec.size()           < pool[0].m_name_stream_len)
+    {
+        log_error(stderr, "  pool: the second batch has not been grown to fit the first one\n");
+        return false;
+    }
+
+    // refill it with a batch of the same size: this must not reallocate anything, nor grow it again
+    {
+        const BatchStorage storage( pool[1] );
+
+        fill_batch( pool[1], 1000u, 100u );
+        pool.record( 1u );
+        pool.reserve( 1u );
+
+        if (!(BatchStorage( pool[1] ) == storage) || pool.n_grows() != 1u)
+        {
+            log_error(stderr, "  pool: a batch of the same size has been reallocated\n");
+            return false;
+        }
+    }
+
+    // now load a larger batch: the peak must follow, and the other batch must be grown again
+    const uint64 old_peak = pool.peak_bytes();
+
+    fill_batch( pool[0], 3000u, 150u );
+    pool.record( 0u );
+
+    if (pool.n_batches() != 3u || pool.peak_bytes() <= old_peak || pool.peak_bytes() != io::SequenceDataHostPool::bytes( pool[0] ))
+    {
+        log_error(stderr, "  pool: wrong statistics after a larger batch\n");
+        return false;
+    }
+
+    pool.reserve( 1u );
+    if (pool.n_grows() != 2u)
+    {
+        log_error(stderr, "  pool: the second batch has not been grown to fit a larger batch\n");
+        return false;
+    }
+    {
+        const BatchStorage storage( pool[1] );
+
+        fill_batch( pool[1], 3000u, 150u );
+
+        if (!(BatchStorage( pool[1] ) == storage))
+        {
+            log_error(stderr, "  pool: a grown batch has been reallocated when refilled\n");
+            return false;
+        }
+    }
+
+    if (pool.reserved_bytes() < io::SequenceDataHostPool::bytes( pool[0] ) + io::SequenceDataHostPool::bytes( pool[1] ))
+    {
+        log_error(stderr, "  pool: %llu bytes reserved, less than in use\n", pool.reserved_bytes());
+        return false;
+    }
+
+    log_verbose(stderr, "  pool: %.1f MB peak, %.1f MB reserved, %llu grows over %llu batches\n",
+        float( pool.peak_bytes() ) / float(1024*1024),
+        float( pool.reserved_bytes() ) / float(1024*1024),
+        pool.n_grows(),
+        pool.n_batches() );
+    return true;
+}
+
+} // anonymous namespace
+
 
 int sequence_test(int argc, char* argv[])
 {
@@ -53,6 +199,9 @@ int sequence_test(int argc, char* argv[])
 
     try
     {
+        if (sequence_pool_test() == false)
+            return 0;
+
         if (index_name != NULL)
         {
             log_verbose(stderr, "  loading sequence file %s\n", index_name );
@@ -0,0 +1,327 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// smem_test.cu
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/packedstream.h>
+#include <nvbio/fmindex/bwt.h>
+#include <nvbio/fmindex/fmindex.h>
+#include <nvbio/fmindex/smem.h>
+#include <nvbio/strings/string_set.h>
+
+namespace nvbio {
+
+namespace { // anonymous namespace
+
+// an FM-index of a small text, built from scratch on the host
+//
+struct TestIndex
+{
+    static const uint32 OCC_INT = 64u;
+
+    typedef PackedStream<uint32*,uint8,2u,true,uint32>                              stream_type;
+    typedef PackedStream<const uint32*,uint8,2u,true,uint32>                        bwt_type;
+    typedef rank_dictionary<2u, OCC_INT, bwt_type, const uint32*, const uint32*>    rank_dict_type;
+    typedef fm_index<rank_dict_type, null_type>                                     fm_index_type;
+
+    // build the index of the given text
+    //
+    void build(const uint32 len, const uint8* text)
+    {
+        const uint32 n_words = util::divide_ri( len, 16u );
+
+        std::vector<uint32> text_words( n_words + 1u, 0u );
+        stream_type text_stream( &text_words[0] );
+        for (uint32 i = 0; i < len; ++i)
+            text_stream[i] = text[i];
+
+        // generate the suffix array
+        std::vector<int32> sa( len + 1u );
+        gen_sa( len, text_stream, &sa[0] );
+
+        bwt.resize( n_words + 1u, 0u );
+        occ.resize( util::divide_ri( len, OCC_INT ) * 4u, 0u );
+        L2.resize( 5u, 0u );
+        count_table.resize( 256u );
+
+        primary = gen_bwt_from_sa( len, text_stream, &sa[0], stream_type( &bwt[0] ) );
+
+        // build the occurrence table
+        build_occurrence_table<OCC_INT>(
+            stream_type( &bwt[0] ),
+            stream_type( &bwt[0] ) + len,
+            &occ[0],
+            &L2[1] );
+
+        // transform the L2 table into a cumulative sum
+        for (uint32 c = 0; c < 4; ++c)
+            L2[c+1] += L2[c];
+
+        gen_bwt_count_table( &count_table[0] );
+
+        length = len;
+    }
+
+    // return the FM-index
+    //
+    fm_index_type index() const
+    {
+        return fm_index_type(
+            length,
+            primary,
+            &L2[0],
+            rank_dict_type(
+                bwt_type( &bwt[0] ),
+                &occ[0],
+                &count_table[0] ),
+            null_type() );
+    }
+
+    uint32              length;
+    uint32              primary;
+    std::vector<uint32> bwt;
+    std::vector<uint32> occ;
+    std::vector<uint32> L2;
+    std::vector<uint32> count_table;
+};
+
+// a brute-force SMEM
+//
+struct RefSMEM
+{
+    uint32 begin;       // the span begin on the pattern
+    uint32 end;         // the span end on the pattern
+    uint32 count;       // the number of occurrences in the text
+};
+
+// find all SMEMs of a pattern scanning the text directly: for each begin b on the pattern,
+// E(b) is the largest end such that P[b,E(b)) occurs at least min_intv times in the text;
+// [b,E(b)) is right-maximal by construction, and it is left-maximal if E(b-1) < E(b).
+// As E() is non-decreasing, maximal spans cannot contain one another.
+//
+void find_smems_ref(
+    const uint32            text_len,
+    const uint8*            text,
+    const uint32            pattern_len,
+    const uint8*            pattern,
+    const uint32            min_intv,
+    const uint32            min_span,
+    std::vector<RefSMEM>&   smems)
+{
+    smems.clear();
+
+    uint32 prev_end = 0u;
+
+    std::vector<uint32> occ;
+    std::vector<uint32> next_occ;
+    for (uint32 b = 0; b < pattern_len; ++b)
+    {
+        // the occurrences of P[b,e), updated as e grows
+        occ.resize( text_len );
+        for (uint32 i = 0; i < text_len; ++i)
+            occ[i] = i;
+
+        uint32 e     = b;
+        uint32 count = 0u;
+        while (e < pattern_len)
+        {
+            next_occ.clear();
+            for (uint32 k = 0; k < occ.size(); ++k)
+            {
+                if (occ[k] + e - b < text_len && text[ occ[k] + e - b ] == pattern[e])
+                    next_occ.push_back( occ[k] );
+            }
+            if (next_occ.size() < min_intv)
+                break;
+
+            occ.swap( next_occ );
+            count = uint32( occ.size() );
+            ++e;
+        }
+
+        if (e > b && (b == 0u || prev_end < e) && e - b >= min_span)
+        {
+            const RefSMEM smem = { b, e, count };
+            smems.push_back( smem );
+        }
+        prev_end = e;
+    }
+}
+
+// generate a pattern: half of them are sampled from the text and mutated, the others
+// are random strings; a few Ns are sprinkled over both
+//
+void gen_pattern(
+    const uint32            text_len,
+    const uint8*            text,
+    const uint32            i,
+    std::vector<uint8>&     pattern)
+{
+    const uint32 len = 1u + rand() % 100u;
+
+    pattern.resize( len );
+    if (i & 1u)
+    {
+        const uint32 pos = rand() % (text_len - len);
+        for (uint32 j = 0; j < len; ++j)
+            pattern[j] = (rand() % 16u) ? text[ pos + j ] : uint8( rand() % 4u );
+    }
+    else
+    {
+        for (uint32 j = 0; j < len; ++j)
+            pattern[j] = uint8( rand() % 4u );
+    }
+
+    if (rand() % 4u == 0u)
+        pattern[ rand() % len ] = 4u;
+}
+
+} // anonymous namespace
+
+// check the host SMEM finder against a brute-force search on a small random text,
+// for a few combinations of the minimum SA interval and span, and of the number of lanes
+//
+int smem_test()
+{
+    log_info(stderr, "smem test... started\n");
+
+    const uint32 TEXT_LEN   = 4000u;
+    const uint32 N_PATTERNS = 1000u;
+
+    typedef TestIndex::fm_index_type                            fm_index_type;
+    typedef SMEMFinderHost<fm_index_type>                       smem_finder_type;
+    typedef smem_finder_type::rank_type                         rank_type;
+    typedef ConcatenatedStringSet<const uint8*,const uint32*>   string_set_type;
+
+    srand(0);
+
+    // build the text and its reverse
+    std::vector<uint8> text( TEXT_LEN );
+    std::vector<uint8> rtext( TEXT_LEN );
+    for (uint32 i = 0; i < TEXT_LEN; ++i)
+        text[i] = uint8( rand() % 4u );
+    for (uint32 i = 0; i < TEXT_LEN; ++i)
+        rtext[i] = text[ TEXT_LEN - i - 1u ];
+
+    TestIndex f_data, r_data;
+    f_data.build( TEXT_LEN, &text[0] );
+    r_data.build( TEXT_LEN, &rtext[0] );
+
+    const fm_index_type f_index = f_data.index();
+    const fm_index_type r_index = r_data.index();
+
+    // build the patterns
+    std::vector<uint8>  patterns;
+    std::vector<uint32> offsets( 1u, 0u );
+    {
+        std::vector<uint8> pattern;
+        for (uint32 i = 0; i < N_PATTERNS; ++i)
+        {
+            gen_pattern( TEXT_LEN, &text[0], i, pattern );
+
+            patterns.insert( patterns.end(), pattern.begin(), pattern.end() );
+            offsets.push_back( uint32( patterns.size() ) );
+        }
+    }
+    const string_set_type string_set( N_PATTERNS, &patterns[0], &offsets[0] );
+
+    struct Config { uint32 min_intv; uint32 min_span; uint32 lanes; };
+    const Config configs[] = {
+        { 1u, 1u, 16u },
+        { 1u, 1u,  1u },
+        { 2u, 1u, 16u },
+        { 1u, 8u, 16u },
+    };
+
+    for (uint32 t = 0; t < sizeof(configs) / sizeof(Config); ++t)
+    {
+        const Config& config = configs[t];
+
+        smem_finder_type            smem_finder;
+        smem_finder_type::smem_set_type smems;
+
+        smem_finder.set_lanes( config.lanes );
+        smem_finder.find(
+            f_index,
+            r_index,
+            string_set,
+            smems,
+            config.min_intv,
+            uint32(-1),
+            config.min_span );
+
+        if (smems.size() != N_PATTERNS)
+        {
+            log_error(stderr, "  %u output strings, expected %u\n", smems.size(), N_PATTERNS);
+            return 1;
+        }
+
+        std::vector<RefSMEM> ref;
+        for (uint32 i = 0; i < N_PATTERNS; ++i)
+        {
+            const uint8* pattern     = &patterns[ offsets[i] ];
+            const uint32 pattern_len = offsets[i+1] - offsets[i];
+
+            find_smems_ref( TEXT_LEN, &text[0], pattern_len, pattern, config.min_intv, config.min_span, ref );
+
+            if (smems.n_ranges(i) != ref.size())
+            {
+                log_error(stderr, "  min-intv %u, min-span %u, lanes %u: pattern %u has %u SMEMs, expected %u\n",
+                    config.min_intv, config.min_span, config.lanes, i, smems.n_ranges(i), uint32( ref.size() ));
+                return 1;
+            }
+
+            const rank_type* ranges = smems[i];
+            for (uint32 j = 0; j < ref.size(); ++j)
+            {
+                const uint2 span = ranges[j].span();
+
+                // the SA range must be the one of the pattern span, and hold all its occurrences
+                const uint2 range = match( f_index, pattern + ref[j].begin, ref[j].end - ref[j].begin );
+
+                if (ranges[j].string_id()       != i            ||
+                    span.x                      != ref[j].begin ||
+                    span.y                      != ref[j].end   ||
+                    ranges[j].range().x         != range.x      ||
+                    ranges[j].range().y         != range.y      ||
+                    ranges[j].range_size()      != ref[j].count)
+                {
+                    log_error(stderr, "  min-intv %u, min-span %u, lanes %u: pattern %u, SMEM %u: [%u,%u) x %u, expected [%u,%u) x %u\n",
+                        config.min_intv, config.min_span, config.lanes, i, j,
+                        span.x, span.y, uint32( ranges[j].range_size() ),
+                        ref[j].begin, ref[j].end, ref[j].count);
+                    return 1;
+                }
+            }
+        }
+
+        log_info(stderr, "  min-intv %u, min-span %u, lanes %2u: %llu SMEMs\n",
+            config.min_intv, config.min_span, config.lanes, smems.n_ranges());
+    }
+
+    log_info(stderr, "smem test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
@@ -21,12 +21,154 @@
 
 #include <nvbio/basic/sum_tree.h>
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/timer.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
 
 namespace nvbio {
 
+namespace {
+
+// a simple LCG returning floats in [0,1)
+struct Random
+{
+    Random(const uint32 seed) : m_state( seed ) {}
+
+    uint32 next() { m_state = m_state * 1664525u + 1013904223u; return m_state >> 8; }
+    float  next_float() { return float( next() ) / float( 1u << 24 ); }
+
+    uint32 m_state;
+};
+
+// check that batch_sample() returns the same cells as sample(), and that batch_add() and
+// batch_set() produce the same tree as the corresponding sequences of add() and set()
+//
+template <typename TreeType>
+bool test_batched(const char* name, TreeType& tree, TreeType& ref_tree, std::vector<float>& cells, std::vector<float>& ref_cells)
+{
+    const uint32 n_leaves = tree.size();
+    const uint32 n_ops    = 100000;
+
+    Random rand( 1u );
+
+    // use integer weights so that sums are exact regardless of their order
+    for (uint32 i = 0; i < n_leaves; ++i)
+        cells[ tree.level_offset(0) + i ] = float( rand.next() % 8u );
+
+    tree.setup();
+    ref_cells = cells;
+
+    std::vector<float>  values( n_ops );
+    std::vector<uint32> samples( n_ops );
+    for (uint32 i = 0; i < n_ops; ++i)
+        values[i] = rand.next_float();
+
+    values[0] = 0.0f;
+    values[1] = 1.0f;
+
+    batch_sample( tree, n_ops, &values[0], &samples[0] );
+    for (uint32 i = 0; i < n_ops; ++i)
+    {
+        if (samples[i] != sample( tree, values[i] ))
+        {
+            log_error( stderr, "error in %s batch_sample(%f): %u != %u\n", name, values[i], samples[i], sample( tree, values[i] ) );
+            return false;
+        }
+    }
+
+    // test both a sparse and a dense batch of updates, with repeated cells
+    for (uint32 n_updates = 1000; n_updates <= n_leaves; n_updates *= 100)
+    {
+        std::vector<uint32> indices( n_updates );
+        std::vector<float>  deltas( n_updates );
+        for (uint32 i = 0; i < n_updates; ++i)
+        {
+            indices[i] = rand.next() % n_leaves;
+            deltas[i]  = float( rand.next() % 4u );
+        }
+
+        batch_add( tree, n_updates, &indices[0], &deltas[0] );
+        for (uint32 i = 0; i < n_updates; ++i)
+            ref_tree.add( indices[i], deltas[i] );
+
+        if (cells != ref_cells)
+        {
+            log_error( stderr, "error in %s batch_add(%u)\n", name, n_updates );
+            return false;
+        }
+
+        batch_set( tree, n_updates, &indices[0], &deltas[0] );
+        for (uint32 i = 0; i < n_updates; ++i)
+            ref_tree.set( indices[i], deltas[i] );
+
+        if (cells != ref_cells)
+        {
+            log_error( stderr, "error in %s batch_set(%u)\n", name, n_updates );
+            return false;
+        }
+    }
+    return true;
+}
+
+// measure the throughput of sampling and updating a tree, serially and in batches
+//
+template <typename TreeType>
+void benchmark(const char* name, TreeType& tree, std::vector<float>& cells)
+{
+    const uint32 n_leaves = tree.size();
+    const uint32 n_ops    = 4*1024*1024;
+
+    Random rand( 2u );
+
+    for (uint32 i = 0; i < n_leaves; ++i)
+        cells[ tree.level_offset(0) + i ] = rand.next_float();
+
+    tree.setup();
+
+    std::vector<float>  values( n_ops );
+    std::vector<uint32> indices( n_ops );
+    std::vector<uint32> samples( n_ops );
+    for (uint32 i = 0; i < n_ops; ++i)
+    {
+        values[i]  = rand.next_float();
+        indices[i] = rand.next() % n_leaves;
+    }
+
+    Timer timer;
+
+    timer.start();
+    for (uint32 i = 0; i < n_ops; ++i)
+        samples[i] = sample( tree, values[i] );
+    timer.stop();
+    const float sample_time = timer.seconds();
+
+    timer.start();
+    batch_sample( tree, n_ops, &values[0], &samples[0] );
+    timer.stop();
+    const float batch_sample_time = timer.seconds();
+
+    timer.start();
+    for (uint32 i = 0; i < n_ops; ++i)
+        tree.add( indices[i], values[i] );
+    timer.stop();
+    const float add_time = timer.seconds();
+
+    timer.start();
+    batch_add( tree, n_ops, &indices[0], &values[0] );
+    timer.stop();
+    const float batch_add_time = timer.seconds();
+
+    printf("  %-12s: sample %6.2f M/s, batch_sample %6.2f M/s, add %6.2f M/s, batch_add %6.2f M/s\n",
+        name,
+        1.0e-6f * float(n_ops) / sample_time,
+        1.0e-6f * float(n_ops) / batch_sample_time,
+        1.0e-6f * float(n_ops) / add_time,
+        1.0e-6f * float(n_ops) / batch_add_time);
+}
+
+} // anonymous namespace
+
 int sum_tree_test()
 {
     printf("sum tree... started\n");
@@ -184,6 +326,94 @@ int sum_tree_test()
             }
         }
     }
+    // wide trees
+    {
+        const uint32 n_leaves = 1000;
+
+        std::vector<float> vec( WideSumTree<float*>::node_count( n_leaves ) );
+
+        WideSumTree<float*> sum_tree( n_leaves, &vec[0] );
+
+        if (sum_tree.nodes() != vec.size() || sum_tree.levels() != 4u)
+        {
+            log_error( stderr, "error: wrong wide tree size: %u nodes, %u levels\n", sum_tree.nodes(), sum_tree.levels() );
+            exit(1);
+        }
+
+        // assign each leaf a weight between 0 and 3
+        float* leaves = &vec[ sum_tree.leaf_offset() ];
+        for (uint32 i = 0; i < n_leaves; ++i)
+            leaves[i] = float( (i * 7u) % 4u );
+
+        sum_tree.setup();
+
+        // check that each unit interval of the CDF maps to the proper leaf
+        uint32 leaf = 0;
+        float  cdf  = 0.0f;
+        for (uint32 k = 0; k < uint32( sum_tree.sum() ); ++k)
+        {
+            while (cdf + leaves[leaf] <= float(k))
+                cdf += leaves[leaf++];
+
+            const uint32 c = sample( sum_tree, (float(k) + 0.5f) / sum_tree.sum() );
+            if (c != leaf)
+            {
+                log_error( stderr, "error in wide tree test:\n  c(%u) = %u (!= %u)\n", k, c, leaf );
+                exit(1);
+            }
+        }
+
+        // remove the last non-empty leaf
+        sum_tree.set( 999, 0.0f );
+        if (sample( sum_tree, 1.0f ) != 998)
+        {
+            log_error( stderr, "error in wide tree test:\n  c(1.0) = %u (!= 998)\n", sample( sum_tree, 1.0f ) );
+            exit(1);
+        }
+    }
+    // batched operations
+    {
+        const uint32 n_leaves = 1000003;
+
+        std::vector<float> cells( SumTree<float*>::node_count( n_leaves ) );
+        std::vector<float> ref_cells( cells.size() );
+
+        SumTree<float*> tree( n_leaves, &cells[0] );
+        SumTree<float*> ref_tree( n_leaves, &ref_cells[0] );
+
+        if (test_batched( "SumTree", tree, ref_tree, cells, ref_cells ) == false)
+            exit(1);
+    }
+    {
+        const uint32 n_leaves = 1000003;
+
+        std::vector<float> cells( WideSumTree<float*>::node_count( n_leaves ) );
+        std::vector<float> ref_cells( cells.size() );
+
+        WideSumTree<float*> tree( n_leaves, &cells[0] );
+        WideSumTree<float*> ref_tree( n_leaves, &ref_cells[0] );
+
+        if (test_batched( "WideSumTree", tree, ref_tree, cells, ref_cells ) == false)
+            exit(1);
+    }
+    // benchmarks
+    {
+        const uint32 n_leaves = 16*1024*1024;
+
+        printf("  benchmark (%u leaves)\n", n_leaves);
+        {
+            std::vector<float> cells( SumTree<float*>::node_count( n_leaves ) );
+            SumTree<float*> tree( n_leaves, &cells[0] );
+
+            benchmark( "SumTree", tree, cells );
+        }
+        {
+            std::vector<float> cells( WideSumTree<float*>::node_count( n_leaves ) );
+            WideSumTree<float*> tree( n_leaves, &cells[0] );
+
+            benchmark( "WideSumTree", tree, cells );
+        }
+    }
     printf("sum tree... done\n");
 
     return 0;
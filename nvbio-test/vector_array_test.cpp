@@ -0,0 +1,202 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// vector_array_test.cpp
+//
+
+#include <nvbio/basic/vector_array.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/console.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace nvbio {
+
+namespace {
+
+// the size of the i-th test vector
+//
+uint32 vector_size(const uint32 i) { return 1u + ((i * 2654435761u) >> 24) % 64u; }
+
+// allocate all the test vectors from multiple threads, filling each with its own index;
+// if chunk_size is zero, vectors are allocated directly from the shared pool
+//
+float parallel_alloc(HostVectorArray<uint32>& array, const uint32 n_vectors, const uint32 chunk_size)
+{
+    array.clear();
+
+    Timer timer;
+    timer.start();
+
+  #if defined(_OPENMP)
+    #pragma omp parallel
+  #endif
+    {
+        HostVectorArrayAllocator<uint32> allocator( array, chunk_size ? chunk_size : 1u );
+
+      #if defined(_OPENMP)
+        #pragma omp for
+      #endif
+        for (int i = 0; i < int( n_vectors ); ++i)
+        {
+            const uint32 size = vector_size(i);
+
+            uint32* vec = chunk_size ?
+                allocator.alloc( i, size ) :
+                array.alloc( i, size );
+
+            if (vec)
+            {
+                for (uint32 j = 0; j < size; ++j)
+                    vec[j] = i;
+            }
+        }
+    }
+
+    timer.stop();
+    return timer.seconds();
+}
+
+// check that all vectors were allocated, are disjoint and hold the expected contents
+//
+bool check(const HostVectorArray<uint32>& array, const uint32 n_vectors, const char* name)
+{
+    for (uint32 i = 0; i < n_vectors; ++i)
+    {
+        const uint32* vec = array[i];
+        if (vec == NULL || array.size(i) != vector_size(i))
+        {
+            log_error(stderr, "  %s: vector %u not allocated\n", name, i);
+            return false;
+        }
+        for (uint32 j = 0; j < array.size(i); ++j)
+        {
+            if (vec[j] != i)
+            {
+                log_error(stderr, "  %s: vector %u overwritten at %u (%u)\n", name, i, j, vec[j]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int vector_array_test()
+{
+    log_info(stderr, "vector array test... started\n");
+
+    const uint32 n_vectors = 4*1024*1024;
+
+    uint64 n_elements = 0;
+    for (uint32 i = 0; i < n_vectors; ++i)
+        n_elements += vector_size(i);
+
+    HostVectorArray<uint32> array;
+    array.resize( n_vectors, uint32( n_elements + n_elements/4 ) );
+
+    // allocate directly from the shared pool
+    {
+        const float time = parallel_alloc( array, n_vectors, 0u );
+        if (check( array, n_vectors, "atomic" ) == false)
+            return 1;
+
+        log_info(stderr, "  atomic      : %7.1f M vectors/s (%.1f%% of the arena used)\n",
+            1.0e-6f * float(n_vectors) / time,
+            100.0f * float(array.allocated_size()) / float(array.arena_size()));
+    }
+
+    // allocate through per-thread chunks
+    for (uint32 chunk_size = 256; chunk_size <= 16*1024; chunk_size *= 8)
+    {
+        const float time = parallel_alloc( array, n_vectors, chunk_size );
+        if (check( array, n_vectors, "chunked" ) == false)
+            return 1;
+
+        log_info(stderr, "  chunks(%5u): %7.1f M vectors/s (%.1f%% of the arena used)\n",
+            chunk_size,
+            1.0e-6f * float(n_vectors) / time,
+            100.0f * float(array.allocated_size()) / float(array.arena_size()));
+
+        // compact the arena
+        Timer timer;
+        timer.start();
+
+        const uint32 n_used = array.compact();
+
+        timer.stop();
+
+        if (n_used != n_elements || check( array, n_vectors, "compacted" ) == false)
+        {
+            log_error(stderr, "  compaction failed: %u elements in use, expected %llu\n", n_used, n_elements);
+            return 1;
+        }
+        // check the vectors are now laid out contiguously in index order
+        for (uint32 i = 1; i < n_vectors; ++i)
+        {
+            if (array.slot(i) != array.slot(i-1) + array.size(i-1))
+            {
+                log_error(stderr, "  compaction failed: vector %u not contiguous\n", i);
+                return 1;
+            }
+        }
+        log_info(stderr, "    compaction : %7.1f M vectors/s\n", 1.0e-6f * float(n_vectors) / timer.seconds());
+    }
+
+    // exhaust the arena: all allocations must either succeed and be disjoint, or fail cleanly
+    {
+        HostVectorArray<uint32> small_array;
+        small_array.resize( n_vectors, uint32( n_elements/2 ) );
+
+        parallel_alloc( small_array, n_vectors, 1024u );
+
+        uint32 n_failed = 0;
+        for (uint32 i = 0; i < n_vectors; ++i)
+        {
+            const uint32* vec = small_array[i];
+            if (vec == NULL)
+            {
+                ++n_failed;
+                continue;
+            }
+            for (uint32 j = 0; j < small_array.size(i); ++j)
+            {
+                if (vec[j] != i)
+                {
+                    log_error(stderr, "  overflow: vector %u overwritten at %u (%u)\n", i, j, vec[j]);
+                    return 1;
+                }
+            }
+        }
+        if (n_failed == 0)
+        {
+            log_error(stderr, "  overflow: no allocation failed\n");
+            return 1;
+        }
+    }
+
+    log_info(stderr, "vector array test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
@@ -60,6 +60,18 @@ struct DeviceWarpScheduler {};
 
 ///@} // end of BatchScheduler group
 
+///
+/// Issue software prefetches for the strings of the i-th job of an alignment stream.
+/// The generic version is a no-op: streams can provide more specialized overloads,
+/// which will be found through argument-dependent lookup.
+///
+/// \param stream      the alignment stream
+/// \param i           the job index
+///
+template <typename stream_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void prefetch_strings(const stream_type& stream, const uint32 i) {}
+
 ///
 ///@defgroup BatchAlignment Batch Alignments
 /// A batch alignment is a parallel execution context for performing large batches of
@@ -267,6 +279,11 @@ void batch_banded_alignment_score(
 ///      implement a cache for any of the involved strings. With this design cached strings will
 ///      then be allowed to just contain pointers to the caches, making sure that they can be
 ///      passed by value without inadvertedly copying the caches themselves.
+///\par
+/// The HostThreadScheduler additionally calls prefetch_strings() on the jobs a few steps ahead of
+/// the one being processed by each thread: streams can overload this function to issue software
+/// prefetches for their strings (e.g. through StringPrefetcher::prefetch()), so that by the time
+/// the job is processed its strings are already in cache.
 ///
 template <
     typename stream_type,
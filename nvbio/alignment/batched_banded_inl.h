@@ -113,11 +113,21 @@ struct BatchedBandedAlignmentScore<BAND_LEN,stream_type,HostThreadScheduler>
 template <uint32 BAND_LEN, typename stream_type>
 void BatchedBandedAlignmentScore<BAND_LEN,stream_type,HostThreadScheduler>::enact(stream_type stream, uint64 temp_size, uint8* temp)
 {
+    const uint32 PREFETCH_DISTANCE = 4; // the number of jobs to look ahead when prefetching strings
+
+    const uint32 stream_size = stream.size();
+
   #if defined(_OPENMP)
-    #pragma omp parallel for
+    #pragma omp parallel for schedule(static)
   #endif
-    for (int tid = 0; tid < int( stream.size() ); ++tid)
+    for (int tid = 0; tid < int( stream_size ); ++tid)
+    {
+        // prefetch the strings of an upcoming job
+        if (tid + PREFETCH_DISTANCE < stream_size)
+            prefetch_strings( stream, tid + PREFETCH_DISTANCE );
+
         batched_banded_alignment_score<BAND_LEN>( stream, tid );
+    }
 }
 
 ///
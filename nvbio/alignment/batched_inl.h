@@ -221,7 +221,8 @@ __global__ void warp_persistent_batched_alignment_score_kernel(stream_type strea
 template <typename stream_type>
 struct BatchedAlignmentScore<stream_type,HostThreadScheduler>
 {
-    static const uint32 MAX_THREADS = 128; // whatever CPU we have, we assume we are never going to have more than this number of threads
+    static const uint32 MAX_THREADS       = 128; // whatever CPU we have, we assume we are never going to have more than this number of threads
+    static const uint32 PREFETCH_DISTANCE = 4;   // the number of jobs to look ahead when prefetching strings
 
     typedef typename stream_type::aligner_type                  aligner_type;
     typedef typename column_storage_type<aligner_type>::type    cell_type;
@@ -283,10 +284,14 @@ void BatchedAlignmentScore<stream_type,HostThreadScheduler>::enact(stream_type s
     nvbio::vector<host_tag,uint8> temp_vec( min_temp_size );
     cell_type* columns = (cell_type*)nvbio::raw_pointer( temp_vec );
 
+    const uint32 stream_size = stream.size();
+
+    // use a static schedule, so that each thread processes a contiguous range of jobs and
+    // the jobs it prefetches are those it will process next
     #if defined(_OPENMP)
-    #pragma omp parallel for
+    #pragma omp parallel for schedule(static)
     #endif
-    for (int work_id = 0; work_id < int( stream.size() ); ++work_id)
+    for (int work_id = 0; work_id < int( stream_size ); ++work_id)
     {
       #if defined(_OPENMP)
         const uint32 thread_id = omp_get_thread_num();
@@ -294,6 +299,10 @@ void BatchedAlignmentScore<stream_type,HostThreadScheduler>::enact(stream_type s
         const uint32 thread_id = 0;
       #endif
 
+        // prefetch the strings of an upcoming job
+        if (work_id + PREFETCH_DISTANCE < stream_size)
+            prefetch_strings( stream, work_id + PREFETCH_DISTANCE );
+
         // fetch the proper column storage
         //typedef strided_iterator<cell_type*> column_type;
         //column_type column = column_type( columns + thread_id, queue_capacity );
@@ -836,6 +845,13 @@ void BatchedAlignmentTraceback<CHECKPOINTS,stream_type,DeviceThreadScheduler>::e
 
 namespace priv {
 
+//
+// the string cache used by the convenience batch alignment functions with a given scheduler:
+// a local-memory cache on the device, and a cache of unpacked symbols on the host
+//
+template <typename scheduler_type> struct alignment_cache_tag                      { typedef lmem_cache_tag<128>  type; };
+template <>                        struct alignment_cache_tag<HostThreadScheduler> { typedef host_cache_tag<2048> type; };
+
 //
 // An alignment stream class to be used in conjunction with the BatchAlignmentScore class
 //
@@ -844,16 +860,17 @@ template <
     typename pattern_set_type,
     typename qualities_set_type,
     typename text_set_type,
-    typename sink_iterator>
+    typename sink_iterator,
+    typename cache_tag_type = lmem_cache_tag<128> >
 struct AlignmentStream
 {
     typedef t_aligner_type                              aligner_type;
 
     typedef typename pattern_set_type::string_type                          input_pattern_string;
     typedef typename text_set_type::string_type                             input_text_string;
-    typedef StringPrefetcher<input_pattern_string, lmem_cache_tag<128> >    pattern_prefetcher_type;
+    typedef StringPrefetcher<input_pattern_string, cache_tag_type>          pattern_prefetcher_type;
     typedef typename pattern_prefetcher_type::string_type                   pattern_string;
-    typedef StringPrefetcher<input_text_string, lmem_cache_tag<128> >       text_prefetcher_type;
+    typedef StringPrefetcher<input_text_string, cache_tag_type>             text_prefetcher_type;
     typedef typename text_prefetcher_type::string_type                      text_string;
     typedef typename qualities_set_type::string_type                        quals_string;
     typedef typename std::iterator_traits<sink_iterator>::value_type        sink_type;
@@ -946,6 +963,14 @@ struct AlignmentStream
         strings->text    = strings->text_prefetcher.load( m_texts[i] );
     }
 
+    // prefetch the strings of the i-th job
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const uint32 i) const
+    {
+        pattern_prefetcher_type::prefetch( m_patterns[i] );
+        text_prefetcher_type::prefetch( m_texts[i] );
+    }
+
     // handle the output
     NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
     void output(
@@ -966,6 +991,23 @@ struct AlignmentStream
     const uint32        m_max_text_length;
 };
 
+// prefetch the strings of the i-th job of an AlignmentStream
+//
+template <
+    typename aligner_type,
+    typename pattern_set_type,
+    typename qualities_set_type,
+    typename text_set_type,
+    typename sink_iterator,
+    typename cache_tag_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void prefetch_strings(
+    const AlignmentStream<aligner_type,pattern_set_type,qualities_set_type,text_set_type,sink_iterator,cache_tag_type>& stream,
+    const uint32                                                                                                       i)
+{
+    stream.prefetch( i );
+}
+
 } // namespace priv
 
 //
@@ -986,7 +1028,7 @@ void batch_alignment_score(
     const uint32            max_pattern_length,
     const uint32            max_text_length)
 {
-    typedef priv::AlignmentStream<aligner_type,pattern_set_type,trivial_quality_string_set,text_set_type,sink_iterator> stream_type;
+    typedef priv::AlignmentStream<aligner_type,pattern_set_type,trivial_quality_string_set,text_set_type,sink_iterator,typename priv::alignment_cache_tag<scheduler_type>::type> stream_type;
 
     typedef aln::BatchedAlignmentScore<stream_type, scheduler_type> batch_type;  // our batch type
 
@@ -1026,7 +1068,7 @@ void batch_alignment_score(
     const uint32                max_pattern_length,
     const uint32                max_text_length)
 {
-    typedef priv::AlignmentStream<aligner_type,pattern_set_type,qualities_set_type,text_set_type,sink_iterator> stream_type;
+    typedef priv::AlignmentStream<aligner_type,pattern_set_type,qualities_set_type,text_set_type,sink_iterator,typename priv::alignment_cache_tag<scheduler_type>::type> stream_type;
 
     typedef aln::BatchedAlignmentScore<stream_type, scheduler_type> batch_type;  // our batch type
 
@@ -1065,7 +1107,7 @@ void batch_banded_alignment_score(
     const uint32            max_pattern_length,
     const uint32            max_text_length)
 {
-    typedef priv::AlignmentStream<aligner_type,pattern_set_type,trivial_quality_string_set,text_set_type,sink_iterator> stream_type;
+    typedef priv::AlignmentStream<aligner_type,pattern_set_type,trivial_quality_string_set,text_set_type,sink_iterator,typename priv::alignment_cache_tag<scheduler_type>::type> stream_type;
 
     typedef aln::BatchedBandedAlignmentScore<BAND_LEN, stream_type, scheduler_type> batch_type;  // our batch type
 
@@ -37,70 +37,56 @@ int64 atomic_decrement(int64 volatile *value) { return InterlockedDecrement64(va
 
 namespace nvbio {
 
+// NOTE: these functions follow the semantics of CUDA's atomicAdd()/atomicSub(),
+// i.e. they return the value stored at the given address *before* the operation.
+
+#if defined(WIN32)
+
 int32 host_atomic_add(int32* value, const int32 op)
 {
-    Mutex mutex;
-    ScopedLock lock( &mutex );
-
-    *value += op;
-    return *value;
+    return InterlockedExchangeAdd( reinterpret_cast<LONG volatile*>(value), LONG(op) );
 }
 uint32 host_atomic_add(uint32* value, const uint32 op)
 {
-    Mutex mutex;
-    ScopedLock lock( &mutex );
-
-    *value += op;
-    return *value;
+    return InterlockedExchangeAdd( reinterpret_cast<LONG volatile*>(value), LONG(op) );
 }
 int64 host_atomic_add(int64* value, const int64 op)
 {
-    Mutex mutex;
-    ScopedLock lock( &mutex );
-
-    *value += op;
-    return *value;
+    return InterlockedExchangeAdd64( reinterpret_cast<LONGLONG volatile*>(value), LONGLONG(op) );
 }
 uint64 host_atomic_add(uint64* value, const uint64 op)
 {
-    Mutex mutex;
-    ScopedLock lock( &mutex );
-
-    *value += op;
-    return *value;
+    return InterlockedExchangeAdd64( reinterpret_cast<LONGLONG volatile*>(value), LONGLONG(op) );
 }
 int32 host_atomic_sub(int32* value, const int32 op)
 {
-    Mutex mutex;
-    ScopedLock lock( &mutex );
-
-    *value -= op;
-    return *value;
+    return InterlockedExchangeAdd( reinterpret_cast<LONG volatile*>(value), -LONG(op) );
 }
 uint32 host_atomic_sub(uint32* value, const uint32 op)
 {
-    Mutex mutex;
-    ScopedLock lock( &mutex );
-
-    *value -= op;
-    return *value;
+    return InterlockedExchangeAdd( reinterpret_cast<LONG volatile*>(value), -LONG(op) );
 }
-
 int64 host_atomic_sub(int64* value, const int64 op)
 {
-    Mutex mutex;
-    ScopedLock lock( &mutex );
-
-    *value -= op;
-    return *value;
+    return InterlockedExchangeAdd64( reinterpret_cast<LONGLONG volatile*>(value), -LONGLONG(op) );
 }
 uint64 host_atomic_sub(uint64* value, const uint64 op)
 {
-    Mutex mutex;
-    ScopedLock lock( &mutex );
-
-    *value -= op;
-    return *value;
+    return InterlockedExchangeAdd64( reinterpret_cast<LONGLONG volatile*>(value), -LONGLONG(op) );
 }
 
+#else
+
+int32  host_atomic_add( int32* value, const  int32 op) { return __sync_fetch_and_add( value, op ); }
+uint32 host_atomic_add(uint32* value, const uint32 op) { return __sync_fetch_and_add( value, op ); }
+int64  host_atomic_add( int64* value, const  int64 op) { return __sync_fetch_and_add( value, op ); }
+uint64 host_atomic_add(uint64* value, const uint64 op) { return __sync_fetch_and_add( value, op ); }
+
+int32  host_atomic_sub( int32* value, const  int32 op) { return __sync_fetch_and_sub( value, op ); }
+uint32 host_atomic_sub(uint32* value, const uint32 op) { return __sync_fetch_and_sub( value, op ); }
+int64  host_atomic_sub( int64* value, const  int64 op) { return __sync_fetch_and_sub( value, op ); }
+uint64 host_atomic_sub(uint64* value, const uint64 op) { return __sync_fetch_and_sub( value, op ); }
+
+#endif
+
 } // namespace nvbio
@@ -19,6 +19,12 @@
 #pragma once
 
 #include <nvbio/basic/types.h>
+#include <nvbio/basic/iterator.h>
+
+#if defined(__AVX2__) && !defined(__CUDACC__)
+#include <immintrin.h>
+#define NVBIO_AVX2
+#endif
 
 namespace nvbio {
 
@@ -31,6 +37,11 @@ namespace nvbio {
 /// both on the host and the device:
 ///
 /// - bloom_filter
+///\par
+/// as well as a <i>blocked</i> variant, which confines all the bits of each key to a single
+/// 256-bit block, so that each lookup touches a single cache line:
+///
+/// - blocked_bloom_filter
 ///
 /// \section ExampleSection Example
 ///
@@ -172,6 +183,93 @@ struct bloom_filter
     Hash2       m_hash2;
 };
 
+///
+/// A blocked Bloom filter implementation.
+/// Like bloom_filter, this class is <i>storage-free</i>, and can be used both from the host and the device.
+///\par
+/// The filter is split into blocks of 256 bits (8 words): the first hash function selects
+/// the block, while the second selects K of the block's words (all of them, plus K-8 words
+/// a second time, for K > 8) and is combined with fixed odd multipliers to select one bit
+/// in each of them.
+/// Hence, each insertion and lookup touches a single cache line, rather than K independent ones,
+/// at the cost of a slightly higher false positive rate for the same number of bits per key.
+/// If the storage is 32-byte aligned, the blocks never straddle cache lines.
+///\par
+/// On the host, when compiling with AVX2 support and using plain pointers as the storage iterator,
+/// lookups test all the bits of a key with a single vector load.
+/// The batched has() method further hides memory latency by prefetching the blocks of the
+/// following keys while testing the current ones.
+///
+/// \tparam  K              the number of bits set per key, in [1,16]
+/// \tparam  Hash1          the hash function used to select the block
+/// \tparam  Hash2          the hash function used to select the bits within the block
+/// \tparam  Iterator       the iterator to the internal filter storage, iterator_traits<iterator>::value_type
+///                         must be a uint32
+/// \tparam  OrOperator     the binary functor used to OR the filter's words with the inserted keys;
+///                         NOTE: this operation must be performed atomically if the filter is constructed
+///                         in parallel
+///
+template <
+    uint32   K,         // number of bits per key
+    typename Hash1,     // block hash function
+    typename Hash2,     // in-block hash function
+    typename Iterator,  // storage iterator - must dereference to uint32
+    typename OrOperator = inplace_or>
+struct blocked_bloom_filter
+{
+    static const uint32 BLOCK_WORDS = 8u;   ///< the number of words per block
+    static const uint32 BLOCK_BITS  = 256u; ///< the number of bits per block
+
+    /// constructor
+    ///
+    /// \param size         the Bloom filter's storage size, in bits: must be a power of 2 and a multiple of BLOCK_BITS
+    /// \param storage      the Bloom filter's internal storage
+    /// \param hash1        the block hashing function
+    /// \param hash2        the in-block hashing function
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE 
+    blocked_bloom_filter(
+        const uint64    size,
+        Iterator        storage,
+        const Hash1     hash1 = Hash1(),
+        const Hash2     hash2 = Hash2());
+
+    /// insert a key
+    ///
+    template <typename Key>
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE 
+    void insert(const Key key, const OrOperator or_op = OrOperator());
+
+    /// check for a key
+    ///
+    template <typename Key>
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE 
+    bool has(const Key key) const;
+
+    /// check for a batch of keys, prefetching the blocks of the keys
+    /// PREFETCH_DISTANCE positions ahead of the one being tested
+    ///
+    /// \param n_keys       the number of keys
+    /// \param keys         the keys to test
+    /// \param results      the output results, one bool per key
+    ///
+    template <typename KeyIterator, typename OutputIterator>
+    void has(const uint32 n_keys, const KeyIterator keys, OutputIterator results) const;
+
+    /// return the offset of the first word of the block of a given key
+    ///
+    template <typename Key>
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE 
+    uint64 block_offset(const Key key) const { return (uint64( m_hash1( key ) ) & (m_blocks-1u)) * BLOCK_WORDS; }
+
+    static const uint32 PREFETCH_DISTANCE = 16u;
+
+    uint64      m_blocks;
+    Iterator    m_storage;
+    Hash1       m_hash1;
+    Hash2       m_hash2;
+};
+
 ///@} BloomFilterModule
 ///@} Basic
 
@@ -88,4 +88,231 @@ bool bloom_filter<K,Hash1,Hash2,Iterator,OrOperator>::has(const Key key) const
     return true;
 }
 
+namespace priv {
+
+// the odd multipliers used to select the bits of a key within a block of a blocked_bloom_filter
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 blocked_bloom_salt(const uint32 i)
+{
+    switch (i)
+    {
+    case 0:  return 0x47b6137bu;
+    case 1:  return 0x44974d91u;
+    case 2:  return 0x8824ad5bu;
+    case 3:  return 0xa2b7289du;
+    case 4:  return 0x705495c7u;
+    case 5:  return 0x2df1424bu;
+    case 6:  return 0x9efc4947u;
+    case 7:  return 0x5c6bfb31u;
+    case 8:  return 0x9e3779b1u;
+    case 9:  return 0x85ebca6bu;
+    case 10: return 0xc2b2ae35u;
+    case 11: return 0x27d4eb2fu;
+    case 12: return 0x165667b1u;
+    case 13: return 0xd3a2646du;
+    case 14: return 0xfd7046c5u;
+    default: return 0xb55a4f09u;
+    }
+}
+
+// compute the masks of the bits to set in each of the words of a block:
+// the w-th word gets one bit selected by the w-th multiplier if it is among the
+// K words following a hash-dependent rotation, and a second bit selected by the
+// (w+8)-th multiplier if it is among the first K-8 words
+//
+template <uint32 K>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void blocked_bloom_masks(const uint32 h, uint32* masks)
+{
+    const uint32 r = h & 7u;
+
+    #if defined(__CUDA_ARCH__)
+    #pragma unroll
+    #endif
+    for (uint32 w = 0; w < 8u; ++w)
+    {
+        const uint32 lane = (w - r) & 7u;
+
+        masks[w] = (lane < K) ? 1u << ((h * blocked_bloom_salt(w)) >> 27) : 0u;
+        if (lane + 8u < K)
+            masks[w] |= 1u << ((h * blocked_bloom_salt(w + 8u)) >> 27);
+    }
+}
+
+// test whether all the bits of a key are set in a block
+//
+template <uint32 K, typename Iterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool blocked_bloom_has(const Iterator block, const uint32 h)
+{
+    uint32 masks[8];
+    blocked_bloom_masks<K>( h, masks );
+
+    #if defined(__CUDA_ARCH__)
+    #pragma unroll
+    #endif
+    for (uint32 w = 0; w < 8u; ++w)
+    {
+        if ((block[w] & masks[w]) != masks[w])
+            return false;
+    }
+    return true;
+}
+
+#if defined(NVBIO_AVX2)
+
+// compute the masks of the bits to set in each of the words of a block, using AVX2
+//
+template <uint32 K>
+inline __m256i blocked_bloom_masks_avx2(const uint32 h)
+{
+    const __m256i ones  = _mm256_set1_epi32( 1 );
+    const __m256i hv    = _mm256_set1_epi32( int32( h ) );
+
+    // the position of each word after the hash-dependent rotation
+    const __m256i lanes = _mm256_and_si256(
+        _mm256_sub_epi32( _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ), _mm256_set1_epi32( int32( h & 7u ) ) ),
+        _mm256_set1_epi32( 7 ) );
+
+    // the first bit of each word
+    const __m256i salts_lo = _mm256_setr_epi32(
+        0x47b6137b, 0x44974d91, int32(0x8824ad5bu), int32(0xa2b7289du),
+        0x705495c7, 0x2df1424b, int32(0x9efc4947u), 0x5c6bfb31 );
+
+    __m256i masks = _mm256_sllv_epi32( ones, _mm256_srli_epi32( _mm256_mullo_epi32( hv, salts_lo ), 27 ) );
+    if (K < 8u)
+        masks = _mm256_and_si256( masks, _mm256_cmpgt_epi32( _mm256_set1_epi32( K ), lanes ) );
+
+    // the second bit of each word
+    if (K > 8u)
+    {
+        const __m256i salts_hi = _mm256_setr_epi32(
+            int32(0x9e3779b1u), int32(0x85ebca6bu), int32(0xc2b2ae35u), 0x27d4eb2f,
+            0x165667b1, int32(0xd3a2646du), int32(0xfd7046c5u), int32(0xb55a4f09u) );
+
+        const __m256i masks_hi = _mm256_and_si256(
+            _mm256_sllv_epi32( ones, _mm256_srli_epi32( _mm256_mullo_epi32( hv, salts_hi ), 27 ) ),
+            _mm256_cmpgt_epi32( _mm256_set1_epi32( K - 8u ), lanes ) );
+
+        masks = _mm256_or_si256( masks, masks_hi );
+    }
+    return masks;
+}
+
+// test whether all the bits of a key are set in a block, using a single AVX2 load
+//
+template <uint32 K>
+inline bool blocked_bloom_has(const uint32* block, const uint32 h)
+{
+    const __m256i masks = blocked_bloom_masks_avx2<K>( h );
+    const __m256i words = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( block ) );
+
+    // testc returns 1 iff all the bits set in masks are also set in words
+    return _mm256_testc_si256( words, masks ) != 0;
+}
+
+// test whether all the bits of a key are set in a block, using a single AVX2 load
+//
+template <uint32 K>
+inline bool blocked_bloom_has(uint32* block, const uint32 h)
+{
+    return blocked_bloom_has<K>( const_cast<const uint32*>( block ), h );
+}
+
+#endif // NVBIO_AVX2
+
+} // namespace priv
+
+template <
+    uint32   K,         // number of bits per key
+    typename Hash1,     // block hash function
+    typename Hash2,     // in-block hash function
+    typename Iterator,  // storage iterator - must dereference to uint32
+    typename OrOperator>
+blocked_bloom_filter<K,Hash1,Hash2,Iterator,OrOperator>::blocked_bloom_filter(
+    const uint64    size,
+    Iterator        storage,
+    const Hash1     hash1,
+    const Hash2     hash2) :
+    m_blocks( size / BLOCK_BITS ),
+    m_storage( storage ),
+    m_hash1( hash1 ),
+    m_hash2( hash2 ) {}
+
+template <
+    uint32   K,         // number of bits per key
+    typename Hash1,     // block hash function
+    typename Hash2,     // in-block hash function
+    typename Iterator,  // storage iterator - must dereference to uint32
+    typename OrOperator>
+template <typename Key>
+void blocked_bloom_filter<K,Hash1,Hash2,Iterator,OrOperator>::insert(const Key key, const OrOperator or_op)
+{
+    const uint64 offset = block_offset( key );
+
+    uint32 masks[8];
+    priv::blocked_bloom_masks<K>( uint32( m_hash2( key ) ), masks );
+
+    #if defined(__CUDA_ARCH__)
+    #pragma unroll
+    #endif
+    for (uint32 w = 0; w < BLOCK_WORDS; ++w)
+    {
+        if (masks[w])
+            or_op( &m_storage[offset + w], masks[w] );
+    }
+}
+
+template <
+    uint32   K,         // number of bits per key
+    typename Hash1,     // block hash function
+    typename Hash2,     // in-block hash function
+    typename Iterator,  // storage iterator - must dereference to uint32
+    typename OrOperator>
+template <typename Key>
+bool blocked_bloom_filter<K,Hash1,Hash2,Iterator,OrOperator>::has(const Key key) const
+{
+    return priv::blocked_bloom_has<K>( m_storage + block_offset( key ), uint32( m_hash2( key ) ) );
+}
+
+template <
+    uint32   K,         // number of bits per key
+    typename Hash1,     // block hash function
+    typename Hash2,     // in-block hash function
+    typename Iterator,  // storage iterator - must dereference to uint32
+    typename OrOperator>
+template <typename KeyIterator, typename OutputIterator>
+void blocked_bloom_filter<K,Hash1,Hash2,Iterator,OrOperator>::has(const uint32 n_keys, const KeyIterator keys, OutputIterator results) const
+{
+    // a ring buffer of the block offsets and in-block hashes of the next keys
+    uint64 offsets[PREFETCH_DISTANCE];
+    uint32 hashes[PREFETCH_DISTANCE];
+
+    const uint32 n_prefetched = n_keys < PREFETCH_DISTANCE ? n_keys : PREFETCH_DISTANCE;
+    for (uint32 i = 0; i < n_prefetched; ++i)
+    {
+        offsets[i] = block_offset( keys[i] );
+        hashes[i]  = uint32( m_hash2( keys[i] ) );
+        host_prefetch( m_storage, offsets[i] );
+    }
+
+    for (uint32 i = 0; i < n_keys; ++i)
+    {
+        const uint32 slot   = i & (PREFETCH_DISTANCE-1u);
+        const uint64 offset = offsets[ slot ];
+        const uint32 h      = hashes[ slot ];
+
+        // replace this key with the one PREFETCH_DISTANCE positions ahead
+        if (i + PREFETCH_DISTANCE < n_keys)
+        {
+            offsets[ slot ] = block_offset( keys[i + PREFETCH_DISTANCE] );
+            hashes[ slot ]  = uint32( m_hash2( keys[i + PREFETCH_DISTANCE] ) );
+            host_prefetch( m_storage, offsets[ slot ] );
+        }
+
+        results[i] = priv::blocked_bloom_has<K>( m_storage + offset, h );
+    }
+}
+
 } // namespace nvbio
@@ -19,9 +19,9 @@
 #pragma once
 
 #include <nvbio/basic/types.h>
-#include <map>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/threads.h>
 #include <vector>
-#include <stack>
 
 namespace nvbio {
 
@@ -39,9 +39,21 @@ namespace nvbio {
 /// bool low_watermark() const
 ///     return true when the cache usage is below the low-watermark
 ///
+/// The cache can be used concurrently by multiple host threads.
+/// Elements are distributed across N_SHARDS shards, each with its own lock, open-addressing
+/// hash table and LRU list, so that pinning and unpinning elements which are already cached
+/// only contends with threads accessing the same shard.
+/// Misses and release cycles are serialized by a separate lock, which is also held during all
+/// calls to the CacheManager, so that the latter doesn't need to be thread-safe.
+/// Release cycles evict elements from the tail of each shard's LRU list in round-robin
+/// order, hence approximating a global LRU policy.
+///\par
+/// Pins are reference counted: an element stays pinned until it has been unpinned as many
+/// times as it was pinned.
+///
 struct cache_overflow {};
 
-template <typename CacheManager>
+template <typename CacheManager, uint32 N_SHARDS = 16>
 struct LRU
 {
     typedef CacheManager cache_manager_type;
@@ -58,29 +70,69 @@ struct LRU
     ///
     void unpin(const uint32 item);
 
+    /// return the number of cached elements
+    ///
+    uint32 size() const;
+
 private:
+    static const uint32 INVALID = 0xFFFFFFFFu;
+
     struct List
     {
         List() {}
         List(const uint32 item, const uint32 next, const uint32 prev) :
-            m_item( item ), m_next( next ), m_prev( prev ), m_pinned(true) {}
+            m_item( item ), m_next( next ), m_prev( prev ), m_pinned(1u) {}
 
         uint32 m_item;
         uint32 m_next;
         uint32 m_prev;
-        bool   m_pinned;
+        uint32 m_pinned;
     };
 
-    void touch(const uint32 list_idx, List& list);
-    void release_cycle(const uint32 item);
+    struct Shard
+    {
+        Shard() : m_first( INVALID ), m_last( INVALID ), m_size( 0u ) {}
+
+        /// find the list entry of a given element, returning INVALID if not present
+        ///
+        uint32 find(const uint32 item) const;
+
+        /// insert a new pinned element at the beginning of the LRU list
+        ///
+        void insert(const uint32 item);
 
-    uint32 m_first;
-    uint32 m_last;
+        /// release the least recently used unpinned element, returning false if none
+        ///
+        bool evict(uint32* item);
+
+        /// move an entry at the beginning of the LRU list
+        ///
+        void touch(const uint32 list_idx);
+
+        void push_front(const uint32 list_idx);
+        void extract(const uint32 list_idx);
+        uint32 find_slot(const uint32 item) const;
+        void erase_slot(uint32 slot);
+        void rehash(const uint32 table_size);
+
+        uint32              m_first;
+        uint32              m_last;
+        uint32              m_size;
+        std::vector<List>   m_list;
+        std::vector<uint32> m_pool;
+        std::vector<uint32> m_table;
+        Mutex               m_mutex;
+    };
+
+    static uint32 shard_index(const uint32 item) { return hash( item ) % N_SHARDS; }
+    static uint32 slot_hash(const uint32 item)   { return hash2( item ); }
+
+    void release_cycle(const uint32 item);
 
-    CacheManager*           m_manager;
-    std::map<uint32,uint32> m_cache_map;
-    std::vector<List>       m_cache_list;
-    std::stack<uint32>      m_cache_pool;
+    CacheManager*   m_manager;
+    Mutex           m_manager_mutex;
+    uint32          m_evict_shard;
+    Shard           m_shards[N_SHARDS];
 };
 
 } // namespace nvbio
@@ -20,157 +20,295 @@
 
 namespace nvbio {
 
-template <typename CacheManager>
-LRU<CacheManager>::LRU(CacheManager& manager) : m_first(0xFFFFFFFFu), m_last(0xFFFFFFFFu), m_manager(&manager) {}
+template <typename CacheManager, uint32 N_SHARDS>
+const uint32 LRU<CacheManager,N_SHARDS>::INVALID;
 
-template <typename CacheManager>
-void LRU<CacheManager>::pin(const uint32 item)
+template <typename CacheManager, uint32 N_SHARDS>
+LRU<CacheManager,N_SHARDS>::LRU(CacheManager& manager) : m_manager(&manager), m_evict_shard(0u) {}
+
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::pin(const uint32 item)
 {
-    typename std::map<uint32,uint32>::iterator it = m_cache_map.find( item );
-    if (it == m_cache_map.end())
+    Shard& shard = m_shards[ shard_index( item ) ];
+
+    // fast path: the element is already cached
     {
-        uint32 list_idx;
-        if (m_cache_pool.size())
+        ScopedLock lock( &shard.m_mutex );
+
+        const uint32 list_idx = shard.find( item );
+        if (list_idx != INVALID)
         {
-            list_idx = m_cache_pool.top();
-            m_cache_pool.pop();
+            // pin element
+            shard.m_list[ list_idx ].m_pinned++;
+
+            // move at the beginning of the LRU list
+            shard.touch( list_idx );
+            return;
         }
-        else
+    }
+
+    // slow path: serialize with all other misses and release cycles
+    ScopedLock manager_lock( &m_manager_mutex );
+
+    // check whether another thread loaded the element in the meantime; as elements
+    // are only ever inserted while holding the manager lock, the result of this
+    // check stays valid until we insert it ourselves
+    {
+        ScopedLock lock( &shard.m_mutex );
+
+        const uint32 list_idx = shard.find( item );
+        if (list_idx != INVALID)
         {
-            list_idx = uint32( m_cache_list.size() );
-            m_cache_list.push_back( List() );
+            shard.m_list[ list_idx ].m_pinned++;
+            shard.touch( list_idx );
+            return;
         }
+    }
+
+    if (m_manager->acquire( item ) == false)
+        release_cycle( item );
+
+    ScopedLock lock( &shard.m_mutex );
+    shard.insert( item );
+}
 
-        m_cache_map.insert( std::make_pair( item, list_idx ) );
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::unpin(const uint32 item)
+{
+    Shard& shard = m_shards[ shard_index( item ) ];
+
+    ScopedLock lock( &shard.m_mutex );
+
+    const uint32 list_idx = shard.find( item );
+    if (list_idx == INVALID)
+        return;
 
-        List& list = m_cache_list[ list_idx ];
-        list.m_item   = item;
-        list.m_next   = m_first;
-        list.m_prev   = 0xFFFFFFFFu;
-        list.m_pinned = true;
+    List& list = shard.m_list[ list_idx ];
+    if (list.m_pinned)
+        list.m_pinned--;
+
+    // move at the beginning of the LRU list
+    shard.touch( list_idx );
+}
 
-        // insert at the beginning of the LRU list
-        if (m_first != 0xFFFFFFFFu)
+template <typename CacheManager, uint32 N_SHARDS>
+uint32 LRU<CacheManager,N_SHARDS>::size() const
+{
+    uint32 r = 0u;
+    for (uint32 i = 0; i < N_SHARDS; ++i)
+        r += m_shards[i].m_size;
+    return r;
+}
+
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::release_cycle(const uint32 item_to_acquire)
+{
+    // walk the shards in round-robin order, releasing their least recently used
+    // elements until we both acquired the new element and reached the low-watermark
+    bool   acquired = false;
+    uint32 n_empty  = 0u;
+
+    while (acquired == false || m_manager->low_watermark() == false)
+    {
+        // stop if a whole round didn't find any releasable element
+        if (n_empty == N_SHARDS)
         {
-            List& first = m_cache_list[ m_first ];
-            first.m_prev = list_idx;
+            if (acquired)
+                break;
+            else
+                throw cache_overflow();
         }
 
-        m_first = list_idx;
-        if (m_last == 0xFFFFFFFFu)
-            m_last  = m_first;
+        Shard& shard = m_shards[ m_evict_shard ];
+        m_evict_shard = (m_evict_shard + 1u) % N_SHARDS;
 
-        if (m_manager->acquire( item ) == false)
-            release_cycle( item );
+        uint32 item;
+        bool   evicted;
+        {
+            ScopedLock lock( &shard.m_mutex );
+            evicted = shard.evict( &item );
+        }
+        if (evicted == false)
+        {
+            ++n_empty;
+            continue;
+        }
+        n_empty = 0u;
+
+        m_manager->release( item );
+        if (acquired == false && m_manager->acquire( item_to_acquire ))
+            acquired  = true;
     }
-    else
-    {
-        // pin element
-        List& list = m_cache_list[ it->second ];
-        list.m_pinned = true;
+}
 
-        // move at the beginning of the LRU list
-        touch( it->second, list );
+template <typename CacheManager, uint32 N_SHARDS>
+uint32 LRU<CacheManager,N_SHARDS>::Shard::find_slot(const uint32 item) const
+{
+    if (m_table.empty())
+        return INVALID;
+
+    const uint32 mask = uint32( m_table.size() ) - 1u;
+
+    // linear probing
+    for (uint32 slot = slot_hash( item ) & mask;; slot = (slot + 1u) & mask)
+    {
+        const uint32 list_idx = m_table[ slot ];
+        if (list_idx == INVALID)
+            return INVALID;
+        if (m_list[ list_idx ].m_item == item)
+            return slot;
     }
 }
 
-template <typename CacheManager>
-void LRU<CacheManager>::unpin(const uint32 item)
+template <typename CacheManager, uint32 N_SHARDS>
+uint32 LRU<CacheManager,N_SHARDS>::Shard::find(const uint32 item) const
 {
-    typename std::map<uint32,uint32>::iterator it = m_cache_map.find( item );
-    const uint32 list_idx = it->second;
+    const uint32 slot = find_slot( item );
+    return slot == INVALID ? INVALID : m_table[ slot ];
+}
 
-    List& list = m_cache_list[ list_idx ];
-    list.m_pinned = false;
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::Shard::rehash(const uint32 table_size)
+{
+    m_table.assign( table_size, INVALID );
 
-    // move at the beginning of the LRU list
-    touch( list_idx, list );
+    const uint32 mask = table_size - 1u;
+
+    // re-insert all the elements of the LRU list
+    for (uint32 list_idx = m_first; list_idx != INVALID; list_idx = m_list[ list_idx ].m_next)
+    {
+        uint32 slot = slot_hash( m_list[ list_idx ].m_item ) & mask;
+        while (m_table[ slot ] != INVALID)
+            slot = (slot + 1u) & mask;
+
+        m_table[ slot ] = list_idx;
+    }
 }
 
-template <typename CacheManager>
-void LRU<CacheManager>::touch(const uint32 list_idx, List& list)
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::Shard::insert(const uint32 item)
 {
-    // check whether this element is already at the beginning of the LRU list
-    if (m_first == list_idx)
-        return;
+    // keep the load factor below 1/2
+    if ((m_size + 1u) * 2u > m_table.size())
+        rehash( nvbio::max( uint32( m_table.size() ) * 2u, 16u ) );
 
-    // extract element from the LRU list
-    if (list.m_prev != 0xFFFFFFFFu)
+    uint32 list_idx;
+    if (m_pool.size())
     {
-        List& prev = m_cache_list[ list.m_prev ];
-        prev.m_next = list.m_next;
+        list_idx = m_pool.back();
+        m_pool.pop_back();
     }
-    if (list.m_next != 0xFFFFFFFFu)
+    else
     {
-        List& next = m_cache_list[ list.m_next ];
-        next.m_next = list.m_prev;
+        list_idx = uint32( m_list.size() );
+        m_list.push_back( List() );
     }
-    else // mark the new end of list
-        m_last = list.m_prev;
 
-    // re-insert at the beginning of the LRU list
-    m_first = list_idx;
+    List& list = m_list[ list_idx ];
+    list.m_item   = item;
+    list.m_pinned = 1u;
+
+    // insert at the beginning of the LRU list
+    push_front( list_idx );
+
+    const uint32 mask = uint32( m_table.size() ) - 1u;
+
+    uint32 slot = slot_hash( item ) & mask;
+    while (m_table[ slot ] != INVALID)
+        slot = (slot + 1u) & mask;
+
+    m_table[ slot ] = list_idx;
+    m_size++;
 }
 
-template <typename CacheManager>
-void LRU<CacheManager>::release_cycle(const uint32 item_to_acquire)
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::Shard::erase_slot(uint32 slot)
 {
-    // walk the list from the end
-    uint32 list_idx = m_last;
-    bool acquired = false;
+    const uint32 mask = uint32( m_table.size() ) - 1u;
 
-    do
+    // backward-shift deletion: move back any following element whose probe
+    // sequence would otherwise be broken by the hole we are leaving
+    for (uint32 next = (slot + 1u) & mask; m_table[ next ] != INVALID; next = (next + 1u) & mask)
     {
-        if (list_idx == 0xFFFFFFFFu)
-        {
-            if (acquired)
-                break;
-            else
-                throw cache_overflow();
-        }
+        const uint32 home = slot_hash( m_list[ m_table[ next ] ].m_item ) & mask;
+
+        // check whether home lies cyclically in (slot, next]
+        const bool in_place = (slot <= next) ?
+            (home > slot && home <= next) :
+            (home > slot || home <= next);
 
-        List& list = m_cache_list[ list_idx ];
-        if (list.m_pinned)
+        if (in_place == false)
         {
-            list_idx = list.m_prev;
-            continue;
+            m_table[ slot ] = m_table[ next ];
+            slot = next;
         }
+    }
+    m_table[ slot ] = INVALID;
+    m_size--;
+}
 
-        const uint32 prev = list.m_prev;
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::Shard::push_front(const uint32 list_idx)
+{
+    List& list = m_list[ list_idx ];
+    list.m_prev = INVALID;
+    list.m_next = m_first;
 
-        // extract element from the LRU list
-        if (list.m_prev != 0xFFFFFFFFu)
-        {
-            List& prev = m_cache_list[ list.m_prev ];
-            prev.m_next = list.m_next;
-        }
-        else // mark the list as empty
-            m_first = 0xFFFFFFFFu;
+    if (m_first != INVALID)
+        m_list[ m_first ].m_prev = list_idx;
 
-        if (list.m_next != 0xFFFFFFFFu)
-        {
-            List& next = m_cache_list[ list.m_next ];
-            next.m_next = list.m_prev;
-        }
-        else // mark the new end of list
-            m_last = list.m_prev;
+    m_first = list_idx;
+    if (m_last == INVALID)
+        m_last = list_idx;
+}
 
-        const uint32 item = list.m_item;
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::Shard::extract(const uint32 list_idx)
+{
+    const List& list = m_list[ list_idx ];
 
-        // release this list entry
-        m_cache_pool.push( list_idx );
+    if (list.m_prev != INVALID)
+        m_list[ list.m_prev ].m_next = list.m_next;
+    else
+        m_first = list.m_next;
 
-        // and remove from the map
-        m_cache_map.erase( m_cache_map.find( item ) );
+    if (list.m_next != INVALID)
+        m_list[ list.m_next ].m_prev = list.m_prev;
+    else // mark the new end of list
+        m_last = list.m_prev;
+}
 
-        m_manager->release( item );
-        if (acquired == false && m_manager->acquire( item_to_acquire ))
-            acquired  = true;
+template <typename CacheManager, uint32 N_SHARDS>
+void LRU<CacheManager,N_SHARDS>::Shard::touch(const uint32 list_idx)
+{
+    // check whether this element is already at the beginning of the LRU list
+    if (m_first == list_idx)
+        return;
 
-        // jump to the previous
-        list_idx = prev;
-    }
-    while (m_manager->low_watermark() == false);
+    extract( list_idx );
+    push_front( list_idx );
+}
+
+template <typename CacheManager, uint32 N_SHARDS>
+bool LRU<CacheManager,N_SHARDS>::Shard::evict(uint32* item)
+{
+    // walk the list from the end, looking for an unpinned element
+    uint32 list_idx = m_last;
+    while (list_idx != INVALID && m_list[ list_idx ].m_pinned)
+        list_idx = m_list[ list_idx ].m_prev;
+
+    if (list_idx == INVALID)
+        return false;
+
+    *item = m_list[ list_idx ].m_item;
+
+    // extract element from the LRU list and remove it from the table
+    extract( list_idx );
+    erase_slot( find_slot( *item ) );
+
+    // release this list entry
+    m_pool.push_back( list_idx );
+    return true;
 }
 
 } // namespace nvbio
@@ -42,6 +42,8 @@ namespace cuda {
 /// - (uint32,uint32)
 /// - (uint64,uint32)
 ///
+/// The HostSortEnactor (see nvbio/basic/sort.h) provides the same interface for host-memory
+/// buffers, backed by a multi-threaded radix sort.
 ///
 
 ///@addtogroup Basic
@@ -175,5 +175,14 @@ struct deinterleaved_iterator
     BaseIterator m_it;
 };
 
+/// issue a software prefetch for the i-th element of a deinterleaved iterator
+///
+template<uint32 STRIDE, uint32 WHICH, typename BaseIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void host_prefetch(const deinterleaved_iterator<STRIDE,WHICH,BaseIterator> it, const uint64 i)
+{
+    host_prefetch( it.m_it, i*STRIDE + WHICH );
+}
+
 
 } // namespace nvbio
@@ -0,0 +1,99 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvbio/basic/histogram.h>
+#include <nvbio/basic/numbers.h>
+#include <math.h>
+
+namespace nvbio {
+
+// reset all counters
+//
+void LogLinearHistogram::clear()
+{
+    m_count = 0u;
+    m_sum   = 0u;
+    for (uint32 b = 0; b < N_BUCKETS; ++b)
+        m_counts[b] = 0u;
+}
+
+// add all the values recorded by another histogram
+//
+void LogLinearHistogram::merge(const LogLinearHistogram& other)
+{
+    for (uint32 b = 0; b < N_BUCKETS; ++b)
+    {
+        if (other.m_counts[b])
+            host_atomic_add( &m_counts[b], other.m_counts[b] );
+    }
+    host_atomic_add( &m_count, other.m_count );
+    host_atomic_add( &m_sum,   other.m_sum );
+}
+
+// return the value at the given percentile
+//
+uint64 LogLinearHistogram::percentile(const float p) const
+{
+    // take a consistent total from the buckets themselves, as the histogram might be
+    // concurrently updated
+    uint64 total = 0u;
+    for (uint32 b = 0; b < N_BUCKETS; ++b)
+        total += m_counts[b];
+
+    if (total == 0u)
+        return 0u;
+
+    // compute the rank of the requested value, in [1,total]
+    const double q    = p < 0.0f ? 0.0 : p > 1.0f ? 1.0 : double( p );
+    const uint64 rank = nvbio::max( uint64( ceil( q * double( total ) ) ), uint64(1u) );
+
+    uint64 cum = 0u;
+    for (uint32 b = 0; b < N_BUCKETS; ++b)
+    {
+        cum += m_counts[b];
+        if (cum >= rank)
+            return bucket_last( b );
+    }
+    return bucket_last( N_BUCKETS-1 );
+}
+
+// return the smallest recorded value
+//
+uint64 LogLinearHistogram::min() const
+{
+    for (uint32 b = 0; b < N_BUCKETS; ++b)
+    {
+        if (m_counts[b])
+            return bucket_begin( b );
+    }
+    return 0u;
+}
+
+// return the largest recorded value
+//
+uint64 LogLinearHistogram::max() const
+{
+    for (uint32 b = N_BUCKETS; b > 0; --b)
+    {
+        if (m_counts[b-1])
+            return bucket_last( b-1 );
+    }
+    return 0u;
+}
+
+} // namespace nvbio
@@ -0,0 +1,178 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/atomics.h>
+
+namespace nvbio {
+
+/// \page histogram_page Histograms
+///
+/// This module implements a fixed-memory, log-linear histogram in the style of HdrHistogram,
+/// meant to track the distribution of latencies or sizes over arbitrarily long runs:
+///
+/// - LogLinearHistogram
+///
+/// Values below 2^SUB_BITS are counted exactly, while each successive power-of-two range is
+/// split into 2^SUB_BITS equally sized sub-buckets, so that any reported value is within a
+/// relative error of 2^-SUB_BITS from the recorded one.
+/// Values are recorded through atomic increments, which allows a single histogram to be shared
+/// by several threads without any locking; alternatively, each thread can keep a private
+/// histogram, and all of them can be merged at the end.
+///
+/// \section HistogramExample Example
+///
+/// \code
+/// LogLinearHistogram latency;
+///
+/// #pragma omp parallel for
+/// for (int i = 0; i < n_tasks; ++i)
+/// {
+///     Timer timer;
+///     timer.start();
+///     ... // do something
+///     timer.stop();
+///
+///     // record the latency in nanoseconds
+///     latency.add( uint64( timer.seconds() * 1.0e9f ) );
+/// }
+///
+/// log_info(stderr, "p50: %llu ns, p99: %llu ns\n",
+///     latency.percentile( 0.5f ),
+///     latency.percentile( 0.99f ) );
+/// \endcode
+///
+
+///@addtogroup Basic
+///@{
+
+///
+/// A fixed-memory, lock-free log-linear histogram of non-negative integer values.
+///
+struct LogLinearHistogram
+{
+    static const uint32 SUB_BITS    = 6;                                    ///< log2 of the number of sub-buckets per power of two
+    static const uint32 SUB_BUCKETS = 1u << SUB_BITS;                       ///< the number of sub-buckets per power of two
+    static const uint32 MAX_BITS    = 48;                                   ///< values are clamped to 2^MAX_BITS - 1
+    static const uint32 N_BUCKETS   = SUB_BUCKETS * (MAX_BITS - SUB_BITS + 1);
+
+    /// constructor
+    ///
+    LogLinearHistogram() { clear(); }
+
+    /// reset all counters
+    ///
+    void clear();
+
+    /// record a value n times; this method is thread-safe
+    ///
+    void add(const uint64 value, const uint64 n = 1u)
+    {
+        host_atomic_add( &m_counts[ bucket( value ) ], n );
+        host_atomic_add( &m_count, n );
+        host_atomic_add( &m_sum, value * n );
+    }
+
+    /// add all the values recorded by another histogram; this method is thread-safe
+    /// with respect to concurrent add() and merge() calls on this histogram
+    ///
+    void merge(const LogLinearHistogram& other);
+
+    /// return the total number of recorded values
+    ///
+    uint64 count() const { return m_count; }
+
+    /// return the sum of all recorded values
+    ///
+    uint64 sum() const { return m_sum; }
+
+    /// return the mean of all recorded values
+    ///
+    double mean() const { return m_count ? double( m_sum ) / double( m_count ) : 0.0; }
+
+    /// return the value at the given percentile, i.e. the largest value equivalent to the one
+    /// whose rank is the given fraction of the recorded values
+    ///
+    /// \param p        the requested percentile, in [0,1]
+    ///
+    uint64 percentile(const float p) const;
+
+    /// return the smallest recorded value, up to the histogram's precision
+    ///
+    uint64 min() const;
+
+    /// return the largest recorded value, up to the histogram's precision
+    ///
+    uint64 max() const;
+
+    /// return the number of values recorded in the given bucket
+    ///
+    uint64 bucket_count(const uint32 b) const { return m_counts[b]; }
+
+    /// return the bucket a value falls in
+    ///
+    static uint32 bucket(uint64 value)
+    {
+        if (value < SUB_BUCKETS)
+            return uint32( value );
+
+        value = value < (uint64(1u) << MAX_BITS) ? value : (uint64(1u) << MAX_BITS) - 1u;
+
+        // find the most significant bit
+        uint32 e = SUB_BITS;
+        while (value >> (e+1))
+            ++e;
+
+        // keep the SUB_BITS bits following it
+        const uint32 shift = e - SUB_BITS;
+        return (shift + 1u) * SUB_BUCKETS + uint32( (value >> shift) - SUB_BUCKETS );
+    }
+
+    /// return the smallest value falling in a given bucket
+    ///
+    static uint64 bucket_begin(const uint32 b)
+    {
+        if (b < SUB_BUCKETS)
+            return b;
+
+        const uint32 shift = b / SUB_BUCKETS - 1u;
+        return uint64( SUB_BUCKETS + b % SUB_BUCKETS ) << shift;
+    }
+
+    /// return the largest value falling in a given bucket
+    ///
+    static uint64 bucket_last(const uint32 b)
+    {
+        if (b < SUB_BUCKETS)
+            return b;
+
+        const uint32 shift = b / SUB_BUCKETS - 1u;
+        return bucket_begin( b ) + (uint64(1u) << shift) - 1u;
+    }
+
+private:
+    uint64 m_count;
+    uint64 m_sum;
+    uint64 m_counts[N_BUCKETS];
+};
+
+///@} Basic
+
+} // namespace nvbio
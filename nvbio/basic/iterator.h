@@ -81,4 +81,35 @@ struct iterator_system
     typedef typename iterator_category_system<iterator_category>::type  type;
 };
 
+/// issue a software prefetch for the i-th element of a generic iterator:
+/// as there is no way to know where the element lives, this is a no-op
+///
+template <typename iterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void host_prefetch(const iterator it, const uint64 i) {}
+
+/// issue a software prefetch for the i-th element of a plain pointer, bringing
+/// its cache line into the host caches; this is a no-op on the device
+///
+template <typename T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void host_prefetch(const T* it, const uint64 i)
+{
+  #if !defined(NVBIO_DEVICE_COMPILATION) && defined(__GNUC__)
+    __builtin_prefetch( it + i );
+  #endif
+}
+
+/// issue a software prefetch for the i-th element of a plain pointer, bringing
+/// its cache line into the host caches; this is a no-op on the device
+///
+template <typename T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void host_prefetch(T* it, const uint64 i)
+{
+  #if !defined(NVBIO_DEVICE_COMPILATION) && defined(__GNUC__)
+    __builtin_prefetch( it + i );
+  #endif
+}
+
 } // namespace nvbio
@@ -44,6 +44,28 @@ struct ServerMappedFile::Impl
     HANDLE h_file;
     void*  buffer;
 };
+struct DiskMappedFile::Impl
+{
+    Impl() : h_file( INVALID_HANDLE_VALUE ), h_mapping( NULL ), buffer( NULL ), file_size( 0 ) {}
+
+    // unmap and close the current file, if any
+    void release()
+    {
+        if (buffer != NULL)                 UnmapViewOfFile( buffer );
+        if (h_mapping != NULL)              CloseHandle( h_mapping );
+        if (h_file != INVALID_HANDLE_VALUE) CloseHandle( h_file );
+
+        h_file    = INVALID_HANDLE_VALUE;
+        h_mapping = NULL;
+        buffer    = NULL;
+        file_size = 0;
+    }
+
+    HANDLE h_file;
+    HANDLE h_mapping;
+    void*  buffer;
+    uint64 file_size;
+};
 
 MappedFile::MappedFile() : impl( new Impl() ) {}
 
@@ -133,6 +155,63 @@ ServerMappedFile::~ServerMappedFile()
     delete impl;
 }
 
+DiskMappedFile::DiskMappedFile() : impl( new Impl() ) {}
+
+const void* DiskMappedFile::init(const char* file_name)
+{
+    // release any previous mapping
+    impl->release();
+
+    impl->h_file = CreateFileA(
+        file_name,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL );
+
+    if (impl->h_file == INVALID_HANDLE_VALUE)
+        throw mapping_error( file_name, GetLastError() );
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx( impl->h_file, &file_size );
+    impl->file_size = uint64( file_size.QuadPart );
+
+    impl->h_mapping = CreateFileMapping(
+        impl->h_file,
+        NULL,
+        PAGE_READONLY,
+        0,
+        0,
+        NULL );
+
+    if (impl->h_mapping == NULL)
+        throw mapping_error( file_name, GetLastError() );
+
+    impl->buffer = MapViewOfFile(
+        impl->h_mapping,
+        FILE_MAP_READ,
+        0,
+        0,
+        0 );
+
+    if (impl->buffer == NULL)
+        throw view_error( file_name, GetLastError() );
+
+    const uint64 size = impl->file_size;
+    log_verbose(stderr, "mapped file \"%s\" (%.2f %s)\n", file_name, (size > 1024*1024 ? float(size)/float(1024*1024) : float(size)), (size > 1024*1024 ? "MB" : "B"));
+    return impl->buffer;
+}
+uint64 DiskMappedFile::size() const { return impl->file_size; }
+
+DiskMappedFile::~DiskMappedFile()
+{
+    impl->release();
+
+    delete impl;
+}
+
 } // namespace nvbio
 
 #else
@@ -168,6 +247,25 @@ struct ServerMappedFile::Impl
     std::string file_name;
     uint64      file_size;
 };
+struct DiskMappedFile::Impl
+{
+    Impl() : h_file( -1 ), buffer( NULL ), file_size( 0 ) {}
+
+    // unmap and close the current file, if any
+    void release()
+    {
+        if (buffer != NULL) munmap( buffer, file_size );
+        if (h_file != -1)   close( h_file );
+
+        h_file    = -1;
+        buffer    = NULL;
+        file_size = 0;
+    }
+
+    int    h_file;
+    void*  buffer;
+    uint64 file_size;
+};
 
 MappedFile::MappedFile() : impl( new Impl() ) {}
 
@@ -248,6 +346,51 @@ ServerMappedFile::~ServerMappedFile()
     delete impl;
 }
 
+DiskMappedFile::DiskMappedFile() : impl( new Impl() ) {}
+
+const void* DiskMappedFile::init(const char* file_name)
+{
+    // release any previous mapping
+    impl->release();
+
+    impl->h_file = open( file_name, O_RDONLY );
+
+    if (impl->h_file == -1)
+        throw mapping_error( file_name, errno );
+
+    struct stat file_stat;
+    if (fstat( impl->h_file, &file_stat ) == -1)
+        throw mapping_error( file_name, errno );
+
+    impl->file_size = uint64( file_stat.st_size );
+
+    impl->buffer = mmap(
+        NULL,
+        impl->file_size,
+        PROT_READ,
+        MAP_SHARED,
+        impl->h_file,
+        0 );
+
+    if (impl->buffer == MAP_FAILED)
+    {
+        impl->buffer = NULL;
+        throw view_error( file_name, errno );
+    }
+
+    const uint64 size = impl->file_size;
+    log_verbose(stderr, "mapped file \"%s\" (%.2f %s)\n", file_name, (size > 1024*1024 ? float(size)/float(1024*1024) : float(size)), (size > 1024*1024 ? "MB" : "B"));
+    return impl->buffer;
+}
+uint64 DiskMappedFile::size() const { return impl->file_size; }
+
+DiskMappedFile::~DiskMappedFile()
+{
+    impl->release();
+
+    delete impl;
+}
+
 } // namespace nvbio
 
 #endif
@@ -30,6 +30,7 @@ namespace nvbio {
 ///
 /// - MappedFile
 /// - ServerMappedFile
+/// - DiskMappedFile
 ///
 /// \section MMAPExampleSection Example
 ///
@@ -153,6 +154,49 @@ private:
     Impl* impl;
 };
 
+///
+/// A class to map a file on disk read-only into the address space of the calling process.
+/// Pages are loaded lazily by the OS, and are shared through the page cache by all processes
+/// mapping the same file. The mapping is released when the destructor is called.
+///
+struct DiskMappedFile
+{
+    struct mapping_error
+    {
+        mapping_error(const char* name, int32 code) : m_file_name( name ), m_code( code ) {}
+
+        const char* m_file_name;
+        int32       m_code;
+    };
+    struct view_error
+    {
+        view_error(const char* name, uint32 code) : m_file_name( name ), m_code( code ) {}
+
+        const char* m_file_name;
+        int32       m_code;
+    };
+
+    /// constructor
+    ///
+    DiskMappedFile();
+
+    /// destructor
+    ///
+    ~DiskMappedFile();
+
+    /// map the given file, returning a pointer to its contents
+    ///
+    const void* init(const char* file_name);
+
+    /// return the size of the mapped file
+    ///
+    uint64 size() const;
+
+private:
+    struct Impl;
+    Impl* impl;
+};
+
 ///@} MemoryMappingModule
 ///@} Basic
 
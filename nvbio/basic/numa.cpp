@@ -0,0 +1,290 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvbio/basic/numa.h>
+#include <nvbio/basic/omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#endif
+
+namespace nvbio {
+
+#if defined(__linux__)
+
+namespace {
+
+// the memory policy constants of the mbind() system call, from linux/mempolicy.h
+//
+const int           NUMA_MPOL_BIND       = 2;
+const int           NUMA_MPOL_INTERLEAVE = 3;
+const unsigned int  NUMA_MPOL_MF_MOVE    = 1u << 1;
+
+const uint32        NUMA_MAX_NODES       = 1024u;
+const uint32        NUMA_MASK_WORDS      = NUMA_MAX_NODES / (8u * sizeof(unsigned long));
+
+// call mbind() on the pages overlapping a memory range
+//
+bool mbind_range(void* ptr, const uint64 bytes, const int mode, const unsigned long* node_mask)
+{
+    if (bytes == 0u)
+        return true;
+
+    const uint64 page_size = uint64( sysconf( _SC_PAGESIZE ) );
+    const uint64 begin     = uint64( ptr ) & ~(page_size - 1u);
+    const uint64 end       = uint64( ptr ) + bytes;
+
+    return syscall( SYS_mbind, begin, end - begin, mode, node_mask, NUMA_MAX_NODES + 1u, NUMA_MPOL_MF_MOVE ) == 0;
+}
+
+// parse a list of cpus in the format used by /sys (e.g. "0-7,16-23") into a cpu set
+//
+bool parse_cpu_list(const char* str, cpu_set_t* cpus)
+{
+    CPU_ZERO( cpus );
+
+    while (*str && *str != '\n')
+    {
+        char* end;
+        const long first = strtol( str, &end, 10 );
+        if (end == str)
+            return false;
+
+        long last = first;
+        if (*end == '-')
+        {
+            str  = end + 1;
+            last = strtol( str, &end, 10 );
+            if (end == str)
+                return false;
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+            CPU_SET( cpu, cpus );
+
+        str = (*end == ',') ? end + 1 : end;
+    }
+    return CPU_COUNT( cpus ) > 0;
+}
+
+// the affinity the process had before any OpenMP thread was pinned
+//
+cpu_set_t   s_original_cpus;
+bool        s_original_cpus_saved = false;
+
+// save the affinity of the calling thread, before the OpenMP threads get pinned for the first time
+//
+void save_affinity()
+{
+    if (s_original_cpus_saved == false)
+        s_original_cpus_saved = sched_getaffinity( 0, sizeof(cpu_set_t), &s_original_cpus ) == 0;
+}
+
+} // anonymous namespace
+
+// return the number of NUMA nodes
+//
+uint32 numa_node_count()
+{
+    static uint32 n_nodes = 0u;
+    if (n_nodes == 0u)
+    {
+        // count the contiguous node directories exported by the kernel
+        uint32 n = 0u;
+        for (; n < NUMA_MAX_NODES; ++n)
+        {
+            char path[128];
+            sprintf( path, "/sys/devices/system/node/node%u", n );
+
+            struct stat info;
+            if (stat( path, &info ) != 0)
+                break;
+        }
+        n_nodes = n ? n : 1u;
+    }
+    return n_nodes;
+}
+
+// return the NUMA node the calling thread is currently running on
+//
+uint32 numa_current_node()
+{
+    unsigned int cpu  = 0u;
+    unsigned int node = 0u;
+    if (syscall( SYS_getcpu, &cpu, &node, NULL ) != 0)
+        return 0u;
+
+    return node < numa_node_count() ? node : 0u;
+}
+
+// interleave the pages overlapping a memory range across all nodes
+//
+bool numa_interleave(void* ptr, const uint64 bytes)
+{
+    const uint32 n_nodes = numa_node_count();
+    if (n_nodes == 1u)
+        return true;
+
+    unsigned long node_mask[ NUMA_MASK_WORDS ] = { 0 };
+    for (uint32 node = 0; node < n_nodes; ++node)
+        node_mask[ node / (8u * sizeof(unsigned long)) ] |= 1ul << (node % (8u * sizeof(unsigned long)));
+
+    return mbind_range( ptr, bytes, NUMA_MPOL_INTERLEAVE, node_mask );
+}
+
+// bind the pages overlapping a memory range to a given node
+//
+bool numa_bind(void* ptr, const uint64 bytes, const uint32 node)
+{
+    const uint32 n_nodes = numa_node_count();
+    if (node >= n_nodes)
+        return false;
+    if (n_nodes == 1u)
+        return true;
+
+    unsigned long node_mask[ NUMA_MASK_WORDS ] = { 0 };
+    node_mask[ node / (8u * sizeof(unsigned long)) ] |= 1ul << (node % (8u * sizeof(unsigned long)));
+
+    return mbind_range( ptr, bytes, NUMA_MPOL_BIND, node_mask );
+}
+
+// restrict the calling thread to run on the CPUs of a given node
+//
+bool numa_pin_thread(const uint32 node)
+{
+    if (node >= numa_node_count())
+        return false;
+
+    char path[128];
+    sprintf( path, "/sys/devices/system/node/node%u/cpulist", node );
+
+    FILE* file = fopen( path, "r" );
+    if (file == NULL)
+        return false;
+
+    char cpu_list[4096];
+    const bool ok = fgets( cpu_list, sizeof(cpu_list), file ) != NULL;
+    fclose( file );
+
+    cpu_set_t cpus;
+    if (ok == false || parse_cpu_list( cpu_list, &cpus ) == false)
+        return false;
+
+    return sched_setaffinity( 0, sizeof(cpu_set_t), &cpus ) == 0;
+}
+
+// let the threads of the OpenMP thread pool run again on all the CPUs they could run on
+// before being pinned
+//
+void numa_unpin_omp_threads()
+{
+    if (s_original_cpus_saved == false)
+        return;
+
+    #pragma omp parallel
+    {
+        sched_setaffinity( 0, sizeof(cpu_set_t), &s_original_cpus );
+    }
+}
+
+#else
+
+uint32 numa_node_count()                                            { return 1u; }
+uint32 numa_current_node()                                          { return 0u; }
+bool   numa_interleave(void* ptr, const uint64 bytes)               { return true; }
+bool   numa_bind(void* ptr, const uint64 bytes, const uint32 node)  { return node == 0u; }
+bool   numa_pin_thread(const uint32 node)                           { return node == 0u; }
+void   numa_unpin_omp_threads()                                     {}
+
+#endif
+
+// apply a placement to a memory range
+//
+bool numa_place(void* ptr, const uint64 bytes, const NUMAPlacement placement)
+{
+    if (placement.policy == NUMA_INTERLEAVE)
+        return numa_interleave( ptr, bytes );
+    else if (placement.policy == NUMA_BIND)
+        return numa_bind( ptr, bytes, placement.node );
+
+    return true;
+}
+
+// pin the threads of the OpenMP thread pool according to a placement
+//
+void numa_pin_omp_threads(const NUMAPlacement placement)
+{
+    if (placement.policy == NUMA_DEFAULT)
+        return;
+
+    const uint32 n_nodes = numa_node_count();
+
+  #if defined(__linux__)
+    // remember the affinity to restore in numa_unpin_omp_threads()
+    save_affinity();
+  #endif
+
+    #pragma omp parallel
+    {
+        const uint32 node = placement.policy == NUMA_BIND ?
+            placement.node :
+            uint32( omp_get_thread_num() ) % n_nodes;
+
+        numa_pin_thread( node );
+    }
+}
+
+// parse a NUMA placement from a string
+//
+bool parse_numa_placement(const char* str, NUMAPlacement* placement)
+{
+    if (strcmp( str, "default" ) == 0)
+        *placement = NUMAPlacement( NUMA_DEFAULT );
+    else if (strcmp( str, "interleave" ) == 0)
+        *placement = NUMAPlacement( NUMA_INTERLEAVE );
+    else if (strcmp( str, "replicate" ) == 0)
+        *placement = NUMAPlacement( NUMA_REPLICATE );
+    else if (strcmp( str, "bind" ) == 0)
+        *placement = NUMAPlacement( NUMA_BIND, 0u );
+    else if (strncmp( str, "bind:", 5 ) == 0)
+        *placement = NUMAPlacement( NUMA_BIND, uint32( atoi( str + 5 ) ) );
+    else
+        return false;
+
+    return true;
+}
+
+// return the name of a NUMA policy
+//
+const char* numa_policy_string(const NUMAPolicy policy)
+{
+    switch (policy)
+    {
+    case NUMA_INTERLEAVE:   return "interleave";
+    case NUMA_BIND:         return "bind";
+    case NUMA_REPLICATE:    return "replicate";
+    default:                return "default";
+    }
+}
+
+} // namespace nvbio
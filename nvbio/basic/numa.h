@@ -0,0 +1,195 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/threads.h>
+#include <nvbio/basic/shared_pointer.h>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup Basic
+///@{
+
+///\defgroup NUMAModule NUMA
+///
+/// This module provides a few utilities to control the placement of large, read-mostly host
+/// data structures (e.g. FM-indices and reference sequences) on NUMA systems, where memory
+/// allocated by a given thread is by default placed on the node that thread runs on, and
+/// every access from the other nodes pays the extra latency of the interconnect.
+/// Three placement policies are supported:
+///
+/// - NUMA_INTERLEAVE: spread the pages round-robin across all nodes, so that all threads see
+///   the same average latency and bandwidth is aggregated across all memory controllers;
+/// - NUMA_BIND: place all pages on a single node, typically the one worker threads are pinned to;
+/// - NUMA_REPLICATE: keep one full copy of the data on each node (see NUMAReplicas), trading
+///   memory for purely local accesses.
+///
+/// All functions degrade gracefully to no-ops on systems with a single node and on
+/// platforms other than Linux.
+///
+
+///@addtogroup NUMAModule
+///@{
+
+/// NUMA placement policies
+///
+enum NUMAPolicy
+{
+    NUMA_DEFAULT    = 0,    ///< leave the placement to the OS, i.e. first-touch
+    NUMA_INTERLEAVE = 1,    ///< interleave pages across all nodes
+    NUMA_BIND       = 2,    ///< bind pages to a given node
+    NUMA_REPLICATE  = 3,    ///< replicate the data on each node
+};
+
+/// A NUMA placement, i.e. a policy together with the node used by NUMA_BIND
+///
+struct NUMAPlacement
+{
+    /// constructor
+    ///
+    NUMAPlacement(const NUMAPolicy _policy = NUMA_DEFAULT, const uint32 _node = 0u) :
+        policy( _policy ), node( _node ) {}
+
+    NUMAPolicy policy;
+    uint32     node;
+};
+
+/// parse a NUMA placement from a string, one of "default", "interleave", "replicate", "bind" or "bind:N"
+///
+/// \return false if the string is not recognized
+///
+bool parse_numa_placement(const char* str, NUMAPlacement* placement);
+
+/// return the name of a NUMA policy
+///
+const char* numa_policy_string(const NUMAPolicy policy);
+
+/// return the number of NUMA nodes
+///
+uint32 numa_node_count();
+
+/// return the NUMA node the calling thread is currently running on
+///
+uint32 numa_current_node();
+
+/// interleave the pages overlapping a memory range across all nodes, migrating any page
+/// which has already been touched
+///
+bool numa_interleave(void* ptr, const uint64 bytes);
+
+/// bind the pages overlapping a memory range to a given node, migrating any page
+/// which has already been touched
+///
+bool numa_bind(void* ptr, const uint64 bytes, const uint32 node);
+
+/// apply a placement to a memory range: NUMA_INTERLEAVE and NUMA_BIND are applied with
+/// numa_interleave() and numa_bind() respectively, while the other policies leave the
+/// range untouched
+///
+bool numa_place(void* ptr, const uint64 bytes, const NUMAPlacement placement);
+
+/// restrict the calling thread to run on the CPUs of a given node
+///
+bool numa_pin_thread(const uint32 node);
+
+/// pin the threads of the OpenMP thread pool according to a placement:
+/// with NUMA_BIND all threads are pinned to the given node, with NUMA_INTERLEAVE and
+/// NUMA_REPLICATE thread i is pinned to node i % numa_node_count(), while NUMA_DEFAULT
+/// leaves their current affinity untouched.
+/// As the OpenMP runtime reuses the same threads across parallel regions with the same
+/// number of threads, the pinning persists for the following regions, until
+/// numa_unpin_omp_threads() is called.
+///
+void numa_pin_omp_threads(const NUMAPlacement placement);
+
+/// undo numa_pin_omp_threads(), letting the threads of the OpenMP thread pool run again on
+/// all the CPUs the process could run on before they were first pinned
+///
+void numa_unpin_omp_threads();
+
+///
+/// A set of replicas of a host data structure, one per NUMA node.
+/// Each replica is copy-constructed by a thread pinned to its node, so that its storage
+/// is first-touched, and hence placed, on that node.
+///
+/// \tparam T       the replicated type, which must be copy-constructible
+///
+template <typename T>
+struct NUMAReplicas
+{
+    /// build one replica of a given object per node
+    ///
+    void build(const T& src);
+
+    /// return the number of replicas
+    ///
+    uint32 size() const { return uint32( m_replicas.size() ); }
+
+    /// return the replica placed on a given node
+    ///
+    const T& operator[] (const uint32 node) const { return *m_replicas[ node ]; }
+
+    /// return the replica placed on the node the calling thread is running on
+    ///
+    const T& local() const { return *m_replicas[ numa_current_node() % size() ]; }
+
+private:
+    struct ReplicaThread : public Thread<ReplicaThread>
+    {
+        ReplicaThread(const T& src, const uint32 node, SharedPointer<T>* replica) :
+            m_src( &src ), m_node( node ), m_replica( replica ) {}
+
+        void run()
+        {
+            numa_pin_thread( m_node );
+            *m_replica = SharedPointer<T>( new T( *m_src ) );
+        }
+
+        const T*            m_src;
+        uint32              m_node;
+        SharedPointer<T>*   m_replica;
+    };
+
+    std::vector< SharedPointer<T> > m_replicas;
+};
+
+// build one replica of a given object per node
+//
+template <typename T>
+void NUMAReplicas<T>::build(const T& src)
+{
+    const uint32 n_nodes = numa_node_count();
+
+    m_replicas.resize( n_nodes );
+
+    // build the replicas one at a time, so as not to oversubscribe the memory bandwidth
+    for (uint32 node = 0; node < n_nodes; ++node)
+    {
+        ReplicaThread thread( src, node, &m_replicas[ node ] );
+        thread.create();
+        thread.join();
+    }
+}
+
+///@} NUMAModule
+///@} Basic
+
+} // namespace nvbio
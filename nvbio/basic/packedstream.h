@@ -20,6 +20,7 @@
 
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/numbers.h>
+#include <nvbio/basic/popcount.h>
 #include <nvbio/basic/strided_iterator.h>
 #include <nvbio/basic/iterator.h>
 #if defined(__CUDACC__)
@@ -335,6 +336,39 @@ void assign(
     InputIterator                                                                                   input_string,
     PackedStream<InputStream,Symbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                           packed_string);
 
+/// assign a packed sequence to a packed stream with the same symbol size and endianness.
+/// When both streams are backed by the same integral word type and the symbols tile the words
+/// exactly, the copy proceeds a whole word at a time, funnel-shifting the input words when the
+/// two streams are not aligned to each other; the symbols surrounding the output range are preserved.
+///
+template <typename InStream, typename InSymbol, typename OutStream, typename OutSymbol, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
+NVBIO_HOST_DEVICE
+void assign(
+    const IndexType                                                                                 input_len,
+    const PackedStream<InStream,InSymbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                      input_string,
+    PackedStream<OutStream,OutSymbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                          packed_string);
+
+/// return the length of the longest common prefix of two packed strings of length len,
+/// comparing a whole word of symbols at a time whenever the streams allow it (see assign())
+///
+template <typename Stream1, typename Symbol1, typename Stream2, typename Symbol2, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
+NVBIO_HOST_DEVICE
+IndexType lcp(
+    const IndexType                                                                                 len,
+    const PackedStream<Stream1,Symbol1,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                        string1,
+    const PackedStream<Stream2,Symbol2,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                        string2);
+
+/// lexicographically compare two packed strings, returning -1, 0 or +1 if the first is
+/// respectively less than, equal to or greater than the second
+///
+template <typename Stream1, typename Symbol1, typename Stream2, typename Symbol2, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
+NVBIO_HOST_DEVICE
+int32 compare(
+    const IndexType                                                                                 len1,
+    const PackedStream<Stream1,Symbol1,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                        string1,
+    const IndexType                                                                                 len2,
+    const PackedStream<Stream2,Symbol2,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                        string2);
+
 /// PackedStream specialization of the stream_traits class, providing compile-time information about the
 /// corresponding string type
 ///
@@ -526,7 +526,7 @@ struct packer<BIG_ENDIAN_T,4u,Symbol,InputStream,IndexType,uint64>
 
         typedef typename unsigned_type<IndexType>::type index_type;
 
-        const index_type word_idx = sym_idx >> 5u;
+        const index_type word_idx = sym_idx >> 4u;
 
         const uint64 word = stream[ word_idx ];
         const uint32 symbol_offset = BIG_ENDIAN_T ? (60u - (uint32(sym_idx & 15u) << 2)) : uint32((sym_idx & 15u) << 2);
@@ -541,14 +541,14 @@ struct packer<BIG_ENDIAN_T,4u,Symbol,InputStream,IndexType,uint64>
 
         typedef typename unsigned_type<IndexType>::type index_type;
 
-        const index_type word_idx = sym_idx >> 5u;
+        const index_type word_idx = sym_idx >> 4u;
 
               uint64 word = stream[ word_idx ];
         const uint32 symbol_offset = BIG_ENDIAN_T ? (60u - (uint32(sym_idx & 15u) << 2)) : uint32((sym_idx & 15u) << 2);
-        const uint64 symbol = uint32(sym & SYMBOL_MASK) << symbol_offset;
+        const uint64 symbol = uint64(sym & SYMBOL_MASK) << symbol_offset;
 
         // clear all bits
-        word &= ~(SYMBOL_MASK << symbol_offset);
+        word &= ~(uint64(SYMBOL_MASK) << symbol_offset);
 
         // set bits
         stream[ word_idx ] = word | symbol;
@@ -740,11 +740,11 @@ NVBIO_FORCEINLINE NVBIO_HOST_DEVICE bool operator!= (
     return it1.stream() != it2.stream() || it1.index() != it2.index();
 }
 
-// assign a sequence to a packed stream
+// assign a sequence to a packed stream, encoding a word's worth of symbols at a time
 //
 template <typename InputIterator, typename InputStream, typename Symbol, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
 NVBIO_HOST_DEVICE
-void assign(
+void assign_symbols(
     const IndexType                                                                                 input_len,
     InputIterator                                                                                   input_string,
     PackedStream<InputStream,Symbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                           packed_string)
@@ -769,7 +769,7 @@ void assign(
     if (word_offset)
     {
         // compute how many symbols we still need to encode to fill the current word
-        word_rem = SYMBOLS_PER_WORD - word_offset;
+        word_rem = nvbio::min( SYMBOLS_PER_WORD - word_offset, uint32( input_len ) );
 
         // fetch the word in question
         word_type word = words[ stream_offset / SYMBOLS_PER_WORD ];
@@ -800,11 +800,13 @@ void assign(
   #endif
     for (int64 i = word_rem; i < int64( input_len ); i += SYMBOLS_PER_WORD)
     {
-        // encode a word's worth of characters
-        word_type word = 0u;
+        const uint32 word_idx = uint32( (stream_offset + IndexType(i)) / SYMBOLS_PER_WORD );
 
         const uint32 n_symbols = nvbio::min( SYMBOLS_PER_WORD, uint32( input_len - IndexType(i) ) );
 
+        // encode a word's worth of characters, preserving the symbols past the end of the input
+        word_type word = n_symbols < SYMBOLS_PER_WORD ? words[ word_idx ] : word_type(0u);
+
         // loop through the word's bp's
         for (uint32 j = 0; j < SYMBOLS_PER_WORD; ++j)
         {
@@ -817,18 +819,309 @@ void assign(
                 const uint32 symbol_offset = BIG_ENDIAN ? (WORD_SIZE - SYMBOL_SIZE - bit_idx) : bit_idx;
                 const word_type     symbol = word_type(bp) << symbol_offset;
 
+                // clear all bits
+                word &= ~(word_type(SYMBOL_MASK) << symbol_offset);
+
                 // set bits
                 word |= symbol;
             }
         }
 
         // write out the word
-        const uint32 word_idx = uint32( (stream_offset + IndexType(i)) / SYMBOLS_PER_WORD );
-
         words[ word_idx ] = word;
     }
 }
 
+// assign a sequence to a packed stream
+//
+template <typename InputIterator, typename InputStream, typename Symbol, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
+NVBIO_HOST_DEVICE
+void assign(
+    const IndexType                                                                                 input_len,
+    InputIterator                                                                                   input_string,
+    PackedStream<InputStream,Symbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                           packed_string)
+{
+    assign_symbols( input_len, input_string, packed_string );
+}
+
+// count the trailing zeros of a non-zero word
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 packed_tzc(const uint32 x) { return ffs( int32(x) ) - 1u; }
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 packed_tzc(const uint64 x)
+{
+    return uint32(x) ? packed_tzc( uint32(x) ) : 32u + packed_tzc( uint32(x >> 32) );
+}
+
+// count the leading zeros of a non-zero word
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 packed_lzc(const uint32 x) { return lzc( x ); }
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 packed_lzc(const uint64 x)
+{
+    return uint32(x >> 32) ? lzc( uint32(x >> 32) ) : 32u + lzc( uint32(x) );
+}
+
+// the word types supporting the bulk PackedStream operations
+//
+template <typename word_type> struct packed_word_traits         { static const bool BULK = false; };
+template <>                   struct packed_word_traits<uint32> { static const bool BULK = true; };
+template <>                   struct packed_word_traits<uint64> { static const bool BULK = true; };
+
+// word-level helpers for the bulk PackedStream operations: a word is seen as a sequence of
+// SYMBOLS_PER_WORD symbol slots, where slot 0 holds the first symbol, i.e. the least significant
+// one for little-endian streams, and the most significant one for big-endian streams
+//
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN_T, typename word_type>
+struct packed_words
+{
+    static const uint32 WORD_SIZE        = uint32( 8u * sizeof(word_type) );
+    static const uint32 SYMBOLS_PER_WORD = WORD_SIZE / SYMBOL_SIZE;
+
+    // return the mask of the first n slots, n in [0,SYMBOLS_PER_WORD]
+    //
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE word_type mask(const uint32 n)
+    {
+        if (n >= SYMBOLS_PER_WORD)
+            return ~word_type(0);
+
+        return BIG_ENDIAN_T ?
+            word_type( ~(~word_type(0) >> (n * SYMBOL_SIZE)) ) :
+            word_type( (word_type(1u) << (n * SYMBOL_SIZE)) - 1u );
+    }
+
+    // move the symbols of a word n slots forward, n in [0,SYMBOLS_PER_WORD)
+    //
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE word_type forward(const word_type w, const uint32 n)
+    {
+        return BIG_ENDIAN_T ? w >> (n * SYMBOL_SIZE) : w << (n * SYMBOL_SIZE);
+    }
+
+    // move the symbols of a word n slots backwards, n in [0,SYMBOLS_PER_WORD)
+    //
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE word_type backwards(const word_type w, const uint32 n)
+    {
+        return BIG_ENDIAN_T ? w << (n * SYMBOL_SIZE) : w >> (n * SYMBOL_SIZE);
+    }
+
+    // return the first slot holding a non-zero symbol of a non-zero word
+    //
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 first_set(const word_type w)
+    {
+        return (BIG_ENDIAN_T ? packed_lzc( w ) : packed_tzc( w )) / SYMBOL_SIZE;
+    }
+
+    // load the n symbols (n in [1,SYMBOLS_PER_WORD]) starting at sym_idx into the first n slots
+    // of a word, funnel-shifting two consecutive words if needed; the remaining slots are undefined
+    //
+    template <typename Stream, typename IndexType>
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE word_type load(const Stream words, const IndexType sym_idx, const uint32 n)
+    {
+        const IndexType word_idx = sym_idx / SYMBOLS_PER_WORD;
+        const uint32    offset   = uint32( sym_idx % SYMBOLS_PER_WORD );
+
+        const word_type w = backwards( words[ word_idx ], offset );
+        return offset + n > SYMBOLS_PER_WORD ?
+            w | forward( words[ word_idx+1 ], SYMBOLS_PER_WORD - offset ) : w;
+    }
+
+    // store the first n symbols of a word at slots [offset, offset + n) of the given word,
+    // preserving all other slots
+    //
+    template <typename Stream, typename IndexType>
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void store(Stream words, const IndexType word_idx, const uint32 offset, const uint32 n, const word_type w)
+    {
+        const word_type m = forward( mask( n ), offset );
+        const word_type word = words[ word_idx ];
+        words[ word_idx ] = (word & ~m) | (forward( w, offset ) & m);
+    }
+};
+
+// dispatch the bulk PackedStream operations to their word-parallel implementation, if possible
+//
+template <bool BULK>
+struct packed_stream_bulk {};
+
+// the generic, symbol-by-symbol implementation
+//
+template <>
+struct packed_stream_bulk<false>
+{
+    template <typename InStream, typename OutStream, typename IndexType>
+    static NVBIO_HOST_DEVICE void assign(const IndexType input_len, const InStream input_string, OutStream packed_string)
+    {
+        assign_symbols( input_len, input_string, packed_string );
+    }
+
+    template <typename Stream1, typename Stream2, typename IndexType>
+    static NVBIO_HOST_DEVICE IndexType lcp(const IndexType len, const Stream1 string1, const Stream2 string2)
+    {
+        IndexType i = 0;
+        while (i < len && string1[i] == string2[i])
+            ++i;
+
+        return i;
+    }
+};
+
+// the word-parallel implementation
+//
+template <>
+struct packed_stream_bulk<true>
+{
+    template <typename InStream, typename OutStream, typename IndexType>
+    static NVBIO_HOST_DEVICE void assign(const IndexType input_len, const InStream input_string, OutStream packed_string)
+    {
+        typedef typename OutStream::storage_type                                                word_type;
+        typedef packed_words<OutStream::SYMBOL_SIZE, OutStream::BIG_ENDIAN != 0, word_type>     words_type;
+
+        const uint32 SYMBOLS_PER_WORD = words_type::SYMBOLS_PER_WORD;
+
+        if (input_len == 0)
+            return;
+
+        typename InStream::stream_type  in_words  = input_string.stream();
+        typename OutStream::stream_type out_words = packed_string.stream();
+
+        const IndexType in_offset  = input_string.index();
+        const IndexType out_offset = packed_string.index();
+
+        // fill the first output word, if partially covered
+        const uint32    head_offset = uint32( out_offset % SYMBOLS_PER_WORD );
+        const IndexType head_len    = head_offset ?
+            nvbio::min( input_len, IndexType( SYMBOLS_PER_WORD - head_offset ) ) : IndexType(0);
+
+        if (head_len)
+        {
+            words_type::store(
+                out_words,
+                out_offset / SYMBOLS_PER_WORD,
+                head_offset,
+                uint32( head_len ),
+                words_type::load( in_words, in_offset, uint32( head_len ) ) );
+        }
+
+        // copy all full output words
+        const IndexType n_words   = (input_len - head_len) / SYMBOLS_PER_WORD;
+        const IndexType out_word0 = (out_offset + head_len) / SYMBOLS_PER_WORD;
+        const IndexType in_sym0   = in_offset + head_len;
+
+      #if defined(_OPENMP) && !defined(NVBIO_DEVICE_COMPILATION)
+        #pragma omp parallel for if (n_words > 100000)
+      #endif
+        for (int64 i = 0; i < int64( n_words ); ++i)
+            out_words[ out_word0 + IndexType(i) ] = words_type::load( in_words, in_sym0 + IndexType(i) * SYMBOLS_PER_WORD, SYMBOLS_PER_WORD );
+
+        // and fill the last output word, if partially covered
+        const IndexType tail_begin = head_len + n_words * SYMBOLS_PER_WORD;
+        const uint32    tail_len   = uint32( input_len - tail_begin );
+        if (tail_len)
+        {
+            words_type::store(
+                out_words,
+                out_word0 + n_words,
+                0u,
+                tail_len,
+                words_type::load( in_words, in_offset + tail_begin, tail_len ) );
+        }
+    }
+
+    template <typename Stream1, typename Stream2, typename IndexType>
+    static NVBIO_HOST_DEVICE IndexType lcp(const IndexType len, const Stream1 string1, const Stream2 string2)
+    {
+        typedef typename Stream1::storage_type                                                  word_type;
+        typedef packed_words<Stream1::SYMBOL_SIZE, Stream1::BIG_ENDIAN != 0, word_type>         words_type;
+
+        const uint32 SYMBOLS_PER_WORD = words_type::SYMBOLS_PER_WORD;
+
+        typename Stream1::stream_type words1 = string1.stream();
+        typename Stream2::stream_type words2 = string2.stream();
+
+        const IndexType offset1 = string1.index();
+        const IndexType offset2 = string2.index();
+
+        for (IndexType i = 0; i < len; i += SYMBOLS_PER_WORD)
+        {
+            const uint32 n = uint32( nvbio::min( len - i, IndexType( SYMBOLS_PER_WORD ) ) );
+
+            // xor a word's worth of symbols, and look for the first non-zero slot
+            const word_type diff =
+                (words_type::load( words1, offset1 + i, n ) ^
+                 words_type::load( words2, offset2 + i, n )) & words_type::mask( n );
+
+            if (diff)
+                return i + words_type::first_set( diff );
+        }
+        return len;
+    }
+};
+
+// select the bulk implementation for a pair of packed streams
+//
+template <typename Stream1, typename Stream2>
+struct packed_stream_bulk_selector
+{
+    typedef typename Stream1::storage_type word_type;
+
+    static const bool BULK =
+        same_type<word_type, typename Stream2::storage_type>::pred &&
+        packed_word_traits<word_type>::BULK &&
+        (8u * sizeof(word_type)) % Stream1::SYMBOL_SIZE == 0u;
+
+    typedef packed_stream_bulk<BULK> type;
+};
+
+// assign a packed sequence to a packed stream with the same symbol size and endianness
+//
+template <typename InStream, typename InSymbol, typename OutStream, typename OutSymbol, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
+NVBIO_HOST_DEVICE
+void assign(
+    const IndexType                                                                                 input_len,
+    const PackedStream<InStream,InSymbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                      input_string,
+    PackedStream<OutStream,OutSymbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                          packed_string)
+{
+    typedef PackedStream<InStream,InSymbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>    in_stream_type;
+    typedef PackedStream<OutStream,OutSymbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>  out_stream_type;
+
+    packed_stream_bulk_selector<in_stream_type,out_stream_type>::type::assign( input_len, input_string, packed_string );
+}
+
+// return the length of the longest common prefix of two packed strings of length len
+//
+template <typename Stream1, typename Symbol1, typename Stream2, typename Symbol2, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
+NVBIO_HOST_DEVICE
+IndexType lcp(
+    const IndexType                                                                                 len,
+    const PackedStream<Stream1,Symbol1,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                        string1,
+    const PackedStream<Stream2,Symbol2,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                        string2)
+{
+    typedef PackedStream<Stream1,Symbol1,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType> stream_type1;
+    typedef PackedStream<Stream2,Symbol2,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType> stream_type2;
+
+    return packed_stream_bulk_selector<stream_type1,stream_type2>::type::lcp( len, string1, string2 );
+}
+
+// lexicographically compare two packed strings
+//
+template <typename Stream1, typename Symbol1, typename Stream2, typename Symbol2, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
+NVBIO_HOST_DEVICE
+int32 compare(
+    const IndexType                                                                                 len1,
+    const PackedStream<Stream1,Symbol1,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                        string1,
+    const IndexType                                                                                 len2,
+    const PackedStream<Stream2,Symbol2,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>                        string2)
+{
+    const IndexType len = nvbio::min( len1, len2 );
+    const IndexType l   = lcp( len, string1, string2 );
+
+    if (l < len)
+    {
+        const uint32 c1 = uint32( string1[l] );
+        const uint32 c2 = uint32( string2[l] );
+        return c1 < c2 ? -1 : 1;
+    }
+    return len1 < len2 ? -1 :
+           len1 > len2 ?  1 : 0;
+}
+
 //
 // A utility function to transpose a set of packed input streams:
 //   the symbols of the i-th input stream is supposed to be stored contiguously in the range [offset(i), offset + N(i)]
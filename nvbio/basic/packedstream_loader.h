@@ -24,10 +24,12 @@
 #include <nvbio/basic/strided_iterator.h>
 #include <nvbio/basic/cuda/arch.h>
 #include <nvbio/basic/iterator.h>
+#include <stdlib.h>
 
 namespace nvbio {
 
 template <uint32 CACHE_SIZE> struct lmem_cache_tag {};
+template <uint32 CACHE_SIZE> struct host_cache_tag {};
 
 struct uncached_tag  {};
 
@@ -152,6 +154,97 @@ struct PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,uncached_ta
         const uint32            rev_flag);
 };
 
+///
+/// \relates PackedStringLoader
+/// A host-side cache, unpacking a window of a packed-string into a small buffer of plain symbols and
+/// presenting a plain pointer to the unpacked symbols.
+/// As the buffer lives within the loader itself, which is meant to be allocated on the stack, each host
+/// thread gets its own contiguous copy of the symbols, and the DP loops consuming it avoid all the shifting
+/// and masking needed to extract symbols from the packed words.
+/// The prefetch() method can be used to issue software prefetches for the words of strings that will be
+/// loaded in the near future.
+/// Strings of up to CACHE_SIZE symbols are unpacked into a buffer embedded in the loader, while the rare longer
+/// ones are unpacked into a heap buffer owned by the loader, which is grown as needed and released on destruction.
+/// NOTE: the storage words must be of integral type.
+///
+/// \tparam StorageIterator     the underlying stream of words used to hold the packed stream (e.g. uint32, uint64)
+/// \tparam SYMBOL_SIZE_T       the number of bits needed for each symbol
+/// \tparam BIG_ENDIAN_T        the "endianness" of the words: if true, symbols will be packed from right to left within each word
+/// \tparam CACHE_SIZE          the size of the unpacked symbol cache, in symbols
+///
+template <typename StorageIterator, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, uint32 CACHE_SIZE>
+struct PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >
+{
+    typedef PackedStream<StorageIterator,uint8,SYMBOL_SIZE_T,BIG_ENDIAN_T>                       input_stream;
+    typedef input_stream                                                                         input_iterator;
+    typedef typename std::iterator_traits<StorageIterator>::value_type                           storage_type;
+    typedef const uint8*                                                                         iterator;
+
+    /// constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    PackedStringLoader() : heap( NULL ), heap_size( 0u ) {}
+
+    /// copy constructor: as the loaded symbols are only accessible through the iterators
+    /// returned by load(), the copy just gets its own, empty cache
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    PackedStringLoader(const PackedStringLoader&) : heap( NULL ), heap_size( 0u ) {}
+
+    /// assignment operator: keep this loader's own cache
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    PackedStringLoader& operator=(const PackedStringLoader&) { return *this; }
+
+    /// destructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    ~PackedStringLoader() { free( heap ); }
+
+    /// given a packed stream, load part of it starting at the given offset, and return an iterator
+    /// to the first loaded symbol
+    ///
+    /// \param stream       input stream storage
+    /// \param length       length of the substring to load
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    iterator load(const input_stream stream, const uint32 length);
+
+    /// given a packed stream, and a window of symbols that is virtually mapped to the cache,
+    /// load a substring of it and return an iterator to the first symbol of the window.
+    ///
+    /// \param stream           input stream storage
+    /// \param length           length of the mapped substring
+    /// \param loaded_range     range of the substring to load
+    /// \param rev_flag         true if the range is specified wrt reversed coordinates
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    iterator load(
+        const input_stream      stream,
+        const uint32            length,
+        const uint2             loaded_range,
+        const uint32            rev_flag);
+
+    /// issue software prefetches for the words holding a packed string, so that a later load()
+    /// will find them in cache; this is a no-op on the device
+    ///
+    /// \param stream       input stream storage
+    /// \param length       length of the string
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const input_stream stream, const uint32 length);
+
+private:
+    /// return a buffer large enough to hold a string of the given length
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint8* buffer(const uint32 length);
+
+    uint8   cache[CACHE_SIZE];
+    uint8*  heap;
+    uint32  heap_size;
+};
+
 ///@} PackedStringLoaders
 ///@} PackedStreams
 ///@} Basic
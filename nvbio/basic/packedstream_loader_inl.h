@@ -98,6 +98,48 @@ make_local_string(
     return clmem_stream.begin() + word_offset;
 }
 
+// unpack the symbols [begin, end) of a packed string into a plain symbol buffer, such that
+// the i-th symbol is stored in out[i]
+template <typename StreamType,
+          typename SymbolType,
+          uint32 SYMBOL_SIZE_T,
+          bool   BIG_ENDIAN_T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void unpack_string(
+    const PackedStream<StreamType,SymbolType,SYMBOL_SIZE_T,BIG_ENDIAN_T>    in_stream,
+    const uint32                                                            begin,
+    const uint32                                                            end,
+    uint8*                                                                  out)
+{
+    typedef typename std::iterator_traits<StreamType>::value_type word_type;
+
+    const StreamType in_storage = in_stream.stream();
+
+    const uint32    SYMBOLS_PER_WORD = (sizeof(word_type)*8) / SYMBOL_SIZE_T;
+    const word_type SYMBOL_MASK      = (word_type(1u) << SYMBOL_SIZE_T) - 1u;
+    const uint32    storage_offset   = in_stream.index();
+
+    uint32 i = begin;
+    while (i < end)
+    {
+        // fetch the word containing the i-th symbol only once, and extract all the needed symbols from it
+        const uint32    word_idx    = (storage_offset + i) / SYMBOLS_PER_WORD;
+        const uint32    word_offset = (storage_offset + i) & (SYMBOLS_PER_WORD-1);
+        const uint32    n           = nvbio::min( SYMBOLS_PER_WORD - word_offset, end - i );
+        const word_type word        = in_storage[ word_idx ];
+
+        for (uint32 j = 0; j < n; ++j)
+        {
+            const uint32 shift = BIG_ENDIAN_T ?
+                (SYMBOLS_PER_WORD - 1u - (word_offset + j)) * SYMBOL_SIZE_T :
+                (word_offset + j) * SYMBOL_SIZE_T;
+
+            out[i + j] = uint8( (word >> shift) & SYMBOL_MASK );
+        }
+        i += n;
+    }
+}
+
 } // namespace priv
 
 //
@@ -124,6 +166,78 @@ PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,lmem_cache_tag<CAC
     return priv::make_local_string( stream, length, substring_range, rev_flag, lmem );
 }
 
+//
+// A utility wrapper to unpack a packed-string into a host buffer of plain symbols.
+//
+template <typename StorageIterator, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, uint32 CACHE_SIZE>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >::iterator
+PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >::load(const input_stream stream, const uint32 length)
+{
+    uint8* out = buffer( length );
+
+    priv::unpack_string( stream, 0u, length, out );
+    return out;
+}
+
+template <typename StorageIterator, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, uint32 CACHE_SIZE>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >::iterator
+PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >::load(
+    const input_stream      stream,
+    const uint32            length,
+    const uint2             substring_range,
+    const uint32            rev_flag)
+{
+    uint8* out = buffer( length );
+
+    // unpack only the symbols covered by the window, leaving them at their position within the string
+    priv::unpack_string(
+        stream,
+        rev_flag ? length - substring_range.y : substring_range.x,
+        rev_flag ? length - substring_range.x : substring_range.y,
+        out );
+
+    return out;
+}
+
+// return a buffer large enough to hold a string of the given length: the embedded cache
+// for strings of up to CACHE_SIZE symbols, and a heap buffer for the longer ones
+//
+template <typename StorageIterator, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, uint32 CACHE_SIZE>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint8* PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >::buffer(const uint32 length)
+{
+    if (length <= CACHE_SIZE)
+        return cache;
+
+    if (length > heap_size)
+    {
+        free( heap );
+        heap      = (uint8*)malloc( length );
+        heap_size = length;
+    }
+    return heap;
+}
+
+template <typename StorageIterator, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, uint32 CACHE_SIZE>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >::prefetch(const input_stream stream, const uint32 length)
+{
+    const uint32 SYMBOLS_PER_WORD = (sizeof(storage_type)*8) / SYMBOL_SIZE_T;
+    const uint32 WORDS_PER_LINE   = nvbio::max( 64u / uint32( sizeof(storage_type) ), 1u );
+
+    const uint32 begin_word = stream.index() / SYMBOLS_PER_WORD;
+    const uint32 end_word   = (stream.index() + length + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD;
+
+    // touch one word per cache line, plus the last word, which might sit on a line of its own
+    for (uint32 word = begin_word; word < end_word; word += WORDS_PER_LINE)
+        host_prefetch( stream.stream(), word );
+
+    if (end_word > begin_word)
+        host_prefetch( stream.stream(), end_word - 1u );
+}
+
 //
 // A utility wrapper to cache a packed-string into a local memory buffer and present a wrapper
 // string iterator.
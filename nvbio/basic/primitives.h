@@ -21,6 +21,7 @@
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/numbers.h>
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/exceptions.h>
 #include <nvbio/basic/vector.h>
 #include <nvbio/basic/algorithms.h>
 #include <thrust/reduce.h>
@@ -28,15 +29,14 @@
 #include <thrust/copy.h>
 #include <thrust/binary_search.h>
 #include <thrust/merge.h>
+#include <thrust/functional.h>
 #include <thrust/iterator/constant_iterator.h>
 
 #if defined(__CUDACC__)
 #include <nvbio/basic/cuda/primitives.h>
 #endif
 
-#if defined (_OPENMP)
-#include <omp.h>
-#endif
+#include <nvbio/basic/omp.h>
 
 /// \page primitives_page Parallel Primitives
 ///
@@ -44,6 +44,13 @@
 /// The backend system is specified at compile-time by a \ref SystemTags "system_tag".
 /// All temporary storage is allocated within a single nvbio::vector
 /// passed by the user, which can be safely reused across function calls.
+///\par
+/// The host backend is multi-threaded with OpenMP: scans and reductions are performed
+/// in two passes over contiguous chunks, one per thread (a per-chunk reduction followed
+/// by a scan of each chunk starting from its carry-in), and compactions first count the
+/// selected items of each chunk, and then write them out at the resulting offsets.
+/// Inputs shorter than a few tens of thousands of items are processed by a single thread.
+/// Reductions, scans and compactions accept 64-bit item counts.
 ///
 /// - nvbio::any()
 /// - nvbio::all()
@@ -138,7 +145,7 @@ void transform(
 ///
 template <typename system_tag, typename InputIterator, typename BinaryOp>
 typename std::iterator_traits<InputIterator>::value_type reduce(
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     BinaryOp                            op,
     nvbio::vector<system_tag,uint8>&    temp_storage);
@@ -153,7 +160,7 @@ typename std::iterator_traits<InputIterator>::value_type reduce(
 ///
 template <typename system_tag, typename InputIterator, typename OutputIterator, typename BinaryOp>
 void inclusive_scan(
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     BinaryOp                            op,
@@ -170,7 +177,7 @@ void inclusive_scan(
 ///
 template <typename system_tag, typename InputIterator, typename OutputIterator, typename BinaryOp, typename Identity>
 void exclusive_scan(
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     BinaryOp                            op,
@@ -188,8 +195,8 @@ void exclusive_scan(
 /// \return                     the number of copied items
 ///
 template <typename system_tag, typename InputIterator, typename FlagsIterator, typename OutputIterator>
-uint32 copy_flagged(
-    const uint32                        n,
+uint64 copy_flagged(
+    const uint64                        n,
     InputIterator                       in,
     FlagsIterator                       flags,
     OutputIterator                      out,
@@ -206,8 +213,8 @@ uint32 copy_flagged(
 /// \return                     the number of copied items
 ///
 template <typename system_tag, typename InputIterator, typename OutputIterator, typename Predicate>
-uint32 copy_if(
-    const uint32                        n,
+uint64 copy_if(
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     const Predicate                     pred,
@@ -224,8 +231,8 @@ uint32 copy_if(
 /// \return                     the number of copied items
 ///
 template <typename system_tag, typename InputIterator, typename OutputIterator, typename CountIterator>
-uint32 runlength_encode(
-    const uint32                        n,
+uint64 runlength_encode(
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     CountIterator                       counts,
@@ -244,8 +251,8 @@ uint32 runlength_encode(
 /// \return                     the number of copied items
 ///
 template <typename system_tag, typename KeyIterator, typename ValueIterator, typename OutputKeyIterator, typename OutputValueIterator, typename ReductionOp>
-uint32 reduce_by_key(
-    const uint32                        n,
+uint64 reduce_by_key(
+    const uint64                        n,
     KeyIterator                         keys_in,
     ValueIterator                       values_in,
     OutputKeyIterator                   keys_out,
@@ -367,6 +367,64 @@ void transform(
     transform( system_tag(), n, in1, in2, out, functor );
 }
 
+namespace priv {
+
+// the minimum number of items assigned to each thread by the host primitives: below this,
+// the cost of spawning threads is not amortized
+//
+const uint64 HOST_PRIMITIVES_MIN_CHUNK = 32u*1024u;
+
+// return the number of chunks (and threads) a host primitive over n items is split into
+//
+inline uint32 host_chunks(const uint64 n)
+{
+    const uint64 n_threads = uint64( omp_get_max_threads() );
+    return uint32( nvbio::max( nvbio::min( n_threads, util::divide_ri( n, HOST_PRIMITIVES_MIN_CHUNK ) ), uint64(1u) ) );
+}
+
+// return the beginning of the i-th out of n_chunks chunks of the range [0,n)
+//
+inline uint64 host_chunk_begin(const uint64 n, const uint32 n_chunks, const uint32 i)
+{
+    return (n * i) / n_chunks;
+}
+
+// carve an array of n T's out of the host temporary storage, growing it if needed
+//
+template <typename T>
+T* host_temp_array(nvbio::vector<host_tag,uint8>& temp_storage, const uint32 n)
+{
+    const uint64 bytes = uint64( n ) * sizeof(T);
+    if (temp_storage.size() < bytes)
+        temp_storage.resize( bytes );
+
+    return reinterpret_cast<T*>( nvbio::raw_pointer( temp_storage ) );
+}
+
+// the per-chunk state of a host reduce_by_key
+//
+template <typename value_type>
+struct host_reduce_by_key_chunk
+{
+    uint64      n_heads;        // the number of segments starting in this chunk
+    uint64      offset;         // the output offset of the first segment starting in this chunk
+    value_type  lead;           // the reduction of the items preceding the first head
+    bool        has_lead;       // whether the chunk starts in the middle of a segment
+};
+
+// the device primitives are limited to 32-bit item counts: return n as such, refusing
+// anything larger rather than silently truncating it
+//
+inline uint32 device_items(const uint64 n)
+{
+    if (n > uint64( 0xFFFFFFFFu ))
+        throw nvbio::runtime_error("device primitives support at most 2^32-1 items (%llu requested)", n);
+
+    return uint32( n );
+}
+
+} // namespace priv
+
 // host-wide reduce
 //
 // \param n                    number of items to reduce
@@ -377,12 +435,40 @@ void transform(
 template <typename InputIterator, typename BinaryOp>
 typename std::iterator_traits<InputIterator>::value_type reduce(
     host_tag                            tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     BinaryOp                            op,
     nvbio::vector<host_tag,uint8>&      temp_storage)
 {
-    return thrust::reduce( in, in + n, 0u, op );
+    typedef typename std::iterator_traits<InputIterator>::value_type value_type;
+
+    if (n == 0)
+        return value_type(0u);
+
+    const uint32 n_chunks = priv::host_chunks( n );
+
+    value_type* partials = priv::host_temp_array<value_type>( temp_storage, n_chunks );
+
+    // reduce each chunk
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        value_type r = in[begin];
+        for (uint64 i = begin+1; i < end; ++i)
+            r = op( r, in[i] );
+
+        partials[c] = r;
+    }
+
+    // and reduce the partials, in order, seeding the reduction with an explicit zero
+    value_type r = 0u;
+    for (uint32 c = 0; c < n_chunks; ++c)
+        r = op( r, partials[c] );
+
+    return r;
 }
 
 // host-wide inclusive scan
@@ -396,17 +482,55 @@ typename std::iterator_traits<InputIterator>::value_type reduce(
 template <typename InputIterator, typename OutputIterator, typename BinaryOp>
 void inclusive_scan(
     host_tag                            tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     BinaryOp                            op,
     nvbio::vector<host_tag,uint8>&      temp_storage)
 {
-    thrust::inclusive_scan(
-        in,
-        in + n,
-        out,
-        op );
+    typedef typename std::iterator_traits<InputIterator>::value_type value_type;
+
+    if (n == 0)
+        return;
+
+    const uint32 n_chunks = priv::host_chunks( n );
+
+    value_type* partials = priv::host_temp_array<value_type>( temp_storage, n_chunks );
+
+    // first pass: reduce each chunk but the last, whose total is not needed
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 2)
+    for (int32 c = 0; c < int32( n_chunks ) - 1; ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        value_type r = in[begin];
+        for (uint64 i = begin+1; i < end; ++i)
+            r = op( r, in[i] );
+
+        partials[c] = r;
+    }
+
+    // scan the partials, turning them into the carry-in of the following chunk
+    for (uint32 c = 1; c + 1 < n_chunks; ++c)
+        partials[c] = op( partials[c-1], partials[c] );
+
+    // second pass: scan each chunk starting from its carry-in
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        value_type r = c ? op( partials[c-1], in[begin] ) : value_type( in[begin] );
+        out[begin] = r;
+
+        for (uint64 i = begin+1; i < end; ++i)
+        {
+            r = op( r, in[i] );
+            out[i] = r;
+        }
+    }
 }
 
 // host-wide exclusive scan
@@ -421,19 +545,61 @@ void inclusive_scan(
 template <typename InputIterator, typename OutputIterator, typename BinaryOp, typename Identity>
 void exclusive_scan(
     host_tag                            tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     BinaryOp                            op,
     Identity                            identity,
     nvbio::vector<host_tag,uint8>&      temp_storage)
 {
-    thrust::exclusive_scan(
-        in,
-        in + n,
-        out,
-        identity,
-        op );
+    typedef Identity value_type;
+
+    if (n == 0)
+        return;
+
+    const uint32 n_chunks = priv::host_chunks( n );
+
+    value_type* partials = priv::host_temp_array<value_type>( temp_storage, n_chunks );
+
+    // first pass: reduce each chunk but the last, whose total is not needed
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 2)
+    for (int32 c = 0; c < int32( n_chunks ) - 1; ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        value_type r = in[begin];
+        for (uint64 i = begin+1; i < end; ++i)
+            r = op( r, in[i] );
+
+        partials[c] = r;
+    }
+
+    // exclusive scan of the partials, turning them into the carry-in of each chunk
+    value_type carry = identity;
+    for (uint32 c = 0; c + 1 < n_chunks; ++c)
+    {
+        const value_type r = partials[c];
+        partials[c] = carry;
+        carry = op( carry, r );
+    }
+    partials[ n_chunks-1 ] = carry;
+
+    // second pass: scan each chunk starting from its carry-in
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        value_type r = partials[c];
+        for (uint64 i = begin; i < end; ++i)
+        {
+            const value_type v = in[i];
+            out[i] = r;
+            r = op( r, v );
+        }
+    }
 }
 
 #if defined(__CUDACC__)
@@ -448,12 +614,12 @@ void exclusive_scan(
 template <typename InputIterator, typename BinaryOp>
 typename std::iterator_traits<InputIterator>::value_type reduce(
     device_tag                          tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     BinaryOp                            op,
     nvbio::vector<device_tag,uint8>&    temp_storage)
 {
-    return cuda::reduce( n, in, op, temp_storage );
+    return cuda::reduce( priv::device_items( n ), in, op, temp_storage );
 }
 
 // device-wide inclusive scan
@@ -467,13 +633,13 @@ typename std::iterator_traits<InputIterator>::value_type reduce(
 template <typename InputIterator, typename OutputIterator, typename BinaryOp>
 void inclusive_scan(
     device_tag                          tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     BinaryOp                            op,
     nvbio::vector<device_tag,uint8>&    temp_storage)
 {
-    cuda::inclusive_scan( n, in, out, op, temp_storage );
+    cuda::inclusive_scan( priv::device_items( n ), in, out, op, temp_storage );
 }
 
 // device-wide exclusive scan
@@ -488,14 +654,14 @@ void inclusive_scan(
 template <typename InputIterator, typename OutputIterator, typename BinaryOp, typename Identity>
 void exclusive_scan(
     device_tag                          tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     BinaryOp                            op,
     Identity                            identity,
     nvbio::vector<device_tag,uint8>&    temp_storage)
 {
-    cuda::exclusive_scan( n, in, out, op, identity, temp_storage );
+    cuda::exclusive_scan( priv::device_items( n ), in, out, op, identity, temp_storage );
 }
 
 #endif
@@ -509,7 +675,7 @@ void exclusive_scan(
 //
 template <typename system_tag, typename InputIterator, typename BinaryOp>
 typename std::iterator_traits<InputIterator>::value_type reduce(
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     BinaryOp                            op,
     nvbio::vector<system_tag,uint8>&    temp_storage)
@@ -532,7 +698,7 @@ typename std::iterator_traits<InputIterator>::value_type reduce(
 //
 template <typename system_tag, typename InputIterator, typename OutputIterator, typename BinaryOp>
 void inclusive_scan(
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     BinaryOp                            op,
@@ -558,7 +724,7 @@ void inclusive_scan(
 //
 template <typename system_tag, typename InputIterator, typename OutputIterator, typename BinaryOp, typename Identity>
 void exclusive_scan(
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     BinaryOp                            op,
@@ -586,20 +752,58 @@ void exclusive_scan(
 // \return                     the number of copied items
 //
 template <typename InputIterator, typename FlagsIterator, typename OutputIterator>
-uint32 copy_flagged(
+uint64 copy_flagged(
     const host_tag                  tag,
-    const uint32                    n,
+    const uint64                    n,
     InputIterator                   in,
     FlagsIterator                   flags,
     OutputIterator                  out,
     nvbio::vector<host_tag,uint8>&  temp_storage)
 {
-    return uint32( thrust::copy_if(
-        in,
-        in + n,
-        flags,
-        out,
-        nvbio::is_true_functor<bool>() ) - out );
+    if (n == 0)
+        return 0u;
+
+    const uint32 n_chunks = priv::host_chunks( n );
+
+    uint64* offsets = priv::host_temp_array<uint64>( temp_storage, n_chunks+1 );
+
+    // first pass: count the flagged items in each chunk but the last
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 2)
+    for (int32 c = 0; c < int32( n_chunks ) - 1; ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        uint64 count = 0;
+        for (uint64 i = begin; i < end; ++i)
+            count += flags[i] ? 1u : 0u;
+
+        offsets[c+1] = count;
+    }
+
+    // compute the output offsets
+    offsets[0] = 0u;
+    for (uint32 c = 0; c + 1 < n_chunks; ++c)
+        offsets[c+1] += offsets[c];
+
+    // second pass: compact each chunk
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        uint64 o = offsets[c];
+        for (uint64 i = begin; i < end; ++i)
+        {
+            if (flags[i])
+                out[o++] = in[i];
+        }
+        // the last chunk records the total
+        if (c == int32( n_chunks ) - 1)
+            offsets[ n_chunks ] = o;
+    }
+    return offsets[ n_chunks ];
 }
 
 // host-wide copy of predicated items
@@ -613,50 +817,61 @@ uint32 copy_flagged(
 // \return                     the number of copied items
 //
 template <typename InputIterator, typename OutputIterator, typename Predicate>
-uint32 copy_if(
+uint64 copy_if(
     const host_tag                      tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     const Predicate                     pred,
     nvbio::vector<host_tag,uint8>&      temp_storage)
 {
-    return uint32( thrust::copy_if(
-        in,
-        in + n,
-        out,
-        pred ) - out );
-}
+    if (n == 0)
+        return 0u;
 
-// system-wide run-length encode
-//
-// \param n                     number of input items
-// \param in                    a system input iterator
-// \param out                   a system output iterator
-// \param counts                a system output count iterator
-// \param temp_storage          some temporary storage
-//
-// \return                     the number of copied items
-//
-template <typename InputIterator, typename OutputIterator, typename CountIterator>
-uint32 runlength_encode(
-    const host_tag                      tag,
-    const uint32                        n,
-    InputIterator                       in,
-    OutputIterator                      out,
-    CountIterator                       counts,
-    nvbio::vector<host_tag,uint8>&      temp_storage)
-{
-    return uint32( thrust::reduce_by_key(
-        in,
-        in + n,
-        thrust::make_constant_iterator<uint32>( 1u ),
-        out,
-        counts ).first - out );
-};
+    const uint32 n_chunks = priv::host_chunks( n );
 
+    uint64* offsets = priv::host_temp_array<uint64>( temp_storage, n_chunks+1 );
 
-// system-wide run-length encode
+    // first pass: count the selected items in each chunk but the last
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 2)
+    for (int32 c = 0; c < int32( n_chunks ) - 1; ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        uint64 count = 0;
+        for (uint64 i = begin; i < end; ++i)
+            count += pred( in[i] ) ? 1u : 0u;
+
+        offsets[c+1] = count;
+    }
+
+    // compute the output offsets
+    offsets[0] = 0u;
+    for (uint32 c = 0; c + 1 < n_chunks; ++c)
+        offsets[c+1] += offsets[c];
+
+    // second pass: compact each chunk
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        uint64 o = offsets[c];
+        for (uint64 i = begin; i < end; ++i)
+        {
+            if (pred( in[i] ))
+                out[o++] = in[i];
+        }
+        // the last chunk records the total
+        if (c == int32( n_chunks ) - 1)
+            offsets[ n_chunks ] = o;
+    }
+    return offsets[ n_chunks ];
+}
+
+// host-wide reduce by key
 //
 // \param n                     number of input items
 // \param keys_in               a system input iterator
@@ -669,9 +884,9 @@ uint32 runlength_encode(
 // \return                      the number of copied items
 //
 template <typename KeyIterator, typename ValueIterator, typename OutputKeyIterator, typename OutputValueIterator, typename ReductionOp>
-uint32 reduce_by_key(
+uint64 reduce_by_key(
     const host_tag                      tag,
-    const uint32                        n,
+    const uint64                        n,
     KeyIterator                         keys_in,
     ValueIterator                       values_in,
     OutputKeyIterator                   keys_out,
@@ -679,18 +894,130 @@ uint32 reduce_by_key(
     ReductionOp                         reduction_op,
     nvbio::vector<host_tag,uint8>&      temp_storage)
 {
-    typedef typename std::iterator_traits<KeyIterator>::value_type key_type;
+    typedef typename std::iterator_traits<ValueIterator>::value_type    value_type;
+    typedef priv::host_reduce_by_key_chunk<value_type>                  chunk_type;
 
-    return uint32( thrust::reduce_by_key(
-        keys_in,
-        keys_in + n,
-        values_in,
-        keys_out,
-        values_out,
-        nvbio::equal_functor<key_type>(),
-        reduction_op ).first - keys_out );
+    if (n == 0)
+        return 0u;
+
+    const uint32 n_chunks = priv::host_chunks( n );
+
+    chunk_type* chunks = priv::host_temp_array<chunk_type>( temp_storage, n_chunks );
+
+    // first pass: reduce the items preceding the first segment head of each chunk, which
+    // belong to a segment started in a previous chunk, and count the segment heads of all
+    // chunks but the last
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        chunk_type chunk;
+        chunk.has_lead = c > 0 && keys_in[begin] == keys_in[begin-1];
+
+        uint64 i = begin;
+        if (chunk.has_lead)
+        {
+            value_type r = values_in[i];
+            for (++i; i < end && keys_in[i] == keys_in[i-1]; ++i)
+                r = reduction_op( r, values_in[i] );
+
+            chunk.lead = r;
+        }
+
+        uint64 n_heads = 0;
+        if (c < int32( n_chunks ) - 1)
+        {
+            for (; i < end; ++i)
+                n_heads += (i == 0 || !(keys_in[i] == keys_in[i-1])) ? 1u : 0u;
+        }
+        chunk.n_heads = n_heads;
+        chunks[c] = chunk;
+    }
+
+    // compute the output offsets
+    uint64 n_segments = 0;
+    for (uint32 c = 0; c < n_chunks; ++c)
+    {
+        chunks[c].offset = n_segments;
+        n_segments += chunks[c].n_heads;
+    }
+
+    // second pass: reduce the segments starting in each chunk, clipped to the chunk end
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = priv::host_chunk_begin( n, n_chunks, c );
+        const uint64 end   = priv::host_chunk_begin( n, n_chunks, c+1 );
+
+        // skip the lead
+        uint64 i = begin;
+        if (chunks[c].has_lead)
+        {
+            for (++i; i < end && keys_in[i] == keys_in[i-1]; ++i) {}
+        }
+
+        uint64 o = chunks[c].offset;
+        while (i < end)
+        {
+            keys_out[o] = keys_in[i];
+
+            value_type r = values_in[i];
+            for (++i; i < end && keys_in[i] == keys_in[i-1]; ++i)
+                r = reduction_op( r, values_in[i] );
+
+            values_out[o++] = r;
+        }
+
+        // the last chunk records the total
+        if (c == int32( n_chunks ) - 1)
+            chunks[c].n_heads = o - chunks[c].offset;
+    }
+    n_segments += chunks[ n_chunks-1 ].n_heads;
+
+    // fold the leads into the segments they belong to, in order
+    for (uint32 c = 1; c < n_chunks; ++c)
+    {
+        if (chunks[c].has_lead)
+        {
+            const uint64 o = chunks[c].offset - 1u;
+            values_out[o] = reduction_op( value_type( values_out[o] ), chunks[c].lead );
+        }
+    }
+    return n_segments;
 }
 
+// host-wide run-length encode
+//
+// \param n                     number of input items
+// \param in                    a system input iterator
+// \param out                   a system output iterator
+// \param counts                a system output count iterator
+// \param temp_storage          some temporary storage
+//
+// \return                     the number of copied items
+//
+template <typename InputIterator, typename OutputIterator, typename CountIterator>
+uint64 runlength_encode(
+    const host_tag                      tag,
+    const uint64                        n,
+    InputIterator                       in,
+    OutputIterator                      out,
+    CountIterator                       counts,
+    nvbio::vector<host_tag,uint8>&      temp_storage)
+{
+    return reduce_by_key(
+        tag,
+        n,
+        in,
+        thrust::make_constant_iterator<uint32>( 1u ),
+        out,
+        counts,
+        thrust::plus<uint32>(),
+        temp_storage );
+};
+
 #if defined(__CUDACC__)
 
 // device-wide copy of flagged items
@@ -706,13 +1033,13 @@ uint32 reduce_by_key(
 template <typename InputIterator, typename FlagsIterator, typename OutputIterator>
 uint32 copy_flagged(
     const device_tag                    tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     FlagsIterator                       flags,
     OutputIterator                      out,
     nvbio::vector<device_tag,uint8>&    temp_storage)
 {
-    return cuda::copy_flagged( n, in, flags, out, temp_storage );
+    return cuda::copy_flagged( priv::device_items( n ), in, flags, out, temp_storage );
 }
 
 // device-wide copy of predicated items
@@ -728,13 +1055,13 @@ uint32 copy_flagged(
 template <typename InputIterator, typename OutputIterator, typename Predicate>
 uint32 copy_if(
     const device_tag                    tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     const Predicate                     pred,
     nvbio::vector<device_tag,uint8>&    temp_storage)
 {
-    return cuda::copy_if( n, in, out, pred, temp_storage );
+    return cuda::copy_if( priv::device_items( n ), in, out, pred, temp_storage );
 }
 
 // system-wide run-length encode
@@ -750,13 +1077,13 @@ uint32 copy_if(
 template <typename InputIterator, typename OutputIterator, typename CountIterator>
 uint32 runlength_encode(
     const device_tag                    tag,
-    const uint32                        n,
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     CountIterator                       counts,
     nvbio::vector<device_tag,uint8>&    temp_storage)
 {
-    return cuda::runlength_encode( n, in, out, counts, temp_storage );
+    return cuda::runlength_encode( priv::device_items( n ), in, out, counts, temp_storage );
 };
 
 // device-wide run-length encode
@@ -774,7 +1101,7 @@ uint32 runlength_encode(
 template <typename KeyIterator, typename ValueIterator, typename OutputKeyIterator, typename OutputValueIterator, typename ReductionOp>
 uint32 reduce_by_key(
     const device_tag                    tag,
-    const uint32                        n,
+    const uint64                        n,
     KeyIterator                         keys_in,
     ValueIterator                       values_in,
     OutputKeyIterator                   keys_out,
@@ -783,7 +1110,7 @@ uint32 reduce_by_key(
     nvbio::vector<device_tag,uint8>&    temp_storage)
 {
     return cuda::reduce_by_key(
-        n,
+        priv::device_items( n ),
         keys_in,
         values_in,
         keys_out,
@@ -805,8 +1132,8 @@ uint32 reduce_by_key(
 // \return                     the number of copied items
 //
 template <typename system_tag, typename InputIterator, typename FlagsIterator, typename OutputIterator>
-uint32 copy_flagged(
-    const uint32                        n,
+uint64 copy_flagged(
+    const uint64                        n,
     InputIterator                       in,
     FlagsIterator                       flags,
     OutputIterator                      out,
@@ -826,8 +1153,8 @@ uint32 copy_flagged(
 // \return                     the number of copied items
 //
 template <typename system_tag, typename InputIterator, typename OutputIterator, typename Predicate>
-uint32 copy_if(
-    const uint32                        n,
+uint64 copy_if(
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     const Predicate                     pred,
@@ -847,8 +1174,8 @@ uint32 copy_if(
 // \return                     the number of copied items
 //
 template <typename system_tag, typename InputIterator, typename OutputIterator, typename CountIterator>
-uint32 runlength_encode(
-    const uint32                        n,
+uint64 runlength_encode(
+    const uint64                        n,
     InputIterator                       in,
     OutputIterator                      out,
     CountIterator                       counts,
@@ -870,8 +1197,8 @@ uint32 runlength_encode(
 // \return                      the number of copied items
 //
 template <typename system_tag, typename KeyIterator, typename ValueIterator, typename OutputKeyIterator, typename OutputValueIterator, typename ReductionOp>
-uint32 reduce_by_key(
-    const uint32                        n,
+uint64 reduce_by_key(
+    const uint64                        n,
     KeyIterator                         keys_in,
     ValueIterator                       values_in,
     OutputKeyIterator                   keys_out,
@@ -0,0 +1,506 @@
+/*
+ * nvbio
+ * Copyright (C) 2011-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvbio/basic/sort.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/omp.h>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+namespace nvbio {
+
+namespace {
+
+const uint32 RADIX_BITS     = 8u;
+const uint32 RADIX          = 1u << RADIX_BITS;
+const uint32 MAX_DIGITS     = 8u;                   // 64-bit keys
+const uint32 WC_BYTES       = 64u;                  // the size of a write-combining buffer, i.e. a cache line
+const uint64 MIN_CHUNK      = 64u*1024u;            // the minimum number of items per thread in a parallel pass
+const uint64 MSD_THRESHOLD  = 4u*1024u*1024u;       // the minimum input size to split by the most significant digit first
+const uint64 SMALL_BUCKET   = 64u;                  // the maximum bucket size sorted by insertion sort
+
+// return a mask of the lowest n_bits bits
+//
+template <typename K>
+K bit_mask(const uint32 n_bits)
+{
+    return n_bits >= sizeof(K)*8u ? K(~K(0)) : K( (K(1u) << n_bits) - 1u );
+}
+
+// advance a possibly NULL pointer
+//
+template <typename T>
+T* advance(T* ptr, const uint64 offset) { return ptr ? ptr + offset : ptr; }
+
+// the digits a sort is made of, least significant first
+//
+template <typename K>
+struct radix_digits
+{
+    radix_digits(const uint32 begin_bit, const uint32 end_bit) : n( 0u )
+    {
+        for (uint32 b = begin_bit; b < end_bit; b += RADIX_BITS, ++n)
+        {
+            shift[n] = b;
+            mask[n]  = bit_mask<K>( nvbio::min( RADIX_BITS, end_bit - b ) );
+        }
+    }
+
+    uint32 digit(const K key, const uint32 i) const { return uint32( (key >> shift[i]) & mask[i] ); }
+
+    // return the mask of the lowest n_digits digits, relative to the first one
+    K low_mask(const uint32 n_digits) const
+    {
+        K r = 0u;
+        for (uint32 i = 0; i < n_digits; ++i)
+            r |= mask[i] << (shift[i] - shift[0]);
+        return r;
+    }
+
+    uint32  n;
+    uint32  shift[MAX_DIGITS];
+    K       mask[MAX_DIGITS];
+};
+
+// the values carried along by a write-combining buffer
+//
+template <typename K, typename V>
+struct wc_values
+{
+    static const uint32 ITEMS = WC_BYTES / sizeof(K);
+
+    void put(const uint32 d, const uint32 slot, const V* in, const uint64 i) { data[d][slot] = in[i]; }
+    void flush(const uint32 d, const uint32 count, V* out, const uint64 offset) const { memcpy( out + offset, data[d], count * sizeof(V) ); }
+
+    static void copy(V* out, const V* in, const uint64 n) { memcpy( out, in, n * sizeof(V) ); }
+    static void swap(V* values, const uint64 i, const uint64 j) { std::swap( values[i], values[j] ); }
+
+    V data[RADIX][ITEMS];
+};
+
+// the key-only specialization
+//
+template <typename K>
+struct wc_values<K,null_type>
+{
+    void put(const uint32 d, const uint32 slot, const null_type* in, const uint64 i) {}
+    void flush(const uint32 d, const uint32 count, null_type* out, const uint64 offset) const {}
+
+    static void copy(null_type* out, const null_type* in, const uint64 n) {}
+    static void swap(null_type* values, const uint64 i, const uint64 j) {}
+};
+
+// the per-thread scratch space: one write-combining buffer per digit, plus the
+// histograms used by serial bucket sorts
+//
+template <typename K, typename V>
+struct radix_scratch
+{
+    static const uint32 ITEMS = WC_BYTES / sizeof(K);
+
+    K               keys[RADIX][ITEMS];
+    wc_values<K,V>  values;
+    uint32          count[RADIX];
+    uint32          limit[RADIX];
+    uint64          hist[MAX_DIGITS][RADIX];
+};
+
+// scatter the items [begin,end) of the input to their output positions by a given digit,
+// staging them in per-digit write-combining buffers that are flushed one cache line at a time
+//
+template <typename K, typename V>
+void scatter(
+    const K*                        keys_in,
+    const V*                        values_in,
+    const uint64                    begin,
+    const uint64                    end,
+          K*                        keys_out,
+          V*                        values_out,
+    const radix_digits<K>&          digits,
+    const uint32                    i,
+          uint64*                   offsets,
+          radix_scratch<K,V>&       scratch)
+{
+    const uint32 ITEMS = radix_scratch<K,V>::ITEMS;
+
+    // align all but the first flush of each digit to a cache line boundary of the output
+    for (uint32 d = 0; d < RADIX; ++d)
+    {
+        scratch.count[d] = 0u;
+        scratch.limit[d] = ITEMS - uint32( (size_t( keys_out + offsets[d] ) % WC_BYTES) / sizeof(K) );
+    }
+
+    for (uint64 j = begin; j < end; ++j)
+    {
+        const K      key  = keys_in[j];
+        const uint32 d    = digits.digit( key, i );
+        const uint32 slot = scratch.count[d];
+
+        scratch.keys[d][slot] = key;
+        scratch.values.put( d, slot, values_in, j );
+
+        if (slot+1 == scratch.limit[d])
+        {
+            memcpy( keys_out + offsets[d], scratch.keys[d], (slot+1) * sizeof(K) );
+            scratch.values.flush( d, slot+1, values_out, offsets[d] );
+
+            offsets[d]       += slot+1;
+            scratch.count[d]  = 0u;
+            scratch.limit[d]  = ITEMS;
+        }
+        else
+            scratch.count[d] = slot+1;
+    }
+
+    // flush the leftovers
+    for (uint32 d = 0; d < RADIX; ++d)
+    {
+        if (scratch.count[d])
+        {
+            memcpy( keys_out + offsets[d], scratch.keys[d], scratch.count[d] * sizeof(K) );
+            scratch.values.flush( d, scratch.count[d], values_out, offsets[d] );
+        }
+    }
+}
+
+// stable insertion sort of a short array by the key bits [shift, shift + popc(mask))
+//
+template <typename K, typename V>
+void insertion_sort(
+    const uint64    n,
+          K*        keys,
+          V*        values,
+    const uint32    shift,
+    const K         mask)
+{
+    for (uint64 i = 1; i < n; ++i)
+    {
+        for (uint64 j = i; j > 0 && ((keys[j-1] >> shift) & mask) > ((keys[j] >> shift) & mask); --j)
+        {
+            std::swap( keys[j-1], keys[j] );
+            wc_values<K,V>::swap( values, j-1, j );
+        }
+    }
+}
+
+// copy a range of keys and values with all threads
+//
+template <typename K, typename V>
+void parallel_copy(
+    const uint32    n_threads,
+    const uint64    n,
+    const K*        keys_in,
+    const V*        values_in,
+          K*        keys_out,
+          V*        values_out)
+{
+    const uint32 n_chunks = uint32( nvbio::max( nvbio::min( uint64( n_threads ), n / MIN_CHUNK ), uint64(1u) ) );
+
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = (n * c) / n_chunks;
+        const uint64 end   = (n * (c+1)) / n_chunks;
+
+        memcpy( keys_out + begin, keys_in + begin, (end - begin) * sizeof(K) );
+        wc_values<K,V>::copy( advance( values_out, begin ), advance( values_in, begin ), end - begin );
+    }
+}
+
+// perform a parallel radix sort pass over the i-th digit, returning false if the pass was
+// skipped because all keys share the same digit; in either case, the digit totals are
+// returned in totals
+//
+template <typename K, typename V>
+bool parallel_pass(
+    const uint32                        n_threads,
+    const uint64                        n,
+    const K*                            keys_in,
+    const V*                            values_in,
+          K*                            keys_out,
+          V*                            values_out,
+    const radix_digits<K>&              digits,
+    const uint32                        i,
+          std::vector<uint64>&          hist,
+          std::vector< radix_scratch<K,V> >& scratch,
+          uint64*                       totals)
+{
+    const uint32 n_chunks = uint32( nvbio::max( nvbio::min( uint64( n_threads ), n / MIN_CHUNK ), uint64(1u) ) );
+
+    // build the per-thread histograms
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = (n * c) / n_chunks;
+        const uint64 end   = (n * (c+1)) / n_chunks;
+
+        uint64* h = &hist[ c * RADIX ];
+        for (uint32 d = 0; d < RADIX; ++d)
+            h[d] = 0u;
+
+        for (uint64 j = begin; j < end; ++j)
+            ++h[ digits.digit( keys_in[j], i ) ];
+    }
+
+    bool skip = false;
+    for (uint32 d = 0; d < RADIX; ++d)
+    {
+        totals[d] = 0u;
+        for (uint32 c = 0; c < n_chunks; ++c)
+            totals[d] += hist[ c * RADIX + d ];
+
+        skip = skip || (totals[d] == n);
+    }
+    if (skip)
+        return false;
+
+    // turn the histograms into the output offsets of each thread's digits
+    uint64 sum = 0u;
+    for (uint32 d = 0; d < RADIX; ++d)
+    {
+        for (uint32 c = 0; c < n_chunks; ++c)
+        {
+            const uint64 h = hist[ c * RADIX + d ];
+            hist[ c * RADIX + d ] = sum;
+            sum += h;
+        }
+    }
+
+    // and scatter
+    #pragma omp parallel for num_threads(n_chunks) if (n_chunks > 1)
+    for (int32 c = 0; c < int32( n_chunks ); ++c)
+    {
+        const uint64 begin = (n * c) / n_chunks;
+        const uint64 end   = (n * (c+1)) / n_chunks;
+
+        scatter( keys_in, values_in, begin, end, keys_out, values_out, digits, i, &hist[ c * RADIX ], scratch[c] );
+    }
+    return true;
+}
+
+// sort the keys in [0,n) by the lowest n_digits digits with all threads, leaving the
+// result in the src buffer
+//
+template <typename K, typename V>
+void parallel_lsd_sort(
+    const uint32                        n_threads,
+    const uint64                        n,
+          K*                            keys[2],
+          V*                            values[2],
+    const uint32                        src,
+    const radix_digits<K>&              digits,
+    const uint32                        n_digits,
+          std::vector<uint64>&          hist,
+          std::vector< radix_scratch<K,V> >& scratch)
+{
+    uint64 totals[RADIX];
+
+    uint32 cur = src;
+    for (uint32 i = 0; i < n_digits; ++i)
+    {
+        if (parallel_pass( n_threads, n, keys[cur], values[cur], keys[cur^1], values[cur^1], digits, i, hist, scratch, totals ))
+            cur ^= 1;
+    }
+
+    if (cur != src)
+        parallel_copy( n_threads, n, keys[cur], values[cur], keys[src], values[src] );
+}
+
+// sort the keys in [begin,end) by the lowest n_digits digits with a single thread, leaving
+// the result in the src buffer; all the digit histograms are built in a single sweep
+//
+template <typename K, typename V>
+void serial_lsd_sort(
+    const uint64                        begin,
+    const uint64                        end,
+          K*                            keys[2],
+          V*                            values[2],
+    const uint32                        src,
+    const radix_digits<K>&              digits,
+    const uint32                        n_digits,
+          radix_scratch<K,V>&           scratch)
+{
+    const uint64 n = end - begin;
+    if (n <= SMALL_BUCKET)
+    {
+        insertion_sort(
+            n,
+            keys[src] + begin,
+            advance( values[src], begin ),
+            digits.shift[0],
+            digits.low_mask( n_digits ) );
+        return;
+    }
+
+    for (uint32 i = 0; i < n_digits; ++i)
+        for (uint32 d = 0; d < RADIX; ++d)
+            scratch.hist[i][d] = 0u;
+
+    for (uint64 j = begin; j < end; ++j)
+    {
+        const K key = keys[src][j];
+        for (uint32 i = 0; i < n_digits; ++i)
+            ++scratch.hist[i][ digits.digit( key, i ) ];
+    }
+
+    uint32 cur = src;
+    for (uint32 i = 0; i < n_digits; ++i)
+    {
+        // skip digits on which all keys agree
+        if (scratch.hist[i][ digits.digit( keys[cur][begin], i ) ] == n)
+            continue;
+
+        uint64 offsets[RADIX];
+        uint64 sum = begin;
+        for (uint32 d = 0; d < RADIX; ++d)
+        {
+            offsets[d] = sum;
+            sum += scratch.hist[i][d];
+        }
+
+        scatter( keys[cur], values[cur], begin, end, keys[cur^1], values[cur^1], digits, i, offsets, scratch );
+        cur ^= 1;
+    }
+
+    if (cur != src)
+    {
+        memcpy( keys[src] + begin, keys[cur] + begin, n * sizeof(K) );
+        wc_values<K,V>::copy( advance( values[src], begin ), advance( values[cur], begin ), n );
+    }
+}
+
+// the radix sort driver
+//
+template <typename K, typename V>
+void radix_sort(
+    const uint32    n_threads_in,
+    const uint64    n,
+          K*        keys_buffers[2],
+          V*        values_buffers[2],
+          uint32&   selector,
+    const uint32    begin_bit,
+    const uint32    end_bit_in)
+{
+    const uint32 end_bit = nvbio::min( end_bit_in, uint32( sizeof(K)*8u ) );
+    if (n <= 1u || begin_bit >= end_bit)
+        return;
+
+    const uint32 n_threads = n_threads_in ? n_threads_in : uint32( omp_get_max_threads() );
+
+    K* keys[2]   = { keys_buffers[0],   keys_buffers[1] };
+    V* values[2] = { values_buffers[0], values_buffers[1] };
+
+    const radix_digits<K> digits( begin_bit, end_bit );
+
+    std::vector< radix_scratch<K,V> > scratch( n_threads );
+
+    if (n <= SMALL_BUCKET)
+    {
+        serial_lsd_sort( 0u, n, keys, values, selector, digits, digits.n, scratch[0] );
+        return;
+    }
+
+    std::vector<uint64> hist( n_threads * RADIX );
+
+    // small inputs and short keys are sorted by plain LSD passes
+    if (n < MSD_THRESHOLD || digits.n < 3u)
+    {
+        uint64 totals[RADIX];
+
+        for (uint32 i = 0; i < digits.n; ++i)
+        {
+            if (parallel_pass( n_threads, n, keys[selector], values[selector], keys[selector^1], values[selector^1], digits, i, hist, scratch, totals ))
+                selector ^= 1;
+        }
+        return;
+    }
+
+    // split the input by the most significant digit...
+    const uint32 msd = digits.n - 1u;
+
+    uint64 totals[RADIX];
+    if (parallel_pass( n_threads, n, keys[selector], values[selector], keys[selector^1], values[selector^1], digits, msd, hist, scratch, totals ))
+        selector ^= 1;
+
+    uint64 offsets[RADIX+1];
+    offsets[0] = 0u;
+    for (uint32 d = 0; d < RADIX; ++d)
+        offsets[d+1] = offsets[d] + totals[d];
+
+    // ...sort the few buckets too large to balance across threads with all threads...
+    const uint64 large_bucket = n_threads > 1u ? n / n_threads : n + 1u;
+
+    for (uint32 d = 0; d < RADIX; ++d)
+    {
+        if (totals[d] >= large_bucket)
+        {
+            K* bucket_keys[2]   = { keys[0] + offsets[d], keys[1] + offsets[d] };
+            V* bucket_values[2] = { advance( values[0], offsets[d] ), advance( values[1], offsets[d] ) };
+
+            parallel_lsd_sort( n_threads, totals[d], bucket_keys, bucket_values, selector, digits, msd, hist, scratch );
+        }
+    }
+
+    // ...and all the others in parallel, one bucket per thread, while they fit in cache
+    #pragma omp parallel for num_threads(n_threads) schedule(dynamic,1)
+    for (int32 d = 0; d < int32( RADIX ); ++d)
+    {
+        if (totals[d] < large_bucket)
+            serial_lsd_sort( offsets[d], offsets[d+1], keys, values, selector, digits, msd, scratch[ omp_get_thread_num() ] );
+    }
+}
+
+} // anonymous namespace
+
+void HostSortEnactor::sort(const uint64 count, cuda::SortBuffers<uint32*,uint32*>& buffers, const uint32 begin_bit, const uint32 end_bit)
+{
+    radix_sort( m_n_threads, count, buffers.keys, buffers.values, buffers.selector, begin_bit, end_bit );
+}
+void HostSortEnactor::sort(const uint64 count, cuda::SortBuffers<uint32*,uint2*>& buffers, const uint32 begin_bit, const uint32 end_bit)
+{
+    radix_sort( m_n_threads, count, buffers.keys, buffers.values, buffers.selector, begin_bit, end_bit );
+}
+void HostSortEnactor::sort(const uint64 count, cuda::SortBuffers<uint32*,uint64*>& buffers, const uint32 begin_bit, const uint32 end_bit)
+{
+    radix_sort( m_n_threads, count, buffers.keys, buffers.values, buffers.selector, begin_bit, end_bit );
+}
+void HostSortEnactor::sort(const uint64 count, cuda::SortBuffers<uint64*,uint32*>& buffers, const uint32 begin_bit, const uint32 end_bit)
+{
+    radix_sort( m_n_threads, count, buffers.keys, buffers.values, buffers.selector, begin_bit, end_bit );
+}
+void HostSortEnactor::sort(const uint64 count, cuda::SortBuffers<uint64*,uint2*>& buffers, const uint32 begin_bit, const uint32 end_bit)
+{
+    radix_sort( m_n_threads, count, buffers.keys, buffers.values, buffers.selector, begin_bit, end_bit );
+}
+void HostSortEnactor::sort(const uint64 count, cuda::SortBuffers<uint64*,uint64*>& buffers, const uint32 begin_bit, const uint32 end_bit)
+{
+    radix_sort( m_n_threads, count, buffers.keys, buffers.values, buffers.selector, begin_bit, end_bit );
+}
+void HostSortEnactor::sort(const uint64 count, cuda::SortBuffers<uint32*>& buffers, const uint32 begin_bit, const uint32 end_bit)
+{
+    null_type* values[2] = { NULL, NULL };
+    radix_sort( m_n_threads, count, buffers.keys, values, buffers.selector, begin_bit, end_bit );
+}
+void HostSortEnactor::sort(const uint64 count, cuda::SortBuffers<uint64*>& buffers, const uint32 begin_bit, const uint32 end_bit)
+{
+    null_type* values[2] = { NULL, NULL };
+    radix_sort( m_n_threads, count, buffers.keys, values, buffers.selector, begin_bit, end_bit );
+}
+
+} // namespace nvbio
@@ -0,0 +1,89 @@
+/*
+ * nvbio
+ * Copyright (C) 2011-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*! \file sort.h
+ *   \brief Define host based sort primitives.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/cuda/sort.h>
+
+namespace nvbio {
+
+///@addtogroup Basic
+///@{
+
+///@addtogroup SortEnactors
+///@{
+
+/// A multi-threaded host radix sorter, exposing the same interface as cuda::SortEnactor:
+/// the input is held in <i>buffers.current_keys()</i> (and <i>buffers.current_values()</i>),
+/// the second buffer is used as temporary storage, and on exit the sorted data is found in
+/// the buffer selected by <i>buffers.selector</i>.
+/// Only the key bits in [begin_bit, end_bit) are considered, and the sort is stable.
+///\par
+/// The sort proceeds by 8-bit digits, least significant first.
+/// Each pass builds per-thread digit histograms of a contiguous chunk of the input, and
+/// scatters the chunk through small per-digit write-combining buffers, so that the output
+/// is written one full cache line at a time.
+/// Passes over digits on which all keys agree are skipped altogether.
+/// For large inputs the most significant digit is processed first, splitting the input into
+/// independent buckets which are then sorted by separate threads while they fit in cache.
+///\par
+/// Supported data-types are:
+///
+/// - uint32
+/// - uint64
+/// - (uint32,uint32)
+/// - (uint32,uint2)
+/// - (uint32,uint64)
+/// - (uint64,uint32)
+/// - (uint64,uint2)
+/// - (uint64,uint64)
+///
+struct HostSortEnactor
+{
+    /// constructor
+    ///
+    /// \param n_threads    the number of host threads; 0 means using omp_get_max_threads()
+    ///
+    HostSortEnactor(const uint32 n_threads = 0u) : m_n_threads( n_threads ) {}
+
+    /// set the number of host threads; 0 means using omp_get_max_threads()
+    ///
+    void set_threads(const uint32 n_threads) { m_n_threads = n_threads; }
+
+    void sort(const uint64 count, cuda::SortBuffers<uint32*,uint32*>& buffers, const uint32 begin_bit = 0, const uint32 end_bit = 32);
+    void sort(const uint64 count, cuda::SortBuffers<uint32*,uint2*>&  buffers, const uint32 begin_bit = 0, const uint32 end_bit = 32);
+    void sort(const uint64 count, cuda::SortBuffers<uint32*,uint64*>& buffers, const uint32 begin_bit = 0, const uint32 end_bit = 32);
+    void sort(const uint64 count, cuda::SortBuffers<uint64*,uint32*>& buffers, const uint32 begin_bit = 0, const uint32 end_bit = 64);
+    void sort(const uint64 count, cuda::SortBuffers<uint64*,uint2*>&  buffers, const uint32 begin_bit = 0, const uint32 end_bit = 64);
+    void sort(const uint64 count, cuda::SortBuffers<uint64*,uint64*>& buffers, const uint32 begin_bit = 0, const uint32 end_bit = 64);
+    void sort(const uint64 count, cuda::SortBuffers<uint32*>&         buffers, const uint32 begin_bit = 0, const uint32 end_bit = 32);
+    void sort(const uint64 count, cuda::SortBuffers<uint64*>&         buffers, const uint32 begin_bit = 0, const uint32 end_bit = 64);
+
+private:
+    uint32 m_n_threads;
+};
+
+///@} SortEnactors
+///@} Basic
+
+} // namespace nvbio
@@ -20,7 +20,11 @@
 
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/numbers.h>
+#include <nvbio/basic/iterator.h>
+#include <nvbio/basic/omp.h>
 #include <iterator>
+#include <vector>
+#include <algorithm>
 
 namespace nvbio {
 
@@ -41,7 +45,15 @@ namespace nvbio {
 /// See:
 ///
 /// - SumTree
+/// - WideSumTree
 /// - uint32 sample<Iterator>(const SumTree<Iterator>& tree, const float value)
+/// - uint32 sample<Iterator>(const WideSumTree<Iterator,FANOUT>& tree, const float value)
+///
+/// On the host, the trees can also be updated and sampled in large batches using multiple threads:
+///
+/// - batch_add()
+/// - batch_set()
+/// - batch_sample()
 ///
 /// \section SumTreeExample Example
 ///
@@ -151,12 +163,171 @@ struct SumTree
     NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
     value_type cell(const uint32 i) const { return m_cells[i]; }
 
+    /// \name Level interface, shared with WideSumTree and used by the batched operations
+    ///@{
+
+    static const uint32 FANOUT = 2u;    ///< the number of children of each internal node
+
+    /// return the underlying storage
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    iterator_type cells() const { return m_cells; }
+
+    /// return the number of levels, including the leaves (level 0) and the root
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 levels() const { return nvbio::log2( m_padded_size ) + 1u; }
+
+    /// return the offset of the first node of a given level
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 level_offset(const uint32 l) const { return m_padded_size*2u - ((m_padded_size*2u) >> l); }
+
+    /// return the number of nodes of a given level
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 level_nodes(const uint32 l) const { return m_padded_size >> l; }
+
+    /// recompute the j-th node of level l > 0 from its children
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void update_node(const uint32 l, const uint32 j);
+
+    /// select the child of the j-th node of level l > 0 containing a given value,
+    /// returning its index within level l-1 and rescaling the value to its range
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 sample_child(const uint32 l, const uint32 j, float& v) const;
+
+    ///@}
+
 private:
     iterator_type m_cells;
     uint32        m_size;
     uint32        m_padded_size;
 };
 
+///
+/// A sum tree with a wide fan-out, laid out breadth-first from the root down to the leaves.
+///\par
+/// The children of each internal node are stored contiguously, so that with the default
+/// fan-out of 16 floats or 32-bit integers they occupy exactly one 64-byte cache line
+/// (provided the storage is aligned): sampling a leaf hence touches log_16(N) cache lines,
+/// rather than the log_2(N) touched by a binary SumTree, and the topmost levels, which are
+/// shared by all samples, are packed at the beginning of the storage.
+/// Each level is padded to a multiple of the fan-out, so that the padding overhead is at most
+/// FANOUT-1 cells per level, and the total node count is about N * FANOUT / (FANOUT-1).
+///\par
+/// Like SumTree, this class is <i>storage-free</i> and can be used both in host and device code,
+/// but unlike the latter it stores the leaves at the end of the storage, and they should be
+/// accessed through the leaf_offset() method.
+///
+/// \tparam Iterator       the storage iterator
+/// \tparam FANOUT_T       the number of children of each internal node
+///
+template <typename Iterator, uint32 FANOUT_T = 16u>
+struct WideSumTree
+{
+    typedef Iterator                                              iterator_type;
+    typedef typename std::iterator_traits<Iterator>::value_type   value_type;
+
+    static const uint32 FANOUT     = FANOUT_T;  ///< the number of children of each internal node
+    static const uint32 MAX_LEVELS = 33u;       ///< the maximum number of levels
+
+    /// return the number of nodes corresponding to a given number of leaves
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    static uint32 node_count(const uint32 size);
+
+    /// constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    WideSumTree(const uint32 size, iterator_type cells);
+
+    /// return the number of leaves
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 size() const { return m_size; }
+
+    /// return the total node count
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 nodes() const { return m_offsets[0] + util::round_i( m_size, FANOUT ); }
+
+    /// return the offset of the first leaf in the storage
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 leaf_offset() const { return m_offsets[0]; }
+
+    /// setup the tree structure, given the values of the leaves
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void setup(const value_type zero = value_type(0));
+
+    /// increment a cell's value
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void add(const uint32 i, const value_type v);
+
+    /// reset a cell's value
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void set(const uint32 i, const value_type v);
+
+    /// return the total tree sum
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    value_type sum() const { return m_cells[0]; }
+
+    /// return a cell's value
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    value_type cell(const uint32 i) const { return m_cells[ m_offsets[0] + i ]; }
+
+    /// \name Level interface, shared with SumTree and used by the batched operations
+    ///@{
+
+    /// return the underlying storage
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    iterator_type cells() const { return m_cells; }
+
+    /// return the number of levels, including the leaves (level 0) and the root
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 levels() const { return m_levels; }
+
+    /// return the offset of the first node of a given level
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 level_offset(const uint32 l) const { return m_offsets[l]; }
+
+    /// return the number of nodes of a given level
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 level_nodes(const uint32 l) const { return m_nodes[l]; }
+
+    /// recompute the j-th node of level l > 0 from its children
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void update_node(const uint32 l, const uint32 j);
+
+    /// select the child of the j-th node of level l > 0 containing a given value,
+    /// returning its index within level l-1 and rescaling the value to its range
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 sample_child(const uint32 l, const uint32 j, float& v) const;
+
+    ///@}
+
+private:
+    iterator_type m_cells;
+    uint32        m_size;
+    uint32        m_levels;
+    uint32        m_offsets[MAX_LEVELS];
+    uint32        m_nodes[MAX_LEVELS];
+};
+
 /// sample a cell from a linear SumTree, returning a leaf with probability proportional to its value in the SumTree
 ///
 /// \param value        a value in the range [0,1]
@@ -166,6 +337,52 @@ template <typename Iterator>
 NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
 uint32 sample(const SumTree<Iterator>& tree, const float value);
 
+/// sample a cell from a WideSumTree, returning a leaf with probability proportional to its value in the tree
+///
+/// \param value        a value in the range [0,1]
+/// \return             the sampled cell
+///
+template <typename Iterator, uint32 FANOUT>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 sample(const WideSumTree<Iterator,FANOUT>& tree, const float value);
+
+/// increment the values of a batch of cells of a SumTree or WideSumTree using multiple host threads.
+/// The leaves are updated first, and the internal nodes are then rebuilt one level at a time,
+/// recomputing only the ancestors of the updated leaves (or all of them, if the batch is large).
+/// The same cell can appear multiple times in the batch.
+///
+/// \param tree         the tree to update
+/// \param n            the number of updates
+/// \param indices      the indices of the cells to update
+/// \param values       the increments
+///
+template <typename TreeType, typename IndexIterator, typename ValueIterator>
+void batch_add(TreeType& tree, const uint32 n, const IndexIterator indices, const ValueIterator values);
+
+/// reset the values of a batch of cells of a SumTree or WideSumTree using multiple host threads;
+/// if the same cell appears multiple times in the batch, the last value is retained.
+///
+/// \param tree         the tree to update
+/// \param n            the number of updates
+/// \param indices      the indices of the cells to update
+/// \param values       the new values
+///
+template <typename TreeType, typename IndexIterator, typename ValueIterator>
+void batch_set(TreeType& tree, const uint32 n, const IndexIterator indices, const ValueIterator values);
+
+/// sample a batch of cells from a SumTree or WideSumTree using multiple host threads, returning
+/// the same cells as calling sample() on each value.
+/// The values are processed in tiles, descending the tree level-synchronously for all the
+/// values of a tile, so that the nodes of each level are visited by many samples in a row.
+///
+/// \param tree         the tree to sample
+/// \param n            the number of samples
+/// \param values       the values in the range [0,1]
+/// \param output       the sampled cells
+///
+template <typename TreeType, typename InputIterator, typename OutputIterator>
+void batch_sample(const TreeType& tree, const uint32 n, const InputIterator values, OutputIterator output);
+
 ///@} SumTrees
 ///@} Basic
 
@@ -87,7 +87,7 @@ void SumTree<Iterator>::add(const uint32 i, const value_type v)
 {
     uint32 dst = 0;
     uint32 j   = i;
-    for (uint32 m = m_padded_size; m >= 2; m >>= 1, j >>= 1)
+    for (uint32 m = m_padded_size; m >= 1; m >>= 1, j >>= 1)
     {
         m_cells[ dst + j ] += v;
 
@@ -108,7 +108,7 @@ void SumTree<Iterator>::set(const uint32 i, const value_type v)
     uint32 parent_base = m_padded_size;
     uint32 parent      = i >> 1;
 
-    for (uint32 m = m_padded_size >> 1; m >= 2; m >>= 1, parent >>= 1)
+    for (uint32 m = m_padded_size >> 1; m >= 1; m >>= 1, parent >>= 1)
     {
         m_cells[ parent_base + parent ] =
             m_cells[ prev_base + parent*2   ] +
@@ -176,4 +176,358 @@ uint32 sample(const SumTree<Iterator>& tree, const float value)
     return node_index < size ? node_index : size - 1u;
 }
 
+// recompute the j-th node of level l > 0 from its children
+//
+template <typename Iterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void SumTree<Iterator>::update_node(const uint32 l, const uint32 j)
+{
+    const uint32 src = level_offset( l-1u );
+    const uint32 dst = level_offset( l );
+
+    // the leaves beyond the tree size are treated as zero, as in setup()
+    if (l == 1u)
+    {
+        m_cells[ dst + j ] = (j*2    < m_size ? m_cells[ j*2 ]    : value_type(0)) +
+                             (j*2+1u < m_size ? m_cells[ j*2+1u ] : value_type(0));
+    }
+    else
+        m_cells[ dst + j ] = m_cells[ src + j*2 ] + m_cells[ src + j*2 + 1u ];
+}
+
+// select the child of the j-th node of level l > 0 containing a given value;
+// this performs exactly the same steps as sample()
+//
+template <typename Iterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 SumTree<Iterator>::sample_child(const uint32 level, const uint32 j, float& v) const
+{
+    const uint32 node_index = j*2u;
+
+    if (level > 1u)
+    {
+        const uint32 node_base = level_offset( level-1u );
+
+        // choose the proper node among the selected pair.
+        const float l = float(m_cells[ node_base + node_index      ]);
+        const float r = float(m_cells[ node_base + node_index + 1u ]);
+        const float sum = float( l + r );
+
+        if (sum == 0.0f)
+            return node_index;
+
+        if (v * sum < l || r == 0.0f)
+        {
+            v = nvbio::min( v * sum / l, 1.0f );
+            return node_index;
+        }
+        else
+        {
+            v = nvbio::min( (v*sum - l) / r, 1.0f );
+            return node_index + 1u;
+        }
+    }
+    else
+    {
+        // choose the proper leaf among the selected pair.
+        const float l = node_index      < m_size ? float(m_cells[ node_index ])      : 0.0f;
+        const float r = node_index + 1u < m_size ? float(m_cells[ node_index + 1u ]) : 0.0f;
+        const float sum = float( l + r );
+
+        return (sum > 0.0f && r > 0.0f && v * sum >= l) ? node_index + 1u : node_index;
+    }
+}
+
+// return the number of nodes corresponding to a given number of leaves
+//
+template <typename Iterator, uint32 FANOUT_T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 WideSumTree<Iterator,FANOUT_T>::node_count(const uint32 size)
+{
+    // each level is padded to a multiple of the fan-out, including the root's
+    uint32 padded = util::round_i( size, FANOUT );
+    uint32 nodes  = padded;
+    uint32 n;
+    do
+    {
+        n       = padded / FANOUT;
+        padded  = util::round_i( n, FANOUT );
+        nodes  += padded;
+    }
+    while (n > 1u);
+
+    return nodes;
+}
+
+// constructor
+//
+template <typename Iterator, uint32 FANOUT_T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+WideSumTree<Iterator,FANOUT_T>::WideSumTree(const uint32 size, iterator_type cells) :
+    m_cells( cells ),
+    m_size( size )
+{
+    // compute the number of nodes of each level, from the leaves up to the root
+    uint32 padded[MAX_LEVELS];
+
+    m_nodes[0] = size;
+    padded[0]  = util::round_i( size, FANOUT );
+    m_levels   = 1u;
+    do
+    {
+        m_nodes[ m_levels ] = padded[ m_levels-1u ] / FANOUT;
+        padded[ m_levels ]  = util::round_i( m_nodes[ m_levels ], FANOUT );
+        m_levels++;
+    }
+    while (m_nodes[ m_levels-1u ] > 1u);
+
+    // and lay them out from the root down to the leaves
+    uint32 offset = 0u;
+    for (int32 l = int32( m_levels ) - 1; l >= 0; --l)
+    {
+        m_offsets[l] = offset;
+        offset += padded[l];
+    }
+}
+
+// setup the tree structure
+//
+template <typename Iterator, uint32 FANOUT_T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void WideSumTree<Iterator,FANOUT_T>::setup(const value_type zero)
+{
+    for (uint32 l = 0; l < m_levels; ++l)
+    {
+        // compute the internal nodes
+        if (l)
+        {
+            for (uint32 j = 0; j < m_nodes[l]; ++j)
+                update_node( l, j );
+        }
+
+        // and zero the padding
+        const uint32 padded = util::round_i( m_nodes[l], FANOUT );
+        for (uint32 j = m_nodes[l]; j < padded; ++j)
+            m_cells[ m_offsets[l] + j ] = zero;
+    }
+}
+
+// increment a cell's value
+//
+template <typename Iterator, uint32 FANOUT_T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void WideSumTree<Iterator,FANOUT_T>::add(const uint32 i, const value_type v)
+{
+    uint32 j = i;
+    for (uint32 l = 0; l < m_levels; ++l, j /= FANOUT)
+        m_cells[ m_offsets[l] + j ] += v;
+}
+
+// reset a cell's value
+//
+template <typename Iterator, uint32 FANOUT_T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void WideSumTree<Iterator,FANOUT_T>::set(const uint32 i, const value_type v)
+{
+    m_cells[ m_offsets[0] + i ] = v;
+
+    // recompute all the ancestors from their children
+    uint32 j = i / FANOUT;
+    for (uint32 l = 1; l < m_levels; ++l, j /= FANOUT)
+        update_node( l, j );
+}
+
+// recompute the j-th node of level l > 0 from its children
+//
+template <typename Iterator, uint32 FANOUT_T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void WideSumTree<Iterator,FANOUT_T>::update_node(const uint32 l, const uint32 j)
+{
+    const uint32 src = m_offsets[l-1u] + j * FANOUT;
+
+    value_type sum = m_cells[ src ];
+    for (uint32 c = 1; c < FANOUT; ++c)
+        sum += m_cells[ src + c ];
+
+    m_cells[ m_offsets[l] + j ] = sum;
+}
+
+// select the child of the j-th node of level l > 0 containing a given value
+//
+template <typename Iterator, uint32 FANOUT_T>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 WideSumTree<Iterator,FANOUT_T>::sample_child(const uint32 l, const uint32 j, float& v) const
+{
+    const uint32 src = m_offsets[l-1u] + j * FANOUT;
+
+    // use the node's own value as the sum of its children, which avoids a second
+    // pass over them (rounding is accounted for below)
+    const float sum = float( m_cells[ m_offsets[l] + j ] );
+    if (sum <= 0.0f)
+        return j * FANOUT;
+
+    // find the first child whose range contains the value
+    const float t = v * sum;
+
+    float  prefix = 0.0f;
+    uint32 last   = 0u;
+    for (uint32 c = 0; c < FANOUT; ++c)
+    {
+        const float child = float( m_cells[ src + c ] );
+        if (child > 0.0f)
+        {
+            if (t < prefix + child)
+            {
+                v = nvbio::min( nvbio::max( (t - prefix) / child, 0.0f ), 1.0f );
+                return j * FANOUT + c;
+            }
+            prefix += child;
+            last    = c;
+        }
+    }
+    // rounding left the value past the end: return the last non-empty child
+    v = 1.0f;
+    return j * FANOUT + last;
+}
+
+// sample a cell from a WideSumTree
+//
+template <typename Iterator, uint32 FANOUT>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 sample(const WideSumTree<Iterator,FANOUT>& tree, const float value)
+{
+    float  v = value;
+    uint32 j = 0u;
+
+    // choose the proper child of each internal node, from the root down to the leaves.
+    for (uint32 l = tree.levels() - 1u; l > 0; --l)
+        j = tree.sample_child( l, j, v );
+
+    // clamp the leaf index to the tree size
+    return j < tree.size() ? j : tree.size() - 1u;
+}
+
+namespace priv {
+
+// rebuild the internal nodes of a tree after updating a batch of leaves
+//
+template <typename TreeType>
+void sum_tree_rebuild(TreeType& tree, std::vector<uint32>& nodes)
+{
+    const uint32 n_levels = tree.levels();
+
+    // if a sizeable fraction of the leaves was touched, rebuild all levels
+    if (nodes.size() * 8u > tree.level_nodes(0))
+    {
+        for (uint32 l = 1; l < n_levels; ++l)
+        {
+            const int32 n_nodes = int32( tree.level_nodes(l) );
+
+            #pragma omp parallel for if (n_nodes >= 4096)
+            for (int32 j = 0; j < n_nodes; ++j)
+                tree.update_node( l, uint32(j) );
+        }
+        return;
+    }
+
+    // otherwise, only rebuild the ancestors of the touched leaves
+    std::sort( nodes.begin(), nodes.end() );
+    nodes.erase( std::unique( nodes.begin(), nodes.end() ), nodes.end() );
+
+    for (uint32 l = 1; l < n_levels; ++l)
+    {
+        // compute the parents of the previous level's nodes, which remain sorted
+        uint32 n_parents = 0u;
+        for (uint32 i = 0; i < uint32( nodes.size() ); ++i)
+        {
+            const uint32 parent = nodes[i] / TreeType::FANOUT;
+            if (n_parents == 0 || nodes[ n_parents-1u ] != parent)
+                nodes[ n_parents++ ] = parent;
+        }
+        nodes.resize( n_parents );
+
+        // and update them in parallel, as they are all distinct
+        #pragma omp parallel for if (n_parents >= 4096)
+        for (int32 i = 0; i < int32( n_parents ); ++i)
+            tree.update_node( l, nodes[i] );
+    }
+}
+
+} // namespace priv
+
+// increment the values of a batch of cells using multiple host threads
+//
+template <typename TreeType, typename IndexIterator, typename ValueIterator>
+void batch_add(TreeType& tree, const uint32 n, const IndexIterator indices, const ValueIterator values)
+{
+    typename TreeType::iterator_type leaves = tree.cells() + tree.level_offset(0);
+
+    std::vector<uint32> nodes( n );
+    for (uint32 i = 0; i < n; ++i)
+    {
+        nodes[i] = indices[i];
+        leaves[ indices[i] ] += values[i];
+    }
+    priv::sum_tree_rebuild( tree, nodes );
+}
+
+// reset the values of a batch of cells using multiple host threads
+//
+template <typename TreeType, typename IndexIterator, typename ValueIterator>
+void batch_set(TreeType& tree, const uint32 n, const IndexIterator indices, const ValueIterator values)
+{
+    typename TreeType::iterator_type leaves = tree.cells() + tree.level_offset(0);
+
+    std::vector<uint32> nodes( n );
+    for (uint32 i = 0; i < n; ++i)
+    {
+        nodes[i] = indices[i];
+        leaves[ indices[i] ] = values[i];
+    }
+    priv::sum_tree_rebuild( tree, nodes );
+}
+
+// sample a batch of cells using multiple host threads
+//
+template <typename TreeType, typename InputIterator, typename OutputIterator>
+void batch_sample(const TreeType& tree, const uint32 n, const InputIterator values, OutputIterator output)
+{
+    const uint32 TILE_SIZE = 256u;
+
+    const int32 n_tiles = int32( util::divide_ri( n, TILE_SIZE ) );
+
+    #pragma omp parallel for
+    for (int32 tile = 0; tile < n_tiles; ++tile)
+    {
+        const uint32 begin = uint32( tile ) * TILE_SIZE;
+        const uint32 end   = nvbio::min( begin + TILE_SIZE, n );
+
+        float  v[TILE_SIZE];
+        uint32 j[TILE_SIZE];
+
+        for (uint32 i = begin; i < end; ++i)
+        {
+            v[i - begin] = values[i];
+            j[i - begin] = 0u;
+        }
+
+        // descend all the samples of the tile one level at a time, prefetching the
+        // children of all the current nodes before visiting them, so as to overlap
+        // the cache misses of different samples
+        for (uint32 l = tree.levels() - 1u; l > 0; --l)
+        {
+            const uint32 children = tree.level_offset( l-1u );
+            for (uint32 i = 0; i < end - begin; ++i)
+                host_prefetch( tree.cells(), children + j[i] * TreeType::FANOUT );
+
+            for (uint32 i = 0; i < end - begin; ++i)
+                j[i] = tree.sample_child( l, j[i], v[i] );
+        }
+
+        // clamp the leaf indices to the tree size
+        for (uint32 i = begin; i < end; ++i)
+            output[i] = j[i - begin] < tree.size() ? j[i - begin] : tree.size() - 1u;
+    }
+}
+
 } // namespace nvbio
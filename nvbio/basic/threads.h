@@ -33,6 +33,7 @@ namespace nvbio {
 /// - Thread
 /// - Mutex
 /// - ScopedLock
+/// - Condition
 /// - WorkQueue
 ///
 
@@ -138,6 +139,8 @@ public:
     void unlock();
 
 private:
+    friend class Condition;
+
     struct Impl;
 
     SharedPointer<Impl, AtomicInt32>  m_impl;
@@ -176,6 +179,48 @@ private:
     Mutex* m_mutex;
 };
 
+/// A condition variable, to be used together with a Mutex to let threads sleep until
+/// some shared state changes, e.g.
+///
+/// \code
+/// // consumer
+/// {
+///     ScopedLock lock( &m_mutex );
+///     while (m_queue.empty())
+///         m_condition.wait( &m_mutex );
+///     ...
+/// }
+/// // producer
+/// {
+///     ScopedLock lock( &m_mutex );
+///     m_queue.push( item );
+///     m_condition.signal();
+/// }
+/// \endcode
+///
+class Condition
+{
+public:
+     Condition();
+    ~Condition();
+
+    /// atomically release the given (locked) mutex and wait to be signaled, reacquiring
+    /// the mutex before returning; as wake-ups may be spurious, the caller should always
+    /// check its predicate in a loop
+    void wait(Mutex* mutex);
+
+    /// wake up one of the waiting threads
+    void signal();
+
+    /// wake up all the waiting threads
+    void broadcast();
+
+private:
+    struct Impl;
+
+    SharedPointer<Impl, AtomicInt32>  m_impl;
+};
+
 /// Work queue class
 template <typename WorkItemT, typename ProgressCallbackT>
 class WorkQueue
@@ -22,6 +22,7 @@
 
 #include <windows.h>
 #include <winbase.h>
+#include <intrin.h>
 
 namespace nvbio {
 
@@ -53,12 +54,20 @@ float Timer::seconds() const
 	return float(double(m_stop - m_start) / double(m_freq));
 }
 
+uint64 host_ticks()
+{
+    return __rdtsc();
+}
+
 } // namespace nvbio
 
 #else
 
 #include <time.h>
 #include <sys/time.h>
+#if defined(PLATFORM_X86) || defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 namespace nvbio {
 
@@ -130,6 +139,17 @@ float Timer::seconds() const
 
 #endif
 
+uint64 host_ticks()
+{
+  #if defined(PLATFORM_X86) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+  #else
+    timespec _time;
+    clock_gettime(CLOCK_MONOTONIC,&_time);
+    return uint64(_time.tv_sec) * 1000000000u + uint64(_time.tv_nsec);
+  #endif
+}
+
 } // namespace nvbio
 
 #endif
@@ -20,9 +20,9 @@
 
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/numbers.h>
+#include <nvbio/basic/histogram.h>
 
 #include <string>
-#include <deque>
 
 namespace nvbio {
 
@@ -85,6 +85,13 @@ private:
 
 #endif
 
+///
+/// return a fine-grained, monotonically increasing tick count (the CPU time-stamp counter
+/// where available), meant to measure the relative cost of very short code sections whose
+/// duration is below the resolution of Timer; ticks are not calibrated against seconds.
+///
+uint64 host_ticks();
+
 ///
 /// A helper timer which measures the time from its instantiation
 /// to the moment it goes out of scope
@@ -111,7 +118,12 @@ struct FakeTimer
 };
 
 ///
-/// A class used to keep track of several timing statistics for repeating kernel or function calls
+/// A class used to keep track of several timing statistics for repeating kernel or function calls.
+///\par
+/// Besides the totals, each series keeps a log2 breakdown of the calls by batch size, and a
+/// fixed-memory log-linear histogram of the time taken by each call, which gives accurate latency
+/// percentiles over arbitrarily long runs.
+/// Series collected by different threads can be combined with merge().
 ///
 struct TimeSeries
 {
@@ -144,9 +156,9 @@ struct TimeSeries
         time  += t;
         device_time += dt;
         max_speed = std::max( max_speed, float(c) / t );
-        if (info.size() == 10000)
-            info.pop_front();
-        info.push_back( std::make_pair( c, t ) );
+
+        // record the latency in nanoseconds
+        latency.add( uint64( std::max( t, 0.0f ) * 1.0e9f ) );
 
         const uint32 bin = c ? nvbio::log2( c ) : 0u;
         bin_calls[bin]++;
@@ -155,9 +167,34 @@ struct TimeSeries
         bin_items[bin] += c;
     }
 
+    /// add all the samples of another series
+    ///
+    void merge(const TimeSeries& other)
+    {
+        num         += other.num;
+        calls       += other.calls;
+        time        += other.time;
+        device_time += other.device_time;
+        max_speed    = std::max( max_speed, other.max_speed );
+
+        for (uint32 i = 0; i < 32; ++i)
+        {
+            bin_calls[i] += other.bin_calls[i];
+            bin_items[i] += other.bin_items[i];
+            bin_time[i]  += other.bin_time[i];
+            bin_speed[i] += other.bin_speed[i];
+        }
+        latency.merge( other.latency );
+    }
+
     // return the average speed
     float avg_speed() const { return float(calls) / time; }
 
+    /// return the latency of a call at the given percentile, in seconds
+    ///
+    /// \param p        the requested percentile, in [0,1]
+    float latency_percentile(const float p) const { return float( latency.percentile( p ) ) * 1.0e-9f; }
+
     std::string                             name;
     std::string                             units;
 
@@ -170,7 +207,7 @@ struct TimeSeries
     uint64                                  bin_items[32];
     float                                   bin_time[32];
     float                                   bin_speed[32];
-    std::deque< std::pair<uint32,float> >   info;
+    LogLinearHistogram                      latency;        ///< the time per call, in nanoseconds
 
     float                                   user[32];
     const char*                             user_names[32];
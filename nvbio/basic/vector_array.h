@@ -22,6 +22,10 @@
 #include <nvbio/basic/thrust_view.h>
 #include <nvbio/basic/atomics.h>
 #include <nvbio/basic/vector.h>   // thrust_copy_vector
+#include <algorithm>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 namespace nvbio {
 
@@ -46,6 +50,11 @@ namespace nvbio {
 ///
 /// can be obtained with a call to the plain_view() function.
 ///
+/// On the host, vectors can be allocated concurrently by multiple threads either directly through
+/// HostVectorArray::alloc(), or through per-thread HostVectorArrayAllocator's, which reserve
+/// whole chunks of the arena at once and carve vectors out of them without further synchronization.
+/// The holes left in the arena by partially used chunks can be removed with HostVectorArray::compact().
+///
 /// \section Example
 ///
 ///\code
@@ -113,7 +122,7 @@ struct VectorArrayView
     T* alloc(const uint32 index, const uint32 size)
     {
         const uint32 slot = atomic_add( m_pool, size );
-        if (slot + size >= m_size)
+        if (slot + size > m_size)
         {
             // mark an out-of-bounds allocation
             m_index[index] = m_size;
@@ -273,7 +282,7 @@ struct DeviceVectorArray
 template <typename T>
 struct HostVectorArray
 {
-    typedef device_tag            system_tag;
+    typedef host_tag              system_tag;
     typedef VectorArrayView<T>    plain_view_type;  ///< this object's plain view type
 
     /// constructor
@@ -325,6 +334,54 @@ struct HostVectorArray
     ///
     uint32 allocated_size() const { return m_pool[0]; }
 
+    /// return allocated size
+    ///
+    uint32 arena_size() const { return m_arena.size(); }
+
+    /// alloc the vector bound to the given index, atomically bumping the shared pool counter;
+    /// this method can be called concurrently by multiple host threads
+    ///
+    /// \param index        the index of the vector to allocate
+    /// \param size         the size of the vector
+    ///
+    /// \return             a pointer to the allocated vector, or NULL if the arena is exhausted
+    ///
+    T* alloc(const uint32 index, const uint32 size) { return plain_view().alloc( index, size ); }
+
+    /// atomically reserve a contiguous chunk of the arena, without binding it to any vector;
+    /// this method can be called concurrently by multiple host threads
+    ///
+    /// \param size         the size of the chunk
+    ///
+    /// \return             the offset of the chunk in the arena, or arena_size() if the arena is exhausted
+    ///
+    uint32 reserve(const uint32 size)
+    {
+        const uint32 slot = host_atomic_add( nvbio::raw_pointer( m_pool ), size );
+        return (slot + size <= m_arena.size()) ? slot : uint32( m_arena.size() );
+    }
+
+    /// bind the i-th vector to a given slot of the arena, previously obtained through reserve()
+    ///
+    /// \param index        the index of the vector
+    /// \param slot         the offset of the vector in the arena
+    /// \param size         the size of the vector
+    ///
+    T* bind(const uint32 index, const uint32 slot, const uint32 size)
+    {
+        m_index[index] = slot;
+        m_sizes[index] = size;
+        return nvbio::raw_pointer( m_arena ) + slot;
+    }
+
+    /// compact the arena, removing the holes left by chunked and failed allocations and laying
+    /// out all vectors contiguously in index order;
+    /// this method must not be called concurrently with any allocation
+    ///
+    /// \return             the number of arena elements in use after compaction
+    ///
+    uint32 compact();
+
     /// copy operator
     ///
     HostVectorArray& operator=(const DeviceVectorArray<T>& vec)
@@ -361,6 +418,11 @@ struct HostVectorArray
     NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
     uint32 slot(const uint32 index) const { return m_index[index]; }
 
+    /// return the size of the given array
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 size(const uint32 index) const { return m_sizes[index]; }
+
     /// return the plain view of this object
     ///
     plain_view_type plain_view()
@@ -379,6 +441,114 @@ struct HostVectorArray
     thrust::host_vector<uint32>   m_pool;         ///< pool counter
 };
 
+// compact the arena, removing the holes left by chunked and failed allocations
+//
+template <typename T>
+uint32 HostVectorArray<T>::compact()
+{
+    const uint32 n_vectors  = size();
+    const uint32 arena_size = uint32( m_arena.size() );
+
+    // compute the new offsets of all successfully allocated vectors
+    thrust::host_vector<uint32> offsets( n_vectors );
+
+    uint32 n_used = 0u;
+    for (uint32 i = 0; i < n_vectors; ++i)
+    {
+        offsets[i] = n_used;
+        if (m_index[i] < arena_size)
+            n_used += m_sizes[i];
+    }
+
+    // move all vectors to a new arena, in parallel
+    thrust::host_vector<T> arena( arena_size );
+
+    const T* in_arena  = nvbio::raw_pointer( m_arena );
+          T* out_arena = nvbio::raw_pointer( arena );
+
+  #if defined(_OPENMP)
+    #pragma omp parallel for schedule(dynamic,1024)
+  #endif
+    for (int i = 0; i < int( n_vectors ); ++i)
+    {
+        if (m_index[i] < arena_size)
+        {
+            std::copy(
+                in_arena  + m_index[i],
+                in_arena  + m_index[i] + m_sizes[i],
+                out_arena + offsets[i] );
+
+            m_index[i] = offsets[i];
+        }
+    }
+
+    m_arena.swap( arena );
+    m_pool[0] = n_used;
+    return n_used;
+}
+
+///
+/// A per-thread allocator carving vectors out of a shared HostVectorArray.
+/// Rather than bumping the array's shared pool counter for each vector, this class reserves
+/// whole chunks of the arena at once and carves vectors out of them locally, so that the
+/// threads allocating vectors concurrently only contend once per chunk.
+/// Vectors larger than half a chunk are allocated directly from the shared pool.
+/// The unused tail of each chunk is left as a hole in the arena, which can be removed with
+/// HostVectorArray::compact() once all threads are done.
+///\par
+/// Each thread is meant to use its own allocator, and different threads must allocate distinct
+/// vector indices.
+///
+template <typename T>
+struct HostVectorArrayAllocator
+{
+    /// constructor
+    ///
+    /// \param array        the vector array to allocate from
+    /// \param chunk_size   the size of the chunks reserved from the shared arena
+    ///
+    HostVectorArrayAllocator(HostVectorArray<T>& array, const uint32 chunk_size = 4096u) :
+        m_array( &array ), m_chunk_size( chunk_size ), m_begin( 0u ), m_end( 0u ) {}
+
+    /// alloc the vector bound to the given index
+    ///
+    /// \param index        the index of the vector to allocate
+    /// \param size         the size of the vector
+    ///
+    /// \return             a pointer to the allocated vector, or NULL if the arena is exhausted
+    ///
+    T* alloc(const uint32 index, const uint32 size)
+    {
+        if (m_begin + size > m_end)
+        {
+            // large vectors go straight to the shared pool, leaving the current chunk in place
+            if (size > m_chunk_size/2)
+                return m_array->alloc( index, size );
+
+            // reserve a new chunk
+            const uint32 slot = m_array->reserve( m_chunk_size );
+            if (slot == m_array->arena_size())
+            {
+                // mark an out-of-bounds allocation
+                m_array->m_index[index] = m_array->arena_size();
+                m_array->m_sizes[index] = 0u;
+                return NULL;
+            }
+            m_begin = slot;
+            m_end   = slot + m_chunk_size;
+        }
+
+        const uint32 slot = m_begin;
+        m_begin += size;
+        return m_array->bind( index, slot, size );
+    }
+
+    HostVectorArray<T>* m_array;        ///< the vector array
+    uint32              m_chunk_size;   ///< the chunk size
+    uint32              m_begin;        ///< the first free slot of the current chunk
+    uint32              m_end;          ///< the end of the current chunk
+};
+
 ///\relates DeviceVectorArray
 /// return a view of the queues
 ///
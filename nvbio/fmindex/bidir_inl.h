@@ -60,6 +60,11 @@ void extend_forward(
         x += d_rank.y - d_rank.x;
     }
 
+    // the suffix P$, if present, precedes all the others: P is a suffix of T if and
+    // only if the range of P^R in r_fmi contains the row of $, i.e. r_fmi's primary
+    if (r_range.x <= r_fmi.primary() && r_fmi.primary() <= r_range.y)
+        ++x;
+
     // search for (Pc)^R = cP^R in r_fmi
     {
         const r_range_type c_rank = rank(
@@ -117,6 +122,11 @@ void extend_backwards(
         x += d_rank.y - d_rank.x;
     }
 
+    // the suffix (P$)^R of T^R, if present, precedes all the others: P is a prefix of T
+    // if and only if the range of P in f_fmi contains the row of $, i.e. f_fmi's primary
+    if (f_range.x <= f_fmi.primary() && f_fmi.primary() <= f_range.y)
+        ++x;
+
     // search for cP in f_fmi
     {
         const f_range_type c_rank = rank(
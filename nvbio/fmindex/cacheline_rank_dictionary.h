@@ -0,0 +1,237 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/popcount.h>
+#include <nvbio/basic/iterator.h>
+#include <nvbio/basic/vector.h>
+#include <vector_types.h>
+#include <vector_functions.h>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup FMIndex
+///@{
+
+///@addtogroup RankDictionaryModule
+///@{
+
+///
+/// A 64-byte block of a cacheline_rank_dictionary, holding the 4 occurrence counters
+/// at the beginning of the block followed by 192 2-bit symbols, stored in 6 little-endian
+/// 64-bit words (i.e. symbol j of each word is stored in bits [2j,2j+1]).
+///
+struct cacheline_rank_block
+{
+    static const uint32 WORDS           = 6u;                   ///< number of 64-bit payload words
+    static const uint32 SYMBOLS         = WORDS * 32u;          ///< number of symbols per block
+
+    uint32 occ[4];                                              ///< the occurrence counters at the beginning of the block
+    uint64 bwt[WORDS];                                          ///< the 2-bit payload
+};
+
+///
+/// A random access view of the text stored in a cacheline_rank_dictionary
+///
+struct cacheline_rank_text
+{
+    typedef uint8 value_type;
+    typedef uint8 reference;
+
+    /// default constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    cacheline_rank_text() {}
+
+    /// constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    cacheline_rank_text(const cacheline_rank_block* _blocks) : blocks( _blocks ) {}
+
+    /// return the i-th symbol
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint8 operator[] (const uint32 i) const;
+
+    const cacheline_rank_block* blocks;
+};
+
+///
+/// A host-friendly rank dictionary over a 2-bit alphabet, where the text is stored in
+/// 64-byte, cache-line aligned blocks holding both the occurrence counters and the
+/// symbols they refer to: any rank() query touches exactly one cache line, and is answered
+/// with at most 6 64-bit pop-counts.
+/// Compared to the fused 32-byte BWT/occurrence groups of a rank_dictionary with a
+/// 64-symbol interval this also takes less memory, i.e. 2.67 rather than 4 bits per symbol.
+///\par
+/// The dictionary exposes the same interface as rank_dictionary, and can be used as the
+/// rank dictionary of an fm_index.
+///
+struct cacheline_rank_dictionary
+{
+    static const uint32     BLOCK_INTERVAL  = cacheline_rank_block::SYMBOLS;
+    static const uint32     SYMBOL_SIZE     = 2u;
+
+    typedef cacheline_rank_text         text_type;
+    typedef uint32                      index_type;
+    typedef uint2                       range_type;
+    typedef uint2                       vec2_type;
+    typedef uint4                       vec4_type;
+
+    /// default constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    cacheline_rank_dictionary() {}
+
+    /// constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    cacheline_rank_dictionary(const cacheline_rank_block* _blocks) :
+        text( _blocks ),
+        blocks( _blocks ) {}
+
+    text_type                       text;       ///< the dictionary's text
+    const cacheline_rank_block*     blocks;     ///< the dictionary's blocks
+};
+
+///
+/// Host storage for a cacheline_rank_dictionary, keeping its blocks aligned to 64 bytes
+///
+struct CacheLineRankDictionaryHost
+{
+    typedef cacheline_rank_dictionary   dictionary_type;
+
+    /// empty constructor
+    ///
+    CacheLineRankDictionaryHost() : m_offset( 0u ) {}
+
+    /// return the number of blocks needed to hold n symbols, plus one used to align the storage
+    ///
+    static uint32 n_blocks(const uint32 n) { return util::divide_ri( n, cacheline_rank_block::SYMBOLS ) + 1u; }
+
+    /// build the dictionary of a given string
+    ///
+    /// \param begin    symbol sequence begin
+    /// \param end      symbol sequence end
+    /// \param cnt      optional table of the global counters
+    ///
+    template <typename SymbolIterator>
+    void build(
+        SymbolIterator  begin,
+        SymbolIterator  end,
+        uint32*         cnt = NULL);
+
+    /// return the number of allocated bytes
+    ///
+    uint64 allocated() const { return uint64( m_storage.size() ) * sizeof(uint64); }
+
+    /// return a pointer to the aligned blocks
+    ///
+    const cacheline_rank_block* blocks() const { return reinterpret_cast<const cacheline_rank_block*>( raw_pointer( m_storage ) + m_offset ); }
+          cacheline_rank_block* blocks()       { return reinterpret_cast<cacheline_rank_block*>( raw_pointer( m_storage ) + m_offset ); }
+
+    /// return the dictionary view
+    ///
+    dictionary_type dictionary() const { return dictionary_type( blocks() ); }
+
+    nvbio::vector<host_tag,uint64>                  m_storage;      ///< the block storage, padded by one block
+    uint32                                          m_offset;       ///< the offset of the first aligned word
+};
+
+///
+/// Build the cache-line blocks of a given string.
+/// The output must contain (n + cacheline_rank_block::SYMBOLS - 1) / cacheline_rank_block::SYMBOLS blocks.
+///
+/// Optionally save the table of the global counters as well.
+///
+/// \param begin    symbol sequence begin
+/// \param end      symbol sequence end
+/// \param blocks   output blocks
+/// \param cnt      optional table of the global counters
+///
+template <typename SymbolIterator>
+void build_cacheline_rank_blocks(
+    SymbolIterator          begin,
+    SymbolIterator          end,
+    cacheline_rank_block*   blocks,
+    uint32*                 cnt = NULL);
+
+/// \relates cacheline_rank_dictionary
+/// fetch the text character at position i in the rank dictionary
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint8 text(const cacheline_rank_dictionary& dict, const uint32 i);
+
+/// \relates cacheline_rank_dictionary
+/// fetch the number of occurrences of character c in the substring [0,i]
+///
+/// \param dict         the rank dictionary
+/// \param i            the end of the query range [0,i]
+/// \param c            the query character
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 rank(
+    const cacheline_rank_dictionary& dict, const uint32 i, const uint32 c);
+
+/// \relates cacheline_rank_dictionary
+/// fetch the number of occurrences of character c in the substrings [0,l] and [0,r]
+///
+/// \param dict         the rank dictionary
+/// \param range        the ends of the query ranges [0,range.x] and [0,range.y]
+/// \param c            the query character
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint2 rank(
+    const cacheline_rank_dictionary& dict, const uint2 range, const uint32 c);
+
+/// \relates cacheline_rank_dictionary
+/// fetch the number of occurrences of all characters c in the substring [0,i]
+///
+/// \param dict         the rank dictionary
+/// \param i            the end of the query range [0,i]
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint4 rank4(
+    const cacheline_rank_dictionary& dict, const uint32 i);
+
+/// \relates cacheline_rank_dictionary
+/// fetch the number of occurrences of all characters in the substrings [0,l] and [0,r]
+///
+/// \param dict         the rank dictionary
+/// \param range        the ends of the query ranges [0,range.x] and [0,range.y]
+/// \param outl         the output count of all characters in the first range
+/// \param outl         the output count of all characters in the second range
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void rank4(
+    const cacheline_rank_dictionary& dict, const uint2 range, uint4* outl, uint4* outh);
+
+/// \relates cacheline_rank_dictionary
+/// issue a software prefetch for the block needed to answer rank queries at position i
+///
+/// \param dict         the rank dictionary
+/// \param i            the query position
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void prefetch(
+    const cacheline_rank_dictionary& dict, const uint32 i);
+
+///@} RankDictionaryModule
+///@} FMIndex
+
+} // namespace nvbio
+
+#include <nvbio/fmindex/cacheline_rank_dictionary_inl.h>
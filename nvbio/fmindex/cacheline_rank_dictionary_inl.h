@@ -0,0 +1,253 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+namespace nvbio {
+
+namespace clrank {
+
+// replicate a 2-bit symbol across all the 32 slots of a 64-bit word
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64 pattern(const uint32 c)
+{
+    return uint64(c) * 0x5555555555555555ull;
+}
+
+// return a mask with the low bit of each 2-bit slot of a 64-bit word set
+// if the slot matches the given pattern
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64 match(const uint64 word, const uint64 pattern)
+{
+    const uint64 x = word ^ pattern;
+    return ~(x | (x >> 1)) & 0x5555555555555555ull;
+}
+
+// return a mask selecting the first n (in [1,32]) slots of a 64-bit word
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64 prefix_mask(const uint32 n)
+{
+    return ~uint64(0) >> (64u - 2u*n);
+}
+
+// count the occurrences of c in the first r+1 symbols of a block
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 popc(const cacheline_rank_block& block, const uint32 r, const uint32 c)
+{
+    const uint64 p = pattern( c );
+    const uint32 w = r >> 5;
+
+    uint32 x = 0u;
+    for (uint32 j = 0; j < w; ++j)
+        x += nvbio::popc( match( block.bwt[j], p ) );
+
+    return x + nvbio::popc( match( block.bwt[w], p ) & prefix_mask( (r & 31u) + 1u ) );
+}
+
+// count the occurrences of all symbols in the first r+1 symbols of a block
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint4 popc4(const cacheline_rank_block& block, const uint32 r)
+{
+    const uint32 w = r >> 5;
+
+    uint4 x = make_uint4( 0u, 0u, 0u, 0u );
+    for (uint32 j = 0; j <= w; ++j)
+    {
+        const uint64 word = block.bwt[j];
+        const uint64 mask = (j < w) ? ~uint64(0) : prefix_mask( (r & 31u) + 1u );
+
+        x.y += nvbio::popc( match( word, pattern(1u) ) & mask );
+        x.z += nvbio::popc( match( word, pattern(2u) ) & mask );
+        x.w += nvbio::popc( match( word, pattern(3u) ) & mask );
+    }
+    // the A's are whatever is left
+    x.x = r + 1u - x.y - x.z - x.w;
+    return x;
+}
+
+} // namespace clrank
+
+// return the i-th symbol
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint8 cacheline_rank_text::operator[] (const uint32 i) const
+{
+    const uint32 k = i / cacheline_rank_block::SYMBOLS;
+    const uint32 r = i - k * cacheline_rank_block::SYMBOLS;
+
+    return uint8( (blocks[k].bwt[ r >> 5 ] >> ((r & 31u)*2u)) & 3u );
+}
+
+// build the cache-line blocks of a given string
+//
+template <typename SymbolIterator>
+void build_cacheline_rank_blocks(
+    SymbolIterator          begin,
+    SymbolIterator          end,
+    cacheline_rank_block*   blocks,
+    uint32*                 cnt)
+{
+    const uint32 n        = uint32( end - begin );
+    const uint32 n_blocks = util::divide_ri( n, cacheline_rank_block::SYMBOLS );
+
+    // compute the per-block symbol counts in parallel
+    std::vector<uint4> counts( n_blocks + 1u );
+
+    #pragma omp parallel for
+    for (int64 k = 0; k < int64( n_blocks ); ++k)
+    {
+        cacheline_rank_block& block = blocks[k];
+
+        for (uint32 j = 0; j < cacheline_rank_block::WORDS; ++j)
+            block.bwt[j] = 0u;
+
+        const uint32 block_begin = uint32(k) * cacheline_rank_block::SYMBOLS;
+        const uint32 block_end   = nvbio::min( block_begin + cacheline_rank_block::SYMBOLS, n );
+
+        uint32 c_counts[4] = { 0u, 0u, 0u, 0u };
+        for (uint32 i = block_begin; i < block_end; ++i)
+        {
+            const uint32 r = i - block_begin;
+            const uint32 c = begin[i];
+
+            block.bwt[ r >> 5 ] |= uint64(c) << ((r & 31u)*2u);
+            ++c_counts[c];
+        }
+        counts[k] = make_uint4( c_counts[0], c_counts[1], c_counts[2], c_counts[3] );
+    }
+
+    // and scan them to compute the occurrence counters
+    uint4 counters = make_uint4( 0u, 0u, 0u, 0u );
+    for (uint32 k = 0; k < n_blocks; ++k)
+    {
+        blocks[k].occ[0] = counters.x;
+        blocks[k].occ[1] = counters.y;
+        blocks[k].occ[2] = counters.z;
+        blocks[k].occ[3] = counters.w;
+
+        counters.x += counts[k].x;
+        counters.y += counts[k].y;
+        counters.z += counts[k].z;
+        counters.w += counts[k].w;
+    }
+
+    if (cnt)
+    {
+        cnt[0] = counters.x;
+        cnt[1] = counters.y;
+        cnt[2] = counters.z;
+        cnt[3] = counters.w;
+    }
+}
+
+// build the dictionary of a given string
+//
+template <typename SymbolIterator>
+void CacheLineRankDictionaryHost::build(
+    SymbolIterator  begin,
+    SymbolIterator  end,
+    uint32*         cnt)
+{
+    const uint32 n = uint32( end - begin );
+
+    // allocate one extra block to be able to align the storage to a cache line
+    const uint32 WORDS_PER_BLOCK = uint32( sizeof(cacheline_rank_block) / sizeof(uint64) );
+
+    m_storage.resize( uint64( n_blocks( n ) ) * WORDS_PER_BLOCK );
+
+    const uint64 misalignment = uint64( (size_t)raw_pointer( m_storage ) ) & 63u;
+    m_offset = misalignment ? uint32( (64u - misalignment) / sizeof(uint64) ) : 0u;
+
+    build_cacheline_rank_blocks( begin, end, blocks(), cnt );
+}
+
+// fetch the text character at position i in the rank dictionary
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint8 text(const cacheline_rank_dictionary& dict, const uint32 i)
+{
+    return dict.text[i];
+}
+
+// fetch the number of occurrences of character c in the substring [0,i]
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 rank(
+    const cacheline_rank_dictionary& dict, const uint32 i, const uint32 c)
+{
+    if (i == uint32(-1))
+        return 0u;
+
+    const uint32 k = i / cacheline_rank_block::SYMBOLS;
+    const uint32 r = i - k * cacheline_rank_block::SYMBOLS;
+
+    const cacheline_rank_block& block = dict.blocks[k];
+
+    return block.occ[c] + clrank::popc( block, r, c );
+}
+
+// fetch the number of occurrences of character c in the substrings [0,l] and [0,r]
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint2 rank(
+    const cacheline_rank_dictionary& dict, const uint2 range, const uint32 c)
+{
+    return make_uint2(
+        rank( dict, range.x, c ),
+        rank( dict, range.y, c ) );
+}
+
+// fetch the number of occurrences of all characters c in the substring [0,i]
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint4 rank4(
+    const cacheline_rank_dictionary& dict, const uint32 i)
+{
+    if (i == uint32(-1))
+        return make_uint4( 0u, 0u, 0u, 0u );
+
+    const uint32 k = i / cacheline_rank_block::SYMBOLS;
+    const uint32 r = i - k * cacheline_rank_block::SYMBOLS;
+
+    const cacheline_rank_block& block = dict.blocks[k];
+
+    const uint4 x = clrank::popc4( block, r );
+    return make_uint4(
+        block.occ[0] + x.x,
+        block.occ[1] + x.y,
+        block.occ[2] + x.z,
+        block.occ[3] + x.w );
+}
+
+// fetch the number of occurrences of all characters in the substrings [0,l] and [0,r]
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void rank4(
+    const cacheline_rank_dictionary& dict, const uint2 range, uint4* outl, uint4* outh)
+{
+    *outl = rank4( dict, range.x );
+    *outh = rank4( dict, range.y );
+}
+
+// issue a software prefetch for the block needed to answer rank queries at position i
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void prefetch(
+    const cacheline_rank_dictionary& dict, const uint32 i)
+{
+    if (i == uint32(-1))
+        return;
+
+    host_prefetch( dict.blocks, i / cacheline_rank_block::SYMBOLS );
+}
+
+} // namespace nvbio
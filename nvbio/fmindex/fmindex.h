@@ -360,6 +360,22 @@ struct fm_index
     TSuffixArray        m_sa;
 };
 
+/// \relates fm_index
+/// issue a software prefetch for the rank dictionary data needed to answer rank queries
+/// at position k of the given FM-index; this is a host-side hint which allows to overlap
+/// the memory latency of many independent searches, and is a no-op on the device.
+///
+/// \param fmi      FM-index
+/// \param k        query position
+///
+template <
+    typename TRankDictionary,
+    typename TSuffixArray>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void prefetch(
+    const fm_index<TRankDictionary,TSuffixArray>&                   fmi,
+    typename fm_index<TRankDictionary,TSuffixArray>::index_type     k);
+
 /// \relates fm_index
 /// return the number of occurrences of c in the range [0,k] of the given FM-index.
 ///
@@ -46,6 +46,31 @@ typename fm_index<TRankDictionary,TSuffixArray>::index_type rank(
     return rank( fmi.rank_dict(), k, c );
 }
 
+// issue a software prefetch for the rank dictionary data needed to answer rank queries
+// at position k of the given FM-index.
+//
+// \param fmi      FM-index
+// \param k        query position
+//
+template <
+    typename TRankDictionary,
+    typename TSuffixArray>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void prefetch(
+    const fm_index<TRankDictionary,TSuffixArray>&                   fmi,
+    typename fm_index<TRankDictionary,TSuffixArray>::index_type     k)
+{
+    typedef typename fm_index<TRankDictionary,TSuffixArray>::index_type index_type;
+
+    if (k == index_type(-1) || k >= fmi.length())
+        return;
+
+    if (k >= fmi.primary()) // because $ is not in bwt
+        --k;
+
+    prefetch( fmi.m_rank_dict, k );
+}
+
 // return the number of occurrences of c in the ranges [0,l] and [0,r] of the
 // given FM-index.
 //
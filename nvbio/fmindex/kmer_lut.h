@@ -0,0 +1,146 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/fmindex/fmindex.h>
+
+namespace nvbio {
+
+///@addtogroup FMIndex
+///@{
+
+///
+/// A k-mer lookup table for an FM-index, storing the SA range of each of the 4^k
+/// DNA k-mers, i.e. the range that backward search would reach after consuming the
+/// k-mer's symbols: a lookup in this table replaces the first k steps of a backward
+/// search, and the 2k rank queries they would cost.
+///\par
+/// The k-mer code of a string s[0,k) is defined as sum_j s[j] << 2*(k-1-j), i.e. the
+/// first symbol is the most significant one.
+/// Ranges of k-mers which do not occur in the text are empty (i.e. x > y), and hold the
+/// exact value backward search would return for them.
+///\par
+/// fm_index_kmer_lut is <i>storage-free</i>: the table itself is built with build_kmer_lut(),
+/// and is typically stored on disk together with the index (see io::FMIndexDataHost).
+///
+/// \tparam IndexType       the index type of the FM-index, uint32|uint64
+///
+template <typename IndexType>
+struct fm_index_kmer_lut
+{
+    typedef IndexType                                       index_type;
+    typedef typename vector_type<index_type,2>::type        range_type;
+
+    static const uint32 MAX_K = 15u;                        ///< the maximum supported k-mer length
+
+    /// return the number of table entries for a given k
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    static uint64 entries(const uint32 k) { return uint64(1u) << (2u*k); }
+
+    /// empty constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    fm_index_kmer_lut() : m_k( 0u ), m_ranges( NULL ) {}
+
+    /// constructor
+    ///
+    /// \param k        the k-mer length
+    /// \param ranges   the table of 4^k ranges
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    fm_index_kmer_lut(const uint32 k, const range_type* ranges) : m_k( k ), m_ranges( ranges ) {}
+
+    /// return the k-mer length
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 k() const { return m_k; }
+
+    /// return whether the table is present
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE bool is_valid() const { return m_ranges != NULL; }
+
+    /// return the range of a given k-mer code
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE range_type operator[] (const uint32 code) const { return m_ranges[ code ]; }
+
+    uint32              m_k;
+    const range_type*   m_ranges;
+};
+
+/// \relates fm_index_kmer_lut
+/// compute the k-mer code of a string, returning false if it contains an N
+///
+/// \param pattern      the string
+/// \param k            the k-mer length
+/// \param code         the output code
+///
+template <typename Iterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool kmer_code(
+    const Iterator      pattern,
+    const uint32        k,
+          uint32*       code);
+
+/// \relates fm_index_kmer_lut
+/// build the k-mer lookup table of an FM-index on the host.
+/// The table is built level by level: the ranges of all (l+1)-mers are obtained extending the
+/// ranges of all l-mers by one backward search step, in parallel.
+///
+/// \param fmi          the FM-index
+/// \param k            the k-mer length, at most fm_index_kmer_lut::MAX_K
+/// \param ranges       the output table, of size 4^k
+///
+template <
+    typename TRankDictionary,
+    typename TSuffixArray>
+void build_kmer_lut(
+    const fm_index<TRankDictionary,TSuffixArray>&                       fmi,
+    const uint32                                                        k,
+    typename fm_index<TRankDictionary,TSuffixArray>::range_type*        ranges);
+
+/// \relates fm_index_kmer_lut
+/// return the range of occurrences of a pattern in the given FM-index, replacing the
+/// first k steps of backward search (i.e. the last k symbols of the pattern) with a
+/// single lookup in a k-mer table.
+/// The result is the same as match( fmi, pattern, pattern_len ).
+///
+/// \param fmi          FM-index
+/// \param lut          the k-mer lookup table of fmi
+/// \param pattern      query string
+/// \param pattern_len  query string length
+///
+template <
+    typename TRankDictionary,
+    typename TSuffixArray,
+    typename Iterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename fm_index<TRankDictionary,TSuffixArray>::range_type match(
+    const fm_index<TRankDictionary,TSuffixArray>&                                       fmi,
+    const fm_index_kmer_lut<typename fm_index<TRankDictionary,TSuffixArray>::index_type> lut,
+    const Iterator                                                                      pattern,
+    const uint32                                                                        pattern_len);
+
+///@} // end of the FMIndex group
+
+} // namespace nvbio
+
+#include <nvbio/fmindex/kmer_lut_inl.h>
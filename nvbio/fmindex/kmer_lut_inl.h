@@ -0,0 +1,125 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+namespace nvbio {
+
+// compute the k-mer code of a string, returning false if it contains an N
+//
+template <typename Iterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool kmer_code(
+    const Iterator      pattern,
+    const uint32        k,
+          uint32*       code)
+{
+    uint32 r = 0u;
+    for (uint32 j = 0; j < k; ++j)
+    {
+        const uint8 c = pattern[j];
+        if (c > 3) // there is an N here
+            return false;
+
+        r = (r << 2) | c;
+    }
+    *code = r;
+    return true;
+}
+
+// build the k-mer lookup table of an FM-index on the host
+//
+template <
+    typename TRankDictionary,
+    typename TSuffixArray>
+void build_kmer_lut(
+    const fm_index<TRankDictionary,TSuffixArray>&                       fmi,
+    const uint32                                                        k,
+    typename fm_index<TRankDictionary,TSuffixArray>::range_type*        ranges)
+{
+    typedef typename fm_index<TRankDictionary,TSuffixArray>::index_type index_type;
+    typedef typename fm_index<TRankDictionary,TSuffixArray>::range_type range_type;
+
+    // the table is built in place: at the beginning of level l, the first 4^l entries hold
+    // the ranges of all l-mers; the (l+1)-mer c.s has code (c << 2l) | code(s), so that
+    // the extensions of s by c = 1,2,3 land beyond the first 4^l entries, and only the
+    // extension by c = 0 overwrites s itself, which is hence written last.
+    ranges[0] = make_vector( index_type(0), fmi.length() );
+
+    for (uint32 l = 0; l < k; ++l)
+    {
+        const int64 n_entries = int64(1) << (2u*l);
+
+        #pragma omp parallel for
+        for (int64 s = 0; s < n_entries; ++s)
+        {
+            const range_type range = ranges[s];
+
+            for (int32 c = 3; c >= 0; --c)
+            {
+                range_type c_range = range;
+
+                // propagate empty ranges as they are: backward search would stop there
+                if (range.x <= range.y)
+                {
+                    const range_type c_rank = rank(
+                        fmi,
+                        make_vector( range.x-1, range.y ),
+                        uint8(c) );
+
+                    c_range.x = fmi.L2(c) + c_rank.x + 1;
+                    c_range.y = fmi.L2(c) + c_rank.y;
+                }
+                ranges[ (uint64(c) << (2u*l)) | uint64(s) ] = c_range;
+            }
+        }
+    }
+}
+
+// return the range of occurrences of a pattern in the given FM-index, using a k-mer
+// lookup table for the first k backward search steps
+//
+template <
+    typename TRankDictionary,
+    typename TSuffixArray,
+    typename Iterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename fm_index<TRankDictionary,TSuffixArray>::range_type match(
+    const fm_index<TRankDictionary,TSuffixArray>&                                       fmi,
+    const fm_index_kmer_lut<typename fm_index<TRankDictionary,TSuffixArray>::index_type> lut,
+    const Iterator                                                                      pattern,
+    const uint32                                                                        pattern_len)
+{
+    typedef typename fm_index<TRankDictionary,TSuffixArray>::range_type range_type;
+
+    const uint32 k = lut.k();
+
+    // fall back to plain backward search for short patterns and for k-mers containing Ns,
+    // where the exact output depends on whether the search stops before or after the N
+    uint32 code;
+    if (lut.is_valid() == false || pattern_len < k || kmer_code( pattern + pattern_len - k, k, &code ) == false)
+        return match( fmi, pattern, pattern_len );
+
+    const range_type range = lut[ code ];
+    if (range.x > range.y)
+        return range;
+
+    return match( fmi, pattern, pattern_len - k, range );
+}
+
+} // namespace nvbio
@@ -26,6 +26,8 @@
 #include <nvbio/basic/exceptions.h>
 #include <nvbio/basic/vector.h>
 #include <nvbio/basic/vector_array.h>
+#include <nvbio/basic/atomics.h>
+#include <nvbio/basic/omp.h>
 #include <nvbio/basic/cuda/sort.h>
 #include <nvbio/basic/cuda/primitives.h>
 #include <nvbio/strings/string.h>
@@ -276,6 +278,12 @@ struct MEMHit
 ///  - and then <i>enumerate</i> each individual occurrence of a MEM within the lists,
 ///  as a set of <i>(index-pos,string-id,string-begin,string-end)</i> tuples.
 ///\par
+/// Both the rank() and locate() phases are parallelized across all available host threads
+/// using dynamic load balancing: each thread repeatedly grabs the next chunk of strings
+/// (resp. MEM occurrences) from a shared atomic counter, so that a few reads with many
+/// repetitive MEMs do not hold back the whole batch.
+/// The output is deterministic, as MEM ranges are always reordered by string id.
+///\par
 /// \tparam fm_index_type    the type of the fm-index
 ///
 template <typename fm_index_type>
@@ -291,6 +299,39 @@ struct MEMFilter<host_tag, fm_index_type>
     typedef MEMHit<coord_type>                              mem_type;       ///< MEM coordinates are either uint32_4 or uint64_4
     typedef mem_type                                        hit_type;       ///< MEM coordinates are either uint32_4 or uint64_4
 
+    static const uint32 RANK_CHUNK_SIZE   = 16u;                            ///< default number of strings grabbed at once by each thread
+    static const uint32 LOCATE_CHUNK_SIZE = 1024u;                          ///< default number of occurrences grabbed at once by each thread
+
+    /// empty constructor
+    ///
+    MEMFilter() :
+        m_n_threads( 0u ),
+        m_rank_chunk( RANK_CHUNK_SIZE ),
+        m_locate_chunk( LOCATE_CHUNK_SIZE ),
+        m_n_queries( 0u ),
+        m_n_occurrences( 0u ) {}
+
+    /// set the number of host threads used by rank() and locate()
+    ///
+    /// \param n_threads        the number of threads; 0 means using omp_get_max_threads()
+    ///
+    void set_threads(const uint32 n_threads) { m_n_threads = n_threads; }
+
+    /// set the work-stealing granularity
+    ///
+    /// \param rank_chunk       the number of strings grabbed at once by each thread during rank()
+    /// \param locate_chunk     the number of MEM occurrences grabbed at once by each thread during locate()
+    ///
+    void set_chunk_sizes(const uint32 rank_chunk, const uint32 locate_chunk)
+    {
+        m_rank_chunk   = nvbio::max( rank_chunk,   1u );
+        m_locate_chunk = nvbio::max( locate_chunk, 1u );
+    }
+
+    /// return the number of host threads used by rank() and locate()
+    ///
+    uint32 threads() const;
+
     /// enact the filter on an FM-index and a string-set
     ///
     /// \param f_index          the forward FM-index
@@ -342,6 +383,9 @@ struct MEMFilter<host_tag, fm_index_type>
     ///
     uint64 n_ranges() const { return m_mem_ranges.allocated_size(); }
 
+    uint32                              m_n_threads;
+    uint32                              m_rank_chunk;
+    uint32                              m_locate_chunk;
     uint32                              m_n_queries;
     index_type                          m_f_index;
     index_type                          m_r_index;
@@ -79,8 +79,11 @@ uint32 find_kmems(
                 prev_range = f_range;
             }
         }
-        // check if we still need to save one range
-        if (right_ranges.size() && (right_ranges.back().y - right_ranges.back().x) != (prev_range.y - prev_range.x))
+        // check if we still need to save one range: this includes the case of a range which
+        // never changed after the first symbol, e.g. when x is the last base before an N
+        if (right_ranges.size() ?
+            (right_ranges.back().y - right_ranges.back().x) != (prev_range.y - prev_range.x) :
+            i > x)
             right_ranges.push_back( make_vector( prev_range.x, prev_range.y, coord_type(x), coord_type(i) ) );
     }
 
@@ -1144,8 +1147,80 @@ void reorder_ranges(
         copy_ranges( i, in_ranges, slots, out_ranges );
 }
 
+// host function to apply a functor to all the items in [begin,end) using dynamic load
+// balancing: each thread keeps grabbing the next chunk of items from a shared atomic
+// counter until the range is exhausted, so that threads which happen to get cheap items
+// effectively steal work from the ones stuck on expensive ones
+template <typename functor_type>
+void dynamic_for_each(
+    const uint32                            n_threads,      // # of threads
+    const uint64                            begin,          // range begin
+    const uint64                            end,            // range end
+    const uint32                            chunk_size,     // # of items grabbed at once
+    const functor_type                      functor)        // the functor to apply
+{
+    uint64 next_chunk = begin;
+
+    #pragma omp parallel num_threads( n_threads )
+    {
+        while (1)
+        {
+            const uint64 chunk_begin = atomic_add( &next_chunk, uint64( chunk_size ) );
+            if (chunk_begin >= end)
+                break;
+
+            const uint64 chunk_end = nvbio::min( chunk_begin + chunk_size, end );
+
+            for (uint64 i = chunk_begin; i < chunk_end; ++i)
+                functor( i );
+        }
+    }
+}
+
+// a functor to enumerate and locate the i-th MEM occurrence, writing it to the output
+template <typename index_type, typename mems_iterator>
+struct locate_functor
+{
+    typedef typename index_type::index_type             coord_type;
+    typedef MEMRange<coord_type>                        rank_type;
+
+    // constructor
+    locate_functor(
+        const index_type        _index,
+        const uint32            _n_ranges,
+        const uint64*           _slots,
+        const rank_type*        _ranges,
+        const uint64            _begin,
+        const mems_iterator     _mems) :
+    filter  ( _n_ranges, _slots, _ranges ),
+    locate  ( _index ),
+    lookup  ( _index ),
+    begin   ( _begin ),
+    mems    ( _mems ) {}
+
+    // functor operator
+    void operator() (const uint64 i) const
+    {
+        mems[ i - begin ] = lookup( locate( filter( i ) ) );
+    }
+
+    const filter_results<coord_type>        filter;
+    const locate_ssa_results<index_type>    locate;
+    const lookup_ssa_results<index_type>    lookup;
+    const uint64                            begin;
+    const mems_iterator                     mems;
+};
+
 } // namespace mem
 
+// return the number of host threads used by rank() and locate()
+//
+template <typename fm_index_type>
+uint32 MEMFilter<host_tag, fm_index_type>::threads() const
+{
+    return m_n_threads ? m_n_threads : uint32( omp_get_max_threads() );
+}
+
 
 // enact the filter on an FM-index and a string-set
 //
@@ -1176,10 +1251,13 @@ uint64 MEMFilter<host_tag, fm_index_type>::rank(
 
     m_mem_ranges.resize( m_n_queries, max_string_length * m_n_queries );
 
-    // search the strings in the index, obtaining a set of ranges
-    thrust::for_each(
-        thrust::make_counting_iterator<uint32>(0u),
-        thrust::make_counting_iterator<uint32>(0u) + m_n_queries,
+    // search the strings in the index, obtaining a set of ranges: as the cost of each string
+    // is highly irregular, strings are distributed to threads dynamically
+    mem::dynamic_for_each(
+        threads(),
+        0u,
+        m_n_queries,
+        m_rank_chunk,
         mem::mem_functor<fm_index_type,string_set_type>(
             m_f_index,
             m_r_index,
@@ -1261,34 +1339,24 @@ void MEMFilter<host_tag, fm_index_type>::locate(
     const uint64    end,
     mems_iterator   mems)
 {
-    const uint32 n_hits = end - begin;
-
     // fetch the number of output MEM ranges
     const uint32 n_ranges = m_mem_ranges.allocated_size();
 
-    // fill the output hits with (SA,string-id) coordinates
-    thrust::transform(
-        thrust::make_counting_iterator<uint64>(0u) + begin,
-        thrust::make_counting_iterator<uint64>(0u) + end,
-        mems,
-        mem::filter_results<coord_type>(
+    // fill the output hits with (SA,string-id) coordinates, locate the SSA iterators
+    // and perform the final lookup in a single pass: as the number of LF-mapping steps
+    // needed to reach a sampled SA position varies, occurrences are distributed dynamically
+    mem::dynamic_for_each(
+        threads(),
+        begin,
+        end,
+        m_locate_chunk,
+        mem::locate_functor<fm_index_type,mems_iterator>(
+            m_f_index,
             n_ranges,
             nvbio::plain_view( m_slots ),
-            nvbio::plain_view( m_mem_ranges.m_arena ) ) );
-
-    // locate the SSA iterators
-    thrust::transform(
-        mems,
-        mems + n_hits,
-        mems,
-        mem::locate_ssa_results<fm_index_type>( m_f_index ) );
-
-    // and perform the final lookup
-    thrust::transform(
-        mems,
-        mems + n_hits,
-        mems,
-        mem::lookup_ssa_results<fm_index_type>( m_f_index ) );
+            nvbio::plain_view( m_mem_ranges.m_arena ),
+            begin,
+            mems ) );
 }
 
 // enact the filter on an FM-index and a string-set
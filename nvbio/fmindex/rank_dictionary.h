@@ -177,6 +177,18 @@ template <uint32 K, typename TextString, typename OccIterator, typename CountTab
 NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void rank4(
     const rank_dictionary<2,K,TextString,OccIterator,CountTable>& dict, const uint64_2 range, uint64_4* outl, uint64_4* outh);
 
+/// \relates rank_dictionary
+/// issue a software prefetch for the occurrence table block and the text words needed
+/// to answer rank queries at position i; this is a host-side hint, used to overlap
+/// the latency of independent queries, and is a no-op on the device
+///
+/// \param dict         the rank dictionary
+/// \param i            the query position
+///
+template <uint32 SYMBOL_SIZE_T, uint32 K, typename TextString, typename OccIterator, typename CountTable, typename IndexType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void prefetch(
+    const rank_dictionary<SYMBOL_SIZE_T,K,TextString,OccIterator,CountTable>& dict, const IndexType i);
+
 ///@} RankDictionaryModule
 ///@} FMIndex
 
@@ -98,6 +98,27 @@ void unpack_add(uint64_4* op1, const uint32 op2)
     op1->w += (op2 >> 24);
 }
 
+// sum a uint4 and a uchar4 packed into a uint32, where the packed counters have been
+// accumulated over n <= 256 symbols: if n = 256, a single symbol filling the whole range
+// makes its 8-bit counter wrap around, which can be detected as the counters no longer
+// summing up to n.
+//
+template <typename vec4_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void unpack_add(vec4_type* op1, const uint32 op2, const uint32 n)
+{
+    if (n == 256u && (op2 & 0xff) + (op2 >> 8 & 0xff) + (op2 >> 16 & 0xff) + (op2 >> 24) != 256u)
+    {
+        // the carry has moved into the next counter, or out of the word for the last symbol
+        if      (op2 == 0x00000100u) op1->x += 256u;
+        else if (op2 == 0x00010000u) op1->y += 256u;
+        else if (op2 == 0x01000000u) op1->z += 256u;
+        else                         op1->w += 256u;
+    }
+    else
+        unpack_add( op1, op2 );
+}
+
 namespace occ {
 
 // overload popc_2bit and popc_2bit_all so that they look the same
@@ -314,7 +335,10 @@ struct dispatch_rank<2,K,PackedStream<TextStorage,uint8,2u,true,index_type>,OccI
         const uint32 x = occ::popc_2bit( dict.text.stream(), dict.count_table, off, off + m, ~word_type(i) & (SYMS_PER_WORD-1) );
 
         // add the packed counters to the output result
-        unpack_add( &r, x );
+        if (K < 256)
+            unpack_add( &r, x );
+        else
+            unpack_add( &r, x, uint32( i - index_type(k)*K ) + 1u );
         return r;
     }
     // fetch the number of occurrences of character c in the substring [0,i]
@@ -330,8 +354,16 @@ struct dispatch_rank<2,K,PackedStream<TextStorage,uint8,2u,true,index_type>,OccI
         const uint2 r = popc2( dict.text.stream(), range, kl, kh, dict.count_table );
 
         // add the packed counters to the output result
-        unpack_add( outl, r.x );
-        unpack_add( outh, r.y );
+        if (K < 256)
+        {
+            unpack_add( outl, r.x );
+            unpack_add( outh, r.y );
+        }
+        else
+        {
+            unpack_add( outl, r.x, uint32( range.x - index_type(kl)*K ) + 1u );
+            unpack_add( outh, r.y, uint32( range.y - index_type(kh)*K ) + 1u );
+        }
     }
 };
 
@@ -538,4 +570,30 @@ NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void rank4(
         dict, range, outl, outh );
 }
 
+// issue a software prefetch for the data needed to answer rank queries at position i
+template <uint32 SYMBOL_SIZE_T, uint32 K, typename TextString, typename OccIterator, typename CountTable, typename IndexType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void prefetch(
+    const rank_dictionary<SYMBOL_SIZE_T,K,TextString,OccIterator,CountTable>& dict, const IndexType i)
+{
+  #if !defined(NVBIO_DEVICE_COMPILATION)
+    typedef typename TextString::storage_type                      word_type;
+    typedef typename std::iterator_traits<OccIterator>::value_type occ_type;
+
+    const uint32 SYMS_PER_WORD = (8u * sizeof(word_type)) / SYMBOL_SIZE_T;
+    const uint32 OCC_DIM       = vector_traits<occ_type>::DIM;
+
+    if (i == IndexType(-1))
+        return;
+
+    const uint64 k = uint64(i) / K;
+
+    // prefetch the block counters
+    host_prefetch( dict.occ, (k*4u) / OCC_DIM );
+
+    // prefetch the first and the last text words scanned by the query
+    host_prefetch( dict.text.stream(), (k*K) / SYMS_PER_WORD );
+    host_prefetch( dict.text.stream(), uint64(i) / SYMS_PER_WORD );
+  #endif
+}
+
 } // namespace nvbio
@@ -0,0 +1,286 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/iterator.h>
+#include <nvbio/basic/vector.h>
+#include <vector>
+#include <algorithm>
+
+namespace nvbio {
+
+///@addtogroup FMIndex
+///@{
+
+///@addtogroup RankDictionaryModule
+///@{
+
+///
+/// The byte code used to run-length encode BWTs, e.g. in .rle files and rle_rank_dictionary's:
+/// each byte encodes a run of 1 to MAX_RUN identical symbols, storing the symbol in its low
+/// 3 bits and the run length minus one in its high 5 bits; longer runs are split across
+/// multiple bytes.
+/// Symbols 0-3 are the DNA bases, N is used for any other base and DOLLAR for the
+/// string terminators (which the BWT construction functions emit as 255).
+///
+struct rle_code
+{
+    static const uint32 SYMBOL_BITS = 3u;                           ///< number of bits used to encode the symbol
+    static const uint32 SYMBOL_MASK = (1u << SYMBOL_BITS) - 1u;     ///< symbol mask
+    static const uint32 MAX_RUN     = 1u << (8u - SYMBOL_BITS);     ///< the longest run encoded by a single byte
+    static const uint8  N           = 4u;                           ///< the N symbol
+    static const uint8  DOLLAR      = 5u;                           ///< the dollar symbol
+
+    /// encode a run of len (in [1,MAX_RUN]) symbols c
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint8 encode(const uint8 c, const uint32 len) { return uint8( ((len - 1u) << SYMBOL_BITS) | c ); }
+
+    /// return the symbol of an encoded run
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint8 symbol(const uint8 run) { return run & SYMBOL_MASK; }
+
+    /// return the length of an encoded run
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 length(const uint8 run) { return uint32( run >> SYMBOL_BITS ) + 1u; }
+
+    /// map a BWT symbol (i.e. a DNA base, an N, or 255 for dollars) to its rle_code symbol
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint8 from_bwt(const uint8 c) { return c == 255u ? DOLLAR : (c < N ? c : N); }
+};
+
+///
+/// Run-length encode a sequence of BWT symbols, returning the number of encoded bytes
+/// (i.e. at most n).
+///
+/// \param n        the number of symbols
+/// \param symbols  the input symbols, see rle_code::from_bwt()
+/// \param runs     the output runs
+/// \return         the number of output bytes
+///
+template <typename SymbolIterator>
+uint64 rle_encode(
+    const uint64            n,
+    const SymbolIterator    symbols,
+    uint8*                  runs);
+
+///
+/// A random access view of the text stored in an rle_rank_dictionary.
+/// Runs are grouped in blocks of BLOCK_SIZE bytes, each tagged by the position of its
+/// first symbol; a sampled position index maps every SAMPLE_INTERVAL-th symbol to the
+/// block containing it, so that any symbol can be located scanning a short range of
+/// block positions and a single block of runs.
+///
+struct rle_rank_text
+{
+    static const uint32 BLOCK_SIZE      = 64u;      ///< number of runs per block, i.e. one cache line
+    static const uint32 SAMPLE_INTERVAL = 1024u;    ///< symbol interval of the position index
+
+    typedef uint8 value_type;
+    typedef uint8 reference;
+
+    /// default constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    rle_rank_text() {}
+
+    /// constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    rle_rank_text(const uint8* _runs, const uint64* _pos, const uint32* _index) :
+        runs( _runs ), pos( _pos ), index( _index ) {}
+
+    /// return the block containing the i-th symbol
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 find_block(const uint64 i) const;
+
+    /// return the i-th symbol
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint8 operator[] (const uint64 i) const;
+
+    const uint8*    runs;       ///< the encoded runs
+    const uint64*   pos;        ///< the position of the first symbol of each block, plus the text length
+    const uint32*   index;      ///< the block containing each SAMPLE_INTERVAL-th symbol
+};
+
+///
+/// A host-side rank dictionary over a run-length encoded BWT (see rle_code), where the
+/// occurrence counters of the 4 DNA bases are sampled at the beginning of each block of
+/// runs: a rank() query locates the block through the text's position index and then
+/// decodes at most BLOCK_SIZE runs, without ever decompressing the text.
+/// Ns and dollars are skipped by all counters.
+///\par
+/// The sampled tables take 40 bytes per block of 64 runs, plus 4 bytes per 1024 symbols,
+/// so that the dictionary pays off whenever the average run is longer than a few symbols,
+/// as is typical of the BWTs of read collections.
+///\par
+/// The dictionary exposes the same interface as rank_dictionary, using 64-bit indices.
+///
+struct rle_rank_dictionary
+{
+    static const uint32     BLOCK_SIZE  = rle_rank_text::BLOCK_SIZE;
+
+    typedef rle_rank_text               text_type;
+    typedef uint64                      index_type;
+    typedef uint64_2                    range_type;
+    typedef uint64_2                    vec2_type;
+    typedef uint64_4                    vec4_type;
+
+    /// default constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    rle_rank_dictionary() {}
+
+    /// constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    rle_rank_dictionary(const text_type _text, const uint64* _occ) :
+        text( _text ),
+        occ( _occ ) {}
+
+    text_type                       text;       ///< the dictionary's text
+    const uint64*                   occ;        ///< the occurrence counters at the beginning of each block
+};
+
+///
+/// Host storage for an rle_rank_dictionary
+///
+struct RLERankDictionaryHost
+{
+    typedef rle_rank_dictionary   dictionary_type;
+
+    /// empty constructor
+    ///
+    RLERankDictionaryHost() : m_size( 0u ) {}
+
+    /// build the dictionary of a given sequence of runs
+    ///
+    /// \param begin    run sequence begin
+    /// \param end      run sequence end
+    /// \param cnt      optional table of the global counters
+    ///
+    template <typename RunIterator>
+    void build(
+        RunIterator     begin,
+        RunIterator     end,
+        uint64*         cnt = NULL);
+
+    /// build the sampled tables of the runs already stored in m_runs
+    ///
+    /// \param cnt      optional table of the global counters
+    ///
+    void index(uint64* cnt = NULL);
+
+    /// return the number of encoded symbols
+    ///
+    uint64 size() const { return m_size; }
+
+    /// return the number of runs
+    ///
+    uint64 n_runs() const { return uint64( m_runs.size() ); }
+
+    /// return the number of allocated bytes
+    ///
+    uint64 allocated() const
+    {
+        return uint64( m_runs.size() )  * sizeof(uint8)  +
+               uint64( m_pos.size() )   * sizeof(uint64) +
+               uint64( m_occ.size() )   * sizeof(uint64) +
+               uint64( m_index.size() ) * sizeof(uint32);
+    }
+
+    /// return the dictionary view
+    ///
+    dictionary_type dictionary() const
+    {
+        return dictionary_type(
+            rle_rank_text( raw_pointer( m_runs ), raw_pointer( m_pos ), raw_pointer( m_index ) ),
+            raw_pointer( m_occ ) );
+    }
+
+    nvbio::vector<host_tag,uint8>   m_runs;     ///< the encoded runs
+    nvbio::vector<host_tag,uint64>  m_pos;      ///< the position of the first symbol of each block
+    nvbio::vector<host_tag,uint64>  m_occ;      ///< the occurrence counters at the beginning of each block
+    nvbio::vector<host_tag,uint32>  m_index;    ///< the sampled position index
+    uint64                          m_size;     ///< the number of encoded symbols
+};
+
+/// \relates rle_rank_dictionary
+/// fetch the text character at position i in the rank dictionary
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint8 text(const rle_rank_dictionary& dict, const uint64 i);
+
+/// \relates rle_rank_dictionary
+/// fetch the number of occurrences of character c in the substring [0,i]
+///
+/// \param dict         the rank dictionary
+/// \param i            the end of the query range [0,i]
+/// \param c            the query character
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64 rank(
+    const rle_rank_dictionary& dict, const uint64 i, const uint32 c);
+
+/// \relates rle_rank_dictionary
+/// fetch the number of occurrences of character c in the substrings [0,l] and [0,r]
+///
+/// \param dict         the rank dictionary
+/// \param range        the ends of the query ranges [0,range.x] and [0,range.y]
+/// \param c            the query character
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64_2 rank(
+    const rle_rank_dictionary& dict, const uint64_2 range, const uint32 c);
+
+/// \relates rle_rank_dictionary
+/// fetch the number of occurrences of all characters c in the substring [0,i]
+///
+/// \param dict         the rank dictionary
+/// \param i            the end of the query range [0,i]
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64_4 rank4(
+    const rle_rank_dictionary& dict, const uint64 i);
+
+/// \relates rle_rank_dictionary
+/// fetch the number of occurrences of all characters in the substrings [0,l] and [0,r]
+///
+/// \param dict         the rank dictionary
+/// \param range        the ends of the query ranges [0,range.x] and [0,range.y]
+/// \param outl         the output count of all characters in the first range
+/// \param outl         the output count of all characters in the second range
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void rank4(
+    const rle_rank_dictionary& dict, const uint64_2 range, uint64_4* outl, uint64_4* outh);
+
+/// \relates rle_rank_dictionary
+/// issue a software prefetch for the tables needed to answer rank queries at position i
+///
+/// \param dict         the rank dictionary
+/// \param i            the query position
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void prefetch(
+    const rle_rank_dictionary& dict, const uint64 i);
+
+///@} RankDictionaryModule
+///@} FMIndex
+
+} // namespace nvbio
+
+#include <nvbio/fmindex/rle_rank_dictionary_inl.h>
@@ -0,0 +1,262 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+namespace nvbio {
+
+// run-length encode a sequence of BWT symbols
+//
+template <typename SymbolIterator>
+uint64 rle_encode(
+    const uint64            n,
+    const SymbolIterator    symbols,
+    uint8*                  runs)
+{
+    uint64 n_runs = 0u;
+    for (uint64 i = 0; i < n;)
+    {
+        const uint8 c = rle_code::from_bwt( symbols[i] );
+
+        uint32 len = 1u;
+        while (len < rle_code::MAX_RUN && i + len < n && rle_code::from_bwt( symbols[i + len] ) == c)
+            ++len;
+
+        runs[ n_runs++ ] = rle_code::encode( c, len );
+        i += len;
+    }
+    return n_runs;
+}
+
+// return the block containing the i-th symbol
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 rle_rank_text::find_block(const uint64 i) const
+{
+    // each block spans at least BLOCK_SIZE symbols, so that this takes at most
+    // SAMPLE_INTERVAL / BLOCK_SIZE steps over consecutive entries
+    uint32 k = index[ i / SAMPLE_INTERVAL ];
+    while (pos[k+1] <= i)
+        ++k;
+
+    return k;
+}
+
+// return the i-th symbol
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint8 rle_rank_text::operator[] (const uint64 i) const
+{
+    const uint32 k = find_block( i );
+
+    const uint8* run = runs + uint64(k) * BLOCK_SIZE;
+    for (uint64 p = pos[k];; ++run)
+    {
+        p += rle_code::length( *run );
+        if (p > i)
+            return rle_code::symbol( *run );
+    }
+}
+
+// build the dictionary of a given sequence of runs
+//
+template <typename RunIterator>
+void RLERankDictionaryHost::build(
+    RunIterator     begin,
+    RunIterator     end,
+    uint64*         cnt)
+{
+    m_runs.resize( uint64( end - begin ) );
+    std::copy( begin, end, m_runs.begin() );
+
+    index( cnt );
+}
+
+// build the sampled tables of the runs already stored in m_runs
+//
+inline void RLERankDictionaryHost::index(uint64* cnt)
+{
+    const uint32 BLOCK_SIZE      = rle_rank_text::BLOCK_SIZE;
+    const uint32 SAMPLE_INTERVAL = rle_rank_text::SAMPLE_INTERVAL;
+
+    const uint64 n_bytes  = uint64( m_runs.size() );
+    const uint32 n_blocks = uint32( util::divide_ri( n_bytes, BLOCK_SIZE ) );
+
+    const uint8* runs = raw_pointer( m_runs );
+
+    // compute the per-block symbol counts in parallel
+    std::vector<uint64> counts( uint64( n_blocks ) * 5u );
+
+    #pragma omp parallel for
+    for (int64 k = 0; k < int64( n_blocks ); ++k)
+    {
+        const uint64 block_begin = uint64(k) * BLOCK_SIZE;
+        const uint64 block_end   = nvbio::min( block_begin + BLOCK_SIZE, n_bytes );
+
+        uint64 c_counts[8] = { 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u };
+        for (uint64 j = block_begin; j < block_end; ++j)
+            c_counts[ rle_code::symbol( runs[j] ) ] += rle_code::length( runs[j] );
+
+        uint64* block_counts = &counts[ k*5u ];
+        for (uint32 c = 0; c < 4; ++c)
+            block_counts[c] = c_counts[c];
+
+        block_counts[4] = c_counts[0] + c_counts[1] + c_counts[2] + c_counts[3] +
+                          c_counts[4] + c_counts[5] + c_counts[6] + c_counts[7];
+    }
+
+    // scan them to compute the block positions and occurrence counters
+    m_pos.resize( n_blocks + 1u );
+    m_occ.resize( uint64( n_blocks ) * 4u );
+
+    uint64 counters[5] = { 0u, 0u, 0u, 0u, 0u };
+    for (uint32 k = 0; k < n_blocks; ++k)
+    {
+        m_pos[k] = counters[4];
+        for (uint32 c = 0; c < 4; ++c)
+            m_occ[ uint64(k)*4u + c ] = counters[c];
+
+        for (uint32 c = 0; c < 5; ++c)
+            counters[c] += counts[ uint64(k)*5u + c ];
+    }
+    m_pos[ n_blocks ] = counters[4];
+    m_size            = counters[4];
+
+    // and build the position index, each block filling in the samples it contains
+    m_index.resize( util::divide_ri( m_size, SAMPLE_INTERVAL ) );
+
+    const uint64* pos = raw_pointer( m_pos );
+          uint32* idx = raw_pointer( m_index );
+
+    #pragma omp parallel for
+    for (int64 k = 0; k < int64( n_blocks ); ++k)
+    {
+        for (uint64 j = util::divide_ri( pos[k], SAMPLE_INTERVAL ); j * SAMPLE_INTERVAL < pos[k+1]; ++j)
+            idx[j] = uint32(k);
+    }
+
+    if (cnt)
+    {
+        for (uint32 c = 0; c < 4; ++c)
+            cnt[c] = counters[c];
+    }
+}
+
+// fetch the text character at position i in the rank dictionary
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint8 text(const rle_rank_dictionary& dict, const uint64 i)
+{
+    return dict.text[i];
+}
+
+// fetch the number of occurrences of character c in the substring [0,i]
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64 rank(
+    const rle_rank_dictionary& dict, const uint64 i, const uint32 c)
+{
+    if (i == uint64(-1))
+        return 0u;
+
+    const uint32 k = dict.text.find_block( i );
+
+    uint64 x = dict.occ[ uint64(k)*4u + c ];
+
+    // decode the block's runs up to the one containing i
+    const uint8* run = dict.text.runs + uint64(k) * rle_rank_dictionary::BLOCK_SIZE;
+    for (uint64 p = dict.text.pos[k];; ++run)
+    {
+        const uint32 len = rle_code::length( *run );
+        const bool   hit = rle_code::symbol( *run ) == c;
+
+        if (p + len > i)
+            return hit ? x + (i - p + 1u) : x;
+
+        x += hit ? len : 0u;
+        p += len;
+    }
+}
+
+// fetch the number of occurrences of character c in the substrings [0,l] and [0,r]
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64_2 rank(
+    const rle_rank_dictionary& dict, const uint64_2 range, const uint32 c)
+{
+    return make_vector(
+        rank( dict, range.x, c ),
+        rank( dict, range.y, c ) );
+}
+
+// fetch the number of occurrences of all characters c in the substring [0,i]
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint64_4 rank4(
+    const rle_rank_dictionary& dict, const uint64 i)
+{
+    if (i == uint64(-1))
+        return make_vector( uint64(0u), uint64(0u), uint64(0u), uint64(0u) );
+
+    const uint32 k = dict.text.find_block( i );
+
+    // keep a counter for every symbol, so as to avoid branching on Ns and dollars
+    const uint64* occ = dict.occ + uint64(k)*4u;
+    uint64 x[8] = { occ[0], occ[1], occ[2], occ[3], 0u, 0u, 0u, 0u };
+
+    // decode the block's runs up to the one containing i
+    const uint8* run = dict.text.runs + uint64(k) * rle_rank_dictionary::BLOCK_SIZE;
+    for (uint64 p = dict.text.pos[k];; ++run)
+    {
+        const uint32 len = rle_code::length( *run );
+        const uint8  c   = rle_code::symbol( *run );
+
+        if (p + len > i)
+        {
+            x[c] += i - p + 1u;
+            break;
+        }
+        x[c] += len;
+        p    += len;
+    }
+    return make_vector( x[0], x[1], x[2], x[3] );
+}
+
+// fetch the number of occurrences of all characters in the substrings [0,l] and [0,r]
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void rank4(
+    const rle_rank_dictionary& dict, const uint64_2 range, uint64_4* outl, uint64_4* outh)
+{
+    *outl = rank4( dict, range.x );
+    *outh = rank4( dict, range.y );
+}
+
+// issue a software prefetch for the tables needed to answer rank queries at position i
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE void prefetch(
+    const rle_rank_dictionary& dict, const uint64 i)
+{
+    if (i == uint64(-1))
+        return;
+
+    // the position index must be read to locate anything else: prefetch the tables of the
+    // block it points to, which will be the right one most of the time when runs are long
+    const uint32 k = dict.text.index[ i / rle_rank_text::SAMPLE_INTERVAL ];
+
+    host_prefetch( dict.text.pos, k );
+    host_prefetch( dict.occ,      uint64(k)*4u );
+    host_prefetch( dict.text.runs, uint64(k) * rle_rank_dictionary::BLOCK_SIZE );
+}
+
+} // namespace nvbio
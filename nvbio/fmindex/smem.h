@@ -0,0 +1,187 @@
+/*
+ * nvbio
+ * Copyright (C) 2011-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/fmindex/fmindex.h>
+#include <nvbio/fmindex/bidir.h>
+#include <nvbio/fmindex/mem.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/atomics.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/omp.h>
+#include <thrust/host_vector.h>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup FMIndex
+///@{
+
+///
+///\par
+/// A compact, CSR-style container for the MEM ranges found in a batch of strings:
+/// the ranges of the i-th string are stored contiguously in
+/// <i>m_ranges[ m_offsets[i], m_offsets[i+1] )</i>, sorted by their starting coordinate
+/// on the string.
+///
+/// \tparam coord_type      the coordinate type of the fm-index, uint32|uint64
+///
+template <typename coord_type>
+struct SMEMSet
+{
+    typedef MEMRange<coord_type>        rank_type;      ///< the MEM range type
+
+    /// return the number of strings
+    ///
+    uint32 size() const { return m_offsets.size() ? uint32( m_offsets.size() - 1u ) : 0u; }
+
+    /// return the total number of MEM ranges
+    ///
+    uint64 n_ranges() const { return m_ranges.size(); }
+
+    /// return the number of MEM ranges of the i-th string
+    ///
+    uint32 n_ranges(const uint32 i) const { return uint32( m_offsets[i+1] - m_offsets[i] ); }
+
+    /// return the MEM ranges of the i-th string
+    ///
+    const rank_type* operator[] (const uint32 i) const { return &m_ranges[0] + m_offsets[i]; }
+
+    thrust::host_vector<uint64>         m_offsets;      ///< the CSR offsets, one entry per string plus one
+    thrust::host_vector<rank_type>      m_ranges;       ///< the concatenated MEM ranges
+};
+
+///
+/// Timing and work statistics of a batched SMEM search
+///
+struct SMEMStats
+{
+    SMEMStats() :
+        n_strings( 0 ),
+        n_ranges( 0 ),
+        n_steps( 0 ),
+        n_rank_calls( 0 ),
+        time( 0.0f ),
+        search_time( 0.0f ),
+        rank_time( 0.0f ),
+        bookkeeping_time( 0.0f ),
+        assembly_time( 0.0f ) {}
+
+    uint64 n_strings;           ///< number of searched strings
+    uint64 n_ranges;            ///< number of output MEM ranges
+    uint64 n_steps;             ///< number of single-symbol extension steps
+    uint64 n_rank_calls;        ///< number of rank() queries issued to the FM-indices
+    float  time;                ///< total time
+    float  search_time;         ///< time spent in the interleaved search
+    float  rank_time;           ///< share of the search time spent in rank() queries
+    float  bookkeeping_time;    ///< share of the search time spent in the search state machines
+    float  assembly_time;       ///< time spent assembling the CSR output
+};
+
+///
+///\par
+/// A batched SMEM (Super-Maximal Exact Match) finder for the host, built on top of the
+/// bidirectional FM-index primitives.
+///\par
+/// Given a batch of strings, each host thread keeps several strings in flight at the same
+/// time (one per <i>lane</i>), advancing all of them in lock-step by one extension step at
+/// a time: the rank dictionary blocks needed by the next step of each lane are prefetched
+/// before any of them is used, so that the latency of the (essentially random) memory
+/// accesses performed by independent searches overlaps, rather than being paid serially.
+///\par
+/// Each string is searched exactly as find_kmems() would do, and the output is the same
+/// set of MEM ranges produced by the MEMFilter rank phase, returned in an SMEMSet.
+/// Strings are distributed to threads dynamically, in small chunks.
+///
+/// \tparam fm_index_type    the type of the fm-index
+///
+template <typename fm_index_type>
+struct SMEMFinderHost
+{
+    typedef fm_index_type                                   index_type;     ///< the index type
+    typedef typename index_type::index_type                 coord_type;     ///< the coordinate type of the fm-index, uint32|uint64
+    typedef MEMRange<coord_type>                            rank_type;      ///< the MEM range type
+    typedef SMEMSet<coord_type>                             smem_set_type;  ///< the output container type
+
+    static const uint32 LANES      = 16u;       ///< default number of strings in flight per thread
+    static const uint32 CHUNK_SIZE = 64u;       ///< default number of strings grabbed at once by each thread
+
+    /// empty constructor
+    ///
+    SMEMFinderHost() :
+        m_n_threads( 0u ),
+        m_lanes( LANES ),
+        m_chunk_size( CHUNK_SIZE ) {}
+
+    /// set the number of host threads; 0 means using omp_get_max_threads()
+    ///
+    void set_threads(const uint32 n_threads) { m_n_threads = n_threads; }
+
+    /// set the number of strings each thread keeps in flight
+    ///
+    void set_lanes(const uint32 lanes) { m_lanes = nvbio::max( lanes, 1u ); }
+
+    /// set the number of strings grabbed at once by each thread
+    ///
+    void set_chunk_size(const uint32 chunk_size) { m_chunk_size = nvbio::max( chunk_size, 1u ); }
+
+    /// return the number of host threads
+    ///
+    uint32 threads() const { return m_n_threads ? m_n_threads : uint32( omp_get_max_threads() ); }
+
+    /// find all SMEMs of a string-set
+    ///
+    /// \param f_index          the forward FM-index
+    /// \param r_index          the reverse FM-index
+    /// \param string_set       the query string-set
+    /// \param smems            the output MEM ranges
+    /// \param min_intv         the minimum number of occurrences k of a k-MEM
+    /// \param max_intv         the maximum number of occurrences k of a k-MEM
+    /// \param min_span         the minimum span length on the pattern of MEM
+    ///
+    /// \return the total number of MEM ranges
+    ///
+    template <typename string_set_type>
+    uint64 find(
+        const fm_index_type&    f_index,
+        const fm_index_type&    r_index,
+        const string_set_type&  string_set,
+        smem_set_type&          smems,
+        const uint32            min_intv    = 1u,
+        const uint32            max_intv    = uint32(-1),
+        const uint32            min_span    = 1u);
+
+    /// return the statistics of the last search
+    ///
+    const SMEMStats& stats() const { return m_stats; }
+
+    uint32                          m_n_threads;
+    uint32                          m_lanes;
+    uint32                          m_chunk_size;
+    SMEMStats                       m_stats;
+    thrust::host_vector<uint32>     m_owner;            ///< the thread which searched each string
+    thrust::host_vector<uint64>     m_local_offset;     ///< the offset of each string's output in its thread's buffer
+};
+
+///@} // end of the FMIndex group
+
+} // namespace nvbio
+
+#include <nvbio/fmindex/smem_inl.h>
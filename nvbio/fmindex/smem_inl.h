@@ -0,0 +1,570 @@
+/*
+ * nvbio
+ * Copyright (C) 2011-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+namespace nvbio {
+namespace smem {
+
+// the state of a single search in flight: this is a resumable version of find_kmems(),
+// which stops right before each rank() query
+//
+template <typename index_type, typename string_set_type>
+struct lane
+{
+    typedef typename index_type::index_type             coord_type;
+    typedef typename index_type::range_type             range_type;
+    typedef typename vector_type<coord_type,4u>::type   right_type;
+    typedef MEMRange<coord_type>                        rank_type;
+    typedef typename string_set_type::string_type       string_type;
+
+    enum Phase
+    {
+        BEGIN_FORWARD   = 0,    // start extending right from x
+        CHECK_FORWARD   = 1,    // check whether we can extend right from i
+        RANK_FORWARD    = 2,    // a forward extension is pending
+        END_FORWARD     = 3,    // finalize the right extensions
+        BEGIN_BACKWARD  = 4,    // start extending the j-th right range left
+        CHECK_BACKWARD  = 5,    // check whether we can extend left from l
+        RANK_BACKWARD   = 6,    // a backward extension is pending
+        END_BACKWARD    = 7,    // output the j-th MEM
+        IDLE            = 8     // no more strings to search
+    };
+
+    uint32                  phase;
+    uint32                  string_id;
+    string_type             pattern;
+    uint32                  pattern_len;
+    uint32                  x;              // the base to cover
+    uint32                  i;              // the right end of the current forward extension
+    int32                   l;              // the left end of the current backward extension
+    int32                   j;              // the current right range
+    uint32                  leftmost;       // the leftmost coordinate covered by a MEM
+    uint32                  rightmost;      // the rightmost coordinate covered by a MEM
+    uint32                  mems_begin;     // the first output MEM covering x
+    uint8                   c;              // the pending symbol
+    range_type              f_range;
+    range_type              r_range;
+    range_type              prev_range;
+    range_type              next_range;
+    std::vector<right_type> right;          // the right extensions of x
+    std::vector<rank_type>  mems;           // the output MEMs of the current string
+};
+
+// the per-thread engine advancing a group of lanes in lock-step
+//
+template <typename index_type, typename string_set_type>
+struct engine
+{
+    typedef lane<index_type,string_set_type>            lane_type;
+    typedef typename lane_type::coord_type              coord_type;
+    typedef typename lane_type::range_type              range_type;
+    typedef typename lane_type::right_type              right_type;
+    typedef typename lane_type::rank_type               rank_type;
+
+    // constructor
+    engine(
+        const index_type        _f_index,
+        const index_type        _r_index,
+        const string_set_type   _string_set,
+        const uint32            _min_intv,
+        const uint32            _max_intv,
+        const uint32            _min_span,
+        const uint32            _chunk_size,
+        uint32*                 _next_chunk,
+        uint64*                 _counts,
+        uint32*                 _owner,
+        uint64*                 _local_offset,
+        const uint32            _thread_id,
+        std::vector<rank_type>& _output) :
+    f_index         ( _f_index ),
+    r_index         ( _r_index ),
+    string_set      ( _string_set ),
+    n_strings       ( _string_set.size() ),
+    min_intv        ( _min_intv ),
+    max_intv        ( _max_intv ),
+    min_span        ( _min_span ),
+    chunk_size      ( _chunk_size ),
+    next_chunk      ( _next_chunk ),
+    chunk_begin     ( 0u ),
+    chunk_end       ( 0u ),
+    counts          ( _counts ),
+    owner           ( _owner ),
+    local_offset    ( _local_offset ),
+    thread_id       ( _thread_id ),
+    output          ( _output ),
+    rank_ticks      ( 0u ),
+    bookkeeping_ticks( 0u ),
+    n_steps         ( 0u ),
+    n_rank_calls    ( 0u ) {}
+
+    // bind the next string to the given lane
+    bool fetch(lane_type& ln)
+    {
+        if (chunk_begin >= chunk_end)
+        {
+            // grab a new chunk of strings
+            chunk_begin = atomic_add( next_chunk, chunk_size );
+            chunk_end   = nvbio::min( chunk_begin + chunk_size, n_strings );
+            if (chunk_begin >= n_strings)
+                return false;
+        }
+
+        ln.string_id   = chunk_begin++;
+        ln.pattern     = string_set[ ln.string_id ];
+        ln.pattern_len = nvbio::length( ln.pattern );
+        ln.x           = 0u;
+        ln.phase       = lane_type::BEGIN_FORWARD;
+        ln.mems.clear();
+        return true;
+    }
+
+    // flush the output of the string bound to the given lane
+    void finish(lane_type& ln)
+    {
+        counts[ ln.string_id ]       = ln.mems.size();
+        owner[ ln.string_id ]        = thread_id;
+        local_offset[ ln.string_id ] = output.size();
+
+        output.insert( output.end(), ln.mems.begin(), ln.mems.end() );
+    }
+
+    // advance the given lane up to its next rank() query
+    //
+    // \return false if there is no more work for this lane
+    bool advance(lane_type& ln)
+    {
+        while (1)
+        {
+            switch (ln.phase)
+            {
+            case lane_type::BEGIN_FORWARD:
+                if (ln.x >= ln.pattern_len)
+                {
+                    finish( ln );
+                    if (fetch( ln ) == false)
+                    {
+                        ln.phase = lane_type::IDLE;
+                        return false;
+                    }
+                    break;
+                }
+                // extend forward, using the reverse index
+                ln.f_range    = make_vector( coord_type(0u), f_index.length() );
+                ln.r_range    = make_vector( coord_type(0u), r_index.length() );
+                ln.prev_range = ln.f_range;
+                ln.i          = ln.x;
+                ln.right.clear();
+                ln.phase      = lane_type::CHECK_FORWARD;
+                break;
+
+            case lane_type::CHECK_FORWARD:
+                if (ln.i >= ln.pattern_len)
+                {
+                    ln.phase = lane_type::END_FORWARD;
+                    break;
+                }
+                ln.c = ln.pattern[ ln.i ];
+                if (ln.c > 3) // there is an N here. no match
+                {
+                    ln.prev_range = ln.f_range;
+                    ln.phase      = lane_type::END_FORWARD;
+                    break;
+                }
+                ln.phase = lane_type::RANK_FORWARD;
+                return true;
+
+            case lane_type::END_FORWARD:
+                // check if we still need to save one range, as in find_kmems()
+                if (ln.right.size() ?
+                    (ln.right.back().y - ln.right.back().x) != (ln.prev_range.y - ln.prev_range.x) :
+                    ln.i > ln.x)
+                    ln.right.push_back( make_vector( ln.prev_range.x, ln.prev_range.y, coord_type(ln.x), coord_type(ln.i) ) );
+
+                // no valid match covering x
+                if (ln.right.size() == 0u)
+                {
+                    ln.x     = ln.x + 1u;
+                    ln.phase = lane_type::BEGIN_FORWARD;
+                    break;
+                }
+
+                // save the result value for later
+                ln.rightmost = uint32( ln.right.back().w );
+
+                // keep track of the left-most coordinate covered by a MEM
+                ln.leftmost  = ln.x + 1u;
+
+                // and of the first MEM covering x
+                ln.mems_begin = uint32( ln.mems.size() );
+
+                // now loop through all the right ranges backwards
+                ln.j         = int32( ln.right.size() ) - 1;
+                ln.phase     = lane_type::BEGIN_BACKWARD;
+                break;
+
+            case lane_type::BEGIN_BACKWARD:
+                ln.f_range = make_vector( ln.right[ ln.j ].x, ln.right[ ln.j ].y );
+                ln.l       = int32( ln.x ) - 1;
+                ln.phase   = lane_type::CHECK_BACKWARD;
+                break;
+
+            case lane_type::CHECK_BACKWARD:
+                if (ln.l < 0)
+                {
+                    ln.phase = lane_type::END_BACKWARD;
+                    break;
+                }
+                ln.c = ln.pattern[ ln.l ];
+                if (ln.c > 3) // there is an N here. no match
+                {
+                    ln.phase = lane_type::END_BACKWARD;
+                    break;
+                }
+                ln.phase = lane_type::RANK_BACKWARD;
+                return true;
+
+            case lane_type::END_BACKWARD:
+                {
+                    const uint32 r = uint32( ln.right[ ln.j ].w );
+
+                    // only output the range if it's not contained in any other MEM
+                    if (uint32(ln.l+1) < ln.leftmost && uint32(ln.l+1) < r)
+                    {
+                        // save the range, together with its span
+                        const uint2 pattern_span = make_uint2( uint32(ln.l+1), r );
+
+                        // keep the MEM only if it is above a certain length
+                        if (pattern_span.y - pattern_span.x >= min_span)
+                        {
+                            // check whether the SA range is small enough
+                            if (1u + ln.f_range.y - ln.f_range.x <= max_intv)
+                                ln.mems.push_back( rank_type( ln.f_range, ln.string_id, pattern_span ) );
+
+                            // update the left-most covered coordinate
+                            ln.leftmost = uint32(ln.l+1);
+                        }
+                    }
+
+                    if (--ln.j < 0)
+                    {
+                        // the MEMs covering x have been found right to left: reverse them, so as
+                        // to keep the output sorted by the starting coordinate (as MEMs covering x
+                        // end before those covering any of the following positions)
+                        std::reverse( ln.mems.begin() + ln.mems_begin, ln.mems.end() );
+
+                        // move to the next uncovered position along the pattern
+                        ln.x     = nvbio::max( ln.rightmost, ln.x+1u );
+                        ln.phase = lane_type::BEGIN_FORWARD;
+                    }
+                    else
+                        ln.phase = lane_type::BEGIN_BACKWARD;
+                }
+                break;
+
+            case lane_type::RANK_FORWARD:
+            case lane_type::RANK_BACKWARD:
+                return true;
+
+            default:
+                return false;
+            }
+        }
+    }
+
+    // prefetch the rank dictionary blocks needed by the pending query of the given lane
+    void prefetch(const lane_type& ln) const
+    {
+        if (ln.phase == lane_type::RANK_FORWARD)
+        {
+            nvbio::prefetch( r_index, ln.r_range.x-1 );
+            nvbio::prefetch( r_index, ln.r_range.y );
+        }
+        else
+        {
+            nvbio::prefetch( f_index, ln.f_range.x-1 );
+            nvbio::prefetch( f_index, ln.f_range.y );
+        }
+    }
+
+    // perform the pending rank() query of the given lane
+    void rank(lane_type& ln)
+    {
+        if (ln.phase == lane_type::RANK_FORWARD)
+        {
+            // search c in the FM-index
+            extend_forward( f_index, r_index, ln.f_range, ln.r_range, ln.c );
+
+            n_rank_calls += ln.c + 1u;
+        }
+        else
+        {
+            // search c in the FM-index
+            const range_type c_rank = nvbio::rank(
+                f_index,
+                make_vector( ln.f_range.x-1, ln.f_range.y ),
+                ln.c );
+
+            ln.next_range = make_vector(
+                f_index.L2(ln.c) + c_rank.x + 1,
+                f_index.L2(ln.c) + c_rank.y );
+
+            n_rank_calls++;
+        }
+    }
+
+    // consume the result of the last rank() query of the given lane
+    void consume(lane_type& ln)
+    {
+        if (ln.phase == lane_type::RANK_FORWARD)
+        {
+            // check if the range is too small
+            if (1u + ln.f_range.y - ln.f_range.x < min_intv)
+            {
+                ln.phase = lane_type::END_FORWARD;
+                return;
+            }
+
+            // store the range
+            if (ln.f_range.y - ln.f_range.x != ln.prev_range.y - ln.prev_range.x)
+            {
+                // do not add the empty span
+                if (ln.i > ln.x)
+                    ln.right.push_back( make_vector( ln.prev_range.x, ln.prev_range.y, coord_type(ln.x), coord_type(ln.i) ) );
+
+                ln.prev_range = ln.f_range;
+            }
+            ln.i++;
+            ln.phase = lane_type::CHECK_FORWARD;
+        }
+        else
+        {
+            // stop if the range became too small
+            if (1u + ln.next_range.y - ln.next_range.x < min_intv)
+            {
+                ln.phase = lane_type::END_BACKWARD;
+                return;
+            }
+
+            // update the range
+            ln.f_range = ln.next_range;
+            ln.l--;
+            ln.phase = lane_type::CHECK_BACKWARD;
+        }
+    }
+
+    // run the search on n_lanes lanes until all strings have been consumed
+    void run(const uint32 n_lanes)
+    {
+        std::vector<lane_type> lanes( n_lanes );
+        std::vector<uint32>    active;
+        active.reserve( n_lanes );
+
+        // bind the first strings to the lanes
+        for (uint32 k = 0; k < n_lanes; ++k)
+        {
+            if (fetch( lanes[k] ) && advance( lanes[k] ))
+            {
+                prefetch( lanes[k] );
+                active.push_back( k );
+            }
+        }
+
+        while (active.size())
+        {
+            const uint64 t0 = host_ticks();
+
+            // perform all pending rank queries: their memory accesses have been
+            // prefetched in the previous round, so that their latencies overlap
+            for (uint32 k = 0; k < active.size(); ++k)
+                rank( lanes[ active[k] ] );
+
+            const uint64 t1 = host_ticks();
+
+            n_steps += active.size();
+
+            // update the lane states, advancing each to its next query
+            uint32 n_active = 0;
+            for (uint32 k = 0; k < active.size(); ++k)
+            {
+                lane_type& ln = lanes[ active[k] ];
+
+                consume( ln );
+                if (advance( ln ))
+                {
+                    prefetch( ln );
+                    active[ n_active++ ] = active[k];
+                }
+            }
+            active.resize( n_active );
+
+            const uint64 t2 = host_ticks();
+
+            rank_ticks        += t1 - t0;
+            bookkeeping_ticks += t2 - t1;
+        }
+    }
+
+    const index_type            f_index;
+    const index_type            r_index;
+    const string_set_type       string_set;
+    const uint32                n_strings;
+    const uint32                min_intv;
+    const uint32                max_intv;
+    const uint32                min_span;
+    const uint32                chunk_size;
+    uint32*                     next_chunk;
+    uint32                      chunk_begin;
+    uint32                      chunk_end;
+    uint64*                     counts;
+    uint32*                     owner;
+    uint64*                     local_offset;
+    const uint32                thread_id;
+    std::vector<rank_type>&     output;
+    uint64                      rank_ticks;
+    uint64                      bookkeeping_ticks;
+    uint64                      n_steps;
+    uint64                      n_rank_calls;
+};
+
+} // namespace smem
+
+// find all SMEMs of a string-set
+//
+template <typename fm_index_type>
+template <typename string_set_type>
+uint64 SMEMFinderHost<fm_index_type>::find(
+    const fm_index_type&    f_index,
+    const fm_index_type&    r_index,
+    const string_set_type&  string_set,
+    smem_set_type&          smems,
+    const uint32            min_intv,
+    const uint32            max_intv,
+    const uint32            min_span)
+{
+    typedef smem::engine<fm_index_type,string_set_type> engine_type;
+
+    const uint32 n_strings = string_set.size();
+    const uint32 n_threads = threads();
+
+    m_stats = SMEMStats();
+    m_stats.n_strings = n_strings;
+
+    smems.m_offsets.resize( n_strings + 1u );
+    m_owner.resize( n_strings );
+    m_local_offset.resize( n_strings );
+
+    // per-thread output buffers and statistics
+    std::vector< std::vector<rank_type> > thread_output( n_threads );
+    std::vector<uint64>                   thread_rank_ticks( n_threads, 0u );
+    std::vector<uint64>                   thread_bookkeeping_ticks( n_threads, 0u );
+    std::vector<uint64>                   thread_steps( n_threads, 0u );
+    std::vector<uint64>                   thread_rank_calls( n_threads, 0u );
+
+    uint32 next_chunk = 0u;
+
+    Timer timer;
+    timer.start();
+
+    #pragma omp parallel num_threads( n_threads )
+    {
+        const uint32 thread_id = omp_get_thread_num();
+
+        engine_type engine(
+            f_index,
+            r_index,
+            string_set,
+            min_intv,
+            max_intv,
+            min_span,
+            m_chunk_size,
+            &next_chunk,
+            nvbio::plain_view( smems.m_offsets ),
+            nvbio::plain_view( m_owner ),
+            nvbio::plain_view( m_local_offset ),
+            thread_id,
+            thread_output[ thread_id ] );
+
+        engine.run( m_lanes );
+
+        thread_rank_ticks[ thread_id ]        = engine.rank_ticks;
+        thread_bookkeeping_ticks[ thread_id ] = engine.bookkeeping_ticks;
+        thread_steps[ thread_id ]             = engine.n_steps;
+        thread_rank_calls[ thread_id ]        = engine.n_rank_calls;
+    }
+
+    timer.stop();
+    m_stats.search_time = timer.seconds();
+
+    timer.start();
+
+    // turn the per-string counts into CSR offsets
+    uint64 n_ranges = 0u;
+    for (uint32 i = 0; i < n_strings; ++i)
+    {
+        const uint64 count = smems.m_offsets[i];
+        smems.m_offsets[i] = n_ranges;
+        n_ranges += count;
+    }
+    smems.m_offsets[ n_strings ] = n_ranges;
+
+    // and gather each string's output from the buffer of the thread which searched it
+    smems.m_ranges.resize( n_ranges );
+
+    #pragma omp parallel for num_threads( n_threads )
+    for (int i = 0; i < int( n_strings ); ++i)
+    {
+        const uint32 count = smems.n_ranges(i);
+        if (count == 0)
+            continue;
+
+        const rank_type* src = &thread_output[ m_owner[i] ][0] + m_local_offset[i];
+
+        std::copy(
+            src,
+            src + count,
+            smems.m_ranges.begin() + smems.m_offsets[i] );
+    }
+
+    timer.stop();
+    m_stats.assembly_time = timer.seconds();
+
+    // collect the statistics, splitting the search time proportionally to the
+    // amount of ticks spent in the rank and bookkeeping stages
+    uint64 rank_ticks        = 0u;
+    uint64 bookkeeping_ticks = 0u;
+    for (uint32 t = 0; t < n_threads; ++t)
+    {
+        rank_ticks             += thread_rank_ticks[t];
+        bookkeeping_ticks      += thread_bookkeeping_ticks[t];
+        m_stats.n_steps        += thread_steps[t];
+        m_stats.n_rank_calls   += thread_rank_calls[t];
+    }
+    const float rank_share = (rank_ticks + bookkeeping_ticks) ?
+        float( double( rank_ticks ) / double( rank_ticks + bookkeeping_ticks ) ) : 0.0f;
+
+    m_stats.n_ranges         = n_ranges;
+    m_stats.rank_time        = m_stats.search_time * rank_share;
+    m_stats.bookkeeping_time = m_stats.search_time - m_stats.rank_time;
+    m_stats.time             = m_stats.search_time + m_stats.assembly_time;
+    return n_ranges;
+}
+
+} // namespace nvbio
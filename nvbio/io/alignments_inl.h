@@ -23,7 +23,7 @@ namespace io {
 
 // check whether two alignments are distinct
 //
-NVBIO_FORCEINLINE NVBIO_DEVICE bool distinct_alignments(
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE bool distinct_alignments(
     const uint32 pos1,
     const bool   rc1,
     const uint32 pos2,
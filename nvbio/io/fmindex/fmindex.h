@@ -23,11 +23,14 @@
 #include <vector>
 #include <algorithm>
 #include <nvbio/basic/mmap.h>
+#include <nvbio/basic/numa.h>
 #include <nvbio/basic/vector.h>
+#include <nvbio/basic/exceptions.h>
 #include <nvbio/basic/deinterleaved_iterator.h>
 #include <nvbio/basic/cuda/ldg.h>
 #include <nvbio/fmindex/fmindex.h>
 #include <nvbio/fmindex/ssa.h>
+#include <nvbio/fmindex/kmer_lut.h>
 
 namespace nvbio {
 ///@addtogroup IO
@@ -77,13 +80,24 @@ struct FMIndexDataCore
     static const uint32 FORWARD = 0x02;
     static const uint32 REVERSE = 0x04;
     static const uint32 SA      = 0x10;
+    static const uint32 KMER_LUT = 0x20;
 
     static const uint32 BWT_BITS             = 2u;                              // NOTE: DNA alphabet
     static const bool   BWT_BIG_ENDIAN       = true;                            // NOTE: needs to be true to allow fast BWT construction
     static const uint32 BWT_SYMBOLS_PER_WORD = (8*sizeof(uint32))/BWT_BITS;
 
-    static const uint32 OCC_INT = 64;
-    static const uint32 SA_INT  = 16;
+    static const uint32 OCC_INT = 64;                                       ///< the default occurrence table interval
+    static const uint32 SA_INT  = 16;                                       ///< the default sampled suffix array interval
+
+    /// return whether a given occurrence table interval is supported by the loaders,
+    /// i.e. whether it is one of 32, 64, 128 or 256
+    ///
+    static bool is_supported_occ_intv(const uint32 intv) { return intv == 32u || intv == 64u || intv == 128u || intv == 256u; }
+
+    /// return whether a given sampled suffix array interval is supported by the loaders,
+    /// i.e. whether it is one of 16, 32 or 64
+    ///
+    static bool is_supported_sa_intv(const uint32 intv) { return intv == 16u || intv == 32u || intv == 64u; }
 
     typedef const uint32*               bwt_occ_type;
     typedef const uint32*               count_table_type;
@@ -101,10 +115,15 @@ struct FMIndexDataCore
         m_sa_words      ( 0 ),
         m_primary       ( 0 ),
         m_rprimary      ( 0 ),
+        m_occ_intv      ( OCC_INT ),
+        m_sa_intv       ( SA_INT ),
+        m_kmer_k        ( 0 ),
         m_L2            ( NULL ),
         m_bwt_occ       ( NULL ),
         m_rbwt_occ      ( NULL ),
-        m_count_table   ( NULL )
+        m_count_table   ( NULL ),
+        m_kmer_lut      ( NULL ),
+        m_rkmer_lut     ( NULL )
     {}
     
     uint32        flags()           const { return m_flags; }               ///< return loading flags
@@ -113,11 +132,24 @@ struct FMIndexDataCore
     uint32        rprimary()        const { return m_rprimary; }            ///< return the reverse primary key
     bool          has_ssa()         const { return m_ssa.m_ssa != NULL; }   ///< return whether the sampled suffix array is present
     bool          has_rssa()        const { return m_rssa.m_ssa != NULL; }  ///< return whether the reverse sampled suffix array is present
+    bool          has_kmer_lut()    const { return m_kmer_lut != NULL; }    ///< return whether the forward k-mer lookup table is present
+    bool          has_rkmer_lut()   const { return m_rkmer_lut != NULL; }   ///< return whether the reverse k-mer lookup table is present
+    uint32        kmer_k()          const { return m_kmer_k; }              ///< return the k-mer lookup table length
     const uint32*  bwt_occ()        const { return m_bwt_occ; }             ///< return the BWT stream
     const uint32* rbwt_occ()        const { return m_rbwt_occ; }            ///< return the reverse BWT stream
     const uint32*  count_table()    const { return m_count_table; }         ///< return the count table
     uint32        bwt_occ_words()   const { return m_bwt_occ_words; }       ///< return the number of sequence words
     uint32        sa_words()        const { return m_sa_words; }            ///< return the number of SA words
+    uint32        occ_intv()        const { return m_occ_intv; }            ///< return the occurrence table interval
+    uint32        sa_intv()         const { return m_sa_intv; }             ///< return the sampled suffix array interval
+    uint32        bwt_words()       const { return align<4>( util::divide_ri( m_seq_length, BWT_SYMBOLS_PER_WORD ) ); } ///< return the number of BWT words
+    uint32        occ_words()       const { return util::divide_ri( m_seq_length, m_occ_intv ) * 4u; }                 ///< return the number of occurrence table words
+
+    /// return whether the index uses the default occurrence table and SSA intervals expected by
+    /// FMIndexData::index() and FMIndexDataDevice::index(); indices built with any other interval
+    /// must be accessed through an FMIndexDataView (see dispatch_fmindex())
+    ///
+    bool          has_default_intervals() const { return m_occ_intv == OCC_INT && m_sa_intv == SA_INT; }
     ssa_type      ssa()             const { return m_ssa; }
     ssa_type      rssa()            const { return m_rssa; }
     const uint32* L2()              const { return m_L2; }                  ///< return the L2 table
@@ -129,6 +161,9 @@ public:
     uint32      m_sa_words;
     uint32      m_primary;
     uint32      m_rprimary;
+    uint32      m_occ_intv;
+    uint32      m_sa_intv;
+    uint32      m_kmer_k;
 
     uint32*     m_L2;
     uint32*     m_bwt_occ;
@@ -136,6 +171,8 @@ public:
     uint32*     m_count_table;
     ssa_type    m_ssa;
     ssa_type    m_rssa;
+    const uint2* m_kmer_lut;
+    const uint2* m_rkmer_lut;
 };
 
 ///
@@ -164,6 +201,7 @@ struct FMIndexData : public FMIndexDataCore
 
     typedef fm_index<rank_dict_type, ssa_type>                       fm_index_type;
     typedef fm_index<rank_dict_type, null_type>              partial_fm_index_type;
+    typedef fm_index_kmer_lut<uint32>                                kmer_lut_type;
 
              FMIndexData();                                                 ///< empty constructor
     virtual ~FMIndexData() {}                                               ///< virtual destructor
@@ -176,21 +214,154 @@ struct FMIndexData : public FMIndexDataCore
     bwt_type  bwt_iterator() const { return bwt_type(bwt_occ_type( bwt_occ())); }
     bwt_type rbwt_iterator() const { return bwt_type(bwt_occ_type(rbwt_occ())); }
 
-    ssa_type  ssa_iterator() const { return ssa(); }
-    ssa_type rssa_iterator() const { return rssa(); }
+    ssa_type  ssa_iterator() const { check_sa_intv();  return ssa(); }
+    ssa_type rssa_iterator() const { check_sa_intv(); return rssa(); }
 
     count_table_type count_table_iterator() const { return count_table_type( count_table() ); }
 
-    rank_dict_type  rank_dict() const { return rank_dict_type( bwt_stream_type(  bwt_iterator() ),  occ_iterator(), count_table_iterator() ); }
-    rank_dict_type rrank_dict() const { return rank_dict_type( bwt_stream_type( rbwt_iterator() ), rocc_iterator(), count_table_iterator() ); }
+    rank_dict_type  rank_dict() const { check_occ_intv(); return rank_dict_type( bwt_stream_type(  bwt_iterator() ),  occ_iterator(), count_table_iterator() ); }
+    rank_dict_type rrank_dict() const { check_occ_intv(); return rank_dict_type( bwt_stream_type( rbwt_iterator() ), rocc_iterator(), count_table_iterator() ); }
 
     fm_index_type  index() const { return fm_index_type( length(),  primary(),  L2(),  rank_dict(),  ssa_iterator() ); }
     fm_index_type rindex() const { return fm_index_type( length(), rprimary(),  L2(), rrank_dict(), rssa_iterator() ); }
 
     partial_fm_index_type  partial_index() const { return partial_fm_index_type( length(),  primary(), L2(),  rank_dict(), null_type() ); }
     partial_fm_index_type rpartial_index() const { return partial_fm_index_type( length(), rprimary(), L2(), rrank_dict(), null_type() ); }
+
+    kmer_lut_type  kmer_lut() const { return kmer_lut_type( kmer_k(),  m_kmer_lut ); }
+    kmer_lut_type rkmer_lut() const { return kmer_lut_type( kmer_k(), m_rkmer_lut ); }
+
+private:
+    // the views above are only instantiated for the default intervals: refuse to build them
+    // over an index loaded with any other, which must go through dispatch_fmindex()
+    void check_occ_intv() const
+    {
+        if (m_occ_intv != OCC_INT)
+            throw nvbio::runtime_error("FMIndexData: unsupported occurrence table interval %u, use dispatch_fmindex()", m_occ_intv);
+    }
+    void check_sa_intv() const
+    {
+        if (m_sa_intv != SA_INT)
+            throw nvbio::runtime_error("FMIndexData: unsupported SA interval %u, use dispatch_fmindex()", m_sa_intv);
+    }
+};
+
+///
+/// Helper class describing how the BWT and occurrence table of an FMIndexDataCore are laid
+/// out in memory for a given occurrence table interval: with the default interval, 64 symbols
+/// of the BWT (4 words) are interleaved with their 4 occurrence counters, so that both can be
+/// fetched with a single pair of 128-bit loads; with any other interval, the occurrence
+/// table is stored right after the BWT.
+///
+template <uint32 OCC_INT>
+struct FMIndexDataLayout
+{
+    typedef const uint32*       bwt_type;
+    typedef const uint32*       occ_type;
+
+    static bwt_type bwt(const uint32* bwt_occ, const uint32 bwt_words) { return bwt_occ; }
+    static occ_type occ(const uint32* bwt_occ, const uint32 bwt_words) { return bwt_occ + bwt_words; }
+};
+
+template <>
+struct FMIndexDataLayout<FMIndexDataCore::OCC_INT>
+{
+    typedef const uint4*                                bwt_occ_type;
+    typedef deinterleaved_iterator<2,0,bwt_occ_type>    bwt_type;
+    typedef deinterleaved_iterator<2,1,bwt_occ_type>    occ_type;
+
+    static bwt_type bwt(const uint32* bwt_occ, const uint32 bwt_words) { return bwt_type( bwt_occ_type( bwt_occ ) ); }
+    static occ_type occ(const uint32* bwt_occ, const uint32 bwt_words) { return occ_type( bwt_occ_type( bwt_occ ) ); }
+};
+
+///
+/// A typed view of a host FM-index loaded with a given occurrence table and SSA interval.
+/// The intervals must match the ones the index was loaded with: use dispatch_fmindex()
+/// to select the right view at run-time.
+///
+/// \tparam OCC_INT_T      the occurrence table interval, one of 32, 64, 128 or 256
+/// \tparam SA_INT_T       the sampled suffix array interval, one of 16, 32 or 64
+///
+template <uint32 OCC_INT_T, uint32 SA_INT_T>
+struct FMIndexDataView
+{
+    static const uint32 OCC_INT = OCC_INT_T;
+    static const uint32 SA_INT  = SA_INT_T;
+
+    typedef FMIndexDataLayout<OCC_INT>                              layout_type;
+    typedef typename layout_type::bwt_type                          bwt_type;
+    typedef typename layout_type::occ_type                          occ_type;
+    typedef const uint32*                                           count_table_type;
+    typedef PackedStream<bwt_type,uint8,FMIndexDataCore::BWT_BITS,FMIndexDataCore::BWT_BIG_ENDIAN> bwt_stream_type;
+
+    typedef SSA_index_multiple_context<SA_INT,const uint32*>        ssa_type;
+
+    typedef rank_dictionary<
+        FMIndexDataCore::BWT_BITS,
+        OCC_INT,
+        bwt_stream_type,
+        occ_type,
+        count_table_type>                                           rank_dict_type;
+
+    typedef fm_index<rank_dict_type, ssa_type>                      fm_index_type;
+    typedef fm_index<rank_dict_type, null_type>             partial_fm_index_type;
+
+    /// constructor
+    ///
+    FMIndexDataView(const FMIndexDataCore& data) : m_data( &data ) {}
+
+    /// iterators access
+    ///
+    occ_type  occ_iterator() const { return layout_type::occ( m_data->bwt_occ(),  m_data->bwt_words() ); }
+    occ_type rocc_iterator() const { return layout_type::occ( m_data->rbwt_occ(), m_data->bwt_words() ); }
+
+    bwt_type  bwt_iterator() const { return layout_type::bwt( m_data->bwt_occ(),  m_data->bwt_words() ); }
+    bwt_type rbwt_iterator() const { return layout_type::bwt( m_data->rbwt_occ(), m_data->bwt_words() ); }
+
+    ssa_type  ssa_iterator() const { return ssa_type( m_data->m_ssa.m_ssa ); }
+    ssa_type rssa_iterator() const { return ssa_type( m_data->m_rssa.m_ssa ); }
+
+    count_table_type count_table_iterator() const { return count_table_type( m_data->count_table() ); }
+
+    rank_dict_type  rank_dict() const { return rank_dict_type( bwt_stream_type(  bwt_iterator() ),  occ_iterator(), count_table_iterator() ); }
+    rank_dict_type rrank_dict() const { return rank_dict_type( bwt_stream_type( rbwt_iterator() ), rocc_iterator(), count_table_iterator() ); }
+
+    fm_index_type  index() const { return fm_index_type( m_data->length(),  m_data->primary(), m_data->L2(),  rank_dict(),  ssa_iterator() ); }
+    fm_index_type rindex() const { return fm_index_type( m_data->length(), m_data->rprimary(), m_data->L2(), rrank_dict(), rssa_iterator() ); }
+
+    partial_fm_index_type  partial_index() const { return partial_fm_index_type( m_data->length(),  m_data->primary(), m_data->L2(),  rank_dict(), null_type() ); }
+    partial_fm_index_type rpartial_index() const { return partial_fm_index_type( m_data->length(), m_data->rprimary(), m_data->L2(), rrank_dict(), null_type() ); }
+
+    const FMIndexDataCore* m_data;
 };
 
+///
+/// Select the FMIndexDataView matching the occurrence table and SSA intervals an index
+/// has been loaded with, and pass it to a functor implementing the method:
+///\code
+/// template <typename view_type>
+/// void operator() (const view_type& view);
+///\endcode
+///
+/// \return false if the index intervals are not supported
+///
+template <typename Functor>
+bool dispatch_fmindex(const FMIndexDataCore& data, Functor& functor);
+
+///
+/// Build the k-mer lookup tables of the forward and reverse FM-indices (see fm_index_kmer_lut),
+/// and save them to <i>output_prefix.kmer</i> and <i>output_prefix.rkmer</i>, where they
+/// will be found by FMIndexDataHost::load() when passing the KMER_LUT flag.
+///
+/// \param driver_data      the FM-index, loaded with both the FORWARD and REVERSE flags
+/// \param k                the k-mer length, at most fm_index_kmer_lut::MAX_K
+/// \param output_prefix    the output prefix
+///
+bool save_kmer_luts(
+    const FMIndexDataCore&          driver_data,
+    const uint32                    k,
+    const char*                     output_prefix);
+
 void init_ssa(
     const FMIndexData&              driver_data,
     FMIndexData::ssa_storage_type&  ssa,
@@ -198,16 +369,43 @@ void init_ssa(
 
 ///
 /// An in-RAM FM-index.
+///\par
+/// On NUMA systems, the loader can place the index according to a NUMAPlacement:
+/// NUMA_INTERLEAVE and NUMA_BIND are applied to the loaded tables, while with NUMA_REPLICATE
+/// the tables are left on the loading thread's node, and per-node copies can be built with
+/// NUMAReplicas<FMIndexDataHost>.
 ///
 struct FMIndexDataHost : public FMIndexData
 {
+    /// empty constructor
+    ///
+    FMIndexDataHost() {}
+
+    /// copy constructor: the tables are copied, while the memory-mapped k-mer lookup tables,
+    /// if any, are shared with the source, which must outlive the copy
+    ///
+    FMIndexDataHost(const FMIndexDataHost& other);
+
+    /// assignment operator: the tables are copied, while the memory-mapped k-mer lookup tables,
+    /// if any, are shared with the source, which must outlive the copy
+    ///
+    FMIndexDataHost& operator= (const FMIndexDataHost& other);
+
     /// load a genome from file
     ///
     /// \param genome_prefix            prefix file name
     /// \param flags                    loading flags specifying which elements to load
+    /// \param occ_intv                 the occurrence table interval, one of 32, 64, 128 or 256;
+    ///                                 the SSA interval is read from the .sa file header
+    /// \param numa                     the NUMA placement of the loaded tables
+    ///
+    /// If the KMER_LUT flag is specified, the k-mer lookup tables saved by save_kmer_luts()
+    /// are memory-mapped from the .kmer and .rkmer files, if present.
     int load(
-        const char* genome_prefix,
-        const uint32 flags = FORWARD | REVERSE | SA);
+        const char*         genome_prefix,
+        const uint32        flags    = FORWARD | REVERSE | SA,
+        const uint32        occ_intv = OCC_INT,
+        const NUMAPlacement numa     = NUMAPlacement());
 
     nvbio::vector<host_tag,uint32>  m_bwt_occ_vec;          ///< local storage for the forward BWT/OCC
     nvbio::vector<host_tag,uint32>  m_rbwt_occ_vec;         ///< local storage for the reverse BWT/OCC
@@ -215,6 +413,8 @@ struct FMIndexDataHost : public FMIndexData
     nvbio::vector<host_tag,uint32>  m_rssa_vec;             ///< local storage for the reverse SSA
     uint32                          m_count_table_vec[256]; ///< local storage for the BWT counting table
     uint32                          m_L2_vec[5];            ///< local storage for the L2 vector
+    DiskMappedFile                  m_kmer_file;            ///< the memory-mapped forward k-mer lookup table
+    DiskMappedFile                  m_rkmer_file;           ///< the memory-mapped reverse k-mer lookup table
 };
 
 struct FMIndexDataMMAPInfo
@@ -224,6 +424,8 @@ struct FMIndexDataMMAPInfo
     uint32  sa_words;
     uint32  primary;
     uint32  rprimary;
+    uint32  occ_intv;
+    uint32  sa_intv;
     uint32  L2[5];
 };
 
@@ -239,8 +441,10 @@ struct FMIndexDataMMAPServer : public FMIndexData
     ///
     /// \param genome_prefix            prefix file name
     /// \param mapped_name              memory mapped object name
+    /// \param occ_intv                 the occurrence table interval, one of 32, 64, 128 or 256;
+    ///                                 the SSA interval is read from the .sa file header
     int load(
-        const char* genome_prefix, const char* mapped_name);
+        const char* genome_prefix, const char* mapped_name, const uint32 occ_intv = OCC_INT);
 
 private:
     Info                m_info;                         ///< internal info object storage
@@ -364,3 +568,5 @@ void init_ssa(
 
 } // namespace io
 } // namespace nvbio
+
+#include <nvbio/io/fmindex/fmindex_inl.h>
@@ -174,7 +174,7 @@ uint32* load_sa(
     Allocator&      allocator,
     const uint32    seq_length,
     const uint32    primary,
-    const uint32    SA_INT)
+          uint32&   sa_intv)
 {
     uint32* ssa = NULL;
 
@@ -212,11 +212,17 @@ uint32* load_sa(
                 log_error(stderr, "error: failed reading SSA \"%s\"\n", sa_file_name);
                 return 0;
             }
-            if (field != SA_INT)
+            if (FMIndexDataCore::is_supported_sa_intv( field ) == false)
             {
-                log_error(stderr, "unsupported SA interval (found %u, expected %u)\n", field, SA_INT);
+                log_error(stderr, "unsupported SA interval %u\n", field);
                 throw file_mismatch();
             }
+            if (sa_intv && field != sa_intv)
+            {
+                log_error(stderr, "SA file mismatch \"%s\"\n  expected interval %u, got %u\n", sa_file_name, sa_intv, field);
+                throw file_mismatch();
+            }
+            const uint32 SA_INT = field;
 
             if(!fread( &field, sizeof(field), 1, sa_file ))
             {
@@ -238,6 +244,9 @@ uint32* load_sa(
                 log_error(stderr, "error: failed reading SSA \"%s\"\n", sa_file_name);
                 return 0;
             }
+
+            // record the SA interval
+            sa_intv = SA_INT;
         }
         catch (...)
         {
@@ -250,38 +259,55 @@ uint32* load_sa(
     return ssa;
 }
 
+// build the occurrence table of a BWT, sampling the counters every OCC_INT symbols
+//
+template <uint32 OCC_INT>
+void build_occurrence_table(
+    const uint32                            seq_length,
+    const nvbio::vector<host_tag,uint32>&   bwt_vec,
+    uint32*                                 occ,
+    uint32*                                 cnt)
+{
+    typedef PackedStream<const uint32*,uint8,FMIndexDataCore::BWT_BITS,FMIndexDataCore::BWT_BIG_ENDIAN> stream_type;
+
+    // build a bwt stream
+    stream_type bwt( raw_pointer( bwt_vec ) );
+
+    nvbio::build_occurrence_table<OCC_INT>(
+        bwt,
+        bwt + seq_length,
+        occ,
+        cnt );
+}
+
 template <typename Allocator>
 uint32* build_occurrence_table(
     const uint32                            seq_length,
     const uint32                            seq_words,
     const nvbio::vector<host_tag,uint32>&   bwt_vec,
     Allocator&                              allocator,
+    const uint32                            occ_intv,
     uint32&                                 bwt_occ_words,
     uint32*                                 L2)
 {
-    typedef PackedStream<const uint32*,uint8,FMIndexDataCore::BWT_BITS,FMIndexDataCore::BWT_BIG_ENDIAN> stream_type;
-
-    // build a bwt stream
-    stream_type bwt( raw_pointer( bwt_vec ) );
-
     // compute the number of words needed to store the occurrences
-    const uint32 occ_words = util::divide_ri( seq_length, FMIndexDataCore::OCC_INT ) * 4;
+    const uint32 occ_words = util::divide_ri( seq_length, occ_intv ) * 4;
 
     // build the occurrence table
     nvbio::vector<host_tag,uint32> occ_vec( occ_words, 0u );
     uint32 cnt[4];
 
-    nvbio::build_occurrence_table<FMIndexDataCore::OCC_INT>(
-        bwt,
-        bwt + seq_length,
-        raw_pointer( occ_vec ),
-        cnt );
-
-    if (occ_words != seq_words)
+    switch (occ_intv)
     {
-        log_error(stderr, "error: bwt size != occurrence table size!\n  words: %u, %u\n", seq_words, occ_words);
+    case  32u: build_occurrence_table< 32u>( seq_length, bwt_vec, raw_pointer( occ_vec ), cnt ); break;
+    case  64u: build_occurrence_table< 64u>( seq_length, bwt_vec, raw_pointer( occ_vec ), cnt ); break;
+    case 128u: build_occurrence_table<128u>( seq_length, bwt_vec, raw_pointer( occ_vec ), cnt ); break;
+    case 256u: build_occurrence_table<256u>( seq_length, bwt_vec, raw_pointer( occ_vec ), cnt ); break;
+    default:
+        log_error(stderr, "error: unsupported occurrence table interval %u\n", occ_intv);
         return 0;
     }
+
     if ((seq_words % 4u) != 0)
     {
         log_error(stderr, "error: occ size not a multiple of 4\n  words: %u\n", seq_words);
@@ -297,19 +323,35 @@ uint32* build_occurrence_table(
     bwt_occ_words = seq_words + occ_words;
     uint32* bwt_occ = allocator.alloc( bwt_occ_words );
 
-    #if defined(_OPENMP)
-    #pragma omp parallel for
-    #endif
-    for (int64 w = 0; w < int64( seq_words ); w += 4)
+    if (occ_intv == FMIndexDataCore::OCC_INT)
+    {
+        // with the default interval each block of 4 BWT words is interleaved with its 4 counters
+        if (occ_words != seq_words)
+        {
+            log_error(stderr, "error: bwt size != occurrence table size!\n  words: %u, %u\n", seq_words, occ_words);
+            return 0;
+        }
+
+        #if defined(_OPENMP)
+        #pragma omp parallel for
+        #endif
+        for (int64 w = 0; w < int64( seq_words ); w += 4)
+        {
+            bwt_occ[ w*2+0 ] = bwt_vec[ w+0 ];
+            bwt_occ[ w*2+1 ] = bwt_vec[ w+1 ];
+            bwt_occ[ w*2+2 ] = bwt_vec[ w+2 ];
+            bwt_occ[ w*2+3 ] = bwt_vec[ w+3 ];
+            bwt_occ[ w*2+4 ] = occ_vec[ w+0 ];
+            bwt_occ[ w*2+5 ] = occ_vec[ w+1 ];
+            bwt_occ[ w*2+6 ] = occ_vec[ w+2 ];
+            bwt_occ[ w*2+7 ] = occ_vec[ w+3 ];
+        }
+    }
+    else
     {
-        bwt_occ[ w*2+0 ] = bwt_vec[ w+0 ];
-        bwt_occ[ w*2+1 ] = bwt_vec[ w+1 ];
-        bwt_occ[ w*2+2 ] = bwt_vec[ w+2 ];
-        bwt_occ[ w*2+3 ] = bwt_vec[ w+3 ];
-        bwt_occ[ w*2+4 ] = occ_vec[ w+0 ];
-        bwt_occ[ w*2+5 ] = occ_vec[ w+1 ];
-        bwt_occ[ w*2+6 ] = occ_vec[ w+2 ];
-        bwt_occ[ w*2+7 ] = occ_vec[ w+3 ];
+        // otherwise, store the occurrence table right after the BWT
+        memcpy( bwt_occ,             raw_pointer( bwt_vec ), sizeof(uint32) * seq_words );
+        memcpy( bwt_occ + seq_words, raw_pointer( occ_vec ), sizeof(uint32) * occ_words );
     }
 
     // compute the L2 table
@@ -320,6 +362,133 @@ uint32* build_occurrence_table(
     return bwt_occ;
 }
 
+// the header of a k-mer lookup table file, followed by 4^k uint2 ranges
+//
+struct KmerLUTHeader
+{
+    uint32 k;
+    uint32 seq_length;
+    uint32 primary;
+    uint32 reserved;
+};
+
+// memory-map a k-mer lookup table, checking it matches the given BWT
+//
+const uint2* map_kmer_lut(
+    const char*     file_name,
+    DiskMappedFile& file,
+    const uint32    seq_length,
+    const uint32    primary,
+    uint32&         k)
+{
+    const uint8* buffer;
+    try
+    {
+        buffer = (const uint8*)file.init( file_name );
+    }
+    catch (DiskMappedFile::mapping_error)
+    {
+        log_warning(stderr, "unable to open %s\n", file_name);
+        return NULL;
+    }
+    catch (DiskMappedFile::view_error)
+    {
+        log_warning(stderr, "unable to map %s\n", file_name);
+        return NULL;
+    }
+
+    const KmerLUTHeader* header = (const KmerLUTHeader*)buffer;
+    if (file.size() < sizeof(KmerLUTHeader) ||
+        header->k == 0u || header->k > fm_index_kmer_lut<uint32>::MAX_K ||
+        file.size() != sizeof(KmerLUTHeader) + fm_index_kmer_lut<uint32>::entries( header->k ) * sizeof(uint2))
+    {
+        log_warning(stderr, "%s is corrupted\n", file_name);
+        return NULL;
+    }
+    if (header->seq_length != seq_length || header->primary != primary)
+    {
+        log_warning(stderr, "%s does not match the BWT\n", file_name);
+        return NULL;
+    }
+    if (k && k != header->k)
+    {
+        log_warning(stderr, "%s has a different k-mer length (%u != %u)\n", file_name, header->k, k);
+        return NULL;
+    }
+    k = header->k;
+    return (const uint2*)( buffer + sizeof(KmerLUTHeader) );
+}
+
+// save a k-mer lookup table
+//
+bool save_kmer_lut(
+    const char*     file_name,
+    const uint32    k,
+    const uint32    seq_length,
+    const uint32    primary,
+    const uint2*    ranges)
+{
+    FILE* file = fopen( file_name, "wb" );
+    if (file == NULL)
+    {
+        log_error(stderr, "unable to open %s\n", file_name);
+        return false;
+    }
+
+    KmerLUTHeader header;
+    header.k          = k;
+    header.seq_length = seq_length;
+    header.primary    = primary;
+    header.reserved   = 0u;
+
+    const uint64 n_entries = fm_index_kmer_lut<uint32>::entries( k );
+
+    const bool ok =
+        fwrite( &header, sizeof(KmerLUTHeader), 1u, file ) == 1u &&
+        fwrite( ranges, sizeof(uint2), n_entries, file ) == n_entries;
+
+    fclose( file );
+
+    if (!ok)
+        log_error(stderr, "failed writing %s\n", file_name);
+    return ok;
+}
+
+// a functor building and saving the k-mer lookup tables of an index, given its typed view
+//
+struct KmerLUTBuilder
+{
+    KmerLUTBuilder(const FMIndexDataCore& data, const uint32 k, const char* output_prefix) :
+        m_data( data ), m_k( k ), m_output_prefix( output_prefix ), m_ok( false ) {}
+
+    template <typename view_type>
+    void operator() (const view_type& view)
+    {
+        nvbio::vector<host_tag,uint2> ranges( fm_index_kmer_lut<uint32>::entries( m_k ) );
+
+        const std::string kmer_string  = std::string( m_output_prefix ) + ".kmer";
+        const std::string rkmer_string = std::string( m_output_prefix ) + ".rkmer";
+
+        log_info(stderr, "building k-mer table... started\n");
+        build_kmer_lut( view.partial_index(), m_k, raw_pointer( ranges ) );
+        log_info(stderr, "building k-mer table... done\n");
+
+        if (save_kmer_lut( kmer_string.c_str(), m_k, m_data.length(), m_data.primary(), raw_pointer( ranges ) ) == false)
+            return;
+
+        log_info(stderr, "building reverse k-mer table... started\n");
+        build_kmer_lut( view.rpartial_index(), m_k, raw_pointer( ranges ) );
+        log_info(stderr, "building reverse k-mer table... done\n");
+
+        m_ok = save_kmer_lut( rkmer_string.c_str(), m_k, m_data.length(), m_data.rprimary(), raw_pointer( ranges ) );
+    }
+
+    const FMIndexDataCore&  m_data;
+    const uint32            m_k;
+    const char*             m_output_prefix;
+    bool                    m_ok;
+};
+
 ///@} // FMIndexIODetails
 
 } // anonymous namespace
@@ -330,18 +499,61 @@ FMIndexData::FMIndexData()
 {
 }
 
+// copy constructor
+//
+FMIndexDataHost::FMIndexDataHost(const FMIndexDataHost& other)
+{
+    this->operator=( other );
+}
+
+// assignment operator
+//
+FMIndexDataHost& FMIndexDataHost::operator= (const FMIndexDataHost& other)
+{
+    // copy the core, including the pointers to the memory-mapped k-mer lookup tables
+    this->FMIndexDataCore::operator=( other );
+
+    m_bwt_occ_vec  = other.m_bwt_occ_vec;
+    m_rbwt_occ_vec = other.m_rbwt_occ_vec;
+    m_ssa_vec      = other.m_ssa_vec;
+    m_rssa_vec     = other.m_rssa_vec;
+
+    for (uint32 i = 0; i < 256; ++i)
+        m_count_table_vec[i] = other.m_count_table_vec[i];
+    for (uint32 i = 0; i < 5; ++i)
+        m_L2_vec[i] = other.m_L2_vec[i];
+
+    // rebind the pointers to the local storage
+    m_count_table = &m_count_table_vec[0];
+    m_L2          = &m_L2_vec[0];
+    m_bwt_occ     = other.m_bwt_occ  ? raw_pointer( m_bwt_occ_vec )  : NULL;
+    m_rbwt_occ    = other.m_rbwt_occ ? raw_pointer( m_rbwt_occ_vec ) : NULL;
+    m_ssa.m_ssa   = other.m_ssa.m_ssa  ? raw_pointer( m_ssa_vec )  : NULL;
+    m_rssa.m_ssa  = other.m_rssa.m_ssa ? raw_pointer( m_rssa_vec ) : NULL;
+    return *this;
+}
+
 int FMIndexDataHost::load(
-    const char* genome_prefix,
-    const uint32 flags)
+    const char*         genome_prefix,
+    const uint32        flags,
+    const uint32        occ_intv,
+    const NUMAPlacement numa)
 {
     log_visible(stderr, "FMIndexData: loading... started\n");
     log_visible(stderr, "  genome : %s\n", genome_prefix);
 
+    if (is_supported_occ_intv( occ_intv ) == false)
+    {
+        log_error(stderr, "unsupported occurrence table interval %u\n", occ_intv);
+        return 0;
+    }
+
     // initialize the core
     this->FMIndexDataCore::operator=( FMIndexDataCore() );
 
     // bind pointers to static vectors
     m_flags       = flags;
+    m_occ_intv    = occ_intv;
     m_count_table = &m_count_table_vec[0];
     m_L2          = &m_L2_vec[0];
 
@@ -386,6 +598,7 @@ int FMIndexDataHost::load(
                 seq_words,
                 bwt_vec,
                 allocator,
+                occ_intv,
                 m_bwt_occ_words,
                 m_L2 );
         }
@@ -420,6 +633,7 @@ int FMIndexDataHost::load(
                 seq_words,
                 rbwt_vec,
                 allocator,
+                occ_intv,
                 m_bwt_occ_words,
                 m_L2 );
         }
@@ -435,6 +649,9 @@ int FMIndexDataHost::load(
     // read ssa
     if (flags & SA)
     {
+        // the SA interval is taken from the header of the first SSA file
+        uint32 sa_intv = 0u;
+
         if (flags & FORWARD)
         {
             VectorAllocator allocator( m_ssa_vec );
@@ -443,7 +660,7 @@ int FMIndexDataHost::load(
                 allocator,
                 seq_length,
                 m_primary,
-                SA_INT );
+                sa_intv );
         }
         // read rssa
         if (flags & REVERSE)
@@ -454,16 +671,45 @@ int FMIndexDataHost::load(
                 allocator,
                 seq_length,
                 m_rprimary,
-                SA_INT );
+                sa_intv );
         }
 
-        // record the number of SA words
-        m_sa_words = (seq_length + SA_INT) / SA_INT;
+        // record the SA interval and the number of SA words
+        m_sa_intv  = sa_intv ? sa_intv : SA_INT;
+        m_sa_words = (seq_length + m_sa_intv) / m_sa_intv;
+    }
+
+    // map the k-mer lookup tables
+    if (flags & KMER_LUT)
+    {
+        const std::string kmer_string  = std::string( genome_prefix ) + ".kmer";
+        const std::string rkmer_string = std::string( genome_prefix ) + ".rkmer";
+
+        uint32 k = 0u;
+        if (flags & FORWARD)
+            m_kmer_lut = map_kmer_lut( kmer_string.c_str(), m_kmer_file, seq_length, m_primary, k );
+        if (flags & REVERSE)
+            m_rkmer_lut = map_kmer_lut( rkmer_string.c_str(), m_rkmer_file, seq_length, m_rprimary, k );
+
+        m_kmer_k = k;
     }
 
     // generate the count table
     gen_bwt_count_table( m_count_table );
 
+    // place the tables on the NUMA nodes
+    if (numa.policy == NUMA_INTERLEAVE || numa.policy == NUMA_BIND)
+    {
+        const bool placed =
+            numa_place( raw_pointer( m_bwt_occ_vec ),  m_bwt_occ_vec.size()  * sizeof(uint32), numa ) &&
+            numa_place( raw_pointer( m_rbwt_occ_vec ), m_rbwt_occ_vec.size() * sizeof(uint32), numa ) &&
+            numa_place( raw_pointer( m_ssa_vec ),      m_ssa_vec.size()      * sizeof(uint32), numa ) &&
+            numa_place( raw_pointer( m_rssa_vec ),     m_rssa_vec.size()     * sizeof(uint32), numa );
+
+        if (placed == false)
+            log_warning(stderr, "  unable to apply NUMA policy \"%s\"\n", numa_policy_string( numa.policy ));
+    }
+
     const uint32 has_fw     = (m_flags & FORWARD) ? 1u : 0;
     const uint32 has_rev    = (m_flags & REVERSE) ? 1u : 0;
     const uint32 has_sa     = (m_flags & SA)      ? 1u : 0;
@@ -472,17 +718,29 @@ int FMIndexDataHost::load(
                  (has_fw + has_rev) * sizeof(uint32)*m_bwt_occ_words +
         has_sa * (has_fw + has_rev) * sizeof(uint32)*m_sa_words;
 
+    log_visible(stderr, "  occ intv : %u\n", m_occ_intv);
+    log_visible(stderr, "  sa intv  : %u\n", m_sa_intv);
+    if (m_kmer_k)
+        log_visible(stderr, "  k-mer lut: %u (mapped)\n", m_kmer_k);
     log_visible(stderr, "  memory   : %.1f MB\n", float(memory_footprint)/float(1024*1024));
+    if (numa.policy != NUMA_DEFAULT)
+        log_visible(stderr, "  numa     : %s (%u nodes)\n", numa_policy_string( numa.policy ), numa_node_count());
 
     log_visible(stderr, "FMIndexData: loading... done\n");
     return 1;
 }
 
-int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_name)
+int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_name, const uint32 occ_intv)
 {
     log_visible(stderr, "FMIndexData: loading... started\n");
     log_visible(stderr, "  genome : %s\n", genome_prefix);
 
+    if (is_supported_occ_intv( occ_intv ) == false)
+    {
+        log_error(stderr, "unsupported occurrence table interval %u\n", occ_intv);
+        return 0;
+    }
+
     std::string bwt_string    = std::string( genome_prefix ) + ".bwt";
     std::string rbwt_string   = std::string( genome_prefix ) + ".rbwt";
     std::string sa_string     = std::string( genome_prefix ) + ".sa";
@@ -506,7 +764,8 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
     m_count_table = &m_count_table_vec[0];
     m_L2          = &m_L2_vec[0];
 
-    m_flags = FORWARD | REVERSE | SA;
+    m_flags    = FORWARD | REVERSE | SA;
+    m_occ_intv = occ_intv;
 
     try
     {
@@ -540,6 +799,7 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
                     seq_words,
                     bwt_vec,
                     allocator,
+                    occ_intv,
                     m_bwt_occ_words,
                     m_L2 );
             }
@@ -573,6 +833,7 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
                     seq_words,
                     rbwt_vec,
                     allocator,
+                    occ_intv,
                     m_bwt_occ_words,
                     m_L2 );
             }
@@ -582,6 +843,9 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
         log_visible(stderr, "   primary : %u\n", uint32(m_primary));
         log_visible(stderr, "  rprimary : %u\n", uint32(m_rprimary));
 
+        // the SA interval is taken from the header of the first SSA file
+        uint32 sa_intv = 0u;
+
         // read ssa
         {
             MMapAllocator allocator( saName.c_str(), m_sa_file );
@@ -590,7 +854,7 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
                 allocator,
                 seq_length,
                 m_primary,
-                SA_INT );
+                sa_intv );
         }
         // read rssa
         {
@@ -600,14 +864,15 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
                 allocator,
                 seq_length,
                 m_rprimary,
-                SA_INT );
+                sa_intv );
         }
 
         // record the sequence length
         m_seq_length = seq_length;
 
-        // record the number of SA words
-        m_sa_words = has_ssa() ? (seq_length + SA_INT) / SA_INT : 0u;
+        // record the SA interval and the number of SA words
+        m_sa_intv  = sa_intv ? sa_intv : SA_INT;
+        m_sa_words = has_ssa() ? (seq_length + m_sa_intv) / m_sa_intv : 0u;
 
         // generate the count table
         gen_bwt_count_table( m_count_table );
@@ -620,6 +885,8 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
                      (has_fw + has_rev) * sizeof(uint32)*m_bwt_occ_words +
             has_sa * (has_fw + has_rev) * sizeof(uint32)*m_sa_words;
 
+        log_visible(stderr, "  occ intv : %u\n", m_occ_intv);
+        log_visible(stderr, "  sa intv  : %u\n", m_sa_intv);
         log_visible(stderr, "  memory   : %.1f MB\n", float(memory_footprint)/float(1024*1024));
 
         m_info.sequence_length = m_seq_length;
@@ -627,6 +894,8 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
         m_info.sa_words        = m_sa_words;
         m_info.primary         = m_primary;
         m_info.rprimary        = m_rprimary;
+        m_info.occ_intv        = m_occ_intv;
+        m_info.sa_intv         = m_sa_intv;
         for (uint32 i = 0; i < 5; ++i)
             m_info.L2[i]  = m_L2[i];
 
@@ -697,6 +966,8 @@ int FMIndexDataMMAP::load(
         m_bwt_occ_words = info->bwt_occ_words;
         m_primary       = info->primary;
         m_rprimary      = info->rprimary;
+        m_occ_intv      = info->occ_intv;
+        m_sa_intv       = info->sa_intv;
         for (uint32 i = 0; i < 5; ++i)
             m_L2[i] = info->L2[i];
 
@@ -721,6 +992,31 @@ int FMIndexDataMMAP::load(
     return 1;
 }
 
+bool save_kmer_luts(
+    const FMIndexDataCore&          driver_data,
+    const uint32                    k,
+    const char*                     output_prefix)
+{
+    if (k == 0u || k > fm_index_kmer_lut<uint32>::MAX_K)
+    {
+        log_error(stderr, "unsupported k-mer length %u\n", k);
+        return false;
+    }
+    if ((driver_data.flags() & (FMIndexDataCore::FORWARD | FMIndexDataCore::REVERSE)) != (FMIndexDataCore::FORWARD | FMIndexDataCore::REVERSE))
+    {
+        log_error(stderr, "building k-mer tables requires both the forward and reverse BWT\n");
+        return false;
+    }
+
+    KmerLUTBuilder builder( driver_data, k, output_prefix );
+    if (dispatch_fmindex( driver_data, builder ) == false)
+    {
+        log_error(stderr, "unsupported index intervals\n");
+        return false;
+    }
+    return builder.m_ok;
+}
+
 void init_ssa(
     const FMIndexData&              driver_data,
     FMIndexData::ssa_storage_type&  ssa,
@@ -748,6 +1044,12 @@ FMIndexDataDevice::FMIndexDataDevice(const FMIndexData& host_data, const uint32
     m_sa_words      = host_data.m_sa_words;
     m_primary       = host_data.m_primary;
     m_rprimary      = host_data.m_rprimary;
+    m_occ_intv      = host_data.m_occ_intv;
+    m_sa_intv       = host_data.m_sa_intv;
+
+    // the device index views are only instantiated for the default intervals
+    if (has_default_intervals() == false)
+        throw nvbio::runtime_error("FMIndexDataDevice: unsupported index intervals (occ: %u, sa: %u)", m_occ_intv, m_sa_intv);
 
     m_L2_vec.resize( 5 );
     m_L2 = raw_pointer( m_L2_vec );
@@ -0,0 +1,59 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+namespace nvbio {
+namespace io {
+
+namespace detail {
+
+// select the FMIndexDataView matching the SSA interval of an index, given its occurrence interval
+//
+template <uint32 OCC_INT, typename Functor>
+bool dispatch_fmindex_sa(const FMIndexDataCore& data, Functor& functor)
+{
+    switch (data.sa_intv())
+    {
+    case 16u: functor( FMIndexDataView<OCC_INT,16u>( data ) ); return true;
+    case 32u: functor( FMIndexDataView<OCC_INT,32u>( data ) ); return true;
+    case 64u: functor( FMIndexDataView<OCC_INT,64u>( data ) ); return true;
+    }
+    return false;
+}
+
+} // namespace detail
+
+// select the FMIndexDataView matching the occurrence table and SSA intervals an index
+// has been loaded with, and pass it to a functor
+//
+template <typename Functor>
+bool dispatch_fmindex(const FMIndexDataCore& data, Functor& functor)
+{
+    switch (data.occ_intv())
+    {
+    case  32u: return detail::dispatch_fmindex_sa< 32u>( data, functor );
+    case  64u: return detail::dispatch_fmindex_sa< 64u>( data, functor );
+    case 128u: return detail::dispatch_fmindex_sa<128u>( data, functor );
+    case 256u: return detail::dispatch_fmindex_sa<256u>( data, functor );
+    }
+    return false;
+}
+
+} // namespace io
+} // namespace nvbio
@@ -62,6 +62,12 @@ void BamOutput::process(struct GPUOutputBatch& gpu_batch,
     readback(cpu_output, gpu_batch, mate, score);
 }
 
+void BamOutput::process(struct CPUOutputBatch& host_batch)
+{
+    // take the host-side results for later processing
+    take(cpu_output, host_batch);
+}
+
 uint32 BamOutput::generate_cigar(struct BAM_alignment& alnh,
                                  struct BAM_alignment_data_block& alnd,
                                  const AlignmentData& alignment)
@@ -545,6 +551,9 @@ void BamOutput::output_alignment(DataBuffer& out, BAM_alignment& alnh, BAM_align
 
 void BamOutput::end_batch(void)
 {
+    // expand the results of the unique reads to their duplicates
+    fan_out(cpu_output);
+
     for(uint32 c = 0; c < cpu_output.count; c++)
     {
         // wrap the alignment into AlignmentData structures for both mates
@@ -79,8 +79,17 @@ void DebugOutput::process(struct GPUOutputBatch& gpu_batch,
     readback(cpu_batch, gpu_batch, mate, score);
 }
 
+void DebugOutput::process(struct CPUOutputBatch& host_batch)
+{
+    // take the host-side results for later processing
+    take(cpu_batch, host_batch);
+}
+
 void DebugOutput::end_batch(void)
 {
+    // expand the results of the unique reads to their duplicates
+    fan_out(cpu_batch);
+
     for(uint32 c = 0; c < cpu_batch.count; c++)
     {
         AlignmentData mate_1;
@@ -0,0 +1,490 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvbio/io/output/output_dedup.h>
+#include <nvbio/io/sequence/sequence_access.h>
+#include <nvbio/basic/vector.h>
+
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+namespace nvbio {
+namespace io {
+
+namespace {
+
+typedef SequenceDataAccess<DNA_N,ConstSequenceDataView>     read_access_type;
+typedef SequenceDataEdit<DNA_N,SequenceDataView>            read_edit_type;
+
+// the flag marking the reads whose results come from the cross-batch cache
+const uint32 CACHED = 0x80000000u;
+
+// mix a value into a 64-bit hash
+//
+inline uint64 hash_mix(uint64 h, const uint64 v)
+{
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+// finalize a 64-bit hash
+//
+inline uint64 hash_finalize(uint64 h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// order (key, read) pairs by key first, and read id second
+//
+struct key_less
+{
+    bool operator() (const std::pair<uint64,uint32>& a, const std::pair<uint64,uint32>& b) const
+    {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    }
+};
+
+} // anonymous namespace
+
+// constructor
+//
+DuplicateReadCache::DuplicateReadCache(const uint32 cache_size, const bool use_qualities) :
+    n_reads( 0u ),
+    n_batch_hits( 0u ),
+    n_cache_hits( 0u ),
+    m_cache_size( cache_size ),
+    m_use_qualities( use_qualities ),
+    m_reads( NULL )
+{}
+
+// compute the key of a read of the current batch
+//
+uint64 DuplicateReadCache::key(const uint32 read_id) const
+{
+    const read_access_type reads( *m_reads );
+    const uint2 range = reads.get_range( read_id );
+
+    const read_access_type::sequence_stream_type stream = reads.sequence_stream();
+    const char*                                  qual   = reads.qual_stream();
+
+    uint64 h = range.y - range.x;
+
+    // pack 16 symbols at a time
+    uint64 word = 0;
+    for (uint32 i = range.x; i < range.y; ++i)
+    {
+        word = (word << 4) | stream[i];
+        if (((i - range.x) & 15u) == 15u)
+        {
+            h    = hash_mix( h, word );
+            word = 0;
+        }
+    }
+    h = hash_mix( h, word );
+
+    if (m_use_qualities && m_reads->has_qualities())
+    {
+        for (uint32 i = range.x; i < range.y; ++i)
+            h = hash_mix( h, uint8( qual[i] ) );
+    }
+    return hash_finalize( h );
+}
+
+// check whether two reads of the current batch are identical
+//
+bool DuplicateReadCache::equal(const uint32 read_id1, const uint32 read_id2) const
+{
+    const read_access_type reads( *m_reads );
+    const uint2 range1 = reads.get_range( read_id1 );
+    const uint2 range2 = reads.get_range( read_id2 );
+
+    const uint32 len = range1.y - range1.x;
+    if (range2.y - range2.x != len)
+        return false;
+
+    const read_access_type::sequence_stream_type stream = reads.sequence_stream();
+    for (uint32 i = 0; i < len; ++i)
+    {
+        if (stream[ range1.x + i ] != stream[ range2.x + i ])
+            return false;
+    }
+
+    if (m_use_qualities && m_reads->has_qualities())
+        return memcmp( reads.qual_stream() + range1.x, reads.qual_stream() + range2.x, len ) == 0;
+
+    return true;
+}
+
+// check whether a read of the current batch is identical to a cached one
+//
+bool DuplicateReadCache::equal(const uint32 read_id, const Entry& entry) const
+{
+    const read_access_type reads( *m_reads );
+    const uint2 range = reads.get_range( read_id );
+
+    const uint32 len = range.y - range.x;
+    if (entry.sequence.size() != len)
+        return false;
+
+    const read_access_type::sequence_stream_type stream = reads.sequence_stream();
+    for (uint32 i = 0; i < len; ++i)
+    {
+        if (stream[ range.x + i ] != entry.sequence[i])
+            return false;
+    }
+
+    if (m_use_qualities && m_reads->has_qualities())
+        return entry.qual.size() == len && memcmp( reads.qual_stream() + range.x, &entry.qual[0], len ) == 0;
+
+    return true;
+}
+
+// collapse a batch of reads to its unique representatives
+//
+const SequenceDataHost& DuplicateReadCache::dedup(const SequenceDataHost& reads)
+{
+    m_reads = &reads;
+
+    const uint32 n = reads.size();
+
+    m_keys.resize( n );
+    m_map.resize( n );
+    m_unique_ids.clear();
+    m_hits.clear();
+
+    // compute the read keys
+    for (uint32 i = 0; i < n; ++i)
+        m_keys[i] = key(i);
+
+    // sort the reads by key, so that duplicates end up in contiguous runs, led by their first occurrence
+    std::vector< std::pair<uint64,uint32> > sorted( n );
+    for (uint32 i = 0; i < n; ++i)
+        sorted[i] = std::make_pair( m_keys[i], i );
+
+    std::sort( sorted.begin(), sorted.end(), key_less() );
+
+    // assign each read to a representative, looking it up in the cache first
+    const uint32 UNASSIGNED = uint32(-1);
+    std::fill( m_map.begin(), m_map.end(), UNASSIGNED );
+
+    std::vector<uint32> leaders;    // the leading reads of the current run (more than one in case of hash collisions)
+    std::vector<uint32> sources;    // the corresponding sources
+
+    for (uint32 run_begin = 0; run_begin < n;)
+    {
+        uint32 run_end = run_begin + 1;
+        while (run_end < n && sorted[run_end].first == sorted[run_begin].first)
+            ++run_end;
+
+        leaders.clear();
+        sources.clear();
+
+        for (uint32 r = run_begin; r < run_end; ++r)
+        {
+            const uint32 read_id = sorted[r].second;
+
+            // look for an identical leader
+            uint32 l = 0;
+            while (l < leaders.size() && equal( leaders[l], read_id ) == false)
+                ++l;
+
+            if (l < leaders.size())
+            {
+                m_map[ read_id ] = sources[l];
+                ++n_batch_hits;
+                continue;
+            }
+
+            // this is a new sequence: look it up in the cache
+            uint32 source = UNASSIGNED;
+            if (m_cache_size)
+            {
+                const entry_map::iterator it = m_index.find( sorted[r].first );
+                if (it != m_index.end() && equal( read_id, *it->second ))
+                {
+                    // move the entry to the front of the LRU list
+                    m_entries.splice( m_entries.begin(), m_entries, it->second );
+
+                    source = CACHED | uint32( m_hits.size() );
+                    m_hits.push_back( it->second );
+                    ++n_cache_hits;
+                }
+            }
+            if (source == UNASSIGNED)
+            {
+                source = uint32( m_unique_ids.size() );
+                m_unique_ids.push_back( read_id );
+            }
+
+            m_map[ read_id ] = source;
+
+            leaders.push_back( read_id );
+            sources.push_back( source );
+        }
+        run_begin = run_end;
+    }
+    n_reads += n;
+
+    // keep the unique reads in input order
+    std::vector<uint32> order( m_unique_ids.size() );
+    {
+        std::vector< std::pair<uint32,uint32> > by_id( m_unique_ids.size() );
+        for (uint32 u = 0; u < m_unique_ids.size(); ++u)
+            by_id[u] = std::make_pair( m_unique_ids[u], u );
+
+        std::sort( by_id.begin(), by_id.end() );
+        for (uint32 u = 0; u < by_id.size(); ++u)
+        {
+            m_unique_ids[u]         = by_id[u].first;
+            order[ by_id[u].second ] = u;
+        }
+    }
+    for (uint32 i = 0; i < n; ++i)
+    {
+        if ((m_map[i] & CACHED) == 0)
+            m_map[i] = order[ m_map[i] ];
+    }
+
+    //
+    // build the batch of unique reads
+    //
+    const read_access_type in( reads );
+
+    const uint32 n_unique = uint32( m_unique_ids.size() );
+
+    uint32 n_bps       = 0;
+    uint32 n_name_len  = 0;
+    for (uint32 u = 0; u < n_unique; ++u)
+    {
+        const uint32 i = m_unique_ids[u];
+        n_bps      += in.sequence_index()[i+1] - in.sequence_index()[i];
+        n_name_len += in.name_index()[i+1]     - in.name_index()[i];
+    }
+
+    m_unique.SequenceDataInfo::operator=( SequenceDataInfo() );
+    m_unique.m_alphabet              = reads.m_alphabet;
+    m_unique.m_has_qualities         = reads.m_has_qualities;
+    m_unique.m_n_seqs                = n_unique;
+    m_unique.m_sequence_stream_len   = n_bps;
+    m_unique.m_sequence_stream_words = util::divide_ri( n_bps, read_edit_type::SEQUENCE_SYMBOLS_PER_WORD );
+    m_unique.m_name_stream_len       = n_name_len;
+
+    m_unique.m_sequence_vec.resize( nvbio::max( m_unique.m_sequence_stream_words, 1u ) );
+    m_unique.m_qual_vec.resize( nvbio::max( n_bps, 1u ) );
+    m_unique.m_name_vec.resize( nvbio::max( n_name_len, 1u ) );
+    m_unique.m_sequence_index_vec.resize( n_unique + 1u );
+    m_unique.m_name_index_vec.resize( n_unique + 1u );
+
+    // clear the last word, as symbols are or'ed in
+    m_unique.m_sequence_vec[ m_unique.m_sequence_vec.size()-1 ] = 0u;
+
+    const read_access_type::sequence_stream_type in_stream( in.sequence_stream() );
+    read_edit_type::sequence_stream_type out_stream( nvbio::raw_pointer( m_unique.m_sequence_vec ) );
+
+    m_unique.m_sequence_index_vec[0] = 0u;
+    m_unique.m_name_index_vec[0]     = 0u;
+
+    uint32 bp_offset   = 0;
+    uint32 name_offset = 0;
+    for (uint32 u = 0; u < n_unique; ++u)
+    {
+        const uint32 i     = m_unique_ids[u];
+        const uint2  range = in.get_range(i);
+        const uint32 len   = range.y - range.x;
+
+        for (uint32 j = 0; j < len; ++j)
+            out_stream[ bp_offset + j ] = in_stream[ range.x + j ];
+
+        if (reads.has_qualities())
+            memcpy( nvbio::raw_pointer( m_unique.m_qual_vec ) + bp_offset, in.qual_stream() + range.x, len );
+
+        const uint32 name_len = in.name_index()[i+1] - in.name_index()[i];
+        memcpy( nvbio::raw_pointer( m_unique.m_name_vec ) + name_offset, in.name_stream() + in.name_index()[i], name_len );
+
+        bp_offset   += len;
+        name_offset += name_len;
+
+        m_unique.m_sequence_index_vec[u+1] = bp_offset;
+        m_unique.m_name_index_vec[u+1]     = name_offset;
+
+        m_unique.m_min_sequence_len = nvbio::min( m_unique.m_min_sequence_len, len );
+        m_unique.m_max_sequence_len = nvbio::max( m_unique.m_max_sequence_len, len );
+    }
+    m_unique.m_avg_sequence_len = n_unique ? (uint32) ceilf( float(n_bps) / float(n_unique) ) : 0u;
+
+    return m_unique;
+}
+
+// insert the results of a unique read in the cross-batch cache
+//
+void DuplicateReadCache::insert(const uint32 unique_id, const CPUOutputBatch& batch)
+{
+    const uint32 read_id = m_unique_ids[ unique_id ];
+
+    const read_access_type reads( *m_reads );
+    const uint2  range = reads.get_range( read_id );
+    const uint32 len   = range.y - range.x;
+
+    // replace any colliding entry
+    const uint64 k = m_keys[ read_id ];
+    const entry_map::iterator it = m_index.find( k );
+    if (it != m_index.end())
+    {
+        m_entries.erase( it->second );
+        m_index.erase( it );
+    }
+
+    m_entries.push_front( Entry() );
+    Entry& entry = m_entries.front();
+
+    entry.key = k;
+
+    const read_access_type::sequence_stream_type stream = reads.sequence_stream();
+    entry.sequence.resize( len );
+    for (uint32 i = 0; i < len; ++i)
+        entry.sequence[i] = stream[ range.x + i ];
+
+    if (m_use_qualities && m_reads->has_qualities())
+        entry.qual.assign( reads.qual_stream() + range.x, reads.qual_stream() + range.y );
+
+    entry.result       = batch.best_alignments[ unique_id ];
+    entry.cigar_coords = batch.cigar[ MATE_1 ].coords[ unique_id ];
+
+    const Cigar* cigar = batch.cigar[ MATE_1 ].array[ unique_id ];
+    if (cigar)
+        entry.cigar.assign( cigar, cigar + batch.cigar[ MATE_1 ].array.size( unique_id ) );
+
+    const uint8* mds = batch.mds[ MATE_1 ][ unique_id ];
+    if (mds)
+        entry.mds.assign( mds, mds + batch.mds[ MATE_1 ].size( unique_id ) );
+
+    m_index[k] = m_entries.begin();
+
+    // evict the least recently used entries
+    while (m_entries.size() > m_cache_size)
+    {
+        m_index.erase( m_entries.back().key );
+        m_entries.pop_back();
+    }
+}
+
+// expand the alignment results of the unique representatives to all reads of the batch
+//
+void DuplicateReadCache::fan_out(CPUOutputBatch& batch)
+{
+    const uint32 n        = uint32( m_map.size() );
+    const uint32 n_unique = unique_reads();
+    const uint32 n_hits   = uint32( m_hits.size() );
+
+    // if no read had to be aligned, the batch holds no valid results
+    const bool has_results = n_unique > 0;
+
+    HostCigarArray cigars;
+    HostMdsArray   mds;
+    thrust::host_vector<AlignmentResult> results( n );
+
+    // compute the slots of all unique and cached vectors in the new arenas
+    std::vector<uint2> cigar_slots( n_unique + n_hits );
+    std::vector<uint2> mds_slots( n_unique + n_hits );
+    uint32 cigar_arena = 0;
+    uint32 mds_arena   = 0;
+    for (uint32 u = 0; u < n_unique; ++u)
+    {
+        const uint32 cigar_len = batch.cigar[ MATE_1 ].array[u] ? batch.cigar[ MATE_1 ].array.size(u) : 0u;
+        const uint32 mds_len   = batch.mds[ MATE_1 ][u]         ? batch.mds[ MATE_1 ].size(u)         : 0u;
+        cigar_slots[u] = make_uint2( cigar_arena, cigar_len ); cigar_arena += cigar_len;
+        mds_slots[u]   = make_uint2( mds_arena,   mds_len );   mds_arena   += mds_len;
+    }
+    for (uint32 h = 0; h < n_hits; ++h)
+    {
+        const Entry& entry = *m_hits[h];
+        cigar_slots[ n_unique + h ] = make_uint2( cigar_arena, uint32( entry.cigar.size() ) ); cigar_arena += uint32( entry.cigar.size() );
+        mds_slots[ n_unique + h ]   = make_uint2( mds_arena,   uint32( entry.mds.size() ) );   mds_arena   += uint32( entry.mds.size() );
+    }
+
+    cigars.array.resize( n, nvbio::max( cigar_arena, 1u ) );
+    cigars.coords.resize( n );
+    mds.resize( n, nvbio::max( mds_arena, 1u ) );
+
+    // copy the vectors, binding them to their first read
+    std::vector<bool> copied( n_unique + n_hits, false );
+    for (uint32 i = 0; i < n; ++i)
+    {
+        const uint32 src    = m_map[i];
+        const bool   cached = (src & CACHED) != 0;
+        const uint32 slot   = cached ? n_unique + (src & ~CACHED) : src;
+
+        const uint2 cigar_slot = cigar_slots[ slot ];
+        const uint2 mds_slot   = mds_slots[ slot ];
+
+        Cigar* cigar_vec = cigar_slot.y ? cigars.array.bind( i, cigar_slot.x, cigar_slot.y ) : NULL;
+        uint8* mds_vec   = mds_slot.y   ? mds.bind( i, mds_slot.x, mds_slot.y )             : NULL;
+
+        if (cached)
+        {
+            const Entry& entry = *m_hits[ src & ~CACHED ];
+
+            results[i]       = entry.result;
+            cigars.coords[i] = entry.cigar_coords;
+
+            if (copied[ slot ] == false)
+            {
+                if (cigar_vec) memcpy( cigar_vec, &entry.cigar[0], sizeof(Cigar) * cigar_slot.y );
+                if (mds_vec)   memcpy( mds_vec,   &entry.mds[0],   mds_slot.y );
+                copied[ slot ] = true;
+            }
+        }
+        else if (has_results)
+        {
+            results[i]       = batch.best_alignments[ src ];
+            cigars.coords[i] = batch.cigar[ MATE_1 ].coords[ src ];
+
+            if (copied[ slot ] == false)
+            {
+                if (cigar_vec) memcpy( cigar_vec, batch.cigar[ MATE_1 ].array[ src ], sizeof(Cigar) * cigar_slot.y );
+                if (mds_vec)   memcpy( mds_vec,   batch.mds[ MATE_1 ][ src ],         mds_slot.y );
+                copied[ slot ] = true;
+            }
+        }
+    }
+
+    // add the newly aligned reads to the cache; as this may evict some of the entries
+    // hit by this batch, their references are dropped
+    m_hits.clear();
+    if (m_cache_size)
+    {
+        for (uint32 u = 0; u < n_unique; ++u)
+            insert( u, batch );
+    }
+
+    // swap the expanded results in
+    batch.best_alignments.swap( results );
+    batch.cigar[ MATE_1 ].array.swap( cigars.array );
+    batch.cigar[ MATE_1 ].coords.swap( cigars.coords );
+    batch.mds[ MATE_1 ].swap( mds );
+    batch.count = n;
+}
+
+} // namespace io
+} // namespace nvbio
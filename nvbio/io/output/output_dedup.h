@@ -0,0 +1,132 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/io/output/output_batch.h>
+#include <nvbio/io/sequence/sequence.h>
+
+#include <vector>
+#include <list>
+#include <map>
+
+namespace nvbio {
+namespace io {
+
+/**
+   @addtogroup IO
+   @{
+   @addtogroup Output
+   @{
+*/
+
+/**
+   A cache of alignment results for exact-duplicate single-end reads.
+
+   Before alignment, DuplicateReadCache::dedup scans a batch of reads and collapses all exact
+   duplicates to a batch of unique representatives, which is the only one that needs to be aligned.
+   Reads whose sequence has been aligned in a recent batch are looked up in a bounded LRU cache,
+   and don't need to be aligned at all.
+   Once the results of the unique reads have been gathered by the OutputFile, DuplicateReadCache::fan_out
+   copies them back to all duplicates, so that the output is the same as if all reads had been aligned.
+
+   Reads are keyed by their stored sequence, i.e. after any strand conversion performed by the loader,
+   so that a read and its reverse-complement are never merged. As qualities affect the final
+   Smith-Waterman scores, and hence the mapping qualities, they are part of the key unless
+   explicitly disabled.
+
+   Usage:
+   \code
+   io::DuplicateReadCache dedup( 256*1024 );
+   output_file->configure_dedup( &dedup );
+
+   const io::SequenceDataHost& unique_reads = dedup.dedup( *read_data );
+
+   output_file->start_batch( read_data );
+   // align unique_reads and pass the results to output_file->process()
+   output_file->end_batch(); // fans out the results to all duplicates
+   \endcode
+*/
+struct DuplicateReadCache
+{
+    /// constructor
+    /// \param cache_size       the maximum number of sequences kept across batches (0 disables the cross-batch cache)
+    /// \param use_qualities    whether qualities are part of the read keys
+    DuplicateReadCache(const uint32 cache_size, const bool use_qualities = true);
+
+    /// collapse a batch of reads to its unique representatives
+    /// \param reads            the input batch
+    /// \return                 the batch of reads which need to be aligned, which remains valid until the next call
+    const SequenceDataHost& dedup(const SequenceDataHost& reads);
+
+    /// expand the alignment results of the unique representatives of the last batch to all its reads,
+    /// and insert them in the cross-batch cache
+    /// \param batch            on input, the results of the reads returned by dedup();
+    ///                         on output, the results of the whole batch
+    void fan_out(CPUOutputBatch& batch);
+
+    /// return the number of reads which need to be aligned in the last batch
+    uint32 unique_reads() const { return uint32( m_unique_ids.size() ); }
+
+    /// return the fraction of reads whose alignment has been skipped so far
+    float hit_rate() const { return n_reads ? float(n_batch_hits + n_cache_hits) / float(n_reads) : 0.0f; }
+
+    uint64 n_reads;         ///< total number of reads processed
+    uint64 n_batch_hits;    ///< number of reads found duplicated within their batch
+    uint64 n_cache_hits;    ///< number of reads found in the cross-batch cache
+
+private:
+    struct Entry
+    {
+        uint64              key;
+        std::vector<uint8>  sequence;
+        std::vector<char>   qual;
+        AlignmentResult     result;
+        uint2               cigar_coords;
+        std::vector<Cigar>  cigar;
+        std::vector<uint8>  mds;
+    };
+    typedef std::list<Entry>                        entry_list;
+    typedef std::map<uint64,entry_list::iterator>   entry_map;
+
+    uint64 key(const uint32 read_id) const;
+    bool   equal(const uint32 read_id1, const uint32 read_id2) const;
+    bool   equal(const uint32 read_id, const Entry& entry) const;
+    void   insert(const uint32 unique_id, const CPUOutputBatch& batch);
+
+    uint32                                  m_cache_size;
+    bool                                    m_use_qualities;
+
+    const SequenceDataHost*                 m_reads;        // the current input batch
+    SequenceDataHost                        m_unique;       // the current batch of unique reads
+    std::vector<uint64>                     m_keys;         // the keys of the current batch
+    std::vector<uint32>                     m_map;          // the source of each read's results
+    std::vector<uint32>                     m_unique_ids;   // the input ids of the unique reads
+    std::vector<entry_list::iterator>       m_hits;         // the cache entries hit by the current batch
+
+    entry_list                              m_entries;      // the cache entries, in LRU order
+    entry_map                               m_index;        // the cache index
+};
+
+/**
+   @} // Output
+   @} // IO
+*/
+
+} // namespace io
+} // namespace nvbio
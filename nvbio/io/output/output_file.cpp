@@ -17,6 +17,7 @@
  */
 
 #include <nvbio/io/output/output_batch.h>
+#include <nvbio/io/output/output_dedup.h>
 #include <nvbio/io/output/output_sam.h>
 #include <nvbio/io/output/output_bam.h>
 #include <nvbio/io/output/output_debug.h>
@@ -30,6 +31,7 @@ OutputFile::OutputFile(const char *_file_name, AlignmentType _alignment_type, BN
       bnt(_bnt),
       mapq_evaluator(NULL),
       mapq_filter(-1),
+      dedup(NULL),
       read_data_1(NULL),
       read_data_2(NULL)
 {
@@ -45,6 +47,16 @@ void OutputFile::configure_mapq_evaluator(const io::MapQEvaluator *mapq, int map
     OutputFile::mapq_filter = mapq_filter;
 }
 
+void OutputFile::configure_dedup(DuplicateReadCache *dedup)
+{
+    if (alignment_type != SINGLE_END)
+    {
+        log_warning(stderr, "duplicate-read caching is only supported for single-end alignment, ignoring\n");
+        return;
+    }
+    OutputFile::dedup = dedup;
+}
+
 void OutputFile::start_batch(const io::SequenceDataHost *read_data_1,
                              const io::SequenceDataHost *read_data_2)
 {
@@ -60,6 +72,11 @@ void OutputFile::process(struct GPUOutputBatch& gpu_batch,
     // do nothing
 }
 
+void OutputFile::process(struct CPUOutputBatch& host_batch)
+{
+    // do nothing
+}
+
 void OutputFile::end_batch(void)
 {
     // invalidate the read data pointers
@@ -119,6 +136,48 @@ void OutputFile::readback(struct CPUOutputBatch& cpu_batch,
     iostats.alignments_DtoH_count += gpu_batch.count;
 }
 
+void OutputFile::fan_out(struct CPUOutputBatch& cpu_batch)
+{
+    if (dedup == NULL)
+        return;
+
+    Timer timer;
+    timer.start();
+
+    // if all reads were found in the cache, no results have been processed for this batch:
+    // make sure the read data pointers are up to date in any case
+    cpu_batch.read_data[MATE_1] = read_data_1;
+    cpu_batch.read_data[MATE_2] = read_data_2;
+
+    dedup->fan_out(cpu_batch);
+
+    timer.stop();
+    iostats.output_process_timings.add(cpu_batch.count, timer.seconds());
+}
+
+void OutputFile::take(struct CPUOutputBatch& cpu_batch,
+                      struct CPUOutputBatch& host_batch)
+{
+    Timer timer;
+    timer.start();
+
+    // swap the results in, handing the storage of the previous batch back to the caller
+    cpu_batch.best_alignments.swap( host_batch.best_alignments );
+    for (uint32 mate = 0; mate < 2; ++mate)
+    {
+        cpu_batch.cigar[mate].array.swap( host_batch.cigar[mate].array );
+        cpu_batch.cigar[mate].coords.swap( host_batch.cigar[mate].coords );
+        cpu_batch.mds[mate].swap( host_batch.mds[mate] );
+    }
+    cpu_batch.count = host_batch.count;
+
+    cpu_batch.read_data[MATE_1] = read_data_1;
+    cpu_batch.read_data[MATE_2] = read_data_2;
+
+    timer.stop();
+    iostats.output_process_timings.add(cpu_batch.count, timer.seconds());
+}
+
 OutputFile *OutputFile::open(const char *file_name, AlignmentType aln_type, BNT bnt)
 {
     // parse out file extension; look for .sam, .bam suffixes
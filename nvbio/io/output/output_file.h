@@ -71,6 +71,11 @@ public:
     virtual void configure_mapq_evaluator(const io::MapQEvaluator *mapq,
                                           int mapq_filter);
 
+    /// Configure a duplicate-read cache, whose unique reads are the ones being aligned: at the end of
+    /// each batch, their results are fanned out to all the reads passed to start_batch.
+    /// Only supported for single-end alignment. Must be called prior to any batch processing.
+    virtual void configure_dedup(struct DuplicateReadCache *dedup);
+
     /// Begin a new batch of alignment results
     /// \param read_data_1 The (host-side) read data pointer for the first mate
     /// \param read_data_2 The (host-side) read data pointer for the second mate, if any (can be NULL for single-end alignment)
@@ -85,6 +90,14 @@ public:
                          const AlignmentMate alignment_mate,
                          const AlignmentScore alignment_score);
 
+    /// Process the complete set of alignment results for the current batch, computed on the host.
+    /// This is the counterpart of the GPUOutputBatch variant used by host-side aligners: the batch
+    /// must hold the best and second-best alignments of all reads, along with the CIGARs and MD
+    /// strings of the best ones.
+    /// \param host_batch The host-side alignment results; its contents are swapped into the
+    ///                   output file, leaving host_batch with storage that can be recycled
+    virtual void process(struct CPUOutputBatch& host_batch);
+
     /// Mark a batch of alignment results as complete
     virtual void end_batch(void);
 
@@ -105,6 +118,17 @@ protected:
                   const AlignmentMate alignment_mate,
                   const AlignmentScore alignment_score);
 
+    /// Expand the results gathered for the current batch through the duplicate-read cache, if any;
+    /// this must be called at the beginning of end_batch, before any result is consumed
+    /// \param [in,out] cpu_batch The CPUOutputBatch struct holding the results of the unique reads
+    void fan_out(struct CPUOutputBatch& cpu_batch);
+
+    /// Take ownership of a batch of host-side results
+    /// \param [out] cpu_batch The CPUOutputBatch struct which will receive the data
+    /// \param [in,out] host_batch The host-side results, swapped with the previous contents of cpu_batch
+    void take(struct CPUOutputBatch& cpu_batch,
+              struct CPUOutputBatch& host_batch);
+
     /// Name of the file we're writing
     const char *file_name;
     /// The type of alignment we're running (single or paired-end)
@@ -117,6 +141,9 @@ protected:
     /// The current mapping quality filter: reads with a mapq below this value will be marked as not aligned
     int mapq_filter;
 
+    /// The duplicate-read cache whose unique reads are being aligned, if any
+    struct DuplicateReadCache *dedup;
+
     /// Host-side copies of the read data for the current batch.
     /// These are set by start_batch and invalidated by end_batch.
     const io::SequenceDataHost *read_data_1;
@@ -551,9 +551,18 @@ void SamOutput::process(struct GPUOutputBatch& gpu_batch,
     readback(cpu_batch, gpu_batch, mate, score);
 }
 
+void SamOutput::process(struct CPUOutputBatch& host_batch)
+{
+    // take the host-side results for later processing
+    take(cpu_batch, host_batch);
+}
+
 // called when output data for a given batch has been received, triggers processing of the accumulated data
 void SamOutput::end_batch(void)
 {
+    // expand the results of the unique reads to their duplicates
+    fan_out(cpu_batch);
+
     for(uint32 c = 0; c < cpu_batch.count; c++)
     {
         AlignmentData alignment;
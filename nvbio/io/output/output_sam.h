@@ -85,6 +85,7 @@ public:
     void process(struct GPUOutputBatch& gpu_batch,
                  const AlignmentMate mate,
                  const AlignmentScore score);
+    void process(struct CPUOutputBatch& host_batch);
     void end_batch(void);
 
     void close(void);
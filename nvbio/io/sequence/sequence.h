@@ -23,6 +23,7 @@
 #include <nvbio/basic/packedstream.h>
 #include <nvbio/basic/vector_view.h>
 #include <nvbio/basic/vector.h>
+#include <nvbio/basic/numa.h>
 #include <nvbio/basic/cuda/ldg.h>
 #include <nvbio/strings/string_set.h>
 
@@ -556,7 +557,7 @@ struct SequenceDataStorage : public SequenceData
         m_sequence_index_vec.reserve( n_seqs+1 );
         m_sequence_vec.reserve( n_bps / bps_per_word );
         m_qual_vec.reserve( n_bps );
-        m_name_index_vec.reserve( AVG_NAME_LENGTH * n_seqs );
+        m_name_vec.reserve( AVG_NAME_LENGTH * n_seqs );
         m_name_index_vec.reserve( n_seqs+1 );
     }
 
@@ -638,13 +639,15 @@ SequenceDataStream* open_sequence_file(
 /// \param sequence_file_name   the file to open
 /// \param load_flags           a set of flags indicating what to load
 /// \param qualities            the encoding of the qualities
+/// \param numa                 the NUMA placement of the loaded sequence data
 ///
 bool load_sequence_file(
     const Alphabet              alphabet,
     SequenceDataHost*           sequence_data,
     const char*                 sequence_file_name,
     const SequenceFlags         load_flags  = io::SequenceFlags( io::SEQUENCE_DATA | io::SEQUENCE_QUALS | io::SEQUENCE_NAMES ),
-    const QualityEncoding       qualities   = Phred33);
+    const QualityEncoding       qualities   = Phred33,
+    const NUMAPlacement         numa        = NUMAPlacement());
 
 /// load a sequence file
 ///
@@ -652,12 +655,14 @@ bool load_sequence_file(
 /// \param sequence_file_name   the file to open
 /// \param load_flags           a set of flags indicating what to load
 /// \param qualities            the encoding of the qualities
+/// \param numa                 the NUMA placement of the loaded sequence data
 ///
 SequenceDataHost* load_sequence_file(
     const Alphabet              alphabet,
     const char*                 sequence_file_name,
     const SequenceFlags         load_flags  = io::SequenceFlags( io::SEQUENCE_DATA | io::SEQUENCE_QUALS | io::SEQUENCE_NAMES ),
-    const QualityEncoding       qualities   = Phred33);
+    const QualityEncoding       qualities   = Phred33,
+    const NUMAPlacement         numa        = NUMAPlacement());
 
 ///@} // SequenceIO
 ///@} // IO
@@ -0,0 +1,144 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvbio/io/sequence/sequence_pool.h>
+
+namespace nvbio {
+namespace io {
+
+namespace {
+
+// grow a vector to hold at least n elements, leaving it untouched if it is already large enough
+//
+template <typename vector_type>
+bool grow(vector_type& vec, const uint64 n)
+{
+    if (vec.size() >= n)
+        return false;
+
+    vec.resize( n );
+    return true;
+}
+
+} // anonymous namespace
+
+// constructor
+//
+SequenceDataHostPool::SequenceDataHostPool(const uint32 n_batches, const float headroom) :
+    m_batches( n_batches ),
+    m_headroom( nvbio::max( headroom, 1.0f ) ),
+    m_max_seqs( 0u ),
+    m_max_words( 0u ),
+    m_max_bps( 0u ),
+    m_max_name_len( 0u ),
+    m_peak_bytes( 0u ),
+    m_n_batches( 0u ),
+    m_n_grows( 0u )
+{}
+
+// resize the pool
+//
+void SequenceDataHostPool::resize(const uint32 n_batches)
+{
+    m_batches.resize( n_batches );
+}
+
+// return the number of bytes used by the current contents of a batch
+//
+uint64 SequenceDataHostPool::bytes(const SequenceDataHost& batch)
+{
+    return
+        uint64( batch.m_sequence_stream_words ) * sizeof(uint32) +
+        uint64( batch.m_sequence_stream_len )   * sizeof(char) +
+        uint64( batch.m_name_stream_len )       * sizeof(char) +
+        uint64( batch.m_n_seqs + 1u ) * 2u      * sizeof(uint32);
+}
+
+// record the footprint of the i-th batch after it has been loaded
+//
+void SequenceDataHostPool::record(const uint32 i)
+{
+    const SequenceDataHost& batch = m_batches[i];
+
+    ScopedLock lock( &m_mutex );
+
+    m_max_seqs     = nvbio::max( m_max_seqs,     batch.m_n_seqs );
+    m_max_words    = nvbio::max( m_max_words,    batch.m_sequence_stream_words );
+    m_max_bps      = nvbio::max( m_max_bps,      batch.m_sequence_stream_len );
+    m_max_name_len = nvbio::max( m_max_name_len, batch.m_name_stream_len );
+    m_peak_bytes   = nvbio::max( m_peak_bytes,   bytes( batch ) );
+    m_n_batches++;
+}
+
+// grow the storage of the i-th batch to fit the largest batch recorded so far
+//
+void SequenceDataHostPool::reserve(const uint32 i)
+{
+    uint32 max_seqs, max_words, max_bps, max_name_len;
+    {
+        ScopedLock lock( &m_mutex );
+        max_seqs     = m_max_seqs;
+        max_words    = m_max_words;
+        max_bps      = m_max_bps;
+        max_name_len = m_max_name_len;
+    }
+    if (max_seqs == 0u)
+        return;
+
+    SequenceDataHost& batch = m_batches[i];
+
+    // check whether the batch can already hold the largest one, and if not, grow all its
+    // vectors at once, leaving some headroom for the next batches
+    if (batch.m_sequence_index_vec.size() >= max_seqs + 1u &&
+        batch.m_name_index_vec.size()     >= max_seqs + 1u &&
+        batch.m_sequence_vec.size()       >= max_words &&
+        batch.m_qual_vec.size()           >= max_bps &&
+        batch.m_name_vec.size()           >= max_name_len)
+        return;
+
+    const float h = m_headroom;
+
+    grow( batch.m_sequence_index_vec,   uint64( float( max_seqs + 1u ) * h ) );
+    grow( batch.m_name_index_vec,       uint64( float( max_seqs + 1u ) * h ) );
+    grow( batch.m_sequence_vec,         uint64( float( max_words ) * h ) );
+    grow( batch.m_qual_vec,             uint64( float( max_bps ) * h ) );
+    grow( batch.m_name_vec,             uint64( float( max_name_len ) * h ) );
+
+    ScopedLock lock( &m_mutex );
+    m_n_grows++;
+}
+
+// return the total number of bytes currently reserved by all batches
+//
+uint64 SequenceDataHostPool::reserved_bytes() const
+{
+    uint64 r = 0u;
+    for (uint32 i = 0; i < size(); ++i)
+    {
+        const SequenceDataHost& batch = m_batches[i];
+        r += batch.m_sequence_vec.size()       * sizeof(uint32) +
+             batch.m_qual_vec.size()           * sizeof(char) +
+             batch.m_name_vec.size()           * sizeof(char) +
+             batch.m_sequence_index_vec.size() * sizeof(uint32) +
+             batch.m_name_index_vec.size()     * sizeof(uint32);
+    }
+    return r;
+}
+
+} // namespace io
+} // namespace nvbio
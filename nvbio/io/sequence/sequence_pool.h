@@ -0,0 +1,120 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/basic/threads.h>
+#include <vector>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///
+/// A pool of host-side sequence batches, recycled across the batches of a SequenceDataStream
+/// by a producer thread (filling them) and a consumer thread (processing them).
+///\par
+/// The storage of a SequenceDataHost is never shrunk between batches, so that once a batch
+/// has grown large enough it can be refilled without any further allocation or initialization.
+/// The pool tracks the largest batch loaded so far, and reserve() grows any batch to fit it
+/// (plus some headroom) in a single step, rather than through the repeated doubling the
+/// encoder would otherwise perform on each batch independently.
+/// Calling reserve() from the consumer thread when a batch is released lets the consumer touch
+/// any newly allocated memory first, so that on NUMA systems it is placed close to the consumer.
+///\par
+/// The pool also keeps statistics about the peak size of the batches and the amount of memory
+/// reserved for them.
+///
+struct SequenceDataHostPool
+{
+    /// constructor
+    ///
+    /// \param n_batches        the number of batches in the pool
+    /// \param headroom         the growth factor applied to the largest batch when reserving storage
+    ///
+    SequenceDataHostPool(const uint32 n_batches = 0u, const float headroom = 1.25f);
+
+    /// resize the pool
+    ///
+    void resize(const uint32 n_batches);
+
+    /// return the number of batches in the pool
+    ///
+    uint32 size() const { return uint32( m_batches.size() ); }
+
+    /// return the i-th batch
+    ///
+    SequenceDataHost& operator[] (const uint32 i) { return m_batches[i]; }
+
+    /// return the i-th batch
+    ///
+    const SequenceDataHost& operator[] (const uint32 i) const { return m_batches[i]; }
+
+    /// record the footprint of the i-th batch after it has been loaded
+    ///
+    void record(const uint32 i);
+
+    /// grow the storage of the i-th batch to fit the largest batch recorded so far;
+    /// this method must be called by the thread currently owning the batch
+    ///
+    void reserve(const uint32 i);
+
+    /// return the peak number of bytes used by a batch
+    ///
+    uint64 peak_bytes() const { return m_peak_bytes; }
+
+    /// return the total number of bytes currently reserved by all batches
+    ///
+    uint64 reserved_bytes() const;
+
+    /// return the number of batches recorded so far
+    ///
+    uint64 n_batches() const { return m_n_batches; }
+
+    /// return the number of times a batch had to be grown by reserve()
+    ///
+    uint64 n_grows() const { return m_n_grows; }
+
+    /// return the number of bytes used by the current contents of a batch
+    ///
+    static uint64 bytes(const SequenceDataHost& batch);
+
+private:
+    std::vector<SequenceDataHost>   m_batches;
+    float                           m_headroom;
+    Mutex                           m_mutex;
+    uint32                          m_max_seqs;
+    uint32                          m_max_words;
+    uint32                          m_max_bps;
+    uint32                          m_max_name_len;
+    uint64                          m_peak_bytes;
+    uint64                          m_n_batches;
+    uint64                          m_n_grows;
+};
+
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
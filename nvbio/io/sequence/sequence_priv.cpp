@@ -226,25 +226,48 @@ SequenceDataStream *open_sequence_file(
 // \param sequence_file_name   the file to open
 // \param load_flags           a set of flags indicating what to load
 // \param qualities            the encoding of the qualities
+// \param numa                 the NUMA placement of the loaded sequence data
 //
 bool load_sequence_file(
     const Alphabet              alphabet,
     SequenceDataHost*           sequence_data,
     const char*                 sequence_file_name,
     const SequenceFlags         load_flags,
-    const QualityEncoding       qualities)
+    const QualityEncoding       qualities,
+    const NUMAPlacement         numa)
 {
     // check whether this is a pac archive
     if (is_pac_archive( sequence_file_name ))
-        return load_pac( alphabet, sequence_data, sequence_file_name, load_flags, qualities );
-
-    // open a regular stream
-    SharedPointer<SequenceDataStream> sequence_file( open_sequence_file( sequence_file_name, qualities ) );
-    if (sequence_file == NULL || sequence_file->is_ok() == false)
-        return false;
+    {
+        if (load_pac( alphabet, sequence_data, sequence_file_name, load_flags, qualities ) == false)
+            return false;
+    }
+    else
+    {
+        // open a regular stream
+        SharedPointer<SequenceDataStream> sequence_file( open_sequence_file( sequence_file_name, qualities ) );
+        if (sequence_file == NULL || sequence_file->is_ok() == false)
+            return false;
+
+        // load as many sequences as possible in one go
+        if (io::next( alphabet, sequence_data, sequence_file.get(), uint32(-1), uint32(-1) ) <= 0)
+            return false;
+    }
 
-    // load as many sequences as possible in one go
-    return io::next( alphabet, sequence_data, sequence_file.get(), uint32(-1), uint32(-1) ) > 0;
+    // apply the requested NUMA placement
+    if (numa.policy == NUMA_INTERLEAVE || numa.policy == NUMA_BIND)
+    {
+        const bool placed =
+            numa_place( raw_pointer( sequence_data->m_sequence_vec ),       sequence_data->m_sequence_vec.size()       * sizeof(uint32), numa ) &&
+            numa_place( raw_pointer( sequence_data->m_sequence_index_vec ), sequence_data->m_sequence_index_vec.size() * sizeof(uint32), numa ) &&
+            numa_place( raw_pointer( sequence_data->m_qual_vec ),           sequence_data->m_qual_vec.size()           * sizeof(char),   numa ) &&
+            numa_place( raw_pointer( sequence_data->m_name_vec ),           sequence_data->m_name_vec.size()           * sizeof(char),   numa ) &&
+            numa_place( raw_pointer( sequence_data->m_name_index_vec ),     sequence_data->m_name_index_vec.size()     * sizeof(uint32), numa );
+
+        if (placed == false)
+            log_warning(stderr, "unable to apply NUMA policy \"%s\" to \"%s\"\n", numa_policy_string( numa.policy ), sequence_file_name);
+    }
+    return true;
 }
 
 
@@ -254,15 +277,17 @@ bool load_sequence_file(
 /// \param sequence_file_name   the file to open
 /// \param load_flags           a set of flags indicating what to load
 /// \param qualities            the encoding of the qualities
+/// \param numa                 the NUMA placement of the loaded sequence data
 ///
 SequenceDataHost* load_sequence_file(
     const Alphabet              alphabet,
     const char*                 sequence_file_name,
     const SequenceFlags         load_flags,
-    const QualityEncoding       qualities)
+    const QualityEncoding       qualities,
+    const NUMAPlacement         numa)
 {
     SequenceDataHost* ret = new SequenceDataHost;
-    if (load_sequence_file( alphabet, ret, sequence_file_name, load_flags, qualities ) == false)
+    if (load_sequence_file( alphabet, ret, sequence_file_name, load_flags, qualities, numa ) == false)
     {
         delete ret;
         return NULL;
@@ -24,6 +24,7 @@
 #include <nvbio/basic/vector.h>
 #include <nvbio/basic/algorithms.h>
 #include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/sort.h>
 #include <nvbio/basic/cuda/sort.h>
 #include <nvbio/basic/cuda/primitives.h>
 #include <thrust/sort.h>
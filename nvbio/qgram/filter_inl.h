@@ -301,7 +301,9 @@ uint32 QGramFilter<host_tag, qgram_index_type, query_iterator, index_iterator>::
           output_iterator   merged_hits,
           count_iterator    merged_counts)
 {
-    m_diags.resize( n_hits );
+    // copy the hits to a temporary sorting buffer
+    const uint32 buffer_size = align<32>( n_hits );
+    m_diags.resize( buffer_size * 2u );
 
     // convert hits to diagonals and snap them to the closest one
     diagonals( n_hits, hits, m_diags.begin(), interval );
@@ -310,14 +312,18 @@ uint32 QGramFilter<host_tag, qgram_index_type, query_iterator, index_iterator>::
     typedef typename if_equal<diagonal_type, uint32, uint32, uint64>::type primitive_type;
 
     primitive_type* raw_diags( (primitive_type*)nvbio::raw_pointer( m_diags ) );
-    thrust::sort(
-        raw_diags,
-        raw_diags + n_hits );
+
+    cuda::SortBuffers<primitive_type*> sort_buffers;
+    sort_buffers.keys[0] = raw_diags;
+    sort_buffers.keys[1] = raw_diags + buffer_size;
+
+    HostSortEnactor sort_enactor;
+    sort_enactor.sort( n_hits, sort_buffers );
 
     // and run-length encode them
     const uint32 n_merged = uint32( thrust::reduce_by_key(
-            m_diags.begin(),
-            m_diags.begin() + n_hits,
+            m_diags.begin() + sort_buffers.selector * buffer_size,
+            m_diags.begin() + sort_buffers.selector * buffer_size + n_hits,
             thrust::make_constant_iterator<uint32>(1u),
             merged_hits,
             merged_counts ).first - merged_hits );
@@ -38,6 +38,9 @@ namespace nvbio {
 /// running expensive algorithms on them (especially with packed-strings).
 /// This is because local-memory reads guarantee fully coalesced accesses and implement
 /// efficient L1 caching.
+/// On the host, the host_cache_tag specializations unpack strings into small per-thread symbol
+/// buffers instead, and their prefetch() methods can be used to bring the strings needed by the
+/// next few jobs of a batch into the CPU caches ahead of time.
 ///
 ///@{
 
@@ -71,6 +74,13 @@ struct StringPrefetcher
     const string_type& load(
         const input_string_type& string,
         const uint2              range) { return string; }
+
+    /// issue software prefetches for a string that will be loaded in the near future
+    ///
+    /// \param string       input string
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const input_string_type& string) {}
 };
 
 ///
@@ -123,6 +133,14 @@ struct StringPrefetcher<
                          false ) );
     }
 
+    /// issue software prefetches for a string that will be loaded in the near future:
+    /// a no-op for local-memory caches
+    ///
+    /// \param string       input string
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const input_string_type& string) {}
+
     loader_type loader;
 };
 
@@ -178,6 +196,14 @@ struct StringPrefetcher<
                          false ) );
     }
 
+    /// issue software prefetches for a string that will be loaded in the near future:
+    /// a no-op for local-memory caches
+    ///
+    /// \param string       input string
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const input_string_type& string) {}
+
     loader_type loader;
 };
 
@@ -233,6 +259,208 @@ struct StringPrefetcher<
                          false ) );
     }
 
+    /// issue software prefetches for a string that will be loaded in the near future:
+    /// a no-op for local-memory caches
+    ///
+    /// \param string       input string
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const input_string_type& string) {}
+
+    loader_type loader;
+};
+
+///
+/// A class to prefetch a packed string using a host-side cache of unpacked symbols
+///
+/// \tparam StorageIterator     the underlying packed string storage iterator
+/// \tparam SYMBOL_SIZE_T       the size of the packed symbols, in bits
+/// \tparam BIG_ENDIAN_T        the endianness of the packing
+/// \tparam CACHE_SIZE          the host cache size, in symbols
+///
+template <typename StorageIterator, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, uint32 CACHE_SIZE>
+struct StringPrefetcher<
+    vector_view< PackedStream<StorageIterator,uint8,SYMBOL_SIZE_T,BIG_ENDIAN_T> >,
+    host_cache_tag<CACHE_SIZE> >
+{
+    typedef vector_view< PackedStream<StorageIterator,uint8,SYMBOL_SIZE_T,BIG_ENDIAN_T> >                           input_string_type;
+    typedef PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >              loader_type;
+    typedef vector_view<typename loader_type::iterator>                                                             string_type;
+
+    /// given a string, prefetch all its content and return a new string object
+    /// wrapping the cached version
+    ///
+    /// \param string       input string
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    string_type load(const input_string_type& string)
+    {
+        return string_type(
+            string.size(),
+            loader.load( string.base(),
+                         string.size() ) );
+    }
+
+    /// given a string, prefetch the contents of a substring and return a new string object
+    /// wrapping the cached version
+    ///
+    /// \param string           input string
+    /// \param range            range of the substring to load
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    string_type load(
+        const input_string_type& string,
+        const uint2              range)
+    {
+        return string_type(
+            string.size(),
+            loader.load( string.base(),
+                         string.size(),
+                         range,
+                         false ) );
+    }
+
+    /// issue software prefetches for a string that will be loaded in the near future
+    ///
+    /// \param string       input string
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const input_string_type& string)
+    {
+        loader_type::prefetch( string.base(), string.size() );
+    }
+
+    loader_type loader;
+};
+
+///
+/// A class to prefetch an infix built on top of a PackedStream using a host-side cache of unpacked symbols
+///
+/// \tparam StorageIterator     the underlying packed string storage iterator
+/// \tparam SYMBOL_SIZE_T       the size of the packed symbols, in bits
+/// \tparam BIG_ENDIAN_T        the endianness of the packing
+/// \tparam CACHE_SIZE          the host cache size, in symbols
+///
+template <typename InfixCoordType, typename StorageIterator, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, uint32 CACHE_SIZE>
+struct StringPrefetcher<
+    Infix< PackedStream<StorageIterator,uint8,SYMBOL_SIZE_T,BIG_ENDIAN_T>,
+           InfixCoordType >,
+    host_cache_tag<CACHE_SIZE> >
+{
+    typedef Infix< PackedStream<StorageIterator,uint8,SYMBOL_SIZE_T,BIG_ENDIAN_T>,
+                   InfixCoordType>                                                                                  input_string_type;
+    typedef PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >              loader_type;
+    typedef vector_view<typename loader_type::iterator>                                                             string_type;
+
+    /// given a string, prefetch all its content and return a new string object
+    /// wrapping the cached version
+    ///
+    /// \param string       input string
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    string_type load(const input_string_type& string)
+    {
+        return string_type(
+            string.size(),
+            loader.load( string.m_string + string.range().x,
+                         string.size() ) );
+    }
+
+    /// given a string, prefetch the contents of a substring and return a new string object
+    /// wrapping the cached version
+    ///
+    /// \param string           input string
+    /// \param range            range of the substring to load
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    string_type load(
+        const input_string_type& string,
+        const uint2              range)
+    {
+        return string_type(
+            string.size(),
+            loader.load( string.m_string + string.range().x,
+                         string.size(),
+                         range,
+                         false ) );
+    }
+
+    /// issue software prefetches for a string that will be loaded in the near future
+    ///
+    /// \param string       input string
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const input_string_type& string)
+    {
+        loader_type::prefetch( string.m_string + string.range().x, string.size() );
+    }
+
+    loader_type loader;
+};
+
+///
+/// A class to prefetch an infix built on top of a vector_view of a PackedStream using a host-side
+/// cache of unpacked symbols
+///
+/// \tparam StorageIterator     the underlying packed string storage iterator
+/// \tparam SYMBOL_SIZE_T       the size of the packed symbols, in bits
+/// \tparam BIG_ENDIAN_T        the endianness of the packing
+/// \tparam CACHE_SIZE          the host cache size, in symbols
+///
+template <typename InfixCoordType, typename StorageIterator, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, uint32 CACHE_SIZE>
+struct StringPrefetcher<
+    Infix< vector_view< PackedStream<StorageIterator,uint8,SYMBOL_SIZE_T,BIG_ENDIAN_T> >,
+           InfixCoordType >,
+    host_cache_tag<CACHE_SIZE> >
+{
+    typedef Infix< vector_view< PackedStream<StorageIterator,uint8,SYMBOL_SIZE_T,BIG_ENDIAN_T> >,
+                   InfixCoordType>                                                                                  input_string_type;
+    typedef PackedStringLoader<StorageIterator,SYMBOL_SIZE_T,BIG_ENDIAN_T,host_cache_tag<CACHE_SIZE> >              loader_type;
+    typedef vector_view<typename loader_type::iterator>                                                             string_type;
+
+    /// given a string, prefetch all its content and return a new string object
+    /// wrapping the cached version
+    ///
+    /// \param string       input string
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    string_type load(const input_string_type& string)
+    {
+        return string_type(
+            string.size(),
+            loader.load( string.m_string.base() + string.range().x,
+                         string.size() ) );
+    }
+
+    /// given a string, prefetch the contents of a substring and return a new string object
+    /// wrapping the cached version
+    ///
+    /// \param string           input string
+    /// \param range            range of the substring to load
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    string_type load(
+        const input_string_type& string,
+        const uint2              range)
+    {
+        return string_type(
+            string.size(),
+            loader.load( string.m_string.base() + string.range().x,
+                         string.size(),
+                         range,
+                         false ) );
+    }
+
+    /// issue software prefetches for a string that will be loaded in the near future
+    ///
+    /// \param string       input string
+    ///
+    static NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void prefetch(const input_string_type& string)
+    {
+        loader_type::prefetch( string.m_string.base() + string.range().x, string.size() );
+    }
+
     loader_type loader;
 };
 
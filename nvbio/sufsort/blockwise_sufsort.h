@@ -22,10 +22,12 @@
 #include <nvbio/sufsort/compression_sort.h>
 #include <nvbio/sufsort/prefix_doubling_sufsort.h>
 #include <nvbio/sufsort/dcs.h>
+#include <nvbio/sufsort/spill_file.h>
 #include <nvbio/strings/string_set.h>
 #include <nvbio/basic/thrust_view.h>
 #include <nvbio/basic/cuda/sort.h>
 #include <nvbio/basic/timer.h>
+#include <nvbio/basic/shared_pointer.h>
 #include <thrust/device_vector.h>
 #include <thrust/transform_scan.h>
 #include <thrust/binary_search.h>
@@ -34,6 +36,9 @@
 #include <thrust/sort.h>
 #include <mgpuhost.cuh>
 #include <moderngpu.cuh>
+#include <stdio.h>
+#include <string>
+#include <vector>
 
 
 namespace nvbio {
@@ -72,7 +77,7 @@ void blockwise_suffix_sort(
 
     //const size_t max_super_block_mem  = free - max_block_size*16u - 512u*1024u*1024u;
     //const uint32 max_super_block_size = uint32( max_super_block_mem / 4u );
-    const uint32 max_super_block_size = nvbio::min(             // requires max_super_block_size*4 host memory bytes
+    uint32 max_super_block_size = nvbio::min(                   // requires max_super_block_size*4 host memory bytes
         index_type( params ?
             (params->host_memory - (128u*1024u*1024u)) / 4u :   // leave 128MB for the bucket counters
             512*1024*1024 ),
@@ -105,9 +110,27 @@ void blockwise_suffix_sort(
 
     const uint32 DELAY_BUFFER = 1024*1024;
 
-    log_verbose(stderr,"  super-block-size: %.1f M\n", float(max_super_block_size)/float(1024*1024));
+    // in external-memory mode the super-blocks are not gathered in host memory: the suffixes
+    // of each block of sub-buckets are spilled to a separate scratch file together with their
+    // bucket, and placed in their slots only when the block is loaded back for sorting.
+    // As blocks of sub-buckets are packed greedily, each pair of them holds at least
+    // max_block_size suffixes, so that a super-block never needs more than MAX_SPILLS+1 files.
+    const bool   external   = params && params->scratch_dir;
+    const uint32 MAX_SPILLS = 256;
+
+    if (external)
+    {
+        max_super_block_size = uint32( nvbio::min( nvbio::min(
+            uint64( MAX_SPILLS/2 ) * max_block_size,
+            uint64( string_len ) + 1u ),                        // +1 as super-blocks are strictly smaller
+            uint64( uint32(-1) ) ) );
+    }
+    const uint64 spill_buffer = external ?                      // requires MAX_SPILLS*spill_buffer host memory bytes
+        nvbio::max( params->host_memory / (2u*MAX_SPILLS), uint64( 1024u*1024u ) ) : 0u;
+
+    log_verbose(stderr,"  super-block-size: %.1f M%s\n", float(max_super_block_size)/float(1024*1024), external ? " (spilled)" : "");
     log_verbose(stderr,"        block-size: %.1f M\n", float(max_block_size)/float(1024*1024));
-    thrust::host_vector<uint32> h_super_suffixes( max_super_block_size, 0u );
+    thrust::host_vector<uint32> h_super_suffixes( external ? 0u : max_super_block_size, 0u );
     thrust::host_vector<uint32> h_block_suffixes( max_block_size );
     thrust::host_vector<uint32> h_block_radices( max_block_size );
 
@@ -219,6 +242,10 @@ void blockwise_suffix_sort(
 
     index_type global_suffix_offset = 0;
 
+    std::vector< SharedPointer<SpillFile> > spills;     // the scratch files of the current super-block
+    std::vector<uint32>                     bucket_spills( external ? h_buckets.size() : 0u );
+    std::vector<uint2>                      h_spilled( external ? max_block_size : 0u );
+
     for (uint32 bucket_begin = 0, bucket_end = 0; bucket_begin < h_buckets.size(); bucket_begin = bucket_end)
     {
         // grow the block of buckets until we can
@@ -228,6 +255,30 @@ void blockwise_suffix_sort(
 
         uint32 suffix_count = 0;
 
+        if (external)
+        {
+            // assign each block of sub-buckets its own scratch file
+            uint32 n_spills = 0;
+            for (uint32 subbucket_begin = bucket_begin, subbucket_end = bucket_begin; subbucket_begin < bucket_end; subbucket_begin = subbucket_end, ++n_spills)
+            {
+                uint32 subbucket_size;
+                for (subbucket_size = 0; (subbucket_end < bucket_end) && (subbucket_size + h_buckets[subbucket_end] < max_block_size); ++subbucket_end)
+                {
+                    subbucket_size += h_buckets[subbucket_end];
+
+                    bucket_spills[ subbucket_end ] = n_spills;
+                }
+            }
+
+            spills.clear();
+            spills.resize( n_spills );
+            for (uint32 i = 0; i < n_spills; ++i)
+            {
+                spills[i] = SharedPointer<SpillFile>( new SpillFile );
+                spills[i]->open( spill_file_name( params->scratch_dir, params->scratch_prefix, i ).c_str(), sizeof(uint2), spill_buffer );
+            }
+        }
+
         log_verbose(stderr,"  collect buckets[%u:%u] (%u suffixes)\n", bucket_begin, bucket_end, bucket_size);
         Timer collect_timer;
         collect_timer.start();
@@ -250,19 +301,32 @@ void blockwise_suffix_sort(
                 h_block_radices.begin(),
                 h_block_suffixes.begin() );
 
-            // dispatch each suffix to their respective bucket
-            for (uint32 i = 0; i < n_collected; ++i)
+            if (external)
+            {
+                // spill each suffix together with its bucket, to be placed when loaded back
+                for (uint32 i = 0; i < n_collected; ++i)
+                {
+                    const uint2 entry = make_uint2( h_block_radices[i], h_block_suffixes[i] );
+
+                    spills[ bucket_spills[ entry.x ] ]->append( 1u, &entry );
+                }
+            }
+            else
             {
-                const uint32 loc    = h_block_suffixes[i];
-                const uint32 bucket = h_block_radices[i];
-                const uint64 slot   = h_bucket_offsets[bucket]++; // this could be done in parallel using atomics
+                // dispatch each suffix to their respective bucket
+                for (uint32 i = 0; i < n_collected; ++i)
+                {
+                    const uint32 loc    = h_block_suffixes[i];
+                    const uint32 bucket = h_block_radices[i];
+                    const uint64 slot   = h_bucket_offsets[bucket]++; // this could be done in parallel using atomics
 
-                NVBIO_CUDA_DEBUG_ASSERT(
-                    slot >= global_suffix_offset,
-                    slot <  global_suffix_offset + max_super_block_size,
-                    "[%u] = %u placed at %llu - %llu (%u)\n", i, loc, slot, global_suffix_offset, bucket );
+                    NVBIO_CUDA_DEBUG_ASSERT(
+                        slot >= global_suffix_offset,
+                        slot <  global_suffix_offset + max_super_block_size,
+                        "[%u] = %u placed at %llu - %llu (%u)\n", i, loc, slot, global_suffix_offset, bucket );
 
-                h_super_suffixes[ slot - global_suffix_offset ] = loc;
+                    h_super_suffixes[ slot - global_suffix_offset ] = loc;
+                }
             }
 
             suffix_count += n_collected;
@@ -293,6 +357,8 @@ void blockwise_suffix_sort(
 
         suffix_count = 0u;
 
+        uint32 spill_id = 0u;
+
         for (uint32 subbucket_begin = bucket_begin, subbucket_end = bucket_begin; subbucket_begin < bucket_end; subbucket_begin = subbucket_end)
         {
             // grow the block of sub-buckets until we can
@@ -310,10 +376,39 @@ void blockwise_suffix_sort(
             timer.start();
 
             // initialize the device sorting indices
-            thrust::copy(
-                h_super_suffixes.begin() + suffix_count,
-                h_super_suffixes.begin() + suffix_count + n_suffixes,
-                d_subbucket_suffixes.begin() );
+            if (external)
+            {
+                // load the spilled suffixes back, placing each in its slot within the block
+                SpillFile& spill = *spills[ spill_id++ ];
+                spill.rewind();
+
+                if (spill.read( n_suffixes, &h_spilled[0] ) != n_suffixes)
+                    throw nvbio::runtime_error("blockwise_suffix_sort(): short read from a scratch file");
+
+                spill.close();
+
+                const uint64 block_offset = uint64( global_suffix_offset ) + suffix_count;
+
+                for (uint32 i = 0; i < n_suffixes; ++i)
+                {
+                    const uint2  entry = h_spilled[i];
+                    const uint64 slot  = h_bucket_offsets[ entry.x ]++;
+
+                    h_block_suffixes[ uint32( slot - block_offset ) ] = entry.y;
+                }
+
+                thrust::copy(
+                    h_block_suffixes.begin(),
+                    h_block_suffixes.begin() + n_suffixes,
+                    d_subbucket_suffixes.begin() );
+            }
+            else
+            {
+                thrust::copy(
+                    h_super_suffixes.begin() + suffix_count,
+                    h_super_suffixes.begin() + suffix_count + n_suffixes,
+                    d_subbucket_suffixes.begin() );
+            }
 
         #if defined(COMPRESSION_SORTING)
             delay_list.set_offset( global_suffix_offset + suffix_count );
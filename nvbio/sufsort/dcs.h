@@ -167,6 +167,43 @@ struct DCS
     thrust::device_vector<uint32> d_ranks;      ///< ordered DCS ranks
 };
 
+/// A host-side Difference Cover Sample, used by the CPU-only blockwise suffix sorter
+///
+struct HostDCS
+{
+    typedef DCSView plain_view_type;
+
+    /// constructor
+    ///
+    template <uint32 QT>
+    void init();
+
+    /// estimate sample size
+    ///
+    uint32 estimate_sample_size(const uint64 string_len) const { return uint32( util::divide_ri( string_len * N, Q ) + 1u ); }
+
+    /// return the amount of used host memory
+    ///
+    uint64 allocated_host_memory() const
+    {
+        return
+            h_dc.size()      * sizeof(uint32) +
+            h_lut.size()     * sizeof(uint32) +
+            h_pos.size()     * sizeof(uint32) +
+            h_bitmask.size() * sizeof(uint8)  +
+            h_ranks.size()   * sizeof(uint32);
+    }
+
+    uint32                        Q;            ///< difference cover period
+    uint32                        N;            ///< difference cover quorum
+
+    thrust::host_vector<uint32>   h_dc;         ///< difference cover table
+    thrust::host_vector<uint32>   h_lut;        ///< the (i,j) -> l LUT
+    thrust::host_vector<uint32>   h_pos;        ///< the DC -> pos mapping
+    thrust::host_vector<uint8>    h_bitmask;    ///< difference cover bitmask
+    thrust::host_vector<uint32>   h_ranks;      ///< ordered DCS ranks
+};
+
 /// return the plain view of a DCS
 ///
 inline DCSView plain_view(DCS& dcs)
@@ -189,6 +226,28 @@ inline DCSView plain_view(const DCS& dcs)
     return plain_view( const_cast<DCS&>( dcs ) );
 }
 
+/// return the plain view of a host-side DCS
+///
+inline DCSView plain_view(HostDCS& dcs)
+{
+    return DCSView(
+        dcs.Q,
+        dcs.N,
+        uint32( dcs.h_ranks.size() ),
+        nvbio::plain_view( dcs.h_dc ),
+        nvbio::plain_view( dcs.h_lut ),
+        nvbio::plain_view( dcs.h_pos ),
+        nvbio::plain_view( dcs.h_bitmask ),
+        nvbio::plain_view( dcs.h_ranks ) );
+}
+
+/// return the plain view of a host-side DCS
+///
+inline DCSView plain_view(const HostDCS& dcs)
+{
+    return plain_view( const_cast<HostDCS&>( dcs ) );
+}
+
 namespace priv {
 
 /// A functor to evaluate whether an index is in a Difference Cover Sample
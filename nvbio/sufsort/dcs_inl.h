@@ -128,30 +128,41 @@ uint32 DCSView::index(const uint32 i) const
 // constructor
 //
 template <uint32 QT>
-void DCS::init()
+void HostDCS::init()
 {
     // build a table for our Difference Cover
-    const uint32* h_dc = DCTable<QT>::S();
+    const uint32* dc = DCTable<QT>::S();
 
     Q = QT;
     N = DCTable<QT>::N;
 
-    thrust::host_vector<uint8>    h_bitmask( Q, 0u );
-    thrust::host_vector<uint32>   h_lut( Q*Q, 0u );
-    thrust::host_vector<uint32>   h_pos( Q, 0u );
+    h_dc.resize( N );
+    h_bitmask.resize( Q );
+    h_lut.resize( Q*Q );
+    h_pos.resize( Q );
+    h_ranks.clear();
+
+    thrust::fill( h_bitmask.begin(), h_bitmask.end(), 0u );
+    thrust::fill( h_lut.begin(),     h_lut.end(),     0u );
+    thrust::fill( h_pos.begin(),     h_pos.end(),     0u );
+
+    thrust::copy(
+        dc,
+        dc + N,
+        h_dc.begin() );
 
     // build the DC bitmask
     thrust::scatter(
         thrust::make_constant_iterator<uint32>(1u),
         thrust::make_constant_iterator<uint32>(1u) + N,
-        h_dc,
+        dc,
         h_bitmask.begin() );
 
     // build the DC position table, mapping each entry in DC to its position (q -> i | DC[i] = q)
     thrust::scatter(
         thrust::make_counting_iterator<uint32>(0u),
         thrust::make_counting_iterator<uint32>(0u) + N,
-        h_dc,
+        dc,
         h_pos.begin() );
 
     // build the LUT (i,j) -> l | [(i + l) in DC && (j + l) in DC]
@@ -172,17 +183,25 @@ void DCS::init()
             }
         }
     }
+}
 
-    // copy all tables to the device
-    d_dc.resize( N );
-    thrust::copy(
-        h_dc,
-        h_dc + N,
-        d_dc.begin() );
-
-    d_lut     = h_lut;
-    d_pos     = h_pos;
-    d_bitmask = h_bitmask;
+// constructor
+//
+template <uint32 QT>
+void DCS::init()
+{
+    // build the tables on the host
+    HostDCS h_dcs;
+    h_dcs.init<QT>();
+
+    Q = h_dcs.Q;
+    N = h_dcs.N;
+
+    // and copy them to the device
+    d_dc      = h_dcs.h_dc;
+    d_lut     = h_dcs.h_lut;
+    d_pos     = h_dcs.h_pos;
+    d_bitmask = h_dcs.h_bitmask;
 }
 
 } // namespace nvbio
@@ -18,8 +18,10 @@
 
 #include <nvbio/sufsort/file_bwt.h>
 #include <nvbio/sufsort/file_bwt_bgz.h>
+#include <nvbio/basic/timer.h>
 #include <nvbio/sufsort/sufsort_priv.h>
 #include <zlib/zlib.h>
+#include <algorithm>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -107,6 +109,8 @@ struct DollarRankMap
         const uint2*  d_suffixes,
         const uint32* d_indices)
     {
+        uint32 n_found_dollars = 0;
+
         if (h_suffixes != NULL &&   // these are NULL for the empty suffixes
             d_suffixes != NULL)
         {
@@ -117,8 +121,6 @@ struct DollarRankMap
             priv::alloc_storage( h_dollar_ranks,   n_suffixes );
             priv::alloc_storage( h_dollars,        n_suffixes );
 
-            uint32 n_found_dollars = 0;
-
             if (d_indices != NULL)
             {
                 priv::alloc_storage( d_dollar_indices, n_suffixes );
@@ -180,17 +182,12 @@ struct DollarRankMap
                     uint64( offset + h_dollar_ranks[i] ),
                     h_dollars[i] );
             }
-
-            n_dollars += n_found_dollars;
-            return n_found_dollars;
         #else
             priv::alloc_storage( found_dollars, n_suffixes );
             priv::alloc_storage( h_indices,     n_suffixes );
 
             const priv::suffix_component_functor<priv::STRING_ID> suffix_string;
 
-            uint32 n_found_dollars = 0;
-
             if (d_indices != NULL)
             {
                 // copy the indices back to the host
@@ -204,7 +201,7 @@ struct DollarRankMap
                 {
                     if (h_bwt[i] == 255u)
                     {
-                        h_dollars[ n_found_dollars++ ] = std::make_pair(
+                        found_dollars[ n_found_dollars++ ] = std::make_pair(
                             uint64( offset + i ),
                             suffix_string( h_suffixes[ h_indices[i] ] ) );
                     }
@@ -223,14 +220,29 @@ struct DollarRankMap
                     }
                 }
             }
-
-            n_dollars += n_found_dollars;
-            return n_found_dollars;
         #endif
         }
+        else if (h_suffixes != NULL)    // host-only construction: the suffixes are given in sorted order
+        {
+            priv::alloc_storage( found_dollars, n_suffixes );
 
-        offset += n_suffixes;
-        return 0;
+            const priv::suffix_component_functor<priv::STRING_ID> suffix_string;
+
+            // loop through every symbol and keep track of the dollars
+            for (uint32 i = 0; i < n_suffixes; ++i)
+            {
+                if (h_bwt[i] == 255u)
+                {
+                    found_dollars[ n_found_dollars++ ] = std::make_pair(
+                        uint64( offset + i ),
+                        suffix_string( h_suffixes[i] ) );
+                }
+            }
+        }
+
+        n_dollars += n_found_dollars;
+        offset    += n_suffixes;
+        return n_found_dollars;
     }
 
     uint64                          offset;
@@ -256,14 +268,22 @@ struct FileBWTHandler : public BaseBWTHandler, public BWTWriter
 {
     static const uint32 WORD_SIZE = uint32( 8u * sizeof(word_type) );
     static const uint32 SYMBOLS_PER_WORD = WORD_SIZE / SYMBOL_SIZE;
+    static const uint32 SYMBOL_MASK = (1u << SYMBOL_SIZE) - 1u;     // dollars (255) are truncated to SYMBOL_MASK
 
     /// constructor
     ///
-    FileBWTHandler() : offset(0) {}
+    FileBWTHandler() : offset(0), cache_word(0) {}
 
-    /// destructor
+    /// destructor: flush the last partial word and terminate the index with the BWT length
     ///
-    virtual ~FileBWTHandler() {}
+    virtual ~FileBWTHandler()
+    {
+        if (offset & (SYMBOLS_PER_WORD-1))
+            BWTWriter::bwt_write( sizeof(word_type), &cache_word );
+
+        const DollarRankMap::entry_type terminator( offset, uint32(-1) );
+        BWTWriter::index_write( sizeof(DollarRankMap::entry_type), &terminator );
+    }
 
     /// write header
     ///
@@ -273,6 +293,19 @@ struct FileBWTHandler : public BaseBWTHandler, public BWTWriter
         BWTWriter::index_write( 4, magic );
     }
 
+    /// wait for any output compressed in the background to be written out
+    ///
+    void flush() { BWTWriter::flush(); }
+
+    /// return the statistics of the output stage
+    ///
+    BWTOutputStats output_stats() const
+    {
+        BWTOutputStats stats;
+        BWTWriter::collect_stats( &stats );
+        return stats;
+    }
+
     /// process a batch of BWT symbols
     ///
     void process(
@@ -305,7 +338,7 @@ struct FileBWTHandler : public BaseBWTHandler, public BWTWriter
             {
                 const uint32       bit_idx = (word_offset + i) * SYMBOL_SIZE;
                 const uint32 symbol_offset = BIG_ENDIAN ? (WORD_SIZE - SYMBOL_SIZE - bit_idx) : bit_idx;
-                const word_type     symbol = word_type(h_bwt[i]) << symbol_offset;
+                const word_type     symbol = word_type(h_bwt[i] & SYMBOL_MASK) << symbol_offset;
 
                 // set bits
                 word |= symbol;
@@ -328,7 +361,7 @@ struct FileBWTHandler : public BaseBWTHandler, public BWTWriter
             {
                 const uint32       bit_idx = j * SYMBOL_SIZE;
                 const uint32 symbol_offset = BIG_ENDIAN ? (WORD_SIZE - SYMBOL_SIZE - bit_idx) : bit_idx;
-                const word_type     symbol = word_type(h_bwt[i + j]) << symbol_offset;
+                const word_type     symbol = word_type(h_bwt[i + j] & SYMBOL_MASK) << symbol_offset;
 
                 // set bits
                 word |= symbol;
@@ -402,6 +435,19 @@ struct ASCIIFileBWTHandler : public BaseBWTHandler, public BWTWriter
         BWTWriter::index_write( 5, magic );
     }
 
+    /// wait for any output compressed in the background to be written out
+    ///
+    void flush() { BWTWriter::flush(); }
+
+    /// return the statistics of the output stage
+    ///
+    BWTOutputStats output_stats() const
+    {
+        BWTOutputStats stats;
+        BWTWriter::collect_stats( &stats );
+        return stats;
+    }
+
     /// process a batch of BWT symbols
     ///
     void process(
@@ -472,6 +518,109 @@ struct ASCIIFileBWTHandler : public BaseBWTHandler, public BWTWriter
     std::vector<char>       dollar_buffer;
 };
 
+/// A class to output the BWT to a run-length encoded binary file (see rle_code).
+/// Batches are encoded in parallel in fixed-size chunks, whose runs are not merged
+/// across chunk boundaries.
+///
+template <typename BWTWriter>
+struct RLEFileBWTHandler : public BaseBWTHandler, public BWTWriter
+{
+    static const uint32 CHUNK_SIZE = 1024u*1024u;
+
+    /// constructor
+    ///
+    RLEFileBWTHandler() : offset(0) {}
+
+    /// destructor: terminate the index with the BWT length
+    ///
+    virtual ~RLEFileBWTHandler()
+    {
+        const DollarRankMap::entry_type terminator( offset, uint32(-1) );
+        BWTWriter::index_write( sizeof(DollarRankMap::entry_type), &terminator );
+    }
+
+    /// write header
+    ///
+    void write_header()
+    {
+        const char* magic = "PRIB";         // PRImary-Binary
+        BWTWriter::index_write( 4, magic );
+    }
+
+    /// wait for any output compressed in the background to be written out
+    ///
+    void flush() { BWTWriter::flush(); }
+
+    /// return the statistics of the output stage
+    ///
+    BWTOutputStats output_stats() const
+    {
+        BWTOutputStats stats;
+        BWTWriter::collect_stats( &stats );
+        return stats;
+    }
+
+    /// process a batch of BWT symbols
+    ///
+    void process(
+        const uint32  n_suffixes,
+        const uint8*  h_bwt,
+        const uint8*  d_bwt,
+        const uint2*  h_suffixes,
+        const uint2*  d_suffixes,
+        const uint32* d_indices)
+    {
+        const uint32 n_chunks = util::divide_ri( n_suffixes, CHUNK_SIZE );
+
+        // encode each chunk in place of its symbols
+        priv::alloc_storage( runs,       n_suffixes );
+        priv::alloc_storage( chunk_runs, n_chunks );
+
+        #pragma omp parallel for
+        for (int k = 0; k < int( n_chunks ); ++k)
+        {
+            const uint32 chunk_begin = uint32(k) * CHUNK_SIZE;
+            const uint32 chunk_size  = nvbio::min( CHUNK_SIZE, n_suffixes - chunk_begin );
+
+            chunk_runs[k] = uint32( rle_encode( chunk_size, h_bwt + chunk_begin, &runs[ chunk_begin ] ) );
+        }
+
+        // and write them out in order
+        for (uint32 k = 0; k < n_chunks; ++k)
+        {
+            const uint32 n_bytes   = chunk_runs[k];
+            const uint32 n_written = BWTWriter::bwt_write( n_bytes, &runs[ k * CHUNK_SIZE ] );
+            if (n_written != n_bytes)
+                throw nvbio::runtime_error("RLEFileBWTHandler::process() : bwt write failed! (%u/%u bytes written)", n_written, n_bytes);
+        }
+
+        const uint32 n_found_dollars = dollars.extract(
+            n_suffixes,
+            h_bwt,
+            d_bwt,
+            h_suffixes,
+            d_suffixes,
+            d_indices );
+
+        // and write the list to the output
+        if (n_found_dollars)
+        {
+            const uint32 n_bytes   = uint32( sizeof(DollarRankMap::entry_type) * n_found_dollars );
+            const uint32 n_written = BWTWriter::index_write( n_bytes, &dollars.found_dollars[0] );
+            if (n_written != n_bytes)
+                throw nvbio::runtime_error("RLEFileBWTHandler::process() : index write failed! (%u/%u bytes written)", n_written, n_bytes);
+        }
+
+        // advance the offset
+        offset += n_suffixes;
+    }
+
+    uint64                  offset;
+    std::vector<uint8>      runs;
+    std::vector<uint32>     chunk_runs;
+    DollarRankMap           dollars;
+};
+
 /// A class to output the BWT to a binary file
 ///
 struct RawBWTWriter
@@ -498,9 +647,18 @@ struct RawBWTWriter
     ///
     bool is_ok() const;
 
+    /// wait for all pending output to be written out
+    ///
+    void flush() {}
+
+    /// add the output statistics to a given record
+    ///
+    void collect_stats(BWTOutputStats* stats) const { *stats += m_stats; }
+
 private:
-    FILE*   output_file;
-    FILE*   index_file;
+    FILE*           output_file;
+    FILE*           index_file;
+    BWTOutputStats  m_stats;
 };
 
 /// A class to output the BWT to a gzipped binary file
@@ -529,9 +687,18 @@ struct BWTGZWriter
     ///
     bool is_ok() const;
 
+    /// wait for all pending output to be written out
+    ///
+    void flush() {}
+
+    /// add the output statistics to a given record
+    ///
+    void collect_stats(BWTOutputStats* stats) const { *stats += m_stats; }
+
 private:
-    void*   output_file;
-    void*   index_file;
+    void*           output_file;
+    void*           index_file;
+    BWTOutputStats  m_stats;
 };
 
 // constructor
@@ -561,7 +728,14 @@ void RawBWTWriter::open(const char* output_name, const char* index_name)
 //
 uint32 RawBWTWriter::bwt_write(const uint32 n_bytes, const void* buffer)
 {
-    return fwrite( buffer, sizeof(uint8), n_bytes, output_file );
+    Timer timer;
+    timer.start();
+
+    const uint32 n_written = fwrite( buffer, sizeof(uint8), n_bytes, output_file );
+
+    timer.stop();
+    m_stats.wait_time += timer.seconds();
+    return n_written;
 }
 
 // write to the index
@@ -606,7 +780,17 @@ void BWTGZWriter::open(const char* output_name, const char* index_name, const ch
 //
 uint32 BWTGZWriter::bwt_write(const uint32 n_bytes, const void* buffer)
 {
-    return gzwrite( output_file, buffer, n_bytes );
+    // compression happens synchronously, on the calling thread
+    Timer timer;
+    timer.start();
+
+    const uint32 n_written = gzwrite( output_file, buffer, n_bytes );
+
+    timer.stop();
+    m_stats.compression_time += timer.seconds();
+    m_stats.wait_time        += timer.seconds();
+    m_stats.raw_bytes        += n_bytes;
+    return n_written;
 }
 
 // write to the index
@@ -621,6 +805,85 @@ uint32 BWTGZWriter::index_write(const uint32 n_bytes, const void* buffer)
 bool BWTGZWriter::is_ok() const { return output_file != NULL || index_file != NULL; }
 
 
+/// A class to collect the BWT of a string set in a HostSetBWT
+///
+struct HostSetBWTHandler : public BaseBWTHandler
+{
+    typedef HostSetBWT::word_type word_type;
+
+    static const uint32 SYMBOLS_PER_WORD = HostSetBWT::SYMBOLS_PER_WORD;
+    static const uint32 SYMBOL_MASK      = (1u << HostSetBWT::SYMBOL_SIZE) - 1u;
+
+    /// constructor
+    ///
+    HostSetBWTHandler(HostSetBWT* _bwt) : bwt(_bwt)
+    {
+        bwt->n_symbols = 0;
+        bwt->dollars.clear();
+    }
+
+    /// process a batch of BWT symbols
+    ///
+    void process(
+        const uint32  n_suffixes,
+        const uint8*  h_bwt,
+        const uint8*  d_bwt,
+        const uint2*  h_suffixes,
+        const uint2*  d_suffixes,
+        const uint32* d_indices)
+    {
+        const uint64 offset = bwt->n_symbols;
+
+        // grow the packed storage geometrically
+        const uint64 required_words = util::divide_ri( offset + n_suffixes, SYMBOLS_PER_WORD ) + 1u;
+        if (bwt->bwt.size() < required_words)
+            bwt->bwt.resize( nvbio::max( required_words, (uint64( bwt->bwt.size() ) * 3u) / 2u ) );
+
+        // fill the current partial word
+        const uint32 word_offset = uint32( offset & (SYMBOLS_PER_WORD-1) );
+        const uint32 word_rem    = word_offset ? nvbio::min( SYMBOLS_PER_WORD - word_offset, n_suffixes ) : 0u;
+
+        HostSetBWT::stream_type stream = bwt->stream();
+        for (uint32 i = 0; i < word_rem; ++i)
+            stream[ offset + i ] = h_bwt[i] & SYMBOL_MASK;
+
+        // and encode all following words in parallel
+        word_type* words = nvbio::raw_pointer( bwt->bwt );
+
+        #pragma omp parallel for
+        for (int i = word_rem; i < int( n_suffixes ); i += SYMBOLS_PER_WORD)
+        {
+            word_type word = 0u;
+
+            const uint32 n_symbols = nvbio::min( SYMBOLS_PER_WORD, n_suffixes - i );
+
+            for (uint32 j = 0; j < n_symbols; ++j)
+                word |= word_type(h_bwt[i + j] & SYMBOL_MASK) << (30u - j*2u);
+
+            words[ (offset + i) / SYMBOLS_PER_WORD ] = word;
+        }
+
+        // keep track of the dollars
+        const uint32 n_found_dollars = dollars.extract(
+            n_suffixes,
+            h_bwt,
+            d_bwt,
+            h_suffixes,
+            d_suffixes,
+            d_indices );
+
+        bwt->dollars.insert(
+            bwt->dollars.end(),
+            dollars.found_dollars.begin(),
+            dollars.found_dollars.begin() + n_found_dollars );
+
+        bwt->n_symbols = offset + n_suffixes;
+    }
+
+    HostSetBWT*     bwt;
+    DollarRankMap   dollars;
+};
+
 // open a BWT file
 //
 BaseBWTHandler* open_bwt_file(const char* output_name, const char* params)
@@ -640,6 +903,9 @@ BaseBWTHandler* open_bwt_file(const char* output_name, const char* params)
         BWT4GZ  = 10,
         BWT4BGZ = 11,
         BWT4LZ4 = 12,
+        RLE     = 13,
+        RLEGZ   = 14,
+        RLEBGZ  = 15,
     };
     OutputFormat format = UNKNOWN;
     std::string  index_string = output_name;
@@ -704,6 +970,34 @@ BaseBWTHandler* open_bwt_file(const char* output_name, const char* params)
             }
         }
 
+        //
+        // detect RLE* variants
+        //
+        if (len >= strlen(".rle.bgz"))
+        {
+            if (strcmp(&output_name[len - strlen(".rle.bgz")], ".rle.bgz") == 0)
+            {
+                format = RLEBGZ;
+                index_string.replace( index_string.find(".rle.bgz"), 8u, ".pri.bgz" );
+            }
+        }
+        if (len >= strlen(".rle.gz"))
+        {
+            if (strcmp(&output_name[len - strlen(".rle.gz")], ".rle.gz") == 0)
+            {
+                format = RLEGZ;
+                index_string.replace( index_string.find(".rle.gz"), 7u, ".pri.gz" );
+            }
+        }
+        if (len >= strlen(".rle"))
+        {
+            if (strcmp(&output_name[len - strlen(".rle")], ".rle") == 0)
+            {
+                format = RLE;
+                index_string.replace( index_string.find(".rle"), 4u, ".pri" );
+            }
+        }
+
         //
         // detect TXT* variants
         //
@@ -817,6 +1111,48 @@ BaseBWTHandler* open_bwt_file(const char* output_name, const char* params)
         file_handler->write_header();
         return file_handler;
     }
+    else if (format == RLE)
+    {
+        // build an output handler
+        RLEFileBWTHandler<RawBWTWriter>* file_handler = new RLEFileBWTHandler<RawBWTWriter>();
+
+        file_handler->open( output_name, index_string.c_str() );
+        if (file_handler->is_ok() == false)
+        {
+            log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
+            return NULL;
+        }
+        file_handler->write_header();
+        return file_handler;
+    }
+    else if (format == RLEBGZ)
+    {
+        // build an output handler
+        RLEFileBWTHandler<BWTBGZWriter>* file_handler = new RLEFileBWTHandler<BWTBGZWriter>();
+
+        file_handler->open( output_name, index_string.c_str(), params );
+        if (file_handler->is_ok() == false)
+        {
+            log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
+            return NULL;
+        }
+        file_handler->write_header();
+        return file_handler;
+    }
+    else if (format == RLEGZ)
+    {
+        // build an output handler
+        RLEFileBWTHandler<BWTGZWriter>* file_handler = new RLEFileBWTHandler<BWTGZWriter>();
+
+        file_handler->open( output_name, index_string.c_str(), params );
+        if (file_handler->is_ok() == false)
+        {
+            log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
+            return NULL;
+        }
+        file_handler->write_header();
+        return file_handler;
+    }
     else if (format == TXT)
     {
         // build an output handler
@@ -864,4 +1200,327 @@ BaseBWTHandler* open_bwt_file(const char* output_name, const char* params)
     return NULL;
 }
 
+// return the name of the primary index file written alongside a given BWT file
+//
+std::string primary_index_name(const char* bwt_name)
+{
+    struct Format { const char* bwt_ext; const char* pri_ext; };
+
+    const Format formats[] = {
+        { ".bwt.bgz",   ".pri.bgz" },
+        { ".bwt.gz",    ".pri.gz"  },
+        { ".bwt",       ".pri"     },
+        { ".bwt4.bgz",  ".pri.bgz" },
+        { ".bwt4.gz",   ".pri.gz"  },
+        { ".bwt4",      ".pri"     },
+        { ".rle.bgz",   ".pri.bgz" },
+        { ".rle.gz",    ".pri.gz"  },
+        { ".rle",       ".pri"     },
+        { ".txt.bgz",   ".pri.bgz" },
+        { ".txt.gz",    ".pri.gz"  },
+        { ".txt",       ".pri"     },
+    };
+
+    const uint32 len = (uint32)strlen( bwt_name );
+
+    for (uint32 f = 0; f < sizeof(formats) / sizeof(Format); ++f)
+    {
+        const uint32 ext_len = (uint32)strlen( formats[f].bwt_ext );
+        if (len >= ext_len && strcmp( &bwt_name[len - ext_len], formats[f].bwt_ext ) == 0)
+        {
+            std::string index_string = bwt_name;
+            index_string.replace( len - ext_len, ext_len, formats[f].pri_ext );
+            return index_string;
+        }
+    }
+    return std::string();
+}
+
+// open a handler collecting a string-set BWT in host memory
+//
+BaseBWTHandler* open_host_set_bwt(HostSetBWT* bwt)
+{
+    return new HostSetBWTHandler( bwt );
+}
+
+namespace { // anonymous namespace
+
+// a sequential reader for the files written by open_bwt_file(): the ".bgz" streams of
+// independently deflated blocks are decoded by a BGZFileReader, while gzread() handles
+// both gzip compressed and uncompressed files
+//
+struct BWTInputFile
+{
+    BWTInputFile() : m_bgz( false ), m_gz_file( NULL ) {}
+    ~BWTInputFile() { close(); }
+
+    bool open(const char* name)
+    {
+        const uint32 len = (uint32)strlen( name );
+
+        m_bgz = len >= 4u && strcmp( &name[len - 4u], ".bgz" ) == 0;
+        if (m_bgz)
+            return m_bgz_file.open( name );
+
+        m_gz_file = gzopen( name, "rb" );
+        return m_gz_file != NULL;
+    }
+
+    int read(void* dst, const uint32 n_bytes)
+    {
+        return m_bgz ? m_bgz_file.read( dst, n_bytes ) : gzread( m_gz_file, dst, n_bytes );
+    }
+
+    void close()
+    {
+        m_bgz_file.close();
+        if (m_gz_file)
+            gzclose( m_gz_file );
+        m_gz_file = NULL;
+    }
+
+private:
+    bool            m_bgz;
+    BGZFileReader   m_bgz_file;
+    gzFile          m_gz_file;
+};
+
+// read a binary primary index written by open_bwt_file(), returning its sorted dollars and
+// the length of the BWT stored in its terminator
+//
+bool read_primary_index(const char* index_name, std::vector<HostSetBWT::dollar_type>& dollars, uint64* n_symbols)
+{
+    typedef HostSetBWT::dollar_type dollar_type;
+
+    BWTInputFile index_file;
+    if (index_file.open( index_name ) == false)
+    {
+        log_error(stderr,"  unable to open index file \"%s\"\n", index_name);
+        return false;
+    }
+
+    char magic[4];
+    if (index_file.read( magic, 4 ) != 4 || strncmp( magic, "PRIB", 4 ) != 0)
+    {
+        log_error(stderr,"  index file \"%s\" is not a binary primary index\n", index_name);
+        return false;
+    }
+
+    dollars.clear();
+
+    *n_symbols = uint64(-1);
+
+    dollar_type entry;
+    while (index_file.read( &entry, sizeof(dollar_type) ) == int( sizeof(dollar_type) ))
+    {
+        if (entry.second == uint32(-1))
+        {
+            *n_symbols = entry.first;
+            break;
+        }
+        dollars.push_back( entry );
+    }
+    index_file.close();
+
+    if (*n_symbols == uint64(-1))
+    {
+        log_error(stderr,"  index file \"%s\" has no length terminator (written by an older version?)\n", index_name);
+        return false;
+    }
+
+    std::sort( dollars.begin(), dollars.end() );
+
+    if (dollars.size() && dollars.back().first >= *n_symbols)
+    {
+        log_error(stderr,"  index file \"%s\" is inconsistent with the BWT length\n", index_name);
+        return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// load a string-set BWT from a binary file written by open_bwt_file()
+//
+bool load_bwt_file(const char* input_name, HostSetBWT* bwt)
+{
+    typedef HostSetBWT::word_type   word_type;
+
+    struct Format { const char* bwt_ext; const char* pri_ext; uint32 symbol_size; };
+
+    const Format formats[] = {
+        { ".bwt.bgz",   ".pri.bgz", 2u },
+        { ".bwt.gz",    ".pri.gz",  2u },
+        { ".bwt",       ".pri",     2u },
+        { ".bwt4.bgz",  ".pri.bgz", 4u },
+        { ".bwt4.gz",   ".pri.gz",  4u },
+        { ".bwt4",      ".pri",     4u },
+    };
+
+    // detect the file format from the suffix
+    uint32      symbol_size  = 0u;
+    std::string index_string = input_name;
+    {
+        const uint32 len = (uint32)strlen( input_name );
+
+        for (uint32 f = 0; f < sizeof(formats) / sizeof(Format); ++f)
+        {
+            const uint32 ext_len = (uint32)strlen( formats[f].bwt_ext );
+            if (len >= ext_len && strcmp( &input_name[len - ext_len], formats[f].bwt_ext ) == 0)
+            {
+                symbol_size = formats[f].symbol_size;
+                index_string.replace( len - ext_len, ext_len, formats[f].pri_ext );
+                break;
+            }
+        }
+        if (symbol_size == 0u)
+        {
+            log_error(stderr,"  unsupported input format \"%s\"\n", input_name);
+            return false;
+        }
+    }
+
+    // read the primary index first, as its terminator holds the length of the BWT
+    uint64 n_symbols;
+    if (read_primary_index( index_string.c_str(), bwt->dollars, &n_symbols ) == false)
+        return false;
+
+    // and read the BWT itself
+    {
+        BWTInputFile bwt_file;
+        if (bwt_file.open( input_name ) == false)
+        {
+            log_error(stderr,"  unable to open input file \"%s\"\n", input_name);
+            return false;
+        }
+
+        bwt->resize( n_symbols );
+
+        const uint32 symbols_per_file_word = 32u / symbol_size;
+        const uint64 n_file_words          = util::divide_ri( n_symbols, symbols_per_file_word );
+        const uint32 chunk_words           = 16u*1024u*1024u;   // multiple of 2, so that 4-bit chunks map to whole 2-bit words
+
+        word_type* words = nvbio::raw_pointer( bwt->bwt );
+
+        std::vector<word_type> chunk( symbol_size == 4u ? chunk_words : 0u );
+
+        for (uint64 word_begin = 0; word_begin < n_file_words; word_begin += chunk_words)
+        {
+            const uint32 n_words = uint32( nvbio::min( uint64( chunk_words ), n_file_words - word_begin ) );
+
+            // read 2-bit words in place
+            word_type* dst = symbol_size == 2u ? words + word_begin : &chunk[0];
+
+            const int n_bytes = int( n_words * sizeof(word_type) );
+            if (bwt_file.read( dst, n_bytes ) != n_bytes)
+            {
+                log_error(stderr,"  failed reading input file \"%s\"\n", input_name);
+                return false;
+            }
+
+            if (symbol_size == 4u)
+            {
+                // repack pairs of 4-bit words into single 2-bit words, truncating dollars to 2 bits
+                #pragma omp parallel for
+                for (int w = 0; w < int( util::divide_ri( n_words, 2u ) ); ++w)
+                {
+                    word_type word = 0u;
+                    for (uint32 h = 0; h < 2u && 2u*w + h < n_words; ++h)
+                    {
+                        const word_type in = chunk[ 2u*w + h ];
+                        for (uint32 j = 0; j < 8u; ++j)
+                            word |= ((in >> (28u - j*4u)) & 3u) << (30u - (h*8u + j)*2u);
+                    }
+                    words[ word_begin/2u + w ] = word;
+                }
+            }
+        }
+        bwt_file.close();
+    }
+    return true;
+}
+
+// load a run-length encoded string-set BWT written by open_bwt_file()
+//
+bool load_rle_bwt_file(const char* input_name, RLERankDictionaryHost* dict, std::vector<HostSetBWT::dollar_type>* dollars)
+{
+    struct Format { const char* bwt_ext; const char* pri_ext; };
+
+    const Format formats[] = {
+        { ".rle.bgz",   ".pri.bgz" },
+        { ".rle.gz",    ".pri.gz"  },
+        { ".rle",       ".pri"     },
+    };
+
+    // detect the file format from the suffix
+    std::string index_string;
+    {
+        const uint32 len = (uint32)strlen( input_name );
+
+        for (uint32 f = 0; f < sizeof(formats) / sizeof(Format); ++f)
+        {
+            const uint32 ext_len = (uint32)strlen( formats[f].bwt_ext );
+            if (len >= ext_len && strcmp( &input_name[len - ext_len], formats[f].bwt_ext ) == 0)
+            {
+                index_string = input_name;
+                index_string.replace( len - ext_len, ext_len, formats[f].pri_ext );
+                break;
+            }
+        }
+        if (index_string.empty())
+        {
+            log_error(stderr,"  unsupported input format \"%s\"\n", input_name);
+            return false;
+        }
+    }
+
+    std::vector<HostSetBWT::dollar_type> index_dollars;
+
+    uint64 n_symbols;
+    if (read_primary_index( index_string.c_str(), dollars ? *dollars : index_dollars, &n_symbols ) == false)
+        return false;
+
+    // read all the runs, whose number is not known in advance
+    {
+        BWTInputFile bwt_file;
+        if (bwt_file.open( input_name ) == false)
+        {
+            log_error(stderr,"  unable to open input file \"%s\"\n", input_name);
+            return false;
+        }
+
+        const uint32 chunk_size = 16u*1024u*1024u;
+
+        uint64 n_runs = 0u;
+        for (;;)
+        {
+            dict->m_runs.resize( n_runs + chunk_size );
+
+            const int n_read = bwt_file.read( nvbio::raw_pointer( dict->m_runs ) + n_runs, chunk_size );
+            if (n_read < 0)
+            {
+                log_error(stderr,"  failed reading input file \"%s\"\n", input_name);
+                return false;
+            }
+            n_runs += uint32( n_read );
+
+            if (uint32( n_read ) < chunk_size)
+                break;
+        }
+        bwt_file.close();
+
+        dict->m_runs.resize( n_runs );
+    }
+
+    // and build the rank dictionary tables
+    dict->index();
+
+    if (dict->size() != n_symbols)
+    {
+        log_error(stderr,"  input file \"%s\" holds %llu symbols, expected %llu\n", input_name, (unsigned long long)dict->size(), (unsigned long long)n_symbols);
+        return false;
+    }
+    return true;
+}
+
 } // namespace nvbio
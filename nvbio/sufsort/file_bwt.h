@@ -19,6 +19,9 @@
 #pragma once
 
 #include <nvbio/sufsort/sufsort_utils.h>
+#include <nvbio/sufsort/merge_bwt.h>
+#include <nvbio/fmindex/rle_rank_dictionary.h>
+#include <string>
 
 namespace nvbio {
 
@@ -41,6 +44,9 @@ namespace nvbio {
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt4</td><td style="vertical-align:text-top;">     4-bit packed binary</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt4.gz</td><td style="vertical-align:text-top;">  4-bit packed binary, gzip compressed</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt4.bgz</td><td style="vertical-align:text-top;"> 4-bit packed binary, block-gzip compressed</td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">.rle</td><td style="vertical-align:text-top;">      run-length encoded binary</td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">.rle.gz</td><td style="vertical-align:text-top;">   run-length encoded binary, gzip compressed</td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">.rle.bgz</td><td style="vertical-align:text-top;">  run-length encoded binary, block-gzip compressed</td></tr>
 /// </table>
 ///
 /// Alongside with the main BWT file, a file containing the mapping between the primary
@@ -58,7 +64,14 @@ namespace nvbio {
 ///\verbatim
 ///char[4] header = "PRIB";
 ///struct { uint64 position; uint32 string_id; } pairs[n];
+///struct { uint64 length;   uint32 0xFFFFFFFF; } terminator;
 ///\endverbatim
+/// where the terminator holds the total number of symbols in the BWT.
+/// In the packed binary BWT files dollars are stored as the largest symbol (i.e. 3 or 15),
+/// and can only be told apart through the index.
+/// The run-length encoded files are plain sequences of rle_code bytes, where dollars
+/// are kept as a separate symbol, and can be queried directly through an rle_rank_dictionary
+/// (see load_rle_bwt_file()).
 ///
 /// \param output_name      output name
 /// \param params           additional compression parameters (e.g. "1R", "9", etc)
@@ -66,6 +79,40 @@ namespace nvbio {
 ///
 BaseBWTHandler* open_bwt_file(const char* output_name, const char* params);
 
+/// return the name of the primary index file open_bwt_file() writes alongside a given BWT
+/// file, or an empty string if the format of the BWT file is not recognized
+///
+/// \param bwt_name         the BWT file name
+///
+std::string primary_index_name(const char* bwt_name);
+
+/// open a handler collecting a string-set BWT in host memory, e.g. to merge it with
+/// an existing one through merge_bwt()
+///
+/// \param bwt              the output BWT
+/// \return     a handler that can be used by the string-set BWT construction functions
+///
+BaseBWTHandler* open_host_set_bwt(HostSetBWT* bwt);
+
+/// load a string-set BWT from a packed binary file written by open_bwt_file(), i.e.
+/// any of the .bwt and .bwt4 variants, together with its primary index
+///
+/// \param input_name       input name
+/// \param bwt              the output BWT
+/// \return     true on success
+///
+bool load_bwt_file(const char* input_name, HostSetBWT* bwt);
+
+/// load a run-length encoded string-set BWT written by open_bwt_file(), i.e. any of the
+/// .rle variants, into a rank dictionary, optionally returning the dollars of its primary index
+///
+/// \param input_name       input name
+/// \param dict             the output rank dictionary
+/// \param dollars          the optional output list of (position,string-id) pairs, sorted by position
+/// \return     true on success
+///
+bool load_rle_bwt_file(const char* input_name, RLERankDictionaryHost* dict, std::vector<HostSetBWT::dollar_type>* dollars = NULL);
+
 ///@}
 
 } // namespace nvbio
@@ -19,6 +19,7 @@
 #include <nvbio/sufsort/file_bwt_bgz.h>
 #include <nvbio/basic/exceptions.h>
 #include <zlib/zlib.h>
+#include <string.h>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -57,12 +58,13 @@ static const int one = 1;
 static const uint32 BLOCK_SIZE             = 256*1024;      // the compression unit, in bytes
 static const unsigned int BGZS_MAGICNUMBER = 0x0F1F2F3F;    // just a magic number
 static const unsigned int BGZS_EOS         = 0;             // a stream terminator
-static const uint32 NUM_BLOCKS             = 128;           // the highest, the better for load balancing
 
 // constructor
 //
 BGZFileWriter::BGZFileWriter(FILE* _file) :
-    m_file(NULL), m_buffer(NUM_BLOCKS*BLOCK_SIZE), m_buffer_size(0), m_comp_buffer(NUM_BLOCKS*BLOCK_SIZE)
+    BlockFileWriter( BLOCK_SIZE ),
+    m_level( Z_DEFAULT_COMPRESSION ),
+    m_strategy( Z_DEFAULT_STRATEGY )
 {
     if (_file != NULL)
         open( _file, Z_DEFAULT_COMPRESSION, Z_DEFAULT_STRATEGY );
@@ -74,21 +76,22 @@ BGZFileWriter::~BGZFileWriter() { close(); }
 
 // open a session
 //
-void BGZFileWriter::open(FILE* _file, const int level, const int strategy)
+void BGZFileWriter::open(FILE* _file, const int level, const int strategy, const uint32 n_threads)
 {
-    m_file = _file;
-
     const uint32 blockSizeId = nvbio::log2( BLOCK_SIZE );
 
     // write the archive header
-    char out_buff[7];
+    char out_buff[8] = { 0 };
     *(unsigned int*)out_buff = LITTLE_ENDIAN_32(BGZS_MAGICNUMBER);   // Magic Number, in Little Endian convention
     *(out_buff+4)  = 1;                                              // Version('01')
     *(out_buff+5)  = (char)blockSizeId;
-    fwrite( out_buff, 1, 8, m_file );                                // reserve 8 bytes in total
+    fwrite( out_buff, 1, 8, _file );                                 // reserve 8 bytes in total
 
     m_level    = level;
     m_strategy = strategy;
+
+    // and start the compressors
+    start( _file, n_threads );
 }
 
 // close a session
@@ -98,12 +101,8 @@ void BGZFileWriter::close()
     if (m_file == NULL)
         return;
 
-    // encode any remaining bytes
-    if (m_buffer_size)
-    {
-        encode_block( m_buffer_size, &m_buffer[0] );
-        m_buffer_size = 0;
-    }
+    // write out any remaining bytes
+    stop();
 
     // write the BGZ End-Of-Stream marker
     const unsigned int eos = BGZS_EOS;
@@ -113,95 +112,9 @@ void BGZFileWriter::close()
     m_file = NULL;
 }
 
-// write a block to the output
-//
-void BGZFileWriter::write(uint32 n_bytes, const void* _src)
-{
-    // convert input to a uint8 pointer
-    const uint8* src = (const uint8*)_src;
-
-    const uint32 NB = NUM_BLOCKS;//(uint32)omp_get_num_procs();
-
-    if (m_buffer_size)
-    {
-        //
-        // we have some pending bytes in the buffer, let's add as much as we can and
-        // eventually output a block if full
-        //
-        const uint32 n_needed = nvbio::min( NB*BLOCK_SIZE - m_buffer_size, n_bytes );
-
-        // copy the given block from the source
-        memcpy( &m_buffer[0] + m_buffer_size, src, n_needed );
-
-        m_buffer_size += n_needed;
-        src           += n_needed;
-        n_bytes       -= n_needed;
-
-        if (m_buffer_size == NB*BLOCK_SIZE)
-        {
-            encode_block( m_buffer_size, &m_buffer[0] );
-            m_buffer_size = 0;
-        }
-    }
-
-    //
-    // at this point either we have filled the buffer and emptied it, or
-    // we have terminated the source (i.e. n_bytes = 0)
-    //
-
-    for (uint32 block_begin = 0; block_begin < n_bytes; block_begin += NB*BLOCK_SIZE)
-    {
-        const uint32 block_end = nvbio::min( block_begin + NB*BLOCK_SIZE, n_bytes );
-
-        if (block_end - block_begin == NB*BLOCK_SIZE)
-        {
-            // encode directly without buffering
-            encode_block( NB*BLOCK_SIZE, src + block_begin );
-        }
-        else
-        {
-            // buffer the remaining bytes - happens only at the last iteration
-            memcpy( &m_buffer[0], src + block_begin, block_end - block_begin );
-            m_buffer_size += block_end - block_begin;
-        }
-    }
-}
-
-// encode a given block and write it to the output
-//
-void BGZFileWriter::encode_block(uint32 n_bytes, const uint8* src)
-{
-    uint32 block_sizes[NUM_BLOCKS];
-
-    #pragma omp parallel for
-    for (int block = 0; block < int( n_bytes ); block += BLOCK_SIZE)
-    {
-        const uint32 block_size = nvbio::min( BLOCK_SIZE, uint32( n_bytes - block ) );
-        block_sizes[ block/BLOCK_SIZE ] = compress( src + block, &m_comp_buffer[0] + block, block_size );
-    }
-
-    for (int block = 0; block < int( n_bytes ); block += BLOCK_SIZE)
-    {
-        const uint32 block_size = nvbio::min( BLOCK_SIZE, uint32( n_bytes - block ) );
-        const uint32 n_compressed = block_sizes[ block/BLOCK_SIZE ];
-        if (n_compressed)
-        {
-            const uint32 block_header = LITTLE_ENDIAN_32( n_compressed );
-            fwrite( &block_header, sizeof(uint32), 1u, m_file );
-            fwrite( &m_comp_buffer[0] + block, sizeof(uint8), n_compressed, m_file );
-        }
-        else
-        {
-            const uint32 block_header = LITTLE_ENDIAN_32( block_size | 0x80000000);   // Add Uncompressed flag
-            fwrite( &block_header, sizeof(uint32), 1u, m_file );
-            fwrite( src + block, sizeof(uint8), block_size, m_file );
-        }
-    }
-}
-
 // compress a given block
 //
-uint32 BGZFileWriter::compress(const uint8* src, uint8* dst, const uint32 n_bytes)
+uint32 BGZFileWriter::compress(const uint8* src, uint8* dst, const uint32 n_bytes) const
 {
     // initialize the gzip header
     // note that we don't actually care about most of these fields
@@ -254,6 +167,150 @@ uint32 BGZFileWriter::compress(const uint8* src, uint8* dst, const uint32 n_byte
     return stream.total_out;
 }
 
+// constructor
+//
+BGZFileReader::BGZFileReader() :
+    m_file( NULL ),
+    m_block_size( 0u ),
+    m_size( 0u ),
+    m_pos( 0u ),
+    m_eos( false ),
+    m_error( false )
+{}
+
+// destructor
+//
+BGZFileReader::~BGZFileReader() { close(); }
+
+// open a file
+//
+bool BGZFileReader::open(const char* name)
+{
+    close();
+
+    m_file = fopen( name, "rb" );
+    if (m_file == NULL)
+        return false;
+
+    // read and check the archive header
+    unsigned char in_buff[8];
+    if (fread( in_buff, 1, 8, m_file ) != 8 ||
+        LITTLE_ENDIAN_32( *(unsigned int*)in_buff ) != BGZS_MAGICNUMBER ||
+        in_buff[4] != 1 ||
+        in_buff[5] > 30)
+    {
+        close();
+        return false;
+    }
+
+    m_block_size = 1u << in_buff[5];
+    m_in.resize( m_block_size );
+    m_out.resize( m_block_size );
+    m_size  = 0u;
+    m_pos   = 0u;
+    m_eos   = false;
+    m_error = false;
+    return true;
+}
+
+// close the file
+//
+void BGZFileReader::close()
+{
+    if (m_file == NULL)
+        return;
+
+    fclose( m_file );
+    m_file = NULL;
+}
+
+// read up to n_bytes
+//
+int BGZFileReader::read(void* _dst, const uint32 n_bytes)
+{
+    uint8* dst = (uint8*)_dst;
+
+    uint32 n_read = 0u;
+    while (n_read < n_bytes)
+    {
+        if (m_pos == m_size && next_block() == false)
+            break;
+
+        const uint32 n_copied = nvbio::min( m_size - m_pos, n_bytes - n_read );
+        memcpy( dst + n_read, &m_out[ m_pos ], n_copied );
+        m_pos  += n_copied;
+        n_read += n_copied;
+    }
+    return m_error ? -1 : int( n_read );
+}
+
+// load and decode the next block, returning false at the end of the stream or on errors
+//
+bool BGZFileReader::next_block()
+{
+    if (m_file == NULL || m_eos || m_error)
+        return false;
+
+    uint32 block_header;
+    if (fread( &block_header, sizeof(uint32), 1u, m_file ) != 1u)
+    {
+        // the stream must be terminated by an explicit EOS marker
+        m_error = true;
+        return false;
+    }
+    block_header = LITTLE_ENDIAN_32( block_header );
+
+    if (block_header == BGZS_EOS)
+    {
+        m_eos = true;
+        return false;
+    }
+
+    const bool   raw         = (block_header & 0x80000000u) != 0u;
+    const uint32 block_bytes = block_header & ~0x80000000u;
+    if (block_bytes > m_block_size ||
+        fread( raw ? &m_out[0] : &m_in[0], sizeof(uint8), block_bytes, m_file ) != block_bytes)
+    {
+        m_error = true;
+        return false;
+    }
+
+    m_pos = 0u;
+
+    if (raw)
+    {
+        m_size = block_bytes;
+        return true;
+    }
+
+    // inflate the block
+    z_stream stream;
+    stream.zalloc   = Z_NULL;
+    stream.zfree    = Z_NULL;
+    stream.opaque   = Z_NULL;
+
+    stream.next_in  = (Bytef *)&m_in[0];
+    stream.avail_in = block_bytes;
+
+    stream.next_out  = (Bytef *)&m_out[0];
+    stream.avail_out = m_block_size;
+
+    if (inflateInit2(&stream, 15 + 16) != Z_OK)  // log2 of the window size + 16 to decode the gzip format
+        throw nvbio::runtime_error("BGZFileReader::next_block() inflateInit2 failed");
+
+    const int ret = inflate(&stream, Z_FINISH);
+    m_size = uint32( stream.total_out );
+    inflateEnd(&stream);
+
+    if (ret != Z_STREAM_END)
+    {
+        m_size  = 0u;
+        m_error = true;
+        return false;
+    }
+    return true;
+}
+
 // constructor
 //
 BWTBGZWriter::BWTBGZWriter() :
@@ -311,8 +368,16 @@ void BWTBGZWriter::open(const char* output_name, const char* index_name, const c
         }
     }
 
-    output_file_writer.open( output_file, level, strategy );
-    index_file_writer.open( index_file, level, strategy );
+    // compress the bwt on all cores, in the background of the BWT construction,
+    // while the much smaller index needs a single thread
+  #ifdef _OPENMP
+    const uint32 n_threads = uint32( omp_get_num_procs() );
+  #else
+    const uint32 n_threads = 1u;
+  #endif
+
+    output_file_writer.open( output_file, level, strategy, n_threads );
+    index_file_writer.open( index_file, level, strategy, 1u );
 }
 
 // write to the bwt
@@ -331,6 +396,22 @@ uint32 BWTBGZWriter::index_write(const uint32 n_bytes, const void* buffer)
     return n_bytes;
 }
 
+// wait for all pending output to be written out
+//
+void BWTBGZWriter::flush()
+{
+    output_file_writer.flush();
+    index_file_writer.flush();
+}
+
+// add the output statistics to a given record
+//
+void BWTBGZWriter::collect_stats(BWTOutputStats* stats) const
+{
+    output_file_writer.collect_stats( stats );
+    index_file_writer.collect_stats( stats );
+}
+
 // return whether the file is in a good state
 //
 bool BWTBGZWriter::is_ok() const { return output_file != NULL || index_file != NULL; }
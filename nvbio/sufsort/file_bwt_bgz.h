@@ -19,10 +19,13 @@
 #pragma once
 
 #include <nvbio/sufsort/file_bwt.h>
+#include <nvbio/sufsort/file_bwt_block.h>
 
 namespace nvbio {
 
-struct BGZFileWriter
+/// A BlockFileWriter producing a stream of independently deflated blocks
+///
+struct BGZFileWriter : public BlockFileWriter
 {
     /// constructor
     ///
@@ -34,31 +37,69 @@ struct BGZFileWriter
 
     /// open a session
     ///
-    void open(FILE* _file, const int level, const int strategy);
+    /// \param _file           the output file
+    /// \param level           the zlib compression level
+    /// \param strategy        the zlib compression strategy
+    /// \param n_threads       the number of compressor threads
+    ///
+    void open(FILE* _file, const int level, const int strategy, const uint32 n_threads = 1u);
 
     /// close a session
     ///
     void close();
 
-    /// write a block to the output
+protected:
+    /// compress a given block
     ///
-    void write(uint32 n_bytes, const void* _src);
+    uint32 compress(const uint8* src, uint8* dst, const uint32 n_bytes) const;
 
 private:
-    /// encode a given block and write it to the output
+    int                m_level;
+    int                m_strategy;
+};
+
+/// A reader for the stream of independently deflated blocks produced by BGZFileWriter:
+/// an 8-byte header holding the magic number, the version and the log2 of the block size,
+/// followed by blocks prefixed by their little-endian length (with the 0x80000000 flag
+/// marking uncompressed blocks), and terminated by an empty block header.
+///\par
+/// Note that these files are not plain concatenations of gzip members, and cannot be
+/// decoded by gzread().
+///
+struct BGZFileReader
+{
+    /// constructor
     ///
-    void encode_block(uint32 n_bytes, const uint8* src);
+    BGZFileReader();
 
-    /// compress a given block
+    /// destructor
     ///
-    uint32 compress(const uint8* src, uint8* dst, const uint32 n_bytes);
+    ~BGZFileReader();
 
-    FILE*              m_file;
-    std::vector<uint8> m_buffer;
-    std::vector<uint8> m_comp_buffer;
-    uint32             m_buffer_size;
-    int                m_level;
-    int                m_strategy;
+    /// open a file, returning false if it can't be opened or its header is not valid
+    ///
+    bool open(const char* name);
+
+    /// close the file
+    ///
+    void close();
+
+    /// read up to n_bytes, returning the number of bytes read - less than requested only
+    /// at the end of the stream - or -1 if the stream is corrupt or truncated
+    ///
+    int read(void* dst, const uint32 n_bytes);
+
+private:
+    bool next_block();
+
+    FILE*               m_file;
+    uint32              m_block_size;
+    std::vector<uint8>  m_in;
+    std::vector<uint8>  m_out;
+    uint32              m_size;         // the number of decoded bytes in m_out
+    uint32              m_pos;          // the number of decoded bytes already consumed
+    bool                m_eos;
+    bool                m_error;
 };
 
 /// A class to output the BWT to an BGZ-compressed binary file
@@ -88,6 +129,14 @@ struct BWTBGZWriter
     ///
     bool is_ok() const;
 
+    /// wait for all pending output to be written out
+    ///
+    void flush();
+
+    /// add the output statistics to a given record
+    ///
+    void collect_stats(BWTOutputStats* stats) const;
+
 private:
     FILE*           output_file;
     FILE*           index_file;
@@ -0,0 +1,279 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvbio/sufsort/file_bwt_block.h>
+#include <nvbio/basic/timer.h>
+#include <string.h>
+
+namespace nvbio {
+
+namespace {
+
+// convert a 32-bit integer to little-endian
+//
+inline uint32 little_endian_32(const uint32 i)
+{
+    const uint32 one = 1u;
+    return *(const char*)(&one) ? i :
+        ((i << 24) & 0xff000000u) |
+        ((i <<  8) & 0x00ff0000u) |
+        ((i >>  8) & 0x0000ff00u) |
+        ((i >> 24) & 0x000000ffu);
+}
+
+} // anonymous namespace
+
+// constructor
+//
+BlockFileWriter::BlockFileWriter(const uint32 block_size) :
+    m_file( NULL ),
+    m_block_size( block_size ),
+    m_fill( 0u ),
+    m_fill_size( 0u ),
+    m_next_compress( 0u ),
+    m_next_write( 0u ),
+    m_pending( 0u ),
+    m_writing( false ),
+    m_stop( false )
+{}
+
+// destructor
+//
+BlockFileWriter::~BlockFileWriter() {}
+
+// start a pool of compressor threads writing to a given file
+//
+void BlockFileWriter::start(FILE* file, const uint32 n_threads)
+{
+    m_file = file;
+
+    // slot buffers are allocated lazily, so that streams using only a few of them
+    // (e.g. the primary index) take little memory
+    m_slots.resize( 2u * nvbio::max( n_threads, 1u ) );
+
+    m_fill          = 0u;
+    m_fill_size     = 0u;
+    m_next_compress = 0u;
+    m_next_write    = 0u;
+    m_pending       = 0u;
+    m_writing       = false;
+    m_stop          = false;
+
+    m_threads.resize( nvbio::max( n_threads, 1u ) );
+    for (uint32 i = 0; i < m_threads.size(); ++i)
+    {
+        m_threads[i].writer = this;
+        m_threads[i].set_id( i );
+        m_threads[i].create();
+    }
+}
+
+// write a block to the output
+//
+void BlockFileWriter::write(uint32 n_bytes, const void* _src)
+{
+    // convert input to a uint8 pointer
+    const uint8* src = (const uint8*)_src;
+
+    while (n_bytes)
+    {
+        Slot& slot = m_slots[ m_fill ];
+        if (slot.in.size() < m_block_size)
+            slot.in.resize( m_block_size );
+
+        // copy as much as we can in the current slot
+        const uint32 n_copied = nvbio::min( m_block_size - m_fill_size, n_bytes );
+
+        memcpy( &slot.in[0] + m_fill_size, src, n_copied );
+
+        m_fill_size += n_copied;
+        src         += n_copied;
+        n_bytes     -= n_copied;
+
+        // and hand it to the compressors if full
+        if (m_fill_size == m_block_size)
+            submit();
+    }
+}
+
+// hand the slot being filled to the compressors, and wait for the next one to be free
+//
+void BlockFileWriter::submit()
+{
+    if (m_fill_size == 0u)
+        return;
+
+    ScopedLock lock( &m_mutex );
+
+    Slot& slot = m_slots[ m_fill ];
+    slot.size  = m_fill_size;
+    slot.state = READY;
+
+    m_stats.raw_bytes += m_fill_size;
+    m_pending++;
+    m_work.signal();
+
+    m_fill      = (m_fill + 1u) % uint32( m_slots.size() );
+    m_fill_size = 0u;
+
+    // wait for the next slot to be written out
+    if (m_slots[ m_fill ].state != FREE)
+    {
+        Timer timer;
+        timer.start();
+
+        while (m_slots[ m_fill ].state != FREE)
+            m_freed.wait( &m_mutex );
+
+        timer.stop();
+        m_stats.wait_time += timer.seconds();
+    }
+}
+
+// submit any buffered bytes and wait for all pending blocks to be written out
+//
+void BlockFileWriter::flush()
+{
+    if (m_threads.empty())
+        return;
+
+    submit();
+
+    ScopedLock lock( &m_mutex );
+    if (m_pending)
+    {
+        Timer timer;
+        timer.start();
+
+        while (m_pending)
+            m_freed.wait( &m_mutex );
+
+        timer.stop();
+        m_stats.wait_time += timer.seconds();
+    }
+}
+
+// flush the output and stop the compressor threads
+//
+void BlockFileWriter::stop()
+{
+    if (m_threads.empty())
+        return;
+
+    flush();
+    {
+        ScopedLock lock( &m_mutex );
+        m_stop = true;
+        m_work.broadcast();
+    }
+    for (uint32 i = 0; i < m_threads.size(); ++i)
+        m_threads[i].join();
+
+    m_threads.clear();
+}
+
+// add the output statistics to a given record
+//
+void BlockFileWriter::collect_stats(BWTOutputStats* stats) const
+{
+    *stats += m_stats;
+}
+
+// the compressor threads' main loop
+//
+void BlockFileWriter::compressor_loop()
+{
+    const uint32 n_slots = uint32( m_slots.size() );
+
+    for (;;)
+    {
+        // grab the oldest submitted slot
+        uint32 k;
+        {
+            ScopedLock lock( &m_mutex );
+            while (m_slots[ m_next_compress ].state != READY && m_stop == false)
+                m_work.wait( &m_mutex );
+
+            if (m_slots[ m_next_compress ].state != READY)
+                break;
+
+            k = m_next_compress;
+            m_slots[k].state = COMPRESSING;
+            m_next_compress  = (k + 1u) % n_slots;
+        }
+
+        // compress it
+        Slot& slot = m_slots[k];
+        if (slot.out.size() < m_block_size)
+            slot.out.resize( m_block_size );
+
+        Timer timer;
+        timer.start();
+
+        slot.comp_size = compress( &slot.in[0], &slot.out[0], slot.size );
+
+        timer.stop();
+
+        // and write out all the slots compressed so far in submission order,
+        // unless another thread is already doing so
+        ScopedLock lock( &m_mutex );
+        slot.state = COMPRESSED;
+
+        m_stats.compression_time += timer.seconds();
+
+        if (m_writing)
+            continue;
+
+        m_writing = true;
+        while (m_slots[ m_next_write ].state == COMPRESSED)
+        {
+            Slot& out = m_slots[ m_next_write ];
+
+            m_mutex.unlock();
+            write_slot( out );
+            m_mutex.lock();
+
+            out.state    = FREE;
+            m_next_write = (m_next_write + 1u) % n_slots;
+            m_pending--;
+            m_freed.broadcast();
+        }
+        m_writing = false;
+    }
+}
+
+// write out a compressed slot
+//
+void BlockFileWriter::write_slot(const Slot& slot)
+{
+    if (slot.comp_size)
+    {
+        const uint32 block_header = little_endian_32( slot.comp_size );
+        fwrite( &block_header, sizeof(uint32), 1u, m_file );
+        fwrite( &slot.out[0], sizeof(uint8), slot.comp_size, m_file );
+    }
+    else
+    {
+        const uint32 block_header = little_endian_32( slot.size | 0x80000000u );   // add the uncompressed flag
+        fwrite( &block_header, sizeof(uint32), 1u, m_file );
+        fwrite( &slot.in[0], sizeof(uint8), slot.size, m_file );
+    }
+    m_stats.compressed_bytes += sizeof(uint32) + (slot.comp_size ? slot.comp_size : slot.size);
+}
+
+} // namespace nvbio
@@ -0,0 +1,138 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/sufsort/sufsort_utils.h>
+#include <nvbio/basic/threads.h>
+#include <stdio.h>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup Sufsort
+///@{
+
+///
+/// The base class of the block-compressed file writers (i.e. LZ4FileWriter and BGZFileWriter).
+/// The output is buffered in fixed-size blocks which are handed to a pool of compressor
+/// threads as soon as they are full, so that compression proceeds in the background of the
+/// thread producing the output, and whichever compressor completes the oldest pending block
+/// writes out all the blocks available in submission order.
+/// Each block is written with a little-endian 32-bit header holding its compressed size, or
+/// its raw size with the top bit set if compression did not shrink it.
+///\par
+/// The producer only blocks when all the pool's slots (two per compressor thread) are pending.
+///
+struct BlockFileWriter
+{
+    /// constructor
+    ///
+    /// \param block_size       the compression unit, in bytes
+    ///
+    BlockFileWriter(const uint32 block_size);
+
+    /// destructor; derived classes must call stop() in their own destructor,
+    /// as compressor threads call back their compress() method
+    ///
+    virtual ~BlockFileWriter();
+
+    /// start a pool of compressor threads writing to a given file
+    ///
+    /// \param file             the output file
+    /// \param n_threads        the number of compressor threads
+    ///
+    void start(FILE* file, const uint32 n_threads);
+
+    /// write a block to the output
+    ///
+    void write(uint32 n_bytes, const void* src);
+
+    /// submit any buffered bytes and wait for all pending blocks to be written out
+    ///
+    void flush();
+
+    /// flush the output and stop the compressor threads
+    ///
+    void stop();
+
+    /// add the output statistics to a given record
+    ///
+    void collect_stats(BWTOutputStats* stats) const;
+
+protected:
+    /// compress a block of up to block_size bytes into a buffer of the same size, returning
+    /// the compressed size, or zero if the block could not be shrunk;
+    /// this method is called concurrently by all compressor threads
+    ///
+    virtual uint32 compress(const uint8* src, uint8* dst, const uint32 n_bytes) const = 0;
+
+    FILE*   m_file;
+
+private:
+    enum SlotState { FREE = 0, READY = 1, COMPRESSING = 2, COMPRESSED = 3 };
+
+    struct Slot
+    {
+        Slot() : size(0u), comp_size(0u), state(FREE) {}
+
+        std::vector<uint8>  in;
+        std::vector<uint8>  out;
+        uint32              size;
+        uint32              comp_size;
+        uint32              state;
+    };
+
+    struct CompressorThread : public Thread<CompressorThread>
+    {
+        void run() { writer->compressor_loop(); }
+
+        BlockFileWriter* writer;
+    };
+
+    /// hand the slot being filled to the compressors, and wait for the next one to be free
+    ///
+    void submit();
+
+    /// the compressor threads' main loop
+    ///
+    void compressor_loop();
+
+    /// write out a compressed slot
+    ///
+    void write_slot(const Slot& slot);
+
+    uint32                          m_block_size;
+    std::vector<Slot>               m_slots;
+    std::vector<CompressorThread>   m_threads;
+    uint32                          m_fill;             // the slot being filled by the producer
+    uint32                          m_fill_size;        // the number of bytes in the slot being filled
+    uint32                          m_next_compress;    // the next slot to compress
+    uint32                          m_next_write;       // the next slot to write out
+    uint32                          m_pending;          // the number of submitted slots not yet written out
+    bool                            m_writing;          // whether a compressor is writing out slots
+    bool                            m_stop;
+    Mutex                           m_mutex;
+    Condition                       m_work;             // signaled when a slot is submitted
+    Condition                       m_freed;            // signaled when a slot is written out
+    BWTOutputStats                  m_stats;
+};
+
+///@}
+
+} // namespace nvbio
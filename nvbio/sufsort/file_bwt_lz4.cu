@@ -19,6 +19,9 @@
 #include <nvbio/sufsort/file_bwt_lz4.h>
 #include <lz4/lz4.h>
 #include <lz4/lz4hc.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace nvbio {
 
@@ -62,7 +65,7 @@ static const unsigned int LZ4S_EOS         = 0;
 // constructor
 //
 LZ4FileWriter::LZ4FileWriter(FILE* _file) :
-    m_file(NULL), m_buffer(BLOCK_SIZE), m_buffer_size(0), m_comp_buffer(BLOCK_SIZE)
+    BlockFileWriter( BLOCK_SIZE )
 {
     if (_file != NULL)
         open( _file );
@@ -74,10 +77,8 @@ LZ4FileWriter::~LZ4FileWriter() { close(); }
 
 // open a session
 //
-void LZ4FileWriter::open(FILE* _file)
+void LZ4FileWriter::open(FILE* _file, const uint32 n_threads)
 {
-    m_file = _file;
-
     const int blockIndependence = 1;
     const int blockChecksum     = 0;
     const int streamChecksum    = 0;
@@ -96,7 +97,10 @@ void LZ4FileWriter::open(FILE* _file)
     //checkbits = XXH32((out_buff+4), 2, LZ4S_CHECKSUM_SEED);
     //checkbits = LZ4S_GetCheckBits_FromXXH(checkbits);
     *(out_buff+6)  = (unsigned char)checkbits;
-    fwrite( out_buff, 1, 7, m_file );
+    fwrite( out_buff, 1, 7, _file );
+
+    // and start the compressors
+    start( _file, n_threads );
 }
 
 // close a session
@@ -106,12 +110,8 @@ void LZ4FileWriter::close()
     if (m_file == NULL)
         return;
 
-    // encode any remaining bytes
-    if (m_buffer_size)
-    {
-        encode_block( m_buffer_size, &m_buffer[0] );
-        m_buffer_size = 0;
-    }
+    // write out any remaining bytes
+    stop();
 
     // write the LZ4 End-Of-Stream marker
     const unsigned int eos = LZ4S_EOS;
@@ -121,79 +121,13 @@ void LZ4FileWriter::close()
     m_file = NULL;
 }
 
-// write a block to the output
+// compress a given block
 //
-void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
+uint32 LZ4FileWriter::compress(const uint8* src, uint8* dst, const uint32 n_bytes) const
 {
-    // convert input to a uint8 pointer
-    const uint8* src = (const uint8*)_src;
-
-    if (m_buffer_size)
-    {
-        //
-        // we have some pending bytes in the buffer, let's add as much as we can and
-        // eventually output a block if full
-        //
-        const uint32 n_needed = nvbio::min( BLOCK_SIZE - m_buffer_size, n_bytes );
-
-        // copy the given block from the source
-        memcpy( &m_buffer[0] + m_buffer_size, src, n_needed );
-
-        m_buffer_size += n_needed;
-        src           += n_needed;
-        n_bytes       -= n_needed;
-
-        if (m_buffer_size == BLOCK_SIZE)
-        {
-            encode_block( m_buffer_size, &m_buffer[0] );
-            m_buffer_size = 0;
-        }
-    }
-
-    //
-    // at this point either we have filled the buffer and emptied it, or
-    // we have terminated the source (i.e. n_bytes = 0)
-    //
-
-    for (uint32 block_begin = 0; block_begin < n_bytes; block_begin += BLOCK_SIZE)
-    {
-        const uint32 block_end = nvbio::min( block_begin + BLOCK_SIZE, n_bytes );
-
-        if (block_end - block_begin == BLOCK_SIZE)
-        {
-            // encode directly without buffering
-            encode_block( BLOCK_SIZE, src + block_begin );
-        }
-        else
-        {
-            // buffer the remaining bytes - happens only at the last iteration
-            memcpy( &m_buffer[0], src + block_begin, block_end - block_begin );
-            m_buffer_size += block_end - block_begin;
-        }
-    }
+    return (uint32)LZ4_compressHC_limitedOutput( (const char*)src, (char*)dst, n_bytes, n_bytes-1 );
 }
 
-// encode a given block and write it to the output
-//
-void LZ4FileWriter::encode_block(uint32 n_bytes, const uint8* src)
-{
-    const uint32 n_compressed = (uint32)LZ4_compressHC_limitedOutput( (const char*)src, (char*)&m_comp_buffer[0], n_bytes, n_bytes-1 );
-
-    if (n_compressed)
-    {
-        const uint32 block_header = LITTLE_ENDIAN_32( n_compressed );
-        fwrite( &block_header, sizeof(uint32), 1u, m_file );
-        fwrite( &m_comp_buffer[0], sizeof(uint8), n_compressed, m_file );
-    }
-    else
-    {
-        const uint32 block_header = LITTLE_ENDIAN_32( n_bytes | 0x80000000);   // Add Uncompressed flag
-        fwrite( &block_header, sizeof(uint32), 1u, m_file );
-        fwrite( src, sizeof(uint8), n_bytes, m_file );
-    }
-}
-
-
 // constructor
 //
 BWTLZ4Writer::BWTLZ4Writer() :
@@ -221,8 +155,16 @@ void BWTLZ4Writer::open(const char* output_name, const char* index_name, const c
     output_file = fopen( output_name, "wb" );
     index_file  = fopen( index_name,  "wb" );
 
-    output_file_writer.open( output_file );
-    index_file_writer.open( index_file );
+    // compress the bwt on all cores, in the background of the BWT construction,
+    // while the much smaller index needs a single thread
+  #ifdef _OPENMP
+    const uint32 n_threads = uint32( omp_get_num_procs() );
+  #else
+    const uint32 n_threads = 1u;
+  #endif
+
+    output_file_writer.open( output_file, n_threads );
+    index_file_writer.open( index_file, 1u );
 }
 
 // write to the bwt
@@ -241,6 +183,22 @@ uint32 BWTLZ4Writer::index_write(const uint32 n_bytes, const void* buffer)
     return n_bytes;
 }
 
+// wait for all pending output to be written out
+//
+void BWTLZ4Writer::flush()
+{
+    output_file_writer.flush();
+    index_file_writer.flush();
+}
+
+// add the output statistics to a given record
+//
+void BWTLZ4Writer::collect_stats(BWTOutputStats* stats) const
+{
+    output_file_writer.collect_stats( stats );
+    index_file_writer.collect_stats( stats );
+}
+
 // return whether the file is in a good state
 //
 bool BWTLZ4Writer::is_ok() const { return output_file != NULL || index_file != NULL; }
@@ -19,10 +19,13 @@
 #pragma once
 
 #include <nvbio/sufsort/file_bwt.h>
+#include <nvbio/sufsort/file_bwt_block.h>
 
 namespace nvbio {
 
-struct LZ4FileWriter
+/// A BlockFileWriter producing an LZ4 stream of independent blocks
+///
+struct LZ4FileWriter : public BlockFileWriter
 {
     /// constructor
     ///
@@ -34,25 +37,19 @@ struct LZ4FileWriter
 
     /// open a session
     ///
-    void open(FILE* _file);
+    /// \param _file           the output file
+    /// \param n_threads       the number of compressor threads
+    ///
+    void open(FILE* _file, const uint32 n_threads = 1u);
 
     /// close a session
     ///
     void close();
 
-    /// write a block to the output
-    ///
-    void write(uint32 n_bytes, const void* _src);
-
-private:
-    /// encode a given block and write it to the output
+protected:
+    /// compress a given block
     ///
-    void encode_block(uint32 n_bytes, const uint8* src);
-
-    FILE*              m_file;
-    std::vector<uint8> m_buffer;
-    std::vector<uint8> m_comp_buffer;
-    uint32             m_buffer_size;
+    uint32 compress(const uint8* src, uint8* dst, const uint32 n_bytes) const;
 };
 
 /// A class to output the BWT to an LZ4-compressed binary file
@@ -82,6 +79,14 @@ struct BWTLZ4Writer
     ///
     bool is_ok() const;
 
+    /// wait for all pending output to be written out
+    ///
+    void flush();
+
+    /// add the output statistics to a given record
+    ///
+    void collect_stats(BWTOutputStats* stats) const;
+
 private:
     FILE*           output_file;
     FILE*           index_file;
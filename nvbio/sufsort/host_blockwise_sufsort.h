@@ -0,0 +1,742 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/sufsort/sufsort_priv.h>
+#include <nvbio/sufsort/dcs.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/sort.h>
+#include <vector>
+#include <algorithm>
+
+namespace nvbio {
+namespace priv {
+
+/// A functor fetching windows of 64 bits worth of symbols from a host-side string,
+/// with the first symbol in the most significant bits
+///
+template <uint32 SYMBOL_SIZE, typename string_type>
+struct host_string_window
+{
+    static const uint32 WINDOW_SYMBOLS = 64u / SYMBOL_SIZE;
+
+    /// constructor
+    ///
+    host_string_window(const string_type _string) : string( _string ) {}
+
+    /// return the WINDOW_SYMBOLS symbols starting at i, which must all lie within the string
+    ///
+    uint64 operator() (const uint64 i) const { return (*this)( i, WINDOW_SYMBOLS ); }
+
+    /// return the n <= WINDOW_SYMBOLS symbols starting at i, padded with zeros
+    ///
+    uint64 operator() (const uint64 i, const uint32 n) const
+    {
+        uint64 word = 0u;
+        for (uint32 j = 0; j < n; ++j)
+            word |= uint64( string[i + j] ) << (64u - SYMBOL_SIZE - j*SYMBOL_SIZE);
+
+        return word;
+    }
+
+    string_type string;
+};
+
+/// A functor fetching windows of 64 bits worth of symbols from a host-side string,
+/// specialized for big-endian packed streams: a full window is assembled from at most
+/// three 32-bit storage words instead of being gathered one symbol at a time
+///
+template <uint32 SYMBOL_SIZE, typename storage_type, typename symbol_type, typename index_type>
+struct host_string_window<SYMBOL_SIZE, PackedStream<storage_type,symbol_type,SYMBOL_SIZE,true,index_type> >
+{
+    typedef PackedStream<storage_type,symbol_type,SYMBOL_SIZE,true,index_type> string_type;
+
+    static const uint32 WINDOW_SYMBOLS  = 64u / SYMBOL_SIZE;
+    static const uint32 STORAGE_SYMBOLS = 32u / SYMBOL_SIZE;
+
+    /// constructor
+    ///
+    host_string_window(const string_type _string) : string( _string ) {}
+
+    /// return the WINDOW_SYMBOLS symbols starting at i, which must all lie within the string
+    ///
+    uint64 operator() (const uint64 i) const
+    {
+        // symbols straddling word boundaries are only supported if they divide the words evenly
+        if (32u % SYMBOL_SIZE)
+            return (*this)( i, WINDOW_SYMBOLS );
+
+        const storage_type words = string.stream();
+
+        const uint64 off   = uint64( string.index() ) + i;
+        const uint64 k     = off / STORAGE_SYMBOLS;
+        const uint32 shift = uint32( off % STORAGE_SYMBOLS ) * SYMBOL_SIZE;
+
+        const uint64 word = (uint64( words[k] ) << 32) | uint64( words[k+1] );
+
+        // when the window is not aligned, its last symbols lie in a third word
+        return shift ?
+            (word << shift) | (uint64( words[k+2] ) >> (32u - shift)) :
+            word;
+    }
+
+    /// return the n <= WINDOW_SYMBOLS symbols starting at i, padded with zeros
+    ///
+    uint64 operator() (const uint64 i, const uint32 n) const
+    {
+        uint64 word = 0u;
+        for (uint32 j = 0; j < n; ++j)
+            word |= uint64( string[i + j] ) << (64u - SYMBOL_SIZE - j*SYMBOL_SIZE);
+
+        return word;
+    }
+
+    string_type string;
+};
+
+/// A host-side functor comparing the first symbols of two suffixes of a string,
+/// 64 bits worth of symbols at a time.
+/// Unlike e.g. the AVX2 lookups of blocked_bloom_filter, no SIMD intrinsics are used here:
+/// each step compares a single pair of windows assembled from arbitrary, unaligned offsets
+/// of the packed string, and most comparisons are resolved within the first window.
+///
+template <uint32 SYMBOL_SIZE, typename string_type>
+struct host_suffix_compare
+{
+    typedef host_string_window<SYMBOL_SIZE,string_type> window_type;
+
+    static const uint32 WINDOW_SYMBOLS = window_type::WINDOW_SYMBOLS;
+
+    /// constructor
+    ///
+    host_suffix_compare(const uint64 _string_len, const string_type _string) :
+        string_len( _string_len ),
+        window( _string ) {}
+
+    /// compare the first max_len symbols of two suffixes, returning -1, 0 or +1;
+    /// a suffix shorter than max_len is smaller than all the suffixes it is a prefix of
+    ///
+    int operator() (const uint64 suffix_idx1, const uint64 suffix_idx2, const uint64 max_len) const
+    {
+        const uint64 suffix_len1 = string_len - suffix_idx1;
+        const uint64 suffix_len2 = string_len - suffix_idx2;
+        const uint64 n = nvbio::min( nvbio::min( suffix_len1, suffix_len2 ), max_len );
+
+        // compare all full windows
+        uint64 i = 0;
+        for (; i + WINDOW_SYMBOLS <= n; i += WINDOW_SYMBOLS)
+        {
+            const uint64 w1 = window( suffix_idx1 + i );
+            const uint64 w2 = window( suffix_idx2 + i );
+            if (w1 != w2)
+                return w1 < w2 ? -1 : 1;
+        }
+
+        // and the last, partial one
+        if (i < n)
+        {
+            const uint64 w1 = window( suffix_idx1 + i, uint32( n - i ) );
+            const uint64 w2 = window( suffix_idx2 + i, uint32( n - i ) );
+            if (w1 != w2)
+                return w1 < w2 ? -1 : 1;
+        }
+
+        if (n == max_len)
+            return 0;
+
+        // one of the suffixes is a prefix of the other
+        return suffix_len1 < suffix_len2 ? -1 :
+               suffix_len1 > suffix_len2 ?  1 : 0;
+    }
+
+    const uint64        string_len;
+    const window_type   window;
+};
+
+/// A host-side binary functor comparing two suffixes lexicographically
+///
+template <uint32 SYMBOL_SIZE, typename string_type>
+struct host_suffix_less
+{
+    /// constructor
+    ///
+    host_suffix_less(const uint64 _string_len, const string_type _string) :
+        compare( _string_len, _string ) {}
+
+    /// return true if the first suffix is lexicographically smaller than the second, false otherwise
+    ///
+    bool operator() (const uint32 suffix_idx1, const uint32 suffix_idx2) const
+    {
+        return compare( suffix_idx1, suffix_idx2, uint64(-1) ) < 0;
+    }
+
+    const host_suffix_compare<SYMBOL_SIZE,string_type> compare;
+};
+
+/// A host-side binary functor comparing two suffixes lexicographically using a Difference Cover Sample:
+/// at most Q symbols are compared, after which the order is resolved by a single lookup in the DCS ranks.
+/// This is the host counterpart of DCS_string_suffix_less, comparing 64-bit windows of symbols rather
+/// than 32-bit words with an embedded terminator.
+///
+template <uint32 SYMBOL_SIZE, typename string_type>
+struct DCS_host_suffix_less
+{
+    /// constructor
+    ///
+    DCS_host_suffix_less(
+        const uint64        _string_len,
+        const string_type   _string,
+        const DCSView       _dcs) :
+        compare( _string_len, _string ),
+        dcs( _dcs ) {}
+
+    /// return true if the first suffix is lexicographically smaller than the second, false otherwise
+    ///
+    bool operator() (const uint32 suffix_idx1, const uint32 suffix_idx2) const
+    {
+        if (suffix_idx1 == suffix_idx2)
+            return false;
+
+        const uint32 Q = dcs.Q;
+
+        // compare the first Q symbols; if either suffix is shorter, this is conclusive
+        const int c = compare( suffix_idx1, suffix_idx2, Q );
+        if (c)
+            return c < 0;
+
+        // lookup the smallest number l such that (i + l) and (j + l) are in the DCS
+        const uint32 l = dcs.lut[ (suffix_idx1 & (Q-1)) * Q + (suffix_idx2 & (Q-1)) ];
+
+        // and compare the ranks of the corresponding suffixes
+        return dcs.ranks[ dcs.index( suffix_idx1 + l ) ] < dcs.ranks[ dcs.index( suffix_idx2 + l ) ];
+    }
+
+    const host_suffix_compare<SYMBOL_SIZE,string_type> compare;
+    const DCSView                                      dcs;
+};
+
+/// A binary functor comparing the DCS samples by their first Q symbols
+///
+template <uint32 SYMBOL_SIZE, typename string_type>
+struct DCS_host_prefix_less
+{
+    /// constructor
+    ///
+    DCS_host_prefix_less(const uint64 _string_len, const string_type _string, const uint32 _Q) :
+        compare( _string_len, _string ), Q( _Q ) {}
+
+    /// return true if the first Q symbols of the first suffix are lexicographically smaller than
+    /// those of the second, false otherwise
+    ///
+    bool operator() (const uint32 suffix_idx1, const uint32 suffix_idx2) const
+    {
+        return compare( suffix_idx1, suffix_idx2, Q ) < 0;
+    }
+
+    const host_suffix_compare<SYMBOL_SIZE,string_type> compare;
+    const uint32                                       Q;
+};
+
+/// sort a host-side array using all threads: the array is split in one chunk per thread,
+/// the chunks are sorted independently and then merged pairwise
+///
+template <typename key_type, typename comp_type>
+void host_parallel_sort(const uint64 n, key_type* keys, const comp_type comp)
+{
+    const uint32 n_threads = uint32( omp_get_max_threads() );
+    if (n_threads == 1u || n < 64u*1024u)
+    {
+        std::sort( keys, keys + n, comp );
+        return;
+    }
+
+    const uint64 chunk_size = util::divide_ri( n, n_threads );
+
+    #pragma omp parallel for
+    for (int t = 0; t < int( n_threads ); ++t)
+    {
+        const uint64 begin = nvbio::min( t * chunk_size, n );
+        const uint64 end   = nvbio::min( begin + chunk_size, n );
+        std::sort( keys + begin, keys + end, comp );
+    }
+
+    for (uint64 width = chunk_size; width < n; width *= 2u)
+    {
+        const uint32 n_merges = uint32( util::divide_ri( n, 2u*width ) );
+
+        #pragma omp parallel for
+        for (int m = 0; m < int( n_merges ); ++m)
+        {
+            const uint64 begin = m * 2u * width;
+            const uint64 mid   = nvbio::min( begin + width, n );
+            const uint64 end   = nvbio::min( begin + 2u*width, n );
+            if (mid < end)
+                std::inplace_merge( keys + begin, keys + mid, keys + end, comp );
+        }
+    }
+}
+
+// split the sorted DCS samples in [begin,end) in groups of samples sharing the same key, assigning
+// to each sample the 1-based position of its group and appending the groups of two or more samples
+// to the output list
+//
+template <typename key_type>
+void DCS_host_rank_groups(
+    const uint32        begin,
+    const uint32        end,
+    const key_type*     keys,
+    const uint32*       samples,
+    const DCSView       dcs,
+          uint32*       ranks,
+    std::vector<uint2>& groups)
+{
+    for (uint32 group_begin = begin, group_end = begin; group_begin < end; group_begin = group_end)
+    {
+        for (group_end = group_begin + 1; group_end < end && keys[ group_end ] == keys[ group_begin ]; ++group_end) {}
+
+        for (uint32 i = group_begin; i < group_end; ++i)
+            ranks[ dcs.index( samples[i] ) ] = group_begin + 1u;
+
+        if (group_end - group_begin > 1u)
+            groups.push_back( make_uint2( group_begin, group_end ) );
+    }
+}
+
+} // namespace priv
+
+///@addtogroup Sufsort
+///@{
+
+/// build the difference cover sample of a given host-side string using the CPU only.
+///\par
+/// The sampled suffixes are first sorted by their leading Q symbols, after which the groups of
+/// tied samples are refined by prefix doubling: as the suffix Q positions after a sample is itself
+/// sampled, the rank of the former extends the sorted prefix from L to 2L symbols in a single
+/// lookup. Hence, the number of passes is logarithmic in the length of the longest repeat,
+/// rather than linear as with direct suffix comparisons.
+///
+/// \param dcs                      an initialized host-side DCS, whose ranks are computed
+/// \param string_len               the length of the given string
+/// \param string                   a host-side string
+/// \param params                   construction parameters
+///
+template <typename string_type>
+void host_blockwise_build(
+    HostDCS&                                dcs,
+    const typename string_type::index_type  string_len,
+    string_type                             string,
+    BWTParams*                              params)
+{
+    const uint32 SYMBOL_SIZE   = string_type::SYMBOL_SIZE;
+    const uint32 PARALLEL_SIZE = 256*1024;   // groups above this size are sorted by all threads
+
+    const uint32 Q = dcs.Q;
+    const uint32 N = dcs.N;
+
+    //
+    // build the list of DC sample suffixes
+    //
+
+    // as the DC table is sorted, the samples of each period are laid out in the same order
+    // as their positions, and DCSView::index() maps them to a contiguous range
+    const uint32 n_blocks = uint32( util::divide_ri( string_len, Q ) );
+
+    dcs.h_ranks.resize( n_blocks * N );
+    thrust::fill( dcs.h_ranks.begin(), dcs.h_ranks.end(), 0u );
+
+    std::vector<uint32> samples( n_blocks * N );
+
+    uint32 sample_size = 0u;
+    for (uint32 b = 0; b < n_blocks; ++b)
+    {
+        for (uint32 i = 0; i < N; ++i)
+        {
+            const uint64 suffix = uint64(b) * Q + dcs.h_dc[i];
+            if (suffix < string_len)
+                samples[ sample_size++ ] = uint32( suffix );
+        }
+    }
+    samples.resize( sample_size );
+
+    log_verbose(stderr,"  allocating DCS: %.1f MB\n", float(size_t( sample_size )*16u)/float(1024*1024));
+
+    const DCSView dcs_view = nvbio::plain_view( dcs );
+
+    uint32* ranks = nvbio::plain_view( dcs.h_ranks );
+
+    float sort_time   = 0.0f;
+    float refine_time = 0.0f;
+
+    std::vector<uint2> groups;
+    std::vector<uint2> next_groups;
+
+    // sort the samples by their first Q symbols
+    {
+        ScopedTimer<float> timer( &sort_time );
+
+        priv::host_parallel_sort(
+            sample_size,
+            &samples[0],
+            priv::DCS_host_prefix_less<SYMBOL_SIZE,string_type>( string_len, string, Q ) );
+
+        // and mark the beginning of each group of samples sharing the same prefix
+        std::vector<uint32> heads( sample_size );
+
+        const priv::host_suffix_compare<SYMBOL_SIZE,string_type> compare( string_len, string );
+
+        #pragma omp parallel for
+        for (int i = 0; i < int( sample_size ); ++i)
+            heads[i] = (i == 0 || compare( samples[i-1], samples[i], Q ) != 0) ? uint32(i) : 0u;
+
+        // turn the heads into group keys
+        for (uint32 i = 1; i < sample_size; ++i)
+            heads[i] = nvbio::max( heads[i], heads[i-1] );
+
+        priv::DCS_host_rank_groups( 0u, sample_size, &heads[0], &samples[0], dcs_view, ranks, groups );
+    }
+
+    log_verbose(stderr,"  sorted DCS prefixes (%u groups left)\n", uint32( groups.size() ));
+
+    // refine the groups of samples sharing the same leading h * Q symbols
+    std::vector<uint64> keys( sample_size );
+    std::vector<uint64> sort_temp;              // the radix sort ping-pong buffer for very large groups
+
+    HostSortEnactor sort_enactor;
+
+    const uint32 n_threads = uint32( omp_get_max_threads() );
+
+    std::vector< std::vector<uint2> > thread_groups( n_threads );
+
+    uint32 n_passes = 0u;
+    for (uint64 h = 1; groups.empty() == false; h *= 2u)
+    {
+        ScopedTimer<float> timer( &refine_time );
+
+        const uint32 n_groups = uint32( groups.size() );
+
+        // sort each group by the rank of the sample h * Q symbols ahead, reading the ranks
+        // assigned in the previous pass only: the sorting key is packed together with the
+        // sample in a single 64-bit word
+        #pragma omp parallel for schedule(dynamic,64)
+        for (int g = 0; g < int( n_groups ); ++g)
+        {
+            const uint32 begin = groups[g].x;
+            const uint32 end   = groups[g].y;
+            if (end - begin >= PARALLEL_SIZE)
+                continue;
+
+            for (uint32 i = begin; i < end; ++i)
+            {
+                const uint32 suffix = samples[i];
+                const uint64 key    = suffix + h * Q < string_len ? ranks[ dcs_view.index( suffix ) + h * N ] : 0u;
+                keys[i] = (key << 32) | suffix;
+            }
+            std::sort( &keys[0] + begin, &keys[0] + end );
+        }
+
+        // process very large groups one at a time using all threads
+        for (uint32 g = 0; g < n_groups; ++g)
+        {
+            const uint32 begin = groups[g].x;
+            const uint32 end   = groups[g].y;
+            if (end - begin < PARALLEL_SIZE)
+                continue;
+
+            #pragma omp parallel for
+            for (int i = int( begin ); i < int( end ); ++i)
+            {
+                const uint32 suffix = samples[i];
+                const uint64 key    = suffix + h * Q < string_len ? ranks[ dcs_view.index( suffix ) + h * N ] : 0u;
+                keys[i] = (key << 32) | suffix;
+            }
+
+            // the keys are plain integers: radix sort them
+            if (sort_temp.size() < end - begin)
+                sort_temp.resize( end - begin );
+
+            cuda::SortBuffers<uint64*> sort_buffers;
+            sort_buffers.keys[0] = &keys[0] + begin;
+            sort_buffers.keys[1] = &sort_temp[0];
+
+            sort_enactor.sort( end - begin, sort_buffers );
+
+            if (sort_buffers.selector)
+            {
+                #pragma omp parallel for
+                for (int i = 0; i < int( end - begin ); ++i)
+                    keys[ begin + i ] = sort_temp[i];
+            }
+        }
+
+        // now that all keys have been read, split the groups and assign the new ranks
+        #pragma omp parallel for schedule(dynamic,64)
+        for (int g = 0; g < int( n_groups ); ++g)
+        {
+            const uint32 begin = groups[g].x;
+            const uint32 end   = groups[g].y;
+
+            for (uint32 i = begin; i < end; ++i)
+            {
+                samples[i] = uint32( keys[i] );
+                keys[i]  >>= 32;
+            }
+
+            priv::DCS_host_rank_groups( begin, end, &keys[0], &samples[0], dcs_view, ranks, thread_groups[ omp_get_thread_num() ] );
+        }
+
+        next_groups.clear();
+        for (uint32 t = 0; t < n_threads; ++t)
+        {
+            next_groups.insert( next_groups.end(), thread_groups[t].begin(), thread_groups[t].end() );
+            thread_groups[t].clear();
+        }
+        groups.swap( next_groups );
+
+        ++n_passes;
+    }
+
+    // all samples are now sorted: turn the 1-based group positions into ranks
+    #pragma omp parallel for
+    for (int i = 0; i < int( sample_size ); ++i)
+        ranks[ dcs_view.index( samples[i] ) ] -= 1u;
+
+    log_verbose(stderr,"  DCS sort   : %.1fs\n", sort_time);
+    log_verbose(stderr,"  DCS refine : %.1fs (%u passes)\n", refine_time, n_passes);
+}
+
+/// Sort a list of suffixes of a given host-side string using the CPU only, the host
+/// counterpart of cuda::blockwise_suffix_sort().
+///\par
+/// The suffixes are bucketed by their leading symbols, and the buckets are gathered in blocks
+/// whose size is bounded by BWTParams::host_memory. The buckets of each block are then sorted
+/// in parallel, comparing at most Q symbols for each pair of suffixes followed by a lookup
+/// in the DCS ranks, so that the cost of each comparison is bounded even on highly repetitive
+/// strings. If no DCS is given, suffixes are compared in full.
+///
+/// \param string_len               the length of the given string
+/// \param string                   a host-side string
+/// \param n_suffixes               the number of suffixes to sort
+/// \param suffixes                 the suffixes to sort
+/// \param output                   the handler for the sorted suffixes, receiving host-side arrays
+/// \param dcs                      the host-side DCS, or NULL
+/// \param params                   construction parameters
+///
+template <typename string_type, typename suffix_iterator, typename output_handler>
+void host_blockwise_suffix_sort(
+    const typename string_type::index_type  string_len,
+    string_type                             string,
+    const typename string_type::index_type  n_suffixes,
+    suffix_iterator                         suffixes,
+    output_handler&                         output,
+    const HostDCS*                          dcs,
+    BWTParams*                              params)
+{
+    const uint32 SYMBOL_SIZE    = string_type::SYMBOL_SIZE;
+    const uint32 BUCKETING_BITS = 16u;
+    const uint32 N_BUCKETS      = 1u << BUCKETING_BITS;
+    const uint32 PARALLEL_SIZE  = 256*1024;     // buckets above this size are sorted by all threads
+
+    typedef priv::host_string_window<SYMBOL_SIZE,string_type> window_type;
+
+    const window_type window( string );
+    const uint32      WINDOW_SYMBOLS = window_type::WINDOW_SYMBOLS;
+
+    const uint64 dcs_memory = dcs ? dcs->allocated_host_memory() : 0u;
+
+    const uint32 max_block_size = uint32( nvbio::min(             // requires max_block_size*4 host memory bytes
+        uint64( params && params->host_memory > dcs_memory + 128u*1024u*1024u ?
+            (params->host_memory - dcs_memory - 128u*1024u*1024u) / 4u :
+            512*1024*1024 ),
+        uint64( n_suffixes ) ) );
+
+    // split the suffixes in one chunk per thread; the chunks are assigned to the threads
+    // actually running each parallel region, which might be fewer than requested
+    const uint32 n_chunks   = uint32( omp_get_max_threads() );
+    const uint32 chunk_size = uint32( util::divide_ri( n_suffixes, n_chunks ) );
+
+    float bucket_time = 0.0f;
+    float gather_time = 0.0f;
+    float sort_time   = 0.0f;
+
+    //
+    // count the number of suffixes in each bucket, keeping separate counts for each chunk
+    // of suffixes so that the gathering can later proceed in parallel without conflicts
+    //
+
+    std::vector<uint32> chunk_buckets( n_chunks * N_BUCKETS, 0u );
+    std::vector<uint32> buckets( N_BUCKETS, 0u );
+    {
+        ScopedTimer<float> timer( &bucket_time );
+
+        #pragma omp parallel num_threads( n_chunks )
+        {
+            const uint32 tid       = omp_get_thread_num();
+            const uint32 n_threads = omp_get_num_threads();
+
+            for (uint32 c = tid; c < n_chunks; c += n_threads)
+            {
+                const uint32 chunk_begin = nvbio::min( c * chunk_size, uint32( n_suffixes ) );
+                const uint32 chunk_end   = nvbio::min( chunk_begin + chunk_size, uint32( n_suffixes ) );
+
+                uint32* counts = &chunk_buckets[ c * N_BUCKETS ];
+
+                for (uint32 i = chunk_begin; i < chunk_end; ++i)
+                {
+                    const uint64 suffix = suffixes[i];
+                    const uint64 n      = uint64( string_len - suffix );
+                    const uint32 bucket = uint32( (n >= WINDOW_SYMBOLS ? window( suffix ) : window( suffix, uint32( n ) )) >> (64u - BUCKETING_BITS) );
+
+                    ++counts[ bucket ];
+                }
+            }
+        }
+
+        for (uint32 c = 0; c < n_chunks; ++c)
+            for (uint32 b = 0; b < N_BUCKETS; ++b)
+                buckets[b] += chunk_buckets[ c * N_BUCKETS + b ];
+    }
+
+    std::vector<uint32> block;
+    std::vector<uint32> offsets( N_BUCKETS + 1u );
+    std::vector<uint32> chunk_offsets( n_chunks * N_BUCKETS );
+
+    uint64 suffix_count = 0u;
+
+    for (uint32 bucket_begin = 0, bucket_end = 0; bucket_begin < N_BUCKETS; bucket_begin = bucket_end)
+    {
+        // collect as many buckets as fit in a block, and at least one
+        uint32 block_size = 0u;
+        for (bucket_end = bucket_begin; bucket_end < N_BUCKETS; ++bucket_end)
+        {
+            if (block_size && block_size + buckets[ bucket_end ] > max_block_size)
+                break;
+
+            offsets[ bucket_end ] = block_size;
+            block_size += buckets[ bucket_end ];
+        }
+        offsets[ bucket_end ] = block_size;
+
+        if (block_size == 0u)
+            continue;
+
+        log_verbose(stderr,"\r  sufsort buckets[%u:%u] (%u suffixes)        ", bucket_begin, bucket_end, block_size);
+
+        priv::alloc_storage( block, block_size );
+
+        // gather the suffixes falling in the selected buckets, chunk by chunk
+        {
+            ScopedTimer<float> timer( &gather_time );
+
+            for (uint32 b = bucket_begin; b < bucket_end; ++b)
+            {
+                uint32 offset = offsets[b];
+                for (uint32 c = 0; c < n_chunks; ++c)
+                {
+                    chunk_offsets[ c * N_BUCKETS + b ] = offset;
+                    offset += chunk_buckets[ c * N_BUCKETS + b ];
+                }
+            }
+
+            #pragma omp parallel num_threads( n_chunks )
+            {
+                const uint32 tid       = omp_get_thread_num();
+                const uint32 n_threads = omp_get_num_threads();
+
+                for (uint32 c = tid; c < n_chunks; c += n_threads)
+                {
+                    const uint32 chunk_begin = nvbio::min( c * chunk_size, uint32( n_suffixes ) );
+                    const uint32 chunk_end   = nvbio::min( chunk_begin + chunk_size, uint32( n_suffixes ) );
+
+                    uint32* slots = &chunk_offsets[ c * N_BUCKETS ];
+
+                    for (uint32 i = chunk_begin; i < chunk_end; ++i)
+                    {
+                        const uint64 suffix = suffixes[i];
+                        const uint64 n      = uint64( string_len - suffix );
+                        const uint32 bucket = uint32( (n >= WINDOW_SYMBOLS ? window( suffix ) : window( suffix, uint32( n ) )) >> (64u - BUCKETING_BITS) );
+
+                        if (bucket >= bucket_begin && bucket < bucket_end)
+                            block[ slots[ bucket ]++ ] = uint32( suffix );
+                    }
+                }
+            }
+        }
+
+        // sort the buckets
+        {
+            ScopedTimer<float> timer( &sort_time );
+
+            if (dcs)
+            {
+                const priv::DCS_host_suffix_less<SYMBOL_SIZE,string_type> less( string_len, string, nvbio::plain_view( *dcs ) );
+
+                // sort very large buckets one at a time using all threads
+                for (uint32 b = bucket_begin; b < bucket_end; ++b)
+                {
+                    if (buckets[b] >= PARALLEL_SIZE)
+                        priv::host_parallel_sort( buckets[b], &block[0] + offsets[b], less );
+                }
+
+                // and all the others in parallel, one per thread
+                #pragma omp parallel for schedule(dynamic,16)
+                for (int b = int( bucket_begin ); b < int( bucket_end ); ++b)
+                {
+                    if (buckets[b] > 1u && buckets[b] < PARALLEL_SIZE)
+                        std::sort( &block[0] + offsets[b], &block[0] + offsets[b+1], less );
+                }
+            }
+            else
+            {
+                const priv::host_suffix_less<SYMBOL_SIZE,string_type> less( string_len, string );
+
+                for (uint32 b = bucket_begin; b < bucket_end; ++b)
+                {
+                    if (buckets[b] >= PARALLEL_SIZE)
+                        priv::host_parallel_sort( buckets[b], &block[0] + offsets[b], less );
+                }
+
+                #pragma omp parallel for schedule(dynamic,16)
+                for (int b = int( bucket_begin ); b < int( bucket_end ); ++b)
+                {
+                    if (buckets[b] > 1u && buckets[b] < PARALLEL_SIZE)
+                        std::sort( &block[0] + offsets[b], &block[0] + offsets[b+1], less );
+                }
+            }
+        }
+
+        // process the sorted block
+        output.process_batch(
+            block_size,
+            &block[0] );
+
+        suffix_count += block_size;
+    }
+
+    const float total_time = bucket_time + gather_time + sort_time;
+
+    log_verbose(stderr,"\r  sufsort : %.1fs (%.1f M suffixes/s)                     \n", total_time, 1.0e-6f*float(suffix_count)/total_time);
+    log_verbose(stderr,"    bucket : %.1fs\n", bucket_time);
+    log_verbose(stderr,"    gather : %.1fs\n", gather_time);
+    log_verbose(stderr,"    sort   : %.1fs\n", sort_time);
+}
+
+///@}
+
+} // namespace nvbio
@@ -0,0 +1,386 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/sufsort/sufsort_priv.h>
+#include <nvbio/strings/string_set.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/omp.h>
+#include <vector>
+#include <algorithm>
+
+namespace nvbio {
+namespace priv {
+
+///
+/// A host-side sorter for the suffixes of a string-set, the CPU counterpart of cuda::CompressionSort.
+///\par
+/// Suffixes are represented as packed words of WORD_BITS bits, each holding up to SYMBOLS_PER_WORD
+/// symbols plus DOLLAR_BITS bits encoding the position of the terminator, if any.
+/// The sorter proceeds MSD-first one word at a time: the first word of all suffixes is sorted with
+/// a multi-threaded LSD radix sort, after which only the groups of suffixes which are still tied
+/// are kept active and refined with the following words. Groups whose shared word contains the
+/// terminator are made of identical suffixes, and are ordered by string index, which is the same
+/// ordering produced by the stable GPU sorter on suffixes collected in string order.
+/// As every suffix is terminated, the number of refinement passes is bounded by the length of the
+/// longest string divided by SYMBOLS_PER_WORD, and no Difference Cover Sample is needed to break ties.
+///
+/// \tparam SYMBOL_SIZE         the number of bits per symbol
+/// \tparam string_set_type     the host-side string-set type
+///
+template <uint32 SYMBOL_SIZE, typename string_set_type>
+struct HostSetSuffixSorter
+{
+    static const uint32 WORD_BITS        = 32u;
+    static const uint32 DOLLAR_BITS      = 4u;
+    static const uint32 DOLLAR_MASK      = (1u << DOLLAR_BITS) - 1u;
+    static const uint32 RADIX_BITS       = 8u;
+    static const uint32 RADIX_BUCKETS    = 1u << RADIX_BITS;
+    static const uint32 INSERTION_SIZE   = 32u;     ///< groups below this size are sorted by insertion
+    static const uint32 PARALLEL_SIZE    = 256*1024; ///< groups above this size are sorted by all threads
+
+    typedef local_set_suffix_word_functor<SYMBOL_SIZE,WORD_BITS,DOLLAR_BITS,string_set_type,uint32> word_functor_type;
+
+    /// constructor
+    ///
+    HostSetSuffixSorter(const string_set_type string_set) :
+        m_string_set( string_set ),
+        extract_time( 0.0f ),
+        radixsort_time( 0.0f ),
+        refine_time( 0.0f ),
+        n_passes( 0u ) {}
+
+    /// reserve enough storage to sort the given number of suffixes
+    ///
+    void reserve(const uint32 n_suffixes)
+    {
+        alloc_storage( m_keys,          n_suffixes );
+        alloc_storage( m_temp_keys,     n_suffixes );
+        alloc_storage( m_temp_suffixes, n_suffixes );
+    }
+
+    /// sort a list of suffixes in place
+    ///
+    /// \param n_suffixes       the number of suffixes
+    /// \param suffixes         the (string-offset, string-id) pairs identifying the suffixes
+    ///
+    void sort(const uint32 n_suffixes, uint2* suffixes)
+    {
+        if (n_suffixes <= 1u)
+            return;
+
+        reserve( n_suffixes );
+
+        m_suffixes = suffixes;
+
+        // sort all suffixes by their first word
+        {
+            ScopedTimer<float> timer( &extract_time );
+            extract( 0u, n_suffixes, 0u );
+        }
+        {
+            ScopedTimer<float> timer( &radixsort_time );
+            radix_sort( 0u, n_suffixes, true );
+        }
+
+        std::vector<uint2> segments;
+        std::vector<uint2> next_segments;
+
+        // find the initial groups of tied suffixes
+        {
+            ScopedTimer<float> timer( &refine_time );
+            find_groups( 0u, n_suffixes, segments );
+        }
+
+        // and keep refining them with the following words
+        for (uint32 w = 1; segments.empty() == false; ++w)
+        {
+            ScopedTimer<float> timer( &refine_time );
+
+            next_segments.clear();
+
+            refine( w, segments, next_segments );
+
+            segments.swap( next_segments );
+            n_passes = nvbio::max( n_passes, w );
+        }
+    }
+
+    /// return the amount of used host memory
+    ///
+    uint64 allocated_host_memory() const
+    {
+        return
+            m_keys.size()          * sizeof(uint32) +
+            m_temp_keys.size()     * sizeof(uint32) +
+            m_temp_suffixes.size() * sizeof(uint2);
+    }
+
+private:
+    // compare two suffixes by their string index, used to order identical suffixes
+    //
+    struct string_id_less
+    {
+        bool operator() (const uint2 a, const uint2 b) const { return a.y < b.y; }
+    };
+
+    // extract the w-th word of the suffixes in [begin,end)
+    //
+    void extract(const uint32 begin, const uint32 end, const uint32 w)
+    {
+        const word_functor_type word_functor( m_string_set, w );
+
+        #pragma omp parallel for if (end - begin >= PARALLEL_SIZE)
+        for (int i = int( begin ); i < int( end ); ++i)
+            m_keys[i] = word_functor( m_suffixes[i] );
+    }
+
+    // sort the suffixes in [begin,end) by their current key, using either all threads or just
+    // the calling one
+    //
+    void radix_sort(const uint32 begin, const uint32 end, const bool parallel)
+    {
+        const uint32 n = end - begin;
+        if (n <= INSERTION_SIZE)
+        {
+            insertion_sort( begin, end );
+            return;
+        }
+
+        const uint32 n_chunks   = parallel ? uint32( omp_get_max_threads() ) : 1u;
+        const uint32 chunk_size = util::divide_ri( n, n_chunks );
+
+        // use a stack-allocated histogram in the serial case, as this is called on many small groups
+        uint32              local_histogram[ RADIX_BUCKETS ];
+        std::vector<uint32> chunk_histograms( n_chunks > 1 ? n_chunks * RADIX_BUCKETS : 0u );
+        uint32* histograms = n_chunks > 1 ? &chunk_histograms[0] : local_histogram;
+
+        uint32* keys_src = &m_keys[begin];
+        uint32* keys_dst = &m_temp_keys[begin];
+        uint2*  sufs_src = m_suffixes + begin;
+        uint2*  sufs_dst = &m_temp_suffixes[begin];
+
+        for (uint32 shift = 0; shift < WORD_BITS; shift += RADIX_BITS)
+        {
+            // build the per-chunk histograms
+            if (n_chunks > 1)
+            {
+                // the runtime might grant fewer threads than requested: loop each of them over
+                // the chunks, so that all of them get processed
+                #pragma omp parallel num_threads( n_chunks )
+                {
+                    const uint32 tid  = omp_get_thread_num();
+                    const uint32 team = omp_get_num_threads();
+
+                    for (uint32 chunk = tid; chunk < n_chunks; chunk += team)
+                    {
+                        const uint32 chunk_begin = nvbio::min( chunk * chunk_size, n );
+                        const uint32 chunk_end   = nvbio::min( chunk_begin + chunk_size, n );
+
+                        histogram( keys_src, chunk_begin, chunk_end, shift, histograms + chunk * RADIX_BUCKETS );
+                    }
+                }
+            }
+            else
+                histogram( keys_src, 0u, n, shift, histograms );
+
+            // scan them digit-major, so that each chunk is scattered stably; digits
+            // shared by all keys are skipped altogether
+            uint32 offset = 0u;
+            bool   skip   = false;
+            for (uint32 d = 0; d < RADIX_BUCKETS; ++d)
+            {
+                const uint32 offset_d = offset;
+                for (uint32 t = 0; t < n_chunks; ++t)
+                {
+                    const uint32 count = histograms[ t * RADIX_BUCKETS + d ];
+                    histograms[ t * RADIX_BUCKETS + d ] = offset;
+                    offset += count;
+                }
+                if (offset - offset_d == n)
+                    skip = true;
+            }
+            if (skip)
+                continue;
+
+            // scatter the keys and suffixes
+            if (n_chunks > 1)
+            {
+                #pragma omp parallel num_threads( n_chunks )
+                {
+                    const uint32 tid  = omp_get_thread_num();
+                    const uint32 team = omp_get_num_threads();
+
+                    for (uint32 chunk = tid; chunk < n_chunks; chunk += team)
+                    {
+                        const uint32 chunk_begin = nvbio::min( chunk * chunk_size, n );
+                        const uint32 chunk_end   = nvbio::min( chunk_begin + chunk_size, n );
+
+                        scatter( keys_src, sufs_src, chunk_begin, chunk_end, shift, histograms + chunk * RADIX_BUCKETS, keys_dst, sufs_dst );
+                    }
+                }
+            }
+            else
+                scatter( keys_src, sufs_src, 0u, n, shift, histograms, keys_dst, sufs_dst );
+
+            std::swap( keys_src, keys_dst );
+            std::swap( sufs_src, sufs_dst );
+        }
+
+        // copy the results back if they ended up in the temporary buffers
+        if (keys_src != &m_keys[begin])
+        {
+            #pragma omp parallel for if (n_chunks > 1)
+            for (int i = 0; i < int( n ); ++i)
+            {
+                keys_dst[i] = keys_src[i];
+                sufs_dst[i] = sufs_src[i];
+            }
+        }
+    }
+
+    // count the digits of a chunk of keys
+    //
+    static void histogram(const uint32* keys, const uint32 begin, const uint32 end, const uint32 shift, uint32* histo)
+    {
+        for (uint32 d = 0; d < RADIX_BUCKETS; ++d)
+            histo[d] = 0u;
+
+        for (uint32 i = begin; i < end; ++i)
+            ++histo[ (keys[i] >> shift) & (RADIX_BUCKETS-1) ];
+    }
+
+    // scatter a chunk of keys and suffixes to their slots
+    //
+    static void scatter(
+        const uint32*   keys_src,
+        const uint2*    sufs_src,
+        const uint32    begin,
+        const uint32    end,
+        const uint32    shift,
+              uint32*   offsets,
+              uint32*   keys_dst,
+              uint2*    sufs_dst)
+    {
+        for (uint32 i = begin; i < end; ++i)
+        {
+            const uint32 slot = offsets[ (keys_src[i] >> shift) & (RADIX_BUCKETS-1) ]++;
+            keys_dst[ slot ] = keys_src[i];
+            sufs_dst[ slot ] = sufs_src[i];
+        }
+    }
+
+    // sort the suffixes in [begin,end) by their current key with a stable insertion sort
+    //
+    void insertion_sort(const uint32 begin, const uint32 end)
+    {
+        for (uint32 i = begin + 1; i < end; ++i)
+        {
+            const uint32 key    = m_keys[i];
+            const uint2  suffix = m_suffixes[i];
+
+            uint32 j = i;
+            for (; j > begin && m_keys[j-1] > key; --j)
+            {
+                m_keys[j]     = m_keys[j-1];
+                m_suffixes[j] = m_suffixes[j-1];
+            }
+            m_keys[j]     = key;
+            m_suffixes[j] = suffix;
+        }
+    }
+
+    // scan the sorted keys in [begin,end) for groups of tied suffixes: groups whose key contains
+    // the terminator are resolved immediately, while all others are appended to the output list
+    //
+    void find_groups(const uint32 begin, const uint32 end, std::vector<uint2>& groups)
+    {
+        for (uint32 group_begin = begin, group_end = begin; group_begin < end; group_begin = group_end)
+        {
+            const uint32 key = m_keys[ group_begin ];
+
+            for (group_end = group_begin + 1; group_end < end && m_keys[ group_end ] == key; ++group_end) {}
+
+            if (group_end - group_begin > 1u)
+            {
+                if ((key & DOLLAR_MASK) == DOLLAR_MASK)
+                    groups.push_back( make_uint2( group_begin, group_end ) );
+                else
+                    std::sort( m_suffixes + group_begin, m_suffixes + group_end, string_id_less() );
+            }
+        }
+    }
+
+    // refine a list of groups of tied suffixes with their w-th word
+    //
+    void refine(const uint32 w, const std::vector<uint2>& groups, std::vector<uint2>& next_groups)
+    {
+        const uint32 n_groups = uint32( groups.size() );
+
+        // process very large groups one at a time using all threads
+        for (uint32 i = 0; i < n_groups; ++i)
+        {
+            if (groups[i].y - groups[i].x >= PARALLEL_SIZE)
+            {
+                extract( groups[i].x, groups[i].y, w );
+                radix_sort( groups[i].x, groups[i].y, true );
+                find_groups( groups[i].x, groups[i].y, next_groups );
+            }
+        }
+
+        // and all the others in parallel, one per thread
+        const uint32 n_threads = omp_get_max_threads();
+
+        std::vector< std::vector<uint2> > thread_groups( n_threads );
+
+        #pragma omp parallel for schedule(dynamic,64)
+        for (int i = 0; i < int( n_groups ); ++i)
+        {
+            const uint32 begin = groups[i].x;
+            const uint32 end   = groups[i].y;
+            if (end - begin >= PARALLEL_SIZE)
+                continue;
+
+            const word_functor_type word_functor( m_string_set, w );
+            for (uint32 j = begin; j < end; ++j)
+                m_keys[j] = word_functor( m_suffixes[j] );
+
+            radix_sort( begin, end, false );
+            find_groups( begin, end, thread_groups[ omp_get_thread_num() ] );
+        }
+
+        for (uint32 t = 0; t < n_threads; ++t)
+            next_groups.insert( next_groups.end(), thread_groups[t].begin(), thread_groups[t].end() );
+    }
+
+    string_set_type                 m_string_set;
+    uint2*                          m_suffixes;
+    std::vector<uint32>             m_keys;
+    std::vector<uint32>             m_temp_keys;
+    std::vector<uint2>              m_temp_suffixes;
+
+public:
+    float                           extract_time;
+    float                           radixsort_time;
+    float                           refine_time;
+    uint32                          n_passes;
+};
+
+} // namespace priv
+} // namespace nvbio
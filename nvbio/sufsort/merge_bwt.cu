@@ -0,0 +1,368 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include <nvbio/sufsort/merge_bwt.h>
+#include <nvbio/fmindex/bwt.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/atomics.h>
+#include <nvbio/basic/omp.h>
+#include <algorithm>
+
+namespace nvbio {
+
+namespace { // anonymous namespace
+
+// the number of merged symbols passed to the output handler at once
+//
+const uint32 MERGE_BATCH_SIZE = 16u*1024u*1024u;
+
+// the number of interleaved walks advanced by each thread when computing the insertion points
+//
+const uint32 MERGE_WALKERS = 16u;
+
+// return the first row q of bwt2 whose merged position q + ins[q] is greater than or equal to pos
+//
+uint64 merged_lower_bound(const uint64* ins, const uint64 n, const uint64 pos)
+{
+    uint64 lo = 0, hi = n;
+    while (lo < hi)
+    {
+        const uint64 mid = (lo + hi) / 2;
+        if (mid + ins[mid] < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// return the index of the first dollar at a position greater than or equal to i
+//
+uint32 dollar_lower_bound(const std::vector<HostSetBWT::dollar_type>& dollars, const uint64 i)
+{
+    return uint32( std::lower_bound(
+        dollars.begin(),
+        dollars.end(),
+        std::make_pair( i, uint32(0) ) ) - dollars.begin() );
+}
+
+} // anonymous namespace
+
+// resize the packed string to hold n symbols
+//
+void HostSetBWT::resize(const uint64 n)
+{
+    bwt.resize( util::divide_ri( n, SYMBOLS_PER_WORD ) + 1u );
+    n_symbols = n;
+}
+
+// build the occurrence table and the symbol counts needed by rank() and LF(),
+// processing the BWT in parallel over partitions
+//
+void HostSetBWT::build_rank_dictionary()
+{
+    const uint64 n_blocks = util::divide_ri( n_symbols, OCC_INTERVAL ) + 1u;
+
+    occ.resize( n_blocks * 4u );
+    dollar_mask.resize( n_blocks );
+
+    const word_type* words = nvbio::raw_pointer( bwt );
+          uint64*    occ_p = nvbio::raw_pointer( occ );
+
+    // first pass: count the symbols in each block
+    #pragma omp parallel for
+    for (int64 k = 0; k < int64( n_blocks ); ++k)
+    {
+        uint64 counts[4] = { 0u, 0u, 0u, 0u };
+
+        const uint64 begin = uint64(k) * OCC_INTERVAL;
+        const uint64 end   = nvbio::min( begin + OCC_INTERVAL, n_symbols );
+
+        for (uint64 i = begin; i < end; i += SYMBOLS_PER_WORD)
+        {
+            const word_type word    = words[ i / SYMBOLS_PER_WORD ];
+            const uint32    n_valid = uint32( nvbio::min( uint64(SYMBOLS_PER_WORD), end - i ) );
+
+            for (uint32 j = 0; j < n_valid; ++j)
+                ++counts[ (word >> (30u - j*2u)) & 3u ];
+        }
+        for (uint32 c = 0; c < 4; ++c)
+            occ_p[ k*4 + c ] = counts[c];
+    }
+
+    // second pass: turn the block counts into exclusive prefix sums, in parallel over partitions
+    const uint32 n_partitions = uint32( nvbio::min( uint64( omp_get_max_threads() ) * 4u, n_blocks ) );
+    const uint64 part_size    = util::divide_ri( n_blocks, n_partitions );
+
+    std::vector<uint64> part_counts( (n_partitions + 1u) * 4u, 0u );
+
+    #pragma omp parallel for
+    for (int p = 0; p < int( n_partitions ); ++p)
+    {
+        const uint64 begin = nvbio::min( uint64(p) * part_size, n_blocks );
+        const uint64 end   = nvbio::min( begin + part_size,     n_blocks );
+
+        for (uint64 k = begin; k < end; ++k)
+            for (uint32 c = 0; c < 4; ++c)
+                part_counts[ (p+1)*4 + c ] += occ_p[ k*4 + c ];
+    }
+    for (uint32 p = 1; p <= n_partitions; ++p)
+        for (uint32 c = 0; c < 4; ++c)
+            part_counts[ p*4 + c ] += part_counts[ (p-1)*4 + c ];
+
+    #pragma omp parallel for
+    for (int p = 0; p < int( n_partitions ); ++p)
+    {
+        const uint64 begin = nvbio::min( uint64(p) * part_size, n_blocks );
+        const uint64 end   = nvbio::min( begin + part_size,     n_blocks );
+
+        uint64 counters[4];
+        for (uint32 c = 0; c < 4; ++c)
+            counters[c] = part_counts[ p*4 + c ];
+
+        for (uint64 k = begin; k < end; ++k)
+        {
+            for (uint32 c = 0; c < 4; ++c)
+            {
+                const uint64 cnt = occ_p[ k*4 + c ];
+                occ_p[ k*4 + c ] = counters[c];
+                counters[c] += cnt;
+            }
+        }
+    }
+
+    // build the dollar masks, and remove the dollars preceding each block from its DOLLAR_SYMBOL counter
+    {
+        uint64* mask_p = nvbio::raw_pointer( dollar_mask );
+
+        uint32 d = 0;
+        for (uint64 k = 0; k < n_blocks; ++k)
+        {
+            occ_p[ k*4 + DOLLAR_SYMBOL ] -= d;
+
+            uint64 mask = 0u;
+            for (; d < n_strings() && dollars[d].first < (k+1) * OCC_INTERVAL; ++d)
+                mask |= uint64(1u) << (dollars[d].first & (OCC_INTERVAL-1));
+
+            mask_p[k] = mask;
+        }
+    }
+
+    // build the C table, excluding the dollars from the count of DOLLAR_SYMBOL
+    {
+        const uint64* totals = &part_counts[ n_partitions*4 ];
+
+        C[0] = n_strings();
+        for (uint32 c = 0; c < 4; ++c)
+            C[c+1] = C[c] + totals[c] - (c == DOLLAR_SYMBOL ? n_strings() : 0u);
+
+        if (C[4] != n_symbols)
+            throw nvbio::runtime_error("HostSetBWT::build_rank_dictionary() : inconsistent symbol counts (%llu != %llu)", C[4], n_symbols);
+    }
+
+    gen_bwt_count_table( count_table );
+}
+
+// merge the BWTs of two string sets into the BWT of their union
+//
+void merge_bwt(
+    HostSetBWT&         bwt1,
+    HostSetBWT&         bwt2,
+    BaseBWTHandler&     output)
+{
+    typedef HostSetBWT::dollar_type dollar_type;
+
+    const uint64 n1 = bwt1.size();
+    const uint64 n2 = bwt2.size();
+    const uint32 m1 = bwt1.n_strings();
+    const uint32 m2 = bwt2.n_strings();
+
+    log_verbose(stderr, "  merging BWTs (%llu + %llu symbols, %u + %u strings)\n", n1, n2, m1, m2);
+
+    Timer timer;
+    timer.start();
+
+    // build the rank dictionaries of both inputs
+    bwt1.build_rank_dictionary();
+    bwt2.build_rank_dictionary();
+
+    timer.stop();
+    const float rank_time = timer.seconds();
+
+    timer.start();
+
+    // walk all strings of the second set backwards in both BWTs, recording for each row of bwt2
+    // the number of rows of bwt1 preceding it in the merged order;
+    // the empty suffixes of the second set follow all those of the first set, as their string
+    // ids are larger, and LF() preserves this relative order for all longer suffixes.
+    nvbio::vector<host_tag,uint64> ins( n2 );
+    uint64* ins_p = nvbio::raw_pointer( ins );
+
+    uint32 malformed = 0u;      // set by any thread detecting an inconsistency
+
+    // each thread advances a group of walks in lockstep, prefetching the data needed by
+    // the next step of each walk while the others are being processed
+    const uint32 n_groups = util::divide_ri( m2, MERGE_WALKERS );
+
+    #pragma omp parallel for schedule(dynamic,16)
+    for (int g = 0; g < int( n_groups ); ++g)
+    {
+        uint64 p[ MERGE_WALKERS ];
+        uint64 q[ MERGE_WALKERS ];
+
+        const uint32 k_begin  = g * MERGE_WALKERS;
+              uint32 n_active = nvbio::min( MERGE_WALKERS, m2 - k_begin );
+
+        for (uint32 w = 0; w < n_active; ++w)
+        {
+            q[w] = k_begin + w;
+            p[w] = m1;
+        }
+
+        for (uint64 steps = 0; n_active; ++steps)
+        {
+            // a well-formed BWT always cycles back to a dollar within n2 steps
+            if (steps > n2)
+            {
+                host_atomic_add( &malformed, 1u );
+                break;
+            }
+
+            for (uint32 w = 0; w < n_active; ++w)
+            {
+                ins_p[ q[w] ] = p[w];
+
+                const uint8 c = bwt2[ q[w] ];
+                if (c == HostSetBWT::DOLLAR_SYMBOL && bwt2.is_dollar( q[w] ))
+                {
+                    // retire this walk, replacing it with the last active one
+                    --n_active;
+                    p[w] = p[ n_active ];
+                    q[w] = q[ n_active ];
+                    --w;
+                    continue;
+                }
+
+                p[w] = bwt1.LF( p[w], c );
+                q[w] = bwt2.LF( q[w], c );
+
+                if (q[w] >= n2 || p[w] > n1)
+                {
+                    host_atomic_add( &malformed, 1u );
+                    n_active  = 0;
+                    break;
+                }
+
+                prefetch( bwt1.rank_dict(), p[w] - 1u );
+                prefetch( bwt2.rank_dict(), q[w] - 1u );
+                prefetch( bwt2.rank_dict(), q[w] );
+            }
+        }
+    }
+    if (malformed)
+        throw nvbio::runtime_error("merge_bwt() : malformed input BWT");
+
+    timer.stop();
+    const float walk_time = timer.seconds();
+
+    timer.start();
+
+    // interleave the two BWTs in batches, in parallel over partitions of each batch
+    const uint64 n = n1 + n2;
+
+    std::vector<uint8> h_bwt( nvbio::min( n, uint64( MERGE_BATCH_SIZE ) ) );
+    std::vector<uint2> h_suffixes( h_bwt.size() );
+
+    const uint32 n_partitions = uint32( omp_get_max_threads() ) * 4u;
+
+    for (uint64 batch_begin = 0; batch_begin < n; batch_begin += MERGE_BATCH_SIZE)
+    {
+        const uint64 batch_end  = nvbio::min( batch_begin + MERGE_BATCH_SIZE, n );
+        const uint32 batch_size = uint32( batch_end - batch_begin );
+        const uint32 part_size  = util::divide_ri( batch_size, n_partitions );
+
+        #pragma omp parallel for
+        for (int p = 0; p < int( n_partitions ); ++p)
+        {
+            const uint64 begin = batch_begin + nvbio::min( uint64(p) * part_size, uint64( batch_size ) );
+            const uint64 end   = nvbio::min( begin + part_size, batch_end );
+            if (begin >= end)
+                continue;
+
+            // find the first row of each BWT falling in this partition
+            uint64 q = merged_lower_bound( ins_p, n2, begin );
+            uint64 i = begin - q;
+
+            // and the first dollar of each BWT at or after those rows
+            uint32 d1 = dollar_lower_bound( bwt1.dollars, i );
+            uint32 d2 = dollar_lower_bound( bwt2.dollars, q );
+
+            for (uint64 pos = begin; pos < end; ++pos)
+            {
+                const uint32 out = uint32( pos - batch_begin );
+
+                if (q < n2 && q + ins_p[q] == pos)
+                {
+                    // the next row comes from the second set
+                    if (d2 < m2 && bwt2.dollars[d2].first == q)
+                    {
+                        h_bwt[ out ]        = 255u;
+                        h_suffixes[ out ]   = make_uint2( 0u, m1 + bwt2.dollars[d2].second );
+                        ++d2;
+                    }
+                    else
+                        h_bwt[ out ] = bwt2[q];
+
+                    ++q;
+                }
+                else
+                {
+                    // the next row comes from the first set
+                    if (d1 < m1 && bwt1.dollars[d1].first == i)
+                    {
+                        h_bwt[ out ]        = 255u;
+                        h_suffixes[ out ]   = make_uint2( 0u, bwt1.dollars[d1].second );
+                        ++d1;
+                    }
+                    else
+                        h_bwt[ out ] = bwt1[i];
+
+                    ++i;
+                }
+            }
+        }
+
+        output.process(
+            batch_size,
+            &h_bwt[0],
+            NULL,
+            &h_suffixes[0],
+            NULL,
+            NULL );
+    }
+
+    timer.stop();
+    const float merge_time = timer.seconds();
+
+    log_verbose(stderr, "    rank dictionaries : %.2fs\n", rank_time);
+    log_verbose(stderr, "    insertion walk    : %.2fs (%.1f M symbols/s)\n", walk_time, 1.0e-6f * float(n2) / walk_time);
+    log_verbose(stderr, "    interleaving      : %.2fs (%.1f M symbols/s)\n", merge_time, 1.0e-6f * float(n) / merge_time);
+}
+
+} // namespace nvbio
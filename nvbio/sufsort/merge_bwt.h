@@ -0,0 +1,166 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#pragma once
+
+#include <nvbio/sufsort/sufsort_utils.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/popcount.h>
+#include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/vector.h>
+#include <nvbio/fmindex/rank_dictionary.h>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup Sufsort
+///@{
+
+///
+/// A string-set BWT held in host memory, represented as a 2-bit packed string, a sparse
+/// occurrence table and the sorted list of the positions of its dollars.
+///\par
+/// The BWT follows the same conventions as the output of the string-set BWT construction
+/// functions: the first n_strings() rows correspond to the empty suffixes of each string
+/// (in string order), and identical suffixes are sorted by string id.
+/// Dollars are stored in the packed string as the symbol DOLLAR_SYMBOL (i.e. the 255 marker
+/// truncated to 2 bits), and are excluded from its count by the occurrence table and by
+/// a per-block bit-mask of the dollars, so that rank() takes no extra memory lookups
+/// besides the mask.
+///
+struct HostSetBWT
+{
+    static const uint32 SYMBOL_SIZE      = 2u;
+    static const uint32 SYMBOLS_PER_WORD = 16u;
+    static const uint32 OCC_INTERVAL     = 64u;
+    static const uint8  DOLLAR_SYMBOL    = 3u;
+
+    typedef uint32                                                                  word_type;
+    typedef PackedStream<word_type*,uint8,SYMBOL_SIZE,true,uint64>                  stream_type;
+    typedef PackedStream<const word_type*,uint8,SYMBOL_SIZE,true,uint64>            const_stream_type;
+    typedef rank_dictionary<SYMBOL_SIZE,OCC_INTERVAL,const_stream_type,const uint64*,const uint32*>
+                                                                                    rank_dict_type;
+    typedef std::pair<uint64,uint32>                                                dollar_type;    ///< (position, string-id)
+
+    /// constructor
+    ///
+    HostSetBWT() : n_symbols(0) {}
+
+    /// return the number of symbols (i.e. rows) in the BWT, dollars included
+    ///
+    uint64 size() const { return n_symbols; }
+
+    /// return the number of strings in the set
+    ///
+    uint32 n_strings() const { return uint32( dollars.size() ); }
+
+    /// resize the packed string to hold n symbols
+    ///
+    void resize(const uint64 n);
+
+    /// return the packed string
+    ///
+    stream_type stream() { return stream_type( nvbio::raw_pointer( bwt ) ); }
+
+    /// return the packed string
+    ///
+    const_stream_type stream() const { return const_stream_type( nvbio::raw_pointer( bwt ) ); }
+
+    /// return the i-th symbol of the BWT (dollars are returned as DOLLAR_SYMBOL)
+    ///
+    uint8 operator[] (const uint64 i) const { return stream()[i]; }
+
+    /// build the occurrence table and the symbol counts needed by rank() and LF(),
+    /// processing the BWT in parallel over partitions; the dollars must be sorted by position
+    ///
+    void build_rank_dictionary();
+
+    /// return the rank dictionary of the packed string
+    ///
+    rank_dict_type rank_dict() const
+    {
+        return rank_dict_type(
+            stream(),
+            nvbio::raw_pointer( occ ),
+            count_table );
+    }
+
+    /// return whether the i-th symbol is a dollar
+    ///
+    bool is_dollar(const uint64 i) const
+    {
+        return (dollar_mask[ i / OCC_INTERVAL ] >> (i & (OCC_INTERVAL-1))) & 1u;
+    }
+
+    /// return the number of occurrences of the symbol c in the range [0,i), not counting dollars
+    ///
+    uint64 rank(const uint64 i, const uint8 c) const
+    {
+        if (i == 0)
+            return 0u;
+
+        const uint64 j = i - 1u;
+        const uint64 r = nvbio::rank( rank_dict(), j, uint32(c) );
+
+        // the occurrence table already excludes the dollars preceding the block of j,
+        // while those inside the block are removed using its dollar mask
+        return c == DOLLAR_SYMBOL ?
+            r - popc( dollar_mask[ j / OCC_INTERVAL ] & (uint64(-1) >> (63u - (j & (OCC_INTERVAL-1)))) ) :
+            r;
+    }
+
+    /// return the row of the suffix c.X, where X is the suffix at row i
+    ///
+    uint64 LF(const uint64 i, const uint8 c) const { return C[c] + rank( i, c ); }
+
+    uint64                          n_symbols;          ///< number of symbols
+    nvbio::vector<host_tag,uint32>  bwt;                ///< 2-bit packed BWT
+    std::vector<dollar_type>        dollars;            ///< dollar positions, sorted by position
+    nvbio::vector<host_tag,uint64>  occ;                ///< occurrence table, sampled every OCC_INTERVAL symbols
+    nvbio::vector<host_tag,uint64>  dollar_mask;        ///< bit-mask of the dollars in each occurrence block
+    uint64                          C[5];               ///< C[c] = # of rows whose suffix starts with a symbol < c
+    uint32                          count_table[256];   ///< rank dictionary count table
+};
+
+///
+/// Merge the BWTs of two string sets into the BWT of their union, where the strings of
+/// the second set follow those of the first one (i.e. their ids are offset by bwt1.n_strings()).
+///\par
+/// The merge proceeds in the style of ropeBWT/BCR, but with both inputs already in BWT form:
+/// the strings of the second set are walked backwards with LF() in both BWTs at once,
+/// which gives, for each row of bwt2, the number of rows of bwt1 preceding it in the merged
+/// order; the two BWTs are then interleaved in a single streaming pass, and the merged
+/// symbols are passed to the output handler in batches, together with the merged string
+/// ids of the dollars.
+/// Both the walk and the interleaving are parallelized over the strings of the second set
+/// and over partitions of the output respectively.
+/// Besides the packed inputs themselves, time and memory are proportional to the size of
+/// bwt2, plus a single pass over bwt1 to build its rank dictionary.
+///
+/// \param bwt1             the BWT of the first string set
+/// \param bwt2             the BWT of the second string set
+/// \param output           the output handler
+///
+void merge_bwt(
+    HostSetBWT&         bwt1,
+    HostSetBWT&         bwt2,
+    BaseBWTHandler&     output);
+
+///@}
+
+} // namespace nvbio
@@ -0,0 +1,209 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <nvbio/sufsort/spill_file.h>
+#include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/timer.h>
+#include <string.h>
+
+#if defined(WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace nvbio {
+
+// constructor
+//
+SpillFile::SpillFile() :
+    m_file( NULL ),
+    m_elem_size( 1u ),
+    m_size( 0u ),
+    m_flushed( 0u ),
+    m_at_end( true ) {}
+
+// destructor
+//
+SpillFile::~SpillFile()
+{
+    close();
+}
+
+// create the scratch file
+//
+void SpillFile::open(const char* file_name, const uint32 elem_size, const uint64 buffer_size)
+{
+    close();
+
+    m_file = fopen( file_name, "w+b" );
+    if (m_file == NULL)
+        throw runtime_error( "unable to create scratch file \"%s\"", file_name );
+
+    // all writes go through our own buffer in large chunks
+    setvbuf( m_file, NULL, _IONBF, 0 );
+
+    m_file_name = file_name;
+    m_elem_size = elem_size;
+    m_size      = 0u;
+    m_flushed   = 0u;
+    m_at_end    = true;
+    m_stats     = SpillStats();
+
+    m_buffer.resize( nvbio::max( buffer_size / elem_size, uint64(1u) ) * elem_size );
+}
+
+// close and remove the scratch file
+//
+void SpillFile::close()
+{
+    if (m_file == NULL)
+        return;
+
+    fclose( m_file );
+    remove( m_file_name.c_str() );
+
+    m_file = NULL;
+    m_buffer = std::vector<uint8>();
+}
+
+// append n elements
+//
+void SpillFile::append(const uint64 n, const void* src)
+{
+    const uint64 buffer_elems = m_buffer.size() / m_elem_size;
+
+    const uint8* src_bytes = (const uint8*)src;
+
+    for (uint64 i = 0; i < n;)
+    {
+        const uint64 buffered = m_size - m_flushed;
+        const uint64 n_copy   = nvbio::min( n - i, buffer_elems - buffered );
+
+        memcpy( &m_buffer[0] + buffered * m_elem_size, src_bytes + i * m_elem_size, n_copy * m_elem_size );
+
+        m_size += n_copy;
+        i      += n_copy;
+
+        if (m_size - m_flushed == buffer_elems)
+            flush();
+    }
+}
+
+// overwrite the i-th element
+//
+void SpillFile::patch(const uint64 i, const void* src)
+{
+    if (i >= m_flushed)
+    {
+        memcpy( &m_buffer[0] + (i - m_flushed) * m_elem_size, src, m_elem_size );
+        return;
+    }
+
+    seek( i * m_elem_size );
+    write( m_elem_size, src );
+
+    m_at_end = false;
+    m_stats.n_patches++;
+}
+
+// write out the tail buffer
+//
+void SpillFile::flush()
+{
+    if (m_size == m_flushed)
+        return;
+
+    if (m_at_end == false)
+    {
+        seek( m_flushed * m_elem_size );
+        m_at_end = true;
+    }
+
+    write( (m_size - m_flushed) * m_elem_size, &m_buffer[0] );
+
+    m_flushed = m_size;
+}
+
+// flush the file and rewind it for sequential reading
+//
+void SpillFile::rewind()
+{
+    flush();
+    seek( 0u );
+
+    m_at_end = false;
+}
+
+// read the next n elements, returning the number of elements read
+//
+uint64 SpillFile::read(const uint64 n, void* dst)
+{
+    ScopedTimer<float> timer( &m_stats.read_time );
+
+    const uint64 n_read = fread( dst, m_elem_size, n, m_file );
+
+    m_stats.bytes_read += n_read * m_elem_size;
+    return n_read;
+}
+
+// seek to a given byte offset
+//
+void SpillFile::seek(const uint64 offset)
+{
+#if defined(WIN32)
+    const int r = _fseeki64( m_file, int64( offset ), SEEK_SET );
+#else
+    const int r = fseeko( m_file, off_t( offset ), SEEK_SET );
+#endif
+    if (r != 0)
+        throw runtime_error( "seek failed on scratch file \"%s\"", m_file_name.c_str() );
+}
+
+// write a block of bytes at the current position
+//
+void SpillFile::write(const uint64 n_bytes, const void* src)
+{
+    ScopedTimer<float> timer( &m_stats.write_time );
+
+    if (fwrite( src, 1u, n_bytes, m_file ) != n_bytes)
+        throw runtime_error( "write failed on scratch file \"%s\" (disk full?)", m_file_name.c_str() );
+
+    m_stats.bytes_written += n_bytes;
+}
+
+// return the name of the i-th scratch file of a group
+//
+std::string spill_file_name(const char* scratch_dir, const char* prefix, const uint32 i)
+{
+    char suffix[64];
+    if (prefix)
+        sprintf( suffix, ".%u.spill", i );
+    else
+    {
+    #if defined(WIN32)
+        const uint32 pid = uint32( _getpid() );
+    #else
+        const uint32 pid = uint32( getpid() );
+    #endif
+        sprintf( suffix, "sufsort.%u.%u.spill", pid, i );
+    }
+    return std::string( scratch_dir ) + "/" + (prefix ? prefix : "") + suffix;
+}
+
+} // namespace nvbio
@@ -0,0 +1,151 @@
+/*
+ * nvbio
+ * Copyright (C) 2012-2014, NVIDIA Corporation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup Sufsort
+///@{
+
+/// I/O statistics of a SpillFile
+///
+struct SpillStats
+{
+    SpillStats() :
+        bytes_written( 0u ),
+        bytes_read( 0u ),
+        n_patches( 0u ),
+        write_time( 0.0f ),
+        read_time( 0.0f ) {}
+
+    /// accumulate the statistics of another file
+    ///
+    SpillStats& operator+= (const SpillStats& other)
+    {
+        bytes_written += other.bytes_written;
+        bytes_read    += other.bytes_read;
+        n_patches     += other.n_patches;
+        write_time    += other.write_time;
+        read_time     += other.read_time;
+        return *this;
+    }
+
+    uint64 bytes_written;   ///< bytes written to disk, including patches
+    uint64 bytes_read;      ///< bytes read back from disk
+    uint64 n_patches;       ///< number of elements patched after having been spilled
+    float  write_time;      ///< time spent writing
+    float  read_time;       ///< time spent reading
+};
+
+///
+/// A scratch file holding a flat array of fixed-size elements, used to keep large outputs
+/// out of host memory.
+///\par
+/// Elements are appended through a large in-memory tail buffer, so that the disk only sees
+/// large sequential writes. Elements can later be overwritten: those still in the tail buffer
+/// are patched in memory, while those already spilled are patched in place on disk.
+/// Once complete, the file can be read back sequentially, and it is removed when closed.
+///\par
+/// As a SpillFile owns its file handle, it cannot be copied.
+///
+struct SpillFile
+{
+    /// constructor
+    ///
+    SpillFile();
+
+    /// destructor
+    ///
+    ~SpillFile();
+
+    /// create the scratch file
+    ///
+    /// \param file_name        the scratch file name
+    /// \param elem_size        the size of each element, in bytes
+    /// \param buffer_size      the size of the tail buffer, in bytes
+    ///
+    void open(const char* file_name, const uint32 elem_size, const uint64 buffer_size = 64u*1024u*1024u);
+
+    /// close and remove the scratch file
+    ///
+    void close();
+
+    /// append n elements
+    ///
+    void append(const uint64 n, const void* src);
+
+    /// overwrite the i-th element
+    ///
+    void patch(const uint64 i, const void* src);
+
+    /// write out the tail buffer
+    ///
+    void flush();
+
+    /// flush the file and rewind it for sequential reading
+    ///
+    void rewind();
+
+    /// read the next n elements, returning the number of elements read
+    ///
+    uint64 read(const uint64 n, void* dst);
+
+    /// return the number of elements in the file
+    ///
+    uint64 size() const { return m_size; }
+
+    /// return the I/O statistics
+    ///
+    const SpillStats& stats() const { return m_stats; }
+
+private:
+    SpillFile(const SpillFile&);                // not implemented
+    SpillFile& operator=(const SpillFile&);     // not implemented
+
+    void seek(const uint64 offset);
+    void write(const uint64 n_bytes, const void* src);
+
+    FILE*               m_file;
+    std::string         m_file_name;
+    uint32              m_elem_size;
+    std::vector<uint8>  m_buffer;
+    uint64              m_size;         ///< total number of elements
+    uint64              m_flushed;      ///< number of elements written to disk
+    bool                m_at_end;       ///< whether the file position is at the end of the spilled elements
+    SpillStats          m_stats;
+};
+
+/// return the name of the i-th scratch file of a group, placed in the given directory:
+/// if no prefix is given, the names are tagged with the process id, so that concurrent
+/// processes sharing the directory do not collide
+///
+/// \param scratch_dir     the scratch directory
+/// \param prefix          the prefix of the group's file names, or NULL
+/// \param i               the index of the file within the group
+///
+std::string spill_file_name(const char* scratch_dir, const char* prefix, const uint32 i);
+
+///@}
+
+} // namespace nvbio
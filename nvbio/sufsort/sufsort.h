@@ -86,12 +86,16 @@ struct BWTParams
         host_memory(8u*1024u*1024u*1024llu),
         device_memory(2u*1024u*1024u*1024llu),
         bucketing_bits(16u),
-        radix_slice(4u) {}
+        radix_slice(4u),
+        scratch_dir(NULL),
+        scratch_prefix(NULL) {}
 
-    uint64 host_memory;
-    uint64 device_memory;
-    uint32 bucketing_bits;
-    uint32 radix_slice;
+    uint64      host_memory;
+    uint64      device_memory;
+    uint32      bucketing_bits;
+    uint32      radix_slice;
+    const char* scratch_dir;    ///< if not NULL, cuda::blockwise_suffix_sort() spills its super-blocks to this directory
+    const char* scratch_prefix; ///< the prefix of the spilled super-blocks' file names; if NULL, they are tagged with the process id
 };
 
 ///@}
@@ -277,6 +281,55 @@ void large_bwt(
         output_handler&             output,
         BWTParams*                  params = NULL);
 
+/// Build the bwt of a large host-side string set using the CPU only, without requiring a GPU.
+/// The suffixes are bucketed as in large_bwt(), and each block of buckets is then sorted with
+/// a multi-threaded host MSD radix sorter; the amount of memory used is bounded by
+/// BWTParams::host_memory, while BWTParams::device_memory is ignored.
+///
+/// \tparam SYMBOL_SIZE             alphabet size, in bits per symbol
+/// \tparam storage_type            underlying storage iterator (e.g. uint32*)
+/// \tparam output_handler          an output handler, exposing the same interface required
+///                                 by large_bwt(); however, as there is no device-side storage,
+///                                 all device pointers will be NULL, and the host-side suffixes
+///                                 will be passed in sorted order
+///
+/// \param string_set               a host-side packed-concatenated string-set
+/// \param output                   output handler
+/// \param params                   construction parameters
+///
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN, typename storage_type, typename output_handler>
+void host_large_bwt(
+    const ConcatenatedStringSet<
+        PackedStream<storage_type,uint8,SYMBOL_SIZE,BIG_ENDIAN,uint64>,
+        uint64*>                    string_set,
+        output_handler&             output,
+        BWTParams*                  params = NULL);
+
+/// Sort all the suffixes of a host-side string using the CPU only, without requiring a GPU.
+/// This is the host counterpart of cuda::blockwise_suffix_sort(): a Difference Cover Sample is
+/// first built with a multi-threaded prefix doubling sorter, after which the suffixes are bucketed
+/// by their leading symbols and each bucket is sorted comparing at most Q symbols per pair of
+/// suffixes, 64 bits at a time, followed by a single lookup in the DCS ranks.
+/// The cost of each comparison is hence bounded even on highly repetitive strings.
+///
+/// \tparam string_type             a host-side string, e.g. a big-endian PackedStream
+/// \tparam output_handler          a handler for the sorted suffixes, exposing the same process_batch()
+///                                 method required by cuda::blockwise_suffix_sort(); as there is no
+///                                 device-side storage, it will be passed host-side arrays, and
+///                                 process_scattered() will never be called
+///
+/// \param string_len               the length of the given string
+/// \param string                   a host-side string
+/// \param output                   the handler for the sorted suffixes
+/// \param params                   construction parameters
+///
+template <typename string_type, typename output_handler>
+void host_blockwise_suffix_sort(
+    const typename string_type::index_type  string_len,
+    string_type                             string,
+    output_handler&                         output,
+    BWTParams*                              params = NULL);
+
 ///@}
 
 } // namespace nvbio
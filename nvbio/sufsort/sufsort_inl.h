@@ -20,10 +20,12 @@
 
 #include <nvbio/sufsort/sufsort_priv.h>
 #include <nvbio/sufsort/sufsort_bucketing.h>
+#include <nvbio/sufsort/host_set_sufsort.h>
 #include <nvbio/sufsort/sufsort_utils.h>
 #include <nvbio/sufsort/compression_sort.h>
 #include <nvbio/sufsort/prefix_doubling_sufsort.h>
 #include <nvbio/sufsort/blockwise_sufsort.h>
+#include <nvbio/sufsort/host_blockwise_sufsort.h>
 #include <nvbio/sufsort/dcs.h>
 #include <nvbio/strings/string_set.h>
 #include <nvbio/basic/omp.h>
@@ -905,6 +907,400 @@ void bwt(
 
 } // namespace cuda
 
+template <uint32 BUCKETING_BITS, uint32 SYMBOL_SIZE, bool BIG_ENDIAN, typename storage_type>
+struct HostLargeBWTSkeleton
+{
+    typedef typename std::iterator_traits<storage_type>::value_type word_type;
+
+    static const uint32 WORD_BITS   = uint32( 8u * sizeof(word_type) );
+    static const uint32 DOLLAR_BITS = WORD_BITS <= 32 ? 4 : 5;
+    static const uint32 DOLLAR_MASK = (1u << DOLLAR_BITS) - 1u;
+
+    typedef cuda::HostBWTConfigCPUBucketer<BUCKETING_BITS,SYMBOL_SIZE,BIG_ENDIAN,storage_type>    config_type;
+    typedef cuda::LargeBWTSkeleton<config_type,SYMBOL_SIZE,BIG_ENDIAN,storage_type>                 hybrid_skeleton_type;
+    typedef typename config_type::suffix_bucketer                                                   suffix_bucketer_type;
+
+    typedef ConcatenatedStringSet<
+            PackedStream<storage_type,uint8,SYMBOL_SIZE,BIG_ENDIAN,uint64>,
+            uint64*>    string_set_type;
+
+    typedef priv::HostSetSuffixSorter<SYMBOL_SIZE,string_set_type>                                  suffix_sorter_type;
+
+    // compute the BWT symbols of a block of sorted suffixes
+    //
+    static void block_bwt(
+        const string_set_type   string_set,
+        const uint32            n_suffixes,
+        const uint2*            h_suffixes,
+              uint8*            h_bwt)
+    {
+        #pragma omp parallel for
+        for (int i = 0; i < int( n_suffixes ); ++i)
+        {
+            const priv::string_set_bwt_functor<string_set_type> bwt( string_set );
+            h_bwt[i] = bwt( h_suffixes[i] );
+        }
+    }
+
+    template <typename output_handler>
+    static cuda::LargeBWTStatus enact(
+        const string_set_type       string_set,
+        output_handler&             output,
+        BWTParams*                  params)
+    {
+        const uint32 N = string_set.size();
+
+        cuda::LargeBWTStatus    status;
+
+        // the CPU bucketer doesn't need an MGPU context
+        suffix_bucketer_type    bucketer( mgpu::ContextPtr() );
+        suffix_sorter_type      string_sorter( string_set );
+
+        // each super-block suffix takes 8 bytes, and each block suffix another 17 bytes of sorting
+        // and BWT scratchpads: with blocks up to a quarter of a super-block, 16 bytes per super-block
+        // suffix leave enough room for the per-thread bucketing buffers
+        const uint64 host_memory = params ? params->host_memory : uint64(8u)*1024u*1024u*1024u;
+        const uint64 max_super_block_size = nvbio::min(
+            (host_memory - nvbio::min( host_memory / 2u, uint64(128u*1024u*1024u) )) / 16u,   // leave 128MB for the bucket counters
+            uint64(2u)*1024u*1024u*1024u );
+        const uint32 max_block_size = uint32( nvbio::min(
+            max_super_block_size / 4u,
+            uint64(256u*1024u*1024u) ) );
+
+        log_verbose(stderr,"  super-block-size: %.1f M\n", float(max_super_block_size)/float(1024*1024));
+        log_verbose(stderr,"        block-size: %.1f M\n", float(max_block_size)/float(1024*1024));
+        thrust::host_vector<uint2>       h_suffixes;
+        thrust::host_vector<uint8>       h_block_bwt;
+
+        //
+        // split the suffixes in buckets, and count them
+        //
+
+        const uint32 n_buckets = 1u << BUCKETING_BITS;
+
+        thrust::host_vector<uint32> h_buckets( n_buckets );
+        thrust::host_vector<uint32> h_subbuckets( n_buckets );
+
+        // count how many suffixes fall in each bucket
+        const uint64 total_suffixes = bucketer.count( string_set, h_buckets );
+
+        // no need to reserve more room than there are suffixes
+        h_suffixes.resize( nvbio::min( max_super_block_size, total_suffixes ) );
+
+        // compute the largest non-elementary bucket
+        const uint32 largest_subbucket = hybrid_skeleton_type::max_subbucket_size( h_buckets, max_super_block_size, max_block_size, &status );
+        if (!status)
+        {
+            log_verbose(stderr,"    exceeded maximum bucket size\n");
+            return status;
+        }
+
+        log_verbose(stderr,"    max bucket size: %u\n", largest_subbucket);
+        bucketer.log_count_stats();
+
+        float bwt_time    = 0.0f;
+        float output_time = 0.0f;
+
+        // output the last character of each string (i.e. the symbols preceding all the dollar signs)
+        for (uint32 block_begin = 0; block_begin < N; block_begin += max_block_size)
+        {
+            const uint32 block_end = nvbio::min( block_begin + max_block_size, N );
+
+            const uint32 n_suffixes = block_end - block_begin;
+
+            Timer timer;
+            timer.start();
+
+            priv::alloc_storage( h_block_bwt, n_suffixes );
+
+            // fetch the BWT symbols for the given strings
+            #pragma omp parallel for
+            for (int i = 0; i < int( n_suffixes ); ++i)
+            {
+                const priv::string_set_bwt_functor<string_set_type> bwt( string_set );
+                h_block_bwt[i] = bwt( uint32( block_begin + i ) );
+            }
+
+            timer.stop();
+            bwt_time += timer.seconds();
+
+            timer.start();
+
+            // invoke the output handler
+            output.process(
+                n_suffixes,
+                plain_view( h_block_bwt ),
+                NULL,
+                NULL,
+                NULL,
+                NULL );
+
+            timer.stop();
+            output_time += timer.seconds();
+        }
+
+        bucketer.clear_timers();
+
+        // reserve memory for scratchpads
+        const uint32 scratch_size = uint32( nvbio::min( uint64( max_block_size ), total_suffixes ) );
+        string_sorter.reserve( scratch_size );
+        priv::alloc_storage( h_block_bwt, scratch_size );
+
+        log_verbose(stderr,"  allocated host memory: %.1f MB\n",
+            float( bucketer.allocated_host_memory()         +
+                   string_sorter.allocated_host_memory()    +
+                   h_block_bwt.size()       * sizeof(uint8)  +
+                   h_suffixes.size()        * sizeof(uint2)  +
+                   h_buckets.size()         * sizeof(uint32) +
+                   h_subbuckets.size()      * sizeof(uint32)
+            ) / float(1024*1024) );
+
+        // now build the sub-bucket lists
+        hybrid_skeleton_type::build_subbuckets(
+            h_buckets,
+            h_subbuckets,
+            max_super_block_size,
+            max_block_size );
+
+        float  sufsort_time = 0.0f;
+        float  collect_time = 0.0f;
+        uint64 global_suffix_offset = 0;
+
+        //
+        // do multiple passes through the input string set, collecting in each pass as many
+        // buckets as we can fit in memory at once
+        //
+
+        for (uint32 bucket_begin = 0, bucket_end = 0; bucket_begin < h_buckets.size(); bucket_begin = bucket_end)
+        {
+            // grow the block of buckets until we can
+            uint64 bucket_size;
+            for (bucket_size = 0; (bucket_end < h_buckets.size()) && (bucket_size + h_buckets[bucket_end] <= max_super_block_size); ++bucket_end)
+                bucket_size += h_buckets[bucket_end];
+
+            uint32 max_suffix_len = 0;
+
+            log_verbose(stderr,"  collect buckets[%u:%u] (%llu suffixes)\n", bucket_begin, bucket_end, bucket_size);
+            Timer collect_timer;
+            collect_timer.start();
+
+            bucketer.collect(
+                string_set,
+                bucket_begin,
+                bucket_end,
+                max_suffix_len,
+                h_subbuckets,
+                h_suffixes );
+
+            collect_timer.stop();
+            collect_time += collect_timer.seconds();
+            log_verbose(stderr,"  collect : %.1fs (%.1f M scans/s)\n", collect_time, 1.0e-6f*float(total_suffixes)/collect_time);
+            bucketer.log_collect_stats();
+
+            //
+            // sort the collected suffixes one block of sub-buckets at a time
+            //
+
+            uint64 suffix_count = 0u;
+
+            for (uint32 subbucket_begin = bucket_begin, subbucket_end = bucket_begin; subbucket_begin < bucket_end; subbucket_begin = subbucket_end)
+            {
+                Timer suf_timer;
+                suf_timer.start();
+
+                uint32 subbucket_size;
+                bool   short_strings = false;
+
+                if (h_buckets[subbucket_begin] > max_block_size)
+                {
+                    // this is a short-string bucket, made of identical suffixes already sorted by string index:
+                    // it can be output as is, in multiple blocks
+                    ++subbucket_end;
+
+                    subbucket_size = h_buckets[subbucket_begin];
+                    short_strings  = true;
+                }
+                else
+                {
+                    // grow the block of sub-buckets until we can
+                    for (subbucket_size = 0; (subbucket_end < bucket_end) && (subbucket_size + h_buckets[subbucket_end] <= max_block_size); ++subbucket_end)
+                        subbucket_size += h_buckets[subbucket_end];
+                }
+
+                log_verbose(stderr,"\r  sufsort buckets[%u:%u] (%.1f M suffixes/s)    ", subbucket_begin, subbucket_end, 1.0e-6f*float(global_suffix_offset + suffix_count)/sufsort_time);
+                if (subbucket_size == 0)
+                    continue;
+
+                uint2* h_bucket_suffixes = &h_suffixes[0] + suffix_count;
+
+                if (short_strings == false)
+                    string_sorter.sort( subbucket_size, h_bucket_suffixes );
+
+                for (uint32 block_begin = 0; block_begin < subbucket_size; block_begin += max_block_size)
+                {
+                    const uint32 block_end  = nvbio::min( block_begin + max_block_size, subbucket_size );
+                    const uint32 n_suffixes = block_end - block_begin;
+
+                    Timer timer;
+                    timer.start();
+
+                    // load the BWT symbols
+                    block_bwt(
+                        string_set,
+                        n_suffixes,
+                        h_bucket_suffixes + block_begin,
+                        plain_view( h_block_bwt ) );
+
+                    timer.stop();
+                    bwt_time += timer.seconds();
+
+                    timer.start();
+
+                    // invoke the output handler
+                    output.process(
+                        n_suffixes,
+                        plain_view( h_block_bwt ),
+                        NULL,
+                        h_bucket_suffixes + block_begin,
+                        NULL,
+                        NULL );
+
+                    timer.stop();
+                    output_time += timer.seconds();
+                }
+
+                suffix_count += subbucket_size;
+
+                suf_timer.stop();
+                sufsort_time += suf_timer.seconds();
+            }
+            log_verbose(stderr,"\r  sufsort : %.1fs (%.1f M suffixes/s)                     \n", sufsort_time, 1.0e-6f*float(global_suffix_offset + suffix_count)/sufsort_time);
+            log_verbose(stderr,"    extract  : %.1fs\n", string_sorter.extract_time);
+            log_verbose(stderr,"    r-sort   : %.1fs\n", string_sorter.radixsort_time);
+            log_verbose(stderr,"    refine   : %.1fs (%u passes)\n", string_sorter.refine_time, string_sorter.n_passes);
+            log_verbose(stderr,"    bwt      : %.1fs\n", bwt_time);
+            log_verbose(stderr,"    output   : %.1fs\n", output_time);
+
+            global_suffix_offset += suffix_count;
+        }
+        return status;
+    }
+};
+
+// Compute the bwt of a host-side string set using the CPU only
+//
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN, typename storage_type, typename output_handler>
+void host_large_bwt(
+    const ConcatenatedStringSet<
+        PackedStream<storage_type,uint8,SYMBOL_SIZE,BIG_ENDIAN,uint64>,
+        uint64*>                    string_set,
+        output_handler&             output,
+        BWTParams*                  params)
+{
+    cuda::LargeBWTStatus status;
+
+    const uint32 bucketing_bits = params ? params->bucketing_bits : 16u;
+
+    // try 16-bit bucketing
+    if (bucketing_bits <= 16u)
+    {
+        if (status = HostLargeBWTSkeleton<16,SYMBOL_SIZE,BIG_ENDIAN,storage_type>::enact(
+            string_set,
+            output,
+            params ))
+            return;
+    }
+
+    // try 20-bit bucketing
+    if (bucketing_bits <= 20u)
+    {
+        if (status = HostLargeBWTSkeleton<20,SYMBOL_SIZE,BIG_ENDIAN,storage_type>::enact(
+            string_set,
+            output,
+            params ))
+            return;
+    }
+
+    // try 24-bit bucketing
+    if (bucketing_bits <= 24u)
+    {
+        if (status = HostLargeBWTSkeleton<24,SYMBOL_SIZE,BIG_ENDIAN,storage_type>::enact(
+            string_set,
+            output,
+            params ))
+            return;
+    }
+
+    // try 26-bit bucketing
+    if (status = HostLargeBWTSkeleton<26,SYMBOL_SIZE,BIG_ENDIAN,storage_type>::enact(
+        string_set,
+        output,
+        params ))
+        return;
+
+    if (status.code == cuda::LargeBWTStatus::LargeBucket)
+        throw nvbio::runtime_error("subbucket %u contains %u strings: buffer overflow!\n  please try increasing the host memory limit to at least %u MB\n", status.bucket_index, status.bucket_size, util::divide_ri( status.bucket_size, 1024u*1024u )*64u);
+}
+
+// Sort all the suffixes of a host-side string using the CPU only
+//
+template <typename string_type, typename output_handler>
+void host_blockwise_suffix_sort(
+    const typename string_type::index_type  string_len,
+    string_type                             string,
+    output_handler&                         output,
+    BWTParams*                              params)
+{
+    // find a suitable Difference Cover, accounting for the samples, their ranks and the sorting keys...
+    const uint64 host_memory = params ? params->host_memory : 8u*1024u*1024u*1024llu;
+
+    const uint64 needed_bytes_64   = uint64( DCS::estimated_sample_size<64>( string_len ) ) * 16u;
+    const uint64 needed_bytes_128  = uint64( DCS::estimated_sample_size<128>( string_len ) ) * 16u;
+    const uint64 needed_bytes_256  = uint64( DCS::estimated_sample_size<256>( string_len ) ) * 16u;
+    const uint64 needed_bytes_512  = uint64( DCS::estimated_sample_size<512>( string_len ) ) * 16u;
+    const uint64 needed_bytes_1024 = uint64( DCS::estimated_sample_size<1024>( string_len ) ) * 16u;
+
+    HostDCS dcs;
+
+    if (host_memory >= 2*needed_bytes_64)
+        dcs.init<64>();
+    else if (host_memory >= 2*needed_bytes_128)
+        dcs.init<128>();
+    else if (host_memory >= 2*needed_bytes_256)
+        dcs.init<256>();
+    else if (host_memory >= 2*needed_bytes_512)
+        dcs.init<512>();
+    else if (host_memory >= 2*needed_bytes_1024)
+        dcs.init<1024>();
+    else
+        dcs.init<2048>();
+
+    // build a table for our Difference Cover
+    log_verbose(stderr, "  building DCS-%u... started\n", dcs.Q);
+
+    host_blockwise_build(
+        dcs,
+        string_len,
+        string,
+        params );
+
+    log_verbose(stderr, "  building DCS-%u... done\n", dcs.Q);
+
+    // and do the Difference Cover based sorting
+    log_verbose(stderr, "  DCS-based sorting... started\n");
+
+    host_blockwise_suffix_sort(
+        string_len,
+        string,
+        string_len,
+        thrust::make_counting_iterator<uint32>(0u),
+        output,
+        &dcs,
+        params );
+
+    log_verbose(stderr, "  DCS-based sorting... done\n");
+}
+
 // Compute the bwt of a host-side string set
 //
 template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN, typename storage_type, typename output_handler>
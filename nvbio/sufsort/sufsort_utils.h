@@ -19,6 +19,7 @@
 #pragma once
 
 #include <nvbio/sufsort/sufsort_priv.h>
+#include <nvbio/sufsort/spill_file.h>
 #include <nvbio/strings/string_set.h>
 #include <nvbio/basic/thrust_view.h>
 #include <thrust/host_vector.h>
@@ -29,6 +30,34 @@ namespace nvbio {
 ///@addtogroup Sufsort
 ///@{
 
+///
+/// Statistics about the output stage of a BWT handler
+///
+struct BWTOutputStats
+{
+    BWTOutputStats() :
+        compression_time( 0.0f ),
+        wait_time( 0.0f ),
+        raw_bytes( 0u ),
+        compressed_bytes( 0u ) {}
+
+    /// accumulate another record
+    ///
+    BWTOutputStats& operator+= (const BWTOutputStats& other)
+    {
+        compression_time += other.compression_time;
+        wait_time        += other.wait_time;
+        raw_bytes        += other.raw_bytes;
+        compressed_bytes += other.compressed_bytes;
+        return *this;
+    }
+
+    float   compression_time;       ///< time spent compressing the output, summed over all compressor threads
+    float   wait_time;              ///< time the producer thread spent blocked on the output
+    uint64  raw_bytes;              ///< number of bytes handed to the compressors
+    uint64  compressed_bytes;       ///< number of compressed bytes written out
+};
+
 /// base virtual interface used by all string-set BWT handlers
 ///
 struct BaseBWTHandler
@@ -46,6 +75,14 @@ struct BaseBWTHandler
         const uint2*  h_suffixes,
         const uint2*  d_suffixes,
         const uint32* d_indices) {}
+
+    /// wait for any output processed in the background (e.g. compressed) to be written out
+    ///
+    virtual void flush() {}
+
+    /// return the statistics of the output stage
+    ///
+    virtual BWTOutputStats output_stats() const { return BWTOutputStats(); }
 };
 
 /// A class to output the BWT to a (potentially packed) device string
@@ -480,6 +517,167 @@ struct StringBWTSSAHandler
     StringSSAHandler<output_ssa_iterator>             ssa_handler;
 };
 
+/// a utility StringSuffixHandler to compute the BWT and a Sampled Suffix Array, spilling both
+/// to scratch files rather than keeping them in memory, for building the BWT of strings whose
+/// outputs would not fit in host or device memory.
+///\par
+/// The BWT is spilled one byte per symbol, including the implicit first symbol and the dollar
+/// at the primary position, which the consumer is responsible for skipping when reading it back;
+/// the SSA is spilled as an array of 32-bit suffix indices, including the implicit empty suffix.
+/// The suffixes delayed by the blockwise sorter and resolved at a later time are patched in place.
+///
+template <typename string_type>
+struct StringBWTSSASpillHandler
+{
+    typedef typename string_type::index_type index_type;
+
+    static const uint32 NULL_PRIMARY = uint32(-1);
+
+    // constructor
+    //
+    StringBWTSSASpillHandler(
+        const index_type    _string_len,
+        const string_type   _string,
+        const uint32        _mod,
+        SpillFile*          _bwt,
+        SpillFile*          _ssa) :
+        string_len  ( _string_len ),
+        string      ( _string ),
+        mod         ( _mod ),
+        primary     ( NULL_PRIMARY ),
+        n_output    ( 0 ),
+        bwt         ( _bwt ),
+        ssa         ( _ssa )
+    {
+        // encode the first BWT symbol explicitly
+        priv::alloc_storage( d_block_bwt, 1u );
+        priv::device_copy( 1u, string + string_len-1, nvbio::plain_view( d_block_bwt ), uint32(0u) );
+
+        const uint8 first = d_block_bwt[0];
+        bwt->append( 1u, &first );
+
+        // and encode the implicit empty suffix
+        const uint32 empty = uint32(-1);
+        ssa->append( 1u, &empty );
+    }
+
+    // process the next batch of suffixes
+    //
+    void process_batch(
+        const uint32  n_suffixes,
+        const uint32* d_suffixes)
+    {
+        priv::alloc_storage( d_block_bwt, n_suffixes );
+        priv::alloc_storage( h_block_bwt, n_suffixes );
+        priv::alloc_storage( h_suffixes,  n_suffixes );
+        priv::alloc_storage( h_samples,   n_suffixes / mod + 1u );
+
+        // compute the bwt of the block
+        thrust::transform(
+            thrust::device_ptr<const uint32>( d_suffixes ),
+            thrust::device_ptr<const uint32>( d_suffixes ) + n_suffixes,
+            d_block_bwt.begin(),
+            priv::string_bwt_functor<string_type>( string_len, string ) );
+
+        // check if there is a $ sign
+        const uint32 block_primary = uint32( thrust::find(
+            d_block_bwt.begin(),
+            d_block_bwt.begin() + n_suffixes,
+            255u ) - d_block_bwt.begin() );
+
+        if (block_primary < n_suffixes)
+        {
+            // keep track of the global primary position
+            primary = n_output + block_primary + 1u;                // +1u for the implicit empty suffix
+        }
+
+        thrust::copy(
+            d_block_bwt.begin(),
+            d_block_bwt.begin() + n_suffixes,
+            h_block_bwt.begin() );
+
+        thrust::copy(
+            thrust::device_ptr<const uint32>( d_suffixes ),
+            thrust::device_ptr<const uint32>( d_suffixes ) + n_suffixes,
+            h_suffixes.begin() );
+
+        // spill the bwt
+        bwt->append( n_suffixes, nvbio::plain_view( h_block_bwt ) );
+
+        // collect the sampled suffixes, which are contiguous in the SSA
+        uint32 n_samples = 0u;
+        for (uint32 slot = util::round_i( n_output + 1u, mod ); slot < n_output + 1u + n_suffixes; slot += mod)
+            h_samples[ n_samples++ ] = h_suffixes[ slot - n_output - 1u ];  // +1u for the implicit empty suffix
+
+        ssa->append( n_samples, nvbio::plain_view( h_samples ) );
+
+        // advance the output counter
+        n_output += n_suffixes;
+    }
+
+    // process a sparse set of suffixes
+    //
+    void process_scattered(
+        const uint32  n_suffixes,
+        const uint32* d_suffixes,
+        const uint32* d_slots)
+    {
+        priv::alloc_storage( d_block_bwt, n_suffixes );
+        priv::alloc_storage( h_block_bwt, n_suffixes );
+        priv::alloc_storage( h_suffixes,  n_suffixes );
+        priv::alloc_storage( h_slots,     n_suffixes );
+
+        // compute the bwt of the block
+        thrust::transform(
+            thrust::device_ptr<const uint32>( d_suffixes ),
+            thrust::device_ptr<const uint32>( d_suffixes ) + n_suffixes,
+            d_block_bwt.begin(),
+            priv::string_bwt_functor<string_type>( string_len, string ) );
+
+        thrust::copy(
+            d_block_bwt.begin(),
+            d_block_bwt.begin() + n_suffixes,
+            h_block_bwt.begin() );
+
+        thrust::copy(
+            thrust::device_ptr<const uint32>( d_suffixes ),
+            thrust::device_ptr<const uint32>( d_suffixes ) + n_suffixes,
+            h_suffixes.begin() );
+
+        thrust::copy(
+            thrust::device_ptr<const uint32>( d_slots ),
+            thrust::device_ptr<const uint32>( d_slots ) + n_suffixes,
+            h_slots.begin() );
+
+        // patch the spilled outputs
+        for (uint32 i = 0; i < n_suffixes; ++i)
+        {
+            const uint32 slot = h_slots[i] + 1u;    // +1 for the implicit empty suffix
+
+            if (h_block_bwt[i] == 255u)
+                primary = slot;
+
+            bwt->patch( slot, &h_block_bwt[i] );
+
+            if ((slot & (mod-1)) == 0)
+                ssa->patch( slot / mod, &h_suffixes[i] );
+        }
+    }
+
+    const index_type                string_len;
+    const string_type               string;
+    const uint32                    mod;
+    uint32                          primary;
+    uint32                          n_output;
+    SpillFile*                      bwt;
+    SpillFile*                      ssa;
+    thrust::device_vector<uint8>    d_block_bwt;
+    thrust::host_vector<uint8>      h_block_bwt;
+    thrust::host_vector<uint32>     h_suffixes;
+    thrust::host_vector<uint32>     h_slots;
+    thrust::host_vector<uint32>     h_samples;
+};
+
 ///@}
 
 } // namespace nvbio
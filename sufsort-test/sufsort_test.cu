@@ -30,8 +30,11 @@
 
 #include <nvbio/sufsort/sufsort.h>
 #include <nvbio/sufsort/sufsort_utils.h>
+#include <nvbio/sufsort/file_bwt.h>
+#include <nvbio/sufsort/merge_bwt.h>
 #include <nvbio/basic/exceptions.h>
 #include <nvbio/basic/timer.h>
+#include <nvbio/basic/shared_pointer.h>
 #include <nvbio/strings/string_set.h>
 #include <nvbio/basic/cuda/arch.h>
 #include <nvbio/basic/cuda/ldg.h>
@@ -80,6 +83,130 @@ struct SuffixHandler
     thrust::device_vector<uint32> output;
 };
 
+// build a string set with many repeated strings, so as to exercise the tie-breaking logic
+// of the set suffix sorters
+//
+template <uint32 SYMBOL_SIZE, typename offset_type>
+void make_repetitive_string_set(
+    const uint64                        N_strings,
+    const uint32                        N,
+    const uint32                        N_distinct,
+    thrust::host_vector<uint32>&        h_string,
+    thrust::host_vector<offset_type>&   h_offsets)
+{
+    typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,true,uint64> packed_stream_type;
+
+    packed_stream_type packed_string( nvbio::plain_view( h_string ) );
+
+    for (uint64 i = 0; i < N_strings; ++i)
+    {
+        h_offsets[i] = offset_type( uint64(N)*i );
+
+        // all strings with the same id modulo N_distinct are identical
+        LCG_random rand( uint32( i % N_distinct ) );
+        for (uint32 j = 0; j < N; ++j)
+            packed_string[ uint64(N)*i + j ] = uint8( rand.next() >> (32u - SYMBOL_SIZE) );
+    }
+    h_offsets[N_strings] = N*N_strings;
+}
+
+// a functor comparing two suffixes (string, offset) of a string set: suffixes are compared
+// lexicographically, shorter suffixes come first and ties are broken by string id
+//
+template <typename string_set_type>
+struct set_suffix_less
+{
+    set_suffix_less(const string_set_type _string_set) : string_set(_string_set) {}
+
+    bool operator() (const uint2 a, const uint2 b) const
+    {
+        typedef typename string_set_type::string_type string_type;
+
+        const string_type sa = string_set[ a.y ];
+        const string_type sb = string_set[ b.y ];
+
+        const uint32 la = sa.length() - a.x;
+        const uint32 lb = sb.length() - b.x;
+
+        for (uint32 i = 0; i < nvbio::min( la, lb ); ++i)
+        {
+            const uint8 ca = sa[ a.x + i ];
+            const uint8 cb = sb[ b.x + i ];
+            if (ca != cb)
+                return ca < cb;
+        }
+        if (la != lb)
+            return la < lb;
+
+        return a.y < b.y;
+    }
+
+    const string_set_type string_set;
+};
+
+// a suffix handler collecting the host-side output of host_blockwise_suffix_sort()
+//
+struct HostSuffixHandler
+{
+    HostSuffixHandler(uint32* _output) : output( _output ), n_output( 0u ) {}
+
+    void process_batch(
+        const uint32  n_suffixes,
+        const uint32* h_suffixes)
+    {
+        std::copy( h_suffixes, h_suffixes + n_suffixes, output + n_output );
+        n_output += n_suffixes;
+    }
+
+    uint32* output;
+    uint32  n_output;
+};
+
+// check the BWT of a string set computed by host_large_bwt() against a reference built by
+// sorting all its suffixes with std::sort
+//
+template <uint32 SYMBOL_SIZE, typename string_set_type>
+bool check_host_set_bwt(const string_set_type string_set, BWTParams* params)
+{
+    const uint32 n_strings = string_set.size();
+
+    // build the reference
+    std::vector<uint2> suffixes;
+    for (uint32 i = 0; i < n_strings; ++i)
+    {
+        for (uint32 j = 0; j < string_set[i].length(); ++j)
+            suffixes.push_back( make_uint2( j, i ) );
+    }
+    std::sort( suffixes.begin(), suffixes.end(), set_suffix_less<string_set_type>( string_set ) );
+
+    // the BWT starts with the symbols preceding the empty suffixes, i.e. the last symbol of each string
+    std::vector<uint8> ref( n_strings + suffixes.size() );
+    for (uint32 i = 0; i < n_strings; ++i)
+        ref[i] = string_set[i][ string_set[i].length()-1u ];
+    for (uint32 i = 0; i < suffixes.size(); ++i)
+        ref[ n_strings + i ] = suffixes[i].x ? string_set[ suffixes[i].y ][ suffixes[i].x - 1u ] : 255u;
+
+    // and compute the BWT with the host path
+    std::vector<uint8> bwt( ref.size() );
+
+    HostBWTHandler<uint8*> output_handler( &bwt[0] );
+
+    host_large_bwt<SYMBOL_SIZE,true>(
+        string_set,
+        output_handler,
+        params );
+
+    for (uint32 i = 0; i < ref.size(); ++i)
+    {
+        if (bwt[i] != ref[i])
+        {
+            log_error(stderr, "  host set-bwt mismatch at %u: %u != %u\n", i, uint32( bwt[i] ), uint32( ref[i] ));
+            return false;
+        }
+    }
+    return true;
+}
+
 } // namespace sufsort
 
 int sufsort_test(int argc, char* argv[])
@@ -94,6 +221,10 @@ int sufsort_test(int argc, char* argv[])
         kGPU_BWT_SET        = 32u,
         kCPU_BWT_SET        = 64u,
         kGPU_SA_SET         = 128u,
+        kHYBRID_BWT_SET     = 256u,
+        kMERGE_BWT_SET      = 512u,
+        kCPU_SA             = 1024u,
+        kFILE_BWT_SET       = 2048u,
     };
     uint32 TEST_MASK = 0xFFFFFFFFu;
 
@@ -175,6 +306,14 @@ int sufsort_test(int argc, char* argv[])
                     TEST_MASK |= kGPU_BWT_SET;
                 else if (strcmp( temp, "cpu-set-bwt" ) == 0)
                     TEST_MASK |= kCPU_BWT_SET;
+                else if (strcmp( temp, "hybrid-set-bwt" ) == 0)
+                    TEST_MASK |= kHYBRID_BWT_SET;
+                else if (strcmp( temp, "merge-set-bwt" ) == 0)
+                    TEST_MASK |= kMERGE_BWT_SET;
+                else if (strcmp( temp, "cpu-sa" ) == 0)
+                    TEST_MASK |= kCPU_SA;
+                else if (strcmp( temp, "file-set-bwt" ) == 0)
+                    TEST_MASK |= kFILE_BWT_SET;
 
                 if (*end == '\0')
                     break;
@@ -330,6 +469,92 @@ int sufsort_test(int argc, char* argv[])
             }
         }
     }
+    if (TEST_MASK & kCPU_SA)
+    {
+        typedef uint32                                                  index_type;
+        typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,true,index_type> packed_stream_type;
+
+        const index_type N_symbols  = 2u*1024u*1024u;
+        const index_type N_words    = (N_symbols + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD;
+        const index_type N_period   = 64u*1024u;
+
+        log_info(stderr, "  cpu sa test\n");
+        log_info(stderr, "    %5.1f M symbols\n",  (1.0e-6f*float(N_symbols)));
+
+        // build a highly repetitive string, made of copies of the same random sequence
+        // with a few point mutations, so that suffixes share very long common prefixes
+        thrust::host_vector<uint32> h_string( N_words );
+
+        packed_stream_type h_packed_string( nvbio::plain_view( h_string ) );
+
+        LCG_random rand;
+        for (index_type i = 0; i < N_period; ++i)
+            h_packed_string[i] = uint8( rand.next() >> (32u - SYMBOL_SIZE) );
+        for (index_type i = N_period; i < N_symbols; ++i)
+        {
+            h_packed_string[i] = (rand.next() & 8191u) ?
+                uint8( h_packed_string[i - N_period] ) :
+                uint8( rand.next() >> (32u - SYMBOL_SIZE) );
+        }
+
+        log_info(stderr, "  sa-is... started\n");
+
+        Timer timer;
+        timer.start();
+
+        std::vector<int32> sa_ref( N_symbols+1 );
+        gen_sa( N_symbols, h_packed_string, &sa_ref[0] );
+
+        timer.stop();
+        log_info(stderr, "  sa-is... done: %.2fs (%.1fM suffixes/s)\n", timer.seconds(), 1.0e-6f*float(N_symbols)/float(timer.seconds()));
+
+        // sort the suffixes with and without a DCS
+        for (uint32 use_dcs = 0; use_dcs <= 1; ++use_dcs)
+        {
+            std::vector<uint32> h_sa( N_symbols );
+
+            sufsort::HostSuffixHandler output_handler( &h_sa[0] );
+
+            log_info(stderr, "  %s sa... started\n", use_dcs ? "dcs" : "plain");
+
+            timer.start();
+
+            if (use_dcs)
+            {
+                host_blockwise_suffix_sort(
+                    N_symbols,
+                    h_packed_string,
+                    output_handler,
+                    &params );
+            }
+            else
+            {
+                host_blockwise_suffix_sort(
+                    N_symbols,
+                    h_packed_string,
+                    N_symbols,
+                    thrust::make_counting_iterator<uint32>(0u),
+                    output_handler,
+                    (const HostDCS*)NULL,
+                    &params );
+            }
+
+            timer.stop();
+
+            log_info(stderr, "  %s sa... done: %.2fs (%.1fM suffixes/s)\n", use_dcs ? "dcs" : "plain", timer.seconds(), 1.0e-6f*float(N_symbols)/float(timer.seconds()));
+
+            for (uint32 i = 0; i < N_symbols; ++i)
+            {
+                const uint32 s = h_sa[i];
+                const uint32 r = sa_ref[i+1];
+                if (s != r)
+                {
+                    log_error(stderr, "  mismatch at %u: expected %u, got %u\n", i, r, s);
+                    return 0u;
+                }
+            }
+        }
+    }
     if (TEST_MASK & kGPU_SA_SET)
     {
         typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,false>           packed_stream_type;
@@ -687,7 +912,7 @@ int sufsort_test(int argc, char* argv[])
 
         log_info(stderr, "  bwt... done: %.2fs\n", timer.seconds());
     }
-    if (TEST_MASK & kCPU_BWT_SET)
+    if (TEST_MASK & kHYBRID_BWT_SET)
     {
         typedef uint32 word_type;
 
@@ -698,7 +923,7 @@ int sufsort_test(int argc, char* argv[])
         const uint64 N_words     = util::divide_ri( uint64(N_strings)*(N+0), SYMBOLS_PER_WORD );
         const uint64 N_bwt_words = util::divide_ri( uint64(N_strings)*(N+1), SYMBOLS_PER_WORD );
 
-        log_info(stderr, "  cpu set-bwt test\n");
+        log_info(stderr, "  hybrid set-bwt test\n");
         log_info(stderr, "    %5.1f M strings\n",  (1.0e-6f*float(N_strings)));
         log_info(stderr, "    %5.1f G suffixes\n", (1.0e-9f*float(uint64(N_strings)*uint64(N+1))));
         log_info(stderr, "    %5.2f GB\n",         (float(N_words)*sizeof(uint32))/float(1024*1024*1024));
@@ -755,6 +980,316 @@ int sufsort_test(int argc, char* argv[])
 
         log_info(stderr, "  bwt... done: %.2fs\n", timer.seconds());
     }
+    if (TEST_MASK & kCPU_BWT_SET)
+    {
+        typedef uint32 word_type;
+
+        typedef PackedStream<word_type*,uint8,SYMBOL_SIZE,true,uint64>  packed_stream_type;
+        typedef ConcatenatedStringSet<packed_stream_type,uint64*>       string_set;
+
+        const uint32 N_strings   = cpu_bwt_size*1000*1000;
+        const uint64 N_words     = util::divide_ri( uint64(N_strings)*(N+0), SYMBOLS_PER_WORD );
+        const uint64 N_bwt_words = util::divide_ri( uint64(N_strings)*(N+1), SYMBOLS_PER_WORD );
+
+        log_info(stderr, "  cpu set-bwt test\n");
+        log_info(stderr, "    %5.1f M strings\n",  (1.0e-6f*float(N_strings)));
+        log_info(stderr, "    %5.1f G suffixes\n", (1.0e-9f*float(uint64(N_strings)*uint64(N+1))));
+        log_info(stderr, "    %5.2f GB\n",         (float(N_words)*sizeof(uint32))/float(1024*1024*1024));
+
+        // check the host path against a reference on a small set with many repeated strings
+        {
+            const uint32 N_check_strings = 4000;
+            const uint64 N_check_words   = util::divide_ri( uint64(N_check_strings)*N, SYMBOLS_PER_WORD );
+
+            thrust::host_vector<uint32>  h_check_string( N_check_words );
+            thrust::host_vector<uint64>  h_check_offsets( N_check_strings+1 );
+
+            sufsort::make_repetitive_string_set<SYMBOL_SIZE>(
+                N_check_strings,
+                N,
+                N_check_strings / 8,
+                h_check_string,
+                h_check_offsets );
+
+            const string_set h_check_set(
+                N_check_strings,
+                packed_stream_type( (word_type*)nvbio::plain_view( h_check_string ) ),
+                nvbio::plain_view( h_check_offsets ) );
+
+            log_info(stderr, "  check... started\n");
+            if (sufsort::check_host_set_bwt<SYMBOL_SIZE>( h_check_set, &params ) == false)
+                exit(1);
+            log_info(stderr, "  check... done\n");
+        }
+
+        thrust::host_vector<uint32>  h_string( N_words );
+        thrust::host_vector<uint64>  h_offsets( N_strings+1 );
+
+        sufsort::make_test_string_set<SYMBOL_SIZE>(
+            N_strings,
+            N,
+            h_string,
+            h_offsets );
+
+        packed_stream_type h_packed_string( (word_type*)nvbio::plain_view( h_string ) );
+
+        string_set h_string_set(
+            N_strings,
+            h_packed_string,
+            nvbio::plain_view( h_offsets ) );
+
+        log_info(stderr, "  bwt... started\n");
+
+        Timer timer;
+
+        if (store_output)
+        {
+            thrust::host_vector<uint32>  h_bwt( N_bwt_words );
+            packed_stream_type           h_packed_bwt( (word_type*)nvbio::plain_view( h_bwt ) );
+
+            HostBWTHandler<packed_stream_type> output_handler( h_packed_bwt );
+
+            timer.start();
+
+            host_large_bwt<SYMBOL_SIZE,true>(
+                h_string_set,
+                output_handler,
+                &params );
+
+            timer.stop();
+        }
+        else
+        {
+            DiscardBWTHandler output_handler;
+
+            timer.start();
+
+            host_large_bwt<SYMBOL_SIZE,true>(
+                h_string_set,
+                output_handler,
+                &params );
+
+            timer.stop();
+        }
+
+        log_info(stderr, "  bwt... done: %.2fs\n", timer.seconds());
+    }
+    if (TEST_MASK & kMERGE_BWT_SET)
+    {
+        typedef uint32 word_type;
+
+        typedef PackedStream<word_type*,uint8,SYMBOL_SIZE,true,uint64>  packed_stream_type;
+        typedef ConcatenatedStringSet<packed_stream_type,uint64*>       string_set;
+
+        const uint32 N_strings   = 20000;
+        const uint32 N_first     = N_strings / 3;
+        const uint64 N_words     = util::divide_ri( uint64(N_strings)*N, SYMBOLS_PER_WORD );
+
+        log_info(stderr, "  merge set-bwt test\n");
+
+        thrust::host_vector<uint32>  h_string( N_words );
+        thrust::host_vector<uint64>  h_offsets( N_strings+1 );
+
+        // use a set with many repeated strings, some of which will be split across the two halves
+        sufsort::make_repetitive_string_set<SYMBOL_SIZE>(
+            N_strings,
+            N,
+            N_strings / 8,
+            h_string,
+            h_offsets );
+
+        packed_stream_type h_packed_string( (word_type*)nvbio::plain_view( h_string ) );
+
+        // copy the strings following the first N_first to a separate set
+        thrust::host_vector<uint32>  h_second_string( N_words );
+        thrust::host_vector<uint64>  h_second_offsets( N_strings - N_first + 1 );
+
+        packed_stream_type h_second_packed_string( (word_type*)nvbio::plain_view( h_second_string ) );
+
+        const uint64 N_first_symbols = h_offsets[ N_first ];
+        for (uint64 i = N_first_symbols; i < h_offsets[ N_strings ]; ++i)
+            h_second_packed_string[ i - N_first_symbols ] = h_packed_string[i];
+        for (uint32 i = N_first; i <= N_strings; ++i)
+            h_second_offsets[ i - N_first ] = h_offsets[i] - N_first_symbols;
+
+        const string_set h_full_set( N_strings, h_packed_string, nvbio::plain_view( h_offsets ) );
+        const string_set h_first_set( N_first, h_packed_string, nvbio::plain_view( h_offsets ) );
+        const string_set h_second_set( N_strings - N_first, h_second_packed_string, nvbio::plain_view( h_second_offsets ) );
+
+        HostSetBWT full_bwt, first_bwt, second_bwt, merged_bwt;
+        {
+            SharedPointer<BaseBWTHandler> full_handler( open_host_set_bwt( &full_bwt ) );
+            SharedPointer<BaseBWTHandler> first_handler( open_host_set_bwt( &first_bwt ) );
+            SharedPointer<BaseBWTHandler> second_handler( open_host_set_bwt( &second_bwt ) );
+
+            host_large_bwt<SYMBOL_SIZE,true>( h_full_set,   *full_handler,   &params );
+            host_large_bwt<SYMBOL_SIZE,true>( h_first_set,  *first_handler,  &params );
+            host_large_bwt<SYMBOL_SIZE,true>( h_second_set, *second_handler, &params );
+        }
+
+        log_info(stderr, "  merge... started\n");
+
+        Timer timer;
+        timer.start();
+        {
+            SharedPointer<BaseBWTHandler> merged_handler( open_host_set_bwt( &merged_bwt ) );
+
+            merge_bwt( first_bwt, second_bwt, *merged_handler );
+        }
+        timer.stop();
+
+        log_info(stderr, "  merge... done: %.2fs\n", timer.seconds());
+
+        // and check the merged BWT against the one built from scratch
+        if (merged_bwt.size() != full_bwt.size() ||
+            merged_bwt.dollars != full_bwt.dollars)
+        {
+            log_error(stderr, "  merged BWT mismatch: %llu/%llu symbols, %u/%u strings\n",
+                merged_bwt.size(), full_bwt.size(),
+                merged_bwt.n_strings(), full_bwt.n_strings());
+            exit(1);
+        }
+        for (uint64 i = 0; i < full_bwt.size(); ++i)
+        {
+            if (merged_bwt[i] != full_bwt[i])
+            {
+                log_error(stderr, "  merged BWT mismatch at %llu: %u != %u\n", i, uint32( merged_bwt[i] ), uint32( full_bwt[i] ));
+                exit(1);
+            }
+        }
+    }
+    if (TEST_MASK & kFILE_BWT_SET)
+    {
+        typedef uint32 word_type;
+
+        typedef PackedStream<word_type*,uint8,SYMBOL_SIZE,true,uint64>  packed_stream_type;
+        typedef ConcatenatedStringSet<packed_stream_type,uint64*>       string_set;
+
+        const uint32 N_strings   = 20000;
+        const uint64 N_words     = util::divide_ri( uint64(N_strings)*N, SYMBOLS_PER_WORD );
+
+        log_info(stderr, "  file set-bwt test\n");
+
+        thrust::host_vector<uint32>  h_string( N_words );
+        thrust::host_vector<uint64>  h_offsets( N_strings+1 );
+
+        // use a set with many repeated strings, so as to get long runs in the BWT
+        sufsort::make_repetitive_string_set<SYMBOL_SIZE>(
+            N_strings,
+            N,
+            N_strings / 8,
+            h_string,
+            h_offsets );
+
+        packed_stream_type h_packed_string( (word_type*)nvbio::plain_view( h_string ) );
+
+        const string_set h_string_set( N_strings, h_packed_string, nvbio::plain_view( h_offsets ) );
+
+        // build the reference BWT in memory
+        HostSetBWT full_bwt;
+        {
+            SharedPointer<BaseBWTHandler> full_handler( open_host_set_bwt( &full_bwt ) );
+
+            host_large_bwt<SYMBOL_SIZE,true>( h_string_set, *full_handler, &params );
+        }
+
+        // write the BWT in the plain and in all the run-length encoded formats
+        const char* output_names[] = {
+            "sufsort-test.bwt",
+            "sufsort-test.rle",
+            "sufsort-test.rle.gz",
+            "sufsort-test.rle.bgz" };
+        const uint32 n_outputs = sizeof(output_names) / sizeof(output_names[0]);
+
+        for (uint32 f = 0; f < n_outputs; ++f)
+        {
+            SharedPointer<BaseBWTHandler> file_handler( open_bwt_file( output_names[f], "1R" ) );
+            if (file_handler == NULL)
+                exit(1);
+
+            host_large_bwt<SYMBOL_SIZE,true>( h_string_set, *file_handler, &params );
+
+            file_handler->flush();
+        }
+
+        // load the plain BWT back
+        {
+            HostSetBWT file_bwt;
+            if (load_bwt_file( output_names[0], &file_bwt ) == false)
+                exit(1);
+
+            if (file_bwt.size() != full_bwt.size() ||
+                file_bwt.dollars != full_bwt.dollars)
+            {
+                log_error(stderr, "  %s mismatch: %llu/%llu symbols, %u/%u strings\n", output_names[0],
+                    file_bwt.size(), full_bwt.size(),
+                    file_bwt.n_strings(), full_bwt.n_strings());
+                exit(1);
+            }
+            for (uint64 i = 0; i < full_bwt.size(); ++i)
+            {
+                if (file_bwt[i] != full_bwt[i])
+                {
+                    log_error(stderr, "  %s mismatch at %llu: %u != %u\n", output_names[0], i, uint32( file_bwt[i] ), uint32( full_bwt[i] ));
+                    exit(1);
+                }
+            }
+        }
+
+        // and check the run-length encoded BWTs against it, symbol by symbol and rank by rank
+        for (uint32 f = 1; f < n_outputs; ++f)
+        {
+            RLERankDictionaryHost               rle_dict;
+            std::vector<HostSetBWT::dollar_type> rle_dollars;
+
+            if (load_rle_bwt_file( output_names[f], &rle_dict, &rle_dollars ) == false)
+                exit(1);
+
+            if (rle_dict.size() != full_bwt.size() ||
+                rle_dollars != full_bwt.dollars)
+            {
+                log_error(stderr, "  %s mismatch: %llu/%llu symbols, %u/%u strings\n", output_names[f],
+                    rle_dict.size(), full_bwt.size(),
+                    uint32( rle_dollars.size() ), full_bwt.n_strings());
+                exit(1);
+            }
+
+            const rle_rank_dictionary dict = rle_dict.dictionary();
+
+            // walk the sorted dollars alongside the BWT, as the packed one can't tell them apart
+            uint32 d = 0u;
+
+            uint64 occ[4] = { 0u };
+            for (uint64 i = 0; i < full_bwt.size(); ++i)
+            {
+                const bool  dollar = d < full_bwt.n_strings() && full_bwt.dollars[d].first == i;
+                const uint8 c      = dollar ? rle_code::DOLLAR : full_bwt[i];
+                d += dollar ? 1u : 0u;
+                if (c != rle_code::DOLLAR)
+                    ++occ[c];
+
+                if (text( dict, i ) != c)
+                {
+                    log_error(stderr, "  %s mismatch at %llu: %u != %u\n", output_names[f], i, uint32( text( dict, i ) ), uint32( c ));
+                    exit(1);
+                }
+                for (uint32 a = 0; a < 4; ++a)
+                {
+                    if ((i % 1021u == 0u || i + 1u == full_bwt.size()) && rank( dict, i, a ) != occ[a])
+                    {
+                        log_error(stderr, "  %s rank mismatch at %llu: rank(%u) = %llu != %llu\n", output_names[f], i, a, rank( dict, i, a ), occ[a]);
+                        exit(1);
+                    }
+                }
+            }
+        }
+
+        for (uint32 f = 0; f < n_outputs; ++f)
+        {
+            remove( output_names[f] );
+            remove( primary_index_name( output_names[f] ).c_str() );
+        }
+    }
     log_info(stderr, "nvbio/sufsort test... done\n");
     return 0;
 }
@@ -664,12 +664,18 @@ int main(int argc, char* argv[])
             for (int i = 0; i < int( n_read_symbols ); ++i)
                 unpacked_reads[i] = packed_reads[i];
 
+            // the per-read alignment latencies, in nanoseconds
+            LogLinearHistogram read_latency;
+
             Timer timer;
             timer.start();
 
             #pragma omp parallel for
             for (int i = 0; i < int( h_read_data.size() ); ++i)
             {
+                Timer read_timer;
+                read_timer.start();
+
                 const uint32 read_off = reads_access.sequence_index()[i];
                 const uint32 read_len = reads_access.sequence_index()[i+1] - read_off;
 
@@ -689,13 +695,19 @@ int main(int argc, char* argv[])
                 align_destroy( align );
 
                 init_destroy( prof );
+
+                read_timer.stop();
+                read_latency.add( uint64( read_timer.seconds() * 1.0e9f ) );
             }
 
             timer.stop();
             const float time = timer.seconds();
 
             fprintf(stderr,"  %5.1f", 1.0e-9f * float(uint64(n_read_symbols)*uint64(ref_length))/time );
-            fprintf(stderr, " GCUPS\n");
+            fprintf(stderr, " GCUPS (per read latency: p50 %.1f us, p99 %.1f us, p999 %.1f us)\n",
+                1.0e-3f * float( read_latency.percentile( 0.5f ) ),
+                1.0e-3f * float( read_latency.percentile( 0.99f ) ),
+                1.0e-3f * float( read_latency.percentile( 0.999f ) ));
         }
         #endif
     }